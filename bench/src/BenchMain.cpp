@@ -0,0 +1,304 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+// labsound_bench
+//
+// Micro-benchmarks for the DSP kernels the render thread spends its time in:
+// the VectorMath primitives, Biquad, SincResampler, FFTFrame forward/inverse
+// transforms, DelayDSPKernel and DynamicsCompressorKernel.
+//
+// Each benchmark reports nanoseconds per processed sample so numbers are
+// comparable across buffer sizes and machines. Pass --json <path> to also
+// write the results as a JSON array for tracking across releases:
+//
+//     labsound_bench --json bench-results.json
+
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/OfflineAudioDestinationNode.h"
+
+#include "LabSound/extended/AudioContextLock.h"
+
+#include "internal/Biquad.h"
+#include "internal/DelayDSPKernel.h"
+#include "internal/DynamicsCompressorKernel.h"
+#include "internal/FFTFrame.h"
+#include "internal/SincResampler.h"
+#include "internal/VectorMath.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace lab;
+
+namespace
+{
+
+const float kSampleRate = 44100.f;
+const size_t kQuantumFrames = 128;  // AudioNode::ProcessingSizeInFrames
+
+// Accumulating into a volatile keeps the optimizer from discarding the
+// kernels' output (and with it the kernels).
+volatile float g_sink = 0.f;
+
+struct BenchResult
+{
+    std::string name;
+    double nsPerSample = 0;
+    uint64_t iterations = 0;
+};
+
+// Runs fn repeatedly (after a short warmup) until enough wall time has been
+// spent to make the per-sample figure stable, then averages over all runs.
+// samplesPerIteration is the number of samples one call to fn processes.
+template <typename Fn>
+BenchResult runBench(const std::string & name, size_t samplesPerIteration, Fn && fn)
+{
+    using clock = std::chrono::steady_clock;
+
+    const int warmupIterations = 16;
+    const auto minimumDuration = std::chrono::milliseconds(200);
+
+    for (int i = 0; i < warmupIterations; ++i)
+        fn();
+
+    uint64_t iterations = 0;
+    auto start = clock::now();
+    auto elapsed = clock::now() - start;
+
+    while (elapsed < minimumDuration)
+    {
+        // Batch calls so short kernels aren't dominated by the clock reads.
+        for (int i = 0; i < 32; ++i)
+            fn();
+        iterations += 32;
+        elapsed = clock::now() - start;
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.nsPerSample = std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(elapsed).count()
+                         / (static_cast<double>(iterations) * static_cast<double>(samplesPerIteration));
+
+    printf("%-36s %10.3f ns/sample\n", name.c_str(), result.nsPerSample);
+    return result;
+}
+
+void fillNoise(float * data, size_t count, uint32_t seed)
+{
+    // Deterministic input so successive runs measure the same work.
+    std::minstd_rand generator(seed);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+    for (size_t i = 0; i < count; ++i)
+        data[i] = distribution(generator);
+}
+
+void benchVectorMath(std::vector<BenchResult> & results)
+{
+    std::vector<float> source(kQuantumFrames);
+    std::vector<float> source2(kQuantumFrames);
+    std::vector<float> destination(kQuantumFrames);
+    fillNoise(source.data(), source.size(), 1);
+    fillNoise(source2.data(), source2.size(), 2);
+    fillNoise(destination.data(), destination.size(), 3);
+
+    const float scale = 0.7071f;
+
+    results.push_back(runBench("VectorMath::vsma", kQuantumFrames, [&] {
+        VectorMath::vsma(source.data(), 1, &scale, destination.data(), 1, kQuantumFrames);
+        g_sink += destination[0];
+    }));
+
+    results.push_back(runBench("VectorMath::vsmul", kQuantumFrames, [&] {
+        VectorMath::vsmul(source.data(), 1, &scale, destination.data(), 1, kQuantumFrames);
+        g_sink += destination[0];
+    }));
+
+    results.push_back(runBench("VectorMath::vadd", kQuantumFrames, [&] {
+        VectorMath::vadd(source.data(), 1, source2.data(), 1, destination.data(), 1, kQuantumFrames);
+        g_sink += destination[0];
+    }));
+
+    std::vector<float> imag1(kQuantumFrames);
+    std::vector<float> imag2(kQuantumFrames);
+    std::vector<float> realDest(kQuantumFrames);
+    std::vector<float> imagDest(kQuantumFrames);
+    fillNoise(imag1.data(), imag1.size(), 4);
+    fillNoise(imag2.data(), imag2.size(), 5);
+
+    results.push_back(runBench("VectorMath::zvmul", kQuantumFrames, [&] {
+        VectorMath::zvmul(source.data(), imag1.data(), source2.data(), imag2.data(),
+                          realDest.data(), imagDest.data(), kQuantumFrames);
+        g_sink += realDest[0] + imagDest[0];
+    }));
+}
+
+void benchBiquad(std::vector<BenchResult> & results)
+{
+    std::vector<float> source(kQuantumFrames);
+    std::vector<float> destination(kQuantumFrames);
+    fillNoise(source.data(), source.size(), 6);
+
+    Biquad biquad;
+    biquad.setLowpassParams(1000.0 / (kSampleRate / 2), 0.7071);
+
+    results.push_back(runBench("Biquad::process (lowpass)", kQuantumFrames, [&] {
+        biquad.process(source.data(), destination.data(), kQuantumFrames);
+        g_sink += destination[0];
+    }));
+}
+
+void benchSincResampler(std::vector<BenchResult> & results)
+{
+    const double scaleFactor = 44100.0 / 48000.0;
+    const size_t sourceFrames = 1024;
+    const size_t destinationFrames = static_cast<size_t>(sourceFrames / scaleFactor) + 16;
+
+    std::vector<float> source(sourceFrames);
+    std::vector<float> destination(destinationFrames);
+    fillNoise(source.data(), source.size(), 7);
+
+    SincResampler resampler(scaleFactor);
+
+    results.push_back(runBench("SincResampler::process (44.1->48k)", sourceFrames, [&] {
+        resampler.process(source.data(), destination.data(), sourceFrames);
+        g_sink += destination[0];
+    }));
+}
+
+void benchFFTFrame(std::vector<BenchResult> & results)
+{
+    for (size_t fftSize = 128; fftSize <= 32768; fftSize *= 2)
+    {
+        std::vector<float> data(fftSize);
+        fillNoise(data.data(), data.size(), 8);
+
+        FFTFrame frame(fftSize);
+
+        char name[64];
+        snprintf(name, sizeof(name), "FFTFrame::doFFT (%zu)", fftSize);
+        results.push_back(runBench(name, fftSize, [&] {
+            frame.doFFT(data.data());
+            g_sink += frame.realData()[1];
+        }));
+
+        snprintf(name, sizeof(name), "FFTFrame::doInverseFFT (%zu)", fftSize);
+        results.push_back(runBench(name, fftSize, [&] {
+            frame.doInverseFFT(data.data());
+            g_sink += data[0];
+        }));
+    }
+}
+
+void benchDelay(ContextRenderLock & r, std::vector<BenchResult> & results)
+{
+    std::vector<float> source(kQuantumFrames);
+    std::vector<float> destination(kQuantumFrames);
+    fillNoise(source.data(), source.size(), 9);
+
+    DelayDSPKernel delay(0.5, kSampleRate);
+    delay.setDelayFrames(4096);
+
+    results.push_back(runBench("DelayDSPKernel::process", kQuantumFrames, [&] {
+        delay.process(r, source.data(), destination.data(), kQuantumFrames);
+        g_sink += destination[0];
+    }));
+}
+
+void benchDynamicsCompressor(ContextRenderLock & r, std::vector<BenchResult> & results)
+{
+    const unsigned numberOfChannels = 2;
+
+    std::vector<float> sourceLeft(kQuantumFrames);
+    std::vector<float> sourceRight(kQuantumFrames);
+    std::vector<float> destinationLeft(kQuantumFrames);
+    std::vector<float> destinationRight(kQuantumFrames);
+    fillNoise(sourceLeft.data(), sourceLeft.size(), 10);
+    fillNoise(sourceRight.data(), sourceRight.size(), 11);
+
+    const float * sourceChannels[numberOfChannels] = {sourceLeft.data(), sourceRight.data()};
+    float * destinationChannels[numberOfChannels] = {destinationLeft.data(), destinationRight.data()};
+
+    DynamicsCompressorKernel compressor(numberOfChannels);
+
+    // Default parameters from DynamicsCompressor::initializeParameters().
+    results.push_back(runBench("DynamicsCompressorKernel::process", kQuantumFrames * numberOfChannels, [&] {
+        compressor.process(r, sourceChannels, destinationChannels, numberOfChannels, kQuantumFrames,
+                           -24.f,    // dbThreshold
+                           30.f,     // dbKnee
+                           12.f,     // ratio
+                           0.003f,   // attackTime
+                           0.250f,   // releaseTime
+                           0.006f,   // preDelayTime
+                           0.f,      // dbPostGain
+                           1.f,      // effectBlend
+                           0.09f, 0.16f, 0.42f, 0.98f);  // releaseZone1..4
+        g_sink += destinationLeft[0];
+    }));
+}
+
+void writeJson(const std::string & path, const std::vector<BenchResult> & results)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        fprintf(stderr, "labsound_bench: could not open %s for writing\n", path.c_str());
+        return;
+    }
+
+    file << "[\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        file << "  {\"name\": \"" << results[i].name << "\", "
+             << "\"ns_per_sample\": " << results[i].nsPerSample << ", "
+             << "\"iterations\": " << results[i].iterations << "}";
+        if (i + 1 < results.size())
+            file << ",";
+        file << "\n";
+    }
+    file << "]\n";
+
+    printf("\nWrote %zu results to %s\n", results.size(), path.c_str());
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+    std::string jsonPath;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonPath = argv[++i];
+    }
+
+    // DelayDSPKernel and DynamicsCompressorKernel read the sample rate through
+    // a ContextRenderLock, so give them an offline context that is never asked
+    // to render.
+    AudioContext context(true);
+    context.setDestinationNode(std::make_shared<OfflineAudioDestinationNode>(&context, kSampleRate, 1.f, 2));
+
+    std::vector<BenchResult> results;
+
+    benchVectorMath(results);
+    benchBiquad(results);
+    benchSincResampler(results);
+    benchFFTFrame(results);
+
+    {
+        ContextRenderLock r(&context, "labsound_bench");
+        benchDelay(r, results);
+        benchDynamicsCompressor(r, results);
+    }
+
+    if (!jsonPath.empty())
+        writeJson(jsonPath, results);
+
+    return 0;
+}
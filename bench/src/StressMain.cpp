@@ -0,0 +1,392 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+// labsound_stress
+//
+// Capability probe: how many units of a canonical graph shape fit inside the
+// real-time callback budget on this machine? Each scenario builds an offline
+// context with N units - sampled voices through equal-power panners, parallel
+// convolvers, an N-deep biquad chain - renders it, and measures the average
+// wall time per rendered quantum. The harness grows N exponentially until a
+// probe exceeds the budget, bisects to the crossover, and reports the
+// largest N that fits. Rendering is offline so the probe runs headless and
+// as fast as the machine allows.
+//
+//     labsound_stress                     probe every scenario
+//     labsound_stress biquad-chain        probe one scenario
+//     labsound_stress --headroom 0.5     fit within half the callback budget
+//     labsound_stress --json caps.json   also write the report as JSON
+//
+// The budget is the duration of one render quantum at the context sample
+// rate (128 frames at 44.1 kHz is ~2.9 ms), scaled by the headroom fraction;
+// real deployments leave room for the rest of the app, so the default fits
+// within 75% of the callback. Numbers are per-machine and per-build - track
+// them per platform, not across platforms.
+
+#include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/BiquadFilterNode.h"
+#include "LabSound/core/ConvolverNode.h"
+#include "LabSound/core/GainNode.h"
+#include "LabSound/core/OfflineAudioDestinationNode.h"
+#include "LabSound/core/OscillatorNode.h"
+#include "LabSound/core/PannerNode.h"
+#include "LabSound/core/SampledAudioNode.h"
+
+#include "LabSound/extended/AudioContextLock.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace lab;
+
+namespace
+{
+
+const float kSampleRate = 44100.f;
+const size_t kQuantumFrames = 128;  // AudioNode::ProcessingSizeInFrames
+
+const int kWarmupQuanta = 64;
+const int kTimedQuanta = 192;
+
+// A fixed seed keeps the synthesized material identical between runs, so
+// probe-to-probe variance is scheduling noise, not signal-dependent work.
+std::shared_ptr<AudioBus> makeNoiseBus(size_t channels, float seconds, uint32_t seed)
+{
+    size_t frames = static_cast<size_t>(seconds * kSampleRate);
+    auto bus = std::make_shared<AudioBus>(channels, frames);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    for (size_t c = 0; c < channels; ++c)
+    {
+        float * data = bus->channel(c)->mutableData();
+        for (size_t i = 0; i < frames; ++i)
+            data[i] = dist(rng);
+    }
+    return bus;
+}
+
+// An exponentially decaying noise burst standing in for a room response.
+std::shared_ptr<AudioBus> makeImpulseBus(float seconds)
+{
+    auto bus = makeNoiseBus(2, seconds, 7);
+    size_t frames = bus->length();
+    for (size_t c = 0; c < bus->numberOfChannels(); ++c)
+    {
+        float * data = bus->channel(c)->mutableData();
+        for (size_t i = 0; i < frames; ++i)
+            data[i] *= expf(-6.f * float(i) / float(frames));
+    }
+    return bus;
+}
+
+// Builds N units of the scenario's shape into the context and returns the
+// connections to apply; nodes must be kept alive by the caller's list.
+using ScenarioBuilder = std::function<void(AudioContext &, int n,
+                                           std::vector<std::shared_ptr<AudioNode>> & keepAlive,
+                                           std::vector<AudioContext::ConnectionOperation> & connections)>;
+
+struct Scenario
+{
+    const char * name;
+    const char * unit;
+    int maxUnits;  // search ceiling; also bounds a pathological machine
+    ScenarioBuilder build;
+};
+
+struct ProbeResult
+{
+    bool fits = false;
+    double averageMicroseconds = 0;
+};
+
+// Renders a fresh context holding n units and reports the average wall time
+// per quantum against the budget.
+ProbeResult probe(const Scenario & scenario, int n, double budgetMicroseconds)
+{
+    AudioContext context(true);
+    auto destination = std::make_shared<OfflineAudioDestinationNode>(
+        &context, kSampleRate, float((kWarmupQuanta + kTimedQuanta + 8) * kQuantumFrames / kSampleRate), 2);
+    context.setDestinationNode(destination);
+    context.lazyInitialize();
+
+    std::vector<std::shared_ptr<AudioNode>> keepAlive;
+    std::vector<AudioContext::ConnectionOperation> connections;
+    scenario.build(context, n, keepAlive, connections);
+    context.applyConnectionBatch(connections);
+
+    // Let the graph update thread land every connection (and any background
+    // preparation, like convolver impulses) before timing anything.
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (context.hasPendingUpdates())
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            fprintf(stderr, "graph with %d %ss did not settle\n", n, scenario.unit);
+            return ProbeResult();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    AudioBus bus(2, kQuantumFrames);
+
+    for (int q = 0; q < kWarmupQuanta; ++q)
+        destination->render(nullptr, &bus, kQuantumFrames);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int q = 0; q < kTimedQuanta; ++q)
+        destination->render(nullptr, &bus, kQuantumFrames);
+    auto end = std::chrono::steady_clock::now();
+
+    ProbeResult result;
+    result.averageMicroseconds = std::chrono::duration<double, std::micro>(end - start).count() / kTimedQuanta;
+    result.fits = result.averageMicroseconds <= budgetMicroseconds;
+    return result;
+}
+
+struct CapabilityResult
+{
+    std::string name;
+    std::string unit;
+    int maxThatFits = 0;
+    double averageMicrosecondsAtMax = 0;
+    double budgetMicroseconds = 0;
+};
+
+// Exponential growth to bracket the crossover, then bisection inside the
+// bracket; every probe rebuilds the graph from scratch so earlier probes
+// can't warm later ones.
+CapabilityResult findCapability(const Scenario & scenario, double budgetMicroseconds)
+{
+    CapabilityResult result;
+    result.name = scenario.name;
+    result.unit = scenario.unit;
+    result.budgetMicroseconds = budgetMicroseconds;
+
+    int lo = 0;         // largest n known to fit
+    double loMicros = 0;
+    int hi = 0;         // smallest n known not to fit; 0 while unbracketed
+
+    for (int n = 1; n <= scenario.maxUnits; n *= 2)
+    {
+        ProbeResult p = probe(scenario, n, budgetMicroseconds);
+        printf("    n %5d  %8.1f us %s\n", n, p.averageMicroseconds, p.fits ? "fits" : "over");
+        if (p.fits)
+        {
+            lo = n;
+            loMicros = p.averageMicroseconds;
+        }
+        else
+        {
+            hi = n;
+            break;
+        }
+    }
+
+    while (hi && hi - lo > 1 && hi - lo > lo / 16)  // stop within ~6% of the crossover
+    {
+        int mid = lo + (hi - lo) / 2;
+        ProbeResult p = probe(scenario, mid, budgetMicroseconds);
+        printf("    n %5d  %8.1f us %s\n", mid, p.averageMicroseconds, p.fits ? "fits" : "over");
+        if (p.fits)
+        {
+            lo = mid;
+            loMicros = p.averageMicroseconds;
+        }
+        else
+            hi = mid;
+    }
+
+    result.maxThatFits = lo;
+    result.averageMicrosecondsAtMax = loMicros;
+    return result;
+}
+
+// ---------------------------------------------------------------- scenarios
+
+// N looping sampled voices, each through its own equal-power panner spread
+// across the field: the canonical game-audio voice bed.
+void buildSampledVoices(AudioContext & context, int n,
+                        std::vector<std::shared_ptr<AudioNode>> & keepAlive,
+                        std::vector<AudioContext::ConnectionOperation> & connections)
+{
+    static std::shared_ptr<AudioBus> clip = makeNoiseBus(2, 0.5f, 11);
+
+    for (int i = 0; i < n; ++i)
+    {
+        auto voice = std::make_shared<SampledAudioNode>();
+        {
+            ContextRenderLock r(&context, "labsound_stress setBus");
+            voice->setBus(r, clip);
+        }
+        voice->setLoop(true);
+        voice->start(0.0);
+
+        auto panner = std::make_shared<PannerNode>(kSampleRate);
+        panner->setPanningModel(EQUALPOWER);
+        float angle = float(i) / float(std::max(n, 1)) * 6.2831853f;
+        panner->setPosition(sinf(angle), 0.f, cosf(angle));
+
+        AudioContext::ConnectionOperation toPanner;
+        toPanner.destination = panner;
+        toPanner.source = voice;
+        connections.push_back(toPanner);
+
+        AudioContext::ConnectionOperation toDestination;
+        toDestination.destination = context.destination();
+        toDestination.source = panner;
+        connections.push_back(toDestination);
+
+        keepAlive.push_back(voice);
+        keepAlive.push_back(panner);
+    }
+}
+
+// N convolvers sharing one source: parallel sends into room responses.
+void buildConvolvers(AudioContext & context, int n,
+                     std::vector<std::shared_ptr<AudioNode>> & keepAlive,
+                     std::vector<AudioContext::ConnectionOperation> & connections)
+{
+    static std::shared_ptr<AudioBus> impulse = makeImpulseBus(0.5f);
+
+    auto source = std::make_shared<OscillatorNode>(kSampleRate);
+    source->setType(OscillatorType::SAWTOOTH);
+    source->frequency()->setValue(110.f);
+    source->start(0.0);
+    keepAlive.push_back(source);
+
+    for (int i = 0; i < n; ++i)
+    {
+        auto convolver = std::make_shared<ConvolverNode>();
+        convolver->setImpulse(impulse);
+
+        AudioContext::ConnectionOperation toConvolver;
+        toConvolver.destination = convolver;
+        toConvolver.source = source;
+        connections.push_back(toConvolver);
+
+        AudioContext::ConnectionOperation toDestination;
+        toDestination.destination = context.destination();
+        toDestination.source = convolver;
+        connections.push_back(toDestination);
+
+        keepAlive.push_back(convolver);
+    }
+}
+
+// One source through an N-deep serial biquad chain: worst-case node depth,
+// and the shape the chain-fusion pass is built for.
+void buildBiquadChain(AudioContext & context, int n,
+                      std::vector<std::shared_ptr<AudioNode>> & keepAlive,
+                      std::vector<AudioContext::ConnectionOperation> & connections)
+{
+    auto source = std::make_shared<OscillatorNode>(kSampleRate);
+    source->setType(OscillatorType::SAWTOOTH);
+    source->frequency()->setValue(110.f);
+    source->start(0.0);
+    keepAlive.push_back(source);
+
+    std::shared_ptr<AudioNode> previous = source;
+    for (int i = 0; i < n; ++i)
+    {
+        auto filter = std::make_shared<BiquadFilterNode>();
+        filter->setType(LOWPASS);
+        filter->frequency()->setValue(400.f + 40.f * (i % 64));
+        filter->q()->setValue(0.9f);
+
+        AudioContext::ConnectionOperation link;
+        link.destination = filter;
+        link.source = previous;
+        connections.push_back(link);
+
+        keepAlive.push_back(filter);
+        previous = filter;
+    }
+
+    AudioContext::ConnectionOperation toDestination;
+    toDestination.destination = context.destination();
+    toDestination.source = previous;
+    connections.push_back(toDestination);
+}
+
+const Scenario kScenarios[] = {
+    {"sampled-voices", "voice", 4096, buildSampledVoices},
+    {"convolvers", "convolver", 512, buildConvolvers},
+    {"biquad-chain", "filter", 4096, buildBiquadChain},
+};
+
+void writeJson(const std::string & path, const std::vector<CapabilityResult> & results)
+{
+    std::ofstream out(path);
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const auto & r = results[i];
+        out << "  { \"scenario\": \"" << r.name << "\""
+            << ", \"unit\": \"" << r.unit << "\""
+            << ", \"max\": " << r.maxThatFits
+            << ", \"avg_us_at_max\": " << r.averageMicrosecondsAtMax
+            << ", \"budget_us\": " << r.budgetMicroseconds
+            << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+    double headroom = 0.75;
+    std::string jsonPath;
+    std::string filter;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--headroom") && i + 1 < argc)
+            headroom = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+            filter = argv[i];
+    }
+
+    const double quantumMicroseconds = 1e6 * double(kQuantumFrames) / double(kSampleRate);
+    const double budgetMicroseconds = quantumMicroseconds * headroom;
+
+    printf("labsound_stress: budget %.1f us per quantum (%.0f%% of %.1f us callback)\n\n",
+           budgetMicroseconds, headroom * 100.0, quantumMicroseconds);
+
+    std::vector<CapabilityResult> results;
+    for (const Scenario & scenario : kScenarios)
+    {
+        if (!filter.empty() && filter != scenario.name)
+            continue;
+
+        printf("%s:\n", scenario.name);
+        CapabilityResult result = findCapability(scenario, budgetMicroseconds);
+        printf("  -> %d %ss fit (%.1f us avg at that count)\n\n",
+               result.maxThatFits, result.unit.c_str(), result.averageMicrosecondsAtMax);
+        results.push_back(result);
+    }
+
+    if (results.empty())
+    {
+        fprintf(stderr, "no scenario matches '%s'\n", filter.c_str());
+        return 1;
+    }
+
+    if (!jsonPath.empty())
+        writeJson(jsonPath, results);
+
+    return 0;
+}
@@ -0,0 +1,34 @@
+set(labsound_bench_src
+    "${LABSOUND_ROOT}/bench/src/BenchMain.cpp")
+
+add_executable(labsound_bench ${labsound_bench_src})
+
+_set_cxx_14(labsound_bench)
+_set_compile_options(labsound_bench)
+
+if (APPLE)
+    set(DARWIN_LIBS
+        "-framework AudioToolbox"
+        "-framework AudioUnit"
+        "-framework Accelerate"
+        "-framework CoreAudio"
+        "-framework Cocoa")
+endif()
+
+target_link_libraries(labsound_bench LabSound ${DARWIN_LIBS})
+
+# The benchmarks exercise the DSP kernels directly, so unlike the examples
+# they need the internal headers as well as the public ones.
+target_include_directories(labsound_bench PRIVATE
+    ${LABSOUND_ROOT}/src
+    ${LABSOUND_ROOT}/src/internal
+    ${LABSOUND_ROOT}/third_party)
+
+set_target_properties(labsound_bench PROPERTIES
+                      RUNTIME_OUTPUT_DIRECTORY bin)
+
+set_property(TARGET labsound_bench PROPERTY FOLDER "examples")
+
+install(TARGETS labsound_bench
+    BUNDLE DESTINATION bin
+    RUNTIME DESTINATION bin)
@@ -36,13 +36,22 @@ function(_set_compile_options proj)
         #target_compile_options(${proj} PRIVATE /arch:AVX /Zi)
         target_compile_options(${proj} PRIVATE /Zi)
         target_compile_definitions(${proj} PRIVATE __WINDOWS_WASAPI__=1)
+        if(LABSOUND_USE_KISSFFT)
+            target_compile_definitions(${proj} PRIVATE WEBAUDIO_KISSFFT=1)
+        else()
+            target_compile_definitions(${proj} PRIVATE WEBAUDIO_OOURA=1)
+        endif()
         # TODO: These vars are for libniquist and should be set in the find libynquist script.
         target_compile_definitions(${proj} PRIVATE HAVE_STDINT_H=1 HAVE_SINF=1)
     elseif(APPLE)
     elseif(UNIX)
         target_link_libraries(${proj} pthread)
         target_compile_options(${proj} PRIVATE -fPIC)
-        target_compile_definitions(${proj} PRIVATE WEBAUDIO_KISSFFT=1)
+        if(LABSOUND_USE_KISSFFT)
+            target_compile_definitions(${proj} PRIVATE WEBAUDIO_KISSFFT=1)
+        else()
+            target_compile_definitions(${proj} PRIVATE WEBAUDIO_OOURA=1)
+        endif()
         if(LABSOUND_JACK)
             target_link_libraries(${proj} jack)
             target_compile_definitions(${proj} PRIVATE __UNIX_JACK__=1)
@@ -60,6 +69,10 @@ function(_set_compile_options proj)
         target_compile_definitions(${proj} PRIVATE HAVE_STDINT_H=1 HAVE_SETENV=1 HAVE_SINF=1)
     endif()
 
+    if(LABSOUND_RENDER_ALLOC_DETECTOR)
+        target_compile_definitions(${proj} PRIVATE LABSOUND_RENDER_ALLOC_DETECTOR=1)
+    endif()
+
 endfunction()
 
 function(_set_cxx_14 proj)
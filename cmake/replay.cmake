@@ -0,0 +1,32 @@
+set(labsound_replay_src
+    "${LABSOUND_ROOT}/replay/src/ReplayMain.cpp")
+
+add_executable(labsound_replay ${labsound_replay_src})
+
+_set_cxx_14(labsound_replay)
+_set_compile_options(labsound_replay)
+
+if (APPLE)
+    set(DARWIN_LIBS
+        "-framework AudioToolbox"
+        "-framework AudioUnit"
+        "-framework Accelerate"
+        "-framework CoreAudio"
+        "-framework Cocoa")
+endif()
+
+target_link_libraries(labsound_replay LabSound ${DARWIN_LIBS})
+
+set_target_properties(labsound_replay PROPERTIES
+                      RUNTIME_OUTPUT_DIRECTORY bin)
+
+set_property(TARGET labsound_replay PROPERTY FOLDER "examples")
+
+# The replay corpus renders entirely offline, so it can run headless in CI;
+# a run passes when every scenario parses, settles and renders. Output
+# divergence is caught by diffing the reported hashes between builds.
+add_test(NAME labsound_replay COMMAND labsound_replay)
+
+install(TARGETS labsound_replay
+    BUNDLE DESTINATION bin
+    RUNTIME DESTINATION bin)
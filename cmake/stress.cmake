@@ -0,0 +1,31 @@
+set(labsound_stress_src
+    "${LABSOUND_ROOT}/bench/src/StressMain.cpp")
+
+add_executable(labsound_stress ${labsound_stress_src})
+
+_set_cxx_14(labsound_stress)
+_set_compile_options(labsound_stress)
+
+if (APPLE)
+    set(DARWIN_LIBS
+        "-framework AudioToolbox"
+        "-framework AudioUnit"
+        "-framework Accelerate"
+        "-framework CoreAudio"
+        "-framework Cocoa")
+endif()
+
+target_link_libraries(labsound_stress LabSound ${DARWIN_LIBS})
+
+set_target_properties(labsound_stress PROPERTIES
+                      RUNTIME_OUTPUT_DIRECTORY bin)
+
+set_property(TARGET labsound_stress PROPERTY FOLDER "examples")
+
+# Not registered with CTest: the probe's whole output is machine-dependent
+# capability numbers, so there is no portable pass/fail. Run it per platform
+# and track the JSON report alongside the bench results.
+
+install(TARGETS labsound_stress
+    BUNDLE DESTINATION bin
+    RUNTIME DESTINATION bin)
@@ -44,15 +44,14 @@ struct ValidationApp : public LabSoundExampleApp
         {
             ContextRenderLock r(ac, "Validator");
 
-            pingping->BuildSubgraph(context);
             pingping->SetFeedback(0.5f);
             pingping->SetDelayIndex(lab::TempoSync::TS_8);
 
-            ac->connect(context->destination(), pingping->output, 0, 0);
+            ac->connect(context->destination(), pingping, 0, 0);
 
             audioClipNode->setBus(r, audioClip);
 
-            ac->connect(pingping->input, audioClipNode, 0, 0);
+            ac->connect(pingping, audioClipNode, 0, 0);
             audioClipNode->start(0.0f);
         }
 
@@ -33,14 +33,23 @@
 #include "LabSound/core/PannerNode.h"
 #include "LabSound/core/SampledAudioNode.h"
 #include "LabSound/core/StereoPannerNode.h"
+#include "LabSound/core/TraceRecorder.h"
 #include "LabSound/core/WaveShaperNode.h"
 
 // LabSound Extended Public API
 #include "LabSound/extended/ADSRNode.h"
+#include "LabSound/extended/AudioBridgeNode.h"
 #include "LabSound/extended/AudioFileReader.h"
+#include "LabSound/extended/BakeFarm.h"
 #include "LabSound/extended/ClipNode.h"
+#include "LabSound/extended/CompressedAudioStream.h"
+#include "LabSound/extended/CrossfadeNode.h"
 #include "LabSound/extended/DiodeNode.h"
 #include "LabSound/extended/FunctionNode.h"
+#include "LabSound/extended/GranularNode.h"
+#include "LabSound/extended/GraphSerialization.h"
+#include "LabSound/extended/MeteringEngine.h"
+#include "LabSound/extended/MixerHierarchy.h"
 #include "LabSound/extended/NoiseNode.h"
 #include "LabSound/extended/PdNode.h"
 #include "LabSound/extended/PeakCompNode.h"
@@ -49,11 +58,19 @@
 #include "LabSound/extended/PWMNode.h"
 #include "LabSound/extended/RealtimeAnalyser.h"
 #include "LabSound/extended/RecorderNode.h"
+#include "LabSound/extended/ReverbSendBus.h"
 #include "LabSound/extended/SampledInstrumentNode.h"
+#include "LabSound/extended/SceneSwitcher.h"
 #include "LabSound/extended/SfxrNode.h"
+#include "LabSound/extended/Soundbank.h"
 #include "LabSound/extended/SpatializationNode.h"
 #include "LabSound/extended/SpectralMonitorNode.h"
+#include "LabSound/extended/StreamSourceNode.h"
+#include "LabSound/extended/SubgraphFreeze.h"
 #include "LabSound/extended/SupersawNode.h"
+#include "LabSound/extended/TimeStretchNode.h"
+#include "LabSound/extended/VoiceManager.h"
+#include "LabSound/extended/VoicePool.h"
 
 #include <memory>
 // Factory functions for convenience.
@@ -61,7 +78,20 @@
 namespace lab {
 namespace Sound {
     std::shared_ptr<AudioHardwareSourceNode> MakeHardwareSourceNode(ContextRenderLock & r);
+
+    // The default output device's native sample rate, or zero when the
+    // platform cannot report one. Pass it as the context's rate to run the
+    // device natively instead of letting the platform resample invisibly
+    // between the context rate and the device rate.
+    float HardwareSampleRate();
+
     std::unique_ptr<AudioContext> MakeRealtimeAudioContext(uint32_t numChannels, float sample_rate = LABSOUND_DEFAULT_SAMPLERATE);
+
+    // Like MakeRealtimeAudioContext, but all contexts made this way with the
+    // same channel count and sample rate share one hardware stream; their
+    // destinations render in sequence inside a single device callback and mix
+    // there, with deterministic inter-context alignment.
+    std::unique_ptr<AudioContext> MakeSharedRealtimeAudioContext(uint32_t numChannels, float sample_rate = LABSOUND_DEFAULT_SAMPLERATE);
     std::unique_ptr<AudioContext> MakeOfflineAudioContext(uint32_t numChannels, float recordTimeMilliseconds);
     std::unique_ptr<AudioContext> MakeOfflineAudioContext(uint32_t numChannels, float recordTimeMilliseconds, float sample_rate);
 
@@ -49,6 +49,13 @@ public:
     void getFloatTimeDomainData(std::vector<float>& array) { m_analyser->getFloatTimeDomainData(array); } // LabSound
     void getByteTimeDomainData(std::vector<uint8_t>& array) { m_analyser->getByteTimeDomainData(array); }
 
+    // Borrowed two-segment view of the latest time-domain window - zero
+    // copies per refresh for a scope drawing straight from the ring. See
+    // RealtimeAnalyser::floatTimeDomainView for the validity rules; changing
+    // the fft size also invalidates the view, since the analyser (and its
+    // ring) is rebuilt.
+    RealtimeAnalyser::TimeDomainView floatTimeDomainView() { return m_analyser->floatTimeDomainView(); } // LabSound
+
 private:
     void shared_construction(size_t fftSize);
 
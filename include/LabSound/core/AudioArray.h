@@ -11,59 +11,53 @@
 
 namespace lab {
 
+    // All audio sample storage - AudioArray, and through it AudioChannel,
+    // AudioBus contiguous backing, and DSP kernel state - is allocated
+    // through this one facility, so every buffer carries the same alignment
+    // guarantee. 64 bytes covers every SIMD vector width in use as well as
+    // the common cache line size, so buffers never straddle a line at their
+    // start and wider-vector kernels need no per-buffer checks.
+    const size_t kAudioBufferAlignment = 64;
+
+    // Returns kAudioBufferAlignment-aligned, zero-initialized memory;
+    // release with audioBufferFree. Never returns misaligned memory.
+    void * audioBufferAllocate(size_t bytes);
+    void audioBufferFree(void * p);
+
+// Advertises the allocation guarantee to the compiler at a buffer's start so
+// vectorized consumers get aligned codegen without a runtime test.
+#if defined(__GNUC__) || defined(__clang__)
+#define LAB_ASSUME_ALIGNED(p) __builtin_assume_aligned((p), 64)
+#else
+#define LAB_ASSUME_ALIGNED(p) (p)
+#endif
+
     template<typename T>
     class AudioArray {
     public:
-        AudioArray() : m_allocation(0), m_alignedData(0), m_size(0) { }
-        explicit AudioArray(size_t n) : m_allocation(0), m_alignedData(0), m_size(0)
+        AudioArray() : m_data(0), m_size(0) { }
+        explicit AudioArray(size_t n) : m_data(0), m_size(0)
         {
             allocate(n);
         }
 
         ~AudioArray()
         {
-            free(m_allocation);
+            audioBufferFree(m_data);
         }
 
         // It's OK to call allocate() multiple times, but data will *not* be copied from an initial allocation
         // if re-allocated. Allocations are zero-initialized.
         void allocate(size_t n)
         {
-            size_t initialSize = sizeof(T) * n;
-            
-            const size_t alignment = 16;
-            
-            if (m_allocation)
-                free(m_allocation);
-
-            bool isAllocationGood = false;
-
-            while (!isAllocationGood) {
-                // Initially we try to allocate the exact size, but if it's not aligned
-                // then we'll have to reallocate and from then on allocate extra.
-                static size_t extraAllocationBytes = 0;
-
-                T* allocation = static_cast<T*>(malloc(initialSize + extraAllocationBytes));
-                if (!allocation) {
-                    //CRASH(); // dimitri
-                }
-                T* alignedData = alignedAddress(allocation, alignment);
-
-                if (alignedData == allocation || extraAllocationBytes == alignment) {
-                    m_allocation = allocation;
-                    m_alignedData = alignedData;
-                    m_size = n;
-                    isAllocationGood = true;
-                    zero();
-                } else {
-                    extraAllocationBytes = alignment; // always allocate extra after the first alignment failure.
-                    free(allocation);
-                }
-            }
+            if (m_data)
+                audioBufferFree(m_data);
+            m_data = static_cast<T*>(audioBufferAllocate(sizeof(T) * n));
+            m_size = n;
         }
 
-        T* data() { return m_alignedData; }
-        const T* data() const { return m_alignedData; }
+        T* data() { return static_cast<T*>(LAB_ASSUME_ALIGNED(m_data)); }
+        const T* data() const { return static_cast<const T*>(LAB_ASSUME_ALIGNED(m_data)); }
         size_t size() const { return m_size; }
 
         T& at(size_t i)
@@ -104,14 +98,7 @@ namespace lab {
         }
         
     private:
-        static T* alignedAddress(T* address, intptr_t alignment)
-        {
-            intptr_t value = reinterpret_cast<intptr_t>(address);
-            return reinterpret_cast<T*>((value + alignment - 1) & ~(alignment - 1));
-        }
-        
-        T* m_allocation;
-        T* m_alignedData;
+        T* m_data;
         size_t m_size;
     };
     
@@ -23,7 +23,10 @@ public:
     virtual ~AudioBasicInspectorNode() { }
 
     // AudioNode
-    virtual void pullInputs(ContextRenderLock& r, size_t framesToProcess) override;
+    // An inspector passes the input through unprocessed, so the input may
+    // simply alias the output bus and process() only observes the samples.
+    virtual bool canProcessInPlace() const override { return true; }
+
     virtual void checkNumberOfChannelsForInput(ContextRenderLock&, AudioNodeInput*) override;
 };
 
@@ -8,6 +8,7 @@
 #include "LabSound/core/AudioNode.h"
 #include "LabSound/core/AudioProcessor.h"
 #include <memory>
+#include <vector>
 
 namespace lab {
 
@@ -25,8 +26,23 @@ public:
 
     // AudioNode
     virtual void process(ContextRenderLock&, size_t framesToProcess) override;
-    virtual void pullInputs(ContextRenderLock&, size_t framesToProcess) override;
     virtual void reset(ContextRenderLock&) override;
+
+    // When the topology compiler fused the upstream chain into this node
+    // (see AudioContext::fusedChainFor), pulls the chain head's input
+    // instead of this node's; process() then runs every stage's processor
+    // over one buffer.
+    virtual void pullInputs(ContextRenderLock&, size_t framesToProcess) override;
+
+    // In fused mode the silence bookkeeping must look at what was actually
+    // pulled - the chain head's input - and the chain rings for the sum of
+    // every stage's tail, not just this node's.
+    virtual bool inputsAreSilent(ContextRenderLock&) override;
+    virtual bool propagatesSilence(ContextRenderLock&) const override;
+
+    // Every AudioProcessor in the tree processes index-aligned, so the
+    // source bus may alias the destination bus.
+    virtual bool canProcessInPlace() const override { return true; }
     virtual void initialize() override;
     virtual void uninitialize() override;
 
@@ -44,8 +60,22 @@ protected:
     AudioProcessor * processor();
     AudioProcessor * processor() const;
 
+    // Runs the fused upstream stages and then this node's processor over
+    // the output bus in a single pass.
+    void processFusedChain(ContextRenderLock&, size_t framesToProcess);
+
     std::unique_ptr<AudioProcessor> m_processor;
 
+    // Render-thread scratch for chain fusion, refreshed each quantum in
+    // pullInputs(); the stage list lives in the context's render-order
+    // cache and is stable while the graph generation is unchanged.
+    const std::vector<AudioBasicProcessorNode *> * m_fusedStages = nullptr;
+    AudioBus * m_fusedSourceBus = nullptr;
+
+    // Frames of tail (plus latency) left to ring out after the input went
+    // silent; when it reaches zero, process() skips the processor entirely.
+    int64_t m_tailFramesRemaining{ 0 };
+
 };
 
 } // namespace lab
@@ -7,6 +7,7 @@
 
 #include "LabSound/core/Mixing.h"
 #include "LabSound/core/AudioChannel.h"
+#include "LabSound/core/Constants.h"
 #include <vector>
 #include <iostream>
 
@@ -33,7 +34,12 @@ public:
     // allocate indicates whether or not to initially have the AudioChannels created with managed storage.
     // Normal usage is to pass true here, in which case the AudioChannels will memory-manage their own storage.
     // If allocate is false then setChannelMemory() has to be called later on for each channel before the AudioBus is useable...
-    AudioBus(size_t numberOfChannels, size_t length, bool allocate = true);
+    //
+    // When contiguous is true all channels are carved from one aligned
+    // allocation, planar and back to back, so a stereo bus occupies a single
+    // memory stream instead of two distant ones. Channel semantics are
+    // unchanged; only locality differs. Ignored when allocate is false.
+    AudioBus(size_t numberOfChannels, size_t length, bool allocate = true, bool contiguous = false);
 
     // Tells the given channel to use an externally allocated buffer.
     void setChannelMemory(size_t channelIndex, float* storage, size_t length);
@@ -56,6 +62,10 @@ public:
     // Number of sample-frames
     size_t length() const { return m_length; }
 
+    // Bytes of sample storage owned by the channels; channels referencing
+    // external memory contribute nothing.
+    size_t memoryBytes() const;
+
     // resizeSmaller() can only be called with a new length <= the current length.
     // The data stored in the bus will remain undisturbed.
     void resizeSmaller(size_t newLength);
@@ -82,8 +92,12 @@ public:
 
     // Creates a new AudioBus by sample-rate converting sourceBus to the newSampleRate.
     // setSampleRate() must have been previously called on sourceBus.
+    // quality selects the conversion tier (see ResamplerQuality); callers
+    // converting assets for a context should pass the tier from the context's
+    // resampler quality policy rather than assuming full sinc.
     // Note: sample-rate conversion is already handled in the file-reading code for the mac port, so we don't need this.
-    static std::unique_ptr<AudioBus> createBySampleRateConverting(const AudioBus * sourceBus, bool mixToMono, float newSampleRate);
+    static std::unique_ptr<AudioBus> createBySampleRateConverting(const AudioBus * sourceBus, bool mixToMono, float newSampleRate,
+                                                                 ResamplerQuality quality = ResamplerQuality::FullSinc);
 
     // Creates a new AudioBus by mixing all the channels down to mono.
     // If sourceBus is already mono, then the returned AudioBus will simply be a copy.
@@ -101,6 +115,45 @@ public:
     // Our own internal gain m_busGain is ignored.
     void sumFrom(const AudioBus & sourceBus, ChannelInterpretation = ChannelInterpretation::Speakers);
 
+    // A mixing kernel with the channel topology fixed at compile time.
+    typedef void (*MixFunction)(AudioBus & destination, const AudioBus & source);
+
+    // Returns a kernel specialized for the given topology. Mono->mono,
+    // mono->stereo and stereo->stereo - the overwhelming majority of
+    // connections - get fixed-channel kernels with no per-quantum dispatch,
+    // and every other canonical speaker pair gets a kernel executing a
+    // coefficient matrix resolved once; only non-canonical layouts fall back
+    // to the generic runtime-dispatched sumFrom/copyFrom. Select once when a
+    // connection's channel counts settle, then call the returned function
+    // every quantum.
+    static MixFunction selectSumFunction(size_t sourceChannels, size_t destinationChannels);
+    static MixFunction selectCopyFunction(size_t sourceChannels, size_t destinationChannels);
+
+    // A speaker mix resolved to per-channel coefficients. coefficient[d][s]
+    // is the gain applied to source channel s when accumulated into
+    // destination channel d; zero entries cost nothing at execution time.
+    struct ChannelMixMatrix
+    {
+        static const size_t MaxMixChannels = 8;
+        size_t sourceChannels = 0;
+        size_t destinationChannels = 0;
+        bool valid = false;
+        float coefficient[MaxMixChannels][MaxMixChannels] = {};
+    };
+
+    // Resolves the speaker-interpretation mix between two canonical layouts
+    // (mono, stereo, quad, 5.1, 7.1) into a coefficient matrix, including the
+    // proper 5.1/7.1 -> stereo and quad downmixes which previously fell back
+    // to the discrete path. valid is false for non-canonical channel counts.
+    static ChannelMixMatrix speakerMixMatrix(size_t sourceChannels, size_t destinationChannels);
+
+    // Execute a resolved matrix. sumFromByMatrix accumulates
+    // destination[d] += sum over s of coefficient[d][s] * source[s];
+    // copyFromByMatrix overwrites, zeroing destination channels with no
+    // contributing sources. Both skip silent source channels.
+    void sumFromByMatrix(const AudioBus & sourceBus, const ChannelMixMatrix & matrix);
+    void copyFromByMatrix(const AudioBus & sourceBus, const ChannelMixMatrix & matrix);
+
     // Copy each channel from sourceBus into our corresponding channel.
     // We scale by targetGain (and our own internal gain m_busGain), performing "de-zippering" to smoothly change from *lastMixGain to (targetGain*m_busGain).
     // The caller is responsible for setting up lastMixGain to point to storage which is unique for every "stream" which will be applied to this bus.
@@ -110,6 +163,16 @@ public:
     // Copies the sourceBus by scaling with sample-accurate gain values.
     void copyWithSampleAccurateGainValuesFrom(const AudioBus & sourceBus, float* gainValues, size_t numberOfGainValues);
 
+    // True if the channels share one contiguous allocation.
+    bool isContiguous() const { return m_contiguousStorage != nullptr; }
+
+    // Packs frames frames of this bus into dest as interleaved sample frames
+    // (L R L R ... for stereo), and the reverse. Stereo uses an SSE2 unpack
+    // path; boundaries that need packed frames (recording, device formats)
+    // should use these rather than rolling per-sample loops.
+    void interleave(float * dest, size_t frames) const;
+    void deinterleave(const float * source, size_t frames);
+
     // Returns maximum absolute value across all channels (useful for normalization).
     float maxAbsValue() const;
 
@@ -126,8 +189,6 @@ protected:
     void discreteCopyFrom(const AudioBus&);
     void speakersSumFrom(const AudioBus&);
     void discreteSumFrom(const AudioBus&);
-    void speakersSumFrom5_1_ToMono(const AudioBus&);
-    void speakersSumFrom7_1_ToMono(const AudioBus&);
 
     size_t m_length;
 
@@ -135,9 +196,12 @@ protected:
 
     int m_layout = LayoutCanonical;
 
+    // Backing block when the contiguous layout was requested; the channels
+    // reference slices of it.
+    std::unique_ptr<AudioFloatArray> m_contiguousStorage;
+
     float m_busGain = 1.0f;
 
-    std::unique_ptr<AudioFloatArray> m_dezipperGainValues;
 
     bool m_isFirstTime = true;
     float m_sampleRate = 0.0f;
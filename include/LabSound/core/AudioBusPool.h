@@ -0,0 +1,58 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef AudioBusPool_h
+#define AudioBusPool_h
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lab {
+
+class AudioBus;
+
+// AudioBusPool recycles render-quantum sized AudioBus instances so that graph
+// changes during steady-state rendering do not hit the system allocator from
+// the audio thread. Busses are keyed by channel count; every bus in a pool has
+// the same length (normally AudioNode::ProcessingSizeInFrames) and 16 byte
+// aligned channel storage, as guaranteed by AudioArray.
+//
+// acquire() hands out a zeroed bus, recycling one if available. Returning a bus
+// with release() makes it available for reuse; it is also fine to simply drop a
+// bus, in which case it is freed as usual.
+class AudioBusPool
+{
+public:
+    explicit AudioBusPool(size_t length);
+    ~AudioBusPool();
+
+    // Returns a zeroed bus with the requested channel count.
+    std::unique_ptr<AudioBus> acquire(size_t numberOfChannels);
+
+    // Returns a bus to the pool for reuse. Busses whose length does not match
+    // the pool's length are simply freed.
+    void release(std::unique_ptr<AudioBus> bus);
+
+    // Preallocates count busses of the given channel count so that the first
+    // acquisitions on the render thread do not allocate.
+    void prime(size_t numberOfChannels, size_t count);
+
+    size_t length() const { return m_length; }
+
+    // Bytes of sample storage held by the pooled (idle) busses. Busses
+    // currently checked out are attributed to their owners.
+    size_t memoryBytes();
+
+private:
+    size_t m_length;
+
+    std::mutex m_mutex;
+
+    // free lists indexed by channel count
+    std::vector<std::vector<std::unique_ptr<AudioBus>>> m_free;
+};
+
+} // lab
+
+#endif // AudioBusPool_h
@@ -57,6 +57,10 @@ public:
     // How many sample-frames do we contain?
     size_t length() const { return m_length; }
 
+    // Bytes of sample storage this channel owns; zero when referencing
+    // external memory.
+    size_t memoryBytes() const { return m_memBuffer ? m_memBuffer->size() * sizeof(float) : 0; }
+
     // resizeSmaller() can only be called with a new length <= the current length.
     // The data stored in the bus will remain undisturbed.
     void resizeSmaller(size_t newLength);
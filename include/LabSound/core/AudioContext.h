@@ -6,11 +6,13 @@
 #ifndef AUDIO_CONTEXT_H
 #define AUDIO_CONTEXT_H
 
-#include "LabSound/core/ConcurrentQueue.h"
 #include "LabSound/core/AudioScheduledSourceNode.h"
+#include "LabSound/core/Constants.h"
 
 #include <set>
 #include <atomic>
+#include <map>
+#include <queue>
 #include <vector>
 #include <memory>
 #include <thread>
@@ -22,6 +24,10 @@
 namespace lab
 {
 
+class AudioBasicProcessorNode;
+class AudioBusPool;
+class AudioParam;
+class AudioSetting;
 class AudioDestinationNode;
 class AudioListener;
 class AudioNode;
@@ -32,6 +38,8 @@ class AudioNodeOutput;
 class ContextGraphLock;
 class ContextRenderLock;
 
+class SampledAudioNode;
+
 class AudioContext
 {
     friend class ContextGraphLock;
@@ -55,6 +63,24 @@ public:
     // It *is* harmless to call it though, it's just not necessary.
     void lazyInitialize();
 
+    // Kicks every deferred startup cost concurrently: the output device
+    // stream open (via lazyInitialize), the standard oscillator wavetable
+    // bank, the per-size FFT tables, and - when a search path is supplied -
+    // the HRTF database decode. Returns immediately; poll isPrewarmed() to
+    // learn when everything has landed, so a loading screen can hide audio
+    // initialization completely. Must be called from the main thread, after
+    // the destination node has been set. Optional: everything prewarm covers
+    // is otherwise initialized lazily on first use.
+    void prewarm(const std::string & hrtfSearchPath = std::string());
+
+    // True once every task kicked off by prewarm() has completed.
+    bool isPrewarmed() const;
+
+    // Optionally builds the standard oscillator wavetables for this context's
+    // sample rate ahead of first use, removing table-construction cost from
+    // the first-sound path. Safe to call at any time from the main thread.
+    void prewarmWaveTables();
+
     void setDestinationNode(std::shared_ptr<AudioDestinationNode> node);
 
     std::shared_ptr<AudioDestinationNode> destination();
@@ -65,6 +91,24 @@ public:
 
     double currentTime() const;
 
+    // A high-resolution scheduling clock. currentTime() advances in whole
+    // render quanta, so events scheduled against it quantize to the quantum;
+    // this clock extrapolates between device callbacks with the wall clock and
+    // adds the backend's reported output latency, giving the earliest context
+    // time at which a newly scheduled event can actually be heard. Use it as
+    // the "now" for AudioScheduledSourceNode::start() when placement matters.
+    // For an offline context it is simply currentTime().
+    double predictedPresentationTime() const;
+
+    // The backend's reported output latency in seconds (device buffering plus
+    // any hardware latency the driver exposes); zero offline or when unknown.
+    double outputLatency() const;
+
+    // The device's stream clock as of the last callback; diagnostic, for
+    // correlating the context clock against the hardware. Zero when the
+    // backend cannot report it.
+    double deviceStreamTime() const;
+
     float sampleRate() const;
 
     AudioListener & listener();
@@ -81,13 +125,166 @@ public:
     // Only an AudioDestinationNode should call this.
     void processAutomaticPullNodes(ContextRenderLock &, size_t framesToProcess);
 
+    // Number of nodes currently registered for automatic pulling. Pulled nodes
+    // (recorders, analysers) do real work even while the output is silent, so
+    // the offline silence fast-forward refuses to skip time while any exist.
+    size_t automaticPullNodeCount(ContextRenderLock &);
+
+    // A flat array of the graph's node outputs in render (topological) order, recomputed
+    // only when a connection or disconnection has been applied. Iterating this array and
+    // calling processIfNecessary() on each node renders the graph without deep recursion;
+    // the per-quantum processing cache makes the subsequent destination pull a cheap sum.
+    // The pointers are plain - lifetime is guaranteed by the summing-junction
+    // snapshots, which pin every connected output until a topology change is
+    // applied. Only valid on the render thread.
+    const std::vector<AudioNodeOutput *> & renderOrder(ContextRenderLock &);
+
+    // Monotonic counter bumped whenever node or param connections change;
+    // caches derived from the topology (the flattened render order, the
+    // parallel scheduler's partitions) compare against it to detect
+    // staleness cheaply.
+    uint64_t graphGeneration() const { return m_graphGeneration.load(std::memory_order_acquire); }
+
+    // Upstream processor stages renderOrder() fused into the given node, in
+    // head-to-tail order (the node itself excluded), or null when the node
+    // heads no chain or the cached order is stale. A linear run of basic
+    // processor nodes - the classic source->filter->shaper voice - then
+    // executes as one pass over one buffer inside the tail node's process(),
+    // skipping the per-node dispatch and junction checks of the interior
+    // hops. Only valid on the render thread.
+    const std::vector<AudioBasicProcessorNode *> * fusedChainFor(const AudioNode * tail) const;
+
     void connect(std::shared_ptr<AudioNode> destination, std::shared_ptr<AudioNode> source, uint32_t destIdx = 0, uint32_t srcIdx = 0);
     void disconnect(std::shared_ptr<AudioNode> destination, std::shared_ptr<AudioNode> source, uint32_t destIdx = 0, uint32_t srcidx = 0);
 
+    // One edge edit in a batched topology transaction; connect false means
+    // disconnect, with the same null-pointer semantics as disconnect() (a null
+    // source or destination disconnects everything from the other end).
+    struct ConnectionOperation
+    {
+        bool connect = true;
+        std::shared_ptr<AudioNode> destination;
+        std::shared_ptr<AudioNode> source;
+        uint32_t destIndex = 0;
+        uint32_t srcIndex = 0;
+    };
+
+    // Queues a list of connects/disconnects as one transaction: the whole
+    // list is validated up front (a throw leaves the graph untouched), then
+    // queued under a single lock acquisition with a single graph-thread
+    // wakeup. Building a large mixer graph this way costs one synchronization
+    // round-trip instead of one per edge.
+    void applyConnectionBatch(const std::vector<ConnectionOperation> & operations);
+
+    // True while topology changes queued by connect(), disconnect(),
+    // connectParam() or applyConnectionBatch() have not yet been applied by
+    // the graph update thread (a disconnect counts until its fade-out has
+    // finished). Offline tooling polls this to know the graph has settled
+    // before rendering, so the output doesn't depend on thread timing.
+    bool hasPendingUpdates();
+
     void connectParam(std::shared_ptr<AudioParam> param, std::shared_ptr<AudioNode> driver, uint32_t index);
 
     void holdSourceNodeUntilFinished(std::shared_ptr<AudioScheduledSourceNode> node);
 
+    // Hands a node reference to the context so its destructor never runs on a
+    // latency-sensitive thread. Destroying a subgraph can free convolver
+    // partitions, sample buffers, and delay lines; dropping the last
+    // shared_ptr on the main thread (or under the graph lock) stalls for
+    // milliseconds on a large graph. reclaim() is O(1) for the caller: the
+    // reference parks on a reclamation list and the graph update thread
+    // destroys it outside any lock, once the render thread has passed the
+    // quantum in which the node was handed over. Unlinked nodes from
+    // disconnect() are routed through the same list automatically; call this
+    // directly when releasing node references a disconnect never saw.
+    void reclaim(std::shared_ptr<AudioNode> node);
+
+    // One record of a batch grain schedule; when is absolute context time in
+    // seconds, and a grainDuration of zero means play the whole buffer.
+    struct GrainSchedule
+    {
+        std::shared_ptr<SampledAudioNode> node;
+        double when = 0;
+        double grainOffset = 0;
+        double grainDuration = 0;
+    };
+
+    // Queues a batch of grain starts to the render thread, which applies them
+    // at the top of the next render quantum. A sequencer triggering dozens of
+    // notes pays one enqueue pass instead of per-event synchronization, and
+    // every record in the batch is resolved against the same context time.
+    // The render thread side never locks or allocates; if the fixed-capacity
+    // queue fills, the remaining records are applied inline instead (which is
+    // safe, merely not deferred). A node holds a single pending start, so a
+    // later record for the same node supersedes an earlier one, exactly as
+    // with back-to-back startGrain() calls.
+    void scheduleGrains(const GrainSchedule * schedules, size_t count);
+    void scheduleGrains(const std::vector<GrainSchedule> & schedules);
+
+    // One typed command for the render thread; when is absolute context time
+    // in seconds, and zero (or any time already past) means apply at the top
+    // of the next quantum. Only the fields the type reads need to be set.
+    struct RenderCommand
+    {
+        enum Type
+        {
+            SetParamValue = 0,  // param, floatValue
+            SetSettingFloat,    // setting, floatValue
+            SetSettingUint32,   // setting, uintValue
+            StartSource,        // source
+            StopSource,         // source
+        };
+
+        Type type = SetParamValue;
+        double when = 0;
+        std::shared_ptr<AudioParam> param;
+        std::shared_ptr<AudioSetting> setting;
+        std::shared_ptr<AudioScheduledSourceNode> source;
+        float floatValue = 0.f;
+        uint32_t uintValue = 0;
+    };
+
+    // Queues a batch of typed commands to the render thread through the same
+    // kind of fixed-capacity ring scheduleGrains() uses: one enqueue pass for
+    // the whole batch, no per-command synchronization. The render thread
+    // drains the ring at the top of each quantum and applies what is due.
+    // Start/stop and future-dated param values route through the node
+    // scheduler and the param timeline, so they land on their exact sample
+    // within the quantum; settings are quantum-granular and apply at the
+    // boundary of the quantum containing their time. If the ring fills, the
+    // remaining records are applied inline (safe, merely not deferred).
+    void enqueueCommands(const RenderCommand * commands, size_t count);
+    void enqueueCommands(const std::vector<RenderCommand> & commands);
+
+    // Parks the destination's device stream without tearing the graph down:
+    // the device callback stops firing and the graph update thread quiesces
+    // onto an indefinite wait instead of its periodic tick, so a paused
+    // application stops burning CPU on silence. The graph, its connections
+    // and all scheduling state survive; the context clock simply stops
+    // advancing until resume(). No-ops on an offline context.
+    void suspend();
+    void resume();
+
+    // True while suspended, whether explicitly or by auto-idle.
+    bool isSuspended() const;
+
+    // When enabled, the context suspends itself after idleSeconds of
+    // verified output silence (measured against the rendered samples, see
+    // AudioDestinationNode::silentDuration). Any queued connection, param
+    // connection or grain batch wakes it automatically; note that starting
+    // an already-connected source goes straight to the node and is invisible
+    // here, so such callers must resume() explicitly. Off by default.
+    void setAutoIdle(bool enabled, double idleSeconds = 10.0);
+
+    // Call when the OS default output device changed or the device's rate
+    // changed. The destination reopens against the new device and bridges
+    // any rate difference with a resampling stage at the device boundary, so
+    // the graph keeps rendering at its original rate and rate-dependent
+    // resources (wavetables, convolver partitions, the HRTF database) all
+    // survive; the switch costs a moment of resampling instead of a context
+    // rebuild. No-op on an offline context.
+    void handleDeviceChange();
+
     // Necessary to call when using an OfflineAudioDestinationNode
     void startRendering();
     std::function<void()> offlineRenderCompleteCallback;
@@ -95,18 +292,196 @@ public:
     // event dispatching will be called automatically, depending on constructor
     // argument. If not automatically dispatching, it is the user's responsibility
     // to call dispatchEvents often enough to satisfy the user's needs.
-    void enqueueEvent(std::function<void()>&);
+    //
+    // enqueueEvent is called from the render thread and never allocates or
+    // blocks: the record (handler, node id, context time) goes into a
+    // fixed-capacity queue. Copying the shared_ptr only bumps a reference
+    // count, and it keeps the handler alive even if the node is released
+    // before dispatch. If the queue is full the event is dropped.
+    void enqueueEvent(const std::shared_ptr<std::function<void()>> & handler, uint64_t nodeId, double when);
     void dispatchEvents();
 
+    // Budgeted dispatch for callers pumping events once per frame: drains at
+    // most maxEvents events (0 means unbounded) and returns the number
+    // dispatched; overflow stays queued for the next call, so a burst of
+    // hundreds of onEnded events costs a bounded slice of each frame instead
+    // of one hitch.
+    size_t dispatchEvents(size_t maxEvents);
+
+    // Coalesced dispatch: while a batched handler is installed,
+    // dispatchEvents() collects the node ids of the drained events and makes
+    // one invocation per call with the whole batch, instead of invoking each
+    // event's own handler - one callback per frame no matter how many
+    // sources finished. Install nullptr to return to per-event handlers.
+    using BatchedEventHandler = std::function<void(const std::vector<uint64_t> & finishedNodeIds)>;
+    void setBatchedEventHandler(BatchedEventHandler handler);
+
+    // Pool of render-quantum sized busses, recycled so graph changes don't hit
+    // the system allocator from the audio thread.
+    AudioBusPool & renderBusPool();
+
+    // Count of render quanta the audio callback had to skip (emitting silence)
+    // because the render lock could not be acquired within its deadline.
+    uint64_t missedRenderQuanta() const { return m_missedRenderQuanta.load(); }
+    void countMissedRenderQuantum() { m_missedRenderQuanta.fetch_add(1, std::memory_order_relaxed); }
+
+    // When enabled, processIfNecessary() records each node's processing cost so
+    // callback budget overruns can be attributed to a node. Off by default.
+    void setProfilingEnabled(bool enabled) { m_profilingEnabled.store(enabled, std::memory_order_relaxed); }
+    bool profilingEnabled() const { return m_profilingEnabled.load(std::memory_order_relaxed); }
+
+    // Context-wide sample-rate conversion quality, by use case. Conversion
+    // paths consult their tier when they are built: buffers converted at
+    // load (convolver impulses and other asset preparation) take
+    // assetPreparation, realtime streaming conversions take streaming, and
+    // SampledAudioNode voices without an explicit setInterpolation() take
+    // voicePlayback. Set the policy before loading or starting the material
+    // it should affect; existing resamplers are not rebuilt. An offline bake
+    // context can run everything at FullSinc while a realtime context keeps
+    // one-shots on the cheap tier.
+    struct ResamplerQualityPolicy
+    {
+        ResamplerQuality assetPreparation = ResamplerQuality::FullSinc;
+        ResamplerQuality streaming = ResamplerQuality::SmallSinc;
+        ResamplerQuality voicePlayback = ResamplerQuality::Linear;
+    };
+    void setResamplerQualityPolicy(const ResamplerQualityPolicy & policy) { m_resamplerQualityPolicy = policy; }
+    const ResamplerQualityPolicy & resamplerQualityPolicy() const { return m_resamplerQualityPolicy; }
+
+    struct NodeProfile
+    {
+        AudioNode * node = nullptr;
+        uint64_t quanta = 0;           // quanta actually processed (silent quanta are skipped)
+        double averageMicroseconds = 0; // mean cost of a processed quantum
+        uint64_t maxMicroseconds = 0;   // worst quantum observed
+
+        // Heap allocations seen inside this node's process(); always zero
+        // unless the library was built with LABSOUND_RENDER_ALLOC_DETECTOR
+        // and detection was enabled.
+        uint64_t allocations = 0;
+        uint64_t allocationBytes = 0;
+    };
+
+    // Snapshot of the accumulated per-node costs for every node reachable from the
+    // destination, most expensive first. Node pointers remain valid while the
+    // render lock is held.
+    std::vector<NodeProfile> nodeProfile(ContextRenderLock &);
+
+    // Aggregated audio-heap attribution: the sum of queryMemory() over every
+    // node reachable from the destination plus the automatic pull nodes and
+    // the context's render bus pool. Sizes are read from counters - no sample
+    // data is touched - so this is cheap enough to poll every frame for a
+    // budget dashboard, and a steady climb in convolverBytes between polls
+    // points straight at convolver churn.
+    AudioNode::MemoryUsage queryMemory(ContextRenderLock &);
+
+    // A self-contained copy of the graph's topology: every node reachable from
+    // the destination (through inputs and param connections), the edges between
+    // them, and the accumulated profiling counters. Unlike NodeProfile the
+    // snapshot holds no pointers, so it can be serialized, diffed between
+    // builds, or handed to offline tooling after the lock is released.
+    struct GraphSnapshot
+    {
+        struct Node
+        {
+            uint64_t id = 0;                // AudioNode::id()
+            std::string type;               // the node's class name, e.g. "GainNode"
+            size_t numberOfInputs = 0;
+            size_t numberOfOutputs = 0;
+            size_t channelCount = 0;
+            ChannelCountMode channelCountMode = ChannelCountMode::Max;
+            ChannelInterpretation channelInterpretation = ChannelInterpretation::Speakers;
+
+            // Accumulated cost counters; all zero unless profiling was enabled.
+            uint64_t profiledQuanta = 0;
+            double averageMicroseconds = 0;
+            uint64_t maxMicroseconds = 0;
+        };
+
+        struct Edge
+        {
+            uint64_t sourceId = 0;
+            size_t sourceOutput = 0;
+            uint64_t destinationId = 0;
+            size_t destinationInput = 0;    // meaningless when param is non-empty
+            std::string param;              // non-empty when the edge drives an AudioParam
+        };
+
+        std::vector<Node> nodes;
+        std::vector<Edge> edges;
+
+        // The snapshot as a JSON document with "nodes" and "edges" arrays,
+        // for diffing and external tooling.
+        std::string json() const;
+    };
+
+    // Walks the graph from the destination and copies plain data only; the
+    // lock is held just for the walk, and the caller serializes afterwards.
+    // Connections are read from the rendering state, so the snapshot reflects
+    // what the audio thread actually pulls, not connections still pending.
+    GraphSnapshot graphSnapshot(ContextRenderLock &);
+
+    // Placement and scheduling for the engine's internal threads. On a large
+    // machine the default scheduler may migrate workers across sockets, and
+    // cross-NUMA traffic is expensive for memory-bound work like convolution;
+    // a host that knows its topology can confine each class of thread.
+    enum class ThreadRole : int
+    {
+        GraphUpdate = 0,  // the context's graph update thread
+        Render,           // offline render threads and parallel graph workers
+        Background,       // convolver, HRTF loader, streaming and file IO workers
+        DeviceCallback,   // the platform audio callback, elevated in place
+    };
+
+    struct ThreadPolicy
+    {
+        enum Priority : int
+        {
+            PRIORITY_DEFAULT = 0,   // whatever the platform scheduler assigns
+            PRIORITY_BACKGROUND,    // below normal; bulk work off the audio path
+            PRIORITY_ELEVATED,      // above normal, not realtime
+            PRIORITY_REALTIME,      // realtime class where the platform allows it
+        };
+
+        Priority priority = PRIORITY_DEFAULT;
+
+        // Bit n allows logical processor n; zero leaves the thread unrestricted.
+        // On Apple platforms affinity is only a cache-sharing hint.
+        uint64_t affinityMask = 0;
+
+        // When >= 0, pins to that single logical processor, overriding affinityMask.
+        int pinnedCore = -1;
+    };
+
+    // Policies are process-wide, like several of the threads they govern.
+    // A policy applies to threads created after the call; the device callback
+    // picks up changes on its next buffer. By default everything is
+    // PRIORITY_DEFAULT and unrestricted except DeviceCallback, which asks for
+    // the realtime class. Elevation and pinning failures (insufficient
+    // privileges, an empty usable mask) are ignored and the thread runs with
+    // whatever the platform granted.
+    static void setThreadPolicy(ThreadRole role, const ThreadPolicy & policy);
+    static ThreadPolicy threadPolicy(ThreadRole role);
+
 private:
 
     std::mutex m_graphLock;
-    std::mutex m_renderLock;
+
+    // a timed mutex so the audio callback can bound its wait and emit silence
+    // instead of blocking behind a main thread holding the render lock
+    std::timed_mutex m_renderLock;
     std::mutex m_updateMutex;
     std::condition_variable cv;
 
     std::atomic<bool> updateThreadShouldRun{ true };
     std::thread graphUpdateThread;
+
+    // Workers launched by prewarm(), joined in the destructor. The pending
+    // count reaching zero is what isPrewarmed() reports.
+    std::vector<std::thread> m_prewarmThreads;
+    std::atomic<int> m_prewarmTasksPending{0};
+    std::atomic<bool> m_prewarmStarted{false};
+
     void update();
     float graphKeepAlive{ 0.f };
     float lastGraphUpdateTime{ 0.f };
@@ -114,26 +489,99 @@ private:
     bool m_isInitialized = false;
     bool m_isAudioThreadFinished = false;
     bool m_isOfflineContext = false;
-    bool m_automaticPullNodesNeedUpdating = false; // keeps track if m_automaticPullNodes is modified.
 
     void uninitialize();
 
     void handleAutomaticSources();
-    void updateAutomaticPullNodes();
+
+    // Rebuilds and atomically publishes the flat render array from
+    // m_automaticPullNodes. Caller holds m_updateMutex.
+    void publishAutomaticPullNodes();
 
     std::shared_ptr<AudioDestinationNode> m_destinationNode;
     std::shared_ptr<AudioListener> m_listener;
 
+    // bumped by the graph update thread whenever topology changes are applied
+    std::atomic<uint64_t> m_graphGeneration{1};
+
+    std::atomic<uint64_t> m_missedRenderQuanta{0};
+
+    std::atomic<bool> m_profilingEnabled{false};
+
+    ResamplerQualityPolicy m_resamplerQualityPolicy;
+
+    // Suspension state; m_autoIdled is the variant entered (and left) by the
+    // graph update thread on the auto-idle policy rather than by the host.
+    std::atomic<bool> m_suspended{false};
+    std::atomic<bool> m_autoIdled{false};
+    std::atomic<bool> m_autoIdleEnabled{false};
+    std::atomic<float> m_autoIdleSeconds{10.f};
+
+    // Restarts the device stream if auto-idle had parked it; called from the
+    // enqueue paths that constitute evidence the graph is live again.
+    void wakeFromAutoIdle();
+
+    std::unique_ptr<AudioBusPool> m_renderBusPool;
+
+    // render-thread cache of the graph in topological order, and the generation it was built at
+    std::vector<AudioNodeOutput *> m_renderOrder;
+    uint64_t m_renderOrderGeneration = 0;
+
+    // rebuilt with m_renderOrder: for each chain tail, the fused upstream stages
+    std::map<const AudioNode *, std::vector<AudioBasicProcessorNode *>> m_fusedChains;
+
     // @TODO migrate most of the internal datastructures such as PendingConnection
     // into Internals as there's no need to expose these at all.
     struct Internals;
     std::unique_ptr<Internals> m_internal;
 
-    std::set<std::shared_ptr<AudioNode>> m_automaticPullNodes; // queue for added pull nodes
-    std::vector<std::shared_ptr<AudioNode>> m_renderingAutomaticPullNodes; // vector of known pull nodes
+    std::set<std::shared_ptr<AudioNode>> m_automaticPullNodes; // registration set, touched under m_updateMutex
+
+    // Immutable flat snapshot of m_automaticPullNodes, republished on every
+    // add/remove and read on the render thread with one atomic load per
+    // quantum; each new pointer is effectively a new version, so the render
+    // path walks a plain array with no lock and no set iteration.
+    std::shared_ptr<const std::vector<std::shared_ptr<AudioNode>>> m_renderingAutomaticPullNodes;
 
+    // Fire-and-forget voices watched for FINISHED_STATE. Owned by the render
+    // thread; holdSourceNodeUntilFinished() feeds it through a ring in
+    // Internals, so neither starting nor watching a voice takes a lock.
     std::vector<std::shared_ptr<AudioScheduledSourceNode>> automaticSources;
 
+    // Render-thread scratch for the voices that finished this quantum; they
+    // move to m_finishedSourceBatch under one m_updateMutex acquisition.
+    std::vector<std::shared_ptr<AudioScheduledSourceNode>> m_finishedSourceScratch;
+
+    // Whole-quantum batches of expired voices awaiting the graph update
+    // thread. The batch is guarded by m_updateMutex; the reaping list is
+    // touched only by the graph update thread. Every voice in a batch shares
+    // one fade-out countdown and one unlink pass, so a burst of expiring SFX
+    // costs one graph operation rather than one per voice.
+    std::vector<std::shared_ptr<AudioScheduledSourceNode>> m_finishedSourceBatch;
+
+    struct FinishedSourceReap
+    {
+        std::vector<std::shared_ptr<AudioScheduledSourceNode>> nodes;
+        float duration = 0.1f;
+    };
+    std::vector<FinishedSourceReap> m_reapingSources;
+    std::atomic<int> m_reapingSourceBatches{0};
+
+    // Node references parked by reclaim(), destroyed by the graph update
+    // thread outside any lock once the render thread has passed the quantum
+    // boundary recorded at hand-over.
+    struct ReclaimRecord
+    {
+        std::shared_ptr<AudioNode> node;
+        uint64_t safeFrame = 0;
+    };
+    std::mutex m_reclaimMutex;
+    std::vector<ReclaimRecord> m_reclaimedNodes;
+
+    // Destroys eligible reclaimed nodes; force destroys everything, used
+    // during teardown when the sample clock no longer advances.
+    void drainReclaimedNodes(bool force);
+
     enum class ConnectionType : int
     {
         Disconnect = 0,
@@ -8,12 +8,19 @@
 #include "LabSound/core/AudioNode.h"
 #include "LabSound/core/AudioIOCallback.h"
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace lab {
 
 class AudioBus;
 class AudioContext;
+class AudioDestinationMirror;
 class AudioSourceProvider;
+class GraphRenderScheduler;
 class LocalAudioInputProvider;
 
 class AudioDestinationNode : public AudioNode, public AudioIOCallback 
@@ -32,29 +39,177 @@ public:
     
     // The audio hardware calls render() to get the next render quantum of audio into destinationBus.
     // It will optionally give us local/live audio input in sourceBus (if it's not 0).
+    // The graph itself always renders fixed ProcessingSizeInFrames quanta; when
+    // the device callback asks for any other size a FIFO adapter feeds it from
+    // whole quanta, at the cost of up to one quantum of extra latency.
     virtual void render(AudioBus * sourceBus, AudioBus * destinationBus, size_t numberOfFrames) override;
 
     uint64_t currentSampleFrame() const;
     double currentTime() const;
     double currentSampleTime() const; // extrapolated exact time
 
+    // The backend's stream clock and reported output latency in seconds. The
+    // base returns zero (offline rendering has no device);
+    // DefaultAudioDestinationNode forwards the platform destination's values.
+    virtual double deviceStreamTime() const { return 0; }
+    virtual double outputLatency() const { return 0; }
+
     virtual size_t numberOfChannels() const { return m_channelCount; }
 
     virtual void startRendering() = 0;
 
+    // Parks the device stream that startRendering() opened; the graph and
+    // its state survive and startRendering() brings the stream back. The
+    // base is a no-op (offline rendering has no device to park).
+    virtual void stopRendering() {}
+
+    // The default output device changed, or the OS changed its rate: ask the
+    // backend to reopen and adapt. The graph keeps rendering at its original
+    // sample rate — backends bridge any rate difference with a resampling
+    // stage at the device boundary — so rate-dependent state (wavetables,
+    // convolver partitions, the HRTF database) survives the switch. The base
+    // is a no-op.
+    virtual void handleDeviceChange() {}
+
+    // Seconds of uninterrupted silence the destination has rendered, verified
+    // against the output samples rather than inferred from the schedule; any
+    // non-silent quantum resets it to zero. Feeds the context's auto-idle.
+    double silentDuration() const;
+
     float sampleRate() const { return m_sampleRate; }
 
     AudioSourceProvider * localAudioInputProvider();
-    
+
+    // Frames between a live input sample entering the device callback and the
+    // rendered output containing it leaving, measured at the last quantum in
+    // which the graph tapped the input. One render quantum is the floor: the
+    // graph reads the driver's input buffer in place and the result ships in
+    // the same callback. Zero until the input has been tapped.
+    uint64_t inputToOutputLatencyFrames() const;
+
+    // When enabled (the default), independent subgraphs feeding this node are
+    // processed in parallel on a worker pool each render quantum.
+    void setParallelRenderingEnabled(bool enabled) { m_parallelRenderingEnabled = enabled; }
+    bool parallelRenderingEnabled() const { return m_parallelRenderingEnabled; }
+
+    // Optional lookahead rendering. With N > 0, each callback first renders
+    // only what the device buffer absolutely needs, then spends whatever
+    // remains of its deadline (the same budget the callback watchdog times)
+    // rendering up to N quanta ahead into the adapter ring. A transient
+    // over-budget quantum - a page fault, a scheduler preemption - then
+    // drains the surplus instead of glitching, at the cost of up to N quanta
+    // of added output latency. Live input is consumed as it arrives, so
+    // quanta rendered ahead of it see silence in its place. Zero (the
+    // default) keeps rendering strictly synchronous with the callback.
+    void setRenderLookahead(size_t quanta) { m_lookaheadQuanta.store(quanta, std::memory_order_relaxed); }
+    size_t renderLookahead() const { return m_lookaheadQuanta.load(std::memory_order_relaxed); }
+
+    // Every device callback is timed against its deadline - the buffer's
+    // duration at the device sample rate - and accumulated into lock-free
+    // counters so dropouts can be observed rather than reported by listeners.
+    // Load is callback duration as a fraction of the deadline; the histogram
+    // has one bucket per eighth of the deadline, the last catching >= 2x.
+    struct CallbackStats
+    {
+        static const int LoadHistogramSize = 16;
+
+        uint64_t callbacks = 0;             // device callbacks observed
+        uint64_t overruns = 0;              // callbacks that ran past their deadline
+        uint64_t lastMicroseconds = 0;      // duration of the most recent callback
+        uint64_t maxMicroseconds = 0;       // worst callback observed
+        double averageMicroseconds = 0;     // mean callback duration
+        int64_t lastMarginMicroseconds = 0; // deadline minus duration, most recent
+        int64_t minMarginMicroseconds = 0;  // tightest margin observed (negative = overrun)
+        uint64_t loadHistogram[LoadHistogramSize] = {};
+    };
+
+    // Snapshot of the accumulated counters. Written only by the callback
+    // thread; a snapshot taken mid-callback can straddle one update, which
+    // for telemetry purposes is harmless.
+    CallbackStats callbackStats() const;
+    void resetCallbackStats();
+
+    // Multi-device output. Attaches an additional hardware output that
+    // mirrors this destination's rendered audio - voice on headphones while
+    // the same graph feeds the speakers, say - fed from the same render pass
+    // through a lock-free ring and a drift-compensating resampler whose rate
+    // is servoed from the ring's fill level. The second device therefore
+    // costs a resample and a copy, not a second context. Device channels
+    // beyond the graph's receive silence. Returns an id for
+    // removeMirrorOutput(), or -1 if no further mirror can be attached.
+    // Meaningful only for realtime destinations; an offline render outruns
+    // any device.
+    int addMirrorOutput(size_t numberOfChannels, float sampleRate);
+    void removeMirrorOutput(int id);
+
+    // Invoked from the device callback when a callback's margin drops below
+    // the given fraction of the deadline (e.g. 0.25 fires when less than a
+    // quarter of the period remained). The handler runs on the callback
+    // thread and must not block or allocate; installing and clearing are
+    // safe while rendering. Pass nullptr to clear.
+    void setLowMarginCallback(float marginFraction, std::function<void(uint64_t durationMicroseconds, uint64_t deadlineMicroseconds)> handler);
+
 protected:
 
     virtual double tailTime(ContextRenderLock & r) const override { return 0; }
     virtual double latencyTime(ContextRenderLock & r) const override { return 0; }
 
+    // Advances the sample-frame clock and the verified-silence counter as if
+    // numberOfFrames of silence had been rendered, without running the graph.
+    // The offline destination uses this to fast-forward across spans it has
+    // proven silent.
+    void skipSilentFrames(size_t numberOfFrames);
+
     float m_sampleRate;
     AudioContext * m_context;
 
 private:
+    // The untimed device-buffer render; render() is the timing wrapper over it.
+    void renderDeviceBuffer(AudioBus * sourceBus, AudioBus * destinationBus, size_t numberOfFrames);
+
+    // Renders exactly one aligned graph quantum; renderDeviceBuffer() is the adapter over it.
+    void renderQuantum(AudioBus * sourceBus, AudioBus * destinationBus, size_t numberOfFrames);
+
+    // Accumulators behind callbackStats(). Only the callback thread writes,
+    // so relaxed atomics suffice for coherent reads elsewhere.
+    std::atomic<uint64_t> m_statCallbacks{0};
+    std::atomic<uint64_t> m_statOverruns{0};
+    std::atomic<uint64_t> m_statLastMicroseconds{0};
+    std::atomic<uint64_t> m_statMaxMicroseconds{0};
+    std::atomic<uint64_t> m_statSumMicroseconds{0};
+    std::atomic<int64_t> m_statLastMarginMicroseconds{0};
+    std::atomic<int64_t> m_statMinMarginMicroseconds{0};
+    std::atomic<uint64_t> m_statLoadHistogram[CallbackStats::LoadHistogramSize] = {};
+
+    std::atomic<float> m_lowMarginFraction{0.f};
+    std::shared_ptr<const std::function<void(uint64_t, uint64_t)>> m_lowMarginCallback;
+
+    // consecutive silent output frames, written only by the callback thread
+    std::atomic<uint64_t> m_consecutiveSilentFrames{0};
+
+    struct RenderFifo;
+
+    std::unique_ptr<GraphRenderScheduler> m_renderScheduler;
+    std::unique_ptr<RenderFifo> m_inputFifo;
+    std::unique_ptr<RenderFifo> m_outputFifo;
+    std::unique_ptr<AudioBus> m_adapterInputBus;
+    std::unique_ptr<AudioBus> m_adapterOutputBus;
+    bool m_parallelRenderingEnabled = true;
+    std::atomic<size_t> m_lookaheadQuanta{0};
+
+    // Mirror outputs (see addMirrorOutput). The callback thread works from
+    // m_renderMirrors, a cache refreshed with a try_lock so an attach or
+    // detach never blocks rendering; both vectors are reserved up front so
+    // the refresh doesn't allocate on the callback thread.
+    std::mutex m_mirrorMutex;
+    std::vector<std::pair<int, std::shared_ptr<AudioDestinationMirror>>> m_mirrors;
+    std::vector<std::shared_ptr<AudioDestinationMirror>> m_renderMirrors;
+    // Holds removed mirrors until the callback thread has refreshed its
+    // cache, so the final reference (and the device teardown it implies) is
+    // never released on the callback thread.
+    std::vector<std::shared_ptr<AudioDestinationMirror>> m_retiredMirrors;
+    std::atomic<bool> m_mirrorsDirty{false};
+    int m_nextMirrorId = 1;
 };
 
 } // namespace lab
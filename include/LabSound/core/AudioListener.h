@@ -6,6 +6,9 @@
 
 #include "LabSound/core/FloatPoint3D.h"
 #include "LabSound/core/AudioParam.h"
+
+#include <atomic>
+#include <cstdint>
 #include <memory>
 
 namespace lab 
@@ -64,6 +67,18 @@ namespace lab
         std::shared_ptr<AudioParam> upY() const { return m_upY; }
         std::shared_ptr<AudioParam> upZ() const { return m_upZ; }
 
+        // The listener's orthonormal basis, derived from the forward and up
+        // params. Every panner in the scene shares one listener, so the
+        // normalization and cross products are computed here once when the
+        // orientation changes rather than per source per render quantum.
+        struct Basis
+        {
+            FloatPoint3D front{ 0.f, 0.f, -1.f };
+            FloatPoint3D right{ 1.f, 0.f, 0.f };
+            FloatPoint3D up{ 0.f, 1.f, 0.f };
+        };
+        const Basis & basis(ContextRenderLock & r);
+
         // Velocity
         void setVelocity(float x, float y, float z) { setVelocity(FloatPoint3D(x, y, z)); }
         void setVelocity(const FloatPoint3D &velocity);
@@ -72,12 +87,57 @@ namespace lab
         std::shared_ptr<AudioParam> velocityZ() const { return m_velocityZ; }
 
         // Doppler factor
-        void setDopplerFactor(float dopplerFactor) { m_dopplerFactor->setValue(dopplerFactor); }
+        void setDopplerFactor(float dopplerFactor);
         std::shared_ptr<AudioParam> dopplerFactor() const { return m_dopplerFactor; }
 
         // Speed of sound
-        void setSpeedOfSound(float speedOfSound) { m_speedOfSound->setValue(speedOfSound); }
+        void setSpeedOfSound(float speedOfSound);
         std::shared_ptr<AudioParam> speedOfSound() const { return m_speedOfSound; }
+
+        // One coherent view of the listener pose. Every setter above
+        // republishes the whole block through a seqlock, and the render
+        // thread takes one consistent copy per quantum which every panner in
+        // the scene shares - so an application thread updating the listener
+        // mid-quantum can never hand one panner old coordinates and the next
+        // panner new ones, and neither thread ever blocks on the other. The
+        // setters are intended for a single application thread. The
+        // individual params remain readable but see each component
+        // independently; driving them directly bypasses the snapshot.
+        struct Snapshot
+        {
+            FloatPoint3D position{ 0.f, 0.f, 0.f };
+            FloatPoint3D forward{ 0.f, 0.f, -1.f };
+            FloatPoint3D up{ 0.f, 1.f, 0.f };
+            FloatPoint3D velocity{ 0.f, 0.f, 0.f };
+            float dopplerFactor = 1.f;
+            float speedOfSound = 343.f;
+        };
+
+        // The quantum's shared snapshot, taken from the seqlock once per
+        // render quantum and cached - one versioned copy per quantum instead
+        // of one shared cache line bouncing per panner read.
+        const Snapshot & snapshot(ContextRenderLock & r);
+
+    private:
+
+        // Republishes m_shadow through the seqlock; called by the setters.
+        void publish();
+
+        Basis m_basis;
+        FloatPoint3D m_basisForward{ 0.f, 0.f, 0.f };
+        FloatPoint3D m_basisUp{ 0.f, 0.f, 0.f };
+        bool m_basisValid = false;
+
+        // Writer side: the application thread's current state and the
+        // versioned block it publishes. An odd sequence means a write is in
+        // flight.
+        Snapshot m_shadow;
+        Snapshot m_published;
+        std::atomic<uint32_t> m_sequence{0};
+
+        // Render side: the quantum's cached copy.
+        Snapshot m_renderSnapshot;
+        uint64_t m_renderSnapshotFrame = ~0ull;
     };
 
 } // lab
@@ -9,6 +9,7 @@
 #define AudioNode_h
 
 #include "LabSound/core/Mixing.h"
+#include "LabSound/core/SmallVector.h"
 
 #include <algorithm>
 #include <atomic>
@@ -77,6 +78,11 @@ public:
     AudioNode();
     virtual ~AudioNode();
 
+    // A process-unique serial number, stable for the node's lifetime.
+    // Asynchronous event records refer to nodes by this id rather than by
+    // pointer so that a stale record can never dereference a dead node.
+    uint64_t id() const { return m_id; }
+
     // LabSound: If the node included ScheduledNode in its hierarchy, this will return true.
     // This is to save the cost of a dynamic_cast when scheduling nodes.
     virtual bool isScheduledNode() const { return false; }
@@ -109,6 +115,9 @@ public:
     // Called from context's audio thread.
     void processIfNecessary(ContextRenderLock& r, size_t framesToProcess);
 
+    // Returns true if processIfNecessary() has already run during the current render quantum.
+    bool processedThisQuantum(ContextRenderLock& r) const;
+
     // Called when a new connection has been made to one of our inputs or the connection number of channels has changed.
     // This potentially gives us enough information to perform a lazy initialization or, if necessary, a re-initialization.
     // Called from main thread.
@@ -126,7 +135,63 @@ public:
     // will take tailTime() and latencyTime() into account when determining whether the node will propagate silence.
     virtual bool propagatesSilence(ContextRenderLock & r) const;
 
-    bool inputsAreSilent(ContextRenderLock&);
+    // When the last audible input was observed, in context seconds; the
+    // timebase an overridden propagatesSilence() measures its tail against.
+    double lastNonSilentTime() const { return m_lastNonSilentTime; }
+
+    // canProcessInPlace() should return true if process() tolerates its input
+    // bus aliasing its output bus. For a node with the classic one-in/one-out
+    // shape, pullInputs() then suggests the output bus as the upstream render
+    // target; when the upstream fan-out is 1 the source renders straight into
+    // it and this node mutates the samples in place, eliminating one full
+    // buffer copy per node per quantum. The suggestion composes through
+    // linear chains of in-place nodes, so a per-voice effect stack renders
+    // into a single bus end to end. Aliasing only happens when the channel
+    // counts agree and the source isn't fanned out (see AudioNodeOutput::pull).
+    virtual bool canProcessInPlace() const { return false; }
+
+    // foldableGain() should return true (writing the scale) when the node's
+    // entire effect this quantum is a constant scale of its single input - a
+    // GainNode with a settled, un-automated gain. The summing junction that
+    // consumes such a node folds the scale into its own copy or accumulate
+    // kernel and never pulls the node, and the flattened schedule leaves it
+    // out entirely (see AudioNodeInput::pull and AudioContext::renderOrder),
+    // so simple gain stages vanish from the executed graph.
+    virtual bool foldableGain(ContextRenderLock & r, float * foldedGain) { return false; }
+
+    // A bypassed one-in/one-out node's kernel never runs: its input passes
+    // straight through to its output. The junction that consumes it skips it
+    // exactly like a settled gain fold (see AudioNodeInput::resolveFoldedGain)
+    // and the flattened schedule leaves it out, so a bypassed effect costs
+    // nothing at all; when the node is still pulled (fan-out, a param
+    // connection, a channel mismatch) its input bus is published as an output
+    // alias and no samples move either way. The flag takes effect at render
+    // quantum granularity, so an effect can be A/B'd live without
+    // disconnect/reconnect graph churn or a parallel dry path. Nodes with a
+    // different input/output shape ignore the flag.
+    void setBypassed(bool bypassed) { m_bypassed.store(bypassed, std::memory_order_relaxed); }
+    bool bypassed() const { return m_bypassed.load(std::memory_order_relaxed); }
+
+    // Control-rate execution. A node that only drives AudioParams — an LFO or
+    // envelope in a modulation matrix — rarely needs audio-rate resolution.
+    // Marking it control-rate makes it compute a single sample per render
+    // quantum (1/ProcessingSizeInFrames of the work); a param it drives
+    // linearly interpolates from the previous quantum's value to the new one,
+    // which degenerates to sample-and-hold for slowly moving signals. The
+    // interpolated signal trails the full-rate one by one render quantum,
+    // since there is no lookahead at the boundary.
+    // A control-rate node's outputs must feed only AudioParams or other
+    // control-rate nodes: frames past the first are stale. OscillatorNode and
+    // FunctionNode stretch their notion of time so frequencies and schedules
+    // stay correct at the reduced rate.
+    void setControlRate(bool enabled) { m_isControlRate = enabled; }
+    bool isControlRate() const { return m_isControlRate; }
+
+    // Virtual so a node that pulls something other than its own inputs
+    // (a fused chain tail pulls the chain head's) can report the silence
+    // of what it actually consumed.
+    virtual bool inputsAreSilent(ContextRenderLock&);
+    bool outputsAreSilent(ContextRenderLock&);
     void silenceOutputs(ContextRenderLock&);
     void unsilenceOutputs(ContextRenderLock&);
 
@@ -139,9 +204,58 @@ public:
     ChannelInterpretation channelInterpretation() const { return m_channelInterpretation; }
     void setChannelInterpretation(ChannelInterpretation interpretation) { m_channelInterpretation = interpretation; }
 
+    // Per-quantum processing cost, recorded by processIfNecessary() while the
+    // context's profiling flag is enabled. The counters are plain atomics so
+    // they can be read from any thread while rendering continues.
+    uint64_t profiledTotalMicroseconds() const { return m_profileTotalMicroseconds.load(std::memory_order_relaxed); }
+    uint64_t profiledMaxMicroseconds() const { return m_profileMaxMicroseconds.load(std::memory_order_relaxed); }
+    uint64_t profiledQuanta() const { return m_profileQuanta.load(std::memory_order_relaxed); }
+    void resetProfile();
+
+    // Heap allocations observed inside this node's process() by the render
+    // allocation detector. Always zero unless the library was built with
+    // LABSOUND_RENDER_ALLOC_DETECTOR and detection was enabled; a well-behaved
+    // node stays zero forever after warm-up.
+    uint64_t profiledAllocations() const { return m_profileAllocations.load(std::memory_order_relaxed); }
+    uint64_t profiledAllocationBytes() const { return m_profileAllocationBytes.load(std::memory_order_relaxed); }
+    void countRenderAllocation(size_t bytes)
+    {
+        m_profileAllocations.fetch_add(1, std::memory_order_relaxed);
+        m_profileAllocationBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    // Approximate resident bytes on the audio heap, broken down by subsystem
+    // so budget dashboards can chart audio memory by category. Sizes are read
+    // from existing counters - no sample data is touched - so aggregating a
+    // whole graph (AudioContext::queryMemory) is cheap enough to poll every
+    // frame.
+    struct MemoryUsage
+    {
+        size_t busBytes = 0;        // render busses and the context's bus pool
+        size_t sampleBytes = 0;     // loaded sample data and impulse responses
+        size_t convolverBytes = 0;  // reverb partitions and FFT workspaces
+        size_t delayBytes = 0;      // delay lines
+        size_t hrtfBytes = 0;       // the shared HRTF database
+        size_t otherBytes = 0;      // node-specific storage outside the categories above
+
+        size_t total() const { return busBytes + sampleBytes + convolverBytes + delayBytes + hrtfBytes + otherBytes; }
+    };
+
+    // Accumulates this node's resident bytes into usage. The base counts the
+    // output busses; nodes owning heavy storage (sample buffers, reverb
+    // partitions, delay lines) override, call the base, and add their own.
+    // A buffer shared between nodes is counted once per referencing node.
+    virtual void queryMemory(ContextRenderLock & r, MemoryUsage & usage) const;
+
     // returns a vector of parameter names
     std::vector<std::string> params() const;
 
+    // Indexed param access, for render-thread code that must traverse param
+    // driver connections (the parallel scheduler's reachability walk) without
+    // building name strings.
+    size_t numberOfParams() const { return m_params.size(); }
+    std::shared_ptr<AudioParam> param(size_t index) const { return index < m_params.size() ? m_params[index] : std::shared_ptr<AudioParam>(); }
+
     // returns a vector of setting names
     std::vector<std::string> settings() const;
 
@@ -171,10 +285,22 @@ private:
 
     friend class AudioContext;
 
+    uint64_t m_id{ 0 };
+
     volatile bool m_isInitialized{ false };
 
-    std::vector<std::shared_ptr<AudioNodeInput>> m_inputs;
-    std::vector<std::shared_ptr<AudioNodeOutput>> m_outputs;
+    bool m_isControlRate{ false };
+
+    std::atomic<bool> m_bypassed{ false };
+
+    // Runs the connect/disconnect fade ramps over the output busses; called by
+    // processIfNecessary() after the node rendered or passed its input through.
+    void applyScheduledFades(ContextRenderLock & r);
+
+    // Inline capacity covers the common one-input/one-output node without a
+    // heap block per list.
+    SmallVector<std::shared_ptr<AudioNodeInput>, 2> m_inputs;
+    SmallVector<std::shared_ptr<AudioNodeOutput>, 2> m_outputs;
 
     double m_lastProcessingTime{ -1.0 };
     double m_lastNonSilentTime{ -1.0 };
@@ -206,8 +332,21 @@ private:
     std::atomic<float> m_disconnectSchedule{ -1.f };
     std::atomic<float> m_connectSchedule{ 0.f };
 
+    void recordProcessTime(uint64_t microseconds);
+
+    std::atomic<uint64_t> m_profileTotalMicroseconds{ 0 };
+    std::atomic<uint64_t> m_profileMaxMicroseconds{ 0 };
+    std::atomic<uint64_t> m_profileQuanta{ 0 };
+    std::atomic<uint64_t> m_profileAllocations{ 0 };
+    std::atomic<uint64_t> m_profileAllocationBytes{ 0 };
+
 protected:
 
+    // The bypass flag latched once per quantum (and only when the node has the
+    // one-in/one-out shape), so pullInputs() and the passthrough in
+    // processIfNecessary() cannot see a mid-quantum toggle disagree.
+    bool m_bypassedThisQuantum{ false };
+
     std::vector<std::shared_ptr<AudioParam>> m_params;
     std::vector<std::shared_ptr<AudioSetting>> m_settings;
     size_t m_channelCount;
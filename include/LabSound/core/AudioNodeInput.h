@@ -5,6 +5,7 @@
 #ifndef AudioNodeInput_h
 #define AudioNodeInput_h
 
+#include "LabSound/core/AudioBus.h"
 #include "LabSound/core/AudioNode.h"
 #include "LabSound/core/AudioSummingJunction.h"
 
@@ -14,7 +15,6 @@ namespace lab {
 
 class AudioNode;
 class AudioNodeOutput;
-class AudioBus;
 
 // An AudioNodeInput represents an input to an AudioNode and can be connected from one or more AudioNodeOutputs.
 // In the case of multiple connections, the input will act as a unity-gain summing junction, mixing all the outputs.
@@ -55,9 +55,24 @@ public:
     
 private:
 
+    // When the source feeding a connection is a chain of foldable gain
+    // stages (see AudioNode::foldableGain), returns the output at the head
+    // of the chain and accumulates the combined scale into *foldedGain;
+    // otherwise returns the connection's own output. Folded nodes are never
+    // pulled - pull() applies the scale itself as part of its copy or
+    // accumulate pass.
+    AudioNodeOutput * resolveFoldedGain(ContextRenderLock &, AudioNodeOutput *, float * foldedGain);
+
     AudioNode * m_node;
 
     std::unique_ptr<AudioBus> m_internalSummingBus;
+
+    // Summing kernels specialized per source channel count into the current
+    // summing bus topology, re-selected in updateInternalBus() when the
+    // input's channel count settles; pull() indexes by the connection's
+    // channel count and calls through without any per-quantum mixing
+    // dispatch. Index 0 is unused.
+    AudioBus::MixFunction m_sumFunctions[AudioBus::ChannelMixMatrix::MaxMixChannels + 1];
 };
 
 } // namespace lab
@@ -7,6 +7,7 @@
 
 #include "LabSound/core/AudioNode.h"
 #include "LabSound/core/AudioParam.h"
+#include "LabSound/core/SmallVector.h"
 
 #include <set>
 
@@ -49,11 +50,41 @@ public:
     size_t numberOfChannels() const { return m_numberOfChannels; }
     bool isChannelCountKnown() const { return numberOfChannels() > 0; }
 
+    // Bytes of sample storage owned by the internal bus (an alias bus, when
+    // one is published, references its source's memory and adds nothing).
+    size_t memoryBytes() const;
+
     bool isConnected() { return fanOutCount() > 0 || paramFanOutCount() > 0; }
     
     // updateRenderingState() is called in the audio thread at the start or end of the render quantum to handle any recent changes to the graph state.
     void updateRenderingState(ContextRenderLock&);
 
+    // When a node is processed directly (flattened render order or the parallel
+    // scheduler) rather than via pull(), no downstream consumer has supplied an
+    // in-place bus; any in-place target left over from a previous quantum must be
+    // forgotten first so process() renders into the internal bus.
+    void clearInPlaceBus() { m_inPlaceBus = nullptr; }
+
+    // A routing node (ChannelSplitterNode, ChannelMergerNode) can publish a
+    // node-owned bus of channel views into its source's data instead of
+    // copying samples every quantum. While an alias is published, bus()
+    // returns it in place of the internal bus. The alias is only valid for
+    // the render quantum in which it was set; the publishing node re-points
+    // or clears it every time it processes.
+    void setAliasBus(AudioBus * bus) { m_aliasBus = bus; }
+    void clearAliasBus() { m_aliasBus = nullptr; }
+
+    // True when a downstream consumer supplied an in-place bus for the
+    // current quantum. A routing node must then write samples into bus()
+    // rather than publish an alias, because the consumer owns that memory.
+    bool isRenderingInPlace() const { return m_inPlaceBus != nullptr; }
+
+    // Must be called before mutating bus() in place (fade ramps, zeroing).
+    // If an alias is published its samples are copied into the internal bus,
+    // which becomes the published bus again; scaling or zeroing an alias
+    // would corrupt the source node's data for its other consumers.
+    AudioBus * materializeAliasBus(ContextRenderLock &);
+
     // Must be called within the context's graph lock.
     static void disconnectAll(ContextGraphLock &, std::shared_ptr<AudioNodeOutput>);
     static void disconnectAllInputs(ContextGraphLock&, std::shared_ptr<AudioNodeOutput>);
@@ -101,8 +132,12 @@ private:
     // Temporary, during render quantum
     // @tofix - Should this be some kind of shared pointer? It is only valid for a single render quantum, so probably no.
     AudioBus* m_inPlaceBus;
-    
-    std::vector<std::shared_ptr<AudioNodeInput>> m_inputs;
+
+    // Temporary, during render quantum: a node-owned bus of views into
+    // another node's channel data, published via setAliasBus().
+    AudioBus* m_aliasBus;
+
+    SmallVector<std::shared_ptr<AudioNodeInput>, 2> m_inputs;
     
 private:    
     // For the purposes of rendering, keeps track of the number of inputs and AudioParams we're connected to.
@@ -110,8 +145,8 @@ private:
     size_t m_renderingFanOutCount;
     size_t m_renderingParamFanOutCount;
 
-    std::set<std::shared_ptr<AudioParam>> m_params;
-    typedef std::set<AudioParam*>::iterator ParamsIterator;
+    // Few params ever drive one output; membership checks are a linear scan.
+    SmallVector<std::shared_ptr<AudioParam>, 2> m_params;
 };
 
 } // namespace lab
@@ -56,6 +56,10 @@ public:
 
     // Parameter automation.    
     void setValueAtTime(float value, float time) { m_timeline.setValueAtTime(value, time); }
+
+    // Non-blocking variant used by the render-thread command queue; returns
+    // false if the timeline lock was contended so the command can retry.
+    bool trySetValueAtTime(float value, float time) { return m_timeline.trySetValueAtTime(value, time); }
     void linearRampToValueAtTime(float value, float time) { m_timeline.linearRampToValueAtTime(value, time); }
     void exponentialRampToValueAtTime(float value, float time) { m_timeline.exponentialRampToValueAtTime(value, time); }
     void setTargetAtTime(float target, float time, float timeConstant) { m_timeline.setTargetAtTime(target, time, timeConstant); }
@@ -90,7 +94,12 @@ private:
     double m_smoothingConstant;
     
     AudioParamTimeline m_timeline;
-    
+
+    // Value held over from the previous quantum's control-rate drivers, for
+    // linear upsampling at the boundary (see AudioNode::setControlRate).
+    double m_controlRateHold = 0;
+    bool m_controlRateHoldValid = false;
+
     struct Data;
     std::unique_ptr<Data> m_data;
 };
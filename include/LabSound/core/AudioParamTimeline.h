@@ -6,6 +6,8 @@
 #define AudioParamTimeline_h
 
 #include "LabSound/core/AudioContext.h"
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -19,6 +21,11 @@ public:
     AudioParamTimeline() { }
 
     void setValueAtTime(float value, float time);
+
+    // Non-blocking setValueAtTime for the render thread's command queue:
+    // returns false without inserting when the mutation lock is contended,
+    // so the caller can retry next quantum instead of blocking the render.
+    bool trySetValueAtTime(float value, float time);
     void linearRampToValueAtTime(float value, float time);
     void exponentialRampToValueAtTime(float value, float time);
     void setTargetAtTime(float target, float time, float timeConstant);
@@ -37,7 +44,11 @@ public:
     float valuesForTimeRange(double startTime, double endTime, float defaultValue, 
                              float* values, size_t numberOfValues, double sampleRate, double controlRate);
 
-    bool hasValues() { return m_events.size() > 0; }
+    bool hasValues()
+    {
+        auto events = std::atomic_load(&m_renderEvents);
+        return events && events->size() > 0;
+    }
 
 private:
 
@@ -95,6 +106,7 @@ private:
         float timeConstant() const { return m_timeConstant; }
         float duration() const { return m_duration; }
         std::vector<float> & curve() { return m_curve; }
+        const std::vector<float> & curve() const { return m_curve; }
 
     private:
         unsigned m_type;
@@ -106,10 +118,34 @@ private:
     };
 
     void insertEvent(const ParamEvent&);
-    float valuesForTimeRangeImpl(double startTime, double endTime, float defaultValue, 
+    void insertEventLocked(const ParamEvent&);
+    float valuesForTimeRangeImpl(double startTime, double endTime, float defaultValue,
                                  float* values, size_t numberOfValues, double sampleRate, double controlRate);
+    void pruneExpiredEventsLocked();
 
+    // m_events is the master copy, only touched under the mutation lock on the
+    // main/graph thread. Every mutation publishes a fresh immutable snapshot to
+    // m_renderEvents, which the render thread reads via std::atomic_load without
+    // taking any lock (the previous tryLock could fail under mutation pressure
+    // and silently output the default value for a whole quantum).
     std::vector<ParamEvent> m_events;
+    std::shared_ptr<const std::vector<ParamEvent>> m_renderEvents;
+
+    // Render-thread cursor over the current snapshot. Render time advances
+    // monotonically quantum to quantum, so the segment index found last call
+    // is cached and nudged forward instead of re-searched, O(1) in steady
+    // state however deep the schedule runs; a new snapshot or a backwards
+    // seek falls back to the binary search. Touched only on the render thread.
+    std::shared_ptr<const std::vector<ParamEvent>> m_cursorSnapshot;
+    int m_cursorEvent = 0;
+    double m_cursorTime = 0;
+
+    // Start time of the segment the render cursor last landed on. The search
+    // and the cursor never land before it again, so events wholly behind it
+    // are unreadable; mutations prune them once the list grows (see
+    // pruneExpiredEventsLocked). Written by the render thread, read under
+    // the mutation lock.
+    std::atomic<double> m_firstLiveTime{0};
 };
 
 } // namespace lab
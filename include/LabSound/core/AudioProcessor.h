@@ -45,6 +45,9 @@ public:
     virtual double tailTime(ContextRenderLock & r) const = 0;
     virtual double latencyTime(ContextRenderLock & r) const = 0;
 
+    // Bytes of DSP state the processor owns; see AudioNode::queryMemory().
+    virtual size_t memoryBytes() const { return 0; }
+
 protected:
     bool m_initialized = false;
     size_t m_numberOfChannels;
@@ -37,6 +37,11 @@ public:
 
     double startTime() const { return m_startTime; }
 
+    // The start time the render thread will observe next: the pending start
+    // when start() has been called but not yet latched under the render lock,
+    // otherwise the latched start time.
+    double effectiveStartTime() const;
+
     unsigned short playbackState() const { return static_cast<unsigned short>(m_playbackState); }
 
     bool isPlayingOrScheduled() const { return m_playbackState == PLAYING_STATE || m_playbackState == SCHEDULED_STATE; }
@@ -49,7 +54,10 @@ public:
     // This is to save the cost of a dynamic_cast when scheduling nodes.
     virtual bool isScheduledNode() const override { return true; }
 
-    void setOnEnded(std::function<void()> fn) { m_onEnded = fn; }
+    // The handler is held behind a shared_ptr so that finish() can hand it to
+    // the context's event queue from the render thread without copying the
+    // std::function itself (which may heap-allocate). Called from main thread.
+    void setOnEnded(std::function<void()> fn) { m_onEnded = std::make_shared<std::function<void()>>(std::move(fn)); }
 
 protected:
 
@@ -91,7 +99,7 @@ protected:
     double m_pendingEndTime;
     double m_endTime; // in seconds
 
-    std::function<void()> m_onEnded;
+    std::shared_ptr<std::function<void()>> m_onEnded;
 };
 
 } // namespace lab
@@ -5,7 +5,8 @@
 #ifndef AudioSummingJunction_h
 #define AudioSummingJunction_h
 
-#include <vector>
+#include "LabSound/core/SmallVector.h"
+
 #include <memory>
 
 namespace lab {
@@ -35,12 +36,14 @@ public:
     size_t numberOfConnections() const { return m_connectedOutputs.size(); }
     
     // Rendering code accesses its version of the current connections here.
+    // The returned pointer is plain: the snapshot below pins each output, so
+    // no per-quantum refcounting takes place on the render thread.
     size_t numberOfRenderingConnections(ContextRenderLock&) const;
-    std::shared_ptr<AudioNodeOutput> renderingOutput(ContextRenderLock&, size_t i) {
-        return i < m_renderingOutputs.size() ? m_renderingOutputs[i].lock() : nullptr; }
-    
-    const std::shared_ptr<AudioNodeOutput> renderingOutput(ContextRenderLock&, size_t i) const {
-        return i < m_renderingOutputs.size() ? m_renderingOutputs[i].lock() : nullptr; }
+    AudioNodeOutput* renderingOutput(ContextRenderLock&, size_t i) {
+        return i < m_renderingOutputs.size() ? m_renderingOutputs[i].get() : nullptr; }
+
+    const AudioNodeOutput* renderingOutput(ContextRenderLock&, size_t i) const {
+        return i < m_renderingOutputs.size() ? m_renderingOutputs[i].get() : nullptr; }
     
     bool isConnected() const { return numberOfConnections() > 0; }
 
@@ -50,7 +53,13 @@ public:
     void junctionDisconnectOutput(std::shared_ptr<AudioNodeOutput>);
 	void junctionDisconnectAllOutputs();
     void setDirty() { m_renderingStateNeedUpdating = true; }
-    
+
+    // Marks the junction dirty and deposits it on the dirty queue, so the
+    // render thread refreshes it in the batched pass at the next quantum
+    // boundary instead of mid-pull. The dirty flag remains the fallback if
+    // the queue is full.
+    static void enqueueDirty(std::shared_ptr<AudioSummingJunction>);
+
     static void handleDirtyAudioSummingJunctions(ContextRenderLock& r);
 
     bool isConnected(std::shared_ptr<AudioNodeOutput> o) const;
@@ -59,16 +68,23 @@ protected:
     
     // m_outputs contains the AudioNodeOutputs representing current connections.
     // The rendering code should never use this directly, but instead uses m_renderingOutputs.
-    std::vector<std::weak_ptr<AudioNodeOutput>> m_connectedOutputs;
+    SmallVector<std::weak_ptr<AudioNodeOutput>, 2> m_connectedOutputs;
 
-    // m_renderingOutputs is a copy of m_connectedOutputs which will never be modified during the graph rendering on the audio thread.
+    // m_renderingOutputs is a snapshot of m_connectedOutputs which will never be modified during the graph rendering on the audio thread.
     // This is the list which is used by the rendering code.
     // Whenever m_outputs is modified, the context is told so it can later update m_renderingOutputs from m_outputs at a safe time.
-    // Most of the time, m_renderingOutputs is identical to m_outputs.
-    std::vector<std::weak_ptr<AudioNodeOutput>> m_renderingOutputs;
+    // The snapshot holds strong references, taken once when it is rebuilt, so the
+    // render path walks plain pointers with no weak_ptr locking; an output
+    // disconnected on a control thread stays alive until the render thread
+    // rebuilds the snapshot at the next quantum boundary.
+    SmallVector<std::shared_ptr<AudioNodeOutput>, 2> m_renderingOutputs;
 
     // m_renderingStateNeedUpdating indicates outputs were changed
     bool m_renderingStateNeedUpdating;
+
+    // Hash of the live connection set behind the current snapshot; a dirty
+    // junction whose connections turn out unchanged skips the rebuild.
+    uint64_t m_renderingOutputsHash = 0;
 };
 
 } // namespace lab
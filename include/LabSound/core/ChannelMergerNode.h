@@ -9,6 +9,7 @@
 
 namespace lab {
 
+class AudioBus;
 class AudioContext;
 
 class ChannelMergerNode : public AudioNode
@@ -16,7 +17,7 @@ class ChannelMergerNode : public AudioNode
 public:
 
     ChannelMergerNode(size_t numberOfInputs = 1);
-    virtual ~ChannelMergerNode() {}
+    virtual ~ChannelMergerNode();
 
     void addInputs(size_t n);
 
@@ -33,6 +34,11 @@ private:
     virtual double latencyTime(ContextRenderLock & r) const override { return 0; }
 
     size_t m_desiredNumberOfOutputChannels = 1; // default
+
+    // A bus of channel views into the connected inputs' data, re-pointed each
+    // quantum so merging is pointer wiring rather than a per-channel copy.
+    // Recreated when the output channel count changes; owns no sample storage.
+    std::unique_ptr<AudioBus> m_viewBus;
 };
 
 } // namespace lab
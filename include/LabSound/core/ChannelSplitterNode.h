@@ -10,6 +10,7 @@
 namespace lab
 {
 
+class AudioBus;
 class AudioContext;
 
 class ChannelSplitterNode : public AudioNode
@@ -18,7 +19,7 @@ class ChannelSplitterNode : public AudioNode
 public:
 
     ChannelSplitterNode(size_t numberOfOutputs = 1);
-    virtual ~ChannelSplitterNode() {}
+    virtual ~ChannelSplitterNode();
 
     void addOutputs(size_t numberOfOutputs);
 
@@ -31,6 +32,10 @@ private:
     virtual double tailTime(ContextRenderLock & r) const override { return 0; }
     virtual double latencyTime(ContextRenderLock & r) const override { return 0; }
 
+    // One single-channel view bus per output, re-pointed at the source bus's
+    // channel data each quantum so splitting is pointer wiring rather than a
+    // per-channel copy. The views own no sample storage.
+    std::vector<std::unique_ptr<AudioBus>> m_viewBusses;
 };
 
 } // namespace lab
@@ -9,4 +9,18 @@
 #define LABSOUND_DEFAULT_SAMPLERATE 44100.0f
 #define LABSOUND_DEFAULT_CHANNELS (uint32_t) lab::Channels::Stereo
 
+namespace lab
+{
+    // Sample-rate conversion quality tiers, consulted wherever the engine
+    // resamples (see AudioContext::ResamplerQualityPolicy). Sinc-based paths
+    // map the tiers to kernel sizes; SampledAudioNode's per-voice pitch
+    // interpolation maps Linear to linear and the sinc tiers to cubic.
+    enum class ResamplerQuality
+    {
+        Linear = 0,  // cheapest: linear interpolation / a 4-tap kernel
+        SmallSinc,   // 8-tap sinc: streaming grade
+        FullSinc,    // 32-tap sinc: asset-bake / mastering grade
+    };
+}
+
 #endif
@@ -6,8 +6,11 @@
 #define ConvolverNode_h
 
 #include "LabSound/core/AudioNode.h"
+#include "LabSound/core/Constants.h"
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 
 namespace lab {
 
@@ -33,13 +36,29 @@ public:
 
     // Impulse responses
     // setImpulse takes an audio bus as a source of a buffer to create an audio
-    // bus from, but the bus and its data is not retained
+    // bus from, but the bus and its data is not retained.
+    // The prepare pipeline - resampling to the context rate, the
+    // normalization scan, and the FFT of every partition - runs on a worker
+    // thread; the previous reverb keeps rendering until the replacement is
+    // ready, at which point it is swapped in on the render thread. A newer
+    // setImpulse supersedes any preparation still in flight.
     void setImpulse(std::shared_ptr<AudioBus> bus);
     std::shared_ptr<AudioBus> getImpulse();
 
     bool normalize() const;
     void setNormalize(bool normalize);
 
+    // Tail truncation threshold, a linear amplitude. Convolver stages whose
+    // bounded contribution falls below it are gated off until the input grows
+    // loud enough to need them again; 0 (the default) disables the bound.
+    // -60 dBFS (0.001) is a reasonable starting point for long tails buried
+    // under a mix. Stages past what silent input can still excite are always
+    // gated, which is output-exact.
+    float tailTruncationThreshold() const;
+    void setTailTruncationThreshold(float threshold);
+
+    virtual void queryMemory(ContextRenderLock & r, MemoryUsage & usage) const override;
+
 private:
 
     virtual double tailTime(ContextRenderLock & r) const override;
@@ -48,6 +67,10 @@ private:
     std::unique_ptr<Reverb> m_reverb;
     std::shared_ptr<AudioBus> m_bus;
 
+    // Frames of reverb tail left to ring out after the input went silent;
+    // when it reaches zero, process() skips the convolution engine entirely.
+    int64_t m_tailFramesRemaining{ 0 };
+
     // lock free swap on update
     bool m_swapOnRender;
     std::unique_ptr<Reverb> m_newReverb;
@@ -55,6 +78,34 @@ private:
 
     // Normalize the impulse response or not. Must default to true.
     std::shared_ptr<AudioSetting> m_normalize;
+
+    // See tailTruncationThreshold().
+    std::shared_ptr<AudioSetting> m_tailThreshold;
+
+    // Asynchronous impulse preparation (see setImpulse). The worker task
+    // shares this state through its own shared_ptr, so a prepare still in
+    // flight survives the node's destruction; epoch invalidates superseded
+    // prepares and ready marks a result awaiting pickup by process().
+    struct ImpulsePrepareState
+    {
+        ~ImpulsePrepareState();
+        std::mutex mutex;
+        std::unique_ptr<Reverb> reverb;
+        std::shared_ptr<AudioBus> bus;
+        std::atomic<uint64_t> epoch{0};
+        std::atomic<bool> ready{false};
+    };
+    std::shared_ptr<ImpulsePrepareState> m_prepare;
+
+    // Context sample rate observed on the render thread, so the prepare task
+    // knows what rate to resample a mismatched response to. Zero until the
+    // node has rendered, in which case resampling is skipped.
+    std::atomic<float> m_lastKnownSampleRate{0.f};
+
+    // The context's asset-preparation resampler tier, observed alongside the
+    // sample rate; impulse responses are converted offline so they default to
+    // the full-quality kernel.
+    std::atomic<ResamplerQuality> m_lastKnownResampleQuality{ResamplerQuality::FullSinc};
 };
 
 } // namespace lab
@@ -12,23 +12,35 @@ namespace lab {
 class AudioContext;
 struct AudioDestination;
     
-class DefaultAudioDestinationNode final : public AudioDestinationNode 
+class DefaultAudioDestinationNode final : public AudioDestinationNode
 {
     std::unique_ptr<AudioDestination> m_destination;
+    bool m_useSharedDevice{ false };
 
     void createDestination();
-    
+
 public:
 
-    DefaultAudioDestinationNode(AudioContext* context, size_t channelCount, const float sampleRate);
+    // When useSharedDevice is true, this destination does not open its own
+    // hardware stream; all shared-device destinations with the same channel
+    // count and sample rate render inside a single platform callback and are
+    // mixed there. This keeps independently-tuned contexts (game, voice, UI)
+    // on one stream with deterministic alignment instead of paying for a
+    // device stream apiece.
+    DefaultAudioDestinationNode(AudioContext* context, size_t channelCount, const float sampleRate, bool useSharedDevice = false);
     virtual ~DefaultAudioDestinationNode();
     
     virtual void initialize() override;
     virtual void uninitialize() override;
     virtual void startRendering() override;
+    virtual void stopRendering() override;
     
     unsigned maxChannelCount() const;
     virtual void setChannelCount(ContextGraphLock &, size_t) override;
+
+    virtual double deviceStreamTime() const override;
+    virtual double outputLatency() const override;
+    virtual void handleDeviceChange() override;
 };
 
 } // namespace lab
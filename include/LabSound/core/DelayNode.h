@@ -40,6 +40,16 @@ public:
     // default maximum delay of 100ms
     DelayNode(float sampleRate = LABSOUND_DEFAULT_SAMPLERATE, double maxDelayTime = 0.1);
     std::shared_ptr<AudioParam> delayTime();
+
+    // When enabled, a change to delayTime crossfades from the old read
+    // position to the new one over a short window inside the already
+    // allocated ring - no reallocation, no pitch glide. Off by default to
+    // preserve WebAudio's smoothed-glide semantics; tempo-synced subclasses
+    // (BPMDelay) turn it on.
+    void setCrossfadeOnDelayChange(bool enabled);
+    bool crossfadeOnDelayChange();
+
+    virtual void queryMemory(ContextRenderLock & r, MemoryUsage & usage) const override;
 };
 
 } // namespace lab
@@ -31,6 +31,16 @@ public:
     virtual void process(ContextRenderLock&, size_t framesToProcess) override;
     virtual void reset(ContextRenderLock&) override;
 
+    // Both gain kernels are index-aligned scales, so the input bus may alias
+    // the output bus; a settled unity gain then passes through with no copy
+    // at all (see AudioBus::copyWithGainFrom).
+    virtual bool canProcessInPlace() const override { return true; }
+
+    // A settled, un-automated gain over a single matching-channel source is
+    // just a constant scale; report it so the downstream junction can fold
+    // this node out of the executed schedule.
+    virtual bool foldableGain(ContextRenderLock & r, float * foldedGain) override;
+
     // Called in the main thread when the number of channels for the input may have changed.
     virtual void checkNumberOfChannelsForInput(ContextRenderLock&, AudioNodeInput*) override;
 
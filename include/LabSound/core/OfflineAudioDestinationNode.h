@@ -7,32 +7,60 @@
 
 #include "LabSound/core/AudioDestinationNode.h"
 
+#include <functional>
+#include <string>
+
 namespace lab {
 
 class AudioBus;
 class AudioContext;
+class StreamingWavWriter;
 
 class OfflineAudioDestinationNode final : public AudioDestinationNode
 {
-    
+
 public:
-    
+
     OfflineAudioDestinationNode(AudioContext* context, const float sampleRate, const float lengthSeconds, const uint32_t numChannels);
     virtual ~OfflineAudioDestinationNode();
-    
+
     virtual void initialize() override;
     virtual void uninitialize() override;
 
     virtual void startRendering() override;
-    
+
+    // Invoked on the render thread after each completed quantum with the
+    // rendered bus, whose contents are only valid for the duration of the
+    // call. Streaming consumers keep memory flat regardless of render
+    // length; the consumer must not mutate the graph. Set before
+    // startRendering().
+    void setRenderQuantumConsumer(std::function<void(const AudioBus &)> consumer);
+
+    // Streams the bake to a 32 bit float WAV as it renders, on a background
+    // writer thread (the same machinery RecorderNode records through), so
+    // disk I/O overlaps rendering and memory stays flat regardless of
+    // length. Call before startRendering(); the file is finalized before
+    // the offline-render-complete callback fires. Returns false when the
+    // file cannot be created.
+    bool renderToWavFile(const std::string & path);
+
 private:
-  
+
     std::unique_ptr<AudioBus> m_renderBus;
     std::thread m_renderThread;
     void offlineRender();
+
+    // Number of frames (a multiple of the render quantum) that may be skipped
+    // without rendering because the graph is provably silent up to there;
+    // zero means render normally. See the fast-forward notes in offlineRender().
+    size_t provenSilentFrames(ContextRenderLock & r, size_t maxFrames);
     bool m_startedRendering{ false };
     uint32_t m_numChannels;
     float m_lengthSeconds;
+
+    std::function<void(const AudioBus &)> m_quantumConsumer;
+    std::unique_ptr<StreamingWavWriter> m_wavWriter;
+    std::vector<float> m_interleaveScratch;
 };
 
 } // namespace lab
@@ -34,6 +34,15 @@ public:
     OscillatorType type() const;
     void setType(OscillatorType type);
 
+    // Builds a custom periodic wave from Fourier coefficients (real and imag
+    // must be the same nonzero length). The band-limited mipmap is computed
+    // off-thread on the shared worker pool: the oscillator keeps playing its
+    // current table and swaps the new bank in on the render thread once the
+    // build finishes, so preset changes never hitch the calling thread.
+    // Identical spectra are deduplicated process-wide, so switching many
+    // oscillators to one preset builds its tables exactly once.
+    void setPeriodicWave(const std::vector<float> & real, const std::vector<float> & imag);
+
     std::shared_ptr<AudioParam> frequency() { return m_frequency; }
     std::shared_ptr<AudioParam> detune() { return m_detune; }
 
@@ -71,11 +80,9 @@ private:
 
     std::shared_ptr<WaveTable> m_waveTable;
 
-    // Cache the wave tables for different waveform types, except CUSTOM.
-    static std::shared_ptr<WaveTable> s_waveTableSine;
-    static std::shared_ptr<WaveTable> s_waveTableSquare;
-    static std::shared_ptr<WaveTable> s_waveTableSawtooth;
-    static std::shared_ptr<WaveTable> s_waveTableTriangle;
+    // An off-thread custom table build awaiting adoption; process() polls it
+    // and swaps the finished bank into m_waveTable on the render thread.
+    std::shared_ptr<WaveTable::CustomBuild> m_pendingWaveTable;
 };
 
 } // namespace lab
@@ -52,6 +52,7 @@ class PannerNode : public AudioNode
     std::shared_ptr<AudioSetting> m_coneInnerAngle;
     std::shared_ptr<AudioSetting> m_coneOuterAngle;
     std::shared_ptr<AudioSetting> m_panningModel;
+    std::shared_ptr<AudioSetting> m_fastSpatialMath;
 
 
 public:
@@ -124,6 +125,43 @@ public:
     float coneOuterGain() const;
     void setConeOuterGain(float angle);
 
+    // Sources farther than this from the listener output silence without
+    // running the panner at all. Zero (the default) disables culling.
+    float cullDistance() const { return m_cullDistance; }
+    void setCullDistance(float distance) { m_cullDistance = distance; }
+
+    // Distance-based processing level of detail, layered under cullDistance.
+    // A scene with hundreds of emitters only needs full-quality rendering for
+    // the handful near the listener; these bands make the rest cheap without
+    // per-title plumbing.
+
+    // Beyond this distance an HRTF panner renders through the equal-power
+    // panner instead; the HRTF panner and its state are kept for when the
+    // source comes back. The band has ~10% hysteresis so a source hovering
+    // at the boundary does not flap between models. Zero (the default)
+    // disables the fallback. Has no effect on equal-power panners.
+    float hrtfLodDistance() const { return m_hrtfLodDistance; }
+    void setHrtfLodDistance(float distance) { m_hrtfLodDistance = distance; }
+
+    // Beyond this distance the azimuth/elevation and distance/cone gains of
+    // a moving source refresh only every intervalQuanta render quanta -
+    // control rate - instead of on every movement. Zero distance (the
+    // default) disables the band.
+    float controlRateLodDistance() const { return m_controlRateLodDistance; }
+    void setControlRateLod(float distance, uint32_t intervalQuanta = 8);
+
+    // While beyond cullDistance, the position recheck itself runs only every
+    // intervalQuanta quanta; in between the node emits silence without
+    // reading a single parameter. The default of 1 rechecks every quantum.
+    void setCullWakeInterval(uint32_t intervalQuanta);
+
+    // When enabled, azimuth and elevation are computed with a polynomial
+    // arccosine approximation whose maximum error is about 0.004 degrees,
+    // instead of libm trig. Worth switching on when hundreds of sources
+    // move every frame; off by default.
+    void setFastSpatialMath(bool enable);
+    bool fastSpatialMath() const;
+
     void getAzimuthElevation(ContextRenderLock & r, double * outAzimuth, double * outElevation);
     float dopplerRate(ContextRenderLock & r);
 
@@ -134,6 +172,8 @@ public:
     virtual double tailTime(ContextRenderLock & r) const override;
     virtual double latencyTime(ContextRenderLock & r) const override;
 
+    virtual void queryMemory(ContextRenderLock & r, MemoryUsage & usage) const override;
+
 protected:
 
     std::shared_ptr<HRTFDatabaseLoader> m_hrtfDatabaseLoader;
@@ -152,6 +192,31 @@ protected:
 
     float m_lastGain = -1.0f;
     float m_sampleRate;
+
+    float m_cullDistance = 0.f;
+
+    // Distance LOD state (see the setters above).
+    float m_hrtfLodDistance = 0.f;
+    float m_controlRateLodDistance = 0.f;
+    uint32_t m_controlRateInterval = 8;
+    uint32_t m_cullWakeInterval = 1;
+    uint32_t m_cullSleepRemaining = 0;
+    uint32_t m_controlRateCountdown = 0;
+    bool m_hrtfLodActive = false;
+    std::unique_ptr<Panner> m_lodPanner;  // lazily built equal-power fallback
+
+    // Azimuth/elevation trig and distance/cone gains are recomputed only when
+    // the source or listener has moved by more than a small epsilon since the
+    // values were last cached; stationary emitters reuse the cached results.
+    bool m_spatialCacheValid = false;
+    FloatPoint3D m_cachedPosition;
+    FloatPoint3D m_cachedOrientation;
+    FloatPoint3D m_cachedListenerPosition;
+    FloatPoint3D m_cachedListenerFront;
+    FloatPoint3D m_cachedListenerUp;
+    double m_cachedAzimuth = 0;
+    double m_cachedElevation = 0;
+    float m_cachedTotalGain = 1.f;
 };
 
 } // namespace lab
@@ -9,22 +9,39 @@
 #include "LabSound/core/AudioScheduledSourceNode.h"
 #include "LabSound/core/PannerNode.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <thread>
+#include <vector>
 
 namespace lab {
 
 class AudioContext;
 class AudioBus;
+class AudioFileStream;
 
 // This should  be used for short sounds which require a high degree of scheduling flexibility (can playback in rhythmically perfect ways).
 //
 // params: gain, playbackRate
-// settings: loop
+// settings: loop, interpolation
 //
 class SampledAudioNode final : public AudioScheduledSourceNode
 {
 public:
 
+    enum InterpolationMode
+    {
+        LINEAR_INTERPOLATION = 0,
+        CUBIC_INTERPOLATION = 1,
+    };
+
+    enum StorageFormat
+    {
+        STORAGE_FLOAT32 = 0,
+        STORAGE_INT16 = 1,
+    };
+
     SampledAudioNode();
     virtual ~SampledAudioNode();
 
@@ -35,6 +52,28 @@ public:
     bool setBus(ContextRenderLock &, std::shared_ptr<AudioBus> sourceBus);
     std::shared_ptr<AudioBus> getBus() const { return m_sourceBus; }
 
+    // Storage format for the resident sample data. STORAGE_INT16 quantizes the
+    // source bus on assignment and does not retain the float bus, so once the
+    // caller drops its own reference the clip's resident memory is halved;
+    // renderFromBuffer() converts back to float on the fly as samples are
+    // gathered by the interpolation kernels. getBus() returns nullptr in this
+    // mode, but duration(), looping and scheduling behave identically.
+    bool setBus(ContextRenderLock &, std::shared_ptr<AudioBus> sourceBus, StorageFormat storage);
+    StorageFormat storageFormat() const { return m_packedChannels.empty() ? STORAGE_FLOAT32 : STORAGE_INT16; }
+
+    // Streaming mode: instead of holding the whole decoded clip resident, an i/o
+    // thread prefetches planar frames from the stream into a small ring buffer
+    // that the render thread consumes lock-free. Long ambience beds drop from
+    // hundreds of MB resident to the ring (a few hundred KB). Streaming playback
+    // runs at the buffer's native rate: playbackRate/detune/doppler do not apply,
+    // and looping loops the whole stream. Replaces any bus set with setBus().
+    bool setStream(ContextRenderLock &, std::shared_ptr<AudioFileStream> stream);
+    std::shared_ptr<AudioFileStream> getStream() const { return m_stream; }
+
+    // Count of render quanta (or partial quanta) where the ring ran dry and
+    // silence was emitted while the i/o thread caught up.
+    uint64_t streamUnderruns() const { return m_streamUnderruns.load(std::memory_order_relaxed); }
+
     // numberOfChannels() returns the number of output channels. This value equals the number of channels from the buffer.
     // If a new buffer is set with a different number of channels, then this value will dynamically change.
     size_t numberOfChannels(ContextRenderLock & r);
@@ -54,6 +93,28 @@ public:
     void setLoopStart(double loopStart);
     void setLoopEnd(double loopEnd);
 
+    // Precomputed loop-seam crossfade. A segment of the given length is
+    // blended once, off the render path: the last frames of the loop
+    // equal-power fade into the material just before loopStart, so the wrap
+    // is seamless without authored crossfades and without doubling reads at
+    // render time. Requires loopStart to sit at least one crossfade length
+    // into the buffer (author beds with lead-in material); the length is
+    // clamped to what the lead-in allows, so a whole-buffer loop disables
+    // it. Rebuilt by setBus(); call again after changing loop points. Zero
+    // clears. Resident-buffer playback only; streams loop unfaded.
+    void setLoopCrossfade(ContextRenderLock &, float seconds);
+    float loopCrossfade() const { return m_loopCrossfadeSeconds; }
+
+    // Interpolation used when resampling (i.e. whenever the total pitch rate
+    // is not exactly 1). Cubic is a 4-point Catmull-Rom that costs roughly
+    // twice the arithmetic of linear but has far less aliasing, so heavily
+    // pitched one-shots don't need pre-rendered variants. Until this is
+    // called the node follows the context's voicePlayback resampler tier
+    // (linear for ResamplerQuality::Linear, cubic otherwise); calling it
+    // pins the node to the given mode.
+    InterpolationMode interpolation() const;
+    void setInterpolation(InterpolationMode mode);
+
     std::shared_ptr<AudioParam> gain() { return m_gain; }
     std::shared_ptr<AudioParam> playbackRate() { return m_playbackRate; }
     std::shared_ptr<AudioParam> detune() { return m_detune; }
@@ -62,9 +123,21 @@ public:
     void setPannerNode(PannerNode*);
     virtual void clearPannerNode() override;
 
+    // Voice parking (see lab::VoiceManager). A parked voice emits silence at
+    // near-zero cost while its playback position continues to advance exactly
+    // as if it were rendering, so reviving it resumes the sample mid-phrase
+    // rather than where it was parked; a non-looping voice that reaches its
+    // end while parked finishes normally. Streaming playback pauses instead:
+    // the prefetch ring is not consumed while parked. Safe to toggle from any
+    // thread.
+    void setParked(bool parked) { m_parked.store(parked, std::memory_order_relaxed); }
+    bool parked() const { return m_parked.load(std::memory_order_relaxed); }
+
     // If we are no longer playing, propagate silence ahead to downstream nodes.
     virtual bool propagatesSilence(ContextRenderLock & r) const override;
 
+    virtual void queryMemory(ContextRenderLock & r, MemoryUsage & usage) const override;
+
 private:
 
     virtual double tailTime(ContextRenderLock & r) const override { return 0; }
@@ -73,12 +146,51 @@ private:
     // Returns true on success.
     bool renderFromBuffer(ContextRenderLock &, AudioBus *, size_t destinationFrameOffset, size_t numberOfFrames);
 
+    // Streaming-mode counterpart of renderFromBuffer(); consumes from the
+    // prefetch ring without taking any lock.
+    bool renderFromStream(ContextRenderLock &, AudioBus *, size_t destinationFrameOffset, size_t numberOfFrames);
+
+    // Advances m_virtualReadIndex across numberOfFrames while parked,
+    // mirroring renderFromBuffer's bounds and loop arithmetic so the
+    // position lands where real rendering would have left it.
+    void advanceParkedPosition(ContextRenderLock &, size_t numberOfFrames);
+
+    void streamFetchLoop();
+    void stopStreamThread();
+
     // Render silence starting from "index" frame in AudioBus.
     bool renderSilenceAndFinishIfNotLooping(ContextRenderLock & r, AudioBus *, size_t index, size_t framesToProcess);
 
+    // Sample rate / length of the resident source data regardless of storage format.
+    float sourceSampleRate() const;
+    size_t sourceLength() const;
+
     // m_buffer holds the sample data which this node outputs.
     std::shared_ptr<AudioBus> m_sourceBus;
 
+    // Int16 storage mode (see setBus). One packed array per channel, plus the
+    // source metadata that would otherwise be read from the float bus.
+    std::vector<std::vector<int16_t>> m_packedChannels;
+    size_t m_packedLength{ 0 };
+    float m_packedSampleRate{ 0 };
+
+    // Streaming playback state. The ring is a single-producer single-consumer
+    // queue of planar frames: the i/o thread advances m_streamWriteFrame, the
+    // render thread advances m_streamReadFrame, and both are absolute frame
+    // counters so available data is simply their difference.
+    std::shared_ptr<AudioFileStream> m_stream;
+    std::vector<std::vector<float>> m_streamRing; // one ring per channel
+    std::atomic<uint64_t> m_streamWriteFrame{ 0 };
+    std::atomic<uint64_t> m_streamReadFrame{ 0 };
+    std::atomic<uint64_t> m_streamEndFrame{ ~0ull }; // total frames at end of stream, ~0 while unbounded
+    std::atomic<uint64_t> m_streamUnderruns{ 0 };
+    uint64_t m_streamSourceFrame{ 0 }; // i/o thread only: next frame to fetch from the stream
+    uint64_t m_streamFramesToSkip{ 0 }; // render thread only: coarse seek, discarded as frames arrive
+    std::thread m_streamThread;
+    std::mutex m_streamMutex;
+    std::condition_variable m_streamCondition;
+    bool m_streamThreadShouldExit{ false };
+
     // Exposed attributes
     std::shared_ptr<AudioParam> m_gain;
     std::shared_ptr<AudioParam> m_playbackRate;
@@ -88,6 +200,8 @@ private:
     // If true, it will wrap around to the start of the buffer each time it reaches the end.
     std::shared_ptr<AudioSetting> m_isLooping;
 
+    std::atomic<bool> m_parked{ false };
+
     bool m_startRequested{ false };
     double m_requestWhen{ 0 };
     double m_requestGrainOffset{ 0 };
@@ -95,6 +209,26 @@ private:
 
     std::shared_ptr<AudioSetting> m_loopStart;
     std::shared_ptr<AudioSetting> m_loopEnd;
+    std::shared_ptr<AudioSetting> m_interpolation;
+
+    // True once setInterpolation() has been called; while false the render
+    // maps the context's voicePlayback resampler tier instead.
+    bool m_interpolationExplicit{ false };
+
+    // Rebuilds the crossfaded loop tail for the current source and loop
+    // points; clears it when the configuration can't support one.
+    void rebuildLoopCrossfade();
+
+    // The blended loop tail (see setLoopCrossfade): one float segment per
+    // channel with one leading and two trailing guard frames, so the
+    // interpolation taps never leave it. The loop geometry it was built for
+    // is baked alongside and re-validated in renderFromBuffer(); a tail
+    // built for other loop points is simply ignored.
+    float m_loopCrossfadeSeconds{ 0 };
+    std::vector<std::vector<float>> m_loopTail;
+    size_t m_loopTailFrames{ 0 };
+    double m_loopTailEndFrame{ 0 };
+    double m_loopTailLoopStartFrame{ 0 };
 
     // m_virtualReadIndex is a sample-frame index into our buffer representing the current playback position.
     // Since it's floating-point, it has sub-sample accuracy.
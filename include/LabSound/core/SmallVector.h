@@ -0,0 +1,154 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef SmallVector_h
+#define SmallVector_h
+
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace lab
+{
+
+// A vector with inline storage for the first InlineCapacity elements,
+// spilling to the heap only beyond that. Nodes and summing junctions keep
+// their input, output and connection lists in these: the overwhelming
+// majority of nodes have one input and one output carrying one or two
+// connections, so per-node heap blocks for those lists are pure
+// fragmentation. The interface is the subset of std::vector the graph
+// code uses; iterators are plain pointers and are invalidated by growth,
+// exactly as with std::vector.
+template <typename T, size_t InlineCapacity>
+class SmallVector
+{
+    SmallVector(const SmallVector &) = delete;
+    SmallVector & operator=(const SmallVector &) = delete;
+
+public:
+
+    typedef T value_type;
+    typedef T * iterator;
+    typedef const T * const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    SmallVector() = default;
+
+    ~SmallVector()
+    {
+        clear();
+        if (m_data != inlineData())
+            ::operator delete(m_data);
+    }
+
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_capacity; }
+    bool empty() const { return m_size == 0; }
+
+    T & operator[](size_t i) { return m_data[i]; }
+    const T & operator[](size_t i) const { return m_data[i]; }
+
+    T & front() { return m_data[0]; }
+    T & back() { return m_data[m_size - 1]; }
+    const T & front() const { return m_data[0]; }
+    const T & back() const { return m_data[m_size - 1]; }
+
+    iterator begin() { return m_data; }
+    iterator end() { return m_data + m_size; }
+    const_iterator begin() const { return m_data; }
+    const_iterator end() const { return m_data + m_size; }
+
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    void reserve(size_t newCapacity)
+    {
+        if (newCapacity > m_capacity)
+            grow(newCapacity);
+    }
+
+    void push_back(const T & value)
+    {
+        if (m_size == m_capacity)
+            grow(m_capacity * 2);
+        new (m_data + m_size) T(value);
+        ++m_size;
+    }
+
+    void push_back(T && value)
+    {
+        if (m_size == m_capacity)
+            grow(m_capacity * 2);
+        new (m_data + m_size) T(std::move(value));
+        ++m_size;
+    }
+
+    template <typename... Args>
+    void emplace_back(Args &&... args)
+    {
+        if (m_size == m_capacity)
+            grow(m_capacity * 2);
+        new (m_data + m_size) T(std::forward<Args>(args)...);
+        ++m_size;
+    }
+
+    void pop_back()
+    {
+        --m_size;
+        m_data[m_size].~T();
+    }
+
+    // Shifts the tail down by one; returns the iterator following the
+    // removed element, as std::vector::erase does.
+    iterator erase(iterator position)
+    {
+        for (iterator i = position; i + 1 != end(); ++i)
+            *i = std::move(*(i + 1));
+        pop_back();
+        return position;
+    }
+
+    void clear()
+    {
+        for (size_t i = 0; i < m_size; ++i)
+            m_data[i].~T();
+        m_size = 0;
+    }
+
+private:
+
+    T * inlineData() { return reinterpret_cast<T *>(m_inlineStorage); }
+
+    void grow(size_t newCapacity)
+    {
+        if (newCapacity < m_capacity * 2)
+            newCapacity = m_capacity * 2;
+
+        T * newData = static_cast<T *>(::operator new(newCapacity * sizeof(T)));
+        for (size_t i = 0; i < m_size; ++i)
+        {
+            new (newData + i) T(std::move(m_data[i]));
+            m_data[i].~T();
+        }
+
+        if (m_data != inlineData())
+            ::operator delete(m_data);
+
+        m_data = newData;
+        m_capacity = newCapacity;
+    }
+
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type m_inlineStorage[InlineCapacity];
+    T * m_data = inlineData();
+    size_t m_size = 0;
+    size_t m_capacity = InlineCapacity;
+};
+
+} // namespace lab
+
+#endif // SmallVector_h
@@ -0,0 +1,121 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef TraceRecorder_h
+#define TraceRecorder_h
+
+#include "LabSound/core/MpscQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace lab
+{
+
+// Optional trace-span capture for timeline analysis. The profiling counters
+// say what is slow on average; a trace says when and in what order. While
+// enabled, the engine emits one span per device callback, per node
+// process(), per convolution worker job and per decode task, each tagged
+// with the node's type and instance id where one applies. Spans are pushed
+// into a bounded lock-free queue - recording never allocates, locks or
+// blocks on any thread, and a full queue drops the span and counts it -
+// then json() drains the buffer as Chrome trace-event JSON, loadable in
+// chrome://tracing or Perfetto alongside an application's own trace, so a
+// cross-thread stall (a convolver waking late against the callback that
+// needed it) is visible as a gap between spans rather than inferred from
+// counters.
+//
+// Names passed to record() must have static storage duration (string
+// literals and typeid names qualify); only the pointer is stored. Enable,
+// exercise the workload, then dump from one application thread; the queue
+// is the only cross-thread structure.
+class TraceRecorder
+{
+public:
+    enum class Category : uint8_t
+    {
+        Quantum,  // one device callback
+        Node,     // one node's process() within a quantum
+        Worker,   // convolution worker pool job or task
+        Decode,   // async file decode task
+    };
+
+    static TraceRecorder & instance();
+
+    // Starts capture. The span buffer is allocated on first enable (rounded
+    // up to a power of two) and reused by later enables; each enable resets
+    // the trace clock to zero.
+    void enable(size_t capacityEvents = 65536);
+    void disable();
+    bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    // Records a completed span. Returns immediately when capture is off;
+    // callers on hot paths need not check enabled() first unless taking the
+    // timestamps itself is the cost being avoided.
+    void record(Category category, const char * name, uint64_t id,
+                std::chrono::high_resolution_clock::time_point begin,
+                std::chrono::high_resolution_clock::time_point end);
+
+    // Spans that could not be buffered because the queue was full.
+    uint64_t droppedEvents() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    // Drains every buffered span into a Chrome trace-event JSON document
+    // ({"traceEvents":[...]}); node spans are named by their demangled node
+    // type with the instance id in args. Call from one thread at a time.
+    std::string json();
+    bool writeJson(const std::string & path);
+
+private:
+    TraceRecorder() = default;
+    TraceRecorder(const TraceRecorder &) = delete;
+    TraceRecorder & operator=(const TraceRecorder &) = delete;
+
+    struct Event
+    {
+        const char * name = nullptr;
+        uint64_t id = 0;
+        uint64_t startMicroseconds = 0;
+        uint64_t durationMicroseconds = 0;
+        uint64_t threadId = 0;
+        Category category = Category::Quantum;
+    };
+
+    std::unique_ptr<mpsc_queue<Event>> m_queue;
+    std::atomic<bool> m_enabled{ false };
+    std::atomic<uint64_t> m_dropped{ 0 };
+    std::chrono::high_resolution_clock::time_point m_epoch;
+};
+
+// Scoped span: times its enclosing block and records on destruction. The
+// constructor is a single relaxed load when capture is off.
+class TraceSpan
+{
+public:
+    TraceSpan(TraceRecorder::Category category, const char * name, uint64_t id = 0)
+        : m_category(category), m_name(name), m_id(id)
+    {
+        m_active = TraceRecorder::instance().enabled();
+        if (m_active)
+            m_begin = std::chrono::high_resolution_clock::now();
+    }
+
+    ~TraceSpan()
+    {
+        if (m_active)
+            TraceRecorder::instance().record(m_category, m_name, m_id, m_begin,
+                                             std::chrono::high_resolution_clock::now());
+    }
+
+private:
+    TraceRecorder::Category m_category;
+    const char * m_name;
+    uint64_t m_id;
+    bool m_active;
+    std::chrono::high_resolution_clock::time_point m_begin;
+};
+
+} // namespace lab
+
+#endif // TraceRecorder_h
@@ -21,6 +21,11 @@ public:
     // setCurve will take ownership of curve
     void setCurve(std::vector<float> && curve);
     std::vector<float> & curve();
+
+    // 1 disables oversampling; 2 and 4 run the curve at a higher rate to
+    // reduce aliasing from the non-linearity. Throws on any other value.
+    void setOversample(int oversample);
+    int oversample() const;
 };
 
 } // namespace lab
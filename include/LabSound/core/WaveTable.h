@@ -24,6 +24,38 @@ public:
 
     ~WaveTable();
 
+    // Process-wide bank of the standard waveforms, keyed by waveform type and
+    // sample rate and shared across all contexts. Tables are immutable once
+    // built, so the returned table can be rendered from concurrently.
+    static std::shared_ptr<WaveTable> standardWaveTable(const float sampleRate, OscillatorType basicWaveform);
+
+    // Eagerly builds the standard sine/square/sawtooth/triangle tables for the
+    // given sample rate so the first oscillator does not pay table-construction
+    // cost on first sound. Optional; tables are built lazily otherwise.
+    static void prewarmStandardTables(const float sampleRate);
+
+    // A custom-wave build in flight. table() is null until the worker has
+    // published the finished bank, and stable thereafter.
+    class CustomBuild
+    {
+    public:
+        std::shared_ptr<WaveTable> table() const { return std::atomic_load(&m_table); }
+
+    private:
+        friend class WaveTable;
+        std::shared_ptr<WaveTable> m_table;
+    };
+
+    // Process-wide deduplicated bank of custom periodic waves, keyed by a
+    // hash of the Fourier coefficients and the sample rate. Building the
+    // band-limited mipmap runs dozens of inverse FFTs (~10 ms), so the build
+    // is dispatched to the shared worker pool; identical-spectrum requests
+    // share one build and one finished table. Returns null if real and imag
+    // are empty or of mismatched lengths.
+    static std::shared_ptr<CustomBuild> customWaveTable(const float sampleRate,
+                                                        const std::vector<float> & real,
+                                                        const std::vector<float> & imag);
+
     // Returns pointers to the lower and higher wavetable data for the pitch range containing
     // the given fundamental frequency. These two tables are in adjacent "pitch" ranges
     // where the higher table will have the maximum number of partials which won't alias when played back
@@ -32,6 +64,11 @@ public:
     // Where values from 0 -> 1 interpolate between lower -> higher.
     void waveDataForFundamentalFrequency(float, float* &lowerWaveData, float* &higherWaveData, float& tableInterpolationFactor);
 
+    // Cache-friendly variant of the above: returns one pointer into an interleaved
+    // copy of the two tables bounding the pitch range, where element 2*i is the
+    // higher-partial sample and 2*i+1 the lower-partial sample for read index i.
+    const float* interleavedWaveDataForFundamentalFrequency(float, float& tableInterpolationFactor);
+
     // Returns the scalar multiplier to the oscillator frequency to calculate wave table phase increment.
     float rateScale() const { return m_rateScale; }
 
@@ -53,6 +90,9 @@ private:
 
     size_t numberOfRanges() const { return m_numberOfRanges; }
 
+    // Maps a fundamental frequency to a fractional pitch range index, clamped to [0, numberOfRanges - 1].
+    float pitchRangeForFundamentalFrequency(float fundamentalFrequency) const;
+
     // Maximum possible number of partials (before culling).
     size_t maxNumberOfPartials() const;
 
@@ -62,6 +102,11 @@ private:
     void createBandLimitedTables(const float* real, const float* imag, size_t numberOfComponents);
 
     std::vector<std::unique_ptr<AudioFloatArray> > m_bandLimitedTables;
+
+    // Each adjacent pair of range tables interleaved into one allocation, so that
+    // the four samples the oscillator loop needs per output frame land in two
+    // neighbouring cache lines instead of two widely separated tables.
+    std::vector<std::unique_ptr<AudioFloatArray> > m_interleavedPairs;
 };
 
 } // namespace lab
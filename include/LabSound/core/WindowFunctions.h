@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "LabSound/core/AudioArray.h"
+
 #include <vector>
 #include <cmath>
 
@@ -10,7 +12,7 @@ namespace lab {
 
     static const float Pi = 3.14159265358979323846f;
     static const float TwoPi = 6.28318530717958647693f;
-    
+
     enum WindowType {
         window_rectangle,
         window_hamming,
@@ -20,92 +22,23 @@ namespace lab {
         window_blackman_harris,
         window_gaussian,
         window_welch,
-        window_bartlett, 
+        window_bartlett,
         window_parzen
     };
 
-    inline void applyWindow(WindowType wType, std::vector<float> &buffer) {
-
-        int bSize = static_cast<int>(buffer.size());
-
-        switch (wType) {
-
-            case window_rectangle: {
-                for (int i = 0; i< bSize; i++) {
-                    buffer[i] *= 0.5;
-                }
-            }
-            break;
+    // Process-wide cache of window coefficient tables, keyed by (type, size).
+    // A window is a pure function of its type and length, so each table is
+    // computed exactly once per process and shared by every consumer
+    // afterwards. The returned array is 16-byte aligned and lives for the
+    // remainder of the process; entries are never evicted.
+    const AudioFloatArray& windowFunctionTable(WindowType type, size_t size);
 
-            case window_hamming: {
-                for (int i = 0; i< bSize; i++) {
-                    buffer[i] *= 0.54f - 0.46f * cos(TwoPi * i / ( bSize));
-                }
-            }
-            break;
+    // Multiplies p[0..n) in place by the cached table for (type, n) with a
+    // vector multiply.
+    void applyWindowTable(WindowType type, float* p, size_t n);
 
-            case window_hanning: {
-                for (int i = 0; i< bSize; i++) {
-                    buffer[i] *= 0.5f - (0.5f * cos(TwoPi * i / ( bSize)));
-                }
-            }
-            break;
-
-            case window_hanningz: {
-                for (int i = 0; i< bSize; i++) {
-                    buffer[i] *= 0.5f * (1.0f - cos(TwoPi * i / ( bSize)));
-                }
-            }
-            break;
-
-            case window_blackman: {
-                for (int i= 0; i < bSize; i++) {
-                    buffer[i] *= 0.42f - 0.50f * cos(TwoPi * i / (bSize - 1.0f)) + 0.08f * cos(4.0f * TwoPi * i / (bSize - 1.0f));
-                }
-            }
-            break;
-
-            case window_blackman_harris: {
-                for (int i = 0; i < bSize; i++) {
-                    buffer[i] *= 0.35875f - 0.48829f * cos(TwoPi * i / (bSize - 1.0f)) + 0.14128f * cos(2.0f * TwoPi * i / (bSize - 1.0f)) - 0.01168f * cos(3.0f*TwoPi*i/( bSize - 1.0f));
-                }
-            }
-            break;
-
-            case window_gaussian: {
-                float a, b, c = 0.5;
-                int n;
-                for (n = 0; n <  bSize; n++) {
-                    a = (n - c * (bSize - 1)) / (sqrt(c) * (bSize - 1));
-                    b = -c * sqrt(a);
-                    buffer[n] *= exp(b);
-                }
-            }
-            break;
-                
-            case window_welch: {
-                for (int i = 0; i < bSize; i++) {
-                    buffer[i] *= 1.0f - sqrt((2.0f * i - bSize) / (bSize + 1.0f));
-                }
-            }
-            break;
-                
-            case window_bartlett: {
-                for (int i = 0; i < bSize; i++) {
-                    buffer[i] *= 1.0f - abs(2.0f * (i / bSize) - 1.0f);
-                }
-            }
-            break; 
-                
-            case window_parzen: {
-                for (int i = 0; i < bSize; i++) {
-                    buffer[i] *= 1.0f - abs((2.0f * i - bSize) / ( bSize + 1.0f));
-                }
-            }
-            break;
-                
-        }
-        
+    inline void applyWindow(WindowType wType, std::vector<float> &buffer) {
+        applyWindowTable(wType, buffer.data(), buffer.size());
     }
 
 } // End namespace lab
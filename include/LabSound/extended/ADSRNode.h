@@ -11,6 +11,8 @@
 #include "LabSound/core/AudioBasicInspectorNode.h"
 #include "LabSound/core/GainNode.h"
 
+#include <vector>
+
 namespace lab
 {
 
@@ -18,7 +20,12 @@ namespace lab
     {
         class ADSRNodeInternal;
         ADSRNodeInternal * internalNode;
-        
+
+        // SupersawNode embeds an ADSRNode and runs its envelope processor
+        // inline over the internally generated saw bank, rather than routing
+        // through the graph.
+        friend class SupersawNode;
+
     public:
         
         ADSRNode();
@@ -28,6 +35,12 @@ namespace lab
         // finished and avoiding noteOn while finished is true can avoid the popping.
         void noteOn(double when);
         void noteOff(ContextRenderLock&, double when);
+
+        // Gate a whole group of envelopes (e.g. every voice of a chord) from
+        // one shared time, so a retrigger is a single timeline update rather
+        // than per-voice bookkeeping.
+        static void noteOnBatch(const std::vector<ADSRNode *> & group, double when);
+        static void noteOffBatch(ContextRenderLock &, const std::vector<ADSRNode *> & group, double when);
         
         bool finished(ContextRenderLock&); // if a noteOff has been issued, finished will be true after the release period
 
@@ -0,0 +1,91 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef AUDIO_BRIDGE_NODE_H
+#define AUDIO_BRIDGE_NODE_H
+
+#include "LabSound/core/AudioSourceNode.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace lab
+{
+    // AudioBridgeNode carries audio synthesized on one engine thread (game
+    // logic, procedural foley) onto the render thread with no locks and no
+    // copies. It keeps a small ring of quantum-sized planar buffers - three
+    // by default - between a single producer and the render thread:
+    //
+    //     float * const * channels = bridge->beginWrite();
+    //     if (channels) { ...write ProcessingSizeInFrames frames... bridge->publish(); }
+    //
+    // beginWrite hands the producer a buffer it owns outright for the frame;
+    // publish makes it visible with one atomic store. On the other side,
+    // process() points the output bus directly at the oldest published buffer,
+    // so consumption is a pointer swap, not a memcpy. A consumed buffer is
+    // recycled only after the following quantum, which is what makes the
+    // swapped-in pointer safe for downstream readers.
+    //
+    // underruns() counts quanta the render thread found nothing published;
+    // overruns() counts frames the producer found no free buffer. Together
+    // they are the tuning signal for bufferCount: the smallest count with
+    // both counters flat adds exactly (bufferCount - 2) quanta of latency
+    // beyond the unavoidable one.
+    class AudioBridgeNode : public AudioSourceNode
+    {
+    public:
+
+        // bufferCount is clamped to [2, 8].
+        AudioBridgeNode(size_t numberOfChannels, size_t bufferCount = 3);
+        virtual ~AudioBridgeNode();
+
+        // Producer API - single producer thread only.
+        // Returns per-channel write pointers, each ProcessingSizeInFrames
+        // floats, or nullptr when every buffer is full (an overrun).
+        float * const * beginWrite();
+
+        // Publishes the buffer returned by the last beginWrite. One atomic
+        // release store; no effect without a matching beginWrite.
+        void publish();
+
+        // Frames each buffer holds - always AudioNode::ProcessingSizeInFrames.
+        size_t framesPerBuffer() const;
+        size_t bufferCount() const { return m_bufferCount; }
+
+        // Underrun/overrun accounting, readable from any thread.
+        uint64_t underruns() const { return m_underruns.load(std::memory_order_relaxed); }
+        uint64_t overruns() const { return m_overruns.load(std::memory_order_relaxed); }
+        void resetCounters();
+
+        // AudioNode
+        virtual void process(ContextRenderLock &, size_t framesToProcess) override;
+        virtual void reset(ContextRenderLock &) override;
+
+    private:
+
+        // As an audio source, we will never propagate silence.
+        virtual bool propagatesSilence(ContextRenderLock & r) const override { return false; }
+
+        size_t m_channelCount = 0;
+        size_t m_bufferCount = 0;
+
+        // One allocation: bufferCount * channels * quantum, then a parallel
+        // table of per-channel pointers handed out by beginWrite.
+        std::unique_ptr<float[]> m_storage;
+        std::unique_ptr<float *[]> m_channelPointers;
+        std::unique_ptr<float[]> m_silence;
+
+        // Monotonic sequence numbers; slot = seq % bufferCount.
+        std::atomic<uint64_t> m_published{0};  // advanced by publish()
+        std::atomic<uint64_t> m_consumed{0};   // advanced by process()
+
+        bool m_writeOpen = false;      // producer thread only
+        bool m_holdingSlot = false;    // render thread only
+
+        std::atomic<uint64_t> m_underruns{0};
+        std::atomic<uint64_t> m_overruns{0};
+    };
+}
+
+#endif
@@ -11,6 +11,7 @@
 #include "LabSound/core/AudioContext.h"
 #include "LabSound/extended/Logging.h"
 
+#include <chrono>
 #include <iostream>
 #include <mutex>
 
@@ -56,10 +57,10 @@ namespace lab
     
     class ContextRenderLock
     {
-        AudioContext * m_context;
+        AudioContext * m_context = nullptr;
 
     public:
-        
+
         ContextRenderLock(AudioContext * context, const std::string & lockSuitor)
         {
             if (context)
@@ -79,7 +80,20 @@ namespace lab
             }
 #endif
         }
-        
+
+        // Bounded acquisition for the audio callback. The device thread must never
+        // block indefinitely behind a main thread mutating the graph; if the lock
+        // cannot be had within the timeout, context() returns nullptr and the
+        // caller should emit silence for the quantum rather than stall the device.
+        ContextRenderLock(AudioContext * context, const std::string & lockSuitor, std::chrono::microseconds timeout)
+        {
+            if (context && context->m_renderLock.try_lock_for(timeout))
+            {
+                m_context = context;
+                m_context->m_renderLocker = lockSuitor;
+            }
+        }
+
         ~ContextRenderLock()
         {
             if (m_context)
@@ -6,6 +6,8 @@
 
 #include "LabSound/core/AudioBus.h"
 
+#include <functional>
+#include <future>
 #include <memory>
 #include <vector>
 #include <string>
@@ -13,10 +15,27 @@
 
 namespace lab
 {
-    // Performs direct filesystem i/o to decode the file (using libnyquist)
+    // Performs direct filesystem i/o to decode the file (using libnyquist).
+    // Decoded busses are cached by path (weakly, so the cache never pins memory):
+    // loading the same file for several nodes shares one immutable AudioBus
+    // instead of re-decoding and duplicating the samples.
+    //
+    // PCM WAV files (16-bit integer and 32-bit float) load through a read-only
+    // file mapping instead of the decoder: headers are parsed in place and
+    // samples stream from the mapping straight into the bus - for mono float32
+    // files the bus aliases the mapped data outright, making load time the
+    // cost of the mmap and leaving paging to the OS.
     std::shared_ptr<AudioBus> MakeBusFromFile(const char * filePath, bool mixToMono);
     std::shared_ptr<AudioBus> MakeBusFromFile(const std::string& path, bool mixToMono);
 
+    // Decodes on a shared worker pool instead of blocking the caller, so a
+    // soundbank's files decode in parallel. The future resolves to the decoded
+    // bus, or an empty pointer on failure.
+    std::future<std::shared_ptr<AudioBus>> MakeBusFromFileAsync(const std::string & path, bool mixToMono);
+
+    // Callback flavor of the above; the callback runs on the decode thread.
+    void MakeBusFromFileAsync(const std::string & path, bool mixToMono, std::function<void(std::shared_ptr<AudioBus>)> callback);
+
     // Loads and decodes a raw binary memory chunk making use of magic numbers to determine filetype. 
     std::shared_ptr<AudioBus> MakeBusFromMemory(const std::vector<uint8_t> & buffer, bool mixToMono);
 
@@ -0,0 +1,68 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef AudioFileStream_H
+#define AudioFileStream_H
+
+#include "LabSound/extended/Util.h"
+
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace lab
+{
+    // AudioFileStream is a disk-backed source of planar PCM for streaming playback
+    // of long sounds. The file is decoded once up front and the planar samples are
+    // spilled to an anonymous temporary file; afterwards only the portions actually
+    // being played are read back, so steady-state memory for a ten minute ambience
+    // bed is the consumer's ring buffer rather than the full decoded clip.
+    //
+    // (libnyquist has no incremental decode, so the decode itself is still a
+    // transient whole-file cost; it is paid once at load rather than held forever.)
+    //
+    // Subclasses may substitute another backing store behind read() - see
+    // CompressedAudioStream, which decodes chunks of compressed-resident
+    // bytes on demand instead of reading a spill file.
+    class AudioFileStream
+    {
+        NO_MOVE(AudioFileStream);
+
+    public:
+
+        AudioFileStream(const std::string & path, bool mixToMono = false);
+        virtual ~AudioFileStream();
+
+        // False if the file could not be decoded or spilled to disk.
+        virtual bool valid() const { return m_file != nullptr; }
+
+        float sampleRate() const { return m_sampleRate; }
+        size_t length() const { return m_length; } // total sample-frames
+        size_t numberOfChannels() const { return m_numberOfChannels; }
+
+        // Reads up to frameCount planar frames starting at startFrame into the
+        // per-channel destination pointers, returning the count actually read.
+        // This performs blocking disk i/o - call it from an i/o thread, never
+        // from the render thread.
+        virtual size_t read(size_t startFrame, float * const * destination, size_t frameCount);
+
+    protected:
+
+        // For subclasses with their own backing store, which fill in the
+        // stream geometry below themselves.
+        AudioFileStream() = default;
+
+        float m_sampleRate = 0;
+        size_t m_length = 0;
+        size_t m_numberOfChannels = 0;
+
+    private:
+
+        FILE * m_file = nullptr;
+
+        std::mutex m_ioMutex;
+    };
+}
+
+#endif
@@ -0,0 +1,81 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#pragma once
+
+#ifndef BAKE_FARM_H
+#define BAKE_FARM_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lab
+{
+    class AudioContext;
+    class AudioNode;
+
+    // Batch offline rendering ("bake farm"). A pipeline that renders
+    // thousands of independent variations by launching one process per file
+    // pays process startup, HRTF database load, wavetable construction and
+    // sample decoding once per render. Hosting the batch in one process pays
+    // them once in total: the process-wide caches - the HRTF database per
+    // sample rate, the window and nonlinearity tables, the periodic-wave
+    // spectrum dedup, the compressed-stream decode cache - are shared by
+    // every job, and the jobs themselves are independent offline renders
+    // that scale across cores.
+    //
+    // Each job describes its graph in the GraphSerialization format and is
+    // rendered by a private offline context streaming straight to disk, so
+    // a job's memory footprint is one render quantum plus the wav writer's
+    // ring regardless of duration.
+
+    struct BakeJob
+    {
+        // the graph to render, in the serializeGraph() format
+        std::vector<uint8_t> graph;
+
+        // destination for the 32 bit float WAV, streamed while rendering
+        std::string outputPath;
+
+        float durationSeconds = 0.f;
+        float sampleRate = 44100.f;
+        uint32_t channels = 2;
+
+        // Runs on the worker thread after the graph is rebuilt and before
+        // rendering starts, with the created nodes index-aligned with the
+        // serialized data. This is where the payloads serialization leaves
+        // to the caller - sample buffers, impulse responses, periodic
+        // waves, typically handed out of a shared cache - are restored, and
+        // where per-variation parameter changes are applied.
+        std::function<void(AudioContext &, std::vector<std::shared_ptr<AudioNode>> &)> prepare;
+    };
+
+    struct BakeResult
+    {
+        bool ok = false;
+
+        // empty on success
+        std::string error;
+
+        // wall-clock seconds this job spent rendering
+        double renderSeconds = 0;
+    };
+
+    // Renders every job, up to concurrency at a time (zero means one per
+    // hardware thread), and returns results index-aligned with jobs. Blocks
+    // until the whole batch is complete; the calling thread renders jobs
+    // alongside the workers. When more than one job runs at a time, each
+    // job renders single threaded - job-level parallelism already covers
+    // the cores, and per-job subgraph workers would only oversubscribe.
+    // onJobComplete, when provided, is invoked from worker threads as each
+    // job finishes, so it must be thread safe.
+    std::vector<BakeResult> bakeAll(const std::vector<BakeJob> & jobs,
+                                    size_t concurrency = 0,
+                                    std::function<void(size_t jobIndex, const BakeResult &)> onJobComplete = {});
+
+}  // namespace lab
+
+#endif  // BAKE_FARM_H
@@ -0,0 +1,74 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef CompressedAudioStream_H
+#define CompressedAudioStream_H
+
+#include "LabSound/extended/AudioFileStream.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace lab
+{
+    // Compressed-resident streaming source for long, rarely-triggered
+    // material (dialogue banks). Where AudioFileStream spills decoded PCM to
+    // disk, a CompressedAudioStream keeps the compressed bytes themselves in
+    // memory - roughly a quarter of the decoded size for IMA ADPCM - and
+    // decodes fixed-size chunks on demand into a cache shared by every
+    // compressed stream. The cache is LRU over a global byte budget, so total
+    // decoded memory is bounded no matter how many lines are resident, and a
+    // cold trigger costs one chunk decode on the prefetch thread rather than
+    // a disk round trip.
+    //
+    // Drives SampledAudioNode streaming playback exactly like AudioFileStream
+    // (pass it to setStream): the node's i/o thread prefetches into its ring
+    // ahead of the read position, so chunks are decoded ahead of playback and
+    // re-triggered lines usually replay from the cache without decoding.
+    //
+    // The file must be an IMA ADPCM WAV (the blockwise layout is what makes
+    // chunked seeking exact; an offline packer emits it with e.g.
+    // "ffmpeg -c:a adpcm_ima_wav"). Codecs needing a third-party decoder are
+    // out of scope for this class, but the chunk cache does not care what
+    // produced the PCM.
+    class CompressedAudioStream : public AudioFileStream
+    {
+    public:
+
+        CompressedAudioStream(const std::string & path);
+        virtual ~CompressedAudioStream();
+
+        // False if the file could not be read or is not an IMA ADPCM WAV.
+        virtual bool valid() const override { return m_valid; }
+
+        // Serves from the shared chunk cache, decoding misses on the calling
+        // thread. As with the base class, never call from the render thread.
+        virtual size_t read(size_t startFrame, float * const * destination, size_t frameCount) override;
+
+        // Resident size of the compressed payload.
+        size_t compressedBytes() const { return m_compressed.size(); }
+
+        // The decoded-chunk budget shared by all compressed streams
+        // (default 32 MB). Shrinking it evicts immediately.
+        static void setDecodeCacheBudget(size_t bytes);
+        static size_t decodeCacheBudget();
+
+        // Decoded bytes currently cached.
+        static size_t decodeCacheBytes();
+
+        struct DecodedChunk;  // opaque; defined with the cache
+
+    private:
+
+        std::shared_ptr<const DecodedChunk> decodeChunk(uint32_t chunkIndex) const;
+
+        std::vector<uint8_t> m_compressed;  // the resident ADPCM block payload
+        size_t m_blockAlign = 0;            // bytes per ADPCM block
+        size_t m_samplesPerBlock = 0;       // frames per ADPCM block
+        size_t m_blocksPerChunk = 0;        // blocks decoded per cache chunk
+        uint64_t m_cacheId = 0;             // this stream's key in the shared cache
+        bool m_valid = false;
+    };
+}
+
+#endif
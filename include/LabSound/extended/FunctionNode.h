@@ -8,6 +8,9 @@
 #include "LabSound/core/AudioNode.h"
 #include "LabSound/core/AudioParam.h"
 
+#include <functional>
+#include <vector>
+
 namespace lab
 {
     
@@ -24,6 +27,20 @@ namespace lab
         {
             _function = fn;
         }
+
+        // Block form: one invocation per quantum with every channel pointer at
+        // once, so a callback can run its own SIMD across channels without
+        // per-channel std::function dispatch. sampleTime is the time of the
+        // first frame handed to the callback. The pointers are 16-byte
+        // aligned except during the initial partial quantum of a start()
+        // scheduled mid-quantum. Takes precedence over setFunction.
+        typedef std::function<void(ContextRenderLock & r, FunctionNode * me, float * const * channels,
+                                   size_t channelCount, size_t frames, double sampleTime)> BlockFunction;
+
+        void setBlockFunction(BlockFunction fn)
+        {
+            _blockFunction = fn;
+        }
         
         virtual void process(ContextRenderLock & r, size_t framesToProcess) override;
         virtual void reset(ContextRenderLock & r) override;
@@ -35,7 +52,10 @@ namespace lab
         virtual bool propagatesSilence(ContextRenderLock & r) const override;
         
         std::function<void(ContextRenderLock & r, FunctionNode * me, int channel, float * values, size_t framesToProcess)> _function;
-        
+        BlockFunction _blockFunction;
+
+        std::vector<float *> _channelPointers;
+
         double _now = 0.0;
     };
     
@@ -0,0 +1,114 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef GRANULAR_NODE_H
+#define GRANULAR_NODE_H
+
+#include "LabSound/core/AudioParam.h"
+#include "LabSound/core/AudioScheduledSourceNode.h"
+#include "LabSound/core/WindowFunctions.h"
+
+#include <memory>
+#include <vector>
+
+namespace lab
+{
+    class AudioBus;
+    class AudioSetting;
+
+    // Granular synthesis over one shared sample buffer. All grains render
+    // inside this node's process() - state lives in flat per-grain arrays,
+    // the window/envelope and interpolation run through the same vectorized
+    // style as the SampledAudioNode resampler, and grains sum into the output
+    // bus directly - so a dense cloud costs one node rather than one
+    // SampledAudioNode lifecycle (connection churn, per-node buses, scheduler
+    // traffic) per grain.
+    //
+    // params: grainRate, grainDuration, position, positionJitter,
+    //         playbackRate, rateJitter, amplitude
+    // settings: window
+    //
+    class GranularNode : public AudioScheduledSourceNode
+    {
+    public:
+
+        static const size_t MaxGrains = 512;
+
+        GranularNode();
+        virtual ~GranularNode();
+
+        virtual void process(ContextRenderLock &, size_t framesToProcess) override;
+        virtual void reset(ContextRenderLock &) override;
+
+        // The sample memory grains read from; the node holds a reference but
+        // never writes, so many GranularNodes can share one bus.
+        bool setBus(ContextRenderLock &, std::shared_ptr<AudioBus> sourceBus);
+        std::shared_ptr<AudioBus> getBus() const { return m_sourceBus; }
+
+        std::shared_ptr<AudioParam> grainRate() { return m_grainRate; }          // grains spawned per second
+        std::shared_ptr<AudioParam> grainDuration() { return m_grainDuration; }  // seconds
+        std::shared_ptr<AudioParam> position() { return m_position; }            // normalized 0..1 into the buffer
+        std::shared_ptr<AudioParam> positionJitter() { return m_positionJitter; }// +/- normalized, uniform
+        std::shared_ptr<AudioParam> playbackRate() { return m_playbackRate; }    // per-grain pitch
+        std::shared_ptr<AudioParam> rateJitter() { return m_rateJitter; }        // +/- rate, uniform
+        std::shared_ptr<AudioParam> amplitude() { return m_amplitude; }          // per-grain gain
+
+        // Grain envelope; the window is rendered into a lookup table once per
+        // change, not evaluated per sample.
+        WindowType window() const;
+        void setWindow(WindowType type);
+
+        // Diagnostics: grains currently sounding.
+        size_t activeGrains() const { return m_activeGrains; }
+
+        virtual bool propagatesSilence(ContextRenderLock & r) const override;
+
+    private:
+
+        virtual double tailTime(ContextRenderLock & r) const override { return 0; }
+        virtual double latencyTime(ContextRenderLock & r) const override { return 0; }
+
+        // Pushes one grain into the state arrays, truncating its length so
+        // every interpolation tap stays inside the source buffer.
+        void spawnGrain(float startFrame, float increment, float grainFrames, float gain, float sourceFrames);
+        void rebuildWindowTable();
+
+        // Uniform random in [-1, 1), used for position and rate jitter.
+        float jitter();
+
+        std::shared_ptr<AudioBus> m_sourceBus;
+
+        std::shared_ptr<AudioParam> m_grainRate;
+        std::shared_ptr<AudioParam> m_grainDuration;
+        std::shared_ptr<AudioParam> m_position;
+        std::shared_ptr<AudioParam> m_positionJitter;
+        std::shared_ptr<AudioParam> m_playbackRate;
+        std::shared_ptr<AudioParam> m_rateJitter;
+        std::shared_ptr<AudioParam> m_amplitude;
+
+        std::shared_ptr<AudioSetting> m_window;
+
+        // Flat per-grain state, compacted so the first m_activeGrains entries
+        // are live (finished grains are swap-removed). The render loop walks
+        // these arrays; no per-grain allocations or nodes.
+        std::vector<float> m_grainPosition;   // fractional source frame
+        std::vector<float> m_grainIncrement;  // source frames per output frame
+        std::vector<float> m_grainWindowPhase;// fractional window-table index
+        std::vector<float> m_grainWindowStep; // table indices per output frame
+        std::vector<float> m_grainGain;
+        std::vector<int> m_grainFramesLeft;
+        size_t m_activeGrains{ 0 };
+
+        // Fractional grains accumulated toward the next spawn.
+        double m_spawnAccumulator{ 0 };
+
+        std::vector<float> m_windowTable;
+        WindowType m_windowTableType{ window_rectangle };
+        bool m_windowTableValid{ false };
+
+        uint32_t m_jitterState;
+    };
+
+} // namespace lab
+
+#endif // GRANULAR_NODE_H
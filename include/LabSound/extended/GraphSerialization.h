@@ -0,0 +1,67 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#pragma once
+
+#ifndef GRAPH_SERIALIZATION_H
+#define GRAPH_SERIALIZATION_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <typeinfo>
+#include <vector>
+
+namespace lab
+{
+    class AudioContext;
+    class AudioNode;
+    class ContextRenderLock;
+
+    // Compact binary save/load for render-graph topology. Building a large
+    // mixer node by node at startup pays a lock acquisition and a set of
+    // allocations per node and per connection; a serialized graph instead
+    // reloads in bulk: the file header carries node, connection and bus
+    // counts, so loading primes the context's render bus pool up front and
+    // queues every connection as one applyConnectionBatch transaction.
+    //
+    // What is serialized: node types, AudioSetting values, AudioParam values
+    // (the current value; timelines are transient), and the connection list.
+    // Node payloads that are not settings - sample buffers, impulse
+    // responses, periodic waves - are the caller's to restore, exactly as
+    // they were the caller's to provide when building by hand.
+
+    // Serializes the graph currently reachable from the context's
+    // destination. Call at a settled moment (hasPendingUpdates() false);
+    // the walk reads the same rendering snapshot the render thread uses.
+    // Nodes of types not in the registry are omitted along with their
+    // connections.
+    std::vector<uint8_t> serializeGraph(ContextRenderLock & r, AudioContext & context);
+
+    // Rebuilds a serialized graph into the context and returns the created
+    // nodes, index-aligned with the file (index 0 is the context's own
+    // destination node). The caller owns the returned references, as it
+    // would own hand-built nodes. Returns an empty vector on malformed or
+    // version-mismatched data.
+    std::vector<std::shared_ptr<AudioNode>> deserializeGraph(AudioContext & context,
+                                                             const uint8_t * data, size_t size);
+
+    // As above, but connections to the serialized destination (index 0) are
+    // redirected into root instead, leaving the rebuilt graph attached to
+    // root and nowhere else. This is how a warm-standby graph is built
+    // behind a muted gain or an idle crossfade input ahead of a scene
+    // switch; index 0 of the returned vector is root. A null root falls
+    // back to the context's destination.
+    std::vector<std::shared_ptr<AudioNode>> deserializeGraph(AudioContext & context,
+                                                             const uint8_t * data, size_t size,
+                                                             std::shared_ptr<AudioNode> root);
+
+    // Registers a node type for serialization. The standard processing nodes
+    // are pre-registered; extended or application nodes can be added so they
+    // round-trip too. The factory receives the context's sample rate.
+    void registerGraphNodeType(const std::type_info & type, const char * name,
+                               std::function<std::shared_ptr<AudioNode>(float sampleRate)> factory);
+
+}  // namespace lab
+
+#endif  // GRAPH_SERIALIZATION_H
@@ -5,6 +5,7 @@
 #define LABSOUND_LOGGING_H
 
 #include <cstdarg>
+#include <cstdint>
 #include <stdio.h>
 #include <string>
 #include <iostream>
@@ -19,7 +20,28 @@
     #define LOG_VERBOSE(channel, ...)
 #endif
 
+// LabSoundLog deposits a structured record (file, line, format string and
+// decoded arguments) into a lock-free ring; a background thread formats and
+// writes it. A call site therefore costs a format-string walk and a few
+// word copies, never a write(). When the ring is full the record is dropped
+// and counted rather than blocking the caller. %s arguments are copied
+// (truncated to 63 characters) at the call site since the pointed-at string
+// may not outlive the call. LabSoundAssertLog flushes pending records and
+// writes synchronously, since an assert may precede a crash.
 void LabSoundLog(const char* file, int line, const char* fmt, ...);
 void LabSoundAssertLog(const char* file, int line, const char * function, const char * assertion);
 
+namespace lab
+{
+    // Block until every record deposited before the call has been written.
+    void FlushLog();
+
+    // Format and write at the call site instead of the consumer thread;
+    // for debuggers and crash investigation. Off by default.
+    void SetSynchronousLogging(bool synchronous);
+
+    // Records dropped because the ring was full since process start.
+    uint64_t DroppedLogRecords();
+}
+
 #endif
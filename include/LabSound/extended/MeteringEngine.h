@@ -0,0 +1,103 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#pragma once
+
+#ifndef METERING_ENGINE_H
+#define METERING_ENGINE_H
+
+#include "LabSound/core/AudioNode.h"
+
+#include <memory>
+#include <vector>
+
+namespace lab
+{
+    class AudioContext;
+
+    // Central metering for mixer UIs. Attaching a PowerMonitorNode or
+    // SpectralMonitorNode per metered bus costs one graph pull per meter;
+    // with dozens of channel strips that is dozens of node pulls per quantum
+    // for read-only analysis. A MeteringEngine instead registers one
+    // automatic pull node with the context and, once per quantum after the
+    // graph has rendered, computes RMS and peak for every registered tap in
+    // a single vectorized pass over the already-rendered output busses.
+    // Spectral taps are registered with the shared SpectralFFTService, which
+    // transforms every consumer's windows on one background worker instead of
+    // per instance.
+    //
+    // Taps read a node's most recent output, so the tapped node must be
+    // rendered by the graph (connected, directly or transitively, to the
+    // destination); the engine never pulls it. Levels and spectra may be
+    // read from any thread.
+    class MeteringEngine
+    {
+        class BatchNode;
+        struct Tap;
+
+    public:
+        struct Levels
+        {
+            float db = -120.f;  // 20*log10(rms), floored
+            float peak = 0.f;   // max absolute sample of the last quantum
+        };
+
+        struct Loudness
+        {
+            float momentaryLufs = -120.f;   // last 400 ms
+            float shortTermLufs = -120.f;   // last 3 s
+            float integratedLufs = -120.f;  // gated, since the tap was added or reset
+        };
+
+        MeteringEngine(std::shared_ptr<AudioContext> context);
+        ~MeteringEngine();
+
+        // Meter the given output of node. Returns a tap id.
+        int addTap(std::shared_ptr<AudioNode> node, size_t output = 0);
+
+        // As addTap, but additionally accumulates windowSize samples
+        // (channel-summed) and computes a Blackman-windowed magnitude
+        // spectrum on the shared FFT worker. windowSize must be a power of
+        // two.
+        int addSpectralTap(std::shared_ptr<AudioNode> node, size_t windowSize = 512, size_t output = 0);
+
+        // As addTap, but additionally measures BS.1770 loudness: the bus is
+        // run through the K-weighting pre-filter (two biquad stages per
+        // channel, designed at the context rate) and accumulated into gated
+        // 100 ms sub-blocks incrementally each quantum, so momentary,
+        // short-term and integrated LUFS are maintained continuously instead
+        // of by an offline pass over a bounce. The incremental work is two
+        // biquads and a squared sum per channel inside the same batch pass,
+        // so live loudness on every bus of a large mixer stays a fraction of
+        // one node's render cost.
+        int addLoudnessTap(std::shared_ptr<AudioNode> node, size_t output = 0);
+
+        void removeTap(int id);
+
+        Levels levels(int id) const;
+
+        // Momentary / short-term / integrated loudness for a loudness tap;
+        // default values for a plain tap or before the first sub-block fills.
+        // The integrated measure is gated per BS.1770: blocks below -70 LUFS
+        // are discarded outright, then blocks more than 10 LU below the
+        // running mean.
+        Loudness loudness(int id) const;
+
+        // Restarts a loudness tap's measurement windows and integrated gate.
+        void resetLoudness(int id);
+
+        // Copies the most recent magnitude spectrum (windowSize/2 bins) for
+        // a spectral tap; leaves result empty for a plain tap or before the
+        // first window has filled.
+        void spectralMag(int id, std::vector<float> & result) const;
+
+        size_t tapCount() const;
+
+    private:
+        std::shared_ptr<AudioContext> m_context;
+        std::shared_ptr<BatchNode> m_batchNode;
+    };
+
+}
+
+#endif
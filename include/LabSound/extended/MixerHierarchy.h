@@ -0,0 +1,129 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#pragma once
+
+#ifndef MIXER_HIERARCHY_H
+#define MIXER_HIERARCHY_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace lab
+{
+    class AudioContext;
+    class AudioNode;
+    class AudioParam;
+    class GainNode;
+
+    // A mixer-bus hierarchy with flattened gain staging. Building a
+    // voice -> group -> category -> master console from chained GainNodes
+    // costs one full-buffer pass per level per source; most of those levels
+    // only exist to hold a fader. Here a level is either Rendered - backed by
+    // a real GainNode summing junction, whose input mixes every attached
+    // strip in one vectorized pass - or Control, which exists only as a gain
+    // term. Control-bus gains are multiplied down the tree into a single
+    // effective scalar per source once per quantum, so a four-level tree
+    // renders as one summing pass into its category bus instead of four.
+    //
+    // Every gain in the tree is an AudioParam: rendered-bus gains are native
+    // GainNode params (automatable and audio-rate connectable), control-bus
+    // and strip gains are evaluated at control rate, so setValue and timeline
+    // automation apply but audio-rate drivers do not. Strip gain changes
+    // de-zipper through the strip GainNode exactly as a hand-built console
+    // would.
+    //
+    // Per-level metering: any rendered bus (and any strip) can be tapped with
+    // MeteringEngine via tapNode(). A control bus's submix is never rendered
+    // - that is the saving - so it has no bus to meter; make a level Rendered
+    // where a meter is wanted.
+    class MixerHierarchy
+    {
+    public:
+        enum BusKind
+        {
+            BUS_RENDERED = 0,
+            BUS_CONTROL = 1,
+        };
+
+        // The master bus; always rendered. Connect output() into the graph.
+        static const int MasterBusId = 0;
+
+        MixerHierarchy(std::shared_ptr<AudioContext> context);
+        ~MixerHierarchy();
+
+        // Creates a bus under parentBus and returns its id, or 0 if the
+        // parent does not exist. A rendered bus connects into its nearest
+        // rendered ancestor.
+        int createBus(const std::string & name, int parentBus = MasterBusId, BusKind kind = BUS_CONTROL);
+
+        // Removes an empty leaf bus (no child buses, no strips). Returns
+        // false, leaving the tree unchanged, for anything else.
+        bool removeBus(int busId);
+
+        // The bus gain. Audio-rate capable for rendered buses; control-rate
+        // (setValue / timeline automation) for control buses.
+        std::shared_ptr<AudioParam> busGain(int busId) const;
+
+        // Attaches a source under the given bus at the given level and
+        // returns a strip id, or 0 if the bus does not exist. The strip is a
+        // single GainNode carrying the source's flattened effective gain,
+        // connected directly into the nearest rendered ancestor.
+        int addSource(std::shared_ptr<AudioNode> source, int busId, float level = 1.f);
+        void removeSource(int stripId);
+
+        // The strip fader, applied beneath every ancestor gain. Control-rate.
+        std::shared_ptr<AudioParam> sourceLevel(int stripId) const;
+
+        // The node whose rendered output carries this bus's submix, for
+        // MeteringEngine taps or further routing. Null for control buses.
+        std::shared_ptr<GainNode> tapNode(int busId) const;
+
+        // The master output. Connect this to the destination (or onward).
+        std::shared_ptr<GainNode> output() const;
+
+        size_t busCount() const;
+        size_t sourceCount() const;
+
+    private:
+        class FlattenNode;
+
+        struct Bus
+        {
+            int id = 0;
+            int parent = -1;
+            BusKind kind = BUS_CONTROL;
+            std::string name;
+            std::shared_ptr<GainNode> node;    // rendered buses only
+            std::shared_ptr<AudioParam> gain;  // control buses only
+        };
+
+        struct Strip
+        {
+            int id = 0;
+            int bus = 0;
+            std::shared_ptr<AudioNode> source;
+            std::shared_ptr<GainNode> gain;     // carries the flattened scalar
+            std::shared_ptr<AudioParam> level;  // the caller-facing fader
+        };
+
+        // Walks parents from busId to the nearest rendered bus (possibly
+        // busId itself). Caller holds m_mutex.
+        const Bus * nearestRendered(int busId) const;
+        const Bus * findBus(int busId) const;
+
+        std::shared_ptr<AudioContext> m_context;
+        std::shared_ptr<FlattenNode> m_flattenNode;
+
+        mutable std::mutex m_mutex;
+        std::vector<Bus> m_buses;
+        std::vector<Strip> m_strips;
+        int m_nextBusId = 1;
+        int m_nextStripId = 1;
+    };
+
+}  // namespace lab
+
+#endif  // MIXER_HIERARCHY_H
@@ -10,14 +10,14 @@
 #include "LabSound/core/AudioNode.h"
 #include "LabSound/core/AudioParam.h"
 
-namespace lab 
+namespace lab
 {
     class AudioSetting;
 
-    // params: 
-    // settings: type
+    // params:
+    // settings: type, sharedBus
     //
-    class NoiseNode : public AudioScheduledSourceNode 
+    class NoiseNode : public AudioScheduledSourceNode
     {
 
     public:
@@ -38,24 +38,29 @@ namespace lab
         NoiseType type() const;
         void setType(NoiseType newType);
 
+        // When enabled, this node taps a noise block generated once per render
+        // quantum and shared by every tapping node of the same type, instead of
+        // running its own generator. Layered beds (many wind/ocean sources
+        // mixed at different gains) then pay for one generator rather than one
+        // per node. Tapping nodes of the same type output identical samples;
+        // leave this off where decorrelated noise is wanted.
+        void setUseSharedBus(bool shared);
+        bool useSharedBus() const;
+
     private:
 
         virtual bool propagatesSilence(ContextRenderLock & r) const override;
 
         std::shared_ptr<AudioSetting> _type;
+        std::shared_ptr<AudioSetting> _sharedBus;
 
-        uint32_t whiteSeed = 1489853723;
-
-        float lastBrown = 0;
+        // Four independent xorshift lanes; one generator step yields four
+        // white samples. Seeded per-node so layered nodes decorrelate.
+        uint32_t m_whiteState[4];
 
-        float pink0 = 0; 
-        float pink1 = 0;
-        float pink2 = 0;
-        float pink3 = 0;
-        float pink4 = 0;
-        float pink5 = 0;
-        float pink6 = 0;
+        float m_lastBrown = 0;
 
+        float m_pink[7] = { 0, 0, 0, 0, 0, 0, 0 };
     };
 
 }
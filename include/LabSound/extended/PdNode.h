@@ -9,6 +9,8 @@
 
 #include "LabSound/core/AudioBasicProcessorNode.h"
 
+#include <string>
+
 namespace pd
 {
     class PdBase;
@@ -21,22 +23,32 @@ namespace lab
 
 class PureDataNode : public AudioBasicProcessorNode
 {
-    
+
 public:
-    
+
     PureDataNode(AudioContext *, float sampleRate);
     virtual ~PureDataNode();
-    
+
     pd::PdBase & pd() const;
-    
+
+    // Control messages are queued from any thread and applied in one
+    // timestamped batch at the next quantum boundary, immediately before the
+    // quantum's DSP runs. Messages keep their queue order; a batch costs one
+    // lock acquisition per quantum instead of one libpd entry per message.
+    void sendBang(const std::string & destination);
+    void sendFloat(const std::string & destination, float value);
+    void sendSymbol(const std::string & destination, const std::string & symbol);
+
     virtual double tailTime(ContextRenderLock & r) const override { return 0; }
     virtual double latencyTime(ContextRenderLock & r) const override { return 0; }
-    
+
+    virtual bool propagatesSilence() const;
+
 private:
-    
+
     class PureDataNodeInternal;
     PureDataNodeInternal * data;
-    
+
 };
 
 } // end namespace lab
@@ -6,15 +6,15 @@
 #ifndef PING_PONG_DELAY_NODE_H
 #define PING_PONG_DELAY_NODE_H
 
-#include "LabSound/core/AudioNode.h"
+#include "LabSound/core/AudioBasicProcessorNode.h"
 #include "LabSound/core/AudioParam.h"
+#include "LabSound/core/DelayNode.h"
 #include "LabSound/core/GainNode.h"
-#include "LabSound/core/ChannelSplitterNode.h"
-#include "LabSound/core/ChannelMergerNode.h"
 
-#include "LabSound/extended/BPMDelay.h"
+#include <memory>
+#include <vector>
 
-namespace lab 
+namespace lab
 {
     class ContextGraphLock;
     class AudioContext;
@@ -28,19 +28,23 @@ namespace lab
         virtual ~Subgraph() { }
     };
 
-    class PingPongDelayNode : public Subgraph
+    // A tempo-synced ping-pong delay as a single node. Earlier versions
+    // assembled this effect from two BPMDelays, five gains and a
+    // splitter/merger pair; the same feedback/crossfeed matrix now runs over
+    // one interleaved stereo ring in a single pass per quantum, so an
+    // instance costs one graph pull and one delay buffer. Connect it like
+    // any other processing node; the dry signal passes through and the
+    // delayed signal is summed on top.
+    class PingPongDelayNode : public AudioBasicProcessorNode
     {
-        float tempo;
-
-        std::shared_ptr<BPMDelay> leftDelay;
-        std::shared_ptr<BPMDelay> rightDelay;
+        class PingPongDelayInternal;
+        PingPongDelayInternal * internalNode;
 
-        std::shared_ptr<GainNode> splitterGain;
-        std::shared_ptr<GainNode> wetGain;
-        std::shared_ptr<GainNode> feedbackGain;
+        float tempo;
+        int noteDivision;
+        std::vector<float> times;
 
-        std::shared_ptr<ChannelMergerNode> merger;
-        std::shared_ptr<ChannelSplitterNode> splitter;
+        void recomputeDelay();
 
     public:
 
@@ -51,8 +55,6 @@ namespace lab
         void SetFeedback(float f);
         void SetLevel(float f);
         void SetDelayIndex(TempoSync value);
-
-        virtual void BuildSubgraph(std::unique_ptr<AudioContext> & ac) override;
     };
 }
 
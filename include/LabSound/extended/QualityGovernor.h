@@ -0,0 +1,137 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#pragma once
+
+#ifndef QUALITY_GOVERNOR_H
+#define QUALITY_GOVERNOR_H
+
+#include "LabSound/core/AudioNode.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace lab
+{
+    class AudioContext;
+    class AnalyserNode;
+    class AudioBus;
+    class ConvolverNode;
+    class PannerNode;
+
+    // Adaptive quality control under CPU pressure. The destination's callback
+    // watchdog reports how much of each callback's deadline the render
+    // consumed; the governor reads those counters on update() and, when
+    // headroom shrinks, steps the governed nodes down a quality tier: HRTF
+    // panners fall back to equal-power panning, convolver impulse responses
+    // are truncated (with a short fade at the cut), and analyser FFT sizes
+    // are reduced. When load stays low the original quality is restored.
+    // Hysteresis - separate thresholds and separate consecutive-update counts
+    // for stepping down and up - keeps the governor from oscillating at a
+    // boundary.
+    //
+    // The governor only touches nodes handed to it, so content that must not
+    // degrade is simply never registered. Call update() periodically from the
+    // application thread (once per frame or so); all methods are intended for
+    // that one thread.
+    class QualityGovernor
+    {
+    public:
+        enum class Tier : int
+        {
+            Full = 0,     // everything at authored quality
+            Reduced = 1,  // equal-power panning, shortened reverb tails, half-size analysis
+            Minimum = 2,  // shortest tails, quarter-size analysis
+        };
+
+        struct Policy
+        {
+            // Load is callback duration as a fraction of the deadline,
+            // averaged over the callbacks observed since the last update().
+            float degradeLoad = 0.75f;  // step down when recent load exceeds this
+            float restoreLoad = 0.45f;  // step up when recent load falls below this
+            int degradeUpdates = 2;     // consecutive over-budget updates required
+            int restoreUpdates = 8;     // consecutive under-budget updates required
+
+            // Which levers the governor may pull.
+            bool stepPanners = true;
+            bool truncateConvolvers = true;
+            bool reduceAnalysers = true;
+
+            // Convolver tail caps per degraded tier, in seconds.
+            float reducedTailSeconds = 0.5f;
+            float minimumTailSeconds = 0.15f;
+        };
+
+        QualityGovernor(std::shared_ptr<AudioContext> context);
+        QualityGovernor(std::shared_ptr<AudioContext> context, Policy policy);
+        ~QualityGovernor();
+
+        // Hands a node to the governor. The node's current quality (panning
+        // model, impulse response, FFT size) is recorded as the value to
+        // restore at Tier::Full. Nodes are held weakly; a released node is
+        // forgotten on the next tier change.
+        void governPanner(std::shared_ptr<PannerNode> panner);
+        void governConvolver(std::shared_ptr<ConvolverNode> convolver);
+        void governAnalyser(std::shared_ptr<AnalyserNode> analyser);
+
+        // Reads the callback counters accumulated since the previous call and
+        // steps the tier when the hysteresis conditions are met.
+        void update();
+
+        Tier tier() const { return m_tier; }
+
+        // Mean callback load observed by the most recent update(); zero until
+        // a callback has been observed.
+        float recentLoad() const { return m_recentLoad; }
+
+        // Applies a tier directly, bypassing the load logic - for a pause
+        // menu, a cutscene, or testing. update() continues from the new tier.
+        void setTier(Tier tier);
+
+        // Invoked after the governed nodes have been stepped to a new tier,
+        // with the load reading that triggered the change.
+        void setTierChangedCallback(std::function<void(Tier, float load)> callback);
+
+    private:
+        void applyTier(Tier tier);
+
+        struct GovernedPanner
+        {
+            std::weak_ptr<PannerNode> node;
+            PanningMode originalModel;
+        };
+
+        struct GovernedConvolver
+        {
+            std::weak_ptr<ConvolverNode> node;
+            std::shared_ptr<AudioBus> originalImpulse;
+            float appliedTailSeconds = 0.f;  // zero while untruncated
+        };
+
+        struct GovernedAnalyser
+        {
+            std::weak_ptr<AnalyserNode> node;
+            size_t originalFftSize;
+        };
+
+        std::shared_ptr<AudioContext> m_context;
+        Policy m_policy;
+        Tier m_tier = Tier::Full;
+        float m_recentLoad = 0.f;
+        int m_overBudgetUpdates = 0;
+        int m_underBudgetUpdates = 0;
+        uint64_t m_previousHistogram[16] = {};
+        bool m_haveBaseline = false;
+
+        std::vector<GovernedPanner> m_panners;
+        std::vector<GovernedConvolver> m_convolvers;
+        std::vector<GovernedAnalyser> m_analysers;
+
+        std::function<void(Tier, float)> m_tierChangedCallback;
+    };
+
+}
+
+#endif
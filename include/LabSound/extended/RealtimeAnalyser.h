@@ -7,6 +7,7 @@
 
 #include "LabSound/core/AudioArray.h"
 #include "LabSound/extended/AudioContextLock.h"
+#include <memory>
 #include <vector>
 
 namespace lab 
@@ -39,11 +40,40 @@ public:
     void setSmoothingTimeConstant(double k) { m_smoothingTimeConstant = k; }
     double smoothingTimeConstant() const { return m_smoothingTimeConstant; }
 
+    // Analysis decimation: with n > 1, a getter re-runs the FFT only once at
+    // least n render quanta of new samples have arrived; in between it serves
+    // the previous magnitude data. A visualizer drawing at 30 fps against a
+    // faster render clock skips the redundant analyses entirely. 1 (the
+    // default) analyses on every getter call, as before.
+    void setAnalysisDecimation(uint32_t n) { m_analysisDecimation = n > 0 ? n : 1; }
+    uint32_t analysisDecimation() const { return m_analysisDecimation; }
+
     void getFloatFrequencyData(std::vector<float>&);
     void getByteFrequencyData(std::vector<uint8_t>&);
     void getFloatTimeDomainData(std::vector<float>&); // LabSound
     void getByteTimeDomainData(std::vector<uint8_t>&);
 
+    // A borrowed, zero-copy view of the most recent fftSize time-domain
+    // samples: up to two contiguous spans into the input ring, oldest samples
+    // first, split where the ring wraps. An oscilloscope-style display can
+    // render straight from the spans without staging a copy per refresh per
+    // analyser. The view borrows the ring's storage, so it is only valid on
+    // the consumer thread and only until the next call that drains the ring
+    // (any getter above, or another view); a caller that needs contiguous or
+    // longer-lived samples falls back to getFloatTimeDomainData.
+    struct TimeDomainView
+    {
+        const float * first = nullptr;   // older samples
+        size_t firstLength = 0;
+        const float * second = nullptr;  // newer samples after the ring wrap, or null
+        size_t secondLength = 0;
+        size_t length() const { return firstLength + secondLength; }
+    };
+    TimeDomainView floatTimeDomainView();
+
+    // Called from the render thread. Publishes the (down-mixed) samples into
+    // a lock-free queue and returns; the windowing, FFT and dB conversion all
+    // run on whichever thread calls the getters above.
     void writeInput(ContextRenderLock& r, AudioBus*, size_t framesToProcess);
 
     static const double DefaultSmoothingTimeConstant;
@@ -57,14 +87,28 @@ public:
 
 private:
 
-    // The audio thread writes the input audio here.
+    // Holds the render-thread -> consumer-thread sample queue; defined in the
+    // translation unit so the queue implementation stays out of this header.
+    struct Internals;
+    std::unique_ptr<Internals> m_internals;
+
+    // The consumer thread drains queued samples into this ring; only consumer
+    // threads touch it, so the analysis code below reads it without racing
+    // the render thread.
     AudioFloatArray m_inputBuffer;
     size_t m_writeIndex;
-    
+    void drainInputQueue();
+
     uint32_t m_fftSize;
     std::unique_ptr<FFTFrame> m_analysisFrame;
     void doFFTAnalysis();
-    
+
+    // Samples drained since the last FFT; doFFTAnalysis() serves the cached
+    // magnitudes until m_analysisDecimation quanta worth have accumulated.
+    uint32_t m_analysisDecimation{1};
+    size_t m_samplesSinceAnalysis{0};
+    bool m_haveAnalysis{false};
+
     // doFFTAnalysis() stores the floating-point magnitude analysis data here.
     AudioFloatArray m_magnitudeBuffer;
     AudioFloatArray& magnitudeBuffer() { return m_magnitudeBuffer; }
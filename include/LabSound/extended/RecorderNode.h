@@ -6,48 +6,93 @@
 
 #include "LabSound/core/AudioBasicInspectorNode.h"
 #include "LabSound/core/AudioContext.h"
-#include <vector>
+#include <atomic>
+#include <cstdio>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace lab
 {
-    
+
+    // Captured samples flow from the render callback through a preallocated
+    // single-producer single-consumer ring into a writer thread, so recording
+    // costs the callback a bounded copy - no locks, no allocation - regardless
+    // of session length. The writer thread either accumulates in memory for
+    // getData()/writeRecordingToWav(), or streams to a WAV file opened with
+    // startRecording(filename, ...), patching the header sizes when recording
+    // stops so stopping is effectively instantaneous for the caller.
     class RecorderNode : public AudioBasicInspectorNode
     {
-        
+
     public:
-        
+
         RecorderNode();
         virtual ~RecorderNode();
-        
+
         // AudioNode
         virtual void process(ContextRenderLock &, size_t framesToProcess) override;
         virtual void reset(ContextRenderLock &) override;
-        
-        void startRecording() { m_recording = true; }
-        void stopRecording() { m_recording = false; }
-        
+
+        // Captured data accumulates in memory until getData() or
+        // writeRecordingToWav() collects it.
+        void startRecording();
+
+        // Captured data streams incrementally to filenameWithWavExtension;
+        // stopRecording() finalizes the file on the writer thread. The file
+        // is 32 bit float WAV, or 16 bit PCM when sixteenBit is set, in which
+        // case the conversion (SIMD, TPDF dithered) also happens on the
+        // writer thread as data streams through - stopping never waits on a
+        // whole-recording conversion pass.
+        void startRecording(const std::string & filenameWithWavExtension, int channels, float sampleRate, bool sixteenBit = false);
+
+        void stopRecording();
+
         void mixToMono(bool m) { m_mixToMono = m; }
 
         // replaces result with the currently recorded data.
         // saved data is cleared.
         void getData(std::vector<float> & result);
-        
+
         void writeRecordingToWav(int channels, const std::string & filenameWithWavExtension);
-        
+
+        // Frames dropped because the ring filled, which only happens if the
+        // writer thread stalls for several seconds (e.g. a hung disk).
+        uint64_t recordingOverruns() const { return m_overrunFrames.load(std::memory_order_relaxed); }
+
+        virtual void queryMemory(ContextRenderLock & r, MemoryUsage & usage) const override;
+
     private:
-        
+
         virtual double tailTime(ContextRenderLock & r) const override { return 0; }
         virtual double latencyTime(ContextRenderLock & r) const override { return 0; }
 
+        void writerThread();
+
         bool m_mixToMono{ false };
-        bool m_recording{ false };
+        std::atomic<bool> m_recording{ false };
 
-        std::vector<float> m_data; // interleaved
-        mutable std::recursive_mutex m_mutex;
+        // SPSC ring of interleaved samples. The render thread owns the write
+        // index, the writer thread the read index; both only advance.
+        std::vector<float> m_ring;
+        std::atomic<uint64_t> m_ringWrite{ 0 };
+        std::atomic<uint64_t> m_ringRead{ 0 };
+        std::atomic<uint64_t> m_overrunFrames{ 0 };
 
+        std::atomic<bool> m_writerShouldRun{ true };
+        std::thread m_writerThread;
+
+        // Guards everything below; taken by the writer thread and API calls,
+        // never by the render thread.
+        mutable std::mutex m_controlMutex;
+        std::vector<float> m_data;  // interleaved, in-memory accumulation
+        FILE * m_file = nullptr;
+        uint64_t m_bytesStreamed = 0;
+        bool m_finalizeRequested = false;
+        bool m_streamInt16 = false;
     };
-    
-} // end namespace lab
+
+}  // end namespace lab
 
 #endif
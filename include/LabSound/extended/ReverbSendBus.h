@@ -0,0 +1,79 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#pragma once
+
+#ifndef REVERB_SEND_BUS_H
+#define REVERB_SEND_BUS_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lab
+{
+    class AudioBus;
+    class AudioContext;
+    class AudioNode;
+    class AudioParam;
+    class ConvolverNode;
+    class GainNode;
+
+    // A shared reverb send. Spatializing many sources with one ConvolverNode
+    // each runs the convolution engine once per source; a send bus instead
+    // taps each source through a per-source send gain into a single shared
+    // convolver, collapsing N convolutions into one plus N gains. The send
+    // gains feed one summing junction, whose mix pass is already vectorized,
+    // and each send level is an AudioParam, so it can be automated or driven
+    // sample-accurately like any other param.
+    //
+    // The bus carries only the wet path. A source keeps its existing dry
+    // connection into the mix; its dry/wet balance is its direct gain against
+    // its send level. Connect output() (the wet return, with its own level
+    // param) wherever the reverb should land in the mix.
+    class ReverbSendBus
+    {
+    public:
+        ReverbSendBus(std::shared_ptr<AudioContext> context);
+        ~ReverbSendBus();
+
+        // The shared convolver's impulse response; see ConvolverNode.
+        void setImpulse(std::shared_ptr<AudioBus> impulse);
+        void setNormalize(bool normalize);
+
+        // Registers a source with the bus at the given send level.
+        // Returns a send id.
+        int addSend(std::shared_ptr<AudioNode> source, float level = 1.f);
+        void removeSend(int id);
+
+        // The per-source send level; sample-accurate, connectable to drivers.
+        std::shared_ptr<AudioParam> sendLevel(int id) const;
+
+        // The wet return level applied after the convolver.
+        std::shared_ptr<AudioParam> returnLevel() const;
+
+        // The wet output. Connect this to the mix destination.
+        std::shared_ptr<GainNode> output() const { return m_returnGain; }
+
+        std::shared_ptr<ConvolverNode> convolver() const { return m_convolver; }
+
+    private:
+        struct Send
+        {
+            int id = 0;
+            std::shared_ptr<AudioNode> source;
+            std::shared_ptr<GainNode> gain;
+        };
+
+        std::shared_ptr<AudioContext> m_context;
+        std::shared_ptr<ConvolverNode> m_convolver;
+        std::shared_ptr<GainNode> m_returnGain;
+
+        mutable std::mutex m_sendMutex;
+        std::vector<Send> m_sends;
+        int m_nextSendId = 1;
+    };
+
+}  // namespace lab
+
+#endif  // REVERB_SEND_BUS_H
@@ -7,42 +7,40 @@
 #define SAMPLED_INSTRUMENT_NODE
 
 #include "LabSound/core/AudioContext.h"
-#include "LabSound/core/AudioNode.h"
-#include "LabSound/core/AudioParam.h"
+#include "LabSound/core/GainNode.h"
 #include "LabSound/core/SampledAudioNode.h"
 
-#include "LabSound/extended/ADSRNode.h"
 #include "LabSound/extended/AudioContextLock.h"
+#include "LabSound/extended/VoicePool.h"
 
-#include <iostream> 
 #include <array>
-#include <string>
 #include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
-/*
-namespace lab 
+namespace lab
 {
-    struct SamplerSound;
-
-    // Ex: F#6. Assumes uppercase note names, hash symbol for sharp, and octave. 
-    inline uint8_t MakeMIDINoteFromString(std::string noteName) 
+    // Ex: F#6. Assumes uppercase note names, hash symbol for sharp, and octave.
+    inline uint8_t MakeMIDINoteFromString(std::string noteName)
     {
-        const std::array<std::string, 12> midiTranslationArray = {{ "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" }};
+        const std::array<std::string, 12> midiTranslationArray = {{"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"}};
 
-        // Ocatve is always last character, as an integer 
+        // Octave is always last character, as an integer
         std::string octaveString = noteName.substr(noteName.length() - 1, 1);
         int octave = std::stoi(octaveString);
 
-        std::string noteString = noteName.erase(noteName.length() - 1, 1); 
+        std::string noteString = noteName.erase(noteName.length() - 1, 1);
 
         std::transform(noteString.begin(), noteString.end(), noteString.begin(), ::toupper);
 
-        // IF we don't use # notation, convert S to #
+        // If we don't use # notation, convert S to #
         std::replace(noteString.begin(), noteString.end(), 'S', '#');
 
-        // Note name is now the first or second character 
+        // Note name is now the first or second character
         int notePos = -1;
-        for (int i = 0; i < 12; ++i) 
+        for (int i = 0; i < 12; ++i)
         {
             if (noteString == midiTranslationArray[i])
             {
@@ -56,7 +54,7 @@ namespace lab
 
     inline std::string MakeStringFromMIDINote(uint8_t note)
     {
-        const std::array<std::string, 12> midiTranslationArray = {{ "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" }};
+        const std::array<std::string, 12> midiTranslationArray = {{"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"}};
 
         int octave = int(note / 12) - 1;
         int positionInOctave = note % 12;
@@ -64,9 +62,11 @@ namespace lab
         std::string originalNote = midiTranslationArray[positionInOctave];
         std::replace(originalNote.begin(), originalNote.end(), '#', 'S');
 
-        return  (originalNote + std::to_string(octave));
+        return (originalNote + std::to_string(octave));
     }
 
+    // One sampled zone: an encoded audio asset and the key/velocity rectangle
+    // it covers. root is the note the recording plays back untransposed.
     struct SampledInstrumentDefinition
     {
         std::vector<uint8_t> audio;
@@ -74,35 +74,89 @@ namespace lab
         uint8_t root;
         uint8_t min;
         uint8_t max;
+        uint8_t velocityMin = 0;
+        uint8_t velocityMax = 127;
     };
 
-    // This class is a little but subversive of the typical LabSound node pattern. 
-    // Instead of inheriting from a node and injecting samples into an audio buffer,
-    // it internally creates ad-hoc SampledAudioNode(s) and keeps them around
-    // in the graph so long as our gain node has been connected. 
-    class SampledInstrumentNode 
+    // The decoded sample data of one instrument, immutable and shared: load()
+    // decodes a named sample set once process-wide and every instrument
+    // instance - across any number of contexts - references the same busses,
+    // so ten levels instancing the same piano cost one piano of memory.
+    // Zones are kept sorted by key range so a noteOn resolves in O(log n)
+    // rather than a linear scan over the whole set.
+    class InstrumentSampleSet
     {
-        std::vector<std::shared_ptr<SamplerSound>> samples;
-        std::shared_ptr<GainNode> gainNode;
-        std::vector<std::shared_ptr<SampledAudioNode>> voices;
-        const float maxVoiceCount = 24;
-        float sampleRate;
     public:
-        SampledInstrumentNode(AudioContext * ctx, float sampleRate);
+        struct Zone
+        {
+            std::shared_ptr<AudioBus> bus;
+            uint8_t root;
+            uint8_t keyLow;
+            uint8_t keyHigh;
+            uint8_t velocityLow;
+            uint8_t velocityHigh;
+        };
+
+        // Decodes defs into a sample set registered under name. A second load
+        // with the same name returns the already-decoded set without touching
+        // the definitions. The cache holds weak references only, so unloading
+        // is automatic once the last instrument using a set is gone.
+        static std::shared_ptr<const InstrumentSampleSet> load(const std::string & name,
+                                                               const std::vector<SampledInstrumentDefinition> & defs);
+
+        // Binary search by key, then the (few) velocity layers of that key.
+        // Returns nullptr if no zone covers the note.
+        const Zone * find(int midiNoteNumber, int velocity) const;
+
+        size_t zoneCount() const { return m_zones.size(); }
+
+    private:
+        InstrumentSampleSet() = default;
+        std::vector<Zone> m_zones;  // sorted by (keyHigh, velocityHigh)
+    };
+
+    // This class is a little bit subversive of the typical LabSound node
+    // pattern. Instead of inheriting from a node and injecting samples into an
+    // audio buffer, it triggers voices from a VoicePool - pre-built chains that
+    // stay connected to its gain node - so a note-on is an O(1) acquire plus an
+    // O(log n) zone lookup, with no node construction or graph mutation.
+    class SampledInstrumentNode
+    {
+    public:
+        SampledInstrumentNode(std::shared_ptr<AudioContext> context,
+                              std::shared_ptr<const InstrumentSampleSet> samples,
+                              size_t voiceCount = 24);
         ~SampledInstrumentNode();
 
-        void LoadInstrument(std::vector<SampledInstrumentDefinition> & sounds);
+        // velocity is MIDI 0-127 and scales the voice gain linearly.
+        void noteOn(ContextRenderLock & r, int midiNoteNumber, int velocity);
+        void noteOff(ContextRenderLock & r, int midiNoteNumber);
+
+        void killAllNotes();
+
+        // Returns voices whose samples have played out to the pool. Call
+        // periodically (e.g. once per game frame).
+        void recycleFinishedVoices();
 
-        void NoteOn(ContextRenderLock & r, const int midiNoteNumber, const float amplitude);
-        void NoteOff(ContextRenderLock & r, const int midiNoteNumber, const float amplitude);
+        std::shared_ptr<GainNode> output() const { return m_output; }
+        std::shared_ptr<const InstrumentSampleSet> samples() const { return m_samples; }
 
-        void KillAllNotes(); 
+    private:
+        struct ActiveNote
+        {
+            VoicePool::Voice * voice;
+            int midiNoteNumber;
+        };
+
+        std::shared_ptr<AudioContext> m_context;
+        std::shared_ptr<const InstrumentSampleSet> m_samples;
+        std::shared_ptr<GainNode> m_output;
+        std::unique_ptr<VoicePool> m_voices;
 
-        GainNode * GetOutputNode() { return gainNode.get(); }
+        std::vector<ActiveNote> m_active;
+        std::mutex m_activeMutex;
     };
 
 }
 
-*/
-
 #endif
@@ -0,0 +1,110 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#pragma once
+
+#ifndef SCENE_SWITCHER_H
+#define SCENE_SWITCHER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lab
+{
+    class AudioContext;
+    class AudioNode;
+    class CrossfadeNode;
+    class GainNode;
+
+    // Warm-standby scene graphs with O(1) switchover. Building the incoming
+    // scene while the outgoing one fades doubles peak audio cost and stalls
+    // the transition on graph construction. SceneSwitcher moves the
+    // construction ahead of the switch: prepareScene() rebuilds a serialized
+    // graph on a background thread, attached to a private root but not to
+    // the render graph, so the switch itself is one queued connection onto
+    // the idle input of a crossfade, a sample-accurate fade trigger, and a
+    // deferred teardown of the outgoing scene once the fade has landed (its
+    // node references go through AudioContext::reclaim, so no destructor
+    // runs on a latency-sensitive thread).
+    //
+    // Immutable payloads are shared rather than copied: sample buses,
+    // impulse responses and periodic waves travel by shared_ptr and are
+    // never written by the nodes rendering them, so a standby scene that
+    // reuses the outgoing scene's assets (handed across in the prepare
+    // callback) references the same storage - copy-on-write sharing in
+    // effect, with construction cost proportional to what is genuinely new.
+    //
+    // All methods are intended for one application thread.
+    class SceneSwitcher
+    {
+    public:
+        // Receives the created nodes, index-aligned with the serialized data
+        // (index 0 is the scene's root). Runs on the builder thread after
+        // the graph is rebuilt and before the scene is marked ready; restore
+        // non-serialized payloads and apply per-scene changes here.
+        using PrepareScene = std::function<void(AudioContext &, std::vector<std::shared_ptr<AudioNode>> &)>;
+
+        SceneSwitcher(std::shared_ptr<AudioContext> context, float crossfadeSeconds = 0.05f);
+        ~SceneSwitcher();
+
+        // The blend node; connect it to the destination (or a mixer bus) once.
+        std::shared_ptr<AudioNode> output() const;
+
+        // Begins building a scene from serializeGraph() data on a background
+        // thread; the scene stays off the render graph until switchTo(). An
+        // empty graph makes a scene holding only its root, for callers that
+        // build by hand in prepare. Returns an id for the other calls.
+        int prepareScene(std::vector<uint8_t> graph, PrepareScene prepare = {});
+
+        // True once the builder has finished and the scene can be switched to.
+        bool sceneReady(int sceneId) const;
+
+        // Connects the prepared scene behind the crossfade's idle input and
+        // triggers the fade at `when` on the context timeline (0 means the
+        // next processed sample). The outgoing scene is disconnected and
+        // reclaimed once the fade has landed. Returns false when the scene
+        // is unknown, failed to build, or is not ready yet.
+        bool switchTo(int sceneId, double when = 0);
+
+        // Releases a prepared scene that will not be switched to.
+        void discardScene(int sceneId);
+
+    private:
+        struct Scene
+        {
+            std::shared_ptr<GainNode> root;
+            std::vector<std::shared_ptr<AudioNode>> nodes;
+
+            // guarded by m_mutex; ready and failed are terminal
+            bool ready = false;
+            bool failed = false;
+            bool discarded = false;
+        };
+
+        void reclaimScene(Scene & scene);
+
+        std::shared_ptr<AudioContext> m_context;
+        std::shared_ptr<CrossfadeNode> m_crossfade;
+        float m_crossfadeSeconds;
+
+        mutable std::mutex m_mutex;
+        std::map<int, std::shared_ptr<Scene>> m_scenes;  // prepared, not yet active
+        int m_nextSceneId = 1;
+
+        // only touched from the application thread
+        std::shared_ptr<Scene> m_activeScene;
+        int m_activeInput = 0;
+
+        // builder and retirement threads; joined in the destructor
+        std::vector<std::thread> m_threads;
+        std::atomic<bool> m_shuttingDown{false};
+    };
+}
+
+#endif
@@ -11,6 +11,8 @@
 
 namespace lab {
 
+    class AudioBus;
+
     class SfxrNode : public lab::AudioScheduledSourceNode {
     public:
 
@@ -85,6 +87,16 @@ namespace lab {
         void mutate(ContextRenderLock&);
         void randomize(ContextRenderLock&);
 
+        // Renders the current parameter set to completion into a mono
+        // AudioBus, suitable for SampledAudioNode::setBus(). Rendered buses
+        // are cached process-wide keyed by a hash of the parameters, so a UI
+        // firing the same blip thousands of times synthesizes it once and
+        // plays the rest back as table lookups. The cache holds shared
+        // references; clearEffectCache() drops them (buses still in use by a
+        // SampledAudioNode stay alive through their own references).
+        std::shared_ptr<AudioBus> renderToBus(ContextRenderLock&);
+        static void clearEffectCache();
+
     private:
         virtual bool propagatesSilence(ContextRenderLock & r) const override;
 
@@ -0,0 +1,69 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef LABSOUND_SOUNDBANK_H
+#define LABSOUND_SOUNDBANK_H
+
+#include "LabSound/core/AudioBus.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lab
+{
+    // A Soundbank packs many decoded assets into one file of aligned planar
+    // float PCM with a name index, and serves them back at runtime as
+    // AudioBus views directly over memory-mapped pages. Opening a bank does
+    // no decoding and copies no samples: the OS pages data in on first use,
+    // shares the physical pages between processes mapping the same bank, and
+    // evicts them under memory pressure like any other file-backed mapping.
+    //
+    // Busses returned by bus() reference the mapping and keep the bank alive;
+    // they are read-only by convention and must not be written through
+    // mutableData().
+    //
+    // Banks are produced offline with write(), typically by decoding each
+    // source asset through MakeBusFromFile and handing the busses here.
+    class Soundbank : public std::enable_shared_from_this<Soundbank>
+    {
+        class Mapping;
+
+    public:
+        ~Soundbank();
+
+        // Memory-map the bank at path. Returns an empty pointer if the file
+        // cannot be mapped or is not a valid bank.
+        static std::shared_ptr<Soundbank> open(const std::string & path);
+
+        // Pack named busses into a bank file. Channel data is written 64-byte
+        // aligned so mapped views satisfy SIMD alignment. Returns false on
+        // i/o failure or if assets is empty.
+        static bool write(const std::string & path,
+                          const std::vector<std::pair<std::string, std::shared_ptr<AudioBus>>> & assets);
+
+        // A zero-copy view over the named asset's samples in the mapping, or
+        // an empty pointer if the name is not in the bank.
+        std::shared_ptr<AudioBus> bus(const std::string & name) const;
+
+        bool contains(const std::string & name) const;
+        std::vector<std::string> names() const;
+
+    private:
+        Soundbank() = default;
+
+        struct Entry
+        {
+            uint64_t dataOffset;  // byte offset of channel 0; channels are contiguous, each padded to alignment
+            uint64_t frameCount;
+            uint32_t channelCount;
+            float sampleRate;
+        };
+
+        std::unique_ptr<Mapping> m_mapping;
+        std::map<std::string, Entry> m_index;
+    };
+}
+
+#endif
@@ -8,9 +8,12 @@
 
 #include "LabSound/core/PannerNode.h"
 #include <map>
+#include <memory>
 
 namespace lab {
 
+    class Biquad;
+
     struct Occluder 
     {
         float x, y, z;
@@ -56,19 +59,71 @@ namespace lab {
     
     typedef std::shared_ptr<Occluders> OccludersPtr;
 
-    class SpatializationNode : public PannerNode 
+    // One emitter's occlusion result for a physics frame: a broadband
+    // attenuation and an optional lowpass cutoff for the muffling filter
+    // (zero or anything at or above nyquist leaves the signal unfiltered).
+    struct OcclusionResult
+    {
+        float attenuation = 1.f;
+        float lowpassCutoffHz = 0.f;
+    };
+
+    // The whole frame's occlusion results, delivered in one swap. The game
+    // thread stages every emitter's result and then calls publish(), which
+    // atomically replaces the visible set; each SpatializationNode picks up
+    // the latest set at its next quantum boundary. No per-source locking -
+    // one publish per physics tick covers any number of emitters, and the
+    // render thread never blocks on it.
+    class OcclusionBatch
+    {
+    public:
+
+        // Game thread. Stage the full set each frame; publish() hands the
+        // staged results over and starts the next frame empty.
+        void stage(int emitterId, float attenuation, float lowpassCutoffHz = 0.f);
+        void publish();
+
+        // Render thread: the most recently published set, or null before the
+        // first publish.
+        std::shared_ptr<const std::map<int, OcclusionResult>> snapshot() const;
+
+    private:
+
+        std::map<int, OcclusionResult> m_staging;
+        std::shared_ptr<const std::map<int, OcclusionResult>> m_current;
+    };
+
+    class SpatializationNode : public PannerNode
     {
     public:
 
         SpatializationNode(float sampleRate = LABSOUND_DEFAULT_SAMPLERATE);
-        virtual ~SpatializationNode() = default;
+        virtual ~SpatializationNode();
 
         void setOccluders(OccludersPtr ptr);
-        
+
+        // Batch occlusion: this node reads emitterId's entry from the batch
+        // each quantum. Supersedes setOccluders() when set.
+        void setOcclusionBatch(std::shared_ptr<OcclusionBatch> batch, int emitterId);
+
+        virtual void process(ContextRenderLock & r, size_t framesToProcess) override;
+
     private:
 
         virtual float distanceConeGain(ContextRenderLock& r);
         std::shared_ptr<Occluders> occluders;
+
+        std::shared_ptr<OcclusionBatch> occlusionBatch;
+        int emitterId = 0;
+
+        // Render-thread copy of this emitter's result, refreshed once per
+        // quantum from the batch snapshot.
+        OcclusionResult currentOcclusion;
+
+        // Muffling filters, one per output channel, run through the shared
+        // biquad engine; reconfigured only when the cutoff changes.
+        std::unique_ptr<Biquad> occlusionFilter[2];
+        float configuredCutoff = 0.f;
     };
     
 }
@@ -0,0 +1,78 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef STREAM_SOURCE_NODE_H
+#define STREAM_SOURCE_NODE_H
+
+#include "LabSound/core/AudioSourceNode.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace lab
+{
+    // Decodes one encoded network packet (opus, or whatever the application
+    // transports) to interleaved float PCM at the stream's sample rate.
+    // Implementations run on a shared decode worker, never on the render or
+    // network threads, so they may allocate or take their time. One instance
+    // serves one stream - stateful codecs depend on packet order.
+    class StreamPacketDecoder
+    {
+    public:
+        virtual ~StreamPacketDecoder() {}
+
+        // Returns the number of sample-frames written to interleavedDestination,
+        // which has room for maxFrames frames. Return 0 to drop the packet.
+        virtual size_t decode(const uint8_t * data, size_t byteCount,
+                              float * interleavedDestination, size_t maxFrames) = 0;
+    };
+
+    // StreamSourceNode is a first-class source for network audio such as voice
+    // chat, a sibling of AudioHardwareSourceNode for push-model streams.
+    //
+    // Packets are pushed from the network thread into a lock-free queue and
+    // decoded ahead of playback on a worker shared by all streams; the render
+    // thread only ever copies frames out of a ready planar ring. A jitter
+    // depth (default 60 ms) of decoded audio is held back before playback
+    // starts, and re-armed after an underrun, so network timing wobble inside
+    // that window never reaches the output.
+    //
+    // Without a decoder factory the node accepts raw PCM packets only; encoded
+    // packets require a StreamPacketDecoder supplied by the application.
+    class StreamSourceNode : public AudioSourceNode
+    {
+    public:
+
+        StreamSourceNode(const float sampleRate, size_t numberOfChannels,
+                         std::function<std::unique_ptr<StreamPacketDecoder>()> decoderFactory = nullptr);
+        virtual ~StreamSourceNode();
+
+        // Network-thread entry points: enqueue one packet without taking a
+        // lock. False means the jitter queue was full and the packet was
+        // dropped - the stream recovers on its own, this is only a signal for
+        // statistics. pushPcmPacket frames are interleaved at the node's
+        // channel count and sample rate.
+        bool pushEncodedPacket(const uint8_t * data, size_t byteCount);
+        bool pushPcmPacket(const float * interleaved, size_t frames);
+
+        // The number of decoded frames held back before playback begins (and
+        // again after an underrun). Takes effect at the next re-arm.
+        void setJitterFrames(size_t frames);
+        size_t jitterFrames() const;
+
+        // AudioNode
+        virtual void process(ContextRenderLock &, size_t framesToProcess) override;
+        virtual void reset(ContextRenderLock &) override;
+
+    private:
+
+        // As an audio source, we will never propagate silence.
+        virtual bool propagatesSilence(ContextRenderLock & r) const override { return false; }
+
+        struct Internals;
+        std::shared_ptr<Internals> m_internals;
+    };
+}
+
+#endif
@@ -0,0 +1,110 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#pragma once
+
+#ifndef SUBGRAPH_FREEZE_H
+#define SUBGRAPH_FREEZE_H
+
+#include "LabSound/core/AudioNode.h"
+#include "LabSound/core/SampledAudioNode.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace lab
+{
+    class AudioContext;
+
+    // DAW-style subgraph freezing. A static effect chain - unchanging sources
+    // through a fixed processing stack - costs the same every quantum whether
+    // or not anything about it varies. freeze() bounces such a chain to a
+    // buffer offline in the background (an offline context renders on its own
+    // thread while the live graph keeps playing), then swaps the chain out of
+    // the live graph for a SampledAudioNode looping the bounce, in one
+    // connection batch so downstream hears no gap. The frozen chain's nodes
+    // are disconnected and no longer pulled, so the whole stack drops from
+    // per-quantum cost to one sample playback. unfreeze() reverses the swap.
+    //
+    // The offline render needs its own copy of the chain: node graphs can't be
+    // cloned generically (sample buffers, impulse responses and streams are
+    // owned by the application), so the caller passes a builder that
+    // reconstructs the chain inside the offline context - the same code that
+    // built it live, pointed at a different context. The builder returns the
+    // chain's head, which the bounce records from.
+    //
+    // Completed bounces are swapped in from update(); call it periodically
+    // from the application thread (the same cadence as VoiceManager::update
+    // is fine). All methods are intended for that one thread.
+    class SubgraphFreeze
+    {
+    public:
+        // Builds the chain to bounce inside the given (offline) context and
+        // returns its head node; the head is connected to the offline
+        // destination and rendered. Sources the builder starts at time zero
+        // land at the start of the bounce.
+        using SubgraphBuilder = std::function<std::shared_ptr<AudioNode>(AudioContext &)>;
+
+        SubgraphFreeze(std::shared_ptr<AudioContext> context);
+        ~SubgraphFreeze();
+
+        // Begins freezing the live chain whose head is chainHead, currently
+        // connected to output. seconds of the builder's chain are rendered
+        // offline; when the bounce completes, a later update() disconnects
+        // chainHead from output and connects a looping playback of the bounce
+        // in its place. For loops, seconds should be the chain's loop length
+        // so the seam lands on the material's own period. Returns an id for
+        // unfreeze(), or -1 if the arguments can't be frozen.
+        int freeze(std::shared_ptr<AudioNode> chainHead,
+                   std::shared_ptr<AudioNode> output,
+                   SubgraphBuilder builder,
+                   float seconds,
+                   uint32_t numChannels = 2,
+                   bool loop = true);
+
+        // Swaps the original chain back in and drops the bounce. A freeze
+        // whose bounce is still rendering is abandoned instead: the live
+        // graph was never touched, and the offline context is discarded once
+        // its render thread finishes.
+        void unfreeze(int id);
+
+        // Applies completed bounces to the live graph. Returns the number of
+        // freezes swapped in by this call.
+        size_t update();
+
+        // True once the bounce has been swapped into the live graph.
+        bool frozen(int id) const;
+
+        size_t activeFreezes() const { return m_freezes.size(); }
+
+    private:
+        enum class State
+        {
+            Rendering,  // offline bounce in progress, live graph untouched
+            Frozen,     // bounce playing in place of the chain
+        };
+
+        struct FreezeEntry
+        {
+            int id = 0;
+            std::shared_ptr<AudioNode> chainHead;
+            std::shared_ptr<AudioNode> output;
+            std::unique_ptr<AudioContext> offlineContext;
+            std::vector<std::vector<float>> captured;  // one vector per channel
+            std::atomic<bool> renderComplete{ false };
+            std::shared_ptr<SampledAudioNode> bounce;
+            State state = State::Rendering;
+            bool abandoned = false;  // unfrozen while still rendering
+            bool loop = true;
+        };
+
+        std::shared_ptr<AudioContext> m_context;
+        std::vector<std::unique_ptr<FreezeEntry>> m_freezes;
+        int m_nextId = 1;
+    };
+
+}  // namespace lab
+
+#endif  // SUBGRAPH_FREEZE_H
@@ -0,0 +1,105 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#pragma once
+
+#ifndef VOICE_MANAGER_H
+#define VOICE_MANAGER_H
+
+#include "LabSound/core/GainNode.h"
+#include "LabSound/core/PannerNode.h"
+#include "LabSound/core/SampledAudioNode.h"
+
+#include "LabSound/extended/MeteringEngine.h"
+
+#include <memory>
+#include <vector>
+
+namespace lab
+{
+    class AudioContext;
+
+    // Audibility-driven voice budgeting. Registered voices are ranked each
+    // control period by effective audibility: the post-gain power of the
+    // voice's gain node (read from one shared MeteringEngine tap, so ranking
+    // a hundred voices costs one batched metering pass, not a hundred node
+    // pulls) attenuated by the panner's computed distance and cone gains.
+    // Voices ranked beyond the budget are faded out over fadeSeconds and
+    // then parked: the source stops rendering but its playback position
+    // keeps advancing virtually (see SampledAudioNode::setParked), so a
+    // revived voice resumes mid-phrase. Worst-case render cost is therefore
+    // bounded by the budget no matter how many sounds gameplay triggers.
+    //
+    // A parked voice renders silence, so its tap reads nothing; it is ranked
+    // by what it could contribute - the gain it will be revived at times the
+    // panner attenuation, assuming full-scale program - minus reviveMarginDb
+    // of hysteresis, so a parked voice must clearly out-rank an audible one
+    // to displace it.
+    //
+    // Voices are held weakly; a released chain is forgotten on the next
+    // update(). Call update() periodically from the application thread (once
+    // per game frame or so); all methods are intended for that one thread.
+    class VoiceManager
+    {
+    public:
+        struct Policy
+        {
+            size_t maxAudibleVoices = 32;  // voices allowed to render
+            float fadeSeconds = 0.03f;     // park and revive gain ramp
+            float reviveMarginDb = 3.f;    // how decisively a parked voice must win
+        };
+
+        VoiceManager(std::shared_ptr<AudioContext> context);
+        VoiceManager(std::shared_ptr<AudioContext> context, Policy policy);
+        ~VoiceManager();
+
+        // Registers a source -> gain -> panner chain (the VoicePool layout).
+        // The gain node must be rendered by the graph (connected, directly or
+        // transitively, to the destination) for its tap to read anything.
+        // panner may be null for non-spatialized voices, which then rank by
+        // post-gain power alone. Returns an id for unmanage().
+        int manage(std::shared_ptr<SampledAudioNode> source,
+                   std::shared_ptr<GainNode> gain,
+                   std::shared_ptr<PannerNode> panner);
+
+        // Forgets the voice, reviving it first if it was parked.
+        void unmanage(int id);
+
+        // Ranks every managed voice and parks or revives to meet the budget.
+        void update();
+
+        size_t audibleVoices() const;
+        size_t parkedVoices() const;
+        size_t managedVoices() const { return m_voices.size(); }
+
+    private:
+        enum class State
+        {
+            Audible,    // rendering normally
+            FadingOut,  // gain ramping to zero ahead of the park
+            Parked,     // source emits silence, position advances virtually
+        };
+
+        struct ManagedVoice
+        {
+            int id = 0;
+            std::weak_ptr<SampledAudioNode> source;
+            std::weak_ptr<GainNode> gain;
+            std::weak_ptr<PannerNode> panner;
+            int tapId = -1;
+            State state = State::Audible;
+            double parkAtTime = 0;      // context time the fade-out completes
+            float restoreGain = 1.f;    // gain param value to revive at
+            float audibilityDb = -120.f;
+        };
+
+        std::shared_ptr<AudioContext> m_context;
+        Policy m_policy;
+        std::unique_ptr<MeteringEngine> m_metering;
+        std::vector<ManagedVoice> m_voices;
+        int m_nextId = 1;
+    };
+
+}  // namespace lab
+
+#endif  // VOICE_MANAGER_H
@@ -0,0 +1,78 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#pragma once
+
+#ifndef VOICE_POOL_H
+#define VOICE_POOL_H
+
+#include "LabSound/core/GainNode.h"
+#include "LabSound/core/PannerNode.h"
+#include "LabSound/core/SampledAudioNode.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lab
+{
+    class AudioContext;
+
+    // A fixed pool of pre-built source -> gain -> panner voice chains for
+    // one-shot sounds. Constructing and connecting three nodes per trigger is
+    // the dominant main-thread cost of dense sound effects; with a pool, the
+    // chains are built and connected once and a trigger is an O(1) acquire
+    // with no allocation and no graph mutation.
+    //
+    // Voices stay connected to the output at all times. The per-voice gain
+    // node doubles as a mute gate: release() closes it, acquire() re-opens it
+    // at unity, so an idle voice contributes silence (and, because a finished
+    // source propagates silence, almost no processing cost).
+    class VoicePool
+    {
+    public:
+        struct Voice
+        {
+            std::shared_ptr<SampledAudioNode> source;
+            std::shared_ptr<GainNode> gain;
+            std::shared_ptr<PannerNode> panner;
+        };
+
+        // Pre-builds count voice chains and queues their connections to
+        // output. The pool must outlive any voices still playing.
+        VoicePool(std::shared_ptr<AudioContext> context, size_t count, std::shared_ptr<AudioNode> output,
+                  const std::string & hrtfSearchPath = "");
+        ~VoicePool();
+
+        // O(1) and allocation-free; returns nullptr when all voices are busy.
+        // The caller typically follows with setBus() on the source under a
+        // ContextRenderLock, then start().
+        Voice * acquire();
+
+        // Returns a voice to the pool: closes the gate and resets the chain's
+        // processing state so the source can be scheduled again. Safe to call
+        // from the event-dispatch thread (e.g. an onEnded handler); must not
+        // be called from the render thread.
+        void release(Voice * voice);
+
+        // Releases every busy voice whose source has finished playing. Call
+        // periodically (e.g. once per game frame) for fire-and-forget sounds.
+        void recycleFinishedVoices();
+
+        size_t voiceCount() const { return m_voices.size(); }
+        size_t availableVoices() const;
+
+    private:
+        std::shared_ptr<AudioContext> m_context;
+        std::shared_ptr<AudioNode> m_output;
+
+        std::vector<Voice> m_voices;
+        std::vector<bool> m_busy;
+        std::vector<size_t> m_freeList;  // indices into m_voices, used as a stack
+
+        mutable std::mutex m_mutex;
+    };
+
+}  // namespace lab
+
+#endif  // VOICE_POOL_H
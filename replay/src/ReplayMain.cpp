@@ -0,0 +1,515 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+// labsound_replay
+//
+// Deterministic offline replay harness for performance regression and output
+// divergence. Each scenario is a scripted graph description rendered through
+// OfflineAudioDestinationNode at a fixed sample rate; the harness reports an
+// FNV-1a hash over the rendered waveform, the wall time spent rendering, and
+// the per-node timing from the profiling surface. Comparing hashes between
+// two builds catches DSP output divergence; comparing timings catches
+// performance regressions. Registered as a CTest target, where a run passes
+// when every scenario parses, settles and renders.
+//
+//     labsound_replay                      run the built-in corpus
+//     labsound_replay graph.txt ...        run scripted scenarios instead
+//     labsound_replay --json results.json  also write results as JSON
+//
+// Script format, one command per line ('#' starts a comment):
+//
+//     duration 2.0
+//     channels 2
+//     node osc1 oscillator type=square freq=220 detune=0
+//     node lp biquad type=lowpass freq=1200 q=1.2 gain=0
+//     node g gain gain=0.5
+//     node n noise type=pink
+//     node d delay time=0.25 maxdelay=1.0
+//     node c compressor
+//     connect g osc1
+//     connect destination g
+//     start osc1 0.0
+//     stop osc1 1.5
+//
+// Reproducibility notes: node ids (which seed the noise generators) are
+// assigned process-globally in creation order, so the corpus is reproducible
+// run to run because scenarios always execute in the same order. Hashes are
+// over exact float bit patterns and are comparable between builds on the
+// same platform and instruction set, not across them.
+
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/AudioBus.h"
+#include "LabSound/core/BiquadFilterNode.h"
+#include "LabSound/core/DelayNode.h"
+#include "LabSound/core/DynamicsCompressorNode.h"
+#include "LabSound/core/GainNode.h"
+#include "LabSound/core/OfflineAudioDestinationNode.h"
+#include "LabSound/core/OscillatorNode.h"
+
+#include "LabSound/extended/AudioContextLock.h"
+#include "LabSound/extended/NoiseNode.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace lab;
+
+namespace
+{
+
+const float kSampleRate = 44100.f;
+const size_t kQuantumFrames = 128;  // AudioNode::ProcessingSizeInFrames
+
+struct ReplayResult
+{
+    std::string name;
+    uint64_t hash = 0;
+    uint64_t quanta = 0;
+    double renderMilliseconds = 0;
+    bool ok = false;
+};
+
+// ------------------------------------------------------------- script parsing
+
+// "key=value" arguments on a node line.
+std::map<std::string, std::string> parseArgs(std::istringstream & line)
+{
+    std::map<std::string, std::string> args;
+    std::string token;
+    while (line >> token)
+    {
+        size_t eq = token.find('=');
+        if (eq == std::string::npos)
+            throw std::runtime_error("expected key=value, got '" + token + "'");
+        args[token.substr(0, eq)] = token.substr(eq + 1);
+    }
+    return args;
+}
+
+float argFloat(const std::map<std::string, std::string> & args, const char * key, float fallback)
+{
+    auto it = args.find(key);
+    return it == args.end() ? fallback : std::stof(it->second);
+}
+
+std::string argString(const std::map<std::string, std::string> & args, const char * key, const char * fallback)
+{
+    auto it = args.find(key);
+    return it == args.end() ? fallback : it->second;
+}
+
+OscillatorType oscillatorTypeFromString(const std::string & s)
+{
+    if (s == "sine") return OscillatorType::SINE;
+    if (s == "square") return OscillatorType::SQUARE;
+    if (s == "sawtooth") return OscillatorType::SAWTOOTH;
+    if (s == "triangle") return OscillatorType::TRIANGLE;
+    throw std::runtime_error("unknown oscillator type '" + s + "'");
+}
+
+FilterType filterTypeFromString(const std::string & s)
+{
+    if (s == "lowpass") return LOWPASS;
+    if (s == "highpass") return HIGHPASS;
+    if (s == "bandpass") return BANDPASS;
+    if (s == "lowshelf") return LOWSHELF;
+    if (s == "highshelf") return HIGHSHELF;
+    if (s == "peaking") return PEAKING;
+    if (s == "notch") return NOTCH;
+    if (s == "allpass") return ALLPASS;
+    throw std::runtime_error("unknown filter type '" + s + "'");
+}
+
+NoiseNode::NoiseType noiseTypeFromString(const std::string & s)
+{
+    if (s == "white") return NoiseNode::WHITE;
+    if (s == "pink") return NoiseNode::PINK;
+    if (s == "brown") return NoiseNode::BROWN;
+    throw std::runtime_error("unknown noise type '" + s + "'");
+}
+
+std::shared_ptr<AudioNode> makeNode(const std::string & type, const std::map<std::string, std::string> & args)
+{
+    if (type == "oscillator")
+    {
+        auto node = std::make_shared<OscillatorNode>(kSampleRate);
+        node->setType(oscillatorTypeFromString(argString(args, "type", "sine")));
+        node->frequency()->setValue(argFloat(args, "freq", 440.f));
+        node->detune()->setValue(argFloat(args, "detune", 0.f));
+        return node;
+    }
+    if (type == "gain")
+    {
+        auto node = std::make_shared<GainNode>();
+        node->gain()->setValue(argFloat(args, "gain", 1.f));
+        return node;
+    }
+    if (type == "biquad")
+    {
+        auto node = std::make_shared<BiquadFilterNode>();
+        node->setType(filterTypeFromString(argString(args, "type", "lowpass")));
+        node->frequency()->setValue(argFloat(args, "freq", 350.f));
+        node->q()->setValue(argFloat(args, "q", 0.707f));
+        node->gain()->setValue(argFloat(args, "gain", 0.f));
+        return node;
+    }
+    if (type == "delay")
+    {
+        auto node = std::make_shared<DelayNode>(kSampleRate, argFloat(args, "maxdelay", 1.f));
+        node->delayTime()->setValue(argFloat(args, "time", 0.1f));
+        return node;
+    }
+    if (type == "noise")
+    {
+        auto node = std::make_shared<NoiseNode>();
+        node->setType(noiseTypeFromString(argString(args, "type", "white")));
+        return node;
+    }
+    if (type == "compressor")
+    {
+        return std::make_shared<DynamicsCompressorNode>();
+    }
+    throw std::runtime_error("unknown node type '" + type + "'");
+}
+
+// ---------------------------------------------------------------- the harness
+
+uint64_t fnv1a(uint64_t hash, const float * data, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint32_t bits;
+        memcpy(&bits, &data[i], sizeof(bits));
+        for (int b = 0; b < 4; ++b)
+        {
+            hash ^= (bits >> (b * 8)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+ReplayResult runScenario(const std::string & name, const std::string & script)
+{
+    ReplayResult result;
+    result.name = name;
+
+    double duration = 2.0;
+    int channels = 2;
+
+    std::map<std::string, std::shared_ptr<AudioNode>> nodes;
+    std::vector<AudioContext::ConnectionOperation> connections;
+    std::vector<std::pair<std::shared_ptr<AudioScheduledSourceNode>, double>> starts;
+    std::vector<std::pair<std::shared_ptr<AudioScheduledSourceNode>, double>> stops;
+
+    AudioContext context(true);
+
+    auto lookup = [&](const std::string & nodeName) -> std::shared_ptr<AudioNode> {
+        if (nodeName == "destination")
+            return context.destination();
+        auto it = nodes.find(nodeName);
+        if (it == nodes.end())
+            throw std::runtime_error("unknown node '" + nodeName + "'");
+        return it->second;
+    };
+
+    auto lookupScheduled = [&](const std::string & nodeName) {
+        auto node = std::dynamic_pointer_cast<AudioScheduledSourceNode>(lookup(nodeName));
+        if (!node)
+            throw std::runtime_error("'" + nodeName + "' is not a scheduled source");
+        return node;
+    };
+
+    // Two passes over the script: duration and channels size the destination,
+    // which must exist before connect lines can reference it.
+    std::istringstream prescan(script);
+    std::string lineText;
+    while (std::getline(prescan, lineText))
+    {
+        std::istringstream line(lineText.substr(0, lineText.find('#')));
+        std::string command;
+        if (!(line >> command))
+            continue;
+        if (command == "duration")
+            line >> duration;
+        else if (command == "channels")
+            line >> channels;
+    }
+
+    auto destination = std::make_shared<OfflineAudioDestinationNode>(&context, kSampleRate, static_cast<float>(duration), channels);
+    context.setDestinationNode(destination);
+    context.lazyInitialize();
+    context.setProfilingEnabled(true);
+
+    std::istringstream stream(script);
+    while (std::getline(stream, lineText))
+    {
+        std::istringstream line(lineText.substr(0, lineText.find('#')));
+        std::string command;
+        if (!(line >> command))
+            continue;
+
+        if (command == "duration" || command == "channels")
+        {
+            // consumed by the prescan
+        }
+        else if (command == "node")
+        {
+            std::string nodeName, type;
+            line >> nodeName >> type;
+            if (nodes.count(nodeName) || nodeName == "destination")
+                throw std::runtime_error("duplicate node name '" + nodeName + "'");
+            nodes[nodeName] = makeNode(type, parseArgs(line));
+        }
+        else if (command == "connect")
+        {
+            std::string dst, src;
+            line >> dst >> src;
+            AudioContext::ConnectionOperation op;
+            op.destination = lookup(dst);
+            op.source = lookup(src);
+            connections.push_back(op);
+        }
+        else if (command == "start")
+        {
+            std::string nodeName;
+            double when = 0;
+            line >> nodeName >> when;
+            starts.push_back({lookupScheduled(nodeName), when});
+        }
+        else if (command == "stop")
+        {
+            std::string nodeName;
+            double when = 0;
+            line >> nodeName >> when;
+            stops.push_back({lookupScheduled(nodeName), when});
+        }
+        else
+        {
+            throw std::runtime_error("unknown command '" + command + "'");
+        }
+    }
+
+    context.applyConnectionBatch(connections);
+    for (auto & s : starts) s.first->start(s.second);
+    for (auto & s : stops) s.first->stop(s.second);
+
+    // The graph update thread applies connections asynchronously; rendering
+    // before they all land would make the output depend on thread timing.
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (context.hasPendingUpdates())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+                throw std::runtime_error("graph did not settle within 10 seconds");
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    const uint64_t quanta = static_cast<uint64_t>(std::ceil(duration * kSampleRate / kQuantumFrames));
+    AudioBus bus(channels, kQuantumFrames);
+
+    uint64_t hash = 14695981039346656037ull;
+    auto renderStart = std::chrono::steady_clock::now();
+    for (uint64_t q = 0; q < quanta; ++q)
+    {
+        destination->render(nullptr, &bus, kQuantumFrames);
+        for (int c = 0; c < channels; ++c)
+            hash = fnv1a(hash, bus.channel(c)->data(), kQuantumFrames);
+    }
+    auto renderEnd = std::chrono::steady_clock::now();
+
+    result.hash = hash;
+    result.quanta = quanta;
+    result.renderMilliseconds = std::chrono::duration<double, std::milli>(renderEnd - renderStart).count();
+    result.ok = true;
+
+    printf("%-24s hash %016llx  %5.2f s  %6llu quanta  rendered in %8.2f ms\n",
+           name.c_str(), (unsigned long long) result.hash, duration,
+           (unsigned long long) quanta, result.renderMilliseconds);
+
+    // The snapshot carries the class names alongside the profiling counters,
+    // so the timing table needs no live node pointers.
+    AudioContext::GraphSnapshot snapshot;
+    {
+        ContextRenderLock r(&context, "labsound_replay profile");
+        snapshot = context.graphSnapshot(r);
+    }
+    std::sort(snapshot.nodes.begin(), snapshot.nodes.end(),
+              [](const AudioContext::GraphSnapshot::Node & a, const AudioContext::GraphSnapshot::Node & b) {
+                  return a.averageMicroseconds * a.profiledQuanta > b.averageMicroseconds * b.profiledQuanta;
+              });
+    size_t shown = std::min<size_t>(snapshot.nodes.size(), 8);
+    for (size_t i = 0; i < shown; ++i)
+    {
+        const auto & node = snapshot.nodes[i];
+        printf("    %-28s %8llu quanta  %8.2f us avg  %6llu us max\n",
+               node.type.c_str(),
+               (unsigned long long) node.profiledQuanta,
+               node.averageMicroseconds,
+               (unsigned long long) node.maxMicroseconds);
+    }
+
+    return result;
+}
+
+// ------------------------------------------------------------ built-in corpus
+
+struct Scenario
+{
+    const char * name;
+    const char * script;
+};
+
+// A fixed corpus exercising the common render paths: wavetable synthesis,
+// filtering, noise generation, delay and dynamics. Scenario order matters
+// for reproducibility (see the note at the top of the file); append rather
+// than reorder.
+const Scenario kCorpus[] = {
+    {"sine-gain",
+     "duration 2.0\n"
+     "channels 2\n"
+     "node osc oscillator type=sine freq=440\n"
+     "node g gain gain=0.5\n"
+     "connect g osc\n"
+     "connect destination g\n"
+     "start osc 0.0\n"},
+
+    {"detuned-saw-mix",
+     "duration 2.0\n"
+     "channels 2\n"
+     "node o1 oscillator type=sawtooth freq=110 detune=-7\n"
+     "node o2 oscillator type=sawtooth freq=110 detune=5\n"
+     "node o3 oscillator type=sawtooth freq=220.5 detune=-3\n"
+     "node o4 oscillator type=sawtooth freq=220.5 detune=9\n"
+     "node lp biquad type=lowpass freq=1800 q=1.4\n"
+     "node g gain gain=0.2\n"
+     "connect lp o1\n"
+     "connect lp o2\n"
+     "connect lp o3\n"
+     "connect lp o4\n"
+     "connect g lp\n"
+     "connect destination g\n"
+     "start o1 0.0\n"
+     "start o2 0.0\n"
+     "start o3 0.1\n"
+     "start o4 0.1\n"},
+
+    {"filtered-noise",
+     "duration 2.0\n"
+     "channels 2\n"
+     "node n noise type=pink\n"
+     "node bp biquad type=bandpass freq=900 q=4\n"
+     "node g gain gain=0.7\n"
+     "connect bp n\n"
+     "connect g bp\n"
+     "connect destination g\n"
+     "start n 0.0\n"
+     "stop n 1.5\n"},
+
+    {"delay-compressor",
+     "duration 3.0\n"
+     "channels 2\n"
+     "node osc oscillator type=square freq=330\n"
+     "node og gain gain=0.4\n"
+     "node d delay time=0.25 maxdelay=0.5\n"
+     "node fb gain gain=0.4\n"
+     "node c compressor\n"
+     "connect og osc\n"
+     "connect d og\n"
+     "connect fb d\n"
+     "connect d fb\n"
+     "connect c og\n"
+     "connect c d\n"
+     "connect destination c\n"
+     "start osc 0.0\n"
+     "stop osc 1.0\n"},
+};
+
+void writeJson(const std::string & path, const std::vector<ReplayResult> & results)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        fprintf(stderr, "labsound_replay: could not open %s for writing\n", path.c_str());
+        return;
+    }
+
+    file << "[\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        char hash[32];
+        snprintf(hash, sizeof(hash), "%016llx", (unsigned long long) results[i].hash);
+        file << "  {\"scenario\": \"" << results[i].name << "\", "
+             << "\"hash\": \"" << hash << "\", "
+             << "\"quanta\": " << results[i].quanta << ", "
+             << "\"render_ms\": " << results[i].renderMilliseconds << "}";
+        if (i + 1 < results.size())
+            file << ",";
+        file << "\n";
+    }
+    file << "]\n";
+
+    printf("\nWrote %zu results to %s\n", results.size(), path.c_str());
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+    std::string jsonPath;
+    std::vector<std::string> scriptPaths;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+            scriptPaths.push_back(argv[i]);
+    }
+
+    std::vector<ReplayResult> results;
+    bool ok = true;
+
+    try
+    {
+        if (scriptPaths.empty())
+        {
+            for (const auto & scenario : kCorpus)
+                results.push_back(runScenario(scenario.name, scenario.script));
+        }
+        else
+        {
+            for (const auto & path : scriptPaths)
+            {
+                std::ifstream file(path);
+                if (!file)
+                    throw std::runtime_error("could not open script '" + path + "'");
+                std::stringstream buffer;
+                buffer << file.rdbuf();
+                results.push_back(runScenario(path, buffer.str()));
+            }
+        }
+    }
+    catch (const std::exception & e)
+    {
+        fprintf(stderr, "labsound_replay: %s\n", e.what());
+        ok = false;
+    }
+
+    if (!jsonPath.empty())
+        writeJson(jsonPath, results);
+
+    return ok ? 0 : 1;
+}
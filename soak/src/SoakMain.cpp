@@ -0,0 +1,277 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+// labsound_soak
+//
+// Long-run degradation detector. Servers keep one context alive for days
+// while the graph churns; slow growth - an event queue backlog, a vector
+// that only ever push_backs - never shows in short tests. This harness
+// drives continuous graph churn against an offline context (the
+// LiveGraphUpdate pattern: voices connected, played, stopped, disconnected,
+// replaced), samples the memory introspection API and the wall time per
+// rendered quantum as it goes, and fails when either metric drifts upward
+// instead of plateauing.
+//
+//     labsound_soak                     20 second smoke soak
+//     labsound_soak --seconds 14400     four hour soak
+//     labsound_soak --json soak.json    also write the samples as JSON
+//
+// Drift test: after discarding a settling prefix, the sample series is split
+// in half and the second half's median must not exceed the first's by more
+// than the tolerance (memory: 2% or 1 MB, whichever is larger; timing: 25%).
+// A leak grows monotonically through both halves and trips this however slow
+// it is, given enough runtime; noise doesn't, because medians ignore spikes.
+// The exit code is the gate: nonzero means degradation.
+
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/AudioBus.h"
+#include "LabSound/core/BiquadFilterNode.h"
+#include "LabSound/core/GainNode.h"
+#include "LabSound/core/OfflineAudioDestinationNode.h"
+#include "LabSound/core/OscillatorNode.h"
+
+#include "LabSound/extended/AudioContextLock.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace lab;
+
+namespace
+{
+
+const float kSampleRate = 44100.f;
+const size_t kQuantumFrames = 128;  // AudioNode::ProcessingSizeInFrames
+
+// Render this many quanta between churn steps; at 44.1 kHz one batch is
+// roughly a quarter second of audio time.
+const int kQuantaPerBatch = 86;
+
+// One metric sample per this many batches.
+const int kBatchesPerSample = 20;
+
+struct Voice
+{
+    std::shared_ptr<OscillatorNode> source;
+    std::shared_ptr<BiquadFilterNode> filter;
+    std::shared_ptr<GainNode> gain;
+};
+
+struct Sample
+{
+    double audioSeconds = 0;
+    size_t memoryBytes = 0;
+    double microsecondsPerQuantum = 0;
+};
+
+double median(std::vector<double> values)
+{
+    if (values.empty())
+        return 0;
+    std::sort(values.begin(), values.end());
+    size_t mid = values.size() / 2;
+    return values.size() & 1 ? values[mid] : 0.5 * (values[mid - 1] + values[mid]);
+}
+
+// True when the second half of the series has drifted above the first by
+// more than the tolerance. relativeTolerance is a fraction of the first
+// half's median; absoluteTolerance is a floor so tiny bases don't flag.
+bool drifted(const std::vector<double> & series, double relativeTolerance, double absoluteTolerance,
+             double * firstOut, double * secondOut)
+{
+    // Discard the settling prefix: pools fill and caches warm early on.
+    size_t start = series.size() / 5;
+    size_t mid = start + (series.size() - start) / 2;
+
+    std::vector<double> first(series.begin() + start, series.begin() + mid);
+    std::vector<double> second(series.begin() + mid, series.end());
+
+    double a = median(first);
+    double b = median(second);
+    *firstOut = a;
+    *secondOut = b;
+
+    return b > a + std::max(a * relativeTolerance, absoluteTolerance);
+}
+
+void writeJson(const std::string & path, const std::vector<Sample> & samples)
+{
+    std::ofstream out(path);
+    out << "[\n";
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        out << "  { \"audio_s\": " << samples[i].audioSeconds
+            << ", \"memory_bytes\": " << samples[i].memoryBytes
+            << ", \"us_per_quantum\": " << samples[i].microsecondsPerQuantum
+            << " }" << (i + 1 < samples.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+    double seconds = 20;
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonPath = argv[++i];
+    }
+
+    AudioContext context(true);
+    auto destination = std::make_shared<OfflineAudioDestinationNode>(&context, kSampleRate, float(seconds + 1.0), 2);
+    context.setDestinationNode(destination);
+    context.lazyInitialize();
+
+    // A rotating bed of voices: each churn step retires the oldest voice and
+    // builds a replacement, so connect/disconnect, node construction and
+    // teardown, scheduling, and the end-of-playback event path all run
+    // continuously for the whole soak.
+    std::deque<Voice> voices;
+    uint64_t voicesBuilt = 0;
+
+    auto buildVoice = [&]() {
+        Voice v;
+        v.source = std::make_shared<OscillatorNode>(kSampleRate);
+        v.source->setType(OscillatorType::SAWTOOTH);
+        v.source->frequency()->setValue(55.f * float(1 + voicesBuilt % 32));
+        v.filter = std::make_shared<BiquadFilterNode>();
+        v.filter->setType(LOWPASS);
+        v.filter->frequency()->setValue(2000.f);
+        v.gain = std::make_shared<GainNode>();
+        v.gain->gain()->setValue(0.05f);
+
+        std::vector<AudioContext::ConnectionOperation> ops(3);
+        ops[0].destination = v.filter;
+        ops[0].source = v.source;
+        ops[1].destination = v.gain;
+        ops[1].source = v.filter;
+        ops[2].destination = context.destination();
+        ops[2].source = v.gain;
+        context.applyConnectionBatch(ops);
+
+        v.source->start(0.0);
+        ++voicesBuilt;
+        voices.push_back(v);
+    };
+
+    auto retireVoice = [&]() {
+        if (voices.empty())
+            return;
+        Voice v = voices.front();
+        voices.pop_front();
+        v.source->stop(0.0);
+        context.disconnect(nullptr, v.gain, 0, 0);
+        context.disconnect(v.gain, v.filter, 0, 0);
+        context.disconnect(v.filter, v.source, 0, 0);
+    };
+
+    for (int i = 0; i < 8; ++i)
+        buildVoice();
+
+    const uint64_t totalQuanta = static_cast<uint64_t>(seconds * kSampleRate / kQuantumFrames);
+    AudioBus bus(2, kQuantumFrames);
+
+    std::vector<Sample> samples;
+    uint64_t rendered = 0;
+    int batchesSinceSample = 0;
+    double batchMicroseconds = 0;
+    uint64_t batchQuanta = 0;
+
+    printf("labsound_soak: %.0f s of audio, churning %d-voice bed\n", seconds, int(voices.size()));
+
+    while (rendered < totalQuanta)
+    {
+        uint64_t quantaThisBatch = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int q = 0; q < kQuantaPerBatch && rendered < totalQuanta; ++q, ++rendered, ++quantaThisBatch)
+            destination->render(nullptr, &bus, kQuantumFrames);
+        auto end = std::chrono::steady_clock::now();
+
+        batchMicroseconds += std::chrono::duration<double, std::micro>(end - start).count();
+        batchQuanta += quantaThisBatch;
+
+        // Churn between batches, never mid-quantum: retire the oldest voice
+        // and replace it, exactly as a server cycling sounds would.
+        retireVoice();
+        buildVoice();
+
+        // Let the update thread keep pace; a soak that outruns it forever
+        // measures queue growth, not graph state.
+        if (context.hasPendingUpdates())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        if (++batchesSinceSample >= kBatchesPerSample)
+        {
+            Sample sample;
+            sample.audioSeconds = double(rendered) * kQuantumFrames / kSampleRate;
+            {
+                ContextRenderLock r(&context, "labsound_soak memory");
+                sample.memoryBytes = context.queryMemory(r).total();
+            }
+            sample.microsecondsPerQuantum = batchQuanta ? batchMicroseconds / double(batchQuanta) : 0;
+            samples.push_back(sample);
+
+            batchesSinceSample = 0;
+            batchMicroseconds = 0;
+            batchQuanta = 0;
+        }
+    }
+
+    printf("rendered %llu quanta, %zu samples, %llu voices cycled\n",
+           (unsigned long long) rendered, samples.size(), (unsigned long long) voicesBuilt);
+
+    if (samples.size() < 8)
+    {
+        // Too short to split meaningfully; report what was measured and pass.
+        printf("too few samples for drift analysis; extend --seconds for a real soak\n");
+        if (!jsonPath.empty())
+            writeJson(jsonPath, samples);
+        return 0;
+    }
+
+    std::vector<double> memorySeries, timingSeries;
+    for (const Sample & s : samples)
+    {
+        memorySeries.push_back(double(s.memoryBytes));
+        timingSeries.push_back(s.microsecondsPerQuantum);
+    }
+
+    int failures = 0;
+    double first = 0, second = 0;
+
+    if (drifted(memorySeries, 0.02, 1024.0 * 1024.0, &first, &second))
+    {
+        printf("FAIL memory drift: median %.0f -> %.0f bytes\n", first, second);
+        ++failures;
+    }
+    else
+        printf("ok   memory: median %.0f -> %.0f bytes\n", first, second);
+
+    if (drifted(timingSeries, 0.25, 0.0, &first, &second))
+    {
+        printf("FAIL timing drift: median %.1f -> %.1f us/quantum\n", first, second);
+        ++failures;
+    }
+    else
+        printf("ok   timing: median %.1f -> %.1f us/quantum\n", first, second);
+
+    if (!jsonPath.empty())
+        writeJson(jsonPath, samples);
+
+    return failures ? 1 : 0;
+}
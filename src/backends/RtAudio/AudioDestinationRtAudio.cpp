@@ -3,6 +3,7 @@
 // Copyright (C) 2015+, The LabSound Authors. All rights reserved.
 
 #include "AudioDestinationRtAudio.h"
+#include "internal/AudioThreads.h"
 #include "internal/VectorMath.h"
 
 #include "LabSound/core/AudioNode.h"
@@ -11,6 +12,8 @@
 
 #include <rtaudio/RtAudio.h>
 
+#include <cstring>
+
 namespace lab
 {
 
@@ -45,6 +48,16 @@ unsigned long AudioDestination::maxChannelCount()
     return NumDefaultOutputChannels();
 }
 
+float AudioDestination::hardwareSampleRate()
+{
+    RtAudio audio;
+    if (!audio.getDeviceCount())
+        return 0;
+
+    auto info = audio.getDeviceInfo(audio.getDefaultOutputDevice());
+    return info.probed ? static_cast<float>(info.preferredSampleRate) : 0;
+}
+
 AudioDestinationRtAudio::AudioDestinationRtAudio(AudioIOCallback & callback, size_t numChannels, float sampleRate)
 : m_callback(callback)
 , m_renderBus(numChannels, AudioNode::ProcessingSizeInFrames, false)
@@ -84,14 +97,34 @@ void AudioDestinationRtAudio::configure()
     inputParams.nChannels = 1;
     inputParams.firstChannel = 0;
 
+    // Prefer the device's native float path. When there isn't one, open the
+    // stream in the best native integer format and own the final conversion
+    // ourselves - render() converts, interleaves and dithers straight into
+    // the device buffer - rather than handing rtaudio planar floats to push
+    // through its scalar converters.
+    if (!(deviceInfo.nativeFormats & RTAUDIO_FLOAT32))
+    {
+        if (deviceInfo.nativeFormats & RTAUDIO_SINT24)
+            m_deviceFormat = RTAUDIO_SINT24;
+        else if (deviceInfo.nativeFormats & RTAUDIO_SINT16)
+            m_deviceFormat = RTAUDIO_SINT16;
+    }
+
     unsigned int bufferFrames = AudioNode::ProcessingSizeInFrames;
 
     RtAudio::StreamOptions options;
-    options.flags |= RTAUDIO_NONINTERLEAVED;
+    if (m_deviceFormat == RTAUDIO_FLOAT32)
+        options.flags |= RTAUDIO_NONINTERLEAVED;  // integer streams are written interleaved by our converters
 
     try
     {
-        dac.openStream(&outputParams, &inputParams, RTAUDIO_FLOAT32, (unsigned int) m_sampleRate, &bufferFrames, &outputCallback, this, &options);
+        dac.openStream(&outputParams, &inputParams, m_deviceFormat, (unsigned int) m_sampleRate, &bufferFrames, &outputCallback, this, &options);
+
+        // The stream's reported latency (in frames) only changes with the
+        // stream configuration, so capture it once here.
+        long latencyFrames = dac.getStreamLatency();
+        if (latencyFrames > 0)
+            m_outputLatencySeconds = latencyFrames / static_cast<double>(m_sampleRate);
     }
     catch (RtAudioError & e)
     {
@@ -124,47 +157,118 @@ void AudioDestinationRtAudio::stop()
 }
 
 // Pulls on our provider to get rendered audio stream.
-void AudioDestinationRtAudio::render(int numberOfFrames, void * outputBuffer, void * inputBuffer)
+void AudioDestinationRtAudio::render(int numberOfFrames, void * outputBuffer, void * inputBuffer, double streamTime)
 {
-    float *myOutputBufferOfFloats = (float*) outputBuffer;
-    float *myInputBufferOfFloats = (float*) inputBuffer;
+    // The platform audio layer owns this thread, so the policy is applied
+    // from the first callback rather than at spawn.
+    if (!m_callbackPolicyApplied)
+    {
+        ApplyThreadPolicy(AudioContext::ThreadRole::DeviceCallback, "audio callback");
+        m_callbackPolicyApplied = true;
+    }
+
+    // publish the device stream clock for streamTime()
+    m_streamTime.store(streamTime, std::memory_order_relaxed);
+
+    if (m_deviceFormat == RTAUDIO_FLOAT32)
+    {
+        float *myOutputBufferOfFloats = (float*) outputBuffer;
+        float *myInputBufferOfFloats = (float*) inputBuffer;
+
+        // Inform bus to use an externally allocated buffer from rtaudio
+        if (m_renderBus.isFirstTime())
+        {
+            for (uint32_t i = 0; i < m_numChannels; ++i)
+            {
+                m_renderBus.setChannelMemory(i, myOutputBufferOfFloats + i * numberOfFrames, numberOfFrames);
+            }
+        }
+
+        if (m_inputBus.isFirstTime())
+        {
+            m_inputBus.setChannelMemory(0, myInputBufferOfFloats, numberOfFrames);
+        }
+
+        // Source Bus :: Destination Bus
+        m_callback.render(&m_inputBus, &m_renderBus, numberOfFrames);
 
-    // Inform bus to use an externally allocated buffer from rtaudio
+        // Clamp values at 0db (i.e., [-1.0, 1.0])
+        for (unsigned i = 0; i < m_renderBus.numberOfChannels(); ++i)
+        {
+            AudioChannel * channel = m_renderBus.channel(i);
+            VectorMath::vclip(channel->data(), 1, &kLowThreshold, &kHighThreshold, channel->mutableData(), 1, numberOfFrames);
+        }
+        return;
+    }
+
+    // Integer-format stream: the graph renders into the planar scratch, and
+    // the convert-interleave-dither kernel writes the device buffer in one
+    // pass (it clamps, so no separate vclip is needed).
     if (m_renderBus.isFirstTime())
     {
-		for (uint32_t i = 0; i < m_numChannels; ++i)
-		{
-			m_renderBus.setChannelMemory(i, myOutputBufferOfFloats + i * numberOfFrames, numberOfFrames);
-		}
+        m_conversionBuffer.resize(m_numChannels * numberOfFrames);
+        for (uint32_t i = 0; i < m_numChannels; ++i)
+        {
+            m_renderBus.setChannelMemory(i, m_conversionBuffer.data() + i * numberOfFrames, numberOfFrames);
+        }
     }
 
     if (m_inputBus.isFirstTime())
     {
-        m_inputBus.setChannelMemory(0, myInputBufferOfFloats, numberOfFrames);
+        m_inputConversionBuffer.resize(numberOfFrames);
+        m_inputBus.setChannelMemory(0, m_inputConversionBuffer.data(), numberOfFrames);
     }
 
-    // Source Bus :: Destination Bus
-    m_callback.render(&m_inputBus, &m_renderBus, numberOfFrames);
-
-    // Clamp values at 0db (i.e., [-1.0, 1.0])
-    for (unsigned i = 0; i < m_renderBus.numberOfChannels(); ++i)
+    // the stream format applies to the input side as well
+    if (inputBuffer && !m_inputConversionBuffer.empty())
     {
-        AudioChannel * channel = m_renderBus.channel(i);
-        VectorMath::vclip(channel->data(), 1, &kLowThreshold, &kHighThreshold, channel->mutableData(), 1, numberOfFrames);
+        float * in = m_inputConversionBuffer.data();
+        if (m_deviceFormat == RTAUDIO_SINT16)
+        {
+            const int16_t * samples = static_cast<const int16_t *>(inputBuffer);
+            for (int i = 0; i < numberOfFrames; ++i)
+                in[i] = samples[i] * (1.f / 32768.f);
+        }
+        else  // RTAUDIO_SINT24, packed little-endian
+        {
+            const uint8_t * bytes = static_cast<const uint8_t *>(inputBuffer);
+            for (int i = 0; i < numberOfFrames; ++i)
+            {
+                int32_t v = bytes[3 * i] | (bytes[3 * i + 1] << 8) | (bytes[3 * i + 2] << 16);
+                if (v & 0x800000)
+                    v |= ~0xffffff;  // sign extend
+                in[i] = v * (1.f / 8388608.f);
+            }
+        }
     }
+
+    m_callback.render(&m_inputBus, &m_renderBus, numberOfFrames);
+
+    const float * planarChannels[32];
+    uint32_t channels = m_numChannels < 32 ? m_numChannels : 32;
+    for (uint32_t i = 0; i < channels; ++i)
+        planarChannels[i] = m_renderBus.channel(i)->data();
+
+    if (m_deviceFormat == RTAUDIO_SINT24)
+        VectorMath::vfloat_to_int24_interleave(planarChannels, channels, static_cast<uint8_t *>(outputBuffer), numberOfFrames, true);
+    else
+        VectorMath::vfloat_to_int16_interleave(planarChannels, channels, static_cast<int16_t *>(outputBuffer), numberOfFrames, true);
 }
 
-int outputCallback(void * outputBuffer, void * inputBuffer, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void * userData)
+void AudioDestinationRtAudio::zeroDeviceBuffer(void * outputBuffer, unsigned int numberOfFrames) const
 {
-    float *fBufOut = (float*) outputBuffer;
-
-    // Buffer is nBufferFrames * channels
-    // NB: channel count should be set in a principled way
-    memset(fBufOut, 0, sizeof(float) * nBufferFrames * 2);
+    size_t bytesPerSample = m_deviceFormat == RTAUDIO_SINT16 ? 2 : m_deviceFormat == RTAUDIO_SINT24 ? 3 : sizeof(float);
+    memset(outputBuffer, 0, bytesPerSample * m_numChannels * numberOfFrames);
+}
 
+int outputCallback(void * outputBuffer, void * inputBuffer, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void * userData)
+{
     AudioDestinationRtAudio * audioDestination = static_cast<AudioDestinationRtAudio*>(userData);
 
-    audioDestination->render(nBufferFrames, fBufOut, inputBuffer);
+    // Start from silence in whatever format the stream was opened with.
+    audioDestination->zeroDeviceBuffer(outputBuffer, nBufferFrames);
+
+    audioDestination->render(nBufferFrames, outputBuffer, inputBuffer, streamTime);
 
     return 0;
 }
@@ -11,8 +11,10 @@
 #include "internal/AudioDestination.h"
 
 #include "rtaudio/RtAudio.h"
+#include <atomic>
 #include <iostream>
 #include <cstdlib>
+#include <vector>
 
 namespace lab {
 
@@ -29,7 +31,16 @@ public:
 
     float sampleRate() const override { return m_sampleRate; }
 
-    void render(int numberOfFrames, void * outputBuffer, void * inputBuffer);
+    // The stream clock rtaudio hands the output callback, and the open
+    // stream's reported latency; see AudioDestination.
+    double streamTime() const override { return m_streamTime.load(std::memory_order_relaxed); }
+    double outputLatency() const override { return m_outputLatencySeconds; }
+
+    void render(int numberOfFrames, void * outputBuffer, void * inputBuffer, double streamTime);
+
+    // Zeroes the device buffer in whatever sample format the stream was
+    // opened with; called by the output callback before render().
+    void zeroDeviceBuffer(void * outputBuffer, unsigned int numberOfFrames) const;
 
 private:
 
@@ -43,6 +54,22 @@ private:
     unsigned m_numChannels;
     float m_sampleRate;
 
+    std::atomic<double> m_streamTime{0};
+    double m_outputLatencySeconds = 0;
+    bool m_callbackPolicyApplied = false;
+
+    // Sample format negotiated in configure(). Devices without a native
+    // float path get int16/int24 streams; render() then writes the device
+    // buffer itself through the VectorMath convert-interleave-dither kernels
+    // instead of letting rtaudio's scalar converters run after the fact.
+    RtAudioFormat m_deviceFormat = RTAUDIO_FLOAT32;
+
+    // Planar float scratch that stands in for the device buffer when the
+    // stream format is integer; the graph renders here and the conversion
+    // writes the hardware buffer in one pass.
+    std::vector<float> m_conversionBuffer;
+    std::vector<float> m_inputConversionBuffer;
+
     RtAudio dac;
 };
 
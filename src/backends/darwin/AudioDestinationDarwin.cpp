@@ -5,6 +5,7 @@
 #include "LabSound/core/AudioIOCallback.h"
 
 #include "internal/Assertions.h"
+#include "internal/AudioThreads.h"
 #include "AudioDestinationDarwin.h"
 #include "internal/VectorMath.h"
 
@@ -193,6 +194,36 @@ unsigned long AudioDestination::maxChannelCount()
     return 0;
 }
 
+float AudioDestination::hardwareSampleRate()
+{
+#if TARGET_OS_IPHONE
+    // the audio session negotiates rates on ios, not the device
+    return 0;
+#else
+    AudioDeviceID deviceId = kAudioObjectUnknown;
+    UInt32 size = sizeof(deviceId);
+    AudioObjectPropertyAddress defaultOutput = {
+        kAudioHardwarePropertyDefaultOutputDevice,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMaster
+    };
+    if (AudioObjectGetPropertyData(kAudioObjectSystemObject, &defaultOutput, 0, NULL, &size, &deviceId) || deviceId == kAudioObjectUnknown)
+        return 0;
+
+    Float64 nominalRate = 0;
+    size = sizeof(nominalRate);
+    AudioObjectPropertyAddress nominal = {
+        kAudioDevicePropertyNominalSampleRate,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMaster
+    };
+    if (AudioObjectGetPropertyData(deviceId, &nominal, 0, NULL, &size, &nominalRate))
+        return 0;
+
+    return static_cast<float>(nominalRate);
+#endif
+}
+
 AudioDestinationMac::AudioDestinationMac(AudioIOCallback& callback, size_t channelCount, float sampleRate, size_t renderQuantum)
 : m_outputUnit(0)
 , m_callback(callback)
@@ -259,15 +290,61 @@ void AudioDestinationMac::configure()
     result = AudioUnitSetProperty(m_outputUnit, kAudioUnitProperty_StreamFormat, kAudioUnitScope_Input, 0, (void*)&streamFormat, sizeof(AudioStreamBasicDescription));
     ASSERT(!result);
 
-    // Set the buffer frame size.
-    size_t  bufferSize = m_renderQuantum;
+#if !TARGET_OS_IPHONE
+    // Ask the device itself to run at the context's rate rather than letting
+    // CoreAudio resample invisibly between the unit and the device. If the
+    // device refuses, the unit's converter still covers the difference; pass
+    // AudioDestination::hardwareSampleRate() as the context's rate to avoid
+    // conversion entirely.
+    AudioDeviceID deviceId = kAudioObjectUnknown;
+    UInt32 deviceIdSize = sizeof(deviceId);
+    result = AudioUnitGetProperty(m_outputUnit, kAudioOutputUnitProperty_CurrentDevice, kAudioUnitScope_Global, 0, &deviceId, &deviceIdSize);
+    if (!result && deviceId != kAudioObjectUnknown)
+    {
+        AudioObjectPropertyAddress nominal = {
+            kAudioDevicePropertyNominalSampleRate,
+            kAudioObjectPropertyScopeGlobal,
+            kAudioObjectPropertyElementMaster
+        };
+        Float64 nominalRate = 0;
+        UInt32 rateSize = sizeof(nominalRate);
+        if (!AudioObjectGetPropertyData(deviceId, &nominal, 0, NULL, &rateSize, &nominalRate)
+            && nominalRate != static_cast<Float64>(m_sampleRate))
+        {
+            Float64 desiredRate = m_sampleRate;
+            if (AudioObjectSetPropertyData(deviceId, &nominal, 0, NULL, sizeof(desiredRate), &desiredRate))
+                LOG("Device holds %f Hz; CoreAudio converts from the %f Hz context", nominalRate, m_sampleRate);
+        }
+    }
+#endif
+
+    // Set the buffer frame size. A low-latency request takes precedence over
+    // the construction-time render quantum, so studio builds can pin the
+    // device period explicitly (e.g. to 128 frames).
+    UInt32 bufferSize = static_cast<UInt32>(m_renderQuantum);
+    if (lowLatencyRequested() && preferredBufferFrames())
+        bufferSize = preferredBufferFrames();
 #if TARGET_OS_IPHONE
     // ios manages the buffer size according to a variety of factors outside of LabSound's control
 #else
     result = AudioUnitSetProperty(m_outputUnit, kAudioDevicePropertyBufferFrameSize, kAudioUnitScope_Output, 0, (void*)&bufferSize, sizeof(bufferSize));
     ASSERT(!result);
+
+    // read back the period actually granted, for callbackBufferSize()
+    UInt32 grantedSize = sizeof(bufferSize);
+    result = AudioUnitGetProperty(m_outputUnit, kAudioDevicePropertyBufferFrameSize, kAudioUnitScope_Output, 0, &bufferSize, &grantedSize);
+    if (!result)
+        m_callbackBufferFrames = bufferSize;
 #endif
 
+    // The unit's reported processing latency plus one device buffer of
+    // scheduling is the best presentation estimate this API exposes.
+    Float64 unitLatency = 0;
+    UInt32 latencySize = sizeof(unitLatency);
+    result = AudioUnitGetProperty(m_outputUnit, kAudioUnitProperty_Latency, kAudioUnitScope_Global, 0, &unitLatency, &latencySize);
+    if (!result && m_sampleRate > 0)
+        m_outputLatencySeconds = unitLatency + bufferSize / static_cast<double>(m_sampleRate);
+
     m_input->configure(streamFormat, bufferSize);
 }
 
@@ -290,8 +367,21 @@ void AudioDestinationMac::stop()
 }
 
 // Pulls on our provider to get rendered audio stream.
-OSStatus AudioDestinationMac::render(UInt32 numberOfFrames, AudioBufferList* ioData)
+OSStatus AudioDestinationMac::render(UInt32 numberOfFrames, AudioBufferList* ioData, const AudioTimeStamp* timeStamp)
 {
+    // The platform audio layer owns this thread, so the policy is applied
+    // from the first callback rather than at spawn.
+    if (!m_callbackPolicyApplied)
+    {
+        ApplyThreadPolicy(AudioContext::ThreadRole::DeviceCallback, "audio callback");
+        m_callbackPolicyApplied = true;
+    }
+
+    // Publish the device stream clock; mSampleTime counts frames at the
+    // output unit's rate from stream start.
+    if (timeStamp && (timeStamp->mFlags & kAudioTimeStampSampleTimeValid) && m_sampleRate > 0)
+        m_streamTime.store(timeStamp->mSampleTime / m_sampleRate, std::memory_order_relaxed);
+
     AudioBuffer* buffers = ioData->mBuffers;
     m_renderBus.setChannelMemory(0, (float*)buffers[0].mData, numberOfFrames);
     m_renderBus.setChannelMemory(1, (float*)buffers[1].mData, numberOfFrames);
@@ -309,10 +399,10 @@ OSStatus AudioDestinationMac::render(UInt32 numberOfFrames, AudioBufferList* ioD
 }
 
 // DefaultOutputUnit callback
-OSStatus AudioDestinationMac::inputProc(void* userData, AudioUnitRenderActionFlags*, const AudioTimeStamp*, UInt32 /*busNumber*/, UInt32 numberOfFrames, AudioBufferList* ioData)
+OSStatus AudioDestinationMac::inputProc(void* userData, AudioUnitRenderActionFlags*, const AudioTimeStamp* timeStamp, UInt32 /*busNumber*/, UInt32 numberOfFrames, AudioBufferList* ioData)
 {
     AudioDestinationMac* audioOutput = static_cast<AudioDestinationMac*>(userData);
-    return audioOutput->render(numberOfFrames, ioData);
+    return audioOutput->render(numberOfFrames, ioData, timeStamp);
 }
 
 } // namespace lab
@@ -8,6 +8,7 @@
 #include "LabSound/core/AudioBus.h"
 #include "internal/AudioDestination.h"
 #include <AudioUnit/AudioUnit.h>
+#include <atomic>
 
 namespace lab {
 
@@ -23,13 +24,21 @@ public:
 
     float sampleRate() const override { return m_sampleRate; }
 
+    // The output unit's sample-time clock and reported latency; see AudioDestination.
+    double streamTime() const override { return m_streamTime.load(std::memory_order_relaxed); }
+    double outputLatency() const override { return m_outputLatencySeconds; }
+
+    // The device period actually granted, in frames; zero on iOS, where the
+    // session owns the buffer size.
+    unsigned int callbackBufferSize() const override { return m_callbackBufferFrames; }
+
 private:
     void configure();
 
     // DefaultOutputUnit callback
     static OSStatus inputProc(void* userData, AudioUnitRenderActionFlags*, const AudioTimeStamp*, UInt32 busNumber, UInt32 numberOfFrames, AudioBufferList* ioData);
 
-    OSStatus render(UInt32 numberOfFrames, AudioBufferList* ioData);
+    OSStatus render(UInt32 numberOfFrames, AudioBufferList* ioData, const AudioTimeStamp* timeStamp);
 
     AudioUnit m_outputUnit;
     AudioIOCallback& m_callback;
@@ -38,6 +47,11 @@ private:
     float m_sampleRate;
     size_t m_renderQuantum;
 
+    std::atomic<double> m_streamTime{0};
+    double m_outputLatencySeconds = 0;
+    bool m_callbackPolicyApplied = false;
+    unsigned int m_callbackBufferFrames = 0;
+
     class Input; // LabSound
     Input* m_input; // LabSound
 };
@@ -3,6 +3,7 @@
 // Copyright (C) 2015+, The LabSound Authors. All rights reserved.
 
 #include "AudioDestinationLinux.h"
+#include "internal/AudioThreads.h"
 #include "internal/VectorMath.h"
 
 #include "LabSound/core/AudioNode.h"
@@ -45,6 +46,16 @@ unsigned long AudioDestination::maxChannelCount()
     return NumDefaultOutputChannels();
 }
 
+float AudioDestination::hardwareSampleRate()
+{
+    RtAudio audio;
+    if (!audio.getDeviceCount())
+        return 0;
+
+    auto info = audio.getDeviceInfo(audio.getDefaultOutputDevice());
+    return info.probed ? static_cast<float>(info.preferredSampleRate) : 0;
+}
+
 AudioDestinationLinux::AudioDestinationLinux(AudioIOCallback & callback, size_t numChannels, float sampleRate)
 : m_callback(callback)
 , m_renderBus(numChannels, AudioNode::ProcessingSizeInFrames, false)
@@ -77,30 +88,103 @@ void AudioDestinationLinux::configure()
     outputParams.firstChannel = 0;
 
     auto outDeviceInfo = dac.getDeviceInfo(outputParams.deviceId);
-    LOG("Using Default Audio Device: %s", deviceInfo.name.c_str());
+    LOG("Using Default Audio Device: %s", outDeviceInfo.name.c_str());
 
     RtAudio::StreamParameters inputParams;
     inputParams.deviceId = dac.getDefaultInputDevice();
     inputParams.nChannels = 1;
     inputParams.firstChannel = 0;
 
-    auto inDeviceInfo = dac.getDeviceInfo(outputParams.deviceId);
+    auto inDeviceInfo = dac.getDeviceInfo(inputParams.deviceId);
 
-    unsigned int bufferFrames = AudioNode::ProcessingSizeInFrames;
-
-    RtAudio::StreamOptions options;
-    options.flags |= RTAUDIO_NONINTERLEAVED;
+    // Prefer running the stream at the graph's rate. When the device doesn't
+    // support it (common after a default-device switch), open at the device's
+    // preferred rate instead and let render() bridge the difference, rather
+    // than forcing the context to rebuild wavetables, convolver partitions
+    // and the HRTF database at a new rate.
+    m_deviceSampleRate = m_sampleRate;
+    if (outDeviceInfo.probed && m_numChannels <= SincResampler::MaxInterleavedChannels)
+    {
+        bool supportsGraphRate = false;
+        for (unsigned int rate : outDeviceInfo.sampleRates)
+        {
+            if (rate == static_cast<unsigned int>(m_sampleRate))
+            {
+                supportsGraphRate = true;
+                break;
+            }
+        }
+        if (!supportsGraphRate && outDeviceInfo.preferredSampleRate)
+            m_deviceSampleRate = static_cast<float>(outDeviceInfo.preferredSampleRate);
+    }
 
-    try
+    // When low latency is requested, negotiate the smallest period the driver
+    // will grant with the minimum ALSA period count, the callback thread
+    // scheduled realtime. rtaudio's Linux path already does the rest: it
+    // prefers JACK when a server is running and uses mmap'd ALSA transfers
+    // where the driver supports them. Each rung of the ladder relaxes one
+    // demand until the open succeeds.
+    struct OpenAttempt
+    {
+        RtAudioStreamFlags extraFlags;
+        unsigned int frames;
+        unsigned int periods;
+    };
+    std::vector<OpenAttempt> attempts;
+    if (lowLatencyRequested())
     {
-        dac.openStream(outDeviceInfo.probed ? &outputParams : nullptr, 
-                       inDeviceInfo.probed ? &inputParams : nullptr, 
-            RTAUDIO_FLOAT32, 
-            (unsigned int) m_sampleRate, &bufferFrames, &outputCallback, this, &options);
+        unsigned int preferred = preferredBufferFrames() ? preferredBufferFrames() : AudioNode::ProcessingSizeInFrames;
+        attempts.push_back({RTAUDIO_MINIMIZE_LATENCY | RTAUDIO_SCHEDULE_REALTIME, preferred, 2});
+        attempts.push_back({RTAUDIO_SCHEDULE_REALTIME, preferred, 3});
     }
-    catch (RtAudioError & e)
+    attempts.push_back({0, AudioNode::ProcessingSizeInFrames, 0});
+
+    for (size_t attempt = 0; attempt < attempts.size(); ++attempt)
     {
-        e.printMessage();
+        RtAudio::StreamOptions options;
+        options.flags = RTAUDIO_NONINTERLEAVED | attempts[attempt].extraFlags;
+        options.numberOfBuffers = attempts[attempt].periods;
+
+        // openStream adjusts bufferFrames to the period actually granted
+        unsigned int bufferFrames = attempts[attempt].frames;
+
+        try
+        {
+            dac.openStream(outDeviceInfo.probed ? &outputParams : nullptr,
+                           inDeviceInfo.probed ? &inputParams : nullptr,
+                RTAUDIO_FLOAT32,
+                (unsigned int) m_deviceSampleRate, &bufferFrames, &outputCallback, this, &options);
+
+            m_callbackBufferFrames = bufferFrames;
+
+            // The stream's reported latency (in frames) only changes with the
+            // stream configuration, so capture it once here.
+            long latencyFrames = dac.getStreamLatency();
+            if (latencyFrames > 0)
+                m_outputLatencySeconds = latencyFrames / static_cast<double>(m_deviceSampleRate);
+
+            if (attempts[attempt].extraFlags)
+                LOG("Low latency stream opened with a %u frame period", bufferFrames);
+
+            if (m_deviceSampleRate != m_sampleRate)
+            {
+                m_graphReader.destination = this;
+                m_resampler = std::make_unique<SincResampler>(
+                    m_sampleRate / static_cast<double>(m_deviceSampleRate), 32, 32,
+                    static_cast<unsigned>(m_numChannels));
+                LOG("Device opened at %f Hz; bridging from the %f Hz graph", m_deviceSampleRate, m_sampleRate);
+            }
+            else
+            {
+                m_resampler.reset();
+            }
+            break;
+        }
+        catch (RtAudioError & e)
+        {
+            if (attempt + 1 == attempts.size())
+                e.printMessage();
+        }
     }
 }
 
@@ -129,47 +213,234 @@ void AudioDestinationLinux::stop()
 }
 
 // Pulls on our provider to get rendered audio stream.
-void AudioDestinationLinux::render(int numberOfFrames, void * outputBuffer, void * inputBuffer)
+void AudioDestinationLinux::render(int numberOfFrames, void * outputBuffer, void * inputBuffer, double streamTime)
 {
+    // The platform audio layer owns this thread, so the policy is applied
+    // from the first callback rather than at spawn.
+    if (!m_callbackPolicyApplied)
+    {
+        ApplyThreadPolicy(AudioContext::ThreadRole::DeviceCallback, "audio callback");
+        m_callbackPolicyApplied = true;
+    }
+
+    // publish the device stream clock for streamTime()
+    m_streamTime.store(streamTime, std::memory_order_relaxed);
+
     float *myOutputBufferOfFloats = (float*) outputBuffer;
     float *myInputBufferOfFloats = (float*) inputBuffer;
 
-    // Inform bus to use an externally allocated buffer from rtaudio
-    if (m_renderBus.isFirstTime())
+    const int quantum = AudioNode::ProcessingSizeInFrames;
+
+    // Stream running at a rate other than the graph's: pull context-rate
+    // quanta through the resampling bridge and hand the device frames at its
+    // own rate. The pull is synchronous, so the device clock paces the graph
+    // exactly and there is no queue whose fill level could drift.
+    if (m_resampler)
+    {
+        if (!m_quantumBus)
+        {
+            m_quantumBus = std::make_unique<AudioBus>(static_cast<unsigned>(m_numChannels), quantum, true);
+            m_quantumBus->setSampleRate(m_sampleRate);
+            m_spill.resize(m_numChannels * quantum);
+            m_quantumInputBus = std::make_unique<AudioBus>(1, quantum, true);
+            m_inputRing.resize(4 * quantum);
+        }
+
+        // stash the device's input so quantum renders can consume it; it is
+        // handed to the graph at the device's rate, not rate-converted
+        if (myInputBufferOfFloats)
+        {
+            for (int i = 0; i < numberOfFrames && m_inputRingFrames < m_inputRing.size(); ++i)
+                m_inputRing[m_inputRingFrames++] = myInputBufferOfFloats[i];
+        }
+
+        if (m_resampleOut.size() < (size_t) numberOfFrames * m_numChannels)
+            m_resampleOut.resize((size_t) numberOfFrames * m_numChannels);
+
+        m_resampler->process(&m_graphReader, m_resampleOut.data(), numberOfFrames);
+
+        // deinterleave into rtaudio's planar buffer, clamping at 0db
+        for (unsigned c = 0; c < m_numChannels; ++c)
+        {
+            float * out = myOutputBufferOfFloats + c * numberOfFrames;
+            const float * interleaved = m_resampleOut.data() + c;
+            for (int i = 0; i < numberOfFrames; ++i)
+                out[i] = interleaved[i * m_numChannels];
+            VectorMath::vclip(out, 1, &kLowThreshold, &kHighThreshold, out, 1, numberOfFrames);
+        }
+        return;
+    }
+
+    if (numberOfFrames == quantum)
     {
-        for (uint32_t i = 0; i < m_numChannels; ++i)
+        // Inform bus to use an externally allocated buffer from rtaudio
+        if (m_renderBus.isFirstTime())
+        {
+            for (uint32_t i = 0; i < m_numChannels; ++i)
+            {
+                m_renderBus.setChannelMemory(i, myOutputBufferOfFloats + i * numberOfFrames, numberOfFrames);
+            }
+        }
+
+        if (m_inputBus.isFirstTime())
+        {
+            m_inputBus.setChannelMemory(0, myInputBufferOfFloats, numberOfFrames);
+        }
+
+        // Source Bus :: Destination Bus
+        m_callback.render(&m_inputBus, &m_renderBus, numberOfFrames);
+
+        // Clamp values at 0db (i.e., [-1.0, 1.0])
+        for (unsigned i = 0; i < m_renderBus.numberOfChannels(); ++i)
         {
-            m_renderBus.setChannelMemory(i, myOutputBufferOfFloats + i * numberOfFrames, numberOfFrames);
+            AudioChannel * channel = m_renderBus.channel(i);
+            VectorMath::vclip(channel->data(), 1, &kLowThreshold, &kHighThreshold, channel->mutableData(), 1, numberOfFrames);
         }
+        return;
+    }
+
+    // The device granted a period other than the render quantum (the whole
+    // point of the low-latency negotiation). The graph renders fixed-size
+    // quanta, so pull whole quanta into an internal bus and carry the
+    // remainder across callbacks.
+    if (!m_quantumBus)
+    {
+        m_quantumBus = std::make_unique<AudioBus>(static_cast<unsigned>(m_numChannels), quantum, true);
+        m_quantumBus->setSampleRate(m_sampleRate);
+        m_spill.resize(m_numChannels * quantum);
+        m_quantumInputBus = std::make_unique<AudioBus>(1, quantum, true);
+        m_inputRing.resize(4 * quantum);
+    }
+
+    // stash the device's input so quantum renders can consume it
+    if (myInputBufferOfFloats)
+    {
+        for (int i = 0; i < numberOfFrames && m_inputRingFrames < m_inputRing.size(); ++i)
+            m_inputRing[m_inputRingFrames++] = myInputBufferOfFloats[i];
     }
 
-    if (m_inputBus.isFirstTime())
+    int framesFilled = 0;
+    while (framesFilled < numberOfFrames)
     {
-        m_inputBus.setChannelMemory(0, myInputBufferOfFloats, numberOfFrames);
+        if (!m_spillFrames)
+        {
+            float * in = m_quantumInputBus->channel(0)->mutableData();
+            size_t have = m_inputRingFrames < (size_t) quantum ? m_inputRingFrames : (size_t) quantum;
+            memcpy(in, m_inputRing.data(), have * sizeof(float));
+            if (have < (size_t) quantum)
+                memset(in + have, 0, (quantum - have) * sizeof(float));
+            memmove(m_inputRing.data(), m_inputRing.data() + have, (m_inputRingFrames - have) * sizeof(float));
+            m_inputRingFrames -= have;
+
+            m_callback.render(m_quantumInputBus.get(), m_quantumBus.get(), quantum);
+
+            for (unsigned i = 0; i < m_numChannels; ++i)
+            {
+                AudioChannel * channel = m_quantumBus->channel(i);
+                VectorMath::vclip(channel->data(), 1, &kLowThreshold, &kHighThreshold, channel->mutableData(), 1, quantum);
+                memcpy(m_spill.data() + i * quantum, channel->data(), quantum * sizeof(float));
+            }
+            m_spillOffset = 0;
+            m_spillFrames = quantum;
+        }
+
+        int frames = numberOfFrames - framesFilled;
+        if (frames > (int) m_spillFrames)
+            frames = (int) m_spillFrames;
+
+        for (unsigned i = 0; i < m_numChannels; ++i)
+        {
+            memcpy(myOutputBufferOfFloats + i * numberOfFrames + framesFilled,
+                   m_spill.data() + i * quantum + m_spillOffset,
+                   frames * sizeof(float));
+        }
+        framesFilled += frames;
+        m_spillOffset += frames;
+        m_spillFrames -= frames;
     }
+}
 
-    // Source Bus :: Destination Bus
-    m_callback.render(&m_inputBus, &m_renderBus, numberOfFrames);
+// Pulls context-rate frames for the resampling bridge: whole graph quanta
+// are rendered into the spill store and handed out planar at whatever
+// granularity the kernel asks for.
+void AudioDestinationLinux::readGraphFrames(AudioBus * bus, size_t framesToProcess)
+{
+    const size_t quantum = AudioNode::ProcessingSizeInFrames;
 
-    // Clamp values at 0db (i.e., [-1.0, 1.0])
-    for (unsigned i = 0; i < m_renderBus.numberOfChannels(); ++i)
+    size_t filled = 0;
+    while (filled < framesToProcess)
     {
-        AudioChannel * channel = m_renderBus.channel(i);
-        VectorMath::vclip(channel->data(), 1, &kLowThreshold, &kHighThreshold, channel->mutableData(), 1, numberOfFrames);
+        if (!m_spillFrames)
+        {
+            float * in = m_quantumInputBus->channel(0)->mutableData();
+            size_t have = m_inputRingFrames < quantum ? m_inputRingFrames : quantum;
+            memcpy(in, m_inputRing.data(), have * sizeof(float));
+            if (have < quantum)
+                memset(in + have, 0, (quantum - have) * sizeof(float));
+            memmove(m_inputRing.data(), m_inputRing.data() + have, (m_inputRingFrames - have) * sizeof(float));
+            m_inputRingFrames -= have;
+
+            m_callback.render(m_quantumInputBus.get(), m_quantumBus.get(), quantum);
+
+            for (unsigned i = 0; i < m_numChannels; ++i)
+                memcpy(m_spill.data() + i * quantum, m_quantumBus->channel(i)->data(), quantum * sizeof(float));
+            m_spillOffset = 0;
+            m_spillFrames = quantum;
+        }
+
+        size_t frames = framesToProcess - filled;
+        if (frames > m_spillFrames)
+            frames = m_spillFrames;
+
+        for (unsigned i = 0; i < m_numChannels; ++i)
+        {
+            memcpy(bus->channel(i)->mutableData() + filled,
+                   m_spill.data() + i * quantum + m_spillOffset,
+                   frames * sizeof(float));
+        }
+        filled += frames;
+        m_spillOffset += frames;
+        m_spillFrames -= frames;
     }
 }
 
+void AudioDestinationLinux::GraphReader::provideInput(AudioBus * bus, size_t framesToProcess)
+{
+    destination->readGraphFrames(bus, framesToProcess);
+}
+
+void AudioDestinationLinux::handleDeviceChange()
+{
+    // Reopen against whatever the default device now is. The graph keeps its
+    // original sample rate; if the new device runs at a different rate the
+    // bridge is rebuilt around the new ratio in configure(), so wavetables,
+    // convolver partitions and the HRTF database all remain valid and the
+    // switch costs a moment of resampling instead of a context rebuild.
+    bool wasRunning = dac.isStreamRunning();
+    if (dac.isStreamOpen())
+        dac.closeStream();
+
+    m_resampler.reset();
+    m_spillFrames = 0;
+    m_spillOffset = 0;
+    m_inputRingFrames = 0;
+
+    configure();
+
+    if (wasRunning)
+        start();
+}
+
 int outputCallback(void * outputBuffer, void * inputBuffer, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void * userData)
 {
     float *fBufOut = (float*) outputBuffer;
 
-    // Buffer is nBufferFrames * channels
-    // NB: channel count should be set in a principled way
-    memset(fBufOut, 0, sizeof(float) * nBufferFrames * 2);
-
     AudioDestinationLinux * audioDestination = static_cast<AudioDestinationLinux*>(userData);
 
-    audioDestination->render(nBufferFrames, fBufOut, inputBuffer);
+    // Buffer is nBufferFrames * channels, noninterleaved
+    memset(fBufOut, 0, sizeof(float) * nBufferFrames * audioDestination->channelCount());
+
+    audioDestination->render(nBufferFrames, fBufOut, inputBuffer, streamTime);
 
     return 0;
 }
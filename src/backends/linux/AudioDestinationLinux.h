@@ -9,10 +9,14 @@
 #include "LabSound/core/AudioBus.h"
 
 #include "internal/AudioDestination.h"
+#include "internal/SincResampler.h"
 
 #include "rtaudio/RtAudio.h"
+#include <atomic>
 #include <iostream>
+#include <memory>
 #include <cstdlib>
+#include <vector>
 
 namespace lab {
 
@@ -29,11 +33,42 @@ public:
 
     float sampleRate() const override { return m_sampleRate; }
 
-    void render(int numberOfFrames, void * outputBuffer, void * inputBuffer);
+    // The rate the open stream actually runs at. When the device refuses the
+    // graph's rate the stream opens at the device's preferred rate instead
+    // and render() bridges the difference with a SincResampler, so the graph
+    // and its rate-dependent state never notice.
+    float deviceSampleRate() const override { return m_deviceSampleRate; }
+
+    // Reopen against the current default device (it may be a different one,
+    // at a different rate, than the stream was opened with). The bridge is
+    // rebuilt around the new rate; the graph keeps rendering at m_sampleRate.
+    void handleDeviceChange() override;
+
+    // The stream clock rtaudio hands the output callback, and the open
+    // stream's reported latency; see AudioDestination.
+    double streamTime() const override { return m_streamTime.load(std::memory_order_relaxed); }
+    double outputLatency() const override { return m_outputLatencySeconds; }
+
+    // The period the open stream actually granted, in frames; under a
+    // low-latency request this can be smaller than the render quantum.
+    unsigned int callbackBufferSize() const override { return m_callbackBufferFrames; }
+
+    size_t channelCount() const { return m_numChannels; }
+
+    void render(int numberOfFrames, void * outputBuffer, void * inputBuffer, double streamTime);
 
 private:
 
     void configure();
+    void readGraphFrames(AudioBus * bus, size_t framesToProcess);
+
+    // Feeds context-rate frames to the resampling bridge by pulling whole
+    // graph quanta through the spill store below.
+    struct GraphReader : public AudioSourceProvider
+    {
+        AudioDestinationLinux * destination = nullptr;
+        virtual void provideInput(AudioBus * bus, size_t framesToProcess) override;
+    };
 
     AudioIOCallback & m_callback;
 
@@ -42,6 +77,29 @@ private:
 
     size_t m_numChannels;
     float m_sampleRate;
+    float m_deviceSampleRate = 0;
+
+    std::atomic<double> m_streamTime{0};
+    double m_outputLatencySeconds = 0;
+    bool m_callbackPolicyApplied = false;
+    unsigned int m_callbackBufferFrames = 0;
+
+    // Spill machinery for device periods other than the render quantum; see render().
+    std::unique_ptr<AudioBus> m_quantumBus;
+    std::unique_ptr<AudioBus> m_quantumInputBus;
+    std::vector<float> m_spill;
+    std::vector<float> m_inputRing;
+    size_t m_spillFrames = 0;
+    size_t m_spillOffset = 0;
+    size_t m_inputRingFrames = 0;
+
+    // Rate bridge, present only when the stream runs at a rate other than
+    // the graph's. The device callback pulls through the resampler, so
+    // consumption is self-pacing: clock drift between the nominal rates is
+    // absorbed by the pull, with no fill level to servo.
+    GraphReader m_graphReader;
+    std::unique_ptr<SincResampler> m_resampler;
+    std::vector<float> m_resampleOut; // interleaved landing buffer
 
     RtAudio dac;
 };
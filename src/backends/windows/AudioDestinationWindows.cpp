@@ -3,6 +3,7 @@
 // Copyright (C) 2015+, The LabSound Authors. All rights reserved.
 
 #include "AudioDestinationWindows.h"
+#include "internal/AudioThreads.h"
 #include "internal/VectorMath.h"
 
 #include "LabSound/core/AudioNode.h"
@@ -45,6 +46,16 @@ unsigned long AudioDestination::maxChannelCount()
     return NumDefaultOutputChannels();
 }
 
+float AudioDestination::hardwareSampleRate()
+{
+    RtAudio audio;
+    if (!audio.getDeviceCount())
+        return 0;
+
+    auto info = audio.getDeviceInfo(audio.getDefaultOutputDevice());
+    return info.probed ? static_cast<float>(info.preferredSampleRate) : 0;
+}
+
 AudioDestinationWin::AudioDestinationWin(AudioIOCallback & callback, size_t numChannels, float sampleRate)
 : m_callback(callback)
 , m_renderBus(numChannels, AudioNode::ProcessingSizeInFrames, false)
@@ -90,21 +101,59 @@ void AudioDestinationWin::configure()
         m_inputBus = std::make_unique<AudioBus>(1, AudioNode::ProcessingSizeInFrames, false);
     }
 
-    unsigned int bufferFrames = AudioNode::ProcessingSizeInFrames;
-
-    RtAudio::StreamOptions options;
-    options.flags |= RTAUDIO_NONINTERLEAVED;
-
-    try
+    // When low latency is requested, try to hog the device (exclusive mode on
+    // APIs that have one, such as WASAPI) at the smallest period the driver
+    // will grant, with the callback thread scheduled realtime. rtaudio's
+    // WASAPI path is event driven -- the callback wakes at period boundaries
+    // rather than polling -- so shrinking the period is what actually
+    // shortens the output path. Each rung of the ladder relaxes one demand
+    // until the open succeeds.
+    struct OpenAttempt
+    {
+        RtAudioStreamFlags extraFlags;
+        unsigned int frames;
+    };
+    std::vector<OpenAttempt> attempts;
+    if (lowLatencyRequested())
     {
-        dac.openStream(outDeviceInfo.probed ? &outputParams : nullptr, 
-                       inDeviceInfo.probed ? &inputParams : nullptr, 
-            RTAUDIO_FLOAT32, 
-            (unsigned int) m_sampleRate, &bufferFrames, &outputCallback, this, &options);
+        unsigned int preferred = preferredBufferFrames() ? preferredBufferFrames() : AudioNode::ProcessingSizeInFrames;
+        attempts.push_back({RTAUDIO_HOG_DEVICE | RTAUDIO_MINIMIZE_LATENCY | RTAUDIO_SCHEDULE_REALTIME, preferred});
+        attempts.push_back({RTAUDIO_MINIMIZE_LATENCY | RTAUDIO_SCHEDULE_REALTIME, preferred});
     }
-    catch (RtAudioError & e)
+    attempts.push_back({0, AudioNode::ProcessingSizeInFrames});
+
+    for (size_t attempt = 0; attempt < attempts.size(); ++attempt)
     {
-        e.printMessage();
+        RtAudio::StreamOptions options;
+        options.flags = RTAUDIO_NONINTERLEAVED | attempts[attempt].extraFlags;
+
+        // openStream adjusts bufferFrames to the period actually granted
+        unsigned int bufferFrames = attempts[attempt].frames;
+
+        try
+        {
+            dac.openStream(outDeviceInfo.probed ? &outputParams : nullptr,
+                           inDeviceInfo.probed ? &inputParams : nullptr,
+                RTAUDIO_FLOAT32,
+                (unsigned int) m_sampleRate, &bufferFrames, &outputCallback, this, &options);
+
+            m_callbackBufferFrames = bufferFrames;
+
+            // The stream's reported latency (in frames) only changes with the
+            // stream configuration, so capture it once here.
+            long latencyFrames = dac.getStreamLatency();
+            if (latencyFrames > 0)
+                m_outputLatencySeconds = latencyFrames / static_cast<double>(m_sampleRate);
+
+            if (attempts[attempt].extraFlags)
+                LOG("Low latency stream opened with a %u frame period", bufferFrames);
+            break;
+        }
+        catch (RtAudioError & e)
+        {
+            if (attempt + 1 == attempts.size())
+                e.printMessage();
+        }
     }
 }
 
@@ -133,33 +182,116 @@ void AudioDestinationWin::stop()
 }
 
 // Pulls on our provider to get rendered audio stream.
-void AudioDestinationWin::render(int numberOfFrames, void * outputBuffer, void * inputBuffer)
+void AudioDestinationWin::render(int numberOfFrames, void * outputBuffer, void * inputBuffer, double streamTime)
 {
+    // The platform audio layer owns this thread, so the policy is applied
+    // from the first callback rather than at spawn.
+    if (!m_callbackPolicyApplied)
+    {
+        ApplyThreadPolicy(AudioContext::ThreadRole::DeviceCallback, "audio callback");
+        m_callbackPolicyApplied = true;
+    }
+
+    // publish the device stream clock for streamTime()
+    m_streamTime.store(streamTime, std::memory_order_relaxed);
+
     float *myOutputBufferOfFloats = (float*) outputBuffer;
     float *myInputBufferOfFloats = (float*) inputBuffer;
 
-    // Inform bus to use an externally allocated buffer from rtaudio
-    if (m_renderBus.isFirstTime())
+    const int quantum = AudioNode::ProcessingSizeInFrames;
+
+    if (numberOfFrames == quantum)
     {
-        for (uint32_t i = 0; i < m_numChannels; ++i)
+        // Inform bus to use an externally allocated buffer from rtaudio
+        if (m_renderBus.isFirstTime())
+        {
+            for (uint32_t i = 0; i < m_numChannels; ++i)
+            {
+                m_renderBus.setChannelMemory(i, myOutputBufferOfFloats + i * numberOfFrames, numberOfFrames);
+            }
+        }
+
+        if (m_inputBus && m_inputBus->isFirstTime())
         {
-            m_renderBus.setChannelMemory(i, myOutputBufferOfFloats + i * numberOfFrames, numberOfFrames);
+            m_inputBus->setChannelMemory(0, myInputBufferOfFloats, numberOfFrames);
         }
+
+        // Source Bus :: Destination Bus
+        m_callback.render(m_inputBus.get(), &m_renderBus, numberOfFrames);
+
+        // Clamp values at 0db (i.e., [-1.0, 1.0])
+        for (unsigned i = 0; i < m_renderBus.numberOfChannels(); ++i)
+        {
+            AudioChannel * channel = m_renderBus.channel(i);
+            VectorMath::vclip(channel->data(), 1, &kLowThreshold, &kHighThreshold, channel->mutableData(), 1, numberOfFrames);
+        }
+        return;
     }
 
-    if (m_inputBus && m_inputBus->isFirstTime())
+    // The device granted a period other than the render quantum (exclusive
+    // mode grants whatever period the hardware runs at). The graph renders
+    // fixed-size quanta, so pull whole quanta into an internal bus and carry
+    // the remainder across callbacks.
+    if (!m_quantumBus)
     {
-        m_inputBus->setChannelMemory(0, myInputBufferOfFloats, numberOfFrames);
+        m_quantumBus = std::make_unique<AudioBus>(static_cast<unsigned>(m_numChannels), quantum, true);
+        m_quantumBus->setSampleRate(m_sampleRate);
+        m_spill.resize(m_numChannels * quantum);
+        if (m_inputBus)
+        {
+            m_quantumInputBus = std::make_unique<AudioBus>(1, quantum, true);
+            m_inputRing.resize(4 * quantum);
+        }
     }
 
-    // Source Bus :: Destination Bus
-    m_callback.render(m_inputBus.get(), &m_renderBus, numberOfFrames);
+    // stash the device's input so quantum renders can consume it
+    if (myInputBufferOfFloats && m_quantumInputBus)
+    {
+        for (int i = 0; i < numberOfFrames && m_inputRingFrames < m_inputRing.size(); ++i)
+            m_inputRing[m_inputRingFrames++] = myInputBufferOfFloats[i];
+    }
 
-    // Clamp values at 0db (i.e., [-1.0, 1.0])
-    for (unsigned i = 0; i < m_renderBus.numberOfChannels(); ++i)
+    int framesFilled = 0;
+    while (framesFilled < numberOfFrames)
     {
-        AudioChannel * channel = m_renderBus.channel(i);
-        VectorMath::vclip(channel->data(), 1, &kLowThreshold, &kHighThreshold, channel->mutableData(), 1, numberOfFrames);
+        if (!m_spillFrames)
+        {
+            if (m_quantumInputBus)
+            {
+                float * in = m_quantumInputBus->channel(0)->mutableData();
+                size_t have = m_inputRingFrames < (size_t) quantum ? m_inputRingFrames : (size_t) quantum;
+                memcpy(in, m_inputRing.data(), have * sizeof(float));
+                if (have < (size_t) quantum)
+                    memset(in + have, 0, (quantum - have) * sizeof(float));
+                memmove(m_inputRing.data(), m_inputRing.data() + have, (m_inputRingFrames - have) * sizeof(float));
+                m_inputRingFrames -= have;
+            }
+
+            m_callback.render(m_quantumInputBus.get(), m_quantumBus.get(), quantum);
+
+            for (unsigned i = 0; i < m_numChannels; ++i)
+            {
+                AudioChannel * channel = m_quantumBus->channel(i);
+                VectorMath::vclip(channel->data(), 1, &kLowThreshold, &kHighThreshold, channel->mutableData(), 1, quantum);
+                memcpy(m_spill.data() + i * quantum, channel->data(), quantum * sizeof(float));
+            }
+            m_spillOffset = 0;
+            m_spillFrames = quantum;
+        }
+
+        int frames = numberOfFrames - framesFilled;
+        if (frames > (int) m_spillFrames)
+            frames = (int) m_spillFrames;
+
+        for (unsigned i = 0; i < m_numChannels; ++i)
+        {
+            memcpy(myOutputBufferOfFloats + i * numberOfFrames + framesFilled,
+                   m_spill.data() + i * quantum + m_spillOffset,
+                   frames * sizeof(float));
+        }
+        framesFilled += frames;
+        m_spillOffset += frames;
+        m_spillFrames -= frames;
     }
 }
 
@@ -167,12 +299,12 @@ int outputCallback(void * outputBuffer, void * inputBuffer, unsigned int nBuffer
 {
     float *fBufOut = (float*) outputBuffer;
 
-    // Buffer is nBufferFrames * channels
-    // NB: channel count should be set in a principled way
-    memset(fBufOut, 0, sizeof(float) * nBufferFrames * 2);
-
     AudioDestinationWin * audioDestination = static_cast<AudioDestinationWin*>(userData);
-    audioDestination->render(nBufferFrames, fBufOut, inputBuffer);
+
+    // Buffer is nBufferFrames * channels, noninterleaved
+    memset(fBufOut, 0, sizeof(float) * nBufferFrames * audioDestination->channelCount());
+
+    audioDestination->render(nBufferFrames, fBufOut, inputBuffer, streamTime);
 
     return 0;
 }
@@ -11,9 +11,11 @@
 #include "internal/AudioDestination.h"
 
 #include "rtaudio/RtAudio.h"
+#include <atomic>
 #include <iostream>
 #include <memory>
 #include <cstdlib>
+#include <vector>
 
 namespace lab {
 
@@ -30,7 +32,18 @@ public:
 
     float sampleRate() const override { return m_sampleRate; }
 
-    void render(int numberOfFrames, void * outputBuffer, void * inputBuffer);
+    // The stream clock rtaudio hands the output callback, and the open
+    // stream's reported latency; see AudioDestination.
+    double streamTime() const override { return m_streamTime.load(std::memory_order_relaxed); }
+    double outputLatency() const override { return m_outputLatencySeconds; }
+
+    // The period the open stream actually granted, in frames; under a
+    // low-latency request this can be smaller than the render quantum.
+    unsigned int callbackBufferSize() const override { return m_callbackBufferFrames; }
+
+    size_t channelCount() const { return m_numChannels; }
+
+    void render(int numberOfFrames, void * outputBuffer, void * inputBuffer, double streamTime);
 
 private:
     void configure();
@@ -40,6 +53,20 @@ private:
     std::unique_ptr<AudioBus> m_inputBus;
     size_t m_numChannels;
     float m_sampleRate;
+    std::atomic<double> m_streamTime{0};
+    double m_outputLatencySeconds = 0;
+    bool m_callbackPolicyApplied = false;
+    unsigned int m_callbackBufferFrames = 0;
+
+    // Spill machinery for device periods other than the render quantum; see render().
+    std::unique_ptr<AudioBus> m_quantumBus;
+    std::unique_ptr<AudioBus> m_quantumInputBus;
+    std::vector<float> m_spill;
+    std::vector<float> m_inputRing;
+    size_t m_spillFrames = 0;
+    size_t m_spillOffset = 0;
+    size_t m_inputRingFrames = 0;
+
     RtAudio dac;
 };
 
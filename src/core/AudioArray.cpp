@@ -0,0 +1,43 @@
+// License: BSD 3 Clause
+// Copyright (C) 2010, Google Inc. All rights reserved.
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/core/AudioArray.h"
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+namespace lab {
+
+void * audioBufferAllocate(size_t bytes)
+{
+    if (!bytes)
+        return nullptr;
+
+#if defined(_MSC_VER)
+    void * p = _aligned_malloc(bytes, kAudioBufferAlignment);
+#else
+    void * p = nullptr;
+    if (posix_memalign(&p, kAudioBufferAlignment, bytes))
+        p = nullptr;
+#endif
+
+    if (p)
+        memset(p, 0, bytes);
+    return p;
+}
+
+void audioBufferFree(void * p)
+{
+    if (!p)
+        return;
+
+#if defined(_MSC_VER)
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+} // lab
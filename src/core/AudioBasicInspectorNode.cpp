@@ -17,15 +17,6 @@ AudioBasicInspectorNode::AudioBasicInspectorNode(int outputChannelCount) : Audio
     initialize();
 }
 
-// We override pullInputs() as an optimization allowing this node to take advantage of in-place processing,
-// where the input is simply passed through unprocessed to the output.
-// Note: this only applies if the input and output channel counts match.
-void AudioBasicInspectorNode::pullInputs(ContextRenderLock& r, size_t framesToProcess)
-{
-    // Render input stream - try to render directly into output bus for pass-through processing where process() doesn't need to do anything...
-    input(0)->pull(r, output(0)->bus(r), framesToProcess);
-}
-
 void AudioBasicInspectorNode::checkNumberOfChannelsForInput(ContextRenderLock& r, AudioNodeInput* input)
 {
     if (input != this->input(0).get())
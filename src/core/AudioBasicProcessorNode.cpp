@@ -3,13 +3,18 @@
 // Copyright (C) 2015+, The LabSound Authors. All rights reserved.
 
 #include "LabSound/core/AudioBasicProcessorNode.h"
+#include "LabSound/core/AudioContext.h"
 #include "LabSound/core/AudioNodeInput.h"
 #include "LabSound/core/AudioNodeOutput.h"
 #include "LabSound/core/AudioProcessor.h"
 #include "LabSound/core/AudioBus.h"
 
+#include "LabSound/extended/AudioContextLock.h"
+
 #include "internal/Assertions.h"
 
+#include <cmath>
+
 namespace lab {
 
 AudioBasicProcessorNode::AudioBasicProcessorNode() : AudioNode()
@@ -42,34 +47,141 @@ void AudioBasicProcessorNode::uninitialize()
     AudioNode::uninitialize();
 }
 
+void AudioBasicProcessorNode::pullInputs(ContextRenderLock& r, size_t framesToProcess)
+{
+    // A bypassed tail passes its input straight through (see
+    // AudioNode::processIfNecessary); the chain must then render un-fused so
+    // the input junction actually holds the upstream bus.
+    m_fusedStages = m_bypassedThisQuantum ? nullptr : r.context()->fusedChainFor(this);
+    if (!m_fusedStages)
+    {
+        m_fusedSourceBus = nullptr;
+        AudioNode::pullInputs(r, framesToProcess);
+        return;
+    }
+
+    // The interior stages were elided from the render schedule; pull the
+    // chain head's input directly, suggesting our output bus as the render
+    // target so the whole chain can run over one buffer.
+    AudioBasicProcessorNode* head = m_fusedStages->front();
+    m_fusedSourceBus = head->input(0)->pull(r, canProcessInPlace() ? output(0)->bus(r) : nullptr, framesToProcess);
+}
+
+bool AudioBasicProcessorNode::inputsAreSilent(ContextRenderLock& r)
+{
+    // In fused mode this node's own input junction was never pulled; the
+    // bus that was actually consumed is the chain head's.
+    if (m_fusedStages)
+        return !m_fusedSourceBus || m_fusedSourceBus->isSilent();
+
+    return AudioNode::inputsAreSilent(r);
+}
+
+bool AudioBasicProcessorNode::propagatesSilence(ContextRenderLock& r) const
+{
+    if (!m_fusedStages)
+        return AudioNode::propagatesSilence(r);
+
+    // The chain keeps ringing for the sum of every stage's tail.
+    double tailSeconds = latencyTime(r) + tailTime(r);
+    for (AudioBasicProcessorNode * stage : *m_fusedStages)
+        tailSeconds += stage->latencyTime(r) + stage->tailTime(r);
+
+    return lastNonSilentTime() + tailSeconds < r.context()->currentTime();
+}
+
 void AudioBasicProcessorNode::process(ContextRenderLock& r, size_t framesToProcess)
 {
+    if (m_fusedStages)
+    {
+        processFusedChain(r, framesToProcess);
+        return;
+    }
+
     AudioBus* destinationBus = output(0)->bus(r);
-    
+
     if (!isInitialized() || !processor() || processor()->numberOfChannels() != numberOfChannels())
         destinationBus->zero();
     else {
         AudioBus* sourceBus = input(0)->bus(r);
 
-        // FIXME: if we take "tail time" into account, then we can avoid calling processor()->process() once the tail dies down.
         if (!input(0)->isConnected())
             sourceBus->zero();
 
+        // Tail-time aware fast path: once the input has been silent for
+        // longer than the processor's tail and latency, there is nothing
+        // left to ring out and the output is silence. zero() sets the
+        // silent flag, so downstream nodes skip these quanta as well.
+        if (sourceBus->isSilent())
+        {
+            if (m_tailFramesRemaining <= 0)
+            {
+                destinationBus->zero();
+                return;
+            }
+            m_tailFramesRemaining -= static_cast<int64_t>(framesToProcess);
+        }
+        else
+        {
+            double tailSeconds = processor()->tailTime(r) + processor()->latencyTime(r);
+            m_tailFramesRemaining = static_cast<int64_t>(ceil(tailSeconds * r.context()->sampleRate()));
+        }
+
         processor()->process(r, sourceBus, destinationBus, framesToProcess);
     }
 }
 
-// Nice optimization in the very common case allowing for "in-place" processing
-void AudioBasicProcessorNode::pullInputs(ContextRenderLock& r, size_t framesToProcess)
+void AudioBasicProcessorNode::processFusedChain(ContextRenderLock& r, size_t framesToProcess)
 {
-    // Render input stream - suggest to the input to render directly into output bus for in-place processing in process() if possible.
-    input(0)->pull(r, output(0)->bus(r), framesToProcess);
+    AudioBus* destinationBus = output(0)->bus(r);
+    const AudioBus* sourceBus = m_fusedSourceBus;
+    const std::vector<AudioBasicProcessorNode *> * stages = m_fusedStages;
+    size_t channels = destinationBus->numberOfChannels();
+
+    m_fusedStages = nullptr;
+    m_fusedSourceBus = nullptr;
+
+    if (!sourceBus)
+    {
+        destinationBus->zero();
+        return;
+    }
+
+    // One buffer, every stage: the first processor lands in the output bus
+    // and the rest process it in place (the index-aligned contract every
+    // AudioProcessor in the tree already honors). Each processor's own
+    // silent-quantum handling still applies per stage, so silence drains
+    // tails and then short-circuits exactly as in the un-fused path.
+    for (AudioBasicProcessorNode * stage : *stages)
+    {
+        // A stage bypassed after this schedule was built passes through.
+        if (stage->bypassed())
+            continue;
+
+        AudioProcessor * p = stage->processor();
+        if (!stage->isInitialized() || !p || p->numberOfChannels() != channels || sourceBus->numberOfChannels() != channels)
+        {
+            // A stage is mid-reconfiguration; mirror the un-fused path's
+            // response to a processor that can't run.
+            destinationBus->zero();
+            return;
+        }
+        p->process(r, sourceBus, destinationBus, framesToProcess);
+        sourceBus = destinationBus;
+    }
+
+    if (!isInitialized() || !processor() || processor()->numberOfChannels() != channels)
+        destinationBus->zero();
+    else
+        processor()->process(r, sourceBus, destinationBus, framesToProcess);
 }
 
 void AudioBasicProcessorNode::reset(ContextRenderLock&)
 {
     if (processor())
         processor()->reset();
+
+    m_tailFramesRemaining = 0;
 }
 
 // As soon as we know the channel count of our input, we can lazily initialize.
@@ -8,6 +8,10 @@
 #include "internal/VectorMath.h"
 #include "internal/Assertions.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include <algorithm>
 #include <assert.h>
 #include <math.h>
@@ -18,12 +22,29 @@ using namespace VectorMath;
 
 const unsigned MaxBusChannels = 32;
 
-AudioBus::AudioBus(size_t numberOfChannels, size_t length, bool allocate) : m_length(length)
+AudioBus::AudioBus(size_t numberOfChannels, size_t length, bool allocate, bool contiguous) : m_length(length)
 {
     ASSERT(numberOfChannels <= MaxBusChannels);
     if (numberOfChannels > MaxBusChannels) return;
 
-    for (uint32_t i = 0; i < numberOfChannels; ++i) 
+    if (allocate && contiguous && numberOfChannels > 0)
+    {
+        // one aligned block, channels planar and back to back; pad the
+        // per-channel stride to a multiple of four floats so every channel
+        // stays 16 byte aligned
+        size_t stride = (length + 3) & ~size_t(3);
+        m_contiguousStorage.reset(new AudioFloatArray(stride * numberOfChannels));
+
+        for (uint32_t i = 0; i < numberOfChannels; ++i)
+        {
+            AudioChannel * newChannel = new AudioChannel(m_contiguousStorage->data() + i * stride, length);
+            newChannel->zero();  // match the silent initial state of managed channels
+            m_channels.emplace_back(std::unique_ptr<AudioChannel>(newChannel));
+        }
+        return;
+    }
+
+    for (uint32_t i = 0; i < numberOfChannels; ++i)
     {
 		AudioChannel * newChannel{ nullptr };
         if (allocate) newChannel = new AudioChannel(length);
@@ -41,6 +62,14 @@ void AudioBus::setChannelMemory(size_t channelIndex, float * storage, size_t len
     }
 }
 
+size_t AudioBus::memoryBytes() const
+{
+    size_t bytes = 0;
+    for (size_t i = 0; i < m_channels.size(); ++i)
+        bytes += m_channels[i]->memoryBytes();
+    return bytes;
+}
+
 void AudioBus::resizeSmaller(size_t newLength)
 {
     ASSERT(newLength <= m_length);
@@ -182,12 +211,92 @@ std::unique_ptr<AudioBus> AudioBus::createBufferFromRange(const AudioBus* source
     return audioBus;
 }
 
+void AudioBus::interleave(float * dest, size_t frames) const
+{
+    size_t channels = numberOfChannels();
+    if (!channels || !dest) return;
+    frames = std::min(frames, m_length);
+
+    if (channels == 1)
+    {
+        memcpy(dest, channel(0)->data(), frames * sizeof(float));
+        return;
+    }
+
+    if (channels == 2)
+    {
+        const float * left = channel(0)->data();
+        const float * right = channel(1)->data();
+        size_t n4 = frames & ~size_t(3);
+#ifdef __SSE2__
+        for (size_t i = 0; i < n4; i += 4)
+        {
+            __m128 l = _mm_loadu_ps(left + i);
+            __m128 r = _mm_loadu_ps(right + i);
+            _mm_storeu_ps(dest + 2 * i, _mm_unpacklo_ps(l, r));
+            _mm_storeu_ps(dest + 2 * i + 4, _mm_unpackhi_ps(l, r));
+        }
+#else
+        for (size_t i = 0; i < n4; ++i)
+        {
+            dest[2 * i] = left[i];
+            dest[2 * i + 1] = right[i];
+        }
+#endif
+        for (size_t i = n4; i < frames; ++i)
+        {
+            dest[2 * i] = left[i];
+            dest[2 * i + 1] = right[i];
+        }
+        return;
+    }
+
+    for (size_t c = 0; c < channels; ++c)
+    {
+        const float * src = channel(c)->data();
+        for (size_t i = 0; i < frames; ++i)
+            dest[i * channels + c] = src[i];
+    }
+}
+
+void AudioBus::deinterleave(const float * source, size_t frames)
+{
+    size_t channels = numberOfChannels();
+    if (!channels || !source) return;
+    frames = std::min(frames, m_length);
+
+    float * dests[MaxBusChannels];
+    for (size_t c = 0; c < channels; ++c)
+        dests[c] = channel(c)->mutableData();
+
+    VectorMath::vdeintlvem(source, dests, channels, frames);
+}
+
 float AudioBus::maxAbsValue() const
 {
+    // Scan all channels with one kernel invocation per group, skipping
+    // channels already known silent.
+    const size_t MaxStackChannels = 8;
+    const float * sources[MaxStackChannels];
+
     float max = 0.0f;
-    for (size_t i = 0; i < numberOfChannels(); ++i) 
-	{
-        max = std::max(max, channel(i)->maxAbsValue());
+    size_t i = 0;
+    while (i < numberOfChannels())
+    {
+        size_t n = 0;
+        for (; n < MaxStackChannels && i < numberOfChannels(); ++i)
+        {
+            const AudioChannel * c = channel(i);
+            if (!c->isSilent())
+                sources[n++] = c->data();
+        }
+
+        if (n)
+        {
+            float groupMax = 0.0f;
+            VectorMath::vmaxmgvm(sources, n, &groupMax, length());
+            max = std::max(max, groupMax);
+        }
     }
 
     return max;
@@ -195,6 +304,21 @@ float AudioBus::maxAbsValue() const
 
 void AudioBus::normalize()
 {
+    // Canonical channel counts go through the fused scan-and-scale kernel,
+    // which elides the rescale pass when the bus is silent or already peaks
+    // at 1. Wider layouts fall back to the generic two-call path.
+    const size_t MaxStackChannels = 8;
+
+    if (numberOfChannels() <= MaxStackChannels)
+    {
+        float * channels[MaxStackChannels];
+        for (size_t i = 0; i < numberOfChannels(); ++i)
+            channels[i] = channel(i)->mutableData();
+
+        VectorMath::vnormalizem(channels, numberOfChannels(), 1.0f, length());
+        return;
+    }
+
     float max = maxAbsValue();
     if (max) scale(1.0f / max);
 }
@@ -262,199 +386,387 @@ void AudioBus::sumFrom(const AudioBus &sourceBus, ChannelInterpretation channelI
     }
 }
 
-void AudioBus::speakersCopyFrom(const AudioBus& sourceBus)
+// Fixed-topology mixing kernels. The channel counts are template parameters,
+// so the loops below have compile-time trip counts and there is no
+// interpretation or channel-count branching left at call time.
+namespace
 {
-    // FIXME: Implement down mixing 5.1 to stereo.
-    // https://bugs.webkit.org/show_bug.cgi?id=79192
-    
-    const size_t numberOfSourceChannels = sourceBus.numberOfChannels();
-    const size_t numberOfDestinationChannels = numberOfChannels();
-    
-    if (numberOfDestinationChannels == Channels::Stereo && numberOfSourceChannels == Channels::Mono) 
-	{
-        // Handle mono -> stereo case (for now simply copy mono channel into both left and right)
-        // FIXME: Really we should apply an equal-power scaling factor here, since we're effectively panning center...
-        const AudioChannel* sourceChannel = sourceBus.channel(0);
-        channelByType(Channel::Left)->copyFrom(sourceChannel);
-        channelByType(Channel::Right)->copyFrom(sourceChannel);
-    } 
-	else if (numberOfDestinationChannels == Channels::Mono && numberOfSourceChannels == Channels::Stereo) 
-	{
-        // Handle stereo -> mono case. output = 0.5 * (input.L + input.R).
-        AudioBus& sourceBusSafe = const_cast<AudioBus&>(sourceBus);
-        
-        const float * sourceL = sourceBusSafe.channelByType(Channel::Left)->data();
-        const float * sourceR = sourceBusSafe.channelByType(Channel::Right)->data();
-        
-        float * destination = channelByType(Channel::Left)->mutableData();
-        vadd(sourceL, 1, sourceR, 1, destination, 1, length());
-        float scale = 0.5;
-        vsmul(destination, 1, &scale, destination, 1, length());
-    } 
-	else if (numberOfDestinationChannels == Channels::Surround_5_1 && numberOfSourceChannels == Channels::Mono) 
-	{
-        // Handle mono -> 5.1 case, copy mono channel to center.
-        channelByType(Channel::Center)->copyFrom(sourceBus.channel(0));
-        channelByType(Channel::Left)->zero();
-        channelByType(Channel::Right)->zero();
-        channelByType(Channel::LFE)->zero();
-        channelByType(Channel::SurroundLeft)->zero();
-        channelByType(Channel::SurroundRight)->zero();
-    } 
-	else if (numberOfDestinationChannels == Channels::Mono && numberOfSourceChannels == Channels::Surround_5_1) 
-	{
-        // Handle 5.1 -> mono case.
-        zero();
-        speakersSumFrom5_1_ToMono(sourceBus);
-    } 
-	else if (numberOfDestinationChannels == Channels::Surround_7_1 && numberOfSourceChannels == Channels::Mono) 
-	{
-        // Handle mono -> 7.1 case, copy mono channel to center.
-        channelByType(Channel::Center)->copyFrom(sourceBus.channel(0));
-        channelByType(Channel::Left)->zero();
-        channelByType(Channel::Right)->zero();
-        channelByType(Channel::LFE)->zero();
-        channelByType(Channel::SurroundLeft)->zero();
-        channelByType(Channel::SurroundRight)->zero();
-        channelByType(Channel::BackLeft)->zero();
-        channelByType(Channel::BackRight)->zero();
-    } 
-	else if (numberOfDestinationChannels == Channels::Mono && numberOfSourceChannels == Channels::Surround_7_1) 
-	{
-        // Handle 7.1 -> mono case.
-        zero();
-        speakersSumFrom7_1_ToMono(sourceBus);
-    } 
-	else 
-	{
-        // Fallback for unknown combinations.
-        discreteCopyFrom(sourceBus);
+    template <size_t ChannelCount>
+    void copyMatched(AudioBus & destination, const AudioBus & source)
+    {
+        for (size_t i = 0; i < ChannelCount; ++i)
+            destination.channel(i)->copyFrom(source.channel(i));
+    }
+
+    template <size_t ChannelCount>
+    void sumMatched(AudioBus & destination, const AudioBus & source)
+    {
+        for (size_t i = 0; i < ChannelCount; ++i)
+            destination.channel(i)->sumFrom(source.channel(i));
+    }
+
+    void copyMonoToStereo(AudioBus & destination, const AudioBus & source)
+    {
+        destination.channel(0)->copyFrom(source.channel(0));
+        destination.channel(1)->copyFrom(source.channel(0));
+    }
+
+    void sumMonoToStereo(AudioBus & destination, const AudioBus & source)
+    {
+        destination.channel(0)->sumFrom(source.channel(0));
+        destination.channel(1)->sumFrom(source.channel(0));
+    }
+
+    void copyGeneric(AudioBus & destination, const AudioBus & source)
+    {
+        destination.copyFrom(source);
+    }
+
+    void sumGeneric(AudioBus & destination, const AudioBus & source)
+    {
+        destination.sumFrom(source);
+    }
+
+    // Kernels whose coefficient matrix is resolved exactly once per topology
+    // pair, on first use, and executed without re-derivation thereafter.
+    template <size_t SourceChannels, size_t DestinationChannels>
+    void sumBySpeakerMatrix(AudioBus & destination, const AudioBus & source)
+    {
+        static const AudioBus::ChannelMixMatrix matrix = AudioBus::speakerMixMatrix(SourceChannels, DestinationChannels);
+        destination.sumFromByMatrix(source, matrix);
+    }
+
+    template <size_t SourceChannels, size_t DestinationChannels>
+    void copyBySpeakerMatrix(AudioBus & destination, const AudioBus & source)
+    {
+        static const AudioBus::ChannelMixMatrix matrix = AudioBus::speakerMixMatrix(SourceChannels, DestinationChannels);
+        destination.copyFromByMatrix(source, matrix);
     }
 }
 
-void AudioBus::speakersSumFrom(const AudioBus& sourceBus)
+AudioBus::MixFunction AudioBus::selectSumFunction(size_t sourceChannels, size_t destinationChannels)
 {
-    // FIXME: Implement down mixing 5.1 && 7.1 to stereo.
-    // https://bugs.webkit.org/show_bug.cgi?id=79192
-    
-    const size_t numberOfSourceChannels = sourceBus.numberOfChannels();
-    const size_t numberOfDestinationChannels = numberOfChannels();
-    
-    if (numberOfDestinationChannels == Channels::Stereo && numberOfSourceChannels == Channels::Mono)
-	{
-        // Handle mono -> stereo case (summing mono channel into both left and right).
-        const AudioChannel* sourceChannel = sourceBus.channel(0);
-        channelByType(Channel::Left)->sumFrom(sourceChannel);
-        channelByType(Channel::Right)->sumFrom(sourceChannel);
-    } 
-	else if (numberOfDestinationChannels == Channels::Mono && numberOfSourceChannels == Channels::Stereo) 
-	{
-        // Handle stereo -> mono case. output += 0.5 * (input.L + input.R).
-        AudioBus& sourceBusSafe = const_cast<AudioBus&>(sourceBus);
-        
-        const float * sourceL = sourceBusSafe.channelByType(Channel::Left)->data();
-        const float * sourceR = sourceBusSafe.channelByType(Channel::Right)->data();
-        
-        float * destination = channelByType(Channel::Left)->mutableData();
-        float scale = 0.5;
-        vsma(sourceL, 1, &scale, destination, 1, length());
-        vsma(sourceR, 1, &scale, destination, 1, length());
-    } 
-	else if (numberOfDestinationChannels == Channels::Surround_5_1 && numberOfSourceChannels == Channels::Mono) 
-	{
-        // Handle mono -> 5.1 case, sum mono channel into center.
-        channelByType(Channel::Center)->sumFrom(sourceBus.channel(0));
-    } 
-	else if (numberOfDestinationChannels == Channels::Mono && numberOfSourceChannels == Channels::Surround_5_1) 
-	{
-        // Handle 5.1 -> mono case.
-        speakersSumFrom5_1_ToMono(sourceBus);
-    } 
-	else if (numberOfDestinationChannels == Channels::Surround_7_1 && numberOfSourceChannels == Channels::Mono) 
-	{
-        // Handle mono -> 7.1 case, sum mono channel into center.
-        channelByType(Channel::Center)->sumFrom(sourceBus.channel(0));
-    } 
-	else if (numberOfDestinationChannels == Channels::Mono && numberOfSourceChannels == Channels::Surround_7_1) 
-	{
-        // Handle 7.1 -> mono case.
-        speakersSumFrom7_1_ToMono(sourceBus);
-    } 
-	else 
-	{
-        // Fallback for unknown combinations.
+    if (sourceChannels == Channels::Mono && destinationChannels == Channels::Mono)
+        return sumMatched<1>;
+    if (sourceChannels == Channels::Mono && destinationChannels == Channels::Stereo)
+        return sumMonoToStereo;
+    if (sourceChannels == Channels::Stereo && destinationChannels == Channels::Stereo)
+        return sumMatched<2>;
+
+    switch ((sourceChannels << 4) | destinationChannels)
+    {
+        case 0x14: return sumBySpeakerMatrix<1, 4>;
+        case 0x16: return sumBySpeakerMatrix<1, 6>;
+        case 0x18: return sumBySpeakerMatrix<1, 8>;
+        case 0x21: return sumBySpeakerMatrix<2, 1>;
+        case 0x24: return sumBySpeakerMatrix<2, 4>;
+        case 0x26: return sumBySpeakerMatrix<2, 6>;
+        case 0x28: return sumBySpeakerMatrix<2, 8>;
+        case 0x41: return sumBySpeakerMatrix<4, 1>;
+        case 0x42: return sumBySpeakerMatrix<4, 2>;
+        case 0x46: return sumBySpeakerMatrix<4, 6>;
+        case 0x48: return sumBySpeakerMatrix<4, 8>;
+        case 0x61: return sumBySpeakerMatrix<6, 1>;
+        case 0x62: return sumBySpeakerMatrix<6, 2>;
+        case 0x64: return sumBySpeakerMatrix<6, 4>;
+        case 0x68: return sumBySpeakerMatrix<6, 8>;
+        case 0x81: return sumBySpeakerMatrix<8, 1>;
+        case 0x82: return sumBySpeakerMatrix<8, 2>;
+        case 0x84: return sumBySpeakerMatrix<8, 4>;
+        case 0x86: return sumBySpeakerMatrix<8, 6>;
+    }
+    return sumGeneric;
+}
+
+AudioBus::MixFunction AudioBus::selectCopyFunction(size_t sourceChannels, size_t destinationChannels)
+{
+    if (sourceChannels == Channels::Mono && destinationChannels == Channels::Mono)
+        return copyMatched<1>;
+    if (sourceChannels == Channels::Mono && destinationChannels == Channels::Stereo)
+        return copyMonoToStereo;
+    if (sourceChannels == Channels::Stereo && destinationChannels == Channels::Stereo)
+        return copyMatched<2>;
+
+    switch ((sourceChannels << 4) | destinationChannels)
+    {
+        case 0x14: return copyBySpeakerMatrix<1, 4>;
+        case 0x16: return copyBySpeakerMatrix<1, 6>;
+        case 0x18: return copyBySpeakerMatrix<1, 8>;
+        case 0x21: return copyBySpeakerMatrix<2, 1>;
+        case 0x24: return copyBySpeakerMatrix<2, 4>;
+        case 0x26: return copyBySpeakerMatrix<2, 6>;
+        case 0x28: return copyBySpeakerMatrix<2, 8>;
+        case 0x41: return copyBySpeakerMatrix<4, 1>;
+        case 0x42: return copyBySpeakerMatrix<4, 2>;
+        case 0x46: return copyBySpeakerMatrix<4, 6>;
+        case 0x48: return copyBySpeakerMatrix<4, 8>;
+        case 0x61: return copyBySpeakerMatrix<6, 1>;
+        case 0x62: return copyBySpeakerMatrix<6, 2>;
+        case 0x64: return copyBySpeakerMatrix<6, 4>;
+        case 0x68: return copyBySpeakerMatrix<6, 8>;
+        case 0x81: return copyBySpeakerMatrix<8, 1>;
+        case 0x82: return copyBySpeakerMatrix<8, 2>;
+        case 0x84: return copyBySpeakerMatrix<8, 4>;
+        case 0x86: return copyBySpeakerMatrix<8, 6>;
+    }
+    return copyGeneric;
+}
+
+// Canonical channel orderings are index-stable across layouts for the front
+// pair, so the matrices below address channels by index: mono [C], stereo
+// [L R], quad [L R SL SR], 5.1 [L R C LFE SL SR], 7.1 [L R C LFE SL SR BL BR].
+// Downmix folds use the same -3dB (0.7071) weight for center and surrounds
+// that the previous hand-written mono folds used; LFE is dropped, matching
+// the prior behavior.
+AudioBus::ChannelMixMatrix AudioBus::speakerMixMatrix(size_t sourceChannels, size_t destinationChannels)
+{
+    ChannelMixMatrix m;
+    m.sourceChannels = sourceChannels;
+    m.destinationChannels = destinationChannels;
+
+    if (!sourceChannels || !destinationChannels
+        || sourceChannels > ChannelMixMatrix::MaxMixChannels
+        || destinationChannels > ChannelMixMatrix::MaxMixChannels)
+        return m;
+
+    auto & k = m.coefficient;
+    const float q = 0.7071f;
+
+    if (sourceChannels == destinationChannels)
+    {
+        for (size_t i = 0; i < sourceChannels; ++i)
+            k[i][i] = 1.f;
+        m.valid = true;
+        return m;
+    }
+
+    m.valid = true;
+    switch ((sourceChannels << 4) | destinationChannels)
+    {
+        case 0x12:  // mono -> stereo: both speakers
+        case 0x14:  // mono -> quad: front pair
+            k[0][0] = 1.f;
+            k[1][0] = 1.f;
+            break;
+
+        case 0x16:  // mono -> 5.1: center
+        case 0x18:  // mono -> 7.1: center
+            k[2][0] = 1.f;
+            break;
+
+        case 0x21:  // stereo -> mono
+            k[0][0] = 0.5f;
+            k[0][1] = 0.5f;
+            break;
+
+        case 0x24:  // stereo up-mixes: front pair, everything else silent
+        case 0x26:
+        case 0x28:
+            k[0][0] = 1.f;
+            k[1][1] = 1.f;
+            break;
+
+        case 0x41:  // quad -> mono
+            k[0][0] = k[0][1] = k[0][2] = k[0][3] = 0.25f;
+            break;
+
+        case 0x42:  // quad -> stereo: L = 0.5 * (L + SL)
+            k[0][0] = k[0][2] = 0.5f;
+            k[1][1] = k[1][3] = 0.5f;
+            break;
+
+        case 0x46:  // quad -> 5.1 / 7.1: speakers to their own positions
+        case 0x48:
+            k[0][0] = 1.f;
+            k[1][1] = 1.f;
+            k[4][2] = 1.f;
+            k[5][3] = 1.f;
+            break;
+
+        case 0x61:  // 5.1 -> mono
+            k[0][0] = k[0][1] = q;
+            k[0][2] = 1.f;
+            k[0][4] = k[0][5] = 0.5f;
+            break;
+
+        case 0x62:  // 5.1 -> stereo: L = L + 0.7071 * (C + SL)
+            k[0][0] = 1.f;
+            k[0][2] = k[0][4] = q;
+            k[1][1] = 1.f;
+            k[1][2] = k[1][5] = q;
+            break;
+
+        case 0x64:  // 5.1 -> quad: fronts absorb center, surrounds pass
+            k[0][0] = 1.f;
+            k[0][2] = q;
+            k[1][1] = 1.f;
+            k[1][2] = q;
+            k[2][4] = 1.f;
+            k[3][5] = 1.f;
+            break;
+
+        case 0x68:  // 5.1 -> 7.1: backs stay silent
+            for (size_t i = 0; i < 6; ++i)
+                k[i][i] = 1.f;
+            break;
+
+        case 0x81:  // 7.1 -> mono
+            k[0][0] = k[0][1] = q;
+            k[0][2] = 1.f;
+            k[0][4] = k[0][5] = k[0][6] = k[0][7] = 0.5f;
+            break;
+
+        case 0x82:  // 7.1 -> stereo: L = L + 0.7071 * (C + SL + BL)
+            k[0][0] = 1.f;
+            k[0][2] = k[0][4] = k[0][6] = q;
+            k[1][1] = 1.f;
+            k[1][2] = k[1][5] = k[1][7] = q;
+            break;
+
+        case 0x84:  // 7.1 -> quad: backs fold into surrounds
+            k[0][0] = 1.f;
+            k[0][2] = q;
+            k[1][1] = 1.f;
+            k[1][2] = q;
+            k[2][4] = 1.f;
+            k[2][6] = q;
+            k[3][5] = 1.f;
+            k[3][7] = q;
+            break;
+
+        case 0x86:  // 7.1 -> 5.1: backs fold into surrounds
+            for (size_t i = 0; i < 6; ++i)
+                k[i][i] = 1.f;
+            k[4][6] = q;
+            k[5][7] = q;
+            break;
+
+        default:  // non-canonical (e.g. 5.0); caller falls back to discrete
+            m.valid = false;
+            break;
+    }
+    return m;
+}
+
+void AudioBus::sumFromByMatrix(const AudioBus & sourceBus, const ChannelMixMatrix & matrix)
+{
+    bool topologyMatchesMatrix = matrix.valid
+        && sourceBus.numberOfChannels() == matrix.sourceChannels
+        && numberOfChannels() == matrix.destinationChannels;
+    ASSERT(topologyMatchesMatrix);
+    if (!topologyMatchesMatrix)
+    {
         discreteSumFrom(sourceBus);
+        return;
+    }
+
+    size_t framesToProcess = std::min(length(), sourceBus.length());
+
+    for (size_t d = 0; d < matrix.destinationChannels; ++d)
+    {
+        // fetched lazily so destination channels with no contribution keep
+        // their silent flag
+        float * destination = nullptr;
+
+        for (size_t s = 0; s < matrix.sourceChannels; ++s)
+        {
+            float coefficient = matrix.coefficient[d][s];
+            if (coefficient == 0.f || sourceBus.channel(s)->isSilent())
+                continue;
+
+            if (!destination)
+                destination = channel(d)->mutableData();
+
+            const float * source = sourceBus.channel(s)->data();
+            if (coefficient == 1.f)
+                vadd(source, 1, destination, 1, destination, 1, framesToProcess);
+            else
+                vsma(source, 1, &coefficient, destination, 1, framesToProcess);
+        }
     }
 }
 
-void AudioBus::speakersSumFrom5_1_ToMono(const AudioBus& sourceBus)
+void AudioBus::copyFromByMatrix(const AudioBus & sourceBus, const ChannelMixMatrix & matrix)
 {
-    AudioBus& sourceBusSafe = const_cast<AudioBus&>(sourceBus);
-    
-    const float * sourceL = sourceBusSafe.channelByType(Channel::Left)->data();
-    const float * sourceR = sourceBusSafe.channelByType(Channel::Right)->data();
-    const float * sourceC = sourceBusSafe.channelByType(Channel::Center)->data();
-    const float * sourceSL = sourceBusSafe.channelByType(Channel::SurroundLeft)->data();
-    const float * sourceSR = sourceBusSafe.channelByType(Channel::SurroundRight)->data();
-    
-    float * destination = channelByType(Channel::Left)->mutableData();
-    
-    AudioFloatArray temp(length());
-    float * tempData = temp.data();
-    
-    // Sum in L and R.
-    vadd(sourceL, 1, sourceR, 1, tempData, 1, length());
-    float scale = 0.7071f;
-    vsmul(tempData, 1, &scale, tempData, 1, length());
-    vadd(tempData, 1, destination, 1, destination, 1, length());
-    
-    // Sum in SL and SR.
-    vadd(sourceSL, 1, sourceSR, 1, tempData, 1, length());
-    scale = 0.5;
-    vsmul(tempData, 1, &scale, tempData, 1, length());
-    vadd(tempData, 1, destination, 1, destination, 1, length());
-    
-    // Sum in center.
-    vadd(sourceC, 1, destination, 1, destination, 1, length());
+    bool topologyMatchesMatrix = matrix.valid
+        && sourceBus.numberOfChannels() == matrix.sourceChannels
+        && numberOfChannels() == matrix.destinationChannels;
+    ASSERT(topologyMatchesMatrix);
+    if (!topologyMatchesMatrix)
+    {
+        discreteCopyFrom(sourceBus);
+        return;
+    }
+
+    size_t framesToProcess = std::min(length(), sourceBus.length());
+
+    for (size_t d = 0; d < matrix.destinationChannels; ++d)
+    {
+        AudioChannel * destinationChannel = channel(d);
+        bool wroteChannel = false;
+
+        for (size_t s = 0; s < matrix.sourceChannels; ++s)
+        {
+            float coefficient = matrix.coefficient[d][s];
+            if (coefficient == 0.f)
+                continue;
+
+            const AudioChannel * sourceChannel = sourceBus.channel(s);
+            if (!wroteChannel)
+            {
+                // the first contribution overwrites
+                if (sourceChannel->isSilent())
+                    destinationChannel->zero();
+                else if (coefficient == 1.f)
+                    destinationChannel->copyFrom(sourceChannel);
+                else
+                    vsmul(sourceChannel->data(), 1, &coefficient, destinationChannel->mutableData(), 1, framesToProcess);
+                wroteChannel = true;
+            }
+            else if (!sourceChannel->isSilent())
+            {
+                float * destination = destinationChannel->mutableData();
+                if (coefficient == 1.f)
+                    vadd(sourceChannel->data(), 1, destination, 1, destination, 1, framesToProcess);
+                else
+                    vsma(sourceChannel->data(), 1, &coefficient, destination, 1, framesToProcess);
+            }
+        }
+
+        if (!wroteChannel)
+            destinationChannel->zero();
+    }
 }
 
-void AudioBus::speakersSumFrom7_1_ToMono(const AudioBus& sourceBus)
+void AudioBus::speakersCopyFrom(const AudioBus& sourceBus)
 {
-    AudioBus& sourceBusSafe = const_cast<AudioBus&>(sourceBus);
-    
-    const float * sourceL = sourceBusSafe.channelByType(Channel::Left)->data();
-    const float * sourceR = sourceBusSafe.channelByType(Channel::Right)->data();
-    const float * sourceC = sourceBusSafe.channelByType(Channel::Center)->data();
-    const float * sourceSL = sourceBusSafe.channelByType(Channel::SurroundLeft)->data();
-    const float * sourceSR = sourceBusSafe.channelByType(Channel::SurroundRight)->data();
-    const float * sourceBL = sourceBusSafe.channelByType(Channel::BackLeft)->data();
-    const float * sourceBR = sourceBusSafe.channelByType(Channel::BackRight)->data();
-    
-    float * destination = channelByType(Channel::Left)->mutableData();
-    
-    AudioFloatArray temp(length());
-    float * tempData = temp.data();
-    
-    // Sum in L and R.
-    vadd(sourceL, 1, sourceR, 1, tempData, 1, length());
-    float scale = 0.7071f;
-    vsmul(tempData, 1, &scale, tempData, 1, length());
-    vadd(tempData, 1, destination, 1, destination, 1, length());
-    
-    // Sum in SL and SR.
-    vadd(sourceSL, 1, sourceSR, 1, tempData, 1, length());
-    scale = 0.5;
-    vsmul(tempData, 1, &scale, tempData, 1, length());
-    vadd(tempData, 1, destination, 1, destination, 1, length());
-    
-    // Sum in BL and BR.
-    vadd(sourceBL, 1, sourceBR, 1, tempData, 1, length());
-    scale = 0.5;
-    vsmul(tempData, 1, &scale, tempData, 1, length());
-    vadd(tempData, 1, destination, 1, destination, 1, length());
-    
-    // Sum in center.
-    vadd(sourceC, 1, destination, 1, destination, 1, length());
+    // The matrix captures all canonical layout pairs, including downmixes
+    // like 5.1 -> stereo that used to fall through to the discrete path.
+    // Connections should prefer selectCopyFunction(), which resolves the
+    // matrix once; this entry point rebuilds it per call and exists for
+    // one-off mixes and as the ChannelInterpretation::Speakers dispatch.
+    ChannelMixMatrix matrix = speakerMixMatrix(sourceBus.numberOfChannels(), numberOfChannels());
+    if (matrix.valid)
+    {
+        copyFromByMatrix(sourceBus, matrix);
+        return;
+    }
+
+    // Fallback for unknown combinations.
+    discreteCopyFrom(sourceBus);
+}
+
+void AudioBus::speakersSumFrom(const AudioBus& sourceBus)
+{
+    ChannelMixMatrix matrix = speakerMixMatrix(sourceBus.numberOfChannels(), numberOfChannels());
+    if (matrix.valid)
+    {
+        sumFromByMatrix(sourceBus, matrix);
+        return;
+    }
+
+    // Fallback for unknown combinations.
+    discreteSumFrom(sourceBus);
 }
 
 void AudioBus::discreteCopyFrom(const AudioBus & sourceBus)
@@ -517,12 +829,22 @@ void AudioBus::copyWithGainFrom(const AudioBus & sourceBus, float * lastMixGain,
         return;
     }
 
-    if (sourceBus.isSilent()) 
+    if (sourceBus.isSilent())
     {
         zero();
         return;
     }
 
+    // A gain fully settled at zero outputs silence; skip the multiply and let
+    // the silent flag set by zero() propagate downstream.
+    if (targetGain == 0 && (m_isFirstTime || *lastMixGain == 0))
+    {
+        m_isFirstTime = false;
+        *lastMixGain = 0;
+        zero();
+        return;
+    }
+
     const size_t numberOfChannels = m_channels.size();
     ASSERT(numberOfChannels <= MaxBusChannels);
 	if (numberOfChannels > MaxBusChannels) return;
@@ -565,32 +887,22 @@ void AudioBus::copyWithGainFrom(const AudioBus & sourceBus, float * lastMixGain,
     // FIXME: framesToDezipper could be smaller when target gain is close enough within this process loop.
     size_t framesToDezipper = (gainDiff < epsilon) ? 0 : framesToProcess; 
 
-    if (framesToDezipper) 
+    if (framesToDezipper)
     {
-        if (!m_dezipperGainValues.get() || m_dezipperGainValues->size() < framesToDezipper)
-        {
-            m_dezipperGainValues = std::unique_ptr<AudioFloatArray>(new AudioFloatArray(framesToDezipper));
-        }
-           
-        float * gainValues = m_dezipperGainValues->data();
-
-        for (uint32_t i = 0; i < framesToDezipper; ++i) 
+        // Every channel runs the same analytic ramp; the fused kernel
+        // computes the exponential approach inline with the multiply, so no
+        // intermediate gain array and no second memory pass. The final gain
+        // is committed once after the channels are done.
+        float rampedGain = gain;
+        for (uint32_t channelIndex = 0; channelIndex < numberOfChannels; ++channelIndex)
         {
-            gain += (totalDesiredGain - gain) * DezipperRate;
-        
-            // FIXME: If we are clever enough in calculating the framesToDezipper value, we can probably get
-            // rid of this DenormalDisabler::flushDenormalFloatToZero() call.
-            gain = DenormalDisabler::flushDenormalFloatToZero(gain);
-            *gainValues++ = gain;
-        }
-
-        for (uint32_t channelIndex = 0; channelIndex < numberOfChannels; ++channelIndex) 
-        {
-            vmul(sources[channelIndex], 1, m_dezipperGainValues->data(), 1, destinations[channelIndex], 1, framesToDezipper);
+            rampedGain = gain;
+            vexpramp(sources[channelIndex], destinations[channelIndex], totalDesiredGain, &rampedGain, DezipperRate, framesToDezipper);
             sources[channelIndex] += framesToDezipper;
             destinations[channelIndex] += framesToDezipper;
         }
-    } 
+        gain = DenormalDisabler::flushDenormalFloatToZero(rampedGain);
+    }
     else
     {
         gain = totalDesiredGain;
@@ -644,7 +956,8 @@ void AudioBus::copyWithSampleAccurateGainValuesFrom(const AudioBus &sourceBus, f
     }
 }
 
-std::unique_ptr<AudioBus> AudioBus::createBySampleRateConverting(const AudioBus* sourceBus, bool mixToMono, float newSampleRate)
+std::unique_ptr<AudioBus> AudioBus::createBySampleRateConverting(const AudioBus* sourceBus, bool mixToMono, float newSampleRate,
+                                                                 ResamplerQuality quality)
 {
     // sourceBus's sample-rate must be known.
     ASSERT(sourceBus && sourceBus->sampleRate());
@@ -708,7 +1021,7 @@ std::unique_ptr<AudioBus> AudioBus::createBySampleRateConverting(const AudioBus*
         const float* source = resamplerSourceBus->channel(i)->data();
         float* destination = destinationBus->channel(i)->mutableData();
 
-        SincResampler resampler(sampleRateRatio);
+        SincResampler resampler(sampleRateRatio, SincResampler::kernelSizeForQuality(quality));
         resampler.process(source, destination, sourceLength);
     }
 
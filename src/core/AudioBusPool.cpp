@@ -0,0 +1,76 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/core/AudioBusPool.h"
+#include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioContext.h"
+
+namespace lab {
+
+AudioBusPool::AudioBusPool(size_t length)
+    : m_length(length)
+{
+    m_free.resize(AudioContext::maxNumberOfChannels + 1);
+}
+
+AudioBusPool::~AudioBusPool()
+{
+}
+
+std::unique_ptr<AudioBus> AudioBusPool::acquire(size_t numberOfChannels)
+{
+    if (numberOfChannels < m_free.size())
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto & freeList = m_free[numberOfChannels];
+        if (freeList.size())
+        {
+            std::unique_ptr<AudioBus> bus = std::move(freeList.back());
+            freeList.pop_back();
+            bus->zero();
+            bus->clearSilentFlag();
+            bus->reset();
+            return bus;
+        }
+    }
+
+    return std::unique_ptr<AudioBus>(new AudioBus(numberOfChannels, m_length, true, true));
+}
+
+void AudioBusPool::release(std::unique_ptr<AudioBus> bus)
+{
+    if (!bus)
+        return;
+
+    size_t c = bus->numberOfChannels();
+    if (bus->length() != m_length || c >= m_free.size())
+        return; // wrong shape for this pool; let it free normally
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_free[c].emplace_back(std::move(bus));
+}
+
+size_t AudioBusPool::memoryBytes()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t bytes = 0;
+    for (auto & freeList : m_free)
+        for (auto & bus : freeList)
+            bytes += bus->memoryBytes();
+    return bytes;
+}
+
+void AudioBusPool::prime(size_t numberOfChannels, size_t count)
+{
+    if (numberOfChannels >= m_free.size())
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto & freeList = m_free[numberOfChannels];
+    while (freeList.size() < count)
+    {
+        freeList.emplace_back(new AudioBus(numberOfChannels, m_length, true, true));
+    }
+}
+
+} // lab
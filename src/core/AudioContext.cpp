@@ -3,22 +3,35 @@
 
 #include "LabSound/core/AudioContext.h"
 #include "LabSound/core/AnalyserNode.h"
+#include "LabSound/core/AudioBasicProcessorNode.h"
+#include "LabSound/core/AudioBusPool.h"
 #include "LabSound/core/AudioListener.h"
 #include "LabSound/core/AudioNodeInput.h"
 #include "LabSound/core/AudioNodeOutput.h"
+#include "LabSound/core/AudioParam.h"
+#include "LabSound/core/AudioSetting.h"
 #include "LabSound/core/DefaultAudioDestinationNode.h"
 #include "LabSound/core/OfflineAudioDestinationNode.h"
 #include "LabSound/core/OscillatorNode.h"
 #include "LabSound/core/AudioHardwareSourceNode.h"
+#include "LabSound/core/SampledAudioNode.h"
+#include "LabSound/core/WaveTable.h"
 
 #include "LabSound/extended/AudioContextLock.h"
 
 #include "internal/AudioDestination.h"
+#include "internal/AudioThreads.h"
 #include "internal/Assertions.h"
+#include "internal/FFTFrame.h"
+#include "internal/HRTFDatabaseLoader.h"
 
 #include "readerwriterqueue/readerwriterqueue.h"
 
+#include <algorithm>
+#include <limits>
+#include <map>
 #include <queue>
+#include <typeinfo>
 #include <assert.h>
 #include <stdio.h>
 
@@ -30,8 +43,48 @@ struct AudioContext::Internals
     Internals(bool a) : autoDispatchEvents(a) {}
     ~Internals() = default;
 
-    moodycamel::ReaderWriterQueue<std::function<void()>> enqueuedEvents;
+    // A finished voice enqueues one of these from the render thread. The
+    // handler shared_ptr is reference-counted, not copied, so enqueueing
+    // never touches the heap; nodeId and when identify the event for any
+    // future event types that don't carry a handler.
+    struct RenderEvent
+    {
+        std::shared_ptr<std::function<void()>> handler;
+        uint64_t nodeId = 0;
+        double when = 0;
+    };
+
+    // Fixed capacity: try_enqueue never allocates, and if several thousand
+    // events pile up undelivered the oldest behavior is to drop new ones.
+    moodycamel::ReaderWriterQueue<RenderEvent> enqueuedEvents{1024};
     bool autoDispatchEvents;
+
+    // Installed batched handler (see setBatchedEventHandler) and the id
+    // buffer reused across dispatch calls so steady-state dispatch doesn't
+    // allocate.
+    std::mutex batchedHandlerMutex;
+    AudioContext::BatchedEventHandler batchedEventHandler;
+    std::vector<uint64_t> batchedIdScratch;
+
+    // Batched grain starts travel the other direction: the main thread
+    // produces (serialized by grainProducerMutex so the queue sees a single
+    // producer) and the render thread consumes lock-free at the top of each
+    // quantum.
+    moodycamel::ReaderWriterQueue<AudioContext::GrainSchedule> scheduledGrains{1024};
+    std::mutex grainProducerMutex;
+
+    // Typed commands travel the same way as grain schedules: serialized
+    // producers, lock-free render-thread consumption. Commands not yet due
+    // (future-dated settings, a contended timeline insert) wait in
+    // pendingCommands, which only the render thread touches.
+    moodycamel::ReaderWriterQueue<AudioContext::RenderCommand> commandQueue{1024};
+    std::mutex commandProducerMutex;
+    std::vector<AudioContext::RenderCommand> pendingCommands;
+
+    // References handed over by holdSourceNodeUntilFinished() on their way to
+    // the render thread's watch list (see handleAutomaticSources).
+    moodycamel::ReaderWriterQueue<std::shared_ptr<AudioScheduledSourceNode>> heldSourceNodes{1024};
+    std::mutex heldSourceProducerMutex;
 };
 
 const size_t lab::AudioContext::maxNumberOfChannels = 32;
@@ -41,6 +94,7 @@ AudioContext::AudioContext(bool isOffline, bool autoDispatchEvents) : m_isOfflin
 {
     m_internal.reset(new AudioContext::Internals(autoDispatchEvents));
     m_listener.reset(new AudioListener());
+    m_renderBusPool.reset(new AudioBusPool(AudioNode::ProcessingSizeInFrames));
 }
 
 AudioContext::~AudioContext()
@@ -48,6 +102,13 @@ AudioContext::~AudioContext()
     // LOG can block.
     // LOG("Begin AudioContext::~AudioContext()");
 
+    // A prewarm worker may still be opening the device or building tables;
+    // it must finish before teardown proceeds (and before the graph update
+    // thread it may have spawned via lazyInitialize is signalled below).
+    for (auto & worker : m_prewarmThreads)
+        if (worker.joinable())
+            worker.join();
+
     if (!isOfflineContext()) graphKeepAlive = 0.25f;
 
     updateThreadShouldRun = false;
@@ -56,6 +117,9 @@ AudioContext::~AudioContext()
     if (graphUpdateThread.joinable())
         graphUpdateThread.join();
 
+    // The sample clock no longer advances; destroy whatever is still parked.
+    drainReclaimedNodes(true);
+
     uninitialize();
 
 #if USE_ACCELERATE_FFT
@@ -64,7 +128,7 @@ AudioContext::~AudioContext()
 
     ASSERT(!m_isInitialized);
     ASSERT(!m_automaticPullNodes.size());
-    ASSERT(!m_renderingAutomaticPullNodes.size());
+    ASSERT(!m_renderingAutomaticPullNodes || m_renderingAutomaticPullNodes->empty());
 
     LOG("Finish AudioContext::~AudioContext()");
 }
@@ -115,8 +179,6 @@ void AudioContext::uninitialize()
     // Don't allow the context to initialize a second time after it's already been explicitly uninitialized.
     m_isAudioThreadFinished = true;
 
-    updateAutomaticPullNodes(); // added for the case where an OfflineAudioDestinationNode needs to update the graph
-
     m_isInitialized = false;
 }
 
@@ -127,22 +189,154 @@ bool AudioContext::isInitialized() const
 
 void AudioContext::holdSourceNodeUntilFinished(std::shared_ptr<AudioScheduledSourceNode> node)
 {
-    std::lock_guard<std::mutex> lock(m_updateMutex);
-    automaticSources.push_back(node);
+    if (!node)
+        return;
+
+    // The render thread owns the watch list; the reference travels there
+    // through a ring so starting a voice never contends with a graph update.
+    // enqueue() grows the ring if a burst outruns the fixed capacity, which
+    // allocates on this (application) thread, never on the render thread.
+    std::lock_guard<std::mutex> lock(m_internal->heldSourceProducerMutex);
+    if (!m_internal->heldSourceNodes.try_enqueue(node))
+        m_internal->heldSourceNodes.enqueue(node);
+}
+
+void AudioContext::reclaim(std::shared_ptr<AudioNode> node)
+{
+    if (!node)
+        return;
+
+    ReclaimRecord record;
+    record.node = std::move(node);
+    // Destruction becomes safe once the render thread has moved past the
+    // quantum that may still be reading this node's buffers.
+    record.safeFrame = currentSampleFrame() + AudioNode::ProcessingSizeInFrames;
+
+    std::lock_guard<std::mutex> lock(m_reclaimMutex);
+    m_reclaimedNodes.push_back(std::move(record));
+}
+
+void AudioContext::drainReclaimedNodes(bool force)
+{
+    // Move eligible records out under the mutex, then let them destruct after
+    // it is released; a convolver teardown must not stall reclaim() callers.
+    std::vector<ReclaimRecord> expired;
+    {
+        std::lock_guard<std::mutex> lock(m_reclaimMutex);
+        if (m_reclaimedNodes.empty())
+            return;
+
+        if (force)
+        {
+            expired.swap(m_reclaimedNodes);
+        }
+        else
+        {
+            uint64_t frame = currentSampleFrame();
+            for (size_t i = 0; i < m_reclaimedNodes.size();)
+            {
+                if (frame >= m_reclaimedNodes[i].safeFrame)
+                {
+                    expired.push_back(std::move(m_reclaimedNodes[i]));
+                    m_reclaimedNodes[i] = std::move(m_reclaimedNodes.back());
+                    m_reclaimedNodes.pop_back();
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+        }
+    }
 }
 
 void AudioContext::handleAutomaticSources()
 {
-    std::lock_guard<std::mutex> lock(m_updateMutex);
-    for (auto i = automaticSources.begin(); i != automaticSources.end(); ++i)
+    // New fire-and-forget voices arrive through the ring; the watch list
+    // itself is touched only here, on the render thread.
+    std::shared_ptr<AudioScheduledSourceNode> held;
+    while (m_internal->heldSourceNodes.try_dequeue(held))
+        automaticSources.push_back(std::move(held));
+
+    // Collect everything that finished this quantum into one batch.
+    size_t keep = 0;
+    for (size_t i = 0; i < automaticSources.size(); ++i)
     {
-        if ((*i)->hasFinished())
+        if (automaticSources[i]->hasFinished())
+            m_finishedSourceScratch.push_back(std::move(automaticSources[i]));
+        else
+            automaticSources[keep++] = std::move(automaticSources[i]);
+    }
+    automaticSources.resize(keep);
+
+    if (m_finishedSourceScratch.empty())
+        return;
+
+    // One lock acquisition and one wakeup for the whole quantum's expiries,
+    // however many voices a combat burst retires at once.
+    {
+        std::lock_guard<std::mutex> lock(m_updateMutex);
+        if (m_finishedSourceBatch.empty())
+        {
+            m_finishedSourceBatch.swap(m_finishedSourceScratch);
+        }
+        else
         {
-            pendingNodeConnections.emplace(*i, std::shared_ptr<AudioNode>(), ConnectionType::Disconnect, 0, 0);
-            i = automaticSources.erase(i);
-            if (i == automaticSources.end()) break;
+            for (auto & node : m_finishedSourceScratch)
+                m_finishedSourceBatch.push_back(std::move(node));
+            m_finishedSourceScratch.clear();
         }
     }
+    cv.notify_all();
+}
+
+// Applies one render command if it is due; returns false when it must be
+// retried next quantum (a future-dated setting, or a timeline insert that
+// lost the try-lock). now and quantumEnd bracket the quantum about to render.
+static bool applyRenderCommand(const AudioContext::RenderCommand & c, double now, double quantumEnd)
+{
+    switch (c.type)
+    {
+        case AudioContext::RenderCommand::SetParamValue:
+            if (!c.param)
+                return true;
+            if (c.when <= now)
+            {
+                c.param->setValue(c.floatValue);
+                return true;
+            }
+            // A timeline point lands on its exact sample during evaluation;
+            // the non-blocking insert defers to the next quantum if the
+            // mutation lock happens to be held.
+            return c.param->trySetValueAtTime(c.floatValue, static_cast<float>(c.when));
+
+        case AudioContext::RenderCommand::SetSettingFloat:
+            if (!c.setting)
+                return true;
+            if (c.when >= quantumEnd)
+                return false;
+            c.setting->setFloat(c.floatValue);
+            return true;
+
+        case AudioContext::RenderCommand::SetSettingUint32:
+            if (!c.setting)
+                return true;
+            if (c.when >= quantumEnd)
+                return false;
+            c.setting->setUint32(c.uintValue);
+            return true;
+
+        case AudioContext::RenderCommand::StartSource:
+            if (c.source)
+                c.source->start(c.when);
+            return true;
+
+        case AudioContext::RenderCommand::StopSource:
+            if (c.source)
+                c.source->stop(c.when);
+            return true;
+    }
+    return true;
 }
 
 void AudioContext::handlePreRenderTasks(ContextRenderLock & r)
@@ -151,7 +345,39 @@ void AudioContext::handlePreRenderTasks(ContextRenderLock & r)
 
     // At the beginning of every render quantum, try to update the internal rendering graph state (from main thread changes).
     AudioSummingJunction::handleDirtyAudioSummingJunctions(r);
-    updateAutomaticPullNodes();
+
+    // Apply any batched grain schedules before rendering so every record in a
+    // batch resolves against the same quantum start time.
+    GrainSchedule schedule;
+    while (m_internal->scheduledGrains.try_dequeue(schedule))
+    {
+        if (schedule.node)
+            schedule.node->startGrain(schedule.when, schedule.grainOffset, schedule.grainDuration);
+    }
+
+    // Drain the command ring the same way, then apply everything that is due
+    // against this quantum's start time. Commands that must wait (see
+    // applyRenderCommand) stay pending in arrival order; start/stop and
+    // timeline inserts hand sub-quantum offsets to the schedulers, so they
+    // apply immediately even when future-dated.
+    RenderCommand command;
+    while (m_internal->commandQueue.try_dequeue(command))
+        m_internal->pendingCommands.push_back(command);
+
+    if (!m_internal->pendingCommands.empty())
+    {
+        double now = currentTime();
+        double quantumEnd = now + AudioNode::ProcessingSizeInFrames / static_cast<double>(sampleRate());
+
+        auto & pending = m_internal->pendingCommands;
+        size_t keep = 0;
+        for (size_t i = 0; i < pending.size(); ++i)
+        {
+            if (!applyRenderCommand(pending[i], now, quantumEnd))
+                pending[keep++] = std::move(pending[i]);
+        }
+        pending.resize(keep);
+    }
 }
 
 void AudioContext::handlePostRenderTasks(ContextRenderLock & r)
@@ -160,14 +386,81 @@ void AudioContext::handlePostRenderTasks(ContextRenderLock & r)
 
     AudioSummingJunction::handleDirtyAudioSummingJunctions(r);
 
-    updateAutomaticPullNodes();
     handleAutomaticSources();
 }
 
+void AudioContext::scheduleGrains(const GrainSchedule * schedules, size_t count)
+{
+    wakeFromAutoIdle();
+    std::lock_guard<std::mutex> lock(m_internal->grainProducerMutex);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!schedules[i].node)
+            continue;
+
+        // try_enqueue never allocates; if the queue is full the record is
+        // applied inline, which is safe (startGrain only writes atomics)
+        // just not deferred to the quantum boundary.
+        if (!m_internal->scheduledGrains.try_enqueue(schedules[i]))
+            schedules[i].node->startGrain(schedules[i].when, schedules[i].grainOffset, schedules[i].grainDuration);
+    }
+}
+
+void AudioContext::scheduleGrains(const std::vector<GrainSchedule> & schedules)
+{
+    scheduleGrains(schedules.data(), schedules.size());
+}
+
+void AudioContext::enqueueCommands(const RenderCommand * commands, size_t count)
+{
+    wakeFromAutoIdle();
+    std::lock_guard<std::mutex> lock(m_internal->commandProducerMutex);
+    for (size_t i = 0; i < count; ++i)
+    {
+        // try_enqueue copies shared_ptrs (reference bumps, no heap); if the
+        // queue is full the command is applied inline, which is what each
+        // call site did before batching existed, just not deferred.
+        if (m_internal->commandQueue.try_enqueue(commands[i]))
+            continue;
+
+        const RenderCommand & c = commands[i];
+        switch (c.type)
+        {
+            case RenderCommand::SetParamValue:
+                if (c.param)
+                {
+                    if (c.when > 0)
+                        c.param->setValueAtTime(c.floatValue, static_cast<float>(c.when));
+                    else
+                        c.param->setValue(c.floatValue);
+                }
+                break;
+            case RenderCommand::SetSettingFloat:
+                if (c.setting) c.setting->setFloat(c.floatValue);
+                break;
+            case RenderCommand::SetSettingUint32:
+                if (c.setting) c.setting->setUint32(c.uintValue);
+                break;
+            case RenderCommand::StartSource:
+                if (c.source) c.source->start(c.when);
+                break;
+            case RenderCommand::StopSource:
+                if (c.source) c.source->stop(c.when);
+                break;
+        }
+    }
+}
+
+void AudioContext::enqueueCommands(const std::vector<RenderCommand> & commands)
+{
+    enqueueCommands(commands.data(), commands.size());
+}
+
 void AudioContext::connect(std::shared_ptr<AudioNode> destination, std::shared_ptr<AudioNode> source, uint32_t destIdx, uint32_t srcIdx)
 {
     if (!destination) throw std::runtime_error("Cannot connect to null destination");
     if (!destination) throw std::runtime_error("Cannot connect from null source");
+    wakeFromAutoIdle();
     std::lock_guard<std::mutex> lock(m_updateMutex);
     if (srcIdx > source->numberOfOutputs()) throw std::out_of_range("Output index greater than available outputs");
     if (destIdx > destination->numberOfInputs()) throw std::out_of_range("Input index greater than available inputs");
@@ -177,6 +470,7 @@ void AudioContext::connect(std::shared_ptr<AudioNode> destination, std::shared_p
 
 void AudioContext::disconnect(std::shared_ptr<AudioNode> destination, std::shared_ptr<AudioNode> source, uint32_t destIdx, uint32_t srcIdx)
 {
+    wakeFromAutoIdle();
     std::lock_guard<std::mutex> lock(m_updateMutex);
     if (source && srcIdx > source->numberOfOutputs()) throw std::out_of_range("Output index greater than available outputs");
     if (destination && destIdx > destination->numberOfInputs()) throw std::out_of_range("Input index greater than available inputs");
@@ -184,21 +478,67 @@ void AudioContext::disconnect(std::shared_ptr<AudioNode> destination, std::share
     cv.notify_all();
 }
 
+void AudioContext::applyConnectionBatch(const std::vector<ConnectionOperation> & operations)
+{
+    // Validate the whole transaction before queuing anything, so a throw
+    // leaves the graph exactly as it was.
+    for (const auto & op : operations)
+    {
+        if (op.connect)
+        {
+            if (!op.destination) throw std::runtime_error("Cannot connect to null destination");
+            if (!op.source) throw std::runtime_error("Cannot connect from null source");
+        }
+        else if (!op.destination && !op.source)
+        {
+            throw std::invalid_argument("Disconnect requires a source or a destination");
+        }
+
+        if (op.source && op.srcIndex > op.source->numberOfOutputs()) throw std::out_of_range("Output index greater than available outputs");
+        if (op.destination && op.destIndex > op.destination->numberOfInputs()) throw std::out_of_range("Input index greater than available inputs");
+    }
+
+    wakeFromAutoIdle();
+
+    std::lock_guard<std::mutex> lock(m_updateMutex);
+    for (const auto & op : operations)
+    {
+        pendingNodeConnections.emplace(op.destination, op.source,
+                                       op.connect ? ConnectionType::Connect : ConnectionType::Disconnect,
+                                       op.destIndex, op.srcIndex);
+    }
+    cv.notify_all();
+}
+
+bool AudioContext::hasPendingUpdates()
+{
+    std::lock_guard<std::mutex> lock(m_updateMutex);
+    return !pendingNodeConnections.empty() || !pendingParamConnections.empty()
+        || !m_finishedSourceBatch.empty() || m_reapingSourceBatches.load(std::memory_order_relaxed) != 0;
+}
+
 void AudioContext::connectParam(std::shared_ptr<AudioParam> param, std::shared_ptr<AudioNode> driver, uint32_t index)
 {
     if (!param) throw std::invalid_argument("No parameter specified");
     if (index >= driver->numberOfOutputs()) throw std::out_of_range("Output index greater than available outputs on the driver");
+    wakeFromAutoIdle();
     pendingParamConnections.push(std::make_tuple(param, driver, index));
     cv.notify_all();
 }
 
 void AudioContext::update()
 {
+    ApplyThreadPolicy(ThreadRole::GraphUpdate, "graph update");
+
     LOG("Begin UpdateGraphThread");
 
-    const float frameSizeMs = (sampleRate() / (float)AudioNode::ProcessingSizeInFrames) / 1000.f; // = ~0.345ms @ 44.1k/128
-    const float graphTickDurationMs = frameSizeMs * 16; // = ~5.5ms
-    const int graphTickDurationUs = static_cast<int>(graphTickDurationMs * 1000.f);  // = ~5550us
+    // Seconds until the soonest outstanding piece of timed work (keep-alive
+    // decay, fade-outs, deferred scheduled starts, the auto-idle countdown),
+    // recomputed by every drain pass. Infinity means nothing timed is
+    // pending, so the wait below blocks until someone enqueues work; a
+    // quiescent graph takes zero steady-state wakeups. Zero here makes the
+    // first pass run immediately.
+    float nextTimedWork = 0.f;
 
     // graphKeepAlive keeps the thread alive momentarily (letting tail tasks
     // finish) even updateThreadShouldRun has been signaled.
@@ -215,10 +555,13 @@ void AudioContext::update()
             // A condition variable is used to notify this thread that a graph update is pending
             // in one of the queues.
 
-            // graph needs to tick to complete
-            if ((currentTime() + graphKeepAlive) > currentTime())
+            // Timed work sleeps until its exact deadline; while suspended or
+            // idled the context clock is parked and countdowns can never
+            // decay, so fall through to the indefinite wait instead.
+            if (!isSuspended() && nextTimedWork < std::numeric_limits<float>::infinity())
             {
-                cv.wait_until(lk, std::chrono::steady_clock::now() + std::chrono::microseconds(graphTickDurationUs));
+                if (nextTimedWork > 0.f)
+                    cv.wait_until(lk, std::chrono::steady_clock::now() + std::chrono::microseconds(static_cast<int64_t>(nextTimedWork * 1.0e6f)));
             }
             else
             {
@@ -226,10 +569,29 @@ void AudioContext::update()
                 cv.wait(lk);
             }
         }
+        else
+        {
+            // Offline contexts don't pace on the cv, but the pending queues
+            // are still fed by connect()/disconnect()/applyConnectionBatch()
+            // from other threads, so draining them below needs the same lock.
+            lk = std::unique_lock<std::mutex>(m_updateMutex);
+        }
 
         if (m_internal->autoDispatchEvents)
             dispatchEvents();
 
+        // captured before the drain below, so a wakeup caused by new work can
+        // be told apart from a spurious one after the queues empty again
+        const bool hadPendingWork = !pendingNodeConnections.empty() || !pendingParamConnections.empty();
+
+        // Anything with a future deadline records it here as it is drained,
+        // so the wait above sleeps exactly until the soonest one instead of
+        // polling on a fixed tick.
+        nextTimedWork = std::numeric_limits<float>::infinity();
+        auto scheduleWake = [&nextTimedWork](float seconds) {
+            nextTimedWork = std::min(nextTimedWork, seconds > 0.f ? seconds : 0.f);
+        };
+
         // if blocked on cv.wait, double check whether it's still necessary to run.
         if (updateThreadShouldRun || graphKeepAlive > 0)
         {
@@ -240,12 +602,15 @@ void AudioContext::update()
             lastGraphUpdateTime = static_cast<float>(now);
             graphKeepAlive -= delta;
 
+            bool topologyChanged = false;
+
             // Satisfy parameter connections
             while (!pendingParamConnections.empty())
             {
                 auto connection = pendingParamConnections.front();
                 pendingParamConnections.pop();
                 AudioParam::connect(gLock, std::get<0>(connection), std::get<1>(connection)->output(std::get<2>(connection)));
+                topologyChanged = true;
             }
 
             std::vector<PendingConnection> skippedConnections;
@@ -268,6 +633,7 @@ void AudioContext::update()
                         {
                             pendingNodeConnections.pop(); // pop from current queue
                             skippedConnections.push_back(connection); // save for later
+                            scheduleWake(static_cast<float>(node->startTime() - now) - 0.1f);
                             continue;
                         }
                     }
@@ -275,6 +641,7 @@ void AudioContext::update()
                     connection.source->scheduleConnect();
 
                     AudioNodeInput::connect(gLock, connection.destination->input(connection.destIndex), connection.source->output(connection.srcIndex));
+                    topologyChanged = true;
                 }
                 break;
 
@@ -305,9 +672,12 @@ void AudioContext::update()
                     {
                         connection.duration -= delta;
                         skippedConnections.push_back(connection);
+                        scheduleWake(connection.duration);
                         continue;
                     }
 
+                    topologyChanged = true;
+
                     if (connection.source && connection.destination)
                     {
                         AudioNodeInput::disconnect(gLock, connection.destination->input(connection.destIndex), connection.source->output(connection.srcIndex));
@@ -333,6 +703,11 @@ void AudioContext::update()
                         }
                     }
 
+                    // Unlinking is all that happens under the graph lock. If
+                    // these were the last references, park them so the node
+                    // destructors run outside the lock, a quantum from now.
+                    reclaim(std::move(connection.source));
+                    reclaim(std::move(connection.destination));
                 }
                 break;
                 }
@@ -344,10 +719,102 @@ void AudioContext::update()
                 pendingNodeConnections.push(sc);
             }
 
+            // Reap the render thread's finished one-shot voices as whole
+            // batches. Everything that expired in one quantum starts its
+            // fade-out together and shares a single countdown, so a burst of
+            // a hundred ending SFX voices costs one pass here, not a hundred
+            // queue entries.
+            if (!m_finishedSourceBatch.empty())
+            {
+                FinishedSourceReap reap;
+                reap.nodes.swap(m_finishedSourceBatch);
+                for (auto & node : reap.nodes)
+                    node->scheduleDisconnect();
+                if (updateThreadShouldRun)
+                    graphKeepAlive = std::max(graphKeepAlive, reap.duration);
+                m_reapingSources.push_back(std::move(reap));
+                m_reapingSourceBatches.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            for (size_t b = 0; b < m_reapingSources.size();)
+            {
+                FinishedSourceReap & reap = m_reapingSources[b];
+                reap.duration -= delta;
+                if (reap.duration > 0)
+                {
+                    scheduleWake(reap.duration);
+                    ++b;
+                    continue;
+                }
+
+                // Faded out: unlink the whole batch in one pass and park the
+                // references so buffers release together, off this lock.
+                for (auto & node : reap.nodes)
+                {
+                    for (unsigned int out = 0; out < node->numberOfOutputs(); ++out)
+                    {
+                        auto output = node->output(out);
+                        if (!output) continue;
+
+                        AudioNodeOutput::disconnectAll(gLock, output);
+                    }
+                    reclaim(std::move(node));
+                }
+                topologyChanged = true;
+
+                m_reapingSources[b] = std::move(m_reapingSources.back());
+                m_reapingSources.pop_back();
+                m_reapingSourceBatches.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            // invalidate any cached render order so the render thread rebuilds it
+            if (topologyChanged)
+                m_graphGeneration.fetch_add(1, std::memory_order_release);
+
+            // keep-alive expiry is itself a deadline: the thread must run
+            // once more then to exit or to become eligible for auto-idle
+            if (graphKeepAlive > 0)
+                scheduleWake(graphKeepAlive);
+        }
+
+        // Auto-idle policy: park the stream after enough verified silence,
+        // wake it when queued work shows the graph is live again. The queue
+        // inspection needs the lock still held here; the device start/stop
+        // happens after it is released.
+        bool idlePark = false;
+        bool idleWake = false;
+        if (!m_isOfflineContext && m_autoIdleEnabled && !m_suspended && m_destinationNode)
+        {
+            if (m_autoIdled)
+                idleWake = hadPendingWork;
+            else
+            {
+                idlePark = graphKeepAlive <= 0
+                    && pendingNodeConnections.empty() && pendingParamConnections.empty()
+                    && m_destinationNode->silentDuration() >= m_autoIdleSeconds.load();
+
+                // not parkable yet: sleep exactly until the silence threshold
+                // would next be crossed, rather than polling for it. Floored
+                // to one render quantum since silentDuration() only advances
+                // at quantum granularity; if the threshold is already crossed
+                // whatever still blocks parking has its own deadline.
+                const float silenceRemaining = m_autoIdleSeconds.load() - static_cast<float>(m_destinationNode->silentDuration());
+                if (!idlePark && silenceRemaining > 0.f)
+                    scheduleWake(std::max(silenceRemaining, AudioNode::ProcessingSizeInFrames / sampleRate()));
+            }
         }
 
-        if (lk.owns_lock()) 
+        if (lk.owns_lock())
             lk.unlock();
+
+        if (idleWake)
+            wakeFromAutoIdle();
+        else if (idlePark && !m_autoIdled.exchange(true))
+            m_destinationNode->stopRendering();
+
+        // Destroy unlinked nodes whose quantum boundary has passed, with no
+        // lock held; an arbitrarily large teardown runs entirely here.
+        drainReclaimedNodes(false);
     }
 
     LOG("End UpdateGraphThread");
@@ -359,7 +826,7 @@ void AudioContext::addAutomaticPullNode(std::shared_ptr<AudioNode> node)
     if (m_automaticPullNodes.find(node) == m_automaticPullNodes.end())
     {
         m_automaticPullNodes.insert(node);
-        m_automaticPullNodesNeedUpdating = true;
+        publishAutomaticPullNodes();
     }
 }
 
@@ -370,54 +837,530 @@ void AudioContext::removeAutomaticPullNode(std::shared_ptr<AudioNode> node)
     if (it != m_automaticPullNodes.end())
     {
         m_automaticPullNodes.erase(it);
-        m_automaticPullNodesNeedUpdating = true;
+        publishAutomaticPullNodes();
     }
 }
 
-void AudioContext::updateAutomaticPullNodes()
+void AudioContext::publishAutomaticPullNodes()
 {
-    /// @TODO this seems like work for the update thread.
-    /// m_automaticPullNodesNeedUpdating can go away in favor of
-    /// add and remove doing a cv.notify.
-    /// m_automaticPullNodes should be an add/remove vector
-    /// m_renderingAutomaticPullNodes should be the actual live vector
-    if (m_automaticPullNodesNeedUpdating)
+    // The set walk happens here, once per registration change, instead of on
+    // the render thread; the render side picks up the fresh array with a
+    // single atomic load at its next quantum.
+    auto snapshot = std::make_shared<std::vector<std::shared_ptr<AudioNode>>>();
+    snapshot->reserve(m_automaticPullNodes.size());
+    for (auto & node : m_automaticPullNodes)
+        snapshot->push_back(node);
+
+    std::atomic_store(&m_renderingAutomaticPullNodes,
+                      std::shared_ptr<const std::vector<std::shared_ptr<AudioNode>>>(std::move(snapshot)));
+}
+
+const std::vector<AudioNodeOutput *> & AudioContext::renderOrder(ContextRenderLock & r)
+{
+    ASSERT(r.context());
+
+    uint64_t generation = m_graphGeneration.load(std::memory_order_acquire);
+    if (generation == m_renderOrderGeneration)
+        return m_renderOrder;
+
+    // Topology changed; walk upstream from the destination and flatten the graph
+    // into post-order so that every node precedes the nodes it feeds.
+    m_renderOrder.clear();
+    m_fusedChains.clear();
+
+    // True when the edge from output into consumer can execute inside the
+    // consumer's fused chain: both ends are basic processor nodes of the
+    // same width, the consumer's junction is a plain single-connection
+    // pass-through, and nothing else observes the interior output.
+    auto fusableLink = [&r](AudioNodeOutput * output, AudioNode * consumer) -> bool {
+        AudioBasicProcessorNode * stage = dynamic_cast<AudioBasicProcessorNode *>(output->node());
+        AudioBasicProcessorNode * tail = dynamic_cast<AudioBasicProcessorNode *>(consumer);
+        if (!stage || !tail)
+            return false;
+        if (stage->numberOfInputs() != 1 || stage->numberOfOutputs() != 1)
+            return false;
+        if (output->renderingFanOutCount() != 1 || output->renderingParamFanOutCount() != 0)
+            return false;
+        if (tail->numberOfInputs() != 1 || tail->input(0)->numberOfRenderingConnections(r) != 1)
+            return false;
+        // A bypassed stage or tail is passed through, not executed; leave the
+        // chain un-fused so the bypass machinery sees the real junctions.
+        if (stage->bypassed() || tail->bypassed())
+            return false;
+        return output->numberOfChannels() == tail->output(0)->numberOfChannels();
+    };
+
+    // Edges elided from the flattened schedule; the chain lists are
+    // assembled from this after the walk.
+    std::map<AudioNode *, AudioNode *> fusedInto;
+
+    std::set<AudioNode *> visited;
+    std::function<void(AudioNode *)> visit = [&](AudioNode * node) {
+        for (size_t i = 0; i < node->numberOfInputs(); ++i)
+        {
+            auto input = node->input(i);
+            if (!input)
+                continue;
+
+            size_t c = input->numberOfRenderingConnections(r);
+            for (size_t j = 0; j < c; ++j)
+            {
+                auto output = input->renderingOutput(r, j);
+                if (!output || !output->node())
+                    continue;
+
+                if (visited.count(output->node()))
+                    continue;
+
+                visited.insert(output->node());
+                visit(output->node());
+
+                // A foldable gain stage is absorbed by the junction that
+                // consumes it (see AudioNodeInput::pull); leaving it out of
+                // the flattened schedule means it never executes as a node.
+                // If folding is declined at render time (automation started,
+                // the de-zipper is ramping), the consuming junction pulls it
+                // and it renders through the ordinary recursive path.
+                float foldedGain;
+                if (output->renderingFanOutCount() == 1
+                    && output->renderingParamFanOutCount() == 0
+                    && output->node()->foldableGain(r, &foldedGain))
+                    continue;
+
+                // A bypassed pass-through node is skipped by the consuming
+                // junction the same way a folded gain is; leave it out too.
+                // If bypass is lifted before the next topology change, the
+                // junction pulls it and it renders through the ordinary
+                // recursive path.
+                if (output->renderingFanOutCount() == 1
+                    && output->renderingParamFanOutCount() == 0
+                    && output->node()->bypassed()
+                    && output->node()->numberOfInputs() == 1
+                    && output->node()->numberOfOutputs() == 1
+                    && output->node()->input(0)->numberOfRenderingConnections(r) == 1)
+                    continue;
+
+                // A basic processor whose only consumer is the next basic
+                // processor runs inside the consumer's fused chain (see
+                // AudioBasicProcessorNode::processFusedChain); leave it out
+                // of the flattened schedule the same way folded gains are.
+                if (fusableLink(output, node))
+                {
+                    fusedInto[output->node()] = node;
+                    continue;
+                }
+
+                m_renderOrder.push_back(output);
+            }
+        }
+    };
+
+    if (m_destinationNode)
+        visit(m_destinationNode.get());
+
+    // Assemble the chain lists: a tail is a node fused into but not itself
+    // fused away; its stages are the unbroken run of elided edges above it,
+    // ordered head first. The length cap bounds the walk on degenerate
+    // graphs; stages beyond it still render correctly through the ordinary
+    // recursive pull from the fused head.
+    const size_t MaxFusedStages = 16;
+    for (auto & edge : fusedInto)
     {
-        std::lock_guard<std::mutex> lock(m_updateMutex);
+        AudioNode * tail = edge.second;
+        if (fusedInto.count(tail) || m_fusedChains.count(tail))
+            continue;
 
-        // Copy from m_automaticPullNodes to m_renderingAutomaticPullNodes.
-        m_renderingAutomaticPullNodes.resize(m_automaticPullNodes.size());
+        std::vector<AudioBasicProcessorNode *> stages;
+        AudioNode * cursor = tail;
+        while (stages.size() < MaxFusedStages)
+        {
+            if (cursor->numberOfInputs() != 1 || cursor->input(0)->numberOfRenderingConnections(r) != 1)
+                break;
+            AudioNodeOutput * upstream = cursor->input(0)->renderingOutput(r, 0);
+            if (!upstream)
+                break;
+            auto it = fusedInto.find(upstream->node());
+            if (it == fusedInto.end() || it->second != cursor)
+                break;
+            stages.push_back(static_cast<AudioBasicProcessorNode *>(upstream->node()));
+            cursor = upstream->node();
+        }
+        std::reverse(stages.begin(), stages.end());
+        m_fusedChains[tail] = std::move(stages);
+    }
+
+    m_renderOrderGeneration = generation;
+    return m_renderOrder;
+}
+
+const std::vector<AudioBasicProcessorNode *> * AudioContext::fusedChainFor(const AudioNode * tail) const
+{
+    // A stale cache may reference disconnected nodes; until renderOrder()
+    // rebuilds it this quantum, callers take the un-fused path.
+    if (m_renderOrderGeneration != m_graphGeneration.load(std::memory_order_acquire))
+        return nullptr;
+
+    auto it = m_fusedChains.find(tail);
+    if (it == m_fusedChains.end() || it->second.empty())
+        return nullptr;
+    return &it->second;
+}
+
+std::vector<AudioContext::NodeProfile> AudioContext::nodeProfile(ContextRenderLock & r)
+{
+    ASSERT(r.context());
+
+    std::vector<NodeProfile> profiles;
+    std::set<AudioNode *> seen;
+
+    // renderOrder covers every node reachable from the destination; a node with
+    // several outputs appears once per output, so de-duplicate.
+    for (AudioNodeOutput * output : renderOrder(r))
+    {
+        AudioNode * node = output ? output->node() : nullptr;
+        if (!node || seen.count(node))
+            continue;
+
+        seen.insert(node);
+
+        NodeProfile profile;
+        profile.node = node;
+        profile.quanta = node->profiledQuanta();
+        profile.maxMicroseconds = node->profiledMaxMicroseconds();
+        if (profile.quanta)
+            profile.averageMicroseconds = static_cast<double>(node->profiledTotalMicroseconds()) / profile.quanta;
+        profile.allocations = node->profiledAllocations();
+        profile.allocationBytes = node->profiledAllocationBytes();
+        profiles.push_back(profile);
+    }
+
+    std::sort(profiles.begin(), profiles.end(), [](const NodeProfile & a, const NodeProfile & b) {
+        return a.averageMicroseconds * a.quanta > b.averageMicroseconds * b.quanta;
+    });
+
+    return profiles;
+}
 
-        unsigned j = 0;
-        for (auto i = m_automaticPullNodes.begin(); i != m_automaticPullNodes.end(); ++i, ++j)
+AudioNode::MemoryUsage AudioContext::queryMemory(ContextRenderLock & r)
+{
+    ASSERT(r.context());
+
+    AudioNode::MemoryUsage usage;
+    std::set<AudioNode *> seen;
+
+    for (AudioNodeOutput * output : renderOrder(r))
+    {
+        AudioNode * node = output ? output->node() : nullptr;
+        if (!node || seen.count(node))
+            continue;
+
+        seen.insert(node);
+        node->queryMemory(r, usage);
+    }
+
+    auto pullNodes = std::atomic_load(&m_renderingAutomaticPullNodes);
+    if (pullNodes)
+    {
+        for (auto & node : *pullNodes)
+        {
+            if (node && !seen.count(node.get()))
+            {
+                seen.insert(node.get());
+                node->queryMemory(r, usage);
+            }
+        }
+    }
+
+    usage.busBytes += m_renderBusPool->memoryBytes();
+    return usage;
+}
+
+namespace {
+
+// Recovers the unqualified class name from typeid. The Itanium ABI mangles
+// lab::GainNode as "N3lab8GainNodeE", a nested name of length-prefixed
+// components; MSVC returns "class lab::GainNode" directly.
+std::string nodeTypeName(const AudioNode & node)
+{
+    std::string raw = typeid(node).name();
+
+    if (raw.size() > 2 && raw[0] == 'N')
+    {
+        size_t pos = 1;
+        std::string component;
+        while (pos < raw.size() && raw[pos] >= '0' && raw[pos] <= '9')
+        {
+            size_t length = 0;
+            while (pos < raw.size() && raw[pos] >= '0' && raw[pos] <= '9')
+                length = length * 10 + (raw[pos++] - '0');
+            if (pos + length > raw.size())
+                break;
+            component = raw.substr(pos, length);
+            pos += length;
+        }
+        if (!component.empty())
+            return component;
+    }
+
+    size_t colon = raw.rfind(':');
+    if (colon != std::string::npos)
+        return raw.substr(colon + 1);
+
+    // A name mangled outside a namespace is just length-prefixed.
+    size_t digits = 0;
+    while (digits < raw.size() && raw[digits] >= '0' && raw[digits] <= '9')
+        ++digits;
+    return raw.substr(digits);
+}
+
+const char * channelCountModeName(ChannelCountMode mode)
+{
+    switch (mode)
+    {
+        case ChannelCountMode::Max: return "max";
+        case ChannelCountMode::ClampedMax: return "clamped-max";
+        case ChannelCountMode::Explicit: return "explicit";
+        default: return "unknown";
+    }
+}
+
+const char * channelInterpretationName(ChannelInterpretation interpretation)
+{
+    return interpretation == ChannelInterpretation::Discrete ? "discrete" : "speakers";
+}
+
+}  // namespace
+
+AudioContext::GraphSnapshot AudioContext::graphSnapshot(ContextRenderLock & r)
+{
+    ASSERT(r.context());
+
+    GraphSnapshot snapshot;
+    if (!m_destinationNode)
+        return snapshot;
+
+    // Breadth-first from the destination through node inputs and param
+    // drivers; the raw pointers are valid while the render lock is held.
+    std::vector<AudioNode *> order;
+    std::vector<AudioNode *> pending{m_destinationNode.get()};
+    std::set<AudioNode *> seen{m_destinationNode.get()};
+
+    auto visitJunction = [&](AudioSummingJunction & junction) {
+        size_t count = junction.numberOfRenderingConnections(r);
+        for (size_t c = 0; c < count; ++c)
+        {
+            auto output = junction.renderingOutput(r, c);
+            AudioNode * source = output ? output->node() : nullptr;
+            if (source && !seen.count(source))
+            {
+                seen.insert(source);
+                pending.push_back(source);
+            }
+        }
+    };
+
+    while (!pending.empty())
+    {
+        AudioNode * node = pending.back();
+        pending.pop_back();
+        order.push_back(node);
+
+        for (size_t i = 0; i < node->numberOfInputs(); ++i)
+        {
+            auto input = node->input(i);
+            if (input)
+                visitJunction(*input);
+        }
+
+        for (const auto & paramName : node->params())
+        {
+            auto param = node->getParam(paramName.c_str());
+            if (param)
+                visitJunction(*param);
+        }
+    }
+
+    // Map each output back to its owner so edges can carry the output index.
+    std::map<AudioNodeOutput *, std::pair<uint64_t, size_t>> outputOwner;
+    for (AudioNode * node : order)
+        for (size_t o = 0; o < node->numberOfOutputs(); ++o)
+            outputOwner[node->output(o).get()] = {node->id(), o};
+
+    for (AudioNode * node : order)
+    {
+        GraphSnapshot::Node entry;
+        entry.id = node->id();
+        entry.type = nodeTypeName(*node);
+        entry.numberOfInputs = node->numberOfInputs();
+        entry.numberOfOutputs = node->numberOfOutputs();
+        entry.channelCount = node->channelCount();
+        entry.channelCountMode = node->channelCountMode();
+        entry.channelInterpretation = node->channelInterpretation();
+        entry.profiledQuanta = node->profiledQuanta();
+        entry.maxMicroseconds = node->profiledMaxMicroseconds();
+        if (entry.profiledQuanta)
+            entry.averageMicroseconds = static_cast<double>(node->profiledTotalMicroseconds()) / entry.profiledQuanta;
+        snapshot.nodes.push_back(entry);
+    }
+
+    auto recordEdges = [&](AudioNode * node, AudioSummingJunction & junction, size_t inputIndex, const std::string & paramName) {
+        size_t count = junction.numberOfRenderingConnections(r);
+        for (size_t c = 0; c < count; ++c)
+        {
+            auto output = junction.renderingOutput(r, c);
+            auto owner = output ? outputOwner.find(output) : outputOwner.end();
+            if (owner == outputOwner.end())
+                continue;
+
+            GraphSnapshot::Edge edge;
+            edge.sourceId = owner->second.first;
+            edge.sourceOutput = owner->second.second;
+            edge.destinationId = node->id();
+            edge.destinationInput = inputIndex;
+            edge.param = paramName;
+            snapshot.edges.push_back(edge);
+        }
+    };
+
+    for (AudioNode * node : order)
+    {
+        for (size_t i = 0; i < node->numberOfInputs(); ++i)
+        {
+            auto input = node->input(i);
+            if (input)
+                recordEdges(node, *input, i, std::string());
+        }
+
+        for (const auto & paramName : node->params())
         {
-            m_renderingAutomaticPullNodes[j] = *i;
+            auto param = node->getParam(paramName.c_str());
+            if (param)
+                recordEdges(node, *param, 0, paramName);
         }
+    }
 
-        m_automaticPullNodesNeedUpdating = false;
+    return snapshot;
+}
+
+std::string AudioContext::GraphSnapshot::json() const
+{
+    std::string out = "{\n  \"nodes\": [";
+    char buffer[256];
+
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        const Node & n = nodes[i];
+        snprintf(buffer, sizeof(buffer),
+                 "%s\n    {\"id\": %llu, \"type\": \"%s\", \"inputs\": %zu, \"outputs\": %zu,"
+                 " \"channelCount\": %zu, \"channelCountMode\": \"%s\", \"channelInterpretation\": \"%s\","
+                 " \"quanta\": %llu, \"averageMicroseconds\": %.3f, \"maxMicroseconds\": %llu}",
+                 i ? "," : "",
+                 static_cast<unsigned long long>(n.id), n.type.c_str(), n.numberOfInputs, n.numberOfOutputs,
+                 n.channelCount, channelCountModeName(n.channelCountMode), channelInterpretationName(n.channelInterpretation),
+                 static_cast<unsigned long long>(n.profiledQuanta), n.averageMicroseconds,
+                 static_cast<unsigned long long>(n.maxMicroseconds));
+        out += buffer;
     }
+
+    out += "\n  ],\n  \"edges\": [";
+
+    for (size_t i = 0; i < edges.size(); ++i)
+    {
+        const Edge & e = edges[i];
+        if (e.param.empty())
+            snprintf(buffer, sizeof(buffer),
+                     "%s\n    {\"source\": %llu, \"sourceOutput\": %zu, \"destination\": %llu, \"destinationInput\": %zu}",
+                     i ? "," : "",
+                     static_cast<unsigned long long>(e.sourceId), e.sourceOutput,
+                     static_cast<unsigned long long>(e.destinationId), e.destinationInput);
+        else
+            snprintf(buffer, sizeof(buffer),
+                     "%s\n    {\"source\": %llu, \"sourceOutput\": %zu, \"destination\": %llu, \"param\": \"%s\"}",
+                     i ? "," : "",
+                     static_cast<unsigned long long>(e.sourceId), e.sourceOutput,
+                     static_cast<unsigned long long>(e.destinationId), e.param.c_str());
+        out += buffer;
+    }
+
+    out += "\n  ]\n}\n";
+    return out;
+}
+
+void AudioContext::setThreadPolicy(ThreadRole role, const ThreadPolicy & policy)
+{
+    lab::SetThreadPolicy(role, policy);
+}
+
+AudioContext::ThreadPolicy AudioContext::threadPolicy(ThreadRole role)
+{
+    return lab::GetThreadPolicy(role);
 }
 
 void AudioContext::processAutomaticPullNodes(ContextRenderLock & r, size_t framesToProcess)
 {
-    for (unsigned i = 0; i < m_renderingAutomaticPullNodes.size(); ++i)
-        m_renderingAutomaticPullNodes[i]->processIfNecessary(r, framesToProcess);
+    // One atomic load per quantum; registration changes swap in a whole new
+    // array, so the walk below is over stable, contiguous storage.
+    auto pullNodes = std::atomic_load(&m_renderingAutomaticPullNodes);
+    if (!pullNodes)
+        return;
+
+    for (auto & node : *pullNodes)
+        node->processIfNecessary(r, framesToProcess);
 }
 
-void AudioContext::enqueueEvent(std::function<void()>& fn)
+size_t AudioContext::automaticPullNodeCount(ContextRenderLock & r)
 {
-    m_internal->enqueuedEvents.enqueue(fn);
+    ASSERT(r.context());
+
+    auto pullNodes = std::atomic_load(&m_renderingAutomaticPullNodes);
+    return pullNodes ? pullNodes->size() : 0;
+}
+
+void AudioContext::enqueueEvent(const std::shared_ptr<std::function<void()>> & handler, uint64_t nodeId, double when)
+{
+    m_internal->enqueuedEvents.try_enqueue({handler, nodeId, when});
     cv.notify_all();    // processing thread must dispatch events
 }
 
 void AudioContext::dispatchEvents()
 {
-    std::function<void()> event_fn;
-    while (m_internal->enqueuedEvents.try_dequeue(event_fn))
+    dispatchEvents(0);
+}
+
+size_t AudioContext::dispatchEvents(size_t maxEvents)
+{
+    BatchedEventHandler batched;
     {
-        if (event_fn)
-            event_fn();
+        std::lock_guard<std::mutex> lock(m_internal->batchedHandlerMutex);
+        batched = m_internal->batchedEventHandler;
     }
+
+    std::vector<uint64_t> & ids = m_internal->batchedIdScratch;
+    ids.clear();
+
+    size_t dispatched = 0;
+    Internals::RenderEvent event;
+    while ((!maxEvents || dispatched < maxEvents) && m_internal->enqueuedEvents.try_dequeue(event))
+    {
+        ++dispatched;
+        if (batched)
+            ids.push_back(event.nodeId);
+        else if (event.handler && *event.handler)
+            (*event.handler)();
+        event.handler.reset();
+    }
+
+    // one invocation for however many sources finished this frame
+    if (batched && !ids.empty())
+        batched(ids);
+
+    return dispatched;
+}
+
+void AudioContext::setBatchedEventHandler(BatchedEventHandler handler)
+{
+    std::lock_guard<std::mutex> lock(m_internal->batchedHandlerMutex);
+    m_internal->batchedEventHandler = std::move(handler);
 }
 
 void AudioContext::setDestinationNode(std::shared_ptr<AudioDestinationNode> node)
@@ -445,20 +1388,171 @@ double AudioContext::currentTime() const
     return m_destinationNode->currentTime();
 }
 
+double AudioContext::predictedPresentationTime() const
+{
+    if (!m_destinationNode)
+        return 0;
+
+    // Offline rendering has no device clock and no presentation latency.
+    if (m_isOfflineContext)
+        return m_destinationNode->currentTime();
+
+    return m_destinationNode->currentSampleTime() + m_destinationNode->outputLatency();
+}
+
+double AudioContext::outputLatency() const
+{
+    return m_destinationNode ? m_destinationNode->outputLatency() : 0;
+}
+
+double AudioContext::deviceStreamTime() const
+{
+    return m_destinationNode ? m_destinationNode->deviceStreamTime() : 0;
+}
+
 float AudioContext::sampleRate() const
 {
     ASSERT(m_destinationNode);
     return m_destinationNode->sampleRate();
 }
 
+void AudioContext::prewarmWaveTables()
+{
+    WaveTable::prewarmStandardTables(sampleRate());
+}
+
+void AudioContext::prewarm(const std::string & hrtfSearchPath)
+{
+    // a second call has nothing left to kick off
+    if (m_prewarmStarted.exchange(true))
+        return;
+
+    if (!m_destinationNode.get())
+    {
+        LOG_ERROR("prewarm() requires a destination node");
+        return;
+    }
+
+    float rate = sampleRate();
+
+    auto launch = [this](std::function<void()> task) {
+        m_prewarmTasksPending.fetch_add(1, std::memory_order_release);
+        m_prewarmThreads.emplace_back([this, task]() {
+            ApplyThreadPolicy(ThreadRole::Background, "prewarm");
+            task();
+            m_prewarmTasksPending.fetch_sub(1, std::memory_order_release);
+        });
+    };
+
+    // Device stream open (the long pole on most platforms). lazyInitialize is
+    // a no-op when MakeRealtimeAudioContext already initialized the context.
+    launch([this]() { lazyInitialize(); });
+
+    // The standard oscillator wavetable bank; the build itself fans out
+    // across cores per range.
+    launch([rate]() { WaveTable::prewarmStandardTables(rate); });
+
+    // Per-size FFT state (twiddle and bit-reversal tables) for every power of
+    // two the engine uses, so no render-path FFT pays first-use setup.
+    launch([]() {
+        for (size_t size = 128; size <= 16384; size *= 2)
+            FFTFrame frame(size);
+    });
+
+    // HRTF database decode. The singleton must be created on the caller's
+    // (main) thread; the loader then decodes on its own thread, and a worker
+    // folds that completion into the pending count.
+    if (!hrtfSearchPath.length())
+        return;
+
+    auto stripSlash = [](const std::string & path) -> std::string {
+        if (path[path.size() - 1] == '/' || path[path.size() - 1] == '\\')
+            return path.substr(0, path.size() - 1);
+        return path;
+    };
+    auto loader = HRTFDatabaseLoader::MakeHRTFLoaderSingleton(rate, stripSlash(hrtfSearchPath));
+    launch([loader]() { loader->waitForLoaderThreadCompletion(); });
+}
+
+bool AudioContext::isPrewarmed() const
+{
+    return m_prewarmStarted.load(std::memory_order_acquire) &&
+           m_prewarmTasksPending.load(std::memory_order_acquire) == 0;
+}
+
 AudioListener & AudioContext::listener()
 {
     return *m_listener.get();
 }
 
+AudioBusPool & AudioContext::renderBusPool()
+{
+    return *m_renderBusPool.get();
+}
+
 void AudioContext::startRendering()
 {
     destination()->startRendering();
 }
 
+void AudioContext::suspend()
+{
+    if (m_isOfflineContext || !m_isInitialized)
+        return;
+
+    if (m_suspended.exchange(true))
+        return;
+
+    // explicit suspension subsumes any auto-idle parking
+    m_autoIdled = false;
+
+    if (m_destinationNode)
+        m_destinationNode->stopRendering();
+
+    // let the update thread observe the state and quiesce its periodic tick
+    cv.notify_all();
+}
+
+void AudioContext::resume()
+{
+    if (m_isOfflineContext || !m_isInitialized)
+        return;
+
+    bool wasSuspended = m_suspended.exchange(false);
+    bool wasIdled = m_autoIdled.exchange(false);
+
+    if ((wasSuspended || wasIdled) && m_destinationNode)
+        m_destinationNode->startRendering();
+
+    cv.notify_all();
+}
+
+bool AudioContext::isSuspended() const
+{
+    return m_suspended.load() || m_autoIdled.load();
+}
+
+void AudioContext::setAutoIdle(bool enabled, double idleSeconds)
+{
+    m_autoIdleSeconds = static_cast<float>(idleSeconds > 0 ? idleSeconds : 0);
+    m_autoIdleEnabled = enabled;
+    if (!enabled)
+        wakeFromAutoIdle();
+    cv.notify_all();
+}
+
+void AudioContext::handleDeviceChange()
+{
+    if (m_isOfflineContext || !m_destinationNode)
+        return;
+
+    m_destinationNode->handleDeviceChange();
+}
+
+void AudioContext::wakeFromAutoIdle()
+{
+    if (m_autoIdled.exchange(false) && m_destinationNode)
+        m_destinationNode->startRendering();
+}
+
 } // End namespace lab
@@ -8,14 +8,19 @@
 #include "LabSound/core/AudioNodeInput.h"
 #include "LabSound/core/AudioNodeOutput.h"
 #include "LabSound/core/AudioSourceProvider.h"
+#include "LabSound/core/TraceRecorder.h"
 
 #include "LabSound/extended/AudioContextLock.h"
 
 #include "internal/Assertions.h"
+#include "internal/AudioDestinationMirror.h"
 #include "internal/AudioUtilities.h"
 #include "internal/DenormalDisabler.h"
+#include "internal/GraphRenderScheduler.h"
+#include "internal/RenderAllocationDetector.h"
 
 #include <chrono>
+#include <vector>
 
 namespace lab
 {
@@ -37,25 +42,128 @@ public:
     {
     }
 
-    void set(AudioBus * bus)
+    void set(AudioBus * bus, uint64_t captureFrame)
     {
         if (bus) m_sourceBus.copyFrom(*bus);
+        m_captureFrame = captureFrame;
+    }
+
+    // The driver's input buffer is stable for the whole device callback, so
+    // while a quantum is rendering the provider can hand consumers a view of
+    // it directly instead of staging a copy. The pointer is only valid under
+    // the render lock and is cleared before render() returns.
+    void setLive(AudioBus * bus, uint64_t captureFrame)
+    {
+        m_liveInputBus = bus;
+        m_captureFrame = captureFrame;
+    }
+
+    void endQuantum()
+    {
+        m_liveInputBus = nullptr;
     }
 
     // AudioSourceProvider.
     virtual void provideInput(AudioBus * destinationBus, size_t numberOfFrames)
     {
-        bool isGood = destinationBus && destinationBus->length() == numberOfFrames && m_sourceBus.length() == numberOfFrames;
+        bool isGood = destinationBus && destinationBus->length() == numberOfFrames;
         ASSERT(isGood);
-        if (isGood) destinationBus->copyFrom(m_sourceBus);
+        if (!isGood) return;
+
+        if (m_liveInputBus && m_liveInputBus->length() == numberOfFrames)
+        {
+            // one pass, straight out of the driver's buffer into the consumer
+            destinationBus->copyFrom(*m_liveInputBus);
+            m_lastTapLatencyFrames = numberOfFrames; // captured and emitted within the same callback
+        }
+        else if (m_sourceBus.length() == numberOfFrames)
+        {
+            destinationBus->copyFrom(m_sourceBus);
+            m_lastTapLatencyFrames = (m_currentSampleFrame / 2 - m_captureFrame) + numberOfFrames;
+        }
     }
 
     // Counts the number of sample-frames processed by the destination.
     uint64_t m_currentSampleFrame = 0;
 
+    // Frames between an input sample entering the device callback and the
+    // rendered output containing it leaving, as observed at the last tap.
+    uint64_t m_lastTapLatencyFrames = 0;
+
     // low bit of m_currentSampleFrame indexes time point 0 or 1
     // this is so that time and epoch are written atomically, after the alternative epoch has been filled in.
     std::chrono::high_resolution_clock::time_point epoch[2];
+
+private:
+    AudioBus * m_liveInputBus = nullptr;
+    uint64_t m_captureFrame = 0;
+};
+
+// Planar sample FIFO used to adapt arbitrary device callback sizes to the
+// graph's fixed rendering quantum. Only ever touched from the device callback
+// thread, so plain indices suffice; capacity is a power of two.
+struct AudioDestinationNode::RenderFifo
+{
+    void configure(size_t channels, size_t minimumCapacity)
+    {
+        size_t capacity = 1;
+        while (capacity < minimumCapacity)
+            capacity *= 2;
+
+        if (channels == m_channels.size() && capacity <= m_capacity)
+            return;
+
+        m_channels.assign(channels, std::vector<float>(capacity, 0.f));
+        m_capacity = capacity;
+        m_read = m_write = 0;
+    }
+
+    size_t framesAvailable() const { return m_write - m_read; }
+
+    void push(const AudioBus * bus, size_t frames)
+    {
+        size_t mask = m_capacity - 1;
+        for (size_t c = 0; c < m_channels.size(); ++c)
+        {
+            const float * src = c < bus->numberOfChannels() ? bus->channel(c)->data() : nullptr;
+            float * ring = m_channels[c].data();
+            for (size_t i = 0; i < frames; ++i)
+                ring[(m_write + i) & mask] = src ? src[i] : 0.f;
+        }
+        m_write += frames;
+    }
+
+    void pushSilence(size_t frames)
+    {
+        size_t mask = m_capacity - 1;
+        for (size_t c = 0; c < m_channels.size(); ++c)
+        {
+            float * ring = m_channels[c].data();
+            for (size_t i = 0; i < frames; ++i)
+                ring[(m_write + i) & mask] = 0.f;
+        }
+        m_write += frames;
+    }
+
+    void pop(AudioBus * bus, size_t frames)
+    {
+        size_t mask = m_capacity - 1;
+        for (size_t c = 0; c < m_channels.size(); ++c)
+        {
+            float * dst = c < bus->numberOfChannels() ? bus->channel(c)->mutableData() : nullptr;
+            if (!dst)
+                continue;
+            const float * ring = m_channels[c].data();
+            for (size_t i = 0; i < frames; ++i)
+                dst[i] = ring[(m_read + i) & mask];
+        }
+        m_read += frames;
+    }
+
+    std::vector<std::vector<float>> m_channels;
+    size_t m_capacity = 0;
+    size_t m_read = 0;
+    size_t m_write = 0;
 };
 
 AudioDestinationNode::AudioDestinationNode(AudioContext * context, size_t channelCount, float sampleRate)
@@ -63,6 +171,11 @@ AudioDestinationNode::AudioDestinationNode(AudioContext * context, size_t channe
     , m_context(context)
 {
     m_localAudioInputProvider = new LocalAudioInputProvider(channelCount);
+    m_renderScheduler.reset(new GraphRenderScheduler());
+
+    // So the mirror-cache refresh in render() never allocates.
+    m_mirrors.reserve(8);
+    m_renderMirrors.reserve(8);
 
     addInput(std::unique_ptr<AudioNodeInput>(new AudioNodeInput(this)));
 
@@ -90,14 +203,177 @@ void AudioDestinationNode::reset(ContextRenderLock &)
 };
 
 void AudioDestinationNode::render(AudioBus * sourceBus, AudioBus * destinationBus, size_t numberOfFrames)
+{
+    // Time the whole device callback against its deadline: the buffer's
+    // duration at the device rate. Everything here is a relaxed atomic store
+    // from the single callback thread - no locks, no allocation.
+    auto callbackStart = std::chrono::high_resolution_clock::now();
+
+    // Any heap allocation between here and the end of the callback is a
+    // real-time-safety regression; the detector (when built in) counts and
+    // attributes them, or aborts in hard-fail mode.
+    RenderAllocationDetector::RenderSpan allocationSpan;
+
+    renderDeviceBuffer(sourceBus, destinationBus, numberOfFrames);
+
+    // Feed any mirror outputs from this same pass. The cache refresh uses a
+    // try_lock so a thread attaching or detaching a mirror can never block
+    // the callback; a missed refresh simply lands next quantum.
+    if (m_mirrorsDirty.load(std::memory_order_acquire) && m_mirrorMutex.try_lock())
+    {
+        m_renderMirrors.clear();
+        for (auto & entry : m_mirrors)
+            m_renderMirrors.push_back(entry.second);
+        m_mirrorsDirty.store(false, std::memory_order_release);
+        m_mirrorMutex.unlock();
+    }
+    for (auto & mirror : m_renderMirrors)
+        mirror->pushRenderedQuantum(destinationBus, numberOfFrames);
+
+    auto callbackEnd = std::chrono::high_resolution_clock::now();
+    TraceRecorder::instance().record(TraceRecorder::Category::Quantum, "audio callback",
+                                     0, callbackStart, callbackEnd);
+    uint64_t durationUs = std::chrono::duration_cast<std::chrono::microseconds>(callbackEnd - callbackStart).count();
+    uint64_t deadlineUs = static_cast<uint64_t>(1.0e6 * numberOfFrames / m_sampleRate);
+    int64_t marginUs = static_cast<int64_t>(deadlineUs) - static_cast<int64_t>(durationUs);
+
+    uint64_t priorCallbacks = m_statCallbacks.load(std::memory_order_relaxed);
+    m_statCallbacks.store(priorCallbacks + 1, std::memory_order_relaxed);
+    m_statLastMicroseconds.store(durationUs, std::memory_order_relaxed);
+    m_statSumMicroseconds.fetch_add(durationUs, std::memory_order_relaxed);
+    if (durationUs > m_statMaxMicroseconds.load(std::memory_order_relaxed))
+        m_statMaxMicroseconds.store(durationUs, std::memory_order_relaxed);
+    m_statLastMarginMicroseconds.store(marginUs, std::memory_order_relaxed);
+    if (!priorCallbacks || marginUs < m_statMinMarginMicroseconds.load(std::memory_order_relaxed))
+        m_statMinMarginMicroseconds.store(marginUs, std::memory_order_relaxed);
+    if (durationUs > deadlineUs)
+        m_statOverruns.fetch_add(1, std::memory_order_relaxed);
+
+    // one bucket per eighth of the deadline, the last catching >= 2x
+    int bucket = deadlineUs ? static_cast<int>((durationUs * 8) / deadlineUs) : CallbackStats::LoadHistogramSize - 1;
+    if (bucket >= CallbackStats::LoadHistogramSize)
+        bucket = CallbackStats::LoadHistogramSize - 1;
+    m_statLoadHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    float threshold = m_lowMarginFraction.load(std::memory_order_relaxed);
+    if (threshold > 0.f && marginUs < static_cast<int64_t>(threshold * deadlineUs))
+    {
+        auto handler = std::atomic_load_explicit(&m_lowMarginCallback, std::memory_order_acquire);
+        if (handler && *handler)
+            (*handler)(durationUs, deadlineUs);
+    }
+}
+
+void AudioDestinationNode::renderDeviceBuffer(AudioBus * sourceBus, AudioBus * destinationBus, size_t numberOfFrames)
+{
+    // Denormals can slow down audio processing.
+    /// @TODO under what circumstance do they arise?
+    /// If they come from input data such as loaded WAV files, they should be corrected
+    /// at source. If they can result from signal processing; again, where? The
+    /// signal processing should not produce denormalized values.
+    // Use an RAII object to protect the entire device callback - the graph
+    // render and any buffer-size adaptation around it - restoring the caller's
+    // FP environment on the way out.
+    DenormalDisabler denormalDisabler;
+
+    const size_t quantum = AudioNode::ProcessingSizeInFrames;
+    const size_t lookaheadQuanta = m_lookaheadQuanta.load(std::memory_order_relaxed);
+
+    // The budget for rendering ahead is whatever remains of this callback's
+    // deadline once the device's own frames are rendered.
+    auto callbackEntry = std::chrono::high_resolution_clock::now();
+
+    // The common case: the device callback matches the graph's quantum, so no
+    // adaptation and no extra latency.
+    if (numberOfFrames == quantum && !lookaheadQuanta)
+    {
+        renderQuantum(sourceBus, destinationBus, numberOfFrames);
+        return;
+    }
+
+    // Otherwise the graph still renders aligned whole quanta; a FIFO on each
+    // side adapts the device's buffer size. Exact multiples of the quantum
+    // drain completely every callback and add no latency; other sizes carry a
+    // sub-quantum residue, costing at most one quantum of latency. A
+    // lookahead request widens the output ring so a rendered-ahead surplus
+    // can accumulate on top of the adaptation residue.
+    if (!m_inputFifo)
+    {
+        m_inputFifo.reset(new RenderFifo());
+        m_outputFifo.reset(new RenderFifo());
+    }
+
+    size_t inputChannels = sourceBus ? sourceBus->numberOfChannels() : 0;
+    size_t outputChannels = destinationBus->numberOfChannels();
+    m_inputFifo->configure(inputChannels, numberOfFrames + quantum);
+    m_outputFifo->configure(outputChannels, numberOfFrames + quantum + lookaheadQuanta * quantum);
+
+    if (sourceBus)
+    {
+        if (!m_adapterInputBus || m_adapterInputBus->numberOfChannels() != inputChannels)
+            m_adapterInputBus.reset(new AudioBus(inputChannels, quantum));
+        m_inputFifo->push(sourceBus, numberOfFrames);
+    }
+    if (!m_adapterOutputBus || m_adapterOutputBus->numberOfChannels() != outputChannels)
+        m_adapterOutputBus.reset(new AudioBus(outputChannels, quantum));
+
+    auto renderQuantumIntoFifo = [&]() {
+        AudioBus * quantumSource = nullptr;
+        if (sourceBus)
+        {
+            // short only transiently at stream start, when less than a whole
+            // quantum of input has arrived yet - and for any quantum rendered
+            // ahead of the input actually arriving
+            if (m_inputFifo->framesAvailable() < quantum)
+                m_inputFifo->pushSilence(quantum - m_inputFifo->framesAvailable());
+            m_inputFifo->pop(m_adapterInputBus.get(), quantum);
+            quantumSource = m_adapterInputBus.get();
+        }
+
+        renderQuantum(quantumSource, m_adapterOutputBus.get(), quantum);
+        m_outputFifo->push(m_adapterOutputBus.get(), quantum);
+    };
+
+    // What this callback must render; a surplus from earlier callbacks
+    // covers part or all of it, which is the lookahead's spike immunity.
+    while (m_outputFifo->framesAvailable() < numberOfFrames)
+        renderQuantumIntoFifo();
+
+    // Render ahead with the deadline budget left over, stopping at half the
+    // deadline so the refill itself can never be what overruns the callback.
+    if (lookaheadQuanta)
+    {
+        const double budgetSeconds = 0.5 * numberOfFrames / static_cast<double>(m_sampleRate);
+        const size_t targetFrames = numberOfFrames + lookaheadQuanta * quantum;
+        while (m_outputFifo->framesAvailable() < targetFrames)
+        {
+            std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - callbackEntry;
+            if (elapsed.count() >= budgetSeconds)
+                break;
+            renderQuantumIntoFifo();
+        }
+    }
+
+    m_outputFifo->pop(destinationBus, numberOfFrames);
+}
+
+void AudioDestinationNode::renderQuantum(AudioBus * sourceBus, AudioBus * destinationBus, size_t numberOfFrames)
 {
     // The audio system might still be invoking callbacks during shutdown, so bail out if so.
     if (!m_context)
         return;
 
-    ContextRenderLock renderLock(m_context, "AudioDestinationNode::render");
+    // Bound the wait for the render lock to a fraction of the quantum's duration.
+    // If a main thread is mutating the graph, emitting one silent quantum is far
+    // less audible than stalling the device callback and cascading xruns.
+    auto quantumDuration = std::chrono::microseconds(static_cast<int64_t>(1.0e6 * numberOfFrames / m_sampleRate));
+    ContextRenderLock renderLock(m_context, "AudioDestinationNode::render", quantumDuration / 4);
     if (!renderLock.context())
-        return;  // return if couldn't acquire lock
+    {
+        destinationBus->zero();
+        m_context->countMissedRenderQuantum();
+        return;
+    }
 
     if (!m_context->isInitialized())
     {
@@ -105,23 +381,49 @@ void AudioDestinationNode::render(AudioBus * sourceBus, AudioBus * destinationBu
         return;
     }
 
-    // Denormals can slow down audio processing.
-    /// @TODO under what circumstance do they arise?
-    /// If they come from input data such as loaded WAV files, they should be corrected
-    /// at source. If they can result from signal processing; again, where? The
-    /// signal processing should not produce denormalized values.
-    // Use an RAII object to protect all AudioNodes processed within this scope.
-    DenormalDisabler denormalDisabler;
+    // FTZ/DAZ was established at the top of render(), which is the only caller.
 
     // Let the context take care of any business at the start of each render quantum.
     m_context->handlePreRenderTasks(renderLock);
 
-    // Prepare the local audio input provider for this render quantum.
+    // Prepare the local audio input provider for this render quantum. The
+    // backend's input bus already aliases the driver's buffer, so when its
+    // quantum matches the graph reads it in place; otherwise fall back to
+    // staging a copy as before.
     if (sourceBus)
-        m_localAudioInputProvider->set(sourceBus);
+    {
+        if (sourceBus->length() == numberOfFrames)
+            m_localAudioInputProvider->setLive(sourceBus, currentSampleFrame());
+        else
+            m_localAudioInputProvider->set(sourceBus, currentSampleFrame());
+    }
 
     /// @TODO why is only input 0 processed?
 
+    // Refresh the flattened order (and with it the fused-chain cache) before
+    // anything renders, so the parallel pass below already sees the current
+    // topology's chains rather than falling back un-fused for a quantum.
+    m_context->renderOrder(renderLock);
+
+    // Process independent subgraphs on the worker pool; their results are cached
+    // in the node output busses, so the pull below only needs to sum them.
+    if (m_parallelRenderingEnabled)
+        m_renderScheduler->preRender(renderLock, input(0).get(), numberOfFrames);
+
+    // Iterate the flattened render order; upstream nodes come first so each node's
+    // inputs are already rendered when it is reached, avoiding deep recursion.
+    // Anything the parallel scheduler already touched is a cheap no-op here.
+    for (AudioNodeOutput * output : m_context->renderOrder(renderLock))
+    {
+        if (output && output->node())
+        {
+            AudioNode * n = output->node();
+            for (size_t i = 0; i < n->numberOfOutputs(); ++i)
+                n->output(i)->clearInPlaceBus();
+            n->processIfNecessary(renderLock, numberOfFrames);
+        }
+    }
+
     // process the graph by pulling the inputs, which will recurse the entire processing graph.
     AudioBus * renderedBus = input(0)->pull(renderLock, destinationBus, numberOfFrames);
 
@@ -135,12 +437,41 @@ void AudioDestinationNode::render(AudioBus * sourceBus, AudioBus * destinationBu
         destinationBus->copyFrom(*renderedBus);
     }
 
+    // Track verified output silence for the context's auto-idle: trust the
+    // bus's silent flag when it is set, otherwise scan the samples (the scan
+    // exits at the first audible sample, so it is nearly free while sound
+    // is actually playing).
+    bool silent = destinationBus->isSilent();
+    if (!silent)
+    {
+        silent = true;
+        for (unsigned c = 0; silent && c < destinationBus->numberOfChannels(); ++c)
+        {
+            const float * data = destinationBus->channel(c)->data();
+            for (size_t i = 0; i < numberOfFrames; ++i)
+            {
+                if (data[i] != 0.f)
+                {
+                    silent = false;
+                    break;
+                }
+            }
+        }
+    }
+    if (silent)
+        m_consecutiveSilentFrames.fetch_add(numberOfFrames, std::memory_order_relaxed);
+    else
+        m_consecutiveSilentFrames.store(0, std::memory_order_relaxed);
+
     // Process nodes which need a little extra help because they are not connected to anything, but still need to process.
     m_context->processAutomaticPullNodes(renderLock, numberOfFrames);
 
     // Let the context take care of any business at the end of each render quantum.
     m_context->handlePostRenderTasks(renderLock);
 
+    // The driver's input buffer is about to go out of scope.
+    m_localAudioInputProvider->endQuantum();
+
     // Advance current sample-frame.
     int index = 1 - (m_localAudioInputProvider->m_currentSampleFrame & 1);
     m_localAudioInputProvider->epoch[index] = std::chrono::high_resolution_clock::now();
@@ -173,4 +504,113 @@ AudioSourceProvider * AudioDestinationNode::localAudioInputProvider()
     return static_cast<AudioSourceProvider *>(m_localAudioInputProvider);
 }
 
+uint64_t AudioDestinationNode::inputToOutputLatencyFrames() const
+{
+    return m_localAudioInputProvider->m_lastTapLatencyFrames;
+}
+
+double AudioDestinationNode::silentDuration() const
+{
+    return m_consecutiveSilentFrames.load(std::memory_order_relaxed) / static_cast<double>(m_sampleRate);
+}
+
+void AudioDestinationNode::skipSilentFrames(size_t numberOfFrames)
+{
+    m_consecutiveSilentFrames.fetch_add(numberOfFrames, std::memory_order_relaxed);
+
+    // Advance the sample-frame clock exactly as renderQuantum() does.
+    int index = 1 - (m_localAudioInputProvider->m_currentSampleFrame & 1);
+    m_localAudioInputProvider->epoch[index] = std::chrono::high_resolution_clock::now();
+    uint64_t t = m_localAudioInputProvider->m_currentSampleFrame & ~1;
+    m_localAudioInputProvider->m_currentSampleFrame = t + numberOfFrames * 2 + index;
+}
+
+AudioDestinationNode::CallbackStats AudioDestinationNode::callbackStats() const
+{
+    CallbackStats stats;
+    stats.callbacks = m_statCallbacks.load(std::memory_order_relaxed);
+    stats.overruns = m_statOverruns.load(std::memory_order_relaxed);
+    stats.lastMicroseconds = m_statLastMicroseconds.load(std::memory_order_relaxed);
+    stats.maxMicroseconds = m_statMaxMicroseconds.load(std::memory_order_relaxed);
+    stats.averageMicroseconds = stats.callbacks
+        ? static_cast<double>(m_statSumMicroseconds.load(std::memory_order_relaxed)) / stats.callbacks
+        : 0.0;
+    stats.lastMarginMicroseconds = m_statLastMarginMicroseconds.load(std::memory_order_relaxed);
+    stats.minMarginMicroseconds = m_statMinMarginMicroseconds.load(std::memory_order_relaxed);
+    for (int i = 0; i < CallbackStats::LoadHistogramSize; ++i)
+        stats.loadHistogram[i] = m_statLoadHistogram[i].load(std::memory_order_relaxed);
+    return stats;
+}
+
+void AudioDestinationNode::resetCallbackStats()
+{
+    m_statCallbacks.store(0, std::memory_order_relaxed);
+    m_statOverruns.store(0, std::memory_order_relaxed);
+    m_statLastMicroseconds.store(0, std::memory_order_relaxed);
+    m_statMaxMicroseconds.store(0, std::memory_order_relaxed);
+    m_statSumMicroseconds.store(0, std::memory_order_relaxed);
+    m_statLastMarginMicroseconds.store(0, std::memory_order_relaxed);
+    m_statMinMarginMicroseconds.store(0, std::memory_order_relaxed);
+    for (int i = 0; i < CallbackStats::LoadHistogramSize; ++i)
+        m_statLoadHistogram[i].store(0, std::memory_order_relaxed);
+}
+
+int AudioDestinationNode::addMirrorOutput(size_t numberOfChannels, float sampleRate)
+{
+    std::lock_guard<std::mutex> lock(m_mirrorMutex);
+
+    // Once the callback thread has refreshed its cache, retired mirrors are
+    // unreferenced there and can be freed here.
+    if (!m_mirrorsDirty.load(std::memory_order_acquire))
+        m_retiredMirrors.clear();
+
+    if (m_mirrors.size() >= m_mirrors.capacity())
+        return -1;
+
+    auto mirror = std::make_shared<AudioDestinationMirror>(numberOfChannels, sampleRate, m_sampleRate);
+    mirror->start();
+
+    int id = m_nextMirrorId++;
+    m_mirrors.emplace_back(id, std::move(mirror));
+    m_mirrorsDirty.store(true, std::memory_order_release);
+    return id;
+}
+
+void AudioDestinationNode::removeMirrorOutput(int id)
+{
+    std::lock_guard<std::mutex> lock(m_mirrorMutex);
+
+    if (!m_mirrorsDirty.load(std::memory_order_acquire))
+        m_retiredMirrors.clear();
+
+    for (auto it = m_mirrors.begin(); it != m_mirrors.end(); ++it)
+    {
+        if (it->first == id)
+        {
+            it->second->stop();
+            m_retiredMirrors.push_back(std::move(it->second));
+            m_mirrors.erase(it);
+            m_mirrorsDirty.store(true, std::memory_order_release);
+            break;
+        }
+    }
+}
+
+void AudioDestinationNode::setLowMarginCallback(float marginFraction, std::function<void(uint64_t, uint64_t)> handler)
+{
+    if (handler)
+    {
+        auto shared = std::make_shared<const std::function<void(uint64_t, uint64_t)>>(std::move(handler));
+        std::atomic_store_explicit(&m_lowMarginCallback, std::move(shared), std::memory_order_release);
+        m_lowMarginFraction.store(marginFraction, std::memory_order_relaxed);
+    }
+    else
+    {
+        m_lowMarginFraction.store(0.f, std::memory_order_relaxed);
+        std::atomic_store_explicit(&m_lowMarginCallback,
+                                   std::shared_ptr<const std::function<void(uint64_t, uint64_t)>>(),
+                                   std::memory_order_release);
+    }
+}
+
 }  // namespace lab
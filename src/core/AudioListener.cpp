@@ -2,6 +2,9 @@
 // Copyright (C) 2018, The LabSound Authors. All rights reserved.
 
 #include "LabSound/core/AudioListener.h"
+#include "LabSound/core/AudioContext.h"
+
+#include "LabSound/extended/AudioContextLock.h"
 
 namespace lab
 {
@@ -23,18 +26,33 @@ namespace lab
 
     }
 
+    void AudioListener::publish()
+    {
+        // Seqlock write: an odd sequence marks the block in flight. A reader
+        // that catches it mid-write retries or keeps the previous quantum's
+        // copy, so the render thread never waits here.
+        m_sequence.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_published = m_shadow;
+        m_sequence.fetch_add(1, std::memory_order_release);
+    }
+
     void AudioListener::setForward(const FloatPoint3D& fwd)
     {
         m_forwardX->setValue(fwd.x);
         m_forwardY->setValue(fwd.y);
         m_forwardZ->setValue(fwd.z);
+        m_shadow.forward = fwd;
+        publish();
     }
 
-    void AudioListener::setUpVector(const FloatPoint3D &upVector) 
-    { 
+    void AudioListener::setUpVector(const FloatPoint3D &upVector)
+    {
         m_upX->setValue(upVector.x);
         m_upY->setValue(upVector.y);
         m_upZ->setValue(upVector.z);
+        m_shadow.up = upVector;
+        publish();
     }
 
     void AudioListener::setPosition(const FloatPoint3D &position)
@@ -42,6 +60,8 @@ namespace lab
         m_positionX->setValue(position.x);
         m_positionY->setValue(position.y);
         m_positionZ->setValue(position.z);
+        m_shadow.position = position;
+        publish();
     }
 
     void AudioListener::setVelocity(const FloatPoint3D &velocity)
@@ -49,6 +69,88 @@ namespace lab
         m_velocityX->setValue(velocity.x);
         m_velocityY->setValue(velocity.y);
         m_velocityZ->setValue(velocity.z);
+        m_shadow.velocity = velocity;
+        publish();
+    }
+
+    void AudioListener::setDopplerFactor(float dopplerFactor)
+    {
+        m_dopplerFactor->setValue(dopplerFactor);
+        m_shadow.dopplerFactor = dopplerFactor;
+        publish();
+    }
+
+    void AudioListener::setSpeedOfSound(float speedOfSound)
+    {
+        m_speedOfSound->setValue(speedOfSound);
+        m_shadow.speedOfSound = speedOfSound;
+        publish();
+    }
+
+    const AudioListener::Snapshot & AudioListener::snapshot(ContextRenderLock & r)
+    {
+        uint64_t frame = r.context()->currentSampleFrame();
+        if (m_renderSnapshotFrame == frame)
+            return m_renderSnapshot;
+
+        // Seqlock read: retry while the writer holds the block. If the
+        // writer is mid-write on every attempt, keep the previous quantum's
+        // coherent copy rather than waiting for it.
+        for (int attempt = 0; attempt < 4; ++attempt)
+        {
+            uint32_t seq = m_sequence.load(std::memory_order_acquire);
+            if (seq & 1)
+                continue;
+
+            Snapshot copy = m_published;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_sequence.load(std::memory_order_relaxed) == seq)
+            {
+                m_renderSnapshot = copy;
+                break;
+            }
+        }
+
+        m_renderSnapshotFrame = frame;
+        return m_renderSnapshot;
+    }
+
+    const AudioListener::Basis & AudioListener::basis(ContextRenderLock & r)
+    {
+        const Snapshot & s = snapshot(r);
+        FloatPoint3D forward = s.forward;
+        FloatPoint3D up = s.up;
+
+        bool moved = !m_basisValid
+            || fabsf(forward.x - m_basisForward.x) > FLT_EPSILON
+            || fabsf(forward.y - m_basisForward.y) > FLT_EPSILON
+            || fabsf(forward.z - m_basisForward.z) > FLT_EPSILON
+            || fabsf(up.x - m_basisUp.x) > FLT_EPSILON
+            || fabsf(up.y - m_basisUp.y) > FLT_EPSILON
+            || fabsf(up.z - m_basisUp.z) > FLT_EPSILON;
+
+        if (moved)
+        {
+            // A degenerate forward or up (zero, or parallel to each other)
+            // keeps the previous basis rather than producing NaNs.
+            if (!is_zero(forward))
+            {
+                FloatPoint3D front = normalize(forward);
+                FloatPoint3D crossed = cross(front, up);
+                if (!is_zero(crossed))
+                {
+                    m_basis.front = front;
+                    m_basis.right = normalize(crossed);
+                    m_basis.up = cross(m_basis.right, m_basis.front);
+                }
+            }
+
+            m_basisForward = forward;
+            m_basisUp = up;
+            m_basisValid = true;
+        }
+
+        return m_basis;
     }
 
 }
@@ -10,15 +10,25 @@
 #include "LabSound/core/AudioNodeOutput.h"
 #include "LabSound/core/AudioParam.h"
 #include "LabSound/core/AudioSetting.h"
+#include "LabSound/core/TraceRecorder.h"
 #include "LabSound/extended/AudioContextLock.h"
 
 #include "internal/Assertions.h"
+#include "internal/DenormalDisabler.h"
+#include "internal/RenderAllocationDetector.h"
+
+#include <chrono>
 
 using namespace std;
 
 namespace lab {
 
-AudioNode::AudioNode() = default;
+AudioNode::AudioNode()
+{
+    static std::atomic<uint64_t> nextID{1};
+    m_id = nextID.fetch_add(1, std::memory_order_relaxed);
+}
+
 AudioNode::~AudioNode() = default;
 
 void AudioNode::initialize()
@@ -122,6 +132,21 @@ void AudioNode::processIfNecessary(ContextRenderLock & r, size_t framesToProcess
     {
         m_lastProcessingTime = currentTime; // important to first update this time to accomodate feedback loops in the rendering graph
 
+        // A control-rate node computes one sample per quantum; the params it
+        // drives upsample at the boundary (see setControlRate).
+        if (m_isControlRate)
+            framesToProcess = 1;
+
+        // Latch the bypass flag for the quantum. An alias published by a
+        // previous bypassed quantum is stale and must be forgotten before
+        // anything reads or renders into the output bus (the recursive pull
+        // already clears it; the flattened schedule calls here directly).
+        bool wasBypassing = m_bypassedThisQuantum;
+        m_bypassedThisQuantum = m_inputs.size() == 1 && m_outputs.size() == 1
+            && m_bypassed.load(std::memory_order_relaxed);
+        if (wasBypassing || m_bypassedThisQuantum)
+            output(0)->clearAliasBus();
+
         pullInputs(r, framesToProcess);
 
         bool silentInputs = inputsAreSilent(r);
@@ -130,61 +155,183 @@ void AudioNode::processIfNecessary(ContextRenderLock & r, size_t framesToProcess
             m_lastNonSilentTime = (ac->currentSampleFrame() + framesToProcess) / static_cast<double>(ac->sampleRate());
         }
 
+        if (m_bypassedThisQuantum)
+        {
+            // The kernel is skipped outright. If the upstream source already
+            // rendered into the output bus (pullInputs suggested it as the
+            // in-place target) there is nothing to do; if a downstream
+            // consumer owns the output memory, or the channel counts differ,
+            // the input is copied (and mixed) into the output; otherwise the
+            // input bus is published as an alias and no samples move.
+            AudioNodeOutput * out = output(0).get();
+            AudioBus * inBus = input(0)->bus(r);
+            AudioBus * outBus = out->bus(r);
+            if (inBus != outBus)
+            {
+                if (!out->isRenderingInPlace() && inBus->numberOfChannels() == outBus->numberOfChannels())
+                    out->setAliasBus(inBus);
+                else
+                    outBus->copyFrom(*inBus);
+            }
+
+            // The fades still run so a node mid connect or disconnect ramp
+            // cannot pop when bypass is toggled.
+            applyScheduledFades(r);
+        }
         // if this node is supposed to copy silence through, and is itself silent
-        if (silentInputs && propagatesSilence(r))
+        else if (silentInputs && propagatesSilence(r))
         {
             silenceOutputs(r);
         }
         else
         {
+            // When disabled these cost a couple of well-predicted branches per node per quantum.
+            bool profiling = ac->profilingEnabled();
+            bool tracing = TraceRecorder::instance().enabled();
+            std::chrono::high_resolution_clock::time_point profileStart;
+            if (profiling || tracing)
+                profileStart = std::chrono::high_resolution_clock::now();
+
+            // Attribute any render-thread allocations to this node while its
+            // kernel runs; a no-op unless built with the detector.
+            RenderAllocationDetector::NodeScope allocationScope(this);
+
             process(r, framesToProcess);
 
-            float new_schedule = 0.f;
+            applyScheduledFades(r);
 
-            if (m_disconnectSchedule >= 0)
+            if (profiling || tracing)
             {
-                for (auto out : m_outputs)
-                    for (unsigned i = 0; i < out->bus(r)->numberOfChannels(); ++i)
-                    {
-                        float scale = m_disconnectSchedule;
-                        float * sample = out->bus(r)->channel(i)->mutableData();
-                        size_t numSamples = out->bus(r)->channel(i)->length();
-                        for (size_t s = 0; s < numSamples; ++s)
-                        {
-                            sample[s] *= scale;
-                            scale *= 0.98f;
-                        }
-                        new_schedule = scale;
-                    }
-
-                m_disconnectSchedule = new_schedule;
+                auto profileEnd = std::chrono::high_resolution_clock::now();
+                if (profiling)
+                    recordProcessTime(std::chrono::duration_cast<std::chrono::microseconds>(profileEnd - profileStart).count());
+                if (tracing)
+                {
+                    // The raw typeid name has static storage; it is demangled
+                    // once at dump time, not here on the render thread.
+                    TraceRecorder::instance().record(TraceRecorder::Category::Node,
+                                                     typeid(*this).name(), id(),
+                                                     profileStart, profileEnd);
+                }
             }
 
-            new_schedule = 1.f;
-            if (m_connectSchedule < 1)
+#ifndef NDEBUG
+            // With FTZ/DAZ active on every render thread these should never
+            // fire; a nonzero count points at a kernel computing outside the
+            // protected scope, or at denormal-laden source material.
+            for (auto out : m_outputs)
+                for (unsigned i = 0; i < out->bus(r)->numberOfChannels(); ++i)
+                {
+                    AudioChannel * c = out->bus(r)->channel(i);
+                    size_t found = countDenormalsInBlock(c->data(), c->length());
+                    if (found)
+                        denormalAuditCount().fetch_add(found, std::memory_order_relaxed);
+                }
+#endif
+
+            // Silent flags are maintained through AudioChannel's accessors:
+            // writing through mutableData() clears a channel's flag and
+            // zero() sets it. If process() left every output flagged silent
+            // it genuinely emitted silence (a muted gain, an expired tail
+            // fast path), and clearing the flags here would force the whole
+            // downstream chain to process those zeros.
+            if (!outputsAreSilent(r))
+                unsilenceOutputs(r);
+        }
+    }
+}
+
+void AudioNode::applyScheduledFades(ContextRenderLock & r)
+{
+    float new_schedule = 0.f;
+
+    if (m_disconnectSchedule >= 0)
+    {
+        for (auto out : m_outputs)
+        {
+            // The fade scales the published bus in place; an aliased
+            // bus must first be materialized as a copy.
+            AudioBus * outBus = out->materializeAliasBus(r);
+            for (unsigned i = 0; i < outBus->numberOfChannels(); ++i)
             {
-                for (auto out : m_outputs)
-                    for (unsigned i = 0; i < out->bus(r)->numberOfChannels(); ++i)
-                    {
-                        float scale = m_connectSchedule;
-                        float * sample = out->bus(r)->channel(i)->mutableData();
-                        size_t numSamples = out->bus(r)->channel(i)->length();
-                        for (size_t s = 0; s < numSamples; ++s)
-                        {
-                            sample[s] *= scale;
-                            scale = 1.f - ((1.f - scale) * 0.98f);
-                        }
-                        new_schedule = scale;
-                    }
-
-                m_connectSchedule = new_schedule;
+                float scale = m_disconnectSchedule;
+                float * sample = outBus->channel(i)->mutableData();
+                size_t numSamples = outBus->channel(i)->length();
+                for (size_t s = 0; s < numSamples; ++s)
+                {
+                    sample[s] *= scale;
+                    scale *= 0.98f;
+                }
+                new_schedule = scale;
             }
+        }
 
-            unsilenceOutputs(r);
+        m_disconnectSchedule = new_schedule;
+    }
+
+    new_schedule = 1.f;
+    if (m_connectSchedule < 1)
+    {
+        for (auto out : m_outputs)
+        {
+            AudioBus * outBus = out->materializeAliasBus(r);
+            for (unsigned i = 0; i < outBus->numberOfChannels(); ++i)
+            {
+                float scale = m_connectSchedule;
+                float * sample = outBus->channel(i)->mutableData();
+                size_t numSamples = outBus->channel(i)->length();
+                for (size_t s = 0; s < numSamples; ++s)
+                {
+                    sample[s] *= scale;
+                    scale = 1.f - ((1.f - scale) * 0.98f);
+                }
+                new_schedule = scale;
+            }
         }
+
+        // The per-sample ramp approaches unity asymptotically and in
+        // float arithmetic stalls just below it; snap once inaudibly
+        // close so the fade-in cost (and the silent-flag clearing
+        // that comes with touching the busses) ends.
+        if (new_schedule > 0.99999f)
+            new_schedule = 1.f;
+
+        m_connectSchedule = new_schedule;
+    }
+}
+
+void AudioNode::queryMemory(ContextRenderLock &, MemoryUsage & usage) const
+{
+    for (auto & output : m_outputs)
+        usage.busBytes += output->memoryBytes();
+}
+
+void AudioNode::recordProcessTime(uint64_t microseconds)
+{
+    m_profileTotalMicroseconds.fetch_add(microseconds, std::memory_order_relaxed);
+    m_profileQuanta.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t prevMax = m_profileMaxMicroseconds.load(std::memory_order_relaxed);
+    while (microseconds > prevMax && !m_profileMaxMicroseconds.compare_exchange_weak(prevMax, microseconds, std::memory_order_relaxed))
+    {
     }
 }
 
+void AudioNode::resetProfile()
+{
+    m_profileTotalMicroseconds.store(0, std::memory_order_relaxed);
+    m_profileMaxMicroseconds.store(0, std::memory_order_relaxed);
+    m_profileQuanta.store(0, std::memory_order_relaxed);
+    m_profileAllocations.store(0, std::memory_order_relaxed);
+    m_profileAllocationBytes.store(0, std::memory_order_relaxed);
+}
+
+bool AudioNode::processedThisQuantum(ContextRenderLock & r) const
+{
+    auto ac = r.context();
+    return ac && m_lastProcessingTime == ac->currentTime();
+}
+
 void AudioNode::checkNumberOfChannelsForInput(ContextRenderLock& r, AudioNodeInput* input)
 {
     ASSERT(r.context());
@@ -209,10 +356,20 @@ void AudioNode::pullInputs(ContextRenderLock& r, size_t framesToProcess)
 {
     ASSERT(r.context());
 
+    // An in-place node with one input and one output suggests its output bus
+    // as the upstream render target. Note that if this node is itself the
+    // in-place target of a downstream consumer, output(0)->bus(r) is already
+    // that consumer's bus, so the aliasing composes through linear chains.
+    // A bypassed node's passthrough is a trivially in-place identity, so it
+    // makes the same suggestion; if the source takes it, bypass costs nothing.
+    AudioBus * inPlaceBus = nullptr;
+    if (m_inputs.size() == 1 && m_outputs.size() == 1 && (canProcessInPlace() || m_bypassedThisQuantum))
+        inPlaceBus = output(0)->bus(r);
+
     // Process all of the AudioNodes connected to our inputs.
     for (auto & in : m_inputs)
     {
-        in->pull(r, 0, framesToProcess);
+        in->pull(r, inPlaceBus, framesToProcess);
     }
 }
 
@@ -228,10 +385,24 @@ bool AudioNode::inputsAreSilent(ContextRenderLock& r)
     return true;
 }
 
+bool AudioNode::outputsAreSilent(ContextRenderLock& r)
+{
+    for (auto & out : m_outputs)
+    {
+        if (!out->bus(r)->isSilent())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 void AudioNode::silenceOutputs(ContextRenderLock& r)
 {
     for (auto out : m_outputs)
     {
+        // A stale channel alias must not be zeroed; that memory belongs to the source node.
+        out->clearAliasBus();
         out->bus(r)->zero();
     }
 }
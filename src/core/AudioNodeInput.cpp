@@ -3,6 +3,7 @@
 // Copyright (C) 2015+, The LabSound Authors. All rights reserved.
 
 #include "LabSound/core/AudioNodeInput.h"
+#include "LabSound/core/AudioBusPool.h"
 #include "LabSound/core/AudioContext.h"
 #include "LabSound/core/AudioNode.h"
 #include "LabSound/core/AudioNodeOutput.h"
@@ -12,6 +13,7 @@
 #include "LabSound/extended/AudioContextLock.h"
 
 #include "internal/Assertions.h"
+#include "internal/VectorMath.h"
 
 #include <algorithm>
 #include <mutex>
@@ -21,11 +23,20 @@ using namespace std;
 namespace lab
 {
 
+namespace
+{
+    // largest group of matching connections accumulated in one vaddm pass
+    const size_t kMaxSummingBatch = 32;
+}
+
 AudioNodeInput::AudioNodeInput(AudioNode* node, size_t processingSizeInFrames) 
 : AudioSummingJunction(), m_node(node)
 {
     // Set to mono by default.
     m_internalSummingBus = std::unique_ptr<AudioBus>(new AudioBus(Channels::Mono, processingSizeInFrames));
+    for (size_t sourceChannels = 1; sourceChannels <= AudioBus::ChannelMixMatrix::MaxMixChannels; ++sourceChannels)
+        m_sumFunctions[sourceChannels] = AudioBus::selectSumFunction(sourceChannels, Channels::Mono);
+    m_sumFunctions[0] = nullptr;
 }
 
 AudioNodeInput::~AudioNodeInput()
@@ -43,6 +54,7 @@ void AudioNodeInput::connect(ContextGraphLock& g, std::shared_ptr<AudioNodeInput
 
     toOutput->addInput(g, junction);
     junction->junctionConnectOutput(toOutput);
+    enqueueDirty(junction);
 }
 
 void AudioNodeInput::disconnect(ContextGraphLock& g, std::shared_ptr<AudioNodeInput> junction, std::shared_ptr<AudioNodeOutput> toOutput)
@@ -55,6 +67,7 @@ void AudioNodeInput::disconnect(ContextGraphLock& g, std::shared_ptr<AudioNodeIn
     {
         junction->junctionDisconnectOutput(toOutput);
         toOutput->removeInput(g, junction);
+        enqueueDirty(junction);
     }
 }
 
@@ -70,7 +83,17 @@ void AudioNodeInput::updateInternalBus(ContextRenderLock& r)
     if (numberOfInputChannels == m_internalSummingBus->numberOfChannels())
         return;
 
-    m_internalSummingBus = std::unique_ptr<AudioBus>(new AudioBus(numberOfInputChannels, AudioNode::ProcessingSizeInFrames));
+    // recycle through the context's pool so channel-count changes during
+    // rendering don't hit the system allocator
+    AudioBusPool & pool = r.context()->renderBusPool();
+    pool.release(std::move(m_internalSummingBus));
+    m_internalSummingBus = pool.acquire(numberOfInputChannels);
+
+    // channel counts just settled; resolve the specialized summing kernels
+    // (and any speaker mix matrices behind them) once here rather than
+    // dispatching inside the render loop
+    for (size_t sourceChannels = 1; sourceChannels <= AudioBus::ChannelMixMatrix::MaxMixChannels; ++sourceChannels)
+        m_sumFunctions[sourceChannels] = AudioBus::selectSumFunction(sourceChannels, numberOfInputChannels);
 }
 
 size_t AudioNodeInput::numberOfChannels(ContextRenderLock& r) const
@@ -111,7 +134,7 @@ AudioBus* AudioNodeInput::bus(ContextRenderLock& r)
     // @tofix - did I miss part of the merge?
     if (numberOfRenderingConnections(r) == 1) // && node()->channelCountMode() == ChannelCountMode::Max)
     {
-        std::shared_ptr<AudioNodeOutput> output = renderingOutput(r, 0);
+        AudioNodeOutput * output = renderingOutput(r, 0);
         if (output) {
           return output->bus(r);
         }
@@ -122,6 +145,47 @@ AudioBus* AudioNodeInput::bus(ContextRenderLock& r)
 }
 
 
+AudioNodeOutput * AudioNodeInput::resolveFoldedGain(ContextRenderLock & r, AudioNodeOutput * output, float * foldedGain)
+{
+    // Bounded so a degenerate all-gain feedback cycle cannot spin here;
+    // real chains are a handful of stages deep at most.
+    for (int depth = 0; depth < 8; ++depth)
+    {
+        AudioNode * n = output ? output->node() : nullptr;
+        if (!n)
+            return output;
+
+        // Fold only when this junction is the node's sole consumer; another
+        // input or a param connection still needs the node's own output.
+        output->updateRenderingState(r);
+        if (output->renderingFanOutCount() != 1 || output->renderingParamFanOutCount() != 0)
+            return output;
+
+        // A bypassed pass-through node folds away as a unity gain: the walk
+        // continues from its source and the node never executes at all.
+        float g = 1.f;
+        bool skip = n->bypassed()
+            && n->numberOfInputs() == 1 && n->numberOfOutputs() == 1
+            && n->input(0)->numberOfRenderingConnections(r) == 1;
+        if (!skip && !n->foldableGain(r, &g))
+            return output;
+
+        // The fold lands in the summing bus; a channel mismatch there would
+        // silently skip the junction's up/down-mix.
+        if (output->numberOfChannels() != m_internalSummingBus->numberOfChannels())
+            return output;
+
+        AudioNodeOutput * source = n->input(0)->renderingOutput(r, 0);
+        if (!source)
+            return output;
+
+        *foldedGain *= g;
+        output = source;
+    }
+
+    return output;
+}
+
 AudioBus* AudioNodeInput::pull(ContextRenderLock& r, AudioBus* inPlaceBus, size_t framesToProcess)
 {
     updateRenderingState(r);
@@ -135,7 +199,30 @@ AudioBus* AudioNodeInput::pull(ContextRenderLock& r, AudioBus* inPlaceBus, size_
         auto output = renderingOutput(r, 0);
         if (output)
         {
-             return output->pull(r, inPlaceBus, framesToProcess);
+            float foldedGain = 1.f;
+            AudioNodeOutput * source = resolveFoldedGain(r, output, &foldedGain);
+            if (source == output)
+                return output->pull(r, inPlaceBus, framesToProcess);
+
+            // One or more gain stages folded away. A settled unity gain (or
+            // silence) passes the source bus straight through untouched;
+            // otherwise the scale is one fused pass into the summing bus.
+            // Either way the rendered bus is published as an alias on the
+            // connected output, so bus() reflects what was rendered.
+            AudioBus * sourceBus = source->pull(r, foldedGain == 1.f ? inPlaceBus : nullptr, framesToProcess);
+
+            if (foldedGain == 1.f || sourceBus->isSilent())
+            {
+                output->setAliasBus(sourceBus);
+                return sourceBus;
+            }
+
+            size_t channels = m_internalSummingBus->numberOfChannels();
+            for (size_t ch = 0; ch < channels; ++ch)
+                VectorMath::vsmul(sourceBus->channel(ch)->data(), 1, &foldedGain, m_internalSummingBus->channel(ch)->mutableData(), 1, framesToProcess);
+
+            output->setAliasBus(m_internalSummingBus.get());
+            return m_internalSummingBus.get();
         }
 
         c = 0; // if there's a single input, but it has no output; treat this input as silent.
@@ -152,18 +239,69 @@ AudioBus* AudioNodeInput::pull(ContextRenderLock& r, AudioBus* inPlaceBus, size_
     // multiple connections
     m_internalSummingBus->zero();
 
+    // Connections whose bus exactly matches the summing bus topology are batched and
+    // accumulated in a single pass per group via VectorMath::vaddm, so high fan-in
+    // mixes don't walk the destination buffer once per connection. Everything else
+    // (up/down-mixing, silent busses) goes through sumFrom as before.
+    AudioBus * batch[kMaxSummingBatch];
+    size_t batched = 0;
+
     for (int i = 0; i < c; ++i)
     {
         auto output = renderingOutput(r, i);
         if (output)
         {
-            // Render audio from this output.
-            AudioBus* connectionBus = output->pull(r, 0, framesToProcess);
+            float foldedGain = 1.f;
+            AudioNodeOutput * source = resolveFoldedGain(r, output, &foldedGain);
+
+            // Render audio from this output (or, when gain stages folded
+            // away, from the head of the chain; the folded output's own bus
+            // is never read, since this junction is its sole consumer).
+            AudioBus* connectionBus = source->pull(r, 0, framesToProcess);
+
+            if (connectionBus->isSilent())
+                continue;
+
+            if (foldedGain != 1.f)
+            {
+                // The folded scale fuses into the accumulation itself.
+                size_t channels = m_internalSummingBus->numberOfChannels();
+                for (size_t ch = 0; ch < channels; ++ch)
+                    VectorMath::vsma(connectionBus->channel(ch)->data(), 1, &foldedGain, m_internalSummingBus->channel(ch)->mutableData(), 1, framesToProcess);
+                m_internalSummingBus->clearSilentFlag();
+                continue;
+            }
+
+            if (m_internalSummingBus->topologyMatches(*connectionBus) && batched < kMaxSummingBatch)
+            {
+                batch[batched++] = connectionBus;
+                continue;
+            }
+
+            // Sum, with unity-gain, through the kernel selected when the
+            // channel counts settled.
+            size_t sourceChannels = connectionBus->numberOfChannels();
+            if (sourceChannels >= 1 && sourceChannels <= AudioBus::ChannelMixMatrix::MaxMixChannels)
+                m_sumFunctions[sourceChannels](*m_internalSummingBus, *connectionBus);
+            else
+                m_internalSummingBus->sumFrom(*connectionBus);
+        }
+    }
+
+    if (batched)
+    {
+        const float * sources[kMaxSummingBatch];
+        size_t channels = m_internalSummingBus->numberOfChannels();
+        for (size_t ch = 0; ch < channels; ++ch)
+        {
+            for (size_t i = 0; i < batched; ++i)
+                sources[i] = batch[i]->channel(ch)->data();
 
-            // Sum, with unity-gain.
-            m_internalSummingBus->sumFrom(*connectionBus);
+            VectorMath::vaddm(sources, batched, m_internalSummingBus->channel(ch)->mutableData(), framesToProcess);
         }
+        m_internalSummingBus->clearSilentFlag();
     }
+
     return m_internalSummingBus.get();
 }
 
@@ -3,6 +3,7 @@
 // Copyright (C) 2015+, The LabSound Authors. All rights reserved.
 
 #include "LabSound/core/AudioNodeOutput.h"
+#include "LabSound/core/AudioBusPool.h"
 #include "LabSound/core/AudioContext.h"
 #include "LabSound/core/AudioNodeInput.h"
 #include "LabSound/core/AudioParam.h"
@@ -29,12 +30,13 @@ AudioNodeOutput::AudioNodeOutput(AudioNode* node, size_t numberOfChannels, size_
     , m_numberOfChannels(numberOfChannels)
     , m_desiredNumberOfChannels(numberOfChannels)
     , m_inPlaceBus(0)
+    , m_aliasBus(0)
     , m_renderingFanOutCount(0)
     , m_renderingParamFanOutCount(0)
 {
     ASSERT(numberOfChannels <= AudioContext::maxNumberOfChannels);
     
-    m_internalBus.reset(new AudioBus(numberOfChannels, processingSizeInFrames));
+    m_internalBus.reset(new AudioBus(numberOfChannels, processingSizeInFrames, true, true));
 }
 
 AudioNodeOutput::~AudioNodeOutput()
@@ -51,7 +53,10 @@ void AudioNodeOutput::setNumberOfChannels(ContextRenderLock& r, size_t numberOfC
         return;
     
     m_desiredNumberOfChannels = numberOfChannels;
-    m_internalBus.reset(new AudioBus(numberOfChannels, AudioNode::ProcessingSizeInFrames));
+
+    AudioBusPool & pool = r.context()->renderBusPool();
+    pool.release(std::move(m_internalBus));
+    m_internalBus = pool.acquire(numberOfChannels);
 }
 
 void AudioNodeOutput::updateInternalBus()
@@ -59,7 +64,7 @@ void AudioNodeOutput::updateInternalBus()
     if (numberOfChannels() == m_internalBus->numberOfChannels())
         return;
 
-    m_internalBus.reset(new AudioBus(numberOfChannels(), AudioNode::ProcessingSizeInFrames));
+    m_internalBus.reset(new AudioBus(numberOfChannels(), AudioNode::ProcessingSizeInFrames, true, true));
 }
 
 void AudioNodeOutput::updateRenderingState(ContextRenderLock& r)
@@ -102,16 +107,29 @@ AudioBus * AudioNodeOutput::pull(ContextRenderLock& r, AudioBus* inPlaceBus, siz
     // cause our node to process() only the first time, caching the output in m_internalOutputBus for subsequent calls.    
 
     updateRenderingState(r);
-    
-    bool useInPlaceBus = inPlaceBus && inPlaceBus->numberOfChannels() == numberOfChannels() && (m_renderingFanOutCount + m_renderingParamFanOutCount) == 1;
-    
-    // Setup the actual destination bus for processing when our node's process() method gets called in processIfNecessary() below.
-    m_inPlaceBus = useInPlaceBus ? inPlaceBus : 0;
-    
+
     auto n = node();
     if (!n)
         return bus(r);
 
+    // If the node was already processed this quantum (directly, via the flattened
+    // render order or the parallel scheduler), the result is in the current bus;
+    // adopting an in-place bus now would return a bus that was never written.
+    bool alreadyProcessed = n->processedThisQuantum(r);
+
+    bool useInPlaceBus = !alreadyProcessed && inPlaceBus && inPlaceBus->numberOfChannels() == numberOfChannels() && (m_renderingFanOutCount + m_renderingParamFanOutCount) == 1;
+
+    // Setup the actual destination bus for processing when our node's process() method gets called in processIfNecessary() below.
+    if (!alreadyProcessed)
+    {
+        m_inPlaceBus = useInPlaceBus ? inPlaceBus : 0;
+
+        // A junction that folded this output in an earlier quantum may have
+        // left an alias published; the node is about to render into its own
+        // bus. Routing nodes that legitimately alias re-publish in process().
+        m_aliasBus = nullptr;
+    }
+
     n->processIfNecessary(r, framesToProcess);
     return bus(r);
 }
@@ -119,7 +137,24 @@ AudioBus * AudioNodeOutput::pull(ContextRenderLock& r, AudioBus* inPlaceBus, siz
 AudioBus* AudioNodeOutput::bus(ContextRenderLock& r) const
 {
     ASSERT(r.context()); // only legal during rendering because an in place bus might have been supplied to pull
-    return m_inPlaceBus ? m_inPlaceBus : m_internalBus.get();
+    if (m_inPlaceBus)
+        return m_inPlaceBus;
+    return m_aliasBus ? m_aliasBus : m_internalBus.get();
+}
+
+AudioBus * AudioNodeOutput::materializeAliasBus(ContextRenderLock & r)
+{
+    if (m_aliasBus)
+    {
+        m_internalBus->copyFrom(*m_aliasBus);
+        m_aliasBus = nullptr;
+    }
+    return bus(r);
+}
+
+size_t AudioNodeOutput::memoryBytes() const
+{
+    return m_internalBus ? m_internalBus->memoryBytes() : 0;
 }
 
 size_t AudioNodeOutput::fanOutCount()
@@ -156,7 +191,7 @@ void AudioNodeOutput::removeInput(ContextGraphLock& g, std::shared_ptr<AudioNode
     if (!input)
         return;
     
-    for (std::vector<std::shared_ptr<AudioNodeInput>>::iterator i = m_inputs.begin(); i != m_inputs.end(); ++i) 
+    for (auto i = m_inputs.begin(); i != m_inputs.end(); ++i) 
     {
         if (input == *i) 
         {
@@ -184,7 +219,11 @@ void AudioNodeOutput::addParam(ContextGraphLock& g, std::shared_ptr<AudioParam>
     if (!param)
         return;
 
-    m_params.insert(param);
+    for (auto & p : m_params)
+        if (p == param)
+            return;
+
+    m_params.push_back(param);
 }
 
 void AudioNodeOutput::removeParam(ContextGraphLock& g, std::shared_ptr<AudioParam> param)
@@ -192,9 +231,12 @@ void AudioNodeOutput::removeParam(ContextGraphLock& g, std::shared_ptr<AudioPara
     if (!param)
         return;
 
-    auto it = m_params.find(param);
-    if (it != m_params.end())
-        m_params.erase(it);
+    for (auto i = m_params.begin(); i != m_params.end(); ++i)
+        if (*i == param)
+        {
+            m_params.erase(i);
+            break;
+        }
 }
 
 void AudioNodeOutput::disconnectAllParams(ContextGraphLock& g, std::shared_ptr<AudioNodeOutput> self)
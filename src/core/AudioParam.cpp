@@ -155,18 +155,48 @@ void AudioParam::calculateFinalValues(ContextRenderLock& r, float* values, size_
     // point the summing bus at the values array
     m_data->m_internalSummingBus->setChannelMemory(0, values, numberOfValues);
 
+    double controlRateSum = 0;
+    bool hasControlRateConnections = false;
+
     for (size_t i = 0; i < connectionCount; ++i)
     {
         auto output = renderingOutput(r, i);
-        
+
         ASSERT(output);
-        
+
+        if (output->node() && output->node()->isControlRate())
+        {
+            // The driver computes a single sample per quantum; collect it for
+            // boundary upsampling below rather than summing a stale bus.
+            AudioBus* connectionBus = output->pull(r, 0, 1);
+            controlRateSum += connectionBus->channel(0)->data()[0];
+            hasControlRateConnections = true;
+            continue;
+        }
+
         // Render audio from this output.
         AudioBus* connectionBus = output->pull(r, 0, AudioNode::ProcessingSizeInFrames);
 
         // Sum, with unity-gain.
         m_data->m_internalSummingBus->sumFrom(*connectionBus);
     }
+
+    if (hasControlRateConnections)
+    {
+        // Linear upsampling from the value held at the end of the previous
+        // quantum to this quantum's value; for a constant driver this
+        // degenerates to sample-and-hold.
+        if (!m_controlRateHoldValid)
+        {
+            m_controlRateHold = controlRateSum;
+            m_controlRateHoldValid = true;
+        }
+        float v0 = static_cast<float>(m_controlRateHold);
+        float step = static_cast<float>((controlRateSum - m_controlRateHold) / numberOfValues);
+        for (size_t i = 0; i < numberOfValues; ++i)
+            values[i] += v0 + step * (i + 1);
+        m_controlRateHold = controlRateSum;
+    }
 }
 
 void AudioParam::calculateTimelineValues(ContextRenderLock& r, float* values, size_t numberOfValues)
@@ -192,6 +222,7 @@ void AudioParam::connect(ContextGraphLock& g, std::shared_ptr<AudioParam> param,
     
     param->junctionConnectOutput(output);
     output->addParam(g, param);
+    enqueueDirty(param);
 }
 
 void AudioParam::disconnect(ContextGraphLock& g, std::shared_ptr<AudioParam> param, std::shared_ptr<AudioNodeOutput> output)
@@ -203,6 +234,7 @@ void AudioParam::disconnect(ContextGraphLock& g, std::shared_ptr<AudioParam> par
         param->junctionDisconnectOutput(output);
     }
     output->removeParam(g, param);
+    enqueueDirty(param);
 }
 
 void AudioParam::disconnectAll(ContextGraphLock& g, std::shared_ptr<AudioParam> param)
@@ -213,4 +245,5 @@ void AudioParam::disconnectAll(ContextGraphLock& g, std::shared_ptr<AudioParam>
 			j->removeParam(g, param);
 	}
 	param->junctionDisconnectAllOutputs();
+	enqueueDirty(param);
 }
@@ -18,7 +18,8 @@ using namespace std;
 
 namespace lab {
 
-//@tofix - is there any reason this should be per object instead of static?
+// Serializes mutations only. The render thread never takes this lock; it reads
+// the immutable snapshot published by each mutation (see m_renderEvents).
 namespace
 {
     std::mutex m_eventsMutex;
@@ -70,6 +71,33 @@ void AudioParamTimeline::insertEvent(const ParamEvent& event)
         return;
 
     std::lock_guard<std::mutex> lock(m_eventsMutex);
+    insertEventLocked(event);
+}
+
+bool AudioParamTimeline::trySetValueAtTime(float value, float time)
+{
+    if (!isValidNumber(value) || !isValidNumber(time))
+        return true;  // nothing retrying would fix
+
+    std::unique_lock<std::mutex> lock(m_eventsMutex, std::try_to_lock);
+    if (!lock.owns_lock())
+        return false;
+
+    try
+    {
+        insertEventLocked(ParamEvent(ParamEvent::SetValue, value, time, 0, 0, {}));
+    }
+    catch (const std::exception &)
+    {
+        // Overlaps an existing SetValueCurve; dropped, as a throwing insert
+        // would on the main thread, but never propagated out of the render.
+    }
+    return true;
+}
+
+void AudioParamTimeline::insertEventLocked(const ParamEvent& event)
+{
+    pruneExpiredEventsLocked();
 
     unsigned i = 0;
     float insertTime = event.time();
@@ -105,6 +133,7 @@ void AudioParamTimeline::insertEvent(const ParamEvent& event)
         if (m_events[i].time() == insertTime && m_events[i].type() == event.type())
         {
             m_events[i] = event;
+            std::atomic_store(&m_renderEvents, std::make_shared<const std::vector<ParamEvent>>(m_events));
             return;
         }
 
@@ -115,6 +144,33 @@ void AudioParamTimeline::insertEvent(const ParamEvent& event)
     }
 
     m_events.insert(m_events.begin() + i, event);
+    std::atomic_store(&m_renderEvents, std::make_shared<const std::vector<ParamEvent>>(m_events));
+}
+
+// Drops events the render thread can no longer read: its search never lands
+// before the segment containing m_firstLiveTime, so everything before that
+// segment's start is dead weight. A sequencer scheduling thousands of events
+// ahead would otherwise pay for the entire history on every insertion scan
+// and every snapshot copy. Only kicks in once the list has grown past the
+// point where the copies start to matter; the next publication hands the
+// render thread the trimmed snapshot, which re-seeks via binary search.
+void AudioParamTimeline::pruneExpiredEventsLocked()
+{
+    static const size_t PruneThreshold = 64;
+
+    if (m_events.size() <= PruneThreshold)
+        return;
+
+    double liveTime = m_firstLiveTime.load(std::memory_order_relaxed);
+    auto firstKept = std::lower_bound(m_events.begin(), m_events.end(), liveTime,
+                                      [](const ParamEvent& e, double t) { return e.time() < t; });
+
+    // Keep the segment start itself; it defines the value at liveTime.
+    if (firstKept != m_events.begin())
+        --firstKept;
+
+    if (firstKept != m_events.begin())
+        m_events.erase(m_events.begin(), firstKept);
 }
 
 void AudioParamTimeline::cancelScheduledValues(float startTime)
@@ -125,6 +181,7 @@ void AudioParamTimeline::cancelScheduledValues(float startTime)
     for (unsigned i = 0; i < m_events.size(); ++i) {
         if (m_events[i].time() >= startTime) {
             m_events.erase(m_events.begin() + i, m_events.end());
+            std::atomic_store(&m_renderEvents, std::make_shared<const std::vector<ParamEvent>>(m_events));
             break;
         }
     }
@@ -136,8 +193,8 @@ float AudioParamTimeline::valueForContextTime(ContextRenderLock& r, float defaul
     if (!context)
         return defaultValue;
 
-    std::unique_lock<std::mutex> lock(m_eventsMutex, std::try_to_lock);
-    if (!lock.owns_lock() || !m_events.size() || context->currentTime() < m_events[0].time()) {
+    auto events = std::atomic_load(&m_renderEvents);
+    if (!events || !events->size() || context->currentTime() < (*events)[0].time()) {
         hasValue = false;
         return defaultValue;
     }
@@ -178,21 +235,26 @@ float AudioParamTimeline::valuesForTimeRangeImpl(
     if (!values)
         return defaultValue;
 
+    // Grab the current snapshot of the timeline. It is immutable, so no lock is
+    // required here and a concurrent mutation can never be observed half-applied.
+    auto snapshot = std::atomic_load(&m_renderEvents);
+
     // Return default value if there are no events matching the desired time range.
-    std::unique_lock<std::mutex> lock(m_eventsMutex, std::try_to_lock);
-    if (!lock.owns_lock() || !m_events.size() || endTime <= m_events[0].time()) {
+    if (!snapshot || !snapshot->size() || endTime <= (*snapshot)[0].time()) {
         for (unsigned i = 0; i < numberOfValues; ++i)
             values[i] = defaultValue;
         return defaultValue;
     }
 
+    const std::vector<ParamEvent>& events = *snapshot;
+
     // Maintain a running time and index for writing the values buffer.
     double currentTime = startTime;
     unsigned writeIndex = 0;
 
     // If first event is after startTime then fill initial part of values buffer with defaultValue
     // until we reach the first event time.
-    double firstEventTime = m_events[0].time();
+    double firstEventTime = events[0].time();
     if (firstEventTime > startTime) {
         double fillToTime = std::min(endTime, firstEventTime);
         size_t fillToFrame = AudioUtilities::timeToSampleFrame(fillToTime - startTime, sampleRate);
@@ -207,12 +269,40 @@ float AudioParamTimeline::valuesForTimeRangeImpl(
 
     // Go through each event and render the value buffer where the times overlap,
     // stopping when we've rendered all the requested values.
-    // FIXME: could try to optimize by avoiding having to iterate starting from the very first event
-    // and keeping track of a "current" event index.
-    int n = static_cast<int>(m_events.size());
-    for (int i = 0; i < n && writeIndex < numberOfValues; ++i) {
-        ParamEvent& event = m_events[i];
-        ParamEvent* nextEvent = i < n - 1 ? &(m_events[i + 1]) : 0;
+    int n = static_cast<int>(events.size());
+
+    // Events are sorted by time and render time advances monotonically
+    // quantum to quantum, so in steady state the cursor cached from the last
+    // call just nudges forward past any segments completed since - O(1)
+    // however deep the schedule runs. A new snapshot (any mutation
+    // republishes the list) or a backwards seek invalidates the cursor and
+    // falls back to a binary search for the first segment that can overlap
+    // currentTime.
+    int firstEvent;
+    if (snapshot == m_cursorSnapshot && currentTime >= m_cursorTime)
+    {
+        firstEvent = m_cursorEvent;
+        while (firstEvent < n - 1 && events[firstEvent + 1].time() < currentTime)
+            ++firstEvent;
+    }
+    else
+    {
+        auto firstRelevant = std::lower_bound(events.begin() + 1, events.end(), currentTime,
+                                              [](const ParamEvent& e, double t) { return e.time() < t; });
+        firstEvent = static_cast<int>(firstRelevant - events.begin()) - 1;
+    }
+
+    m_cursorSnapshot = snapshot;
+    m_cursorEvent = firstEvent;
+    m_cursorTime = currentTime;
+
+    // Publish the live segment's start so mutations can prune the events
+    // behind it (see pruneExpiredEventsLocked).
+    m_firstLiveTime.store(events[firstEvent].time(), std::memory_order_relaxed);
+
+    for (int i = firstEvent; i < n && writeIndex < numberOfValues; ++i) {
+        const ParamEvent& event = events[i];
+        const ParamEvent* nextEvent = i < n - 1 ? &(events[i + 1]) : 0;
 
         // Wait until we get a more recent event.
         if (nextEvent && nextEvent->time() < currentTime)
@@ -300,8 +390,8 @@ float AudioParamTimeline::valuesForTimeRangeImpl(
 
             case ParamEvent::SetValueCurve:
                 {
-                    std::vector<float> & curve = event.curve();
-                    float * curveData = curve.size() > 0 ? curve.data() : 0;
+                    const std::vector<float> & curve = event.curve();
+                    const float * curveData = curve.size() > 0 ? curve.data() : 0;
                     size_t numberOfCurvePoints = curve.size() > 0 ? curve.size() : 0;
 
                     // Curve events have duration, so don't just use next event time.
@@ -33,11 +33,21 @@ void AudioScheduledSourceNode::updateSchedulingInfo(ContextRenderLock& r,
                                                     size_t & quantumFrameOffset,
                                                     size_t & nonSilentFramesToProcess)
 {
+    quantumFrameOffset = 0;
+    nonSilentFramesToProcess = 0;
+
     if (!outputBus)
         return;
 
+    // A control-rate node renders a single frame that spans a whole render
+    // quantum; its schedule then quantizes to quantum boundaries.
+    uint64_t timeQuantumFrames = quantumFrameSize;
     if (quantumFrameSize != AudioNode::ProcessingSizeInFrames)
-        return;
+    {
+        if (!isControlRate() || quantumFrameSize != 1)
+            return;
+        timeQuantumFrames = AudioNode::ProcessingSizeInFrames;
+    }
 
     AudioContext * context = r.context();
 
@@ -64,7 +74,7 @@ void AudioScheduledSourceNode::updateSchedulingInfo(ContextRenderLock& r,
     // startFrame            : Start frame for this source.
     // endFrame              : End frame for this source.
     uint64_t quantumStartFrame = context->currentSampleFrame();
-    uint64_t quantumEndFrame = quantumStartFrame + quantumFrameSize;
+    uint64_t quantumEndFrame = quantumStartFrame + timeQuantumFrames;
     uint64_t startFrame = AudioUtilities::timeToSampleFrame(m_startTime, sampleRate);
     uint64_t endFrame = m_endTime == UnknownTime ? 0 : AudioUtilities::timeToSampleFrame(m_endTime, sampleRate);
 
@@ -110,10 +120,12 @@ void AudioScheduledSourceNode::updateSchedulingInfo(ContextRenderLock& r,
     // If the end time is somewhere in the middle of this time quantum, then zero out the
     // frames from the end time to the very end of the quantum.
     if (m_endTime != UnknownTime && endFrame >= quantumStartFrame && endFrame < quantumEndFrame) {
-        size_t zeroStartFrame = endFrame - quantumStartFrame;
+        // At control rate the end frame can land past the single rendered
+        // frame; clamp so the node plays through the end of the quantum.
+        size_t zeroStartFrame = static_cast<size_t>(std::min<uint64_t>(endFrame - quantumStartFrame, quantumFrameSize));
         size_t framesToZero = quantumFrameSize - zeroStartFrame;
 
-        bool isSafe = zeroStartFrame < quantumFrameSize && framesToZero <= quantumFrameSize && zeroStartFrame + framesToZero <= quantumFrameSize;
+        bool isSafe = zeroStartFrame <= quantumFrameSize && framesToZero <= quantumFrameSize && zeroStartFrame + framesToZero <= quantumFrameSize;
         ASSERT(isSafe);
 
         if (isSafe) {
@@ -146,6 +158,11 @@ void AudioScheduledSourceNode::start(double when)
     m_playbackState = SCHEDULED_STATE;
 }
 
+double AudioScheduledSourceNode::effectiveStartTime() const
+{
+    return m_pendingStartTime > UnknownTime ? m_pendingStartTime : m_startTime;
+}
+
 void AudioScheduledSourceNode::stop(double when)
 {
     // https://github.com/modulesio/LabSound/pull/17
@@ -170,7 +187,10 @@ void AudioScheduledSourceNode::reset(ContextRenderLock&)
 void AudioScheduledSourceNode::finish(ContextRenderLock& r)
 {
     m_playbackState = FINISHED_STATE;
-    r.context()->enqueueEvent(m_onEnded);
+
+    // Nothing to deliver (and no dispatch thread to wake) if no handler is set.
+    if (m_onEnded && *m_onEnded)
+        r.context()->enqueueEvent(m_onEnded, id(), r.context()->currentTime());
 }
 
 } // namespace lab
@@ -5,6 +5,7 @@
 #include "LabSound/core/AudioSummingJunction.h"
 #include "LabSound/core/AudioNodeOutput.h"
 #include "LabSound/core/AudioContext.h"
+#include "LabSound/core/MpscQueue.h"
 
 #include "LabSound/extended/AudioContextLock.h"
 
@@ -16,13 +17,28 @@
 namespace lab 
 {
     
-lab::concurrent_queue<std::shared_ptr<AudioSummingJunction>> s_dirtySummingJunctions;
+// Dirty junctions are deposited from control threads and drained on the
+// render thread; the bounded lock-free queue keeps the enqueue path off
+// any mutex the render path could contend on.
+lab::mpsc_queue<std::shared_ptr<AudioSummingJunction>> s_dirtySummingJunctions(1024);
 
 namespace
 {
     std::mutex junctionMutex;
 }
 
+void AudioSummingJunction::enqueueDirty(std::shared_ptr<AudioSummingJunction> junction)
+{
+    if (!junction)
+        return;
+
+    junction->m_renderingStateNeedUpdating = true;
+
+    // Drop on a full queue: the flag above still gets the junction updated
+    // lazily from pull().
+    s_dirtySummingJunctions.try_push(junction);
+}
+
 void AudioSummingJunction::handleDirtyAudioSummingJunctions(ContextRenderLock& r)
 {
     ASSERT(r.context());
@@ -53,12 +69,8 @@ bool AudioSummingJunction::isConnected(std::shared_ptr<AudioNodeOutput> o) const
 }
 
 size_t AudioSummingJunction::numberOfRenderingConnections(ContextRenderLock&) const {
-    size_t count = 0;
-    for (auto i : m_renderingOutputs) {
-        if (!i.expired())
-            ++count;
-    }
-    return count;
+    // The snapshot pins its outputs, so every entry is live.
+    return m_renderingOutputs.size();
 }
     
 void AudioSummingJunction::junctionConnectOutput(std::shared_ptr<AudioNodeOutput> o)
@@ -68,7 +80,7 @@ void AudioSummingJunction::junctionConnectOutput(std::shared_ptr<AudioNodeOutput
     
     std::lock_guard<std::mutex> lock(junctionMutex);
 
-    for (std::vector<std::weak_ptr<AudioNodeOutput>>::iterator i = m_connectedOutputs.begin(); i != m_connectedOutputs.end();)
+    for (auto i = m_connectedOutputs.begin(); i != m_connectedOutputs.end();)
         if (i->expired())
             i = m_connectedOutputs.erase(i);
         else
@@ -89,7 +101,7 @@ void AudioSummingJunction::junctionDisconnectOutput(std::shared_ptr<AudioNodeOut
     
     std::lock_guard<std::mutex> lock(junctionMutex);
 
-    for (std::vector<std::weak_ptr<AudioNodeOutput>>::iterator i = m_connectedOutputs.begin(); i != m_connectedOutputs.end(); ++i)
+    for (auto i = m_connectedOutputs.begin(); i != m_connectedOutputs.end(); ++i)
         if (!i->expired() && i->lock() == o) {
             m_connectedOutputs.erase(i);
             m_renderingStateNeedUpdating = true;
@@ -117,15 +129,46 @@ void AudioSummingJunction::updateRenderingState(ContextRenderLock& r)
     if (r.context() && m_renderingStateNeedUpdating)
     {
         std::lock_guard<std::mutex> lock(junctionMutex);
-        
-        // Copy from m_outputs to m_renderingOutputs.
+
+        // Hash the live connection set first; a junction marked dirty whose
+        // connections ended up unchanged (connection storms frequently add
+        // and remove the same edge between quanta) skips the rebuild and the
+        // channel-count propagation that didUpdate() triggers.
+        uint64_t hash = 14695981039346656037ULL;
+        for (auto i = m_connectedOutputs.begin(); i != m_connectedOutputs.end(); ++i)
+        {
+            uint64_t bits = reinterpret_cast<uintptr_t>(i->lock().get());
+            if (!bits)
+                continue;
+            for (int b = 0; b < 8; ++b)
+            {
+                hash ^= (bits >> (b * 8)) & 0xFF;
+                hash *= 1099511628211ULL;
+            }
+        }
+
+        if (hash == m_renderingOutputsHash)
+        {
+            m_renderingStateNeedUpdating = false;
+            return;
+        }
+        m_renderingOutputsHash = hash;
+
+        // Copy from m_outputs to m_renderingOutputs, locking each weak
+        // reference once here at mutation time. The render path then walks
+        // plain pointers into this pinned snapshot every quantum. The
+        // snapshot retains its storage across rebuilds, so a steady-state
+        // rebuild allocates nothing.
         m_renderingOutputs.clear();
-        for (std::vector<std::weak_ptr<AudioNodeOutput>>::iterator i = m_connectedOutputs.begin(); i != m_connectedOutputs.end(); ++i)
-            if (!i->expired())
+        for (auto i = m_connectedOutputs.begin(); i != m_connectedOutputs.end(); ++i)
+        {
+            std::shared_ptr<AudioNodeOutput> output = i->lock();
+            if (output)
             {
-                m_renderingOutputs.push_back(*i);
-                i->lock()->updateRenderingState(r);
+                output->updateRenderingState(r);
+                m_renderingOutputs.push_back(std::move(output));
             }
+        }
 
         didUpdate(r);
         m_renderingStateNeedUpdating = false;
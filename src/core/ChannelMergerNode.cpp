@@ -23,6 +23,10 @@ ChannelMergerNode::ChannelMergerNode(size_t numberOfInputs_)
     initialize(); // initialize only sets a flag, no need to allocate memory according to input count
 }
 
+ChannelMergerNode::~ChannelMergerNode()
+{
+}
+
 void ChannelMergerNode::addInputs(size_t n)
 {
     if (!n || numberOfInputs() == AudioContext::maxNumberOfChannels)
@@ -49,10 +53,18 @@ void ChannelMergerNode::process(ContextRenderLock& r, size_t framesToProcess)
     // Output bus not updated yet, so just output silence. See Note * in checkNumberOfChannelsForInput
     if (m_desiredNumberOfOutputChannels != output->numberOfChannels())
     {
+        output->clearAliasBus();
         output->bus(r)->zero();
         return;
     }
 
+    // When a downstream consumer supplied its own bus for this quantum the
+    // channels must be copied into it; otherwise the merge is pointer wiring
+    // through a bus of views into the inputs' channel data.
+    bool inPlace = output->isRenderingInPlace();
+    if (!inPlace && (!m_viewBus || m_viewBus->numberOfChannels() != output->numberOfChannels()))
+        m_viewBus.reset(new AudioBus(output->numberOfChannels(), AudioNode::ProcessingSizeInFrames, false));
+
     // Merge all the channels from all the inputs into one output.
     uint32_t outputChannelIndex = 0;
     for (uint32_t i = 0; i < numberOfInputs(); ++i)
@@ -67,14 +79,20 @@ void ChannelMergerNode::process(ContextRenderLock& r, size_t framesToProcess)
             for (size_t j = 0; j < numberOfInputChannels; ++j)
             {
                 AudioChannel* inputChannel = input->bus(r)->channel(j);
-                AudioChannel* outputChannel = output->bus(r)->channel(outputChannelIndex);
 
-                outputChannel->copyFrom(inputChannel);
+                if (inPlace)
+                    output->bus(r)->channel(outputChannelIndex)->copyFrom(inputChannel);
+                else
+                    m_viewBus->setChannelMemory(outputChannelIndex, const_cast<float *>(inputChannel->data()), inputChannel->length());
+
                 ++outputChannelIndex;
             }
         }
     }
 
+    if (!inPlace)
+        output->setAliasBus(m_viewBus.get());
+
     ASSERT(outputChannelIndex == output->numberOfChannels());
 }
 
@@ -21,6 +21,10 @@ ChannelSplitterNode::ChannelSplitterNode(size_t numberOfOutputs_)
     initialize();   // currently initialize only sets a flag; no memory is allocated in response to adding outputs
 }
 
+ChannelSplitterNode::~ChannelSplitterNode()
+{
+}
+
 void ChannelSplitterNode::addOutputs(size_t numberOfOutputs_)
 {
     if (!numberOfOutputs_ || numberOfOutputs() == AudioContext::maxNumberOfChannels)
@@ -47,21 +51,38 @@ void ChannelSplitterNode::process(ContextRenderLock& r, size_t framesToProcess)
 
     size_t numberOfSourceChannels = source->numberOfChannels();
 
+    // The view busses own no sample storage; they are re-pointed at the
+    // source's channels below. This allocation happens once per output.
+    while (m_viewBusses.size() < numberOfOutputs())
+        m_viewBusses.emplace_back(new AudioBus(1, AudioNode::ProcessingSizeInFrames, false));
+
     for (uint32_t i = 0; i < numberOfOutputs(); ++i)
     {
-        AudioBus* destination = output(i)->bus(r);
-        ASSERT(destination);
-
         if (i < numberOfSourceChannels)
         {
-            // Split the channel out if it exists in the source.
-            // It would be nice to avoid the copy and simply pass along pointers, but this becomes extremely difficult with fanout and fanin.
-            destination->channel(0)->copyFrom(source->channel(i));
+            if (output(i)->isRenderingInPlace())
+            {
+                // A downstream consumer supplied its own bus for this quantum;
+                // it owns that memory, so the channel must be copied into it.
+                output(i)->bus(r)->channel(0)->copyFrom(source->channel(i));
+            }
+            else
+            {
+                // Publish a view into the source's channel so the split is
+                // pointer wiring instead of a copy. The view never writes
+                // through the pointer; anything that must mutate the published
+                // bus in place (fade ramps, silencing) materializes a copy
+                // through AudioNodeOutput first.
+                AudioBus * view = m_viewBusses[i].get();
+                view->setChannelMemory(0, const_cast<float *>(source->channel(i)->data()), framesToProcess);
+                output(i)->setAliasBus(view);
+            }
         }
         else if (output(i)->renderingFanOutCount() > 0)
         {
             // Only bother zeroing out the destination if it's connected to anything
-            destination->zero();
+            output(i)->clearAliasBus();
+            output(i)->bus(r)->zero();
         }
     }
 }
@@ -12,6 +12,7 @@
 #include "LabSound/extended/AudioContextLock.h"
 
 #include "internal/Assertions.h"
+#include "internal/ConvolutionWorkerPool.h"
 #include "internal/Reverb.h"
 
 using namespace std;
@@ -26,8 +27,14 @@ const size_t MaxFFTSize = 32768;
 
 namespace lab {
 
+ConvolverNode::ImpulsePrepareState::~ImpulsePrepareState()
+{
+}
+
 ConvolverNode::ConvolverNode() : m_swapOnRender(false)
 , m_normalize(std::make_shared<AudioSetting>("normalize"))
+, m_tailThreshold(std::make_shared<AudioSetting>("tailThreshold"))
+, m_prepare(std::make_shared<ImpulsePrepareState>())
 {
     addInput(unique_ptr<AudioNodeInput>(new AudioNodeInput(this)));
     addOutput(unique_ptr<AudioNodeOutput>(new AudioNodeOutput(this, 2)));
@@ -38,6 +45,7 @@ ConvolverNode::ConvolverNode() : m_swapOnRender(false)
     m_channelInterpretation = ChannelInterpretation::Speakers;
 
     m_settings.push_back(m_normalize);
+    m_settings.push_back(m_tailThreshold);
     
     initialize();
 }
@@ -49,6 +57,23 @@ ConvolverNode::~ConvolverNode()
 
 void ConvolverNode::process(ContextRenderLock & r, size_t framesToProcess)
 {
+    m_lastKnownSampleRate.store(r.context()->sampleRate(), std::memory_order_relaxed);
+    m_lastKnownResampleQuality.store(r.context()->resamplerQualityPolicy().assetPreparation, std::memory_order_relaxed);
+
+    // Pick up an asynchronously prepared impulse. try_lock keeps the render
+    // thread from ever blocking against a worker mid-publish; a missed
+    // pickup is simply retried next quantum.
+    if (m_prepare->ready.load(std::memory_order_acquire) && m_prepare->mutex.try_lock())
+    {
+        if (m_prepare->ready.exchange(false))
+        {
+            m_newReverb = std::move(m_prepare->reverb);
+            m_newBus = std::move(m_prepare->bus);
+            m_swapOnRender = true;
+        }
+        m_prepare->mutex.unlock();
+    }
+
     if (m_swapOnRender)
     {
         m_reverb = std::move(m_newReverb);
@@ -67,15 +92,46 @@ void ConvolverNode::process(ContextRenderLock & r, size_t framesToProcess)
 
     // Process using the convolution engine.
     // Note that we can handle the case where nothing is connected to the input, in which case we'll just feed silence into the convolver.
-    // FIXME: If we wanted to get fancy we could try to factor in the 'tail time' and stop processing once the tail dies down if
-    // we keep getting fed silence.
-    m_reverb->process(r, input(0)->bus(r), outputBus, framesToProcess);
+
+    // Tail-time aware fast path: once the input has been silent for longer
+    // than the impulse response, the reverb has fully decayed and a quiescent
+    // convolver is just a frame countdown. zero() sets the silent flag, so
+    // downstream nodes skip these quanta as well.
+    AudioBus * inputBus = input(0)->bus(r);
+    if (inputBus->isSilent())
+    {
+        if (m_tailFramesRemaining <= 0)
+        {
+            outputBus->zero();
+            return;
+        }
+        m_tailFramesRemaining -= static_cast<int64_t>(framesToProcess);
+    }
+    else
+    {
+        m_tailFramesRemaining = static_cast<int64_t>(m_reverb->impulseResponseLength() + m_reverb->latencyFrames());
+    }
+
+    m_reverb->setTailTruncationThreshold(m_tailThreshold->valueFloat());
+    m_reverb->process(r, inputBus, outputBus, framesToProcess);
 }
 
 void ConvolverNode::reset(ContextRenderLock&)
 {
+    // Invalidate any prepare still in flight, and drop one already published
+    // if the worker isn't mid-publish (epoch keeps it from re-appearing).
+    m_prepare->epoch.fetch_add(1);
+    if (m_prepare->mutex.try_lock())
+    {
+        m_prepare->ready.store(false);
+        m_prepare->reverb.reset();
+        m_prepare->bus.reset();
+        m_prepare->mutex.unlock();
+    }
+
     m_newReverb.reset();
     m_swapOnRender = true;
+    m_tailFramesRemaining = 0;
 }
 
 void ConvolverNode::initialize()
@@ -108,11 +164,34 @@ void ConvolverNode::setImpulse(std::shared_ptr<AudioBus> bus)
     ASSERT(isBufferGood);
     if (!isBufferGood) return;
 
-    // Create the reverb with the given impulse response.
-    const bool threaded = false;
-    m_newReverb = std::unique_ptr<Reverb>(new Reverb(bus.get(), AudioNode::ProcessingSizeInFrames, MaxFFTSize, 2, threaded, normalize()));
-    m_newBus = bus;
-    m_swapOnRender = true;
+    // The prepare pipeline - resampling, the normalization scan, and the FFT
+    // of every partition - can take hundreds of milliseconds on a long
+    // response, so it runs on the convolution worker pool. The current
+    // reverb keeps rendering until process() picks up the replacement.
+    std::shared_ptr<ImpulsePrepareState> state = m_prepare;
+    uint64_t epoch = state->epoch.fetch_add(1) + 1;
+    const bool normalizeResponse = normalize();
+    const float contextSampleRate = m_lastKnownSampleRate.load(std::memory_order_relaxed);
+    const ResamplerQuality quality = m_lastKnownResampleQuality.load(std::memory_order_relaxed);
+
+    ConvolutionWorkerPool::shared().enqueueTask([state, bus, epoch, normalizeResponse, contextSampleRate, quality]() {
+
+        std::shared_ptr<AudioBus> response = bus;
+        if (contextSampleRate > 0 && response->sampleRate() > 0 && response->sampleRate() != contextSampleRate)
+            response = AudioBus::createBySampleRateConverting(response.get(), false, contextSampleRate, quality);
+
+        const bool threaded = false;
+        std::unique_ptr<Reverb> reverb(new Reverb(response.get(), AudioNode::ProcessingSizeInFrames, MaxFFTSize, 2, threaded, normalizeResponse));
+
+        // Publish, unless a newer setImpulse has superseded this prepare.
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->epoch.load() == epoch)
+        {
+            state->reverb = std::move(reverb);
+            state->bus = response;
+            state->ready.store(true, std::memory_order_release);
+        }
+    });
 }
 
 std::shared_ptr<AudioBus> ConvolverNode::getImpulse()
@@ -131,6 +210,21 @@ double ConvolverNode::latencyTime(ContextRenderLock & r) const
     return m_reverb ? m_reverb->latencyFrames() / static_cast<double>(r.context()->sampleRate()) : 0;
 }
 
+void ConvolverNode::queryMemory(ContextRenderLock & r, MemoryUsage & usage) const
+{
+    AudioNode::queryMemory(r, usage);
+
+    // Both engines are counted while a pending impulse swap is in flight.
+    if (m_reverb)
+        usage.convolverBytes += m_reverb->memoryBytes();
+    if (m_newReverb)
+        usage.convolverBytes += m_newReverb->memoryBytes();
+    if (m_bus)
+        usage.sampleBytes += m_bus->memoryBytes();
+    if (m_newBus)
+        usage.sampleBytes += m_newBus->memoryBytes();
+}
+
 bool ConvolverNode::normalize() const
 {
     return m_normalize->valueUint32() != 0;
@@ -140,5 +234,14 @@ void ConvolverNode::setNormalize(bool normalize)
     m_normalize->setUint32(normalize ? 1 : 0);
 }
 
+float ConvolverNode::tailTruncationThreshold() const
+{
+    return m_tailThreshold->valueFloat();
+}
+void ConvolverNode::setTailTruncationThreshold(float threshold)
+{
+    m_tailThreshold->setFloat(threshold);
+}
+
 
 } // namespace lab
@@ -9,11 +9,13 @@
 
 #include "internal/Assertions.h"
 #include "internal/AudioDestination.h"
+#include "internal/SharedAudioDestination.h"
 
 namespace lab {
     
-DefaultAudioDestinationNode::DefaultAudioDestinationNode(AudioContext* context, size_t channelCount, const float sampleRate) 
+DefaultAudioDestinationNode::DefaultAudioDestinationNode(AudioContext* context, size_t channelCount, const float sampleRate, bool useSharedDevice)
 : AudioDestinationNode(context, channelCount, sampleRate)
+, m_useSharedDevice(useSharedDevice)
 {
     // Node-specific default mixing rules.
     m_channelCount = channelCount;
@@ -48,7 +50,10 @@ void DefaultAudioDestinationNode::uninitialize()
 void DefaultAudioDestinationNode::createDestination()
 {
     LOG("Designated Samplerate: %f", m_sampleRate);
-    m_destination = std::unique_ptr<AudioDestination>(AudioDestination::MakePlatformAudioDestination(*this, channelCount(), m_sampleRate));
+    if (m_useSharedDevice)
+        m_destination = std::unique_ptr<AudioDestination>(MakeSharedAudioDestination(*this, channelCount(), m_sampleRate));
+    else
+        m_destination = std::unique_ptr<AudioDestination>(AudioDestination::MakePlatformAudioDestination(*this, channelCount(), m_sampleRate));
 }
 
 void DefaultAudioDestinationNode::startRendering()
@@ -57,7 +62,29 @@ void DefaultAudioDestinationNode::startRendering()
     if (isInitialized())
         m_destination->start();
 }
+
+void DefaultAudioDestinationNode::stopRendering()
+{
+    if (isInitialized())
+        m_destination->stop();
+}
     
+double DefaultAudioDestinationNode::deviceStreamTime() const
+{
+    return m_destination ? m_destination->streamTime() : 0;
+}
+
+double DefaultAudioDestinationNode::outputLatency() const
+{
+    return m_destination ? m_destination->outputLatency() : 0;
+}
+
+void DefaultAudioDestinationNode::handleDeviceChange()
+{
+    if (m_destination)
+        m_destination->handleDeviceChange();
+}
+
 unsigned DefaultAudioDestinationNode::maxChannelCount() const
 {
     return AudioDestination::maxChannelCount();
@@ -35,9 +35,26 @@ std::shared_ptr<AudioParam> DelayNode::delayTime()
     return delayProcessor()->delayTime();
 }
 
+void DelayNode::setCrossfadeOnDelayChange(bool enabled)
+{
+    delayProcessor()->setCrossfadeOnDelayChange(enabled);
+}
+
+bool DelayNode::crossfadeOnDelayChange()
+{
+    return delayProcessor()->crossfadeOnDelayChange();
+}
+
 DelayProcessor * DelayNode::delayProcessor()
 {
     return static_cast<DelayProcessor*>(processor());
 }
 
+void DelayNode::queryMemory(ContextRenderLock & r, MemoryUsage & usage) const
+{
+    AudioNode::queryMemory(r, usage);
+    if (const AudioProcessor * p = processor())
+        usage.delayBytes += p->memoryBytes();
+}
+
 } // lab
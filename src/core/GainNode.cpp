@@ -65,6 +65,33 @@ void GainNode::process(ContextRenderLock& r, size_t framesToProcess)
     }
 }
 
+bool GainNode::foldableGain(ContextRenderLock& r, float* foldedGain)
+{
+    if (!isInitialized() || !input(0)->isConnected())
+        return false;
+
+    // Only a plain, settled scale folds: automation needs sample-accurate
+    // values, and a still-converging de-zipper ramp needs the full kernel.
+    if (gain()->hasSampleAccurateValues())
+        return false;
+
+    float g = gain()->value(r);
+    if (g != m_lastGain)
+        return false;
+
+    // Folding bypasses this node's own input junction, so the node must be
+    // a pure pass-through: one source, matching channel count.
+    if (input(0)->numberOfRenderingConnections(r) != 1)
+        return false;
+
+    AudioNodeOutput* source = input(0)->renderingOutput(r, 0);
+    if (!source || source->numberOfChannels() != output(0)->numberOfChannels())
+        return false;
+
+    *foldedGain = g;
+    return true;
+}
+
 void GainNode::reset(ContextRenderLock& r)
 {
     // Snap directly to desired gain.
@@ -8,15 +8,62 @@
 #include "LabSound/extended/AudioContextLock.h"
 #include "LabSound/extended/Logging.h"
 
+#include "LabSound/core/AudioNodeInput.h"
+#include "LabSound/core/AudioNodeOutput.h"
+#include "LabSound/core/AudioScheduledSourceNode.h"
+
 #include "internal/Assertions.h"
+#include "internal/AudioThreads.h"
+#include "internal/DenormalDisabler.h"
+#include "internal/StreamingWavWriter.h"
 
 #include <algorithm>
+#include <chrono>
+#include <limits>
+#include <unordered_map>
 
 using namespace std;
- 
+
 namespace lab {
-    
-const size_t renderQuantumSize = 128;    
+
+const size_t renderQuantumSize = 128;
+
+namespace {
+
+    // Walks the AudioNodeInput topology upstream from node, looking for a cycle.
+    // A node on the current DFS path encountered a second time means feedback
+    // (a DelayNode loop for example), in which case branches are not independent
+    // and must be rendered on a single thread.
+    bool hasFeedback(ContextRenderLock & r, AudioNode * node, std::unordered_map<AudioNode *, int> & state)
+    {
+        if (!node)
+            return false;
+
+        int & s = state[node];
+        if (s == 1)
+            return true; // back edge - this node is still on the path
+        if (s == 2)
+            return false;
+
+        s = 1;
+        for (size_t i = 0; i < node->numberOfInputs(); ++i)
+        {
+            auto input = node->input(i);
+            if (!input)
+                continue;
+
+            for (size_t j = 0; j < input->numberOfRenderingConnections(r); ++j)
+            {
+                auto output = input->renderingOutput(r, j);
+                if (output && hasFeedback(r, output->node(), state))
+                    return true;
+            }
+        }
+        s = 2;
+        return false;
+    }
+
+} // namespace
 
 OfflineAudioDestinationNode::OfflineAudioDestinationNode(AudioContext * context, const float sampleRate, const float lengthSeconds, const uint32_t numChannels) 
 : AudioDestinationNode(context, numChannels, sampleRate),
@@ -52,6 +99,19 @@ void OfflineAudioDestinationNode::uninitialize()
     AudioNode::uninitialize();
 }
 
+void OfflineAudioDestinationNode::setRenderQuantumConsumer(std::function<void(const AudioBus &)> consumer)
+{
+    m_quantumConsumer = std::move(consumer);
+}
+
+bool OfflineAudioDestinationNode::renderToWavFile(const std::string & path)
+{
+    if (!m_wavWriter)
+        m_wavWriter.reset(new StreamingWavWriter());
+
+    return m_wavWriter->open(path, static_cast<int>(m_numChannels), static_cast<int>(m_sampleRate));
+}
+
 void OfflineAudioDestinationNode::startRendering()
 {
     if (!m_startedRendering) 
@@ -75,8 +135,78 @@ void OfflineAudioDestinationNode::startRendering()
     }
 }
 
+size_t OfflineAudioDestinationNode::provenSilentFrames(ContextRenderLock & r, size_t maxFrames)
+{
+    // Pulled-but-unconnected nodes (recorders, analysers) do real work even
+    // while the output is silent, so time cannot jump past them.
+    if (m_context->automaticPullNodeCount(r) > 0)
+        return 0;
+
+    const double now = m_context->currentTime();
+
+    double maxTail = 0;
+    double nextStart = std::numeric_limits<double>::infinity();
+
+    for (AudioNodeOutput * output : m_context->renderOrder(r))
+    {
+        if (!output || !output->node())
+            continue;
+
+        AudioNode * n = output->node();
+        if (n == this)
+            continue;
+
+        maxTail = std::max(maxTail, n->tailTime(r) + n->latencyTime(r));
+
+        if (n->isScheduledNode())
+        {
+            AudioScheduledSourceNode * s = static_cast<AudioScheduledSourceNode *>(n);
+            if (s->playbackState() == AudioScheduledSourceNode::PLAYING_STATE)
+                return 0;
+            if (s->playbackState() == AudioScheduledSourceNode::SCHEDULED_STATE)
+            {
+                double start = s->effectiveStartTime();
+                if (start <= now)
+                    return 0;
+                nextStart = std::min(nextStart, start);
+            }
+        }
+        else if (n->numberOfInputs() == 0)
+        {
+            // A source that is not on the shared scheduling timeline (live
+            // input, an unscheduled generator) may sound at any moment.
+            return 0;
+        }
+    }
+
+    // Tails (reverbs, delays, filters) ring past their input; only once the
+    // output has been verifiably silent for longer than the longest tail is
+    // the graph's internal state itself silent.
+    if (silentDuration() <= maxTail)
+        return 0;
+
+    if (nextStart == std::numeric_limits<double>::infinity())
+        return maxFrames;
+
+    // Stop a whole quantum short of the next start so the source's transition
+    // into PLAYING_STATE renders with its proper sub-quantum offset.
+    uint64_t framesToStart = static_cast<uint64_t>((nextStart - now) * m_context->sampleRate());
+    if (framesToStart <= renderQuantumSize)
+        return 0;
+
+    uint64_t skippable = framesToStart - renderQuantumSize;
+    skippable -= skippable % renderQuantumSize;
+    return static_cast<size_t>(std::min<uint64_t>(skippable, maxFrames));
+}
+
 void OfflineAudioDestinationNode::offlineRender()
 {
+    ApplyThreadPolicy(AudioContext::ThreadRole::Render, "offline render");
+
+    // This is its own thread, so the device callback's FTZ/DAZ state does not
+    // apply here; establish it for the whole bake.
+    DenormalDisabler denormalDisabler;
+
     LOG("Starting Offline Rendering");
 
     ASSERT(m_renderBus.get());
@@ -93,15 +223,99 @@ void OfflineAudioDestinationNode::offlineRender()
     if (!isAudioContextInitialized) 
         return;
 
+    // Stateful nodes (delays, filters, convolvers) carry history from one quantum
+    // into the next, so the duration axis itself cannot be sliced across threads.
+    // What can run concurrently are the independent source branches feeding this
+    // node - but only when the graph is feedback-free. Detect that here and pick
+    // the rendering strategy for the whole bake up front.
+    {
+        ContextRenderLock r(m_context, "OfflineAudioDestinationNode::offlineRender");
+        std::unordered_map<AudioNode *, int> state;
+        bool feedback = hasFeedback(r, this, state);
+        // An explicit disable stands - a bake farm running whole jobs per core
+        // has no headroom for per-job subgraph workers.
+        if (feedback)
+        {
+            setParallelRenderingEnabled(false);
+            LOG("Graph has feedback; offline rendering on a single thread");
+        }
+    }
+
     // Break up the render target into smaller "render quantize" sized pieces.
     size_t framesToProcess = static_cast<size_t>((m_lengthSeconds * m_context->sampleRate()) / renderQuantumSize);
 
+    const bool streamingToDisk = m_wavWriter && m_wavWriter->busy();
+    if (streamingToDisk)
+        m_interleaveScratch.resize(renderQuantumSize * m_numChannels);
+
     while (framesToProcess > 0)
     {
+        // Sparse timelines spend most of their quanta rendering silence at
+        // full kernel cost. Once the last quantum came out silent, check
+        // whether the whole span to the next scheduled start is provably
+        // silent and jump the clock across it, emitting zeros in bulk. The
+        // check short-circuits at the first playing source, so it costs
+        // nearly nothing while sound is actually rendering.
+        if (silentDuration() > 0)
+        {
+            size_t skipFrames = 0;
+            {
+                ContextRenderLock r(m_context, "OfflineAudioDestinationNode::fastForward");
+                if (r.context())
+                    skipFrames = provenSilentFrames(r, framesToProcess * renderQuantumSize);
+            }
+
+            if (skipFrames)
+            {
+                skipSilentFrames(skipFrames);
+
+                if (m_quantumConsumer || streamingToDisk)
+                {
+                    m_renderBus->zero();
+                    if (streamingToDisk)
+                        std::fill(m_interleaveScratch.begin(), m_interleaveScratch.end(), 0.f);
+
+                    for (size_t i = 0; i < skipFrames; i += renderQuantumSize)
+                    {
+                        if (m_quantumConsumer)
+                            m_quantumConsumer(*m_renderBus);
+                        if (streamingToDisk)
+                            m_wavWriter->writeInterleavedBlocking(m_interleaveScratch.data(), m_interleaveScratch.size());
+                    }
+                }
+
+                framesToProcess -= skipFrames / renderQuantumSize;
+                continue;
+            }
+        }
+
         render(0, m_renderBus.get(), renderQuantumSize);
+
+        // Completed quanta are handed off here and never accumulated, so a
+        // bake of any length holds one quantum of audio plus the writer's
+        // ring; the disk I/O runs on the writer thread, overlapped with the
+        // rendering of the next quantum.
+        if (m_quantumConsumer)
+            m_quantumConsumer(*m_renderBus);
+
+        if (streamingToDisk)
+        {
+            m_renderBus->interleave(m_interleaveScratch.data(), renderQuantumSize);
+            m_wavWriter->writeInterleavedBlocking(m_interleaveScratch.data(), m_interleaveScratch.size());
+        }
+
         framesToProcess -= 1;
     }
 
+    if (streamingToDisk)
+    {
+        // The completion callback must imply the file is whole, so wait for
+        // the writer to drain the ring and patch the header.
+        m_wavWriter->finish();
+        while (m_wavWriter->busy())
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+
     LOG("Stopping Offline Rendering");
 }
 
@@ -15,9 +15,14 @@
 #include "LabSound/extended/AudioContextLock.h"
 
 #include "internal/AudioUtilities.h"
+#include "internal/FastMath.h"
 #include "internal/VectorMath.h"
 #include "internal/Assertions.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include <algorithm>
 
 using namespace std;
@@ -26,10 +31,70 @@ namespace lab {
 
 using namespace VectorMath;
 
-std::shared_ptr<WaveTable> OscillatorNode::s_waveTableSine = 0;
-std::shared_ptr<WaveTable> OscillatorNode::s_waveTableSquare = 0;
-std::shared_ptr<WaveTable> OscillatorNode::s_waveTableSawtooth = 0;
-std::shared_ptr<WaveTable> OscillatorNode::s_waveTableTriangle = 0;
+namespace {
+
+    // Interpolates a span of oscillator output from an interleaved wavetable
+    // pair. Read indices and fractions are precomputed by process(), so this
+    // loop is branch-free: two table lerps per sample plus the cross-table
+    // lerp. The interleaved layout puts the higher- and lower-partial samples
+    // of index i at 2*i and 2*i+1, so each tap is one adjacent pair and four
+    // samples need just four 64-bit loads per table position.
+    //
+    // tableFactor carries per-sample cross-table interpolation factors for the
+    // sample-accurate automation path; when null, constantTableFactor applies
+    // to the whole span (the constant-frequency fast path).
+    void renderFromInterleavedTable(const float* waveData, const unsigned* readIndex, const float* frac,
+                                    const float* tableFactor, float constantTableFactor,
+                                    unsigned readIndexMask, float* destination, int framesToProcess)
+    {
+        int k = 0;
+#ifdef __SSE2__
+        const __m128 tfConst = _mm_set1_ps(constantTableFactor);
+        for (; k + 4 <= framesToProcess; k += 4)
+        {
+            unsigned i0 = readIndex[k], i1 = readIndex[k + 1], i2 = readIndex[k + 2], i3 = readIndex[k + 3];
+            unsigned j0 = (i0 + 1) & readIndexMask, j1 = (i1 + 1) & readIndexMask;
+            unsigned j2 = (i2 + 1) & readIndexMask, j3 = (i3 + 1) & readIndexMask;
+
+            // (higher, lower) pairs for the first tap of each sample...
+            __m128 a = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(waveData + 2 * i0));
+            a = _mm_loadh_pi(a, reinterpret_cast<const __m64*>(waveData + 2 * i1));
+            __m128 b = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(waveData + 2 * i2));
+            b = _mm_loadh_pi(b, reinterpret_cast<const __m64*>(waveData + 2 * i3));
+            __m128 higher1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 lower1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+            // ...and the second tap.
+            a = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(waveData + 2 * j0));
+            a = _mm_loadh_pi(a, reinterpret_cast<const __m64*>(waveData + 2 * j1));
+            b = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(waveData + 2 * j2));
+            b = _mm_loadh_pi(b, reinterpret_cast<const __m64*>(waveData + 2 * j3));
+            __m128 higher2 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 lower2 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+            __m128 f = _mm_loadu_ps(frac + k);
+            __m128 sampleHigher = _mm_add_ps(higher1, _mm_mul_ps(f, _mm_sub_ps(higher2, higher1)));
+            __m128 sampleLower = _mm_add_ps(lower1, _mm_mul_ps(f, _mm_sub_ps(lower2, lower1)));
+
+            __m128 tf = tableFactor ? _mm_loadu_ps(tableFactor + k) : tfConst;
+            _mm_storeu_ps(destination + k, _mm_add_ps(sampleHigher, _mm_mul_ps(tf, _mm_sub_ps(sampleLower, sampleHigher))));
+        }
+#endif
+        for (; k < framesToProcess; ++k)
+        {
+            unsigned index = readIndex[k];
+            unsigned index2 = (index + 1) & readIndexMask;
+            float f = frac[k];
+
+            float sampleHigher = waveData[2 * index] + f * (waveData[2 * index2] - waveData[2 * index]);
+            float sampleLower = waveData[2 * index + 1] + f * (waveData[2 * index2 + 1] - waveData[2 * index + 1]);
+
+            float tf = tableFactor ? tableFactor[k] : constantTableFactor;
+            destination[k] = sampleHigher + tf * (sampleLower - sampleHigher);
+        }
+    }
+
+}  // anonymous namespace
 
 OscillatorNode::OscillatorNode(const float sampleRate) :
       m_sampleRate(sampleRate),
@@ -82,44 +147,21 @@ void OscillatorNode::setType(OscillatorType type)
 
 void OscillatorNode::_setType(OscillatorType type)
 {
-    std::shared_ptr<WaveTable> waveTable;
-
     switch (type)
     {
         case OscillatorType::SINE:
-            if (!s_waveTableSine)
-            {
-                s_waveTableSine = std::make_shared<WaveTable>(m_sampleRate, OscillatorType::SINE);
-            }
-            waveTable = s_waveTableSine;
-            break;
         case OscillatorType::SQUARE:
-            if (!s_waveTableSquare)
-            {
-                s_waveTableSquare = std::make_shared<WaveTable>(m_sampleRate, OscillatorType::SQUARE);
-            }
-            waveTable = s_waveTableSquare;
-            break;
         case OscillatorType::SAWTOOTH:
-            if (!s_waveTableSawtooth)
-            {
-                s_waveTableSawtooth = std::make_shared<WaveTable>(m_sampleRate, OscillatorType::SAWTOOTH);
-            }
-            waveTable = s_waveTableSawtooth;
-            break;
         case OscillatorType::TRIANGLE:
-            if (!s_waveTableTriangle)
-            {
-                s_waveTableTriangle = std::make_shared<WaveTable>(m_sampleRate, OscillatorType::TRIANGLE);
-            }
-            waveTable = s_waveTableTriangle;
             break;
         case OscillatorType::CUSTOM:
         default:
             throw std::invalid_argument("Cannot set wavtable for custom type");
     }
 
-    setWaveTable(waveTable);
+    // Standard wavetables come from the process-wide bank, keyed by type and
+    // sample rate, so short-lived oscillators never rebuild identical tables.
+    setWaveTable(WaveTable::standardWaveTable(m_sampleRate, type));
 
     // set the value again, with no notification, as setWaveTable forces the type to CUSTOM.
     m_type->setUint32(static_cast<uint32_t>(type), false);
@@ -144,6 +186,11 @@ bool OscillatorNode::calculateSampleAccuratePhaseIncrements(ContextRenderLock &
 
     float finalScale = m_waveTable->rateScale();
 
+    // At control rate each computed sample spans a whole render quantum, so
+    // the phase must advance a quantum's worth per sample.
+    if (isControlRate())
+        finalScale *= AudioNode::ProcessingSizeInFrames;
+
     if (m_frequency->hasSampleAccurateValues()) {
         hasSampleAccurateValues = true;
         hasFrequencyChanges = true;
@@ -168,8 +215,7 @@ bool OscillatorNode::calculateSampleAccuratePhaseIncrements(ContextRenderLock &
         // Convert from cents to rate scalar.
         float k = 1.f / 1200.f;
         vsmul(detuneValues, 1, &k, detuneValues, 1, framesToProcess);
-        for (unsigned i = 0; i < framesToProcess; ++i)
-            detuneValues[i] = powf(2, detuneValues[i]); // FIXME: converting to expf() will be faster.
+        FastMath::fast_exp2(detuneValues, detuneValues, framesToProcess);
 
         if (hasFrequencyChanges) {
             // Multiply frequencies by detune scalings.
@@ -179,7 +225,7 @@ bool OscillatorNode::calculateSampleAccuratePhaseIncrements(ContextRenderLock &
         // Handle ordinary parameter smoothing/de-zippering if there are no scheduled changes.
         m_detune->smooth(r);
         float detune = m_detune->smoothedValue();
-        float detuneScale = powf(2, detune / 1200);
+        float detuneScale = FastMath::fast_exp2f(detune / 1200);
         finalScale *= detuneScale;
     }
 
@@ -193,6 +239,17 @@ bool OscillatorNode::calculateSampleAccuratePhaseIncrements(ContextRenderLock &
 
 void OscillatorNode::process(ContextRenderLock& r, size_t framesToProcess)
 {
+    // Adopt a finished off-thread custom table build (see setPeriodicWave).
+    // Until it lands we keep rendering the previous table.
+    if (auto pending = std::atomic_load(&m_pendingWaveTable))
+    {
+        if (auto table = pending->table())
+        {
+            setWaveTable(table);
+            std::atomic_store(&m_pendingWaveTable, std::shared_ptr<WaveTable::CustomBuild>());
+        }
+    }
+
     AudioBus* outputBus = output(0)->bus(r);
 
     if (!isInitialized() || !outputBus->numberOfChannels()) {
@@ -239,63 +296,89 @@ void OscillatorNode::process(ContextRenderLock& r, size_t framesToProcess)
 
     float rateScale = m_waveTable->rateScale();
     float invRateScale = 1 / rateScale;
+    // Sample-accurate increments carry the control-rate stride (see
+    // calculateSampleAccuratePhaseIncrements); compensate when recovering the
+    // frequency used to select the wavetable.
+    if (isControlRate())
+        invRateScale /= AudioNode::ProcessingSizeInFrames;
     bool hasSampleAccurateValues = calculateSampleAccuratePhaseIncrements(r, framesToProcess);
 
     float frequency = 0;
-    float* higherWaveData = 0;
-    float* lowerWaveData = 0;
+    const float* waveData = 0;
     float tableInterpolationFactor;
 
     if (!hasSampleAccurateValues) {
         frequency = m_frequency->smoothedValue();
         float detune = m_detune->smoothedValue();
-        float detuneScale = powf(2, detune / 1200);
+        float detuneScale = FastMath::fast_exp2f(detune / 1200);
         frequency *= detuneScale;
-        m_waveTable->waveDataForFundamentalFrequency(frequency, lowerWaveData, higherWaveData, tableInterpolationFactor);
+        waveData = m_waveTable->interleavedWaveDataForFundamentalFrequency(frequency, tableInterpolationFactor);
     }
 
     float incr = frequency * rateScale;
+    if (isControlRate())
+        incr *= AudioNode::ProcessingSizeInFrames;
     float* phaseIncrements = m_phaseIncrements.data();
 
     unsigned readIndexMask = waveTableSize - 1;
 
     // Start rendering at the correct offset.
     destP += quantumFrameOffset;
-    size_t n = nonSilentFramesToProcess;
+    int n = static_cast<int>(nonSilentFramesToProcess);
 
-    while (n--) {
-        unsigned readIndex = static_cast<unsigned>(virtualReadIndex);
-        unsigned readIndex2 = readIndex + 1;
+    // Phase accumulation runs ahead of interpolation: read indices and
+    // fractions for the whole span are prefix-summed into flat arrays first,
+    // then renderFromInterleavedTable() does the table reads and lerps four
+    // samples at a time. Phase still accumulates in double precision with the
+    // same per-sample wrap as before.
+    unsigned runIndex[AudioNode::ProcessingSizeInFrames];
+    float runFrac[AudioNode::ProcessingSizeInFrames];
 
-        // Contain within valid range.
-        readIndex = readIndex & readIndexMask;
-        readIndex2 = readIndex2 & readIndexMask;
-
-        if (hasSampleAccurateValues) {
-            incr = *phaseIncrements++;
-
-            frequency = invRateScale * incr;
-            m_waveTable->waveDataForFundamentalFrequency(frequency, lowerWaveData, higherWaveData, tableInterpolationFactor);
+    if (!hasSampleAccurateValues) {
+        // Constant-frequency fast path: the table pair and cross-table factor
+        // were selected once above and hold for the whole span.
+        for (int k = 0; k < n; ++k) {
+            unsigned readIndex = static_cast<unsigned>(virtualReadIndex);
+            runIndex[k] = readIndex & readIndexMask;
+            runFrac[k] = static_cast<float>(virtualReadIndex) - readIndex;
+
+            virtualReadIndex += incr;
+            virtualReadIndex -= floor(virtualReadIndex * invWaveTableSize) * waveTableSize;
         }
 
-        float sample1Lower = lowerWaveData[readIndex];
-        float sample2Lower = lowerWaveData[readIndex2];
-        float sample1Higher = higherWaveData[readIndex];
-        float sample2Higher = higherWaveData[readIndex2];
-
-        // Linearly interpolate within each table (lower and higher).
-        float interpolationFactor = static_cast<float>(virtualReadIndex) - readIndex;
-        float sampleHigher = (1 - interpolationFactor) * sample1Higher + interpolationFactor * sample2Higher;
-        float sampleLower = (1 - interpolationFactor) * sample1Lower + interpolationFactor * sample2Lower;
+        renderFromInterleavedTable(waveData, runIndex, runFrac, nullptr, tableInterpolationFactor, readIndexMask, destP, n);
+    } else {
+        // Sample-accurate automation: the frequency can move between table
+        // pairs inside the quantum, so record the per-sample selection, then
+        // render in runs that share one table pair with per-sample cross-table
+        // factors. FM-style automation usually stays inside one pair, so the
+        // common case is a single run.
+        float runTableFactor[AudioNode::ProcessingSizeInFrames];
+        const float* runTable[AudioNode::ProcessingSizeInFrames];
+
+        for (int k = 0; k < n; ++k) {
+            unsigned readIndex = static_cast<unsigned>(virtualReadIndex);
+            runIndex[k] = readIndex & readIndexMask;
+            runFrac[k] = static_cast<float>(virtualReadIndex) - readIndex;
+
+            incr = phaseIncrements[k];
+            frequency = invRateScale * incr;
+            runTable[k] = m_waveTable->interleavedWaveDataForFundamentalFrequency(frequency, runTableFactor[k]);
 
-        // Then interpolate between the two tables.
-        float sample = (1 - tableInterpolationFactor) * sampleHigher + tableInterpolationFactor * sampleLower;
+            virtualReadIndex += incr;
+            virtualReadIndex -= floor(virtualReadIndex * invWaveTableSize) * waveTableSize;
+        }
 
-        *destP++ = sample;
+        int runStart = 0;
+        while (runStart < n) {
+            int runEnd = runStart + 1;
+            while (runEnd < n && runTable[runEnd] == runTable[runStart])
+                ++runEnd;
 
-        // Increment virtual read index and wrap virtualReadIndex into the range 0 -> waveTableSize.
-        virtualReadIndex += incr;
-        virtualReadIndex -= floor(virtualReadIndex * invWaveTableSize) * waveTableSize;
+            renderFromInterleavedTable(runTable[runStart], runIndex + runStart, runFrac + runStart,
+                                       runTableFactor + runStart, 0, readIndexMask, destP + runStart, runEnd - runStart);
+            runStart = runEnd;
+        }
     }
 
     m_virtualReadIndex = virtualReadIndex;
@@ -308,6 +391,18 @@ void OscillatorNode::reset(ContextRenderLock&)
     m_virtualReadIndex = 0;
 }
 
+void OscillatorNode::setPeriodicWave(const std::vector<float> & real, const std::vector<float> & imag)
+{
+    auto build = WaveTable::customWaveTable(m_sampleRate, real, imag);
+    if (!build)
+        return;
+
+    // Hand the build (possibly already finished, if the spectrum was cached)
+    // to the render thread; a newer request simply replaces an unfinished
+    // older one.
+    std::atomic_store(&m_pendingWaveTable, build);
+}
+
 void OscillatorNode::setWaveTable(std::shared_ptr<WaveTable> waveTable)
 {
     m_waveTable = waveTable;
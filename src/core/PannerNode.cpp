@@ -19,6 +19,7 @@
 #include "internal/Cone.h"
 #include "internal/Distance.h"
 #include "internal/EqualPowerPanner.h"
+#include "internal/AudioUtilities.h"
 #include "internal/Assertions.h"
 
 using namespace std;
@@ -31,6 +32,18 @@ static void fixNANs(T& x)
     if (std::isnan(T(x)) || std::isinf(x)) x = T(0);
 }
 
+namespace
+{
+    // movement below this threshold reuses the cached azimuth/elevation and
+    // distance/cone gains; well under any audible change in panning
+    const float SpatialEpsilon = 1.e-4f;
+
+    bool movedBeyond(const FloatPoint3D & a, const FloatPoint3D & b, float epsilon)
+    {
+        return fabsf(a.x - b.x) > epsilon || fabsf(a.y - b.y) > epsilon || fabsf(a.z - b.z) > epsilon;
+    }
+}
+
 PannerNode::PannerNode(const float sampleRate, const std::string & searchPath)
 : AudioNode()
 , m_orientationX(std::make_shared<AudioParam>("orientationX", 0.f, -1.f, 1.f))
@@ -49,6 +62,7 @@ PannerNode::PannerNode(const float sampleRate, const std::string & searchPath)
 , m_coneInnerAngle(std::make_shared<AudioSetting>("coneInnerAngle"))
 , m_coneOuterAngle(std::make_shared<AudioSetting>("coneOuterAngle"))
 , m_panningModel(std::make_shared<AudioSetting>("panningMode"))
+, m_fastSpatialMath(std::make_shared<AudioSetting>("fastSpatialMath"))
 , m_sampleRate(sampleRate)
 {
     if (searchPath.length())
@@ -84,6 +98,7 @@ PannerNode::PannerNode(const float sampleRate, const std::string & searchPath)
                 case DistanceEffect::ModelInverse:
                 case DistanceEffect::ModelExponential:
                     m_distanceEffect->setModel(model, true);
+                    m_spatialCacheValid = false;
                     break;
 
                 default:
@@ -97,6 +112,7 @@ PannerNode::PannerNode(const float sampleRate, const std::string & searchPath)
     m_refDistance->setValueChanged(
         [this]() {
             m_distanceEffect->setRefDistance(m_refDistance->valueFloat());
+            m_spatialCacheValid = false;
         }
     );
     m_settings.push_back(m_refDistance);
@@ -104,6 +120,7 @@ PannerNode::PannerNode(const float sampleRate, const std::string & searchPath)
     m_maxDistance->setValueChanged(
         [this]() {
             m_distanceEffect->setMaxDistance(m_maxDistance->valueFloat());
+            m_spatialCacheValid = false;
         }
     );
     m_settings.push_back(m_maxDistance);
@@ -111,6 +128,7 @@ PannerNode::PannerNode(const float sampleRate, const std::string & searchPath)
     m_rolloffFactor->setValueChanged(
         [this]() {
             m_distanceEffect->setRolloffFactor(m_maxDistance->valueFloat());
+            m_spatialCacheValid = false;
         }
     );
     m_settings.push_back(m_rolloffFactor);
@@ -118,6 +136,7 @@ PannerNode::PannerNode(const float sampleRate, const std::string & searchPath)
     m_coneInnerAngle->setValueChanged(
         [this]() {
             m_coneEffect->setInnerAngle(m_coneInnerAngle->valueFloat());
+            m_spatialCacheValid = false;
         }
     );
     m_settings.push_back(m_coneInnerAngle);
@@ -125,6 +144,7 @@ PannerNode::PannerNode(const float sampleRate, const std::string & searchPath)
     m_coneOuterAngle->setValueChanged(
         [this]() {
             m_coneEffect->setOuterAngle(m_coneOuterAngle->valueFloat());
+            m_spatialCacheValid = false;
         }
     );
     m_settings.push_back(m_coneOuterAngle);
@@ -136,6 +156,14 @@ PannerNode::PannerNode(const float sampleRate, const std::string & searchPath)
         }
     );
 
+    m_fastSpatialMath->setValueChanged(
+        [this]() {
+            // recompute the cached angles with the newly selected math
+            m_spatialCacheValid = false;
+        }
+    );
+    m_settings.push_back(m_fastSpatialMath);
+
     // Node-specific default mixing rules.
     m_channelCount = 2;
     m_channelCountMode = ChannelCountMode::ClampedMax;
@@ -229,6 +257,15 @@ void PannerNode::process(ContextRenderLock & r, size_t framesToProcess)
         return;
     }
 
+    // Scheduled wake-up: while culled, the position recheck runs only every
+    // m_cullWakeInterval quanta; the quanta in between cost nothing at all.
+    if (m_cullSleepRemaining > 0)
+    {
+        --m_cullSleepRemaining;
+        destination->zero();
+        return;
+    }
+
     // HRTFDatabase should be loaded before proceeding for offline audio context
     if (static_cast<PanningMode>(m_panningModel->valueUint32()) == PanningMode::HRTF && !m_hrtfDatabaseLoader->isLoaded())
     {
@@ -243,15 +280,101 @@ void PannerNode::process(ContextRenderLock & r, size_t framesToProcess)
         }
     }
 
-    // Apply the panning effect.
-    double azimuth;
-    double elevation;
-    getAzimuthElevation(r, &azimuth, &elevation);
+    AudioListener & listener = r.context()->listener();
+
+    // One coherent pose shared by every read below (and by every other
+    // panner this quantum); see AudioListener::snapshot.
+    const AudioListener::Snapshot & listenerState = listener.snapshot(r);
+
+    FloatPoint3D listenerPosition = listenerState.position;
+    FloatPoint3D position = {
+                                        positionX()->value(r),
+                                        positionY()->value(r),
+                                        positionZ()->value(r) };
+
+    // The squared listener distance drives every LOD decision below.
+    FloatPoint3D offset = position - listenerPosition;
+    float distanceSquared = dot(offset, offset);
+
+    // Cull far-away sources before any panning math runs.
+    if (m_cullDistance > 0.f && distanceSquared > m_cullDistance * m_cullDistance)
+    {
+        destination->zero();
+        m_lastGain = 0.f;
+        if (m_cullWakeInterval > 1)
+            m_cullSleepRemaining = m_cullWakeInterval - 1;
+        return;
+    }
+
+    FloatPoint3D orientation = {
+                                        orientationX()->value(r),
+                                        orientationY()->value(r),
+                                        orientationZ()->value(r) };
+    FloatPoint3D listenerFront = listenerState.forward;
+    FloatPoint3D listenerUp = listenerState.up;
+
+    bool dirty = !m_spatialCacheValid
+        || movedBeyond(position, m_cachedPosition, SpatialEpsilon)
+        || movedBeyond(orientation, m_cachedOrientation, SpatialEpsilon)
+        || movedBeyond(listenerPosition, m_cachedListenerPosition, SpatialEpsilon)
+        || movedBeyond(listenerFront, m_cachedListenerFront, SpatialEpsilon)
+        || movedBeyond(listenerUp, m_cachedListenerUp, SpatialEpsilon);
+
+    // Control-rate band: a distant moving source refreshes its spatial math
+    // only every m_controlRateInterval quanta; the stale cache is inaudible
+    // at that distance.
+    if (dirty && m_spatialCacheValid && m_controlRateLodDistance > 0.f
+        && distanceSquared > m_controlRateLodDistance * m_controlRateLodDistance
+        && m_controlRateCountdown > 0)
+    {
+        --m_controlRateCountdown;
+        dirty = false;
+    }
+    else if (dirty)
+    {
+        m_controlRateCountdown = m_controlRateInterval > 1 ? m_controlRateInterval - 1 : 0;
+    }
+
+    if (dirty)
+    {
+        getAzimuthElevation(r, &m_cachedAzimuth, &m_cachedElevation);
+        m_cachedTotalGain = distanceConeGain(r);
+
+        m_cachedPosition = position;
+        m_cachedOrientation = orientation;
+        m_cachedListenerPosition = listenerPosition;
+        m_cachedListenerFront = listenerFront;
+        m_cachedListenerUp = listenerUp;
+        m_spatialCacheValid = true;
+    }
+
+    // HRTF LOD band: beyond the threshold an HRTF source renders through the
+    // equal-power fallback panner; the HRTF panner keeps its state for the
+    // source's return. ~10% hysteresis keeps the boundary from flapping.
+    Panner * activePanner = m_panner.get();
+    if (m_hrtfLodDistance > 0.f
+        && static_cast<PanningMode>(m_panningModel->valueUint32()) == PanningMode::HRTF)
+    {
+        const float enter = m_hrtfLodDistance;
+        const float exit = 0.9f * m_hrtfLodDistance;
+        if (!m_hrtfLodActive && distanceSquared > enter * enter)
+            m_hrtfLodActive = true;
+        else if (m_hrtfLodActive && distanceSquared < exit * exit)
+            m_hrtfLodActive = false;
+
+        if (m_hrtfLodActive)
+        {
+            if (!m_lodPanner)
+                m_lodPanner = std::unique_ptr<Panner>(new EqualPowerPanner(m_sampleRate));
+            activePanner = m_lodPanner.get();
+        }
+    }
 
-    m_panner->pan(r, azimuth, elevation, source, destination, framesToProcess);
+    // Apply the panning effect. The panner always runs - it is processing
+    // audio - but a stationary source hands it the cached angles.
+    activePanner->pan(r, m_cachedAzimuth, m_cachedElevation, source, destination, framesToProcess);
 
-    // Get the distance and cone gain.
-    float totalGain = distanceConeGain(r);
+    float totalGain = m_cachedTotalGain;
 
     // Snap to desired gain at the beginning.
     if (m_lastGain == -1.f)
@@ -264,8 +387,14 @@ void PannerNode::process(ContextRenderLock & r, size_t framesToProcess)
 void PannerNode::reset(ContextRenderLock&)
 {
     m_lastGain = -1.0; // force to snap to initial gain
+    m_spatialCacheValid = false;
+    m_cullSleepRemaining = 0;
+    m_controlRateCountdown = 0;
+    m_hrtfLodActive = false;
     if (m_panner.get())
         m_panner->reset();
+    if (m_lodPanner.get())
+        m_lodPanner->reset();
 }
 
 PanningMode PannerNode::panningModel() const
@@ -300,6 +429,29 @@ void PannerNode::setPanningModel(PanningMode model)
 
 }
 
+void PannerNode::setControlRateLod(float distance, uint32_t intervalQuanta)
+{
+    m_controlRateLodDistance = distance;
+    m_controlRateInterval = intervalQuanta > 0 ? intervalQuanta : 1;
+    m_controlRateCountdown = 0;
+}
+
+void PannerNode::setCullWakeInterval(uint32_t intervalQuanta)
+{
+    m_cullWakeInterval = intervalQuanta > 0 ? intervalQuanta : 1;
+    m_cullSleepRemaining = 0;
+}
+
+void PannerNode::setFastSpatialMath(bool enable)
+{
+    m_fastSpatialMath->setUint32(enable ? 1 : 0);
+}
+
+bool PannerNode::fastSpatialMath() const
+{
+    return m_fastSpatialMath->valueUint32() != 0;
+}
+
 void PannerNode::setDistanceModel(DistanceModel model)
 {
     m_distanceModel->setUint32(static_cast<uint32_t>(model));
@@ -317,51 +469,47 @@ void PannerNode::getAzimuthElevation(ContextRenderLock& r, double* outAzimuth, d
 
     AudioListener & listener = r.context()->listener();
 
-    // Calculate the source-listener vector
-    FloatPoint3D listenerPosition = {
-                                        listener.positionX()->value(r),
-                                        listener.positionY()->value(r),
-                                        listener.positionZ()->value(r) };
+    // Calculate the source-listener vector, from the quantum's coherent
+    // listener snapshot.
+    FloatPoint3D listenerPosition = listener.snapshot(r).position;
 
     FloatPoint3D sourceListener = {
                                         positionX()->value(r),
                                         positionY()->value(r),
                                         positionZ()->value(r) };
 
-    sourceListener = normalize(sourceListener - listenerPosition);
+    sourceListener = sourceListener - listenerPosition;
 
     if (is_zero(sourceListener))
     {
-        // degenerate case if source and listener are at the same point
+        // degenerate case if source and listener are at the same point;
+        // test before normalizing, which would turn the zero vector into NaNs
         *outAzimuth = 0.0;
         *outElevation = 0.0;
         return;
     }
 
-    // Align axes
-    FloatPoint3D listenerFront = normalize(FloatPoint3D{
-                                        listener.forwardX()->value(r),
-                                        listener.forwardY()->value(r),
-                                        listener.forwardZ()->value(r) }
-                                    );
+    sourceListener = normalize(sourceListener);
 
-    FloatPoint3D listenerUp = {
-                                        listener.upX()->value(r),
-                                        listener.upY()->value(r),
-                                        listener.upZ()->value(r) };
+    // Align axes. The orthonormal listener basis is cached on the listener
+    // itself, so its normalization and cross products are shared by every
+    // panner in the scene.
+    const AudioListener::Basis & basis = listener.basis(r);
 
-    FloatPoint3D listenerRight = normalize(cross(listenerFront, listenerUp));
-    FloatPoint3D up = cross(listenerRight, listenerFront);
+    float upProjection = dot(sourceListener, basis.up);
 
-    float upProjection = dot(sourceListener, up);
+    FloatPoint3D projectedSource = normalize(sourceListener - upProjection * basis.up);
 
-    FloatPoint3D projectedSource = normalize(sourceListener - upProjection * up);
+    // fastAcos trades a maximum of ~0.004 degrees of accuracy for a
+    // polynomial evaluation; see AudioUtilities.
+    const bool fast = fastSpatialMath();
 
-    azimuth = 180.0 * acos(dot(projectedSource, listenerRight)) / piDouble;
+    float rightProjection = dot(projectedSource, basis.right);
+    azimuth = 180.0 * (fast ? AudioUtilities::fastAcos(rightProjection) : acos(rightProjection)) / piDouble;
     fixNANs(azimuth); // avoid illegal values
 
     // Source in front or behind the listener
-    double frontBack = dot(projectedSource, listenerFront);
+    double frontBack = dot(projectedSource, basis.front);
     if (frontBack < 0.0)
         azimuth = 360.0 - azimuth;
 
@@ -372,7 +520,7 @@ void PannerNode::getAzimuthElevation(ContextRenderLock& r, double* outAzimuth, d
         azimuth = 450.0 - azimuth;
 
     // Elevation
-    double elevation = 90.0 - 180.0 * acos(dot(sourceListener, up)) / piDouble;
+    double elevation = 90.0 - 180.0 * (fast ? AudioUtilities::fastAcos(upProjection) : acos(upProjection)) / piDouble;
     fixNANs(elevation); // avoid illegal values
 
     if (elevation > 90.0)
@@ -391,22 +539,20 @@ float PannerNode::dopplerRate(ContextRenderLock & r)
     double dopplerShift = 1.0;
 
     AudioListener & listener = r.context()->listener();
+    const AudioListener::Snapshot & listenerState = listener.snapshot(r);
 
     // FIXME: optimize for case when neither source nor listener has changed...
-    double dopplerFactor = listener.dopplerFactor()->value(r);
+    double dopplerFactor = listenerState.dopplerFactor;
 
     if (dopplerFactor > 0.0)
     {
-        double speedOfSound = listener.speedOfSound()->value(r);
+        double speedOfSound = listenerState.speedOfSound;
 
         const FloatPoint3D sourceVelocity = {
                                                     velocityX()->value(r),
                                                     velocityY()->value(r),
                                                     velocityZ()->value(r) };
-        const FloatPoint3D listenerVelocity = {
-                                                    listener.velocityX()->value(r),
-                                                    listener.velocityY()->value(r),
-                                                    listener.velocityZ()->value(r) };
+        const FloatPoint3D listenerVelocity = listenerState.velocity;
 
         // Don't bother if both source and listener have no velocity
         bool sourceHasVelocity = !is_zero(sourceVelocity);
@@ -415,10 +561,7 @@ float PannerNode::dopplerRate(ContextRenderLock & r)
         if (sourceHasVelocity || listenerHasVelocity)
         {
             // Calculate the source to listener vector
-            FloatPoint3D listenerPosition = {
-                                                    listener.positionX()->value(r),
-                                                    listener.positionY()->value(r),
-                                                    listener.positionZ()->value(r) };
+            FloatPoint3D listenerPosition = listenerState.position;
 
             FloatPoint3D sourceToListener = {
                                                     positionX()->value(r),
@@ -533,9 +676,19 @@ float PannerNode::coneOuterAngle() const { return static_cast<float>(m_coneEffec
 void PannerNode::setConeOuterAngle(float angle) { m_coneOuterAngle->setFloat(angle); }
 
 float PannerNode::coneOuterGain() const { return static_cast<float>(m_coneEffect->outerGain()); }
-void PannerNode::setConeOuterGain(float angle) { m_coneEffect->setOuterGain(angle); }
+void PannerNode::setConeOuterGain(float angle) { m_coneEffect->setOuterGain(angle); m_spatialCacheValid = false; }
 
 double PannerNode::tailTime(ContextRenderLock & r) const { return m_panner ? m_panner->tailTime(r) : 0; }
+
+void PannerNode::queryMemory(ContextRenderLock & r, MemoryUsage & usage) const
+{
+    AudioNode::queryMemory(r, usage);
+
+    // The database is shared process-wide through the loader singleton;
+    // each panner holding a reference counts it.
+    if (m_hrtfDatabaseLoader)
+        usage.hrtfBytes += m_hrtfDatabaseLoader->memoryBytes();
+}
 double PannerNode::latencyTime(ContextRenderLock & r) const { return m_panner ? m_panner->latencyTime(r) : 0; }
 
 } // namespace lab
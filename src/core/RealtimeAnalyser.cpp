@@ -3,19 +3,24 @@
 // Copyright (C) 2015+, The LabSound Authors. All rights reserved.
 
 #include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioNode.h"
 #include "LabSound/core/Macros.h"
+#include "LabSound/core/WindowFunctions.h"
 
 #include "LabSound/extended/RealtimeAnalyser.h"
 #include "LabSound/extended/AudioContextLock.h"
 
-#include "internal/AudioUtilities.h"
+#include "internal/FastMath.h"
 #include "internal/FFTFrame.h"
 #include "internal/VectorMath.h"
 #include "internal/Assertions.h"
 
+#include "readerwriterqueue/readerwriterqueue.h"
+
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <limits.h>
-#include <complex>
 
 using namespace std;
 
@@ -43,25 +48,34 @@ inline uint32_t RoundNextPow2(uint32_t v)
     return v;
 }
     
-inline void ApplyBlackmanWindow(float * p, uint32_t n)
+inline float FastLinearToDecibels(float x)
 {
-    // Blackman window
-    double alpha = 0.16;
-    double a0 = 0.5 * (1 - alpha);
-    double a1 = 0.5;
-    double a2 = 0.5 * alpha;
-    
-    for (uint32_t i = 0; i < n; ++i) 
+    // Maximum error is under 0.002 dB - well below both a visualizer pixel
+    // and the byte quantization in getByteFrequencyData - and it avoids a
+    // libm log10 call per bin per refresh.
+    return 20.f * FastMath::fast_log10f(x);
+}
+
+struct RealtimeAnalyser::Internals
+{
+    explicit Internals(uint32_t queueCapacity)
+        : sampleQueue(queueCapacity)
+        , downmixBuffer(MaxFFTSize)
     {
-        double x = static_cast<double>(i) / static_cast<double>(n);
-        double window = a0 - a1 * cos(2 * piDouble * x) + a2 * cos(4 * piDouble * x);
-        p[i] *= float(window);
     }
 
-}
+    // Render-thread -> consumer-thread sample hand-off. The capacity is fixed
+    // up front so try_enqueue never allocates on the render thread.
+    moodycamel::ReaderWriterQueue<float> sampleQueue;
+
+    // Render-thread scratch for summing a multi-channel bus to mono before
+    // publishing.
+    AudioFloatArray downmixBuffer;
+};
 
 RealtimeAnalyser::RealtimeAnalyser(uint32_t fftSize)
-    : m_inputBuffer(InputBufferSize)
+    : m_internals(new Internals(InputBufferSize))
+    , m_inputBuffer(InputBufferSize)
     , m_writeIndex(0)
     , m_smoothingTimeConstant(DefaultSmoothingTimeConstant)
     , m_minDecibels(DefaultMinDecibels)
@@ -71,7 +85,7 @@ RealtimeAnalyser::RealtimeAnalyser(uint32_t fftSize)
     m_fftSize = size;
     
     m_analysisFrame = std::unique_ptr<FFTFrame>(new FFTFrame(size));
-    
+
     // m_magnitudeBuffer has size = fftSize / 2 because it contains floats reduced from complex values in m_analysisFrame.
     m_magnitudeBuffer.allocate(size / 2);
 }
@@ -83,9 +97,32 @@ RealtimeAnalyser::~RealtimeAnalyser()
 
 void RealtimeAnalyser::reset()
 {
+    // Discard anything the render thread has published but no consumer has
+    // unrolled yet.
+    float sample;
+    while (m_internals->sampleQueue.try_dequeue(sample)) {}
+
     m_writeIndex = 0;
     m_inputBuffer.zero();
     m_magnitudeBuffer.zero();
+    m_samplesSinceAnalysis = 0;
+    m_haveAnalysis = false;
+}
+
+// Unrolls samples published by the render thread into the input ring. Must be
+// called from the consumer thread before the ring is read.
+void RealtimeAnalyser::drainInputQueue()
+{
+    float* inputBuffer = m_inputBuffer.data();
+
+    float sample;
+    while (m_internals->sampleQueue.try_dequeue(sample))
+    {
+        inputBuffer[m_writeIndex] = sample;
+        if (++m_writeIndex >= InputBufferSize)
+            m_writeIndex = 0;
+        ++m_samplesSinceAnalysis;
+    }
 }
 
 void RealtimeAnalyser::writeInput(ContextRenderLock &r, AudioBus* bus, size_t framesToProcess)
@@ -93,16 +130,14 @@ void RealtimeAnalyser::writeInput(ContextRenderLock &r, AudioBus* bus, size_t fr
     bool isBusGood = bus && bus->numberOfChannels() > 0 && bus->channel(0)->length() >= framesToProcess && r.context();
     if (!isBusGood)
         return;
-        
-    // FIXME : allow to work with non-FFTSize divisible chunking
-    bool isDestinationGood = m_writeIndex < m_inputBuffer.size() && m_writeIndex + framesToProcess <= m_inputBuffer.size();
-    ASSERT(isDestinationGood);
-    if (!isDestinationGood)
-        return;    
-    
-    // Perform real-time analysis
+
+    bool isSourceGood = framesToProcess <= m_internals->downmixBuffer.size();
+    ASSERT(isSourceGood);
+    if (!isSourceGood)
+        return;
+
     const float* source = bus->channel(0)->data();
-    float* dest = m_inputBuffer.data() + m_writeIndex;
+    float* dest = m_internals->downmixBuffer.data();
 
     // The source has already been sanity checked with isBusGood above.
     memcpy(dest, source, sizeof(float) * framesToProcess);
@@ -118,13 +153,26 @@ void RealtimeAnalyser::writeInput(ContextRenderLock &r, AudioBus* bus, size_t fr
         VectorMath::vsmul(dest, 1, &scale, dest, 1, framesToProcess);
     }
 
-    m_writeIndex += framesToProcess;
-    if (m_writeIndex >= InputBufferSize)
-        m_writeIndex = 0;
+    // Publish; this is the only touch the render thread makes on shared
+    // state. If no consumer has drained the queue in a while it fills up and
+    // the newest samples are dropped, which a meter tolerates.
+    for (size_t i = 0; i < framesToProcess; ++i)
+        m_internals->sampleQueue.try_enqueue(dest[i]);
 }
 
 void RealtimeAnalyser::doFFTAnalysis()
-{    
+{
+    drainInputQueue();
+
+    // Decimated mode: if fewer than the configured number of quanta arrived
+    // since the last analysis, the cached magnitudes are still current enough
+    // and the window/FFT/smoothing work is skipped outright.
+    if (m_haveAnalysis && m_samplesSinceAnalysis < size_t(m_analysisDecimation) * AudioNode::ProcessingSizeInFrames)
+        return;
+
+    m_samplesSinceAnalysis = 0;
+    m_haveAnalysis = true;
+
     // Unroll the input buffer into a temporary buffer, where we'll apply an analysis window followed by an FFT.
     uint32_t fftSize = this->fftSize();
     
@@ -144,9 +192,9 @@ void RealtimeAnalyser::doFFTAnalysis()
         memcpy(tempP, inputBuffer + writeIndex - fftSize, sizeof(*tempP) * fftSize);
     }
 
-    // Window the input samples.
-    ApplyBlackmanWindow(tempP, fftSize);
-    
+    // Window the input samples against the process-wide cached table.
+    applyWindowTable(window_blackman, tempP, fftSize);
+
     // Do the analysis.
     m_analysisFrame->doFFT(tempP);
 
@@ -157,21 +205,36 @@ void RealtimeAnalyser::doFFTAnalysis()
     imagP[0] = 0;
     
     // Normalize so than an input sine wave at 0dBfs registers as 0dBfs (undo FFT scaling factor).
-    const double magnitudeScale = 1.0 / DefaultFFTSize;
+    const float magnitudeScale = 1.0f / DefaultFFTSize;
 
     // A value of 0 does no averaging with the previous result.  Larger values produce slower, but smoother changes.
     double k = m_smoothingTimeConstant;
     k = max(0.0, k);
-    k = min(1.0, k);    
-    
-    // Convert the analysis data from complex to magnitude and average with the previous result.
+    k = min(1.0, k);
+
+    // Convert the analysis data from complex to magnitude and average with
+    // the previous result. The power spectrum (re^2 + im^2) is assembled with
+    // vector kernels; the square root stays a tight scalar loop, and the
+    // smoothing lerp is a vector scale plus a vector multiply-add.
     float* destination = magnitudeBuffer().data();
     size_t n = magnitudeBuffer().size();
-    for (size_t i = 0; i < n; ++i) {
-        std::complex<double> c(realP[i], imagP[i]);
-        double scalarMagnitude = abs(c) * magnitudeScale;        
-        destination[i] = float(k * destination[i] + (1 - k) * scalarMagnitude);
-    }
+
+    AudioFloatArray powerBuffer(n);
+    AudioFloatArray scratchBuffer(n);
+    float* powerP = powerBuffer.data();
+    float* scratchP = scratchBuffer.data();
+
+    VectorMath::vmul(realP, 1, realP, 1, powerP, 1, n);
+    VectorMath::vmul(imagP, 1, imagP, 1, scratchP, 1, n);
+    VectorMath::vadd(powerP, 1, scratchP, 1, powerP, 1, n);
+
+    for (size_t i = 0; i < n; ++i)
+        powerP[i] = sqrtf(powerP[i]) * magnitudeScale;
+
+    const float smoothK = float(k);
+    const float oneMinusK = float(1 - k);
+    VectorMath::vsmul(destination, 1, &smoothK, destination, 1, n);
+    VectorMath::vsma(powerP, 1, &oneMinusK, destination, 1, n);
 }
 
 void RealtimeAnalyser::getFloatFrequencyData(std::vector<float>& destinationArray)
@@ -182,15 +245,14 @@ void RealtimeAnalyser::getFloatFrequencyData(std::vector<float>& destinationArra
     doFFTAnalysis();
     
     // Convert from linear magnitude to floating-point decibels.
-    const double minDecibels = m_minDecibels;
+    const float minDecibels = float(m_minDecibels);
     size_t sourceLength = magnitudeBuffer().size();
     size_t len = min(sourceLength, destinationArray.size());
     if (len > 0) {
         const float* source = magnitudeBuffer().data();
         for (size_t i = 0; i < len; ++i) {
             float linearValue = source[i];
-            double dbMag = !linearValue ? minDecibels : AudioUtilities::linearToDecibels(linearValue);
-            destinationArray[i] = float(dbMag);
+            destinationArray[i] = !linearValue ? minDecibels : FastLinearToDecibels(linearValue);
         }
     }
 }
@@ -206,16 +268,16 @@ void RealtimeAnalyser::getByteFrequencyData(std::vector<uint8_t>& destinationArr
     size_t sourceLength = magnitudeBuffer().size();
     size_t len = min(sourceLength, destinationArray.size());
     if (len > 0) {
-        const double rangeScaleFactor = m_maxDecibels == m_minDecibels ? 1 : 1 / (m_maxDecibels - m_minDecibels);
-        const double minDecibels = m_minDecibels;
+        const float rangeScaleFactor = float(m_maxDecibels == m_minDecibels ? 1 : 1 / (m_maxDecibels - m_minDecibels));
+        const float minDecibels = float(m_minDecibels);
 
         const float* source = magnitudeBuffer().data();
         for (size_t i = 0; i < len; ++i) {
             float linearValue = source[i];
-            double dbMag = !linearValue ? minDecibels : AudioUtilities::linearToDecibels(linearValue);
-            
+            float dbMag = !linearValue ? minDecibels : FastLinearToDecibels(linearValue);
+
             // The range m_minDecibels to m_maxDecibels will be scaled to byte values from 0 to UCHAR_MAX.
-            double scaledValue = UCHAR_MAX * (dbMag - minDecibels) * rangeScaleFactor;
+            float scaledValue = UCHAR_MAX * (dbMag - minDecibels) * rangeScaleFactor;
 
             // Clip to valid range.
             if (scaledValue < 0)
@@ -229,26 +291,54 @@ void RealtimeAnalyser::getByteFrequencyData(std::vector<uint8_t>& destinationArr
 }
 
 // LabSound begin
+RealtimeAnalyser::TimeDomainView RealtimeAnalyser::floatTimeDomainView()
+{
+    drainInputQueue();
+
+    TimeDomainView view;
+
+    size_t fftSize = this->fftSize();
+    bool isInputBufferGood = m_inputBuffer.size() == InputBufferSize && m_inputBuffer.size() > fftSize;
+    ASSERT(isInputBufferGood);
+    if (!isInputBufferGood)
+        return view;
+
+    // The window is the fftSize samples ending at the write index; when the
+    // ring wrapped inside it, the older samples sit at the tail of the buffer
+    // and the newer ones at the head.
+    const float* inputBuffer = m_inputBuffer.data();
+    size_t writeIndex = m_writeIndex;
+    if (writeIndex < fftSize)
+    {
+        view.first = inputBuffer + InputBufferSize - (fftSize - writeIndex);
+        view.firstLength = fftSize - writeIndex;
+        view.second = inputBuffer;
+        view.secondLength = writeIndex;
+    }
+    else
+    {
+        view.first = inputBuffer + writeIndex - fftSize;
+        view.firstLength = fftSize;
+    }
+
+    return view;
+}
+
 void RealtimeAnalyser::getFloatTimeDomainData(std::vector<float>& destinationArray)
 {
     if (!destinationArray.size())
         return;
-    
-    size_t fftSize = this->fftSize();
-    size_t len = min(fftSize, destinationArray.size());
-    if (len > 0) {
-        bool isInputBufferGood = m_inputBuffer.size() == InputBufferSize && m_inputBuffer.size() > fftSize;
-        ASSERT(isInputBufferGood);
-        if (!isInputBufferGood)
-            return;
-        
-        float* inputBuffer = m_inputBuffer.data();
-        size_t writeIndex = m_writeIndex;
-        
-        for (size_t i = 0; i < len; ++i)
-            // Buffer access is protected due to modulo operation.
-            destinationArray[i] = inputBuffer[(i + writeIndex - fftSize + InputBufferSize) % InputBufferSize];
-    }
+
+    // The contiguity fallback: at most two memcpys from the view's spans
+    // instead of a modulo-indexed copy per sample.
+    TimeDomainView view = floatTimeDomainView();
+
+    size_t len = min(view.length(), destinationArray.size());
+    size_t n1 = min(len, view.firstLength);
+    if (n1)
+        memcpy(destinationArray.data(), view.first, sizeof(float) * n1);
+    if (len > n1)
+        memcpy(destinationArray.data() + n1, view.second, sizeof(float) * (len - n1));
 }
 // LabSound end
 
@@ -256,33 +346,23 @@ void RealtimeAnalyser::getByteTimeDomainData(std::vector<uint8_t>& destinationAr
 {
     if (!destinationArray.size())
         return;
-        
-    size_t fftSize = this->fftSize();
-    size_t len = min(fftSize, destinationArray.size());
-    if (len > 0) {
-        bool isInputBufferGood = m_inputBuffer.size() == InputBufferSize && m_inputBuffer.size() > fftSize;
-        ASSERT(isInputBufferGood);
-        if (!isInputBufferGood)
-            return;
 
-        float* inputBuffer = m_inputBuffer.data();
-        size_t writeIndex = m_writeIndex;
+    TimeDomainView view = floatTimeDomainView();
 
-        for (size_t i = 0; i < len; ++i) {
-            // Buffer access is protected due to modulo operation.
-            float value = inputBuffer[(i + writeIndex - fftSize + InputBufferSize) % InputBufferSize];
+    size_t len = min(view.length(), destinationArray.size());
+    for (size_t i = 0; i < len; ++i) {
+        float value = i < view.firstLength ? view.first[i] : view.second[i - view.firstLength];
 
-            // Scale from nominal -1 -> +1 to unsigned byte.
-            double scaledValue = 128 * (value + 1);
+        // Scale from nominal -1 -> +1 to unsigned byte.
+        double scaledValue = 128 * (value + 1);
 
-            // Clip to valid range.
-            if (scaledValue < 0)
-                scaledValue = 0;
-            if (scaledValue > UCHAR_MAX)
-                scaledValue = UCHAR_MAX;
-            
-            destinationArray[i] = static_cast<unsigned char>(scaledValue);
-        }
+        // Clip to valid range.
+        if (scaledValue < 0)
+            scaledValue = 0;
+        if (scaledValue > UCHAR_MAX)
+            scaledValue = UCHAR_MAX;
+
+        destinationArray[i] = static_cast<unsigned char>(scaledValue);
     }
 }
 
@@ -13,11 +13,19 @@
 #include "LabSound/core/AudioSetting.h"
 #include "LabSound/core/Macros.h"
 #include "LabSound/extended/AudioContextLock.h"
+#include "LabSound/extended/AudioFileStream.h"
 
 #include "internal/AudioUtilities.h"
+#include "internal/AudioThreads.h"
 #include "internal/Assertions.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 
 using namespace std;
 
@@ -30,11 +38,132 @@ const double DefaultGrainDuration = 0.020; // 20ms
 // to minimize linear interpolation aliasing.
 const double MaxRate = 1024;
 
+// Capacity of the streaming prefetch ring, and the granularity of i/o thread
+// fetches. 32k frames of stereo float is 256 KB resident per streaming node,
+// and at 44.1kHz gives the i/o thread ~740ms of slack.
+const size_t StreamRingFrames = 32768;
+const size_t StreamFetchFrames = 8192;
+
+namespace {
+
+    // Resampling kernels for the constant-rate path in renderFromBuffer().
+    // Read indices and interpolation fractions are precomputed once per run
+    // and shared by every channel, and the caller guarantees that all taps
+    // are in-bounds, so these inner loops are branch-free. The gathers go
+    // through the index table and are necessarily scalar, but the
+    // interpolation arithmetic runs four outputs at a time.
+    //
+    // The kernels are templated over a fetcher so they can read either native
+    // float or the packed int16 storage mode (see SampledAudioNode::setBus);
+    // int16 samples are converted to float as they are gathered, which hides
+    // the conversion inside the scalar gather the kernel does anyway.
+    // Quantization scales by 32767 and dequantization by 1/32767 so that a
+    // full-scale round trip is gain-exact.
+
+    struct FetchFloat32
+    {
+        const float * p;
+        float operator()(unsigned i) const { return p[i]; }
+    };
+
+    struct FetchInt16
+    {
+        const int16_t * p;
+        float operator()(unsigned i) const { return p[i] * (1.f / 32767.f); }
+    };
+
+    template <typename Fetch>
+    void interpolateLinear(Fetch source, const unsigned* readIndex, const float* frac, float* destination, int framesToProcess)
+    {
+        int k = 0;
+#ifdef __SSE2__
+        for (; k + 4 <= framesToProcess; k += 4)
+        {
+            __m128 s0 = _mm_set_ps(source(readIndex[k + 3]), source(readIndex[k + 2]), source(readIndex[k + 1]), source(readIndex[k]));
+            __m128 s1 = _mm_set_ps(source(readIndex[k + 3] + 1), source(readIndex[k + 2] + 1), source(readIndex[k + 1] + 1), source(readIndex[k] + 1));
+            __m128 f = _mm_loadu_ps(frac + k);
+            _mm_storeu_ps(destination + k, _mm_add_ps(s0, _mm_mul_ps(f, _mm_sub_ps(s1, s0))));
+        }
+#endif
+        for (; k < framesToProcess; ++k)
+        {
+            float s0 = source(readIndex[k]);
+            float s1 = source(readIndex[k] + 1);
+            destination[k] = s0 + frac[k] * (s1 - s0);
+        }
+    }
+
+    // 4-point Catmull-Rom; every readIndex[k] must have one valid frame
+    // before it and two after.
+    template <typename Fetch>
+    void interpolateCubic(Fetch source, const unsigned* readIndex, const float* frac, float* destination, int framesToProcess)
+    {
+        int k = 0;
+#ifdef __SSE2__
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 fiveHalves = _mm_set1_ps(2.5f);
+        const __m128 two = _mm_set1_ps(2.f);
+        const __m128 threeHalves = _mm_set1_ps(1.5f);
+        for (; k + 4 <= framesToProcess; k += 4)
+        {
+            __m128 xm1 = _mm_set_ps(source(readIndex[k + 3] - 1), source(readIndex[k + 2] - 1), source(readIndex[k + 1] - 1), source(readIndex[k] - 1));
+            __m128 x0 = _mm_set_ps(source(readIndex[k + 3]), source(readIndex[k + 2]), source(readIndex[k + 1]), source(readIndex[k]));
+            __m128 x1 = _mm_set_ps(source(readIndex[k + 3] + 1), source(readIndex[k + 2] + 1), source(readIndex[k + 1] + 1), source(readIndex[k] + 1));
+            __m128 x2 = _mm_set_ps(source(readIndex[k + 3] + 2), source(readIndex[k + 2] + 2), source(readIndex[k + 1] + 2), source(readIndex[k] + 2));
+            __m128 f = _mm_loadu_ps(frac + k);
+
+            __m128 c1 = _mm_mul_ps(half, _mm_sub_ps(x1, xm1));
+            __m128 c2 = _mm_add_ps(_mm_sub_ps(xm1, _mm_mul_ps(fiveHalves, x0)), _mm_sub_ps(_mm_mul_ps(two, x1), _mm_mul_ps(half, x2)));
+            __m128 c3 = _mm_add_ps(_mm_mul_ps(half, _mm_sub_ps(x2, xm1)), _mm_mul_ps(threeHalves, _mm_sub_ps(x0, x1)));
+
+            __m128 result = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(c3, f), c2), f), c1), f), x0);
+            _mm_storeu_ps(destination + k, result);
+        }
+#endif
+        for (; k < framesToProcess; ++k)
+        {
+            float xm1 = source(readIndex[k] - 1);
+            float x0 = source(readIndex[k]);
+            float x1 = source(readIndex[k] + 1);
+            float x2 = source(readIndex[k] + 2);
+            float f = frac[k];
+
+            float c1 = 0.5f * (x1 - xm1);
+            float c2 = xm1 - 2.5f * x0 + 2.f * x1 - 0.5f * x2;
+            float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+
+            destination[k] = ((c3 * f + c2) * f + c1) * f + x0;
+        }
+    }
+
+    // Block int16 -> float conversion for the pitchRate == 1 path, which is a
+    // straight memcpy in float storage mode.
+    void convertInt16ToFloat(const int16_t* source, float* destination, int framesToProcess)
+    {
+        int k = 0;
+#ifdef __SSE2__
+        const __m128 scale = _mm_set1_ps(1.f / 32767.f);
+        for (; k + 8 <= framesToProcess; k += 8)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + k));
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+            _mm_storeu_ps(destination + k, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+            _mm_storeu_ps(destination + k + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+        }
+#endif
+        for (; k < framesToProcess; ++k)
+            destination[k] = source[k] * (1.f / 32767.f);
+    }
+
+}  // anonymous namespace
+
 SampledAudioNode::SampledAudioNode()
 : AudioScheduledSourceNode()
 , m_isLooping(std::make_shared<AudioSetting>("loop"))
 , m_loopStart(std::make_shared<AudioSetting>("loopStart"))
 , m_loopEnd(std::make_shared<AudioSetting>("loopEnd"))
+, m_interpolation(std::make_shared<AudioSetting>("interpolation"))
 , m_grainDuration(DefaultGrainDuration)
 {
     m_gain = make_shared<AudioParam>("gain", 1.0, 0.0, 1.0);
@@ -48,6 +177,7 @@ SampledAudioNode::SampledAudioNode()
     m_settings.push_back(m_isLooping);
     m_settings.push_back(m_loopStart);
     m_settings.push_back(m_loopEnd);
+    m_settings.push_back(m_interpolation);
 
     // Default to mono. A call to setBus() will set the number of output channels to that of the bus.
     addOutput(std::unique_ptr<AudioNodeOutput>(new AudioNodeOutput(this, 1)));
@@ -57,6 +187,7 @@ SampledAudioNode::SampledAudioNode()
 
 SampledAudioNode::~SampledAudioNode()
 {
+    stopStreamThread();
     uninitialize();
 }
 
@@ -64,7 +195,7 @@ void SampledAudioNode::process(ContextRenderLock & r, size_t framesToProcess)
 {
     AudioBus* outputBus = output(0)->bus(r);
 
-    if (!getBus() || !isInitialized() || ! r.context())
+    if ((!getBus() && !m_stream && m_packedChannels.empty()) || !isInitialized() || ! r.context())
     {
         outputBus->zero();
         return;
@@ -73,13 +204,26 @@ void SampledAudioNode::process(ContextRenderLock & r, size_t framesToProcess)
     // After calling setBuffer() with a buffer having a different number of channels, there can in rare cases be a slight delay
     // before the output bus is updated to the new number of channels because of use of tryLocks() in the context's updating system.
     // In this case, if the the buffer has just been changed and we're not quite ready yet, then just output silence.
-    if (numberOfChannels(r) != getBus()->numberOfChannels())
+    size_t sourceChannels = m_stream ? m_stream->numberOfChannels()
+                          : getBus() ? getBus()->numberOfChannels()
+                                     : m_packedChannels.size();
+    if (numberOfChannels(r) != sourceChannels)
     {
         outputBus->zero();
         return;
     }
 
-    if (m_startRequested)
+    if (m_startRequested && m_stream)
+    {
+        m_startTime = m_requestWhen;
+        m_isGrain = false;
+
+        // A nonzero offset is honored coarsely by discarding frames from the
+        // ring as the i/o thread delivers them.
+        m_streamFramesToSkip = AudioUtilities::timeToSampleFrame(std::max(0.0, m_requestGrainOffset), static_cast<double>(m_stream->sampleRate()));
+        m_startRequested = false;
+    }
+    else if (m_startRequested)
     {
         // Do sanity checking of grain parameters versus buffer size.
         double bufferDuration = duration();
@@ -108,7 +252,7 @@ void SampledAudioNode::process(ContextRenderLock & r, size_t framesToProcess)
 
         /// @TODO consistently pick double or size_t through this entire API chain.
         m_virtualReadIndex = static_cast<double>(
-                                AudioUtilities::timeToSampleFrame(m_grainOffset, static_cast<double>(getBus()->sampleRate())));
+                                AudioUtilities::timeToSampleFrame(m_grainOffset, static_cast<double>(sourceSampleRate())));
         m_startRequested = false;
     }
 
@@ -123,8 +267,24 @@ void SampledAudioNode::process(ContextRenderLock & r, size_t framesToProcess)
         return;
     }
 
-    // Render by reading directly from the buffer.
-    if (!renderFromBuffer(r, outputBus, quantumFrameOffset, bufferFramesToProcess))
+    // Parked by a voice manager: emit silence without rendering while the
+    // playback position advances as if the quantum had been produced, so a
+    // revived voice resumes where it would have been. Streams can't advance
+    // virtually (the prefetch ring is not consumed), so they simply pause.
+    if (m_parked.load(std::memory_order_relaxed))
+    {
+        if (!m_stream)
+            advanceParkedPosition(r, bufferFramesToProcess);
+        outputBus->zero();
+        return;
+    }
+
+    // Render by reading directly from the buffer, or from the prefetch ring when streaming.
+    bool rendered = m_stream
+        ? renderFromStream(r, outputBus, quantumFrameOffset, bufferFramesToProcess)
+        : renderFromBuffer(r, outputBus, quantumFrameOffset, bufferFramesToProcess);
+
+    if (!rendered)
     {
         outputBus->zero();
         return;
@@ -165,8 +325,9 @@ bool SampledAudioNode::renderFromBuffer(ContextRenderLock& r, AudioBus* bus, siz
         return false;
 
     auto srcBus = getBus();
+    bool packed = !m_packedChannels.empty();
 
-    if (!bus || !srcBus)
+    if (!bus || (!srcBus && !packed))
         return false;
 
     size_t numChannels = numberOfChannels(r);
@@ -193,8 +354,8 @@ bool SampledAudioNode::renderFromBuffer(ContextRenderLock& r, AudioBus* bus, siz
     // Offset the pointers to the correct offset frame.
     size_t writeIndex = destinationFrameOffset;
 
-    size_t bufferLength = srcBus->length();
-    double bufferSampleRate = srcBus->sampleRate();
+    size_t bufferLength = sourceLength();
+    double bufferSampleRate = sourceSampleRate();
 
     // Avoid converting from time to sample-frames twice by computing
     // the grain end time first before computing the sample frame.
@@ -224,8 +385,8 @@ bool SampledAudioNode::renderFromBuffer(ContextRenderLock& r, AudioBus* bus, siz
     if (loop() && (loopS || loopE) && loopS >= 0 && loopE > 0 && loopS < loopE)
     {
         // Convert from seconds to sample-frames.
-        double loopStartFrame = loopS * srcBus->sampleRate();
-        double loopEndFrame = loopE * srcBus->sampleRate();
+        double loopStartFrame = loopS * bufferSampleRate;
+        double loopEndFrame = loopE * bufferSampleRate;
 
         virtualEndFrame = std::min(loopEndFrame, virtualEndFrame);
         virtualDeltaFrames = virtualEndFrame - loopStartFrame;
@@ -238,6 +399,19 @@ bool SampledAudioNode::renderFromBuffer(ContextRenderLock& r, AudioBus* bus, siz
     if (fabs(pitchRate) >= virtualDeltaFrames)
         return false;
 
+    // Precomputed loop-seam crossfade: engaged only while the loop geometry
+    // still matches what the tail was built for (see setLoopCrossfade);
+    // reads inside [tailStart, loopEnd) come from the blended segment.
+    size_t tailFrames = 0;
+    double tailStart = 0;
+    if (loop() && m_loopTailFrames
+        && virtualEndFrame == m_loopTailEndFrame
+        && virtualEndFrame - virtualDeltaFrames == m_loopTailLoopStartFrame)
+    {
+        tailFrames = m_loopTailFrames;
+        tailStart = virtualEndFrame - static_cast<double>(tailFrames);
+    }
+
     // Get local copy.
     double virtualReadIndex = m_virtualReadIndex;
 
@@ -251,16 +425,27 @@ bool SampledAudioNode::renderFromBuffer(ContextRenderLock& r, AudioBus* bus, siz
         int readIndex = static_cast<int>(virtualReadIndex);
         int deltaFrames = static_cast<int>(virtualDeltaFrames);
         endFrame = static_cast<int>(virtualEndFrame);
+        int tailStartFrame = static_cast<int>(tailStart);
 
         while (framesToProcess > 0)
         {
-            int framesToEnd = static_cast<int>(endFrame) - readIndex;
+            // Split runs at the crossfade boundary so the copy below reads
+            // from exactly one of the two sources.
+            bool inTail = tailFrames && readIndex >= tailStartFrame;
+            int boundary = (tailFrames && !inTail) ? tailStartFrame : static_cast<int>(endFrame);
+            int framesToEnd = boundary - readIndex;
             int framesThisTime = std::min(framesToProcess, framesToEnd);
             framesThisTime = std::max(0, framesThisTime);
 
             for (unsigned i = 0; i < numChannels; ++i)
             {
-                memcpy(bus->channel(i)->mutableData() + writeIndex, srcBus->channel(i)->data() + readIndex, sizeof(float) * framesThisTime);
+                float * destination = bus->channel(i)->mutableData() + writeIndex;
+                if (inTail)
+                    memcpy(destination, m_loopTail[i].data() + 1 + (readIndex - tailStartFrame), sizeof(float) * framesThisTime);
+                else if (packed)
+                    convertInt16ToFloat(m_packedChannels[i].data() + readIndex, destination, framesThisTime);
+                else
+                    memcpy(destination, srcBus->channel(i)->data() + readIndex, sizeof(float) * framesThisTime);
             }
 
             writeIndex += framesThisTime;
@@ -279,52 +464,205 @@ bool SampledAudioNode::renderFromBuffer(ContextRenderLock& r, AudioBus* bus, siz
     }
     else
     {
-        while (framesToProcess--)
-        {
-            unsigned readIndex = static_cast<unsigned>(virtualReadIndex);
-            double interpolationFactor = virtualReadIndex - readIndex;
-
-            // For linear interpolation we need the next sample-frame too.
-            unsigned readIndex2 = readIndex + 1;
+        // Resampling path. The rate is constant within the quantum, so the
+        // render is segmented into runs whose source reads are known to stay
+        // in-bounds: the wrap/boundary logic runs once per run instead of
+        // once per sample, read indices and fractions are computed once and
+        // shared by all channels, and the interpolation arithmetic itself is
+        // vectorized (see interpolateLinear / interpolateCubic above).
+        //
+        // The read position is carried in 32.32 fixed point: the read index
+        // is the high word and the interpolation fraction the low word, so
+        // advancing is one integer add per sample with no per-sample
+        // double-to-int rounding. Conversion to and from the double
+        // m_virtualReadIndex happens once per call; the step is truncated,
+        // so a run can never land past the in-bounds end its length was
+        // computed from.
+        bool cubic = m_interpolationExplicit
+            ? interpolation() == CUBIC_INTERPOLATION
+            : r.context()->resamplerQualityPolicy().voicePlayback != ResamplerQuality::Linear;
+
+        const int64_t kFixedOne = int64_t(1) << 32;
+        const double kFixedScale = 4294967296.0;
+        const float kFracScale = 1.0f / 4294967296.0f;
+
+        int64_t fixedReadIndex = static_cast<int64_t>(virtualReadIndex * kFixedScale);
+        const int64_t fixedStep = std::max<int64_t>(1, static_cast<int64_t>(pitchRate * kFixedScale));
+        const int64_t fixedEndFrame = static_cast<int64_t>(virtualEndFrame * kFixedScale);
+        const int64_t fixedDeltaFrames = static_cast<int64_t>(virtualDeltaFrames * kFixedScale);
+        const int64_t fixedTailStart = static_cast<int64_t>(tailStart * kFixedScale);
+
+        const int MaxRunFrames = AudioNode::ProcessingSizeInFrames;
+        unsigned runIndex[MaxRunFrames];
+        float runFrac[MaxRunFrames];
 
-            if (readIndex2 >= bufferLength)
+        while (framesToProcess > 0)
+        {
+            // The furthest read position whose taps all stay inside the
+            // buffer: cubic needs one frame before the read index and two
+            // after, linear just one after.
+            int64_t safeEnd = std::min(fixedEndFrame, (static_cast<int64_t>(bufferLength) - (cubic ? 2 : 1)) * kFixedOne);
+            bool inTail = tailFrames && fixedReadIndex >= fixedTailStart;
+            if (inTail)
             {
-                if (loop()) {
-                    // Make sure to wrap around at the end of the buffer.
-                    readIndex2 = static_cast<unsigned>(virtualReadIndex + 1 - virtualDeltaFrames);
-                } else
-                    readIndex2 = readIndex;
+                // Reads come from the guarded tail segment, whose guard
+                // frames cover the taps all the way to the loop end.
+                safeEnd = fixedEndFrame;
             }
-
-            // Final sanity check on buffer access.
-            // FIXME: as an optimization, try to get rid of this inner-loop check and put assertions and guards before the loop.
-            if (readIndex >= bufferLength || readIndex2 >= bufferLength)
-                break;
-
-            // Linear interpolation.
-            for (unsigned i = 0; i < numChannels; ++i)
+            else if (tailFrames)
             {
-                float * destination = bus->channel(i)->mutableData();
-                const float * source = srcBus->channel(i)->data();
+                // Stop the run at the crossfade boundary so the next run
+                // switches to the tail segment.
+                safeEnd = std::min(safeEnd, fixedTailStart);
+            }
+            bool runCubic = cubic && (inTail || fixedReadIndex >= kFixedOne);
 
-                double sample1 = source[readIndex];
-                double sample2 = source[readIndex2];
-                double sample = (1.0 - interpolationFactor) * sample1 + interpolationFactor * sample2;
+            int runFrames = 0;
+            if (fixedReadIndex < safeEnd)
+            {
+                int64_t available = (safeEnd - fixedReadIndex) / fixedStep;
+                runFrames = available >= MaxRunFrames ? MaxRunFrames : static_cast<int>(available);
+            }
+            if (cubic && !runCubic && runFrames > 0)
+            {
+                // No leading history yet; render linearly up to the point
+                // where the fourth tap becomes available.
+                int64_t framesToHistory = (kFixedOne - fixedReadIndex) / fixedStep + 1;
+                if (framesToHistory < runFrames)
+                    runFrames = static_cast<int>(framesToHistory);
+            }
+            runFrames = std::min(runFrames, framesToProcess);
 
-                destination[writeIndex] = static_cast<float>(sample);
+            if (runFrames > 0)
+            {
+                // Tail reads are rebased so index 0 is the leading guard
+                // frame; the offset is always >= 1, so cubic's -1 tap stays
+                // inside the segment.
+                unsigned rebase = inTail ? static_cast<unsigned>(fixedTailStart >> 32) - 1 : 0;
+                for (int k = 0; k < runFrames; ++k)
+                {
+                    // Induction form (base + k * step, no loop-carried
+                    // dependency) so the index and fraction lanes can be
+                    // computed with integer SIMD.
+                    int64_t p = fixedReadIndex + k * fixedStep;
+                    runIndex[k] = static_cast<unsigned>(p >> 32) - rebase;
+                    runFrac[k] = static_cast<float>(static_cast<uint32_t>(p)) * kFracScale;
+                }
+
+                for (unsigned i = 0; i < numChannels; ++i)
+                {
+                    float * destination = bus->channel(i)->mutableData() + writeIndex;
+
+                    if (inTail)
+                    {
+                        FetchFloat32 source = {m_loopTail[i].data()};
+                        if (runCubic)
+                            interpolateCubic(source, runIndex, runFrac, destination, runFrames);
+                        else
+                            interpolateLinear(source, runIndex, runFrac, destination, runFrames);
+                    }
+                    else if (packed)
+                    {
+                        FetchInt16 source = {m_packedChannels[i].data()};
+                        if (runCubic)
+                            interpolateCubic(source, runIndex, runFrac, destination, runFrames);
+                        else
+                            interpolateLinear(source, runIndex, runFrac, destination, runFrames);
+                    }
+                    else
+                    {
+                        FetchFloat32 source = {srcBus->channel(i)->data()};
+                        if (runCubic)
+                            interpolateCubic(source, runIndex, runFrac, destination, runFrames);
+                        else
+                            interpolateLinear(source, runIndex, runFrac, destination, runFrames);
+                    }
+                }
+
+                writeIndex += runFrames;
+                framesToProcess -= runFrames;
+                fixedReadIndex += runFrames * fixedStep;
             }
-            writeIndex++;
+            else
+            {
+                // Within a tap's reach of the buffer end or the loop end;
+                // render one sample with the careful boundary handling.
+                unsigned readIndex = static_cast<unsigned>(fixedReadIndex >> 32);
+                double interpolationFactor = static_cast<double>(fixedReadIndex & 0xFFFFFFFF) / kFixedScale;
+
+                // For linear interpolation we need the next sample-frame too.
+                unsigned readIndex2 = readIndex + 1;
+
+                if (inTail)
+                {
+                    // Map into the tail segment; its trailing guard frames
+                    // stand in for the wrapped loop-start samples.
+                    readIndex = readIndex - static_cast<unsigned>(fixedTailStart >> 32) + 1;
+                    readIndex2 = readIndex + 1;
+                }
+                else if (readIndex2 >= bufferLength)
+                {
+                    if (loop()) {
+                        // Make sure to wrap around at the end of the buffer.
+                        readIndex2 = static_cast<unsigned>((fixedReadIndex + kFixedOne - fixedDeltaFrames) >> 32);
+                    } else
+                        readIndex2 = readIndex;
+                }
+
+                // Final sanity check on buffer access.
+                if (inTail)
+                {
+                    if (readIndex2 >= tailFrames + 3)
+                        break;
+                }
+                else if (readIndex >= bufferLength || readIndex2 >= bufferLength)
+                    break;
 
-            virtualReadIndex += pitchRate;
+                // Linear interpolation.
+                for (unsigned i = 0; i < numChannels; ++i)
+                {
+                    float * destination = bus->channel(i)->mutableData();
+
+                    double sample1, sample2;
+                    if (inTail)
+                    {
+                        const float * source = m_loopTail[i].data();
+                        sample1 = source[readIndex];
+                        sample2 = source[readIndex2];
+                    }
+                    else if (packed)
+                    {
+                        FetchInt16 source = {m_packedChannels[i].data()};
+                        sample1 = source(readIndex);
+                        sample2 = source(readIndex2);
+                    }
+                    else
+                    {
+                        const float * source = srcBus->channel(i)->data();
+                        sample1 = source[readIndex];
+                        sample2 = source[readIndex2];
+                    }
+                    double sample = (1.0 - interpolationFactor) * sample1 + interpolationFactor * sample2;
+
+                    destination[writeIndex] = static_cast<float>(sample);
+                }
+                writeIndex++;
+                framesToProcess--;
+
+                fixedReadIndex += fixedStep;
+            }
 
-            // Wrap-around, retaining sub-sample position since virtualReadIndex is floating-point.
-            if (virtualReadIndex >= virtualEndFrame)
+            // Wrap-around, retaining the sub-sample position held in the low word.
+            // Runs never cross the end frame, so this only fires after the boundary samples.
+            if (fixedReadIndex >= fixedEndFrame)
             {
-                virtualReadIndex -= virtualDeltaFrames;
+                fixedReadIndex -= fixedDeltaFrames;
                 if (renderSilenceAndFinishIfNotLooping(r, bus, writeIndex, static_cast<size_t>(framesToProcess)))
                     break;
             }
         }
+
+        virtualReadIndex = static_cast<double>(fixedReadIndex) / kFixedScale;
     }
 
     bus->clearSilentFlag();
@@ -335,6 +673,159 @@ bool SampledAudioNode::renderFromBuffer(ContextRenderLock& r, AudioBus* bus, siz
 }
 
 
+bool SampledAudioNode::renderFromStream(ContextRenderLock& r, AudioBus* bus, size_t destinationFrameOffset, size_t numberOfFrames)
+{
+    if (!r.context() || !bus)
+        return false;
+
+    size_t numChannels = numberOfChannels(r);
+    if (!numChannels || numChannels != bus->numberOfChannels() || numChannels != m_streamRing.size())
+        return false;
+
+    if (destinationFrameOffset + numberOfFrames > bus->length())
+        return false;
+
+    uint64_t readFrame = m_streamReadFrame.load(std::memory_order_relaxed);
+    uint64_t writeFrame = m_streamWriteFrame.load(std::memory_order_acquire);
+
+    // Coarse seek: throw away frames until the requested offset is reached.
+    while (m_streamFramesToSkip && readFrame < writeFrame)
+    {
+        uint64_t skip = std::min<uint64_t>(m_streamFramesToSkip, writeFrame - readFrame);
+        readFrame += skip;
+        m_streamFramesToSkip -= skip;
+    }
+
+    size_t writeIndex = destinationFrameOffset;
+    size_t remaining = numberOfFrames;
+
+    while (remaining)
+    {
+        writeFrame = m_streamWriteFrame.load(std::memory_order_acquire);
+        uint64_t available = writeFrame - readFrame;
+        if (!available)
+            break;
+
+        size_t ringIndex = static_cast<size_t>(readFrame % StreamRingFrames);
+        size_t contiguous = StreamRingFrames - ringIndex;
+        size_t framesThisTime = static_cast<size_t>(std::min<uint64_t>(std::min<uint64_t>(remaining, available), contiguous));
+
+        for (size_t i = 0; i < numChannels; ++i)
+        {
+            memcpy(bus->channel(static_cast<unsigned>(i))->mutableData() + writeIndex, m_streamRing[i].data() + ringIndex, sizeof(float) * framesThisTime);
+        }
+
+        readFrame += framesThisTime;
+        writeIndex += framesThisTime;
+        remaining -= framesThisTime;
+    }
+
+    m_streamReadFrame.store(readFrame, std::memory_order_release);
+
+    uint64_t endFrame = m_streamEndFrame.load(std::memory_order_acquire);
+    if (readFrame >= endFrame)
+    {
+        // Drained a finite (non-looping) stream completely.
+        if (remaining)
+        {
+            for (unsigned i = 0; i < numChannels; ++i)
+                memset(bus->channel(i)->mutableData() + writeIndex, 0, sizeof(float) * remaining);
+        }
+        finish(r);
+    }
+    else if (remaining)
+    {
+        // The i/o thread fell behind; emit silence rather than stale data.
+        for (unsigned i = 0; i < numChannels; ++i)
+            memset(bus->channel(i)->mutableData() + writeIndex, 0, sizeof(float) * remaining);
+
+        m_streamUnderruns.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bus->clearSilentFlag();
+
+    // Wake the i/o thread using a tryLock() so the render thread never blocks;
+    // a missed wakeup is recovered by the thread's periodic poll.
+    if (m_streamMutex.try_lock())
+    {
+        m_streamMutex.unlock();
+        m_streamCondition.notify_one();
+    }
+
+    return true;
+}
+
+void SampledAudioNode::streamFetchLoop()
+{
+    ApplyThreadPolicy(AudioContext::ThreadRole::Background, "sample stream");
+
+    std::vector<float *> chunkPointers(m_streamRing.size());
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_streamMutex);
+            if (m_streamThreadShouldExit)
+                return;
+
+            // Poll periodically as well as on notify; the render thread's wakeup
+            // is best-effort by design.
+            m_streamCondition.wait_for(lock, std::chrono::milliseconds(10));
+            if (m_streamThreadShouldExit)
+                return;
+        }
+
+        for (;;)
+        {
+            uint64_t writeFrame = m_streamWriteFrame.load(std::memory_order_relaxed);
+            uint64_t readFrame = m_streamReadFrame.load(std::memory_order_acquire);
+            uint64_t space = StreamRingFrames - (writeFrame - readFrame);
+            if (space < StreamFetchFrames)
+                break;
+
+            if (m_streamSourceFrame >= m_stream->length())
+            {
+                if (!loop())
+                {
+                    // Publish where the stream ends so the render thread can finish,
+                    // then go idle until more space opens (no-op) or exit.
+                    m_streamEndFrame.store(writeFrame, std::memory_order_release);
+                    break;
+                }
+                m_streamSourceFrame = 0;
+            }
+
+            size_t ringIndex = static_cast<size_t>(writeFrame % StreamRingFrames);
+            size_t contiguous = StreamRingFrames - ringIndex;
+            size_t framesToFetch = std::min(StreamFetchFrames, contiguous);
+
+            for (size_t i = 0; i < m_streamRing.size(); ++i)
+                chunkPointers[i] = m_streamRing[i].data() + ringIndex;
+
+            size_t framesRead = m_stream->read(m_streamSourceFrame, chunkPointers.data(), framesToFetch);
+            if (!framesRead)
+                break; // i/o error; render thread will underrun and emit silence
+
+            m_streamSourceFrame += framesRead;
+            m_streamWriteFrame.store(writeFrame + framesRead, std::memory_order_release);
+        }
+    }
+}
+
+void SampledAudioNode::stopStreamThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_streamMutex);
+        m_streamThreadShouldExit = true;
+    }
+    m_streamCondition.notify_one();
+
+    if (m_streamThread.joinable())
+        m_streamThread.join();
+
+    m_streamThreadShouldExit = false;
+}
+
 void SampledAudioNode::reset(ContextRenderLock& r)
 {
     m_virtualReadIndex = 0;
@@ -343,9 +834,18 @@ void SampledAudioNode::reset(ContextRenderLock& r)
 }
 
 bool SampledAudioNode::setBus(ContextRenderLock & r, std::shared_ptr<AudioBus> buffer)
+{
+    return setBus(r, buffer, STORAGE_FLOAT32);
+}
+
+bool SampledAudioNode::setBus(ContextRenderLock & r, std::shared_ptr<AudioBus> buffer, StorageFormat storage)
 {
     ASSERT(r.context());
 
+    m_packedChannels.clear();
+    m_packedLength = 0;
+    m_packedSampleRate = 0;
+
     if (buffer)
     {
         // Do any necesssary re-configuration to the buffer's number of channels.
@@ -355,10 +855,164 @@ bool SampledAudioNode::setBus(ContextRenderLock & r, std::shared_ptr<AudioBus> b
             return false;
 
         output(0)->setNumberOfChannels(r, numberOfChannels);
+
+        if (storage == STORAGE_INT16)
+        {
+            // Quantize each channel and release the float bus; the memory win
+            // is realized once the caller drops its own reference too.
+            size_t length = buffer->length();
+            m_packedChannels.resize(numberOfChannels);
+            for (size_t i = 0; i < numberOfChannels; ++i)
+            {
+                const float * source = buffer->channel(static_cast<unsigned>(i))->data();
+                std::vector<int16_t> & channel = m_packedChannels[i];
+                channel.resize(length);
+                for (size_t k = 0; k < length; ++k)
+                {
+                    float x = std::max(-1.f, std::min(1.f, source[k]));
+                    channel[k] = static_cast<int16_t>(lrintf(x * 32767.f));
+                }
+            }
+            m_packedLength = length;
+            m_packedSampleRate = buffer->sampleRate();
+            buffer.reset();
+        }
     }
 
     m_virtualReadIndex = 0;
     m_sourceBus = buffer;
+
+    // A bus and a stream are mutually exclusive sources.
+    stopStreamThread();
+    m_stream.reset();
+    m_streamRing.clear();
+
+    rebuildLoopCrossfade();
+
+    return true;
+}
+
+void SampledAudioNode::setLoopCrossfade(ContextRenderLock & r, float seconds)
+{
+    ASSERT(r.context());
+    m_loopCrossfadeSeconds = std::max(0.f, seconds);
+    rebuildLoopCrossfade();
+}
+
+void SampledAudioNode::rebuildLoopCrossfade()
+{
+    m_loopTail.clear();
+    m_loopTailFrames = 0;
+
+    bool packed = !m_packedChannels.empty();
+    if (m_loopCrossfadeSeconds <= 0 || (!m_sourceBus && !packed))
+        return;
+
+    size_t bufferLength = sourceLength();
+    double bufferSampleRate = sourceSampleRate();
+    if (!bufferLength || bufferSampleRate <= 0)
+        return;
+
+    // Mirror the loop geometry renderFromBuffer() derives, so the baked
+    // frames compare bit-exact against the values computed at render time.
+    double loopS = loopStart();
+    double loopE = loopEnd();
+    double loopStartFrame = 0;
+    double loopEndFrame = static_cast<double>(bufferLength);
+    if ((loopS || loopE) && loopS >= 0 && loopE > 0 && loopS < loopE)
+    {
+        loopStartFrame = loopS * bufferSampleRate;
+        loopEndFrame = std::min(loopE * bufferSampleRate, loopEndFrame);
+    }
+    if (loopEndFrame <= loopStartFrame)
+        return;
+
+    // The fade-in material is the lead-in just before loopStart; clamp the
+    // crossfade to what exists. A loop starting at the head of the buffer
+    // has no lead-in, so no crossfade.
+    size_t frames = static_cast<size_t>(m_loopCrossfadeSeconds * bufferSampleRate);
+    frames = std::min(frames, static_cast<size_t>(loopStartFrame));
+    frames = std::min(frames, static_cast<size_t>((loopEndFrame - loopStartFrame) * 0.5));
+    if (!frames)
+        return;
+
+    size_t numChannels = packed ? m_packedChannels.size() : m_sourceBus->numberOfChannels();
+    size_t tailStart = static_cast<size_t>(loopEndFrame) - frames;
+
+    auto sampleAt = [&](size_t channel, size_t index) -> float {
+        if (index >= bufferLength)
+            index = bufferLength - 1;
+        if (packed)
+            return m_packedChannels[channel][index] * (1.f / 32767.f);
+        return m_sourceBus->channel(channel)->data()[index];
+    };
+
+    m_loopTail.resize(numChannels);
+    for (size_t c = 0; c < numChannels; ++c)
+    {
+        // One leading and two trailing guard frames keep the cubic taps
+        // inside the segment; the trailing guards are the first frames of
+        // the loop, which is where playback continues after the wrap.
+        std::vector<float> & tail = m_loopTail[c];
+        tail.resize(frames + 3);
+
+        tail[0] = sampleAt(c, tailStart - 1);
+        for (size_t k = 0; k < frames; ++k)
+        {
+            // Equal-power: the two legs of a bed are decorrelated, so a
+            // linear fade would dip in the middle.
+            float t = static_cast<float>(k + 1) / static_cast<float>(frames + 1);
+            float fadeOut = cosf(t * 1.5707963f);
+            float fadeIn = sinf(t * 1.5707963f);
+            float a = sampleAt(c, tailStart + k);
+            float b = sampleAt(c, static_cast<size_t>(loopStartFrame) - frames + k);
+            tail[1 + k] = a * fadeOut + b * fadeIn;
+        }
+        tail[1 + frames] = sampleAt(c, static_cast<size_t>(loopStartFrame));
+        tail[2 + frames] = sampleAt(c, static_cast<size_t>(loopStartFrame) + 1);
+    }
+
+    m_loopTailFrames = frames;
+    m_loopTailEndFrame = loopEndFrame;
+    m_loopTailLoopStartFrame = loopStartFrame;
+}
+
+bool SampledAudioNode::setStream(ContextRenderLock & r, std::shared_ptr<AudioFileStream> stream)
+{
+    ASSERT(r.context());
+
+    stopStreamThread();
+    m_stream.reset();
+    m_streamRing.clear();
+    m_sourceBus.reset();
+    m_packedChannels.clear();
+    m_packedLength = 0;
+    m_packedSampleRate = 0;
+
+    if (stream)
+    {
+        if (!stream->valid())
+            return false;
+
+        size_t numberOfChannels = stream->numberOfChannels();
+        if (!numberOfChannels || numberOfChannels > AudioContext::maxNumberOfChannels)
+            return false;
+
+        output(0)->setNumberOfChannels(r, numberOfChannels);
+
+        m_stream = stream;
+        m_streamRing.assign(numberOfChannels, std::vector<float>(StreamRingFrames, 0.f));
+        m_streamWriteFrame.store(0, std::memory_order_relaxed);
+        m_streamReadFrame.store(0, std::memory_order_relaxed);
+        m_streamEndFrame.store(~0ull, std::memory_order_relaxed);
+        m_streamUnderruns.store(0, std::memory_order_relaxed);
+        m_streamSourceFrame = 0;
+        m_streamFramesToSkip = 0;
+
+        m_streamThread = std::thread(&SampledAudioNode::streamFetchLoop, this);
+    }
+
+    m_virtualReadIndex = 0;
     return true;
 }
 
@@ -375,7 +1029,7 @@ void SampledAudioNode::startGrain(double when, double grainOffset)
 
 void SampledAudioNode::startGrain(double when, double grainOffset, double grainDuration)
 {
-    if (!getBus())
+    if (!getBus() && !m_stream && m_packedChannels.empty())
         return;
 
     m_requestWhen = when;
@@ -388,11 +1042,28 @@ void SampledAudioNode::startGrain(double when, double grainOffset, double grainD
 
 float SampledAudioNode::duration() const
 {
-    auto bus = getBus();
-    if (!bus)
+    if (m_stream)
+        return m_stream->length() / m_stream->sampleRate();
+
+    float sampleRate = sourceSampleRate();
+    if (!sampleRate)
         return 0;
 
-    return bus->length() / bus->sampleRate();
+    return sourceLength() / sampleRate;
+}
+
+float SampledAudioNode::sourceSampleRate() const
+{
+    if (m_sourceBus)
+        return m_sourceBus->sampleRate();
+    return m_packedSampleRate;
+}
+
+size_t SampledAudioNode::sourceLength() const
+{
+    if (m_sourceBus)
+        return m_sourceBus->length();
+    return m_packedLength;
 }
 
 double SampledAudioNode::totalPitchRate(ContextRenderLock & r)
@@ -404,8 +1075,9 @@ double SampledAudioNode::totalPitchRate(ContextRenderLock & r)
     // Incorporate buffer's sample-rate versus AudioContext's sample-rate.
     // Normally it's not an issue because buffers are loaded at the AudioContext's sample-rate, but we can handle it in any case.
     double sampleRateFactor = 1.0;
-    if (getBus())
-        sampleRateFactor = getBus()->sampleRate() / r.context()->sampleRate();
+    float srcSampleRate = sourceSampleRate();
+    if (srcSampleRate)
+        sampleRateFactor = srcSampleRate / r.context()->sampleRate();
 
     double basePitchRate = playbackRate()->value(r);
 
@@ -426,9 +1098,63 @@ double SampledAudioNode::totalPitchRate(ContextRenderLock & r)
     return totalRate;
 }
 
+void SampledAudioNode::advanceParkedPosition(ContextRenderLock & r, size_t numberOfFrames)
+{
+    size_t bufferLength = sourceLength();
+    if (!bufferLength)
+        return;
+
+    double bufferSampleRate = sourceSampleRate();
+
+    // Mirror renderFromBuffer's end-frame and loop-bounds arithmetic.
+    size_t endFrame = m_isGrain ? AudioUtilities::timeToSampleFrame(m_grainOffset + m_grainDuration, bufferSampleRate) : bufferLength;
+    if (m_isGrain)
+        endFrame += 512;
+    if (endFrame > bufferLength)
+        endFrame = bufferLength;
+
+    if (m_virtualReadIndex >= endFrame)
+        m_virtualReadIndex = 0;
+
+    double virtualEndFrame = static_cast<double>(endFrame);
+    double virtualDeltaFrames = virtualEndFrame;
+
+    double loopS = loopStart();
+    double loopE = loopEnd();
+
+    if (loop() && (loopS || loopE) && loopS >= 0 && loopE > 0 && loopS < loopE)
+    {
+        double loopStartFrame = loopS * bufferSampleRate;
+        double loopEndFrame = loopE * bufferSampleRate;
+
+        virtualEndFrame = std::min(loopEndFrame, virtualEndFrame);
+        virtualDeltaFrames = virtualEndFrame - loopStartFrame;
+    }
+
+    if (virtualDeltaFrames <= 0)
+        return;
+
+    double pitchRate = totalPitchRate(r);
+    double virtualReadIndex = m_virtualReadIndex + numberOfFrames * fabs(pitchRate);
+
+    if (loop())
+    {
+        while (virtualReadIndex >= virtualEndFrame)
+            virtualReadIndex -= virtualDeltaFrames;
+    }
+    else if (virtualReadIndex >= virtualEndFrame)
+    {
+        // ran off the end while parked; finish exactly as rendering would
+        virtualReadIndex = virtualEndFrame;
+        finish(r);
+    }
+
+    m_virtualReadIndex = virtualReadIndex;
+}
+
 bool SampledAudioNode::propagatesSilence(ContextRenderLock & r) const
 {
-    return !isPlayingOrScheduled() || hasFinished() || !m_sourceBus;
+    return !isPlayingOrScheduled() || hasFinished() || (!m_sourceBus && !m_stream && m_packedChannels.empty());
 }
 
 void SampledAudioNode::setPannerNode(PannerNode* pannerNode)
@@ -441,6 +1167,16 @@ void SampledAudioNode::clearPannerNode()
     m_pannerNode = 0;
 }
 
+SampledAudioNode::InterpolationMode SampledAudioNode::interpolation() const
+{
+    return static_cast<InterpolationMode>(m_interpolation->valueUint32());
+}
+void SampledAudioNode::setInterpolation(InterpolationMode mode)
+{
+    m_interpolationExplicit = true;
+    m_interpolation->setUint32(static_cast<uint32_t>(mode));
+}
+
 bool SampledAudioNode::loop() const
 {
     return m_isLooping->valueUint32() != 0;
@@ -459,6 +1195,25 @@ double SampledAudioNode::loopEnd() const
 {
     return m_loopEnd->valueFloat();
 }
+void SampledAudioNode::queryMemory(ContextRenderLock & r, MemoryUsage & usage) const
+{
+    AudioNode::queryMemory(r, usage);
+
+    // The source bus may be shared between several players of the same
+    // sample; each referencing node counts it.
+    if (m_sourceBus)
+        usage.sampleBytes += m_sourceBus->memoryBytes();
+
+    for (auto & channel : m_packedChannels)
+        usage.sampleBytes += channel.capacity() * sizeof(int16_t);
+
+    for (auto & ring : m_streamRing)
+        usage.sampleBytes += ring.capacity() * sizeof(float);
+
+    for (auto & tail : m_loopTail)
+        usage.sampleBytes += tail.capacity() * sizeof(float);
+}
+
 void SampledAudioNode::setLoopStart(double loopStart)
 {
     m_loopStart->setFloat(static_cast<float>(loopStart));
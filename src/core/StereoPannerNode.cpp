@@ -16,6 +16,10 @@
 #include "internal/Panner.h"
 #include "internal/AudioUtilities.h"
 #include "internal/Assertions.h"
+#include "internal/EqualPowerTable.h"
+#include "internal/VectorMath.h"
+
+#include <algorithm>
 
 
 namespace lab
@@ -36,6 +40,9 @@ public:
     {
         // Convert smoothing time (50ms) to a per-sample time value.
         m_smoothingConstant = AudioUtilities::discreteTimeConstantForSampleRate(SmoothingTimeConstant, sampleRate);
+
+        // Build the shared gain table now rather than on the render thread.
+        equalPowerSinTable();
     }
 
     virtual ~Spatializer()
@@ -71,31 +78,44 @@ public:
         if (!sourceL || !sourceR || !destinationL || !destinationR)
             return;
 
-        double gainL, gainR, panRadian;
         size_t n = framesToProcess;
 
         // For mono source case.
         if (numberOfInputChannels == Channels::Mono)
         {
-            while (n--)
+            // Resolve the gain curves from the table first, then apply them
+            // with vectorized multiplies; both output channels read the same
+            // source, so the two passes never alias.
+            float gainsL[AudioNode::ProcessingSizeInFrames];
+            float gainsR[AudioNode::ProcessingSizeInFrames];
+
+            while (n)
             {
-                float inputL = *sourceL++;
+                size_t chunk = std::min(n, static_cast<size_t>(AudioNode::ProcessingSizeInFrames));
 
-                m_pan = clampTo(*panValues++, -1.0, 1.0);
+                for (size_t i = 0; i < chunk; ++i)
+                {
+                    m_pan = clampTo(panValues[i], -1.0, 1.0);
 
-                // Pan from left to right [-1; 1] will be normalized as [0; 1].
-                panRadian = (m_pan * 0.5 + 0.5) * piOverTwoDouble;
+                    // Pan from left to right [-1; 1] will be normalized as [0; 1].
+                    equalPowerGains(static_cast<float>(m_pan * 0.5 + 0.5), gainsL[i], gainsR[i]);
+                }
 
-                gainL = std::cos(panRadian);
-                gainR = std::sin(panRadian);
+                VectorMath::vmul(sourceL, 1, gainsL, 1, destinationL, 1, chunk);
+                VectorMath::vmul(sourceL, 1, gainsR, 1, destinationR, 1, chunk);
 
-                *destinationL++ = static_cast<float>(inputL * gainL);
-                *destinationR++ = static_cast<float>(inputL * gainR);
+                sourceL += chunk;
+                destinationL += chunk;
+                destinationR += chunk;
+                panValues += chunk;
+                n -= chunk;
             }
         }
         // For stereo source case.
         else
         {
+            float gainL, gainR;
+
             while (n--)
             {
                 float inputL = *sourceL++;
@@ -104,20 +124,17 @@ public:
                 m_pan = clampTo(*panValues++, -1.0, 1.0);
 
                 // Normalize [-1; 0] to [0; 1]. Do nothing when [0; 1].
-                panRadian = (m_pan <= 0 ? m_pan + 1 : m_pan) * piOverTwoDouble;
-
-                gainL = std::cos(panRadian);
-                gainR = std::sin(panRadian);
+                equalPowerGains(static_cast<float>(m_pan <= 0 ? m_pan + 1 : m_pan), gainL, gainR);
 
                 if (m_pan <= 0)
                 {
-                    *destinationL++ = static_cast<float>(inputL + inputR * gainL);
-                    *destinationR++ = static_cast<float>(inputR * gainR);
+                    *destinationL++ = inputL + inputR * gainL;
+                    *destinationR++ = inputR * gainR;
                 }
                 else
                 {
-                    *destinationL++ = static_cast<float>(inputL * gainL);
-                    *destinationR++ = static_cast<float>(inputR + inputL * gainR);
+                    *destinationL++ = inputL * gainL;
+                    *destinationR++ = inputR + inputL * gainR;
                 }
             }
         }
@@ -161,33 +178,44 @@ public:
             m_pan = targetPan;
         }
 
-        double gainL, gainR, panRadian;
         const double smoothingConstant = m_smoothingConstant;
         size_t n = framesToProcess;
 
         // For mono source case.
         if (numberOfInputChannels == Channels::Mono)
         {
-            while (n--)
+            // The de-zipper recurrence is serial, but once the trig becomes a
+            // table lookup the gain curves are cheap to fill; the multiplies
+            // are then applied vectorized as in the sample-accurate path.
+            float gainsL[AudioNode::ProcessingSizeInFrames];
+            float gainsR[AudioNode::ProcessingSizeInFrames];
+
+            while (n)
             {
-                float inputL = *sourceL++;
+                size_t chunk = std::min(n, static_cast<size_t>(AudioNode::ProcessingSizeInFrames));
 
-                m_pan += (targetPan - m_pan) * smoothingConstant;
+                for (size_t i = 0; i < chunk; ++i)
+                {
+                    m_pan += (targetPan - m_pan) * smoothingConstant;
 
-                // Pan from left to right [-1; 1] will be normalized as [0; 1].
-                panRadian = (m_pan * 0.5 + 0.5) * piOverTwoDouble;
+                    // Pan from left to right [-1; 1] will be normalized as [0; 1].
+                    equalPowerGains(static_cast<float>(m_pan * 0.5 + 0.5), gainsL[i], gainsR[i]);
+                }
 
-                gainL = std::cos(panRadian);
-                gainR = std::sin(panRadian);
+                VectorMath::vmul(sourceL, 1, gainsL, 1, destinationL, 1, chunk);
+                VectorMath::vmul(sourceL, 1, gainsR, 1, destinationR, 1, chunk);
 
-                *destinationL++ = static_cast<float>(inputL * gainL);
-                *destinationR++ = static_cast<float>(inputL * gainR);
+                sourceL += chunk;
+                destinationL += chunk;
+                destinationR += chunk;
+                n -= chunk;
             }
-
         }
         // For stereo source case.
         else
         {
+            float gainL, gainR;
+
             while (n--) {
                 float inputL = *sourceL++;
                 float inputR = *sourceR++;
@@ -197,10 +225,7 @@ public:
                 // Normalize [-1; 0] to [0; 1] for the left pan position (<= 0), and
                 // do nothing when [0; 1].
 
-                panRadian = (m_pan <= 0 ? m_pan + 1 : m_pan) * piOverTwoDouble;
-
-                gainL = std::cos(panRadian);
-                gainR = std::sin(panRadian);
+                equalPowerGains(static_cast<float>(m_pan <= 0 ? m_pan + 1 : m_pan), gainL, gainR);
 
                 // The pan value should be checked every sample when de-zippering.
                 // See crbug.com/470559.
@@ -208,15 +233,15 @@ public:
                 {
                     // When [-1; 0], keep left channel intact and equal-power pan the
                     // right channel only.
-                    *destinationL++ = static_cast<float>(inputL + inputR * gainL);
-                    *destinationR++ = static_cast<float>(inputR * gainR);
+                    *destinationL++ = inputL + inputR * gainL;
+                    *destinationR++ = inputR * gainR;
                 }
                 else
                 {
                     // When [0; 1], keep right channel intact and equal-power pan the
                     // left channel only.
-                    *destinationL++ = static_cast<float>(inputL * gainL);
-                    *destinationR++ = static_cast<float>(inputR + inputL * gainR);
+                    *destinationL++ = inputL * gainL;
+                    *destinationR++ = inputR + inputL * gainR;
                 }
             }
         }
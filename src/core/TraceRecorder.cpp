@@ -0,0 +1,165 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/core/TraceRecorder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace lab
+{
+
+namespace
+{
+    // Recovers an unqualified class name from a raw typeid name, mirroring
+    // the naming GraphSnapshot uses: the Itanium ABI mangles lab::GainNode
+    // as "N3lab8GainNodeE" (length-prefixed nested components, keep the
+    // last), MSVC returns "class lab::GainNode" (keep past the final colon).
+    std::string demangledName(const char * raw)
+    {
+        std::string s = raw ? raw : "";
+
+        if (s.size() > 2 && s[0] == 'N')
+        {
+            size_t pos = 1;
+            std::string component;
+            while (pos < s.size() && s[pos] >= '0' && s[pos] <= '9')
+            {
+                size_t length = 0;
+                while (pos < s.size() && s[pos] >= '0' && s[pos] <= '9')
+                    length = length * 10 + (s[pos++] - '0');
+                if (pos + length > s.size())
+                    break;
+                component = s.substr(pos, length);
+                pos += length;
+            }
+            if (!component.empty())
+                return component;
+        }
+
+        size_t colon = s.rfind(':');
+        if (colon != std::string::npos)
+            return s.substr(colon + 1);
+        return s;
+    }
+
+    const char * categoryName(TraceRecorder::Category category)
+    {
+        switch (category)
+        {
+            case TraceRecorder::Category::Quantum: return "quantum";
+            case TraceRecorder::Category::Node: return "node";
+            case TraceRecorder::Category::Worker: return "worker";
+            case TraceRecorder::Category::Decode: return "decode";
+        }
+        return "unknown";
+    }
+
+    uint64_t currentThreadId()
+    {
+        // Hashing a thread::id is not free; cache it per thread.
+        static thread_local uint64_t tid =
+            std::hash<std::thread::id>()(std::this_thread::get_id());
+        return tid;
+    }
+}
+
+TraceRecorder & TraceRecorder::instance()
+{
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+void TraceRecorder::enable(size_t capacityEvents)
+{
+    // The queue is allocated once and kept: producers hold no lock, so it
+    // can never be safely replaced while they might be mid-push. A larger
+    // capacity on a later enable is ignored.
+    if (!m_queue)
+        m_queue.reset(new mpsc_queue<Event>(capacityEvents));
+    m_epoch = std::chrono::high_resolution_clock::now();
+    m_dropped.store(0, std::memory_order_relaxed);
+    m_enabled.store(true, std::memory_order_release);
+}
+
+void TraceRecorder::disable()
+{
+    m_enabled.store(false, std::memory_order_release);
+}
+
+void TraceRecorder::record(Category category, const char * name, uint64_t id,
+                           std::chrono::high_resolution_clock::time_point begin,
+                           std::chrono::high_resolution_clock::time_point end)
+{
+    if (!m_enabled.load(std::memory_order_relaxed) || !m_queue)
+        return;
+
+    Event event;
+    event.name = name;
+    event.id = id;
+    event.startMicroseconds = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(begin - m_epoch).count());
+    event.durationMicroseconds = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count());
+    event.threadId = currentThreadId();
+    event.category = category;
+
+    if (!m_queue->try_push(event))
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::string TraceRecorder::json()
+{
+    std::vector<Event> events;
+    if (m_queue)
+    {
+        Event event;
+        while (m_queue->try_pop(event))
+            events.push_back(event);
+    }
+
+    // The queue interleaves threads in publication order; the viewer wants
+    // begin-time order.
+    std::sort(events.begin(), events.end(),
+              [](const Event & a, const Event & b) { return a.startMicroseconds < b.startMicroseconds; });
+
+    std::string out;
+    out.reserve(events.size() * 128 + 64);
+    out += "{\"traceEvents\":[";
+
+    char line[256];
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        const Event & e = events[i];
+        std::string name = e.category == Category::Node ? demangledName(e.name)
+                                                        : std::string(e.name ? e.name : "");
+        snprintf(line, sizeof(line),
+                 "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,"
+                 "\"pid\":1,\"tid\":%llu,\"args\":{\"id\":%llu}}",
+                 i ? "," : "", name.c_str(), categoryName(e.category),
+                 (unsigned long long) e.startMicroseconds,
+                 (unsigned long long) e.durationMicroseconds,
+                 (unsigned long long) (e.threadId & 0xffffffffull),
+                 (unsigned long long) e.id);
+        out += line;
+    }
+
+    out += "\n]}\n";
+    return out;
+}
+
+bool TraceRecorder::writeJson(const std::string & path)
+{
+    FILE * f = fopen(path.c_str(), "wb");
+    if (!f)
+        return false;
+    std::string doc = json();
+    size_t written = fwrite(doc.data(), 1, doc.size(), f);
+    fclose(f);
+    return written == doc.size();
+}
+
+} // namespace lab
@@ -5,6 +5,8 @@
 #include "LabSound/core/WaveShaperNode.h"
 #include "internal/WaveShaperProcessor.h"
 
+#include <stdexcept>
+
 namespace lab
 {
 
@@ -19,6 +21,19 @@ void WaveShaperNode::setCurve(std::vector<float> && curve)
     waveShaperProcessor()->setCurve(std::move(curve));
 }
 
+void WaveShaperNode::setOversample(int oversample)
+{
+    if (oversample != 1 && oversample != 2 && oversample != 4)
+        throw std::out_of_range("oversample must be 1, 2 or 4");
+
+    waveShaperProcessor()->setOversample(oversample);
+}
+
+int WaveShaperNode::oversample() const
+{
+    return static_cast<WaveShaperProcessor *>(m_processor.get())->oversample();
+}
+
 #if 0
 std::vector<float> & WaveShaperNode::curve()
 {
@@ -7,13 +7,20 @@
 #include "LabSound/core/AudioArray.h"
 
 #include "internal/Assertions.h"
+#include "internal/ConvolutionWorkerPool.h"
 #include "internal/FFTFrame.h"
 #include "internal/VectorMath.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <iostream>
 #include <exception>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
 
 // The number of bands per octave.  Each octave will have this many entries in the wave tables.
 const unsigned kNumberOfOctaveBands = 3;
@@ -73,6 +80,83 @@ WaveTable::~WaveTable()
 
 }
 
+std::shared_ptr<WaveTable> WaveTable::standardWaveTable(const float sampleRate, OscillatorType basicWaveform)
+{
+    // Process-wide bank shared by every context. Building a table runs dozens of
+    // inverse FFTs, so short-lived oscillators must not re-derive identical data.
+    static std::mutex bankMutex;
+    static std::map<std::pair<uint32_t, float>, std::shared_ptr<WaveTable>> bank;
+
+    std::lock_guard<std::mutex> lock(bankMutex);
+
+    auto key = std::make_pair(static_cast<uint32_t>(basicWaveform), sampleRate);
+    auto it = bank.find(key);
+    if (it != bank.end())
+        return it->second;
+
+    auto table = std::make_shared<WaveTable>(sampleRate, basicWaveform);
+    bank[key] = table;
+    return table;
+}
+
+void WaveTable::prewarmStandardTables(const float sampleRate)
+{
+    // Build the full standard bank up front so the first oscillator created at
+    // this sample rate finds its tables already in the bank instead of paying
+    // for dozens of inverse FFTs on first sound.
+    standardWaveTable(sampleRate, OscillatorType::SINE);
+    standardWaveTable(sampleRate, OscillatorType::SQUARE);
+    standardWaveTable(sampleRate, OscillatorType::SAWTOOTH);
+    standardWaveTable(sampleRate, OscillatorType::TRIANGLE);
+}
+
+std::shared_ptr<WaveTable::CustomBuild> WaveTable::customWaveTable(const float sampleRate,
+                                                                  const std::vector<float> & real,
+                                                                  const std::vector<float> & imag)
+{
+    if (real.empty() || real.size() != imag.size())
+        return {};
+
+    // Process-wide bank like standardWaveTable's, but keyed by a hash of the
+    // spectrum so identical preset data builds the mipmap exactly once no
+    // matter how many oscillators request it.
+    static std::mutex bankMutex;
+    static std::map<uint64_t, std::shared_ptr<CustomBuild>> bank;
+
+    // FNV-1a over the sample rate and both coefficient arrays.
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const float * data, size_t count) {
+        const unsigned char * bytes = reinterpret_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < count * sizeof(float); ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    mix(&sampleRate, 1);
+    mix(real.data(), real.size());
+    mix(imag.data(), imag.size());
+
+    std::lock_guard<std::mutex> lock(bankMutex);
+
+    auto it = bank.find(hash);
+    if (it != bank.end())
+        return it->second;
+
+    auto build = std::make_shared<CustomBuild>();
+    bank[hash] = build;
+
+    // The worker owns copies of the coefficients; the caller's vectors are
+    // free to go away as soon as this returns.
+    ConvolutionWorkerPool::shared().enqueueTask(
+        [build, sampleRate, realCopy = real, imagCopy = imag]() mutable {
+            auto table = std::make_shared<WaveTable>(sampleRate, OscillatorType::CUSTOM, realCopy, imagCopy);
+            std::atomic_store(&build->m_table, std::shared_ptr<WaveTable>(table));
+        });
+
+    return build;
+}
+
 unsigned WaveTable::periodicWaveSize() const
 {
     // Choose an appropriate wave size for the given sample rate.  This allows us to use shorter
@@ -85,7 +169,7 @@ unsigned WaveTable::periodicWaveSize() const
     return kMaxPeriodicWaveSize;
 }
     
-void WaveTable::waveDataForFundamentalFrequency(float fundamentalFrequency, float* &lowerWaveData, float* &higherWaveData, float& tableInterpolationFactor)
+float WaveTable::pitchRangeForFundamentalFrequency(float fundamentalFrequency) const
 {
     // Negative frequencies are allowed, in which case we alias to the positive frequency.
     fundamentalFrequency = std::abs(fundamentalFrequency);
@@ -100,6 +184,13 @@ void WaveTable::waveDataForFundamentalFrequency(float fundamentalFrequency, floa
     pitchRange = std::max(pitchRange, 0.0f);
     pitchRange = std::min(pitchRange, static_cast<float>(numberOfRanges() - 1));
 
+    return pitchRange;
+}
+
+void WaveTable::waveDataForFundamentalFrequency(float fundamentalFrequency, float* &lowerWaveData, float* &higherWaveData, float& tableInterpolationFactor)
+{
+    float pitchRange = pitchRangeForFundamentalFrequency(fundamentalFrequency);
+
     // The words "lower" and "higher" refer to the table data having the lower and higher numbers of partials.
     // It's a little confusing since the range index gets larger the more partials we cull out.
     // So the lower table data will have a larger range index.
@@ -113,6 +204,23 @@ void WaveTable::waveDataForFundamentalFrequency(float fundamentalFrequency, floa
     tableInterpolationFactor = pitchRange - rangeIndex1;
 }
 
+const float* WaveTable::interleavedWaveDataForFundamentalFrequency(float fundamentalFrequency, float& tableInterpolationFactor)
+{
+    float pitchRange = pitchRangeForFundamentalFrequency(fundamentalFrequency);
+
+    // Pair i interleaves range tables i and i+1. The top range has no pair of its
+    // own; selecting the last pair with an interpolation factor of 1 is equivalent
+    // to the non-interleaved path returning the same table twice with factor 0.
+    unsigned pairIndex = static_cast<unsigned>(pitchRange);
+    unsigned lastPair = static_cast<unsigned>(numberOfRanges()) - 2;
+    if (pairIndex > lastPair)
+        pairIndex = lastPair;
+
+    tableInterpolationFactor = pitchRange - pairIndex;
+
+    return m_interleavedPairs[pairIndex]->data();
+}
+
 size_t WaveTable::maxNumberOfPartials() const
 {
     return periodicWaveSize() / 2;
@@ -137,20 +245,24 @@ size_t WaveTable::numberOfPartialsForRange(size_t rangeIndex) const
 // Thus, higher ranges have more high-frequency partials culled out.
 void WaveTable::createBandLimitedTables(const float* realData, const float* imagData, size_t numberOfComponents)
 {
-    float normalizationScale = 1.f;
-
     size_t fftSize = periodicWaveSize();
     size_t halfSize = fftSize / 2 + 1;
     size_t i;
-    
+
     numberOfComponents = std::min(numberOfComponents, halfSize);
 
-    m_bandLimitedTables.reserve(numberOfRanges());
+    size_t ranges = numberOfRanges();
+    m_bandLimitedTables.resize(ranges);
+
+    // Each range is an independent cull + inverse FFT writing its own table
+    // slot, so the ranges fan out across a transient team of threads and the
+    // bank is ready in roughly the time of the slowest single FFT instead of
+    // the sum of all of them. Normalization depends on the first range's
+    // peak, so it is applied in a second pass below.
+    auto buildRange = [&](size_t rangeIndex) {
 
-    for (size_t rangeIndex = 0; rangeIndex < numberOfRanges(); ++rangeIndex) {
-        
         // This FFTFrame is used to cull partials (represented by frequency bins).
-        FFTFrame frame(fftSize);
+        FFTFrame frame((uint32_t) fftSize);
         float* realP = frame.realData();
         float* imagP = frame.imagData();
 
@@ -167,34 +279,74 @@ void WaveTable::createBandLimitedTables(const float* realData, const float* imag
 
         // If fewer components were provided than 1/2 FFT size, then clear the remaining bins.
         // We also need to cull the aliasing partials for this pitch range.
-        for (i = std::min(numberOfComponents, numberOfPartials + 1); i < halfSize; ++i) {
-            realP[i] = 0;
-            imagP[i] = 0;
+        for (size_t bin = std::min(numberOfComponents, numberOfPartials + 1); bin < halfSize; ++bin) {
+            realP[bin] = 0;
+            imagP[bin] = 0;
         }
-        
+
         // Clear packed-nyquist and any DC-offset.
         realP[0] = 0;
         imagP[0] = 0;
 
         // Create the band-limited table.
-        m_bandLimitedTables.push_back(std::unique_ptr<lab::AudioFloatArray>(new lab::AudioFloatArray(periodicWaveSize())));
+        m_bandLimitedTables[rangeIndex].reset(new lab::AudioFloatArray((unsigned) fftSize));
 
         // Apply an inverse FFT to generate the time-domain table data.
-        float* data = m_bandLimitedTables[rangeIndex]->data();
-        frame.doInverseFFT(data);
-
-        // For the first range (which has the highest power), calculate its peak value then compute normalization scale.
-        if (!rangeIndex) {
-            float maxValue;
-            vmaxmgv(data, 1, &maxValue, fftSize);
+        frame.doInverseFFT(m_bandLimitedTables[rangeIndex]->data());
+    };
+
+    size_t threadCount = std::thread::hardware_concurrency();
+    if (threadCount > ranges)
+        threadCount = ranges;
+
+    if (threadCount > 1) {
+        std::atomic<size_t> nextRange{0};
+        std::vector<std::thread> team;
+        team.reserve(threadCount);
+        for (size_t t = 0; t < threadCount; ++t)
+            team.emplace_back([&] {
+                for (size_t rangeIndex = nextRange.fetch_add(1); rangeIndex < ranges; rangeIndex = nextRange.fetch_add(1))
+                    buildRange(rangeIndex);
+            });
+        for (auto & worker : team)
+            worker.join();
+    }
+    else {
+        for (size_t rangeIndex = 0; rangeIndex < ranges; ++rangeIndex)
+            buildRange(rangeIndex);
+    }
 
-            if (maxValue)
-                normalizationScale = 1.0f / maxValue;
-        }
+    // The first range has the highest power; its peak sets the normalization
+    // scale applied to every table, exactly as the serial loop did.
+    float normalizationScale = 1.f;
+    {
+        float maxValue;
+        vmaxmgv(m_bandLimitedTables[0]->data(), 1, &maxValue, fftSize);
+        if (maxValue)
+            normalizationScale = 1.0f / maxValue;
+    }
 
-        // Apply normalization scale.
+    for (size_t rangeIndex = 0; rangeIndex < ranges; ++rangeIndex) {
+        float* data = m_bandLimitedTables[rangeIndex]->data();
         vsmul(data, 1, &normalizationScale, data, 1, fftSize);
     }
+
+    // Interleave each adjacent pair of range tables into a single allocation. The
+    // oscillator reads four samples per output frame (two read indices from two
+    // tables); with this layout they come from two neighbouring locations.
+    size_t tableSize = periodicWaveSize();
+    m_interleavedPairs.reserve(numberOfRanges() - 1);
+    for (size_t rangeIndex = 0; rangeIndex + 1 < numberOfRanges(); ++rangeIndex) {
+        std::unique_ptr<lab::AudioFloatArray> pair(new lab::AudioFloatArray(2 * tableSize));
+        float* pairData = pair->data();
+        const float* higher = m_bandLimitedTables[rangeIndex]->data();
+        const float* lower = m_bandLimitedTables[rangeIndex + 1]->data();
+        for (i = 0; i < tableSize; ++i) {
+            pairData[2 * i] = higher[i];
+            pairData[2 * i + 1] = lower[i];
+        }
+        m_interleavedPairs.push_back(std::move(pair));
+    }
 }
 
 void WaveTable::generateBasicWaveform(OscillatorType shape)
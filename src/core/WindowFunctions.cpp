@@ -0,0 +1,131 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/core/WindowFunctions.h"
+
+#include "internal/VectorMath.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace lab {
+
+namespace {
+
+    // Fills table[0..n) with the window coefficients; the formulas match what
+    // applyWindow historically multiplied in per sample.
+    void buildWindowTable(WindowType wType, float * table, int bSize)
+    {
+        switch (wType) {
+
+            case window_rectangle: {
+                for (int i = 0; i < bSize; i++) {
+                    table[i] = 0.5f;
+                }
+            }
+            break;
+
+            case window_hamming: {
+                for (int i = 0; i < bSize; i++) {
+                    table[i] = 0.54f - 0.46f * cos(TwoPi * i / (bSize));
+                }
+            }
+            break;
+
+            case window_hanning: {
+                for (int i = 0; i < bSize; i++) {
+                    table[i] = 0.5f - (0.5f * cos(TwoPi * i / (bSize)));
+                }
+            }
+            break;
+
+            case window_hanningz: {
+                for (int i = 0; i < bSize; i++) {
+                    table[i] = 0.5f * (1.0f - cos(TwoPi * i / (bSize)));
+                }
+            }
+            break;
+
+            case window_blackman: {
+                for (int i = 0; i < bSize; i++) {
+                    table[i] = 0.42f - 0.50f * cos(TwoPi * i / (bSize - 1.0f)) + 0.08f * cos(4.0f * TwoPi * i / (bSize - 1.0f));
+                }
+            }
+            break;
+
+            case window_blackman_harris: {
+                for (int i = 0; i < bSize; i++) {
+                    table[i] = 0.35875f - 0.48829f * cos(TwoPi * i / (bSize - 1.0f)) + 0.14128f * cos(2.0f * TwoPi * i / (bSize - 1.0f)) - 0.01168f * cos(3.0f * TwoPi * i / (bSize - 1.0f));
+                }
+            }
+            break;
+
+            case window_gaussian: {
+                float a, b, c = 0.5;
+                int n;
+                for (n = 0; n < bSize; n++) {
+                    a = (n - c * (bSize - 1)) / (sqrt(c) * (bSize - 1));
+                    b = -c * sqrt(a);
+                    table[n] = exp(b);
+                }
+            }
+            break;
+
+            case window_welch: {
+                for (int i = 0; i < bSize; i++) {
+                    table[i] = 1.0f - sqrt((2.0f * i - bSize) / (bSize + 1.0f));
+                }
+            }
+            break;
+
+            case window_bartlett: {
+                for (int i = 0; i < bSize; i++) {
+                    table[i] = 1.0f - std::abs(2.0f * (i / bSize) - 1.0f);
+                }
+            }
+            break;
+
+            case window_parzen: {
+                for (int i = 0; i < bSize; i++) {
+                    table[i] = 1.0f - std::abs((2.0f * i - bSize) / (bSize + 1.0f));
+                }
+            }
+            break;
+
+        }
+    }
+
+} // namespace
+
+const AudioFloatArray& windowFunctionTable(WindowType type, size_t size)
+{
+    // Tables are built under the lock and never evicted, so the returned
+    // reference stays valid; subsequent lookups of the same (type, size) are
+    // a map find.
+    static std::mutex s_tableMutex;
+    static std::map<uint64_t, std::unique_ptr<AudioFloatArray>> s_tables;
+
+    uint64_t key = (uint64_t(type) << 32) | uint64_t(size);
+
+    std::lock_guard<std::mutex> lock(s_tableMutex);
+    auto it = s_tables.find(key);
+    if (it == s_tables.end())
+    {
+        std::unique_ptr<AudioFloatArray> table(new AudioFloatArray(size));
+        buildWindowTable(type, table->data(), static_cast<int>(size));
+        it = s_tables.emplace(key, std::move(table)).first;
+    }
+    return *it->second;
+}
+
+void applyWindowTable(WindowType type, float* p, size_t n)
+{
+    if (!n)
+        return;
+
+    const AudioFloatArray& table = windowFunctionTable(type, n);
+    VectorMath::vmul(p, 1, table.data(), 1, p, 1, n);
+}
+
+} // End namespace lab
@@ -10,12 +10,42 @@
 
 #include "internal/VectorMath.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
 #include <limits>
 
 using namespace lab;
 
 namespace lab
 {
+    namespace
+    {
+        // Writes start + increment, start + 2*increment, ... - one envelope
+        // segment as a straight ramp, no per-sample stage branching.
+        void rampFill(float * dest, float start, float increment, size_t n)
+        {
+            size_t i = 0;
+#ifdef __SSE2__
+            __m128 g = _mm_setr_ps(start + increment, start + 2 * increment, start + 3 * increment, start + 4 * increment);
+            __m128 step = _mm_set1_ps(4 * increment);
+            size_t n4 = n & ~size_t(3);
+            for (; i < n4; i += 4)
+            {
+                _mm_storeu_ps(dest + i, g);
+                g = _mm_add_ps(g, step);
+            }
+            start += increment * i;
+#endif
+            for (; i < n; ++i)
+            {
+                start += increment;
+                dest[i] = start;
+            }
+        }
+    }
     /////////////////////////////////////
     // Private ADSRNode Implementation //
     /////////////////////////////////////
@@ -85,40 +115,30 @@ namespace lab
 
             float s = m_sustainLevel->value(r);
 
-            for (size_t i = 0; i < framesToProcess; ++i)
+            // The gate handlers above compiled the envelope into
+            // (value, increment, length) segments; emit each stage that is
+            // active this quantum as one vectorized ramp, then hold.
+            size_t i = 0;
+            auto emitSegment = [&](int & steps, float stepSize)
             {
-                if (m_zeroSteps > 0)
-                {
-                    --m_zeroSteps;
-                    m_currentGain += m_zeroStepSize;
-                    gainValues[i] = m_currentGain;
-                }
-
-                else if (m_attackSteps > 0)
-                {
-                    --m_attackSteps;
-                    m_currentGain += m_attackStepSize;
-                    gainValues[i] = m_currentGain;
-                }
-
-                else if (m_decaySteps > 0)
-                {
-                    --m_decaySteps;
-                    m_currentGain += m_decayStepSize;
-                    gainValues[i] = m_currentGain;
-                }
-
-                else if (m_releaseSteps > 0)
-                {
-                    --m_releaseSteps;
-                    m_currentGain += m_releaseStepSize;
-                    gainValues[i] = m_currentGain;
-                }
-                else
-                {
-                    m_currentGain = (m_noteOffTime == std::numeric_limits<double>::max()) ? s : 0;
-                    gainValues[i] = m_currentGain;
-                }
+                if (steps <= 0 || i >= framesToProcess)
+                    return;
+                size_t n = std::min(static_cast<size_t>(steps), framesToProcess - i);
+                rampFill(&gainValues[i], m_currentGain, stepSize, n);
+                m_currentGain += stepSize * n;
+                steps -= static_cast<int>(n);
+                i += n;
+            };
+
+            emitSegment(m_zeroSteps, m_zeroStepSize);
+            emitSegment(m_attackSteps, m_attackStepSize);
+            emitSegment(m_decaySteps, m_decayStepSize);
+            emitSegment(m_releaseSteps, m_releaseStepSize);
+
+            if (i < framesToProcess)
+            {
+                m_currentGain = (m_noteOffTime == std::numeric_limits<double>::max()) ? s : 0;
+                std::fill(gainValues.begin() + i, gainValues.begin() + framesToProcess, m_currentGain);
             }
 
             size_t numChannels = numberOfChannels();
@@ -156,17 +176,17 @@ namespace lab
             }
         }
 
-        int m_zeroSteps;
-        float m_zeroStepSize;
+        int m_zeroSteps = 0;
+        float m_zeroStepSize = 0;
 
-        int m_attackSteps;
-        float m_attackStepSize;
+        int m_attackSteps = 0;
+        float m_attackStepSize = 0;
 
-        int m_decaySteps;
-        float m_decayStepSize;
+        int m_decaySteps = 0;
+        float m_decayStepSize = 0;
 
-        int m_releaseSteps;
-        float m_releaseStepSize;
+        int m_releaseSteps = 0;
+        float m_releaseStepSize = 0;
 
         double m_noteOnTime;
 
@@ -221,6 +241,22 @@ namespace lab
         internalNode->noteOff(r, when);
     }
 
+    void ADSRNode::noteOnBatch(const std::vector<ADSRNode *> & group, double when)
+    {
+        // one shared gate time for the whole chord; each envelope compiles
+        // its segments from it on the next quantum
+        for (ADSRNode * node : group)
+            if (node)
+                node->internalNode->noteOn(when);
+    }
+
+    void ADSRNode::noteOffBatch(ContextRenderLock & r, const std::vector<ADSRNode *> & group, double when)
+    {
+        for (ADSRNode * node : group)
+            if (node)
+                node->internalNode->noteOff(r, when);
+    }
+
     std::shared_ptr<AudioParam> ADSRNode::attackTime() const
     {
         return internalNode->m_attackTime;
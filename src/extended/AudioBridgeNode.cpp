@@ -0,0 +1,139 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/AudioBridgeNode.h"
+
+#include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioNodeOutput.h"
+#include "LabSound/extended/AudioContextLock.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace lab
+{
+    AudioBridgeNode::AudioBridgeNode(size_t numberOfChannels, size_t bufferCount)
+    {
+        if (!numberOfChannels || numberOfChannels > 8)
+            throw std::invalid_argument("AudioBridgeNode: unsupported channel count");
+
+        m_channelCount = numberOfChannels;
+        m_bufferCount = bufferCount < 2 ? 2 : (bufferCount > 8 ? 8 : bufferCount);
+
+        const size_t quantum = AudioNode::ProcessingSizeInFrames;
+
+        m_storage.reset(new float[m_bufferCount * m_channelCount * quantum]());
+        m_channelPointers.reset(new float *[m_bufferCount * m_channelCount]);
+        for (size_t b = 0; b < m_bufferCount; ++b)
+            for (size_t c = 0; c < m_channelCount; ++c)
+                m_channelPointers[b * m_channelCount + c] = m_storage.get() + (b * m_channelCount + c) * quantum;
+
+        // The bus points here on underrun so silence never aliases a buffer
+        // the producer may already own again.
+        m_silence.reset(new float[m_channelCount * quantum]());
+
+        addOutput(std::unique_ptr<AudioNodeOutput>(new AudioNodeOutput(this, int(numberOfChannels))));
+
+        initialize();
+    }
+
+    AudioBridgeNode::~AudioBridgeNode()
+    {
+        uninitialize();
+    }
+
+    size_t AudioBridgeNode::framesPerBuffer() const
+    {
+        return AudioNode::ProcessingSizeInFrames;
+    }
+
+    float * const * AudioBridgeNode::beginWrite()
+    {
+        uint64_t published = m_published.load(std::memory_order_relaxed);
+        uint64_t consumed = m_consumed.load(std::memory_order_acquire);
+
+        // The slot one past the render thread's held buffer is still being
+        // read downstream, so the producer may run at most bufferCount - 1
+        // buffers ahead.
+        if (published - consumed >= m_bufferCount - 1)
+        {
+            m_overruns.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        m_writeOpen = true;
+        return &m_channelPointers[(published % m_bufferCount) * m_channelCount];
+    }
+
+    void AudioBridgeNode::publish()
+    {
+        if (!m_writeOpen)
+            return;
+        m_writeOpen = false;
+        m_published.fetch_add(1, std::memory_order_release);
+    }
+
+    void AudioBridgeNode::resetCounters()
+    {
+        m_underruns.store(0, std::memory_order_relaxed);
+        m_overruns.store(0, std::memory_order_relaxed);
+    }
+
+    void AudioBridgeNode::process(ContextRenderLock & r, size_t framesToProcess)
+    {
+        AudioBus * outputBus = output(0)->bus(r);
+        if (!outputBus)
+            return;
+
+        const size_t quantum = AudioNode::ProcessingSizeInFrames;
+        size_t busChannels = outputBus->numberOfChannels();
+
+        // Recycle the buffer rendered last quantum; downstream is done with it.
+        if (m_holdingSlot)
+        {
+            m_holdingSlot = false;
+            m_consumed.fetch_add(1, std::memory_order_release);
+        }
+
+        uint64_t consumed = m_consumed.load(std::memory_order_relaxed);
+        uint64_t published = m_published.load(std::memory_order_acquire);
+
+        // The bridge is quantum-aligned by contract; partial quanta (offline
+        // tails) and empty rings render silence from the dedicated buffer.
+        if (published == consumed || framesToProcess != quantum)
+        {
+            if (published == consumed)
+                m_underruns.fetch_add(1, std::memory_order_relaxed);
+
+            for (size_t c = 0; c < busChannels; ++c)
+            {
+                size_t sourceChannel = c < m_channelCount ? c : m_channelCount - 1;
+                outputBus->channel(c)->set(m_silence.get() + sourceChannel * quantum, framesToProcess);
+                outputBus->channel(c)->zero();
+            }
+            return;
+        }
+
+        float * const * channels = &m_channelPointers[(consumed % m_bufferCount) * m_channelCount];
+        for (size_t c = 0; c < busChannels; ++c)
+        {
+            // A mono bridge feeding a wider bus duplicates its channel.
+            size_t sourceChannel = c < m_channelCount ? c : m_channelCount - 1;
+            outputBus->channel(c)->set(channels[sourceChannel], framesToProcess);
+        }
+
+        m_holdingSlot = true;
+    }
+
+    void AudioBridgeNode::reset(ContextRenderLock & r)
+    {
+        // Drop everything published but not yet rendered. The producer-side
+        // state is untouched; it simply finds more free buffers.
+        if (m_holdingSlot)
+        {
+            m_holdingSlot = false;
+            m_consumed.fetch_add(1, std::memory_order_release);
+        }
+        m_consumed.store(m_published.load(std::memory_order_acquire), std::memory_order_release);
+    }
+}
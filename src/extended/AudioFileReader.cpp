@@ -6,13 +6,27 @@
 #include "LabSound/core/Macros.h"
 #include "LabSound/core/AudioBus.h"
 #include "LabSound/core/Mixing.h"
+#include "LabSound/core/TraceRecorder.h"
 
 #include "LabSound/extended/AudioFileReader.h"
 
 #include "libnyquist/Decoders.h"
 
-#include <mutex>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#if defined(LABSOUND_PLATFORM_WINDOWS)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace detail
 {
@@ -24,35 +38,39 @@ namespace detail
         size_t length = int(numSamples / audioData->channelCount);
         const size_t busChannelCount = mixToMono ? 1 : (audioData->channelCount);
 
-        std::vector<float> planarSamples(numSamples);
-
         // Create AudioBus where we'll put the PCM audio data
         std::shared_ptr<lab::AudioBus> audioBus(new lab::AudioBus(busChannelCount, length));
         audioBus->setSampleRate((float) audioData->sampleRate);
 
-        // Deinterleave stereo into LabSound/WebAudio planar channel layout
-        nqr::DeinterleaveChannels(audioData->samples.data(), planarSamples.data(), length, audioData->channelCount, length);
+        const float * interleaved = audioData->samples.data();
 
-        // Mix to mono if stereo -- easier to do in place instead of using libnyquist helper functions
-        // because we've already deinterleaved
         if (audioData->channelCount == lab::Channels::Stereo && mixToMono)
         {
+            // Fold the stereo pair to mono in a single pass over the
+            // interleaved samples, with no intermediate planar buffer.
             float * destinationMono = audioBus->channel(0)->mutableData();
-            float * leftSamples = planarSamples.data();
-            float * rightSamples = planarSamples.data() + length;
-
             for (size_t i = 0; i < length; i++)
             {
-                destinationMono[i] = 0.5f * (leftSamples[i] + rightSamples[i]);
+                destinationMono[i] = 0.5f * (interleaved[2 * i] + interleaved[2 * i + 1]);
             }
         }
-        else
+        else if (mixToMono && audioData->channelCount > 1)
         {
-            for (size_t i = 0; i < busChannelCount; ++i)
+            // As before, multichannel sources asked for as mono keep just
+            // their first channel.
+            const size_t channelCount = audioData->channelCount;
+            float * destinationMono = audioBus->channel(0)->mutableData();
+            for (size_t i = 0; i < length; i++)
             {
-                std::memcpy(audioBus->channel(i)->mutableData(), planarSamples.data() + (i * length), length * sizeof(float));
+                destinationMono[i] = interleaved[i * channelCount];
             }
         }
+        else
+        {
+            // Deinterleave straight into the bus's planar channels through
+            // the SIMD kernels behind AudioBus::deinterleave.
+            audioBus->deinterleave(interleaved, length);
+        }
 
         delete audioData;
 
@@ -62,17 +80,341 @@ namespace detail
 
 namespace lab
 {
+    namespace
+    {
+        // Decoded busses are shared between callers via weak pointers: the cache
+        // never extends a bus's lifetime, it only de-duplicates concurrent users.
+        std::mutex g_busCacheMutex;
+        std::map<std::string, std::weak_ptr<AudioBus>> g_busCache;
+
+        std::string cacheKey(const std::string & path, bool mixToMono)
+        {
+            return path + (mixToMono ? "|mono" : "|multi");
+        }
+
+        // A read-only file mapping, unmapped on destruction. For the mapped
+        // WAV fast path below: the OS pages sample data in on demand instead
+        // of the file being read, decoded and copied through three heap
+        // buffers.
+        struct MappedFile
+        {
+            const uint8_t * data = nullptr;
+            size_t size = 0;
+
+#if defined(LABSOUND_PLATFORM_WINDOWS)
+            HANDLE file = INVALID_HANDLE_VALUE;
+            HANDLE mapping = 0;
+
+            bool map(const char * path)
+            {
+                file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+                                   FILE_ATTRIBUTE_NORMAL, 0);
+                if (file == INVALID_HANDLE_VALUE)
+                    return false;
+                LARGE_INTEGER fileSize;
+                if (!GetFileSizeEx(file, &fileSize) || !fileSize.QuadPart)
+                    return false;
+                mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+                if (!mapping)
+                    return false;
+                data = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                if (!data)
+                    return false;
+                size = static_cast<size_t>(fileSize.QuadPart);
+                return true;
+            }
+
+            ~MappedFile()
+            {
+                if (data)
+                    UnmapViewOfFile(data);
+                if (mapping)
+                    CloseHandle(mapping);
+                if (file != INVALID_HANDLE_VALUE)
+                    CloseHandle(file);
+            }
+#else
+            int fd = -1;
+
+            bool map(const char * path)
+            {
+                fd = open(path, O_RDONLY);
+                if (fd < 0)
+                    return false;
+                struct stat st;
+                if (fstat(fd, &st) || !st.st_size)
+                    return false;
+                void * mapped = mmap(0, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapped == MAP_FAILED)
+                    return false;
+                data = static_cast<const uint8_t *>(mapped);
+                size = static_cast<size_t>(st.st_size);
+                return true;
+            }
+
+            ~MappedFile()
+            {
+                if (data)
+                    munmap(const_cast<uint8_t *>(data), size);
+                if (fd >= 0)
+                    close(fd);
+            }
+#endif
+        };
+
+        struct WavInfo
+        {
+            const uint8_t * samples = nullptr;  // start of the data chunk
+            size_t sampleBytes = 0;
+            int format = 0;          // 1 = integer PCM, 3 = IEEE float
+            int channels = 0;
+            double sampleRate = 0;
+            int bitsPerSample = 0;
+        };
+
+        uint32_t readU32(const uint8_t * p) { uint32_t v; memcpy(&v, p, 4); return v; }
+        uint16_t readU16(const uint8_t * p) { uint16_t v; memcpy(&v, p, 2); return v; }
+
+        // Minimal RIFF walker for the canonical little-endian PCM layouts an
+        // offline packer emits; anything surprising returns false and the
+        // caller falls back to the full decoder.
+        bool parseWav(const uint8_t * bytes, size_t size, WavInfo & out)
+        {
+            if (size < 12 || memcmp(bytes, "RIFF", 4) || memcmp(bytes + 8, "WAVE", 4))
+                return false;
+
+            size_t pos = 12;
+            bool haveFormat = false;
+            while (pos + 8 <= size)
+            {
+                const uint8_t * chunk = bytes + pos;
+                uint32_t chunkSize = readU32(chunk + 4);
+                if (pos + 8 + chunkSize > size)
+                    return false;
+
+                if (!memcmp(chunk, "fmt ", 4) && chunkSize >= 16)
+                {
+                    out.format = readU16(chunk + 8);
+                    out.channels = readU16(chunk + 10);
+                    out.sampleRate = readU32(chunk + 12);
+                    out.bitsPerSample = readU16(chunk + 22);
+                    if (out.format == 0xFFFE && chunkSize >= 40)  // WAVE_FORMAT_EXTENSIBLE
+                        out.format = readU16(chunk + 32);
+                    haveFormat = true;
+                }
+                else if (!memcmp(chunk, "data", 4))
+                {
+                    out.samples = chunk + 8;
+                    out.sampleBytes = chunkSize;
+                }
+
+                pos += 8 + chunkSize + (chunkSize & 1);  // chunks are word-aligned
+            }
+
+            return haveFormat && out.samples && out.channels > 0 && out.sampleRate > 0;
+        }
+
+        // Loads a PCM WAV through a file mapping: headers are parsed in
+        // place, and samples either alias the mapping directly (mono float32,
+        // where the bus's channel is a view over the mapped data and the
+        // mapping lives as long as the bus) or stream from it into the bus in
+        // a single pass (interleaved multichannel, and 16-bit integer data,
+        // which WAV stores interleaved so planar channel views cannot alias
+        // it). Returns null for anything but 16-bit and float32 PCM.
+        std::shared_ptr<AudioBus> tryMappedWavLoad(const char * path, bool mixToMono)
+        {
+            size_t pathLength = strlen(path);
+            if (pathLength < 4 || (strcmp(path + pathLength - 4, ".wav") && strcmp(path + pathLength - 4, ".WAV")))
+                return {};
+
+            auto mapped = std::make_shared<MappedFile>();
+            if (!mapped->map(path))
+                return {};
+
+            WavInfo wav;
+            if (!parseWav(mapped->data, mapped->size, wav))
+                return {};
+
+            const bool isFloat32 = wav.format == 3 && wav.bitsPerSample == 32;
+            const bool isInt16 = wav.format == 1 && wav.bitsPerSample == 16;
+            if (!isFloat32 && !isInt16)
+                return {};
+
+            const size_t bytesPerSample = wav.bitsPerSample / 8;
+            const size_t channels = wav.channels;
+            const size_t length = wav.sampleBytes / (bytesPerSample * channels);
+            if (!length)
+                return {};
+
+            const size_t busChannels = mixToMono ? 1 : channels;
+
+            if (isFloat32 && channels == 1)
+            {
+                // Zero copy: the channel is a view over the mapped samples,
+                // and the mapping is released with the bus.
+                auto bus = std::shared_ptr<AudioBus>(
+                    new AudioBus(1, length, false),
+                    [mapped](AudioBus * b) { delete b; });
+                bus->setChannelMemory(0, reinterpret_cast<float *>(const_cast<uint8_t *>(wav.samples)), length);
+                bus->setSampleRate(static_cast<float>(wav.sampleRate));
+                return bus;
+            }
 
-    nqr::NyquistIO nyquist_io;
-    std::mutex g_fileIOMutex;
+            auto bus = std::make_shared<AudioBus>(busChannels, length);
+            bus->setSampleRate(static_cast<float>(wav.sampleRate));
+
+            if (isFloat32)
+            {
+                const float * interleaved = reinterpret_cast<const float *>(wav.samples);
+                if (mixToMono && channels == 2)
+                {
+                    float * mono = bus->channel(0)->mutableData();
+                    for (size_t i = 0; i < length; ++i)
+                        mono[i] = 0.5f * (interleaved[2 * i] + interleaved[2 * i + 1]);
+                }
+                else if (mixToMono && channels > 1)
+                {
+                    float * mono = bus->channel(0)->mutableData();
+                    for (size_t i = 0; i < length; ++i)
+                        mono[i] = interleaved[i * channels];
+                }
+                else
+                {
+                    bus->deinterleave(interleaved, length);
+                }
+                return bus;
+            }
+
+            // 16-bit integer PCM: convert while deinterleaving, straight from
+            // the mapping into the planar channels.
+            const int16_t * interleaved = reinterpret_cast<const int16_t *>(wav.samples);
+            const float scale = 1.f / 32768.f;
+            if (mixToMono && channels == 2)
+            {
+                float * mono = bus->channel(0)->mutableData();
+                for (size_t i = 0; i < length; ++i)
+                    mono[i] = 0.5f * scale * (static_cast<float>(interleaved[2 * i]) + static_cast<float>(interleaved[2 * i + 1]));
+            }
+            else if (mixToMono && channels > 1)
+            {
+                float * mono = bus->channel(0)->mutableData();
+                for (size_t i = 0; i < length; ++i)
+                    mono[i] = scale * interleaved[i * channels];
+            }
+            else
+            {
+                for (size_t c = 0; c < channels; ++c)
+                {
+                    float * destination = bus->channel(c)->mutableData();
+                    const int16_t * source = interleaved + c;
+                    for (size_t i = 0; i < length; ++i)
+                        destination[i] = scale * source[i * channels];
+                }
+            }
+            return bus;
+        }
+
+        // A small pool of decode workers shared by all async loads. Lazily
+        // created on first use; workers are joined at process exit.
+        class DecodePool
+        {
+        public:
+            static DecodePool & shared()
+            {
+                static DecodePool pool;
+                return pool;
+            }
+
+            void enqueue(std::function<void()> task)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_tasks.push_back(std::move(task));
+                }
+                m_wake.notify_one();
+            }
+
+        private:
+            DecodePool()
+            {
+                unsigned int hw = std::thread::hardware_concurrency();
+                size_t count = hw > 2 ? std::min<size_t>(hw / 2, 4) : 1;
+                for (size_t i = 0; i < count; ++i)
+                    m_workers.emplace_back(&DecodePool::workerLoop, this);
+            }
+
+            ~DecodePool()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_shouldExit = true;
+                }
+                m_wake.notify_all();
+                for (auto & w : m_workers)
+                {
+                    if (w.joinable())
+                        w.join();
+                }
+            }
+
+            void workerLoop()
+            {
+                for (;;)
+                {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(m_mutex);
+                        m_wake.wait(lock, [this]() { return m_shouldExit || !m_tasks.empty(); });
+                        if (m_shouldExit && m_tasks.empty())
+                            return;
+                        task = std::move(m_tasks.front());
+                        m_tasks.pop_front();
+                    }
+                    TraceSpan span(TraceRecorder::Category::Decode, "audio decode");
+                    task();
+                }
+            }
+
+            std::mutex m_mutex;
+            std::condition_variable m_wake;
+            std::deque<std::function<void()>> m_tasks;
+            std::vector<std::thread> m_workers;
+            bool m_shouldExit = false;
+        };
+    }
 
     std::shared_ptr<AudioBus> MakeBusFromFile(const char * filePath, bool mixToMono)
     {
-        std::lock_guard<std::mutex> lock(g_fileIOMutex);
+        std::string key = cacheKey(filePath, mixToMono);
+
+        {
+            std::lock_guard<std::mutex> lock(g_busCacheMutex);
+            auto cached = g_busCache.find(key);
+            if (cached != g_busCache.end())
+            {
+                if (auto bus = cached->second.lock())
+                    return bus;
+                g_busCache.erase(cached);
+            }
+        }
+
+        // PCM WAV fast path: parse headers over a file mapping and build the
+        // bus without the read-decode-copy round trip. Anything the walker
+        // doesn't recognize falls through to the full decoder.
+        if (std::shared_ptr<AudioBus> bus = tryMappedWavLoad(filePath, mixToMono))
+        {
+            std::lock_guard<std::mutex> lock(g_busCacheMutex);
+            g_busCache[key] = bus;
+            return bus;
+        }
+
+        // Each decode uses its own NyquistIO so concurrent loads don't
+        // serialize on a shared decoder instance.
         nqr::AudioData * audioData = new nqr::AudioData();
         try
         {
-            nyquist_io.Load(audioData, std::string(filePath));
+            nqr::NyquistIO io;
+            io.Load(audioData, std::string(filePath));
         }
         catch (...)
         {
@@ -81,7 +423,15 @@ namespace lab
             return {};
         }
 
-        return detail::LoadInternal(audioData, mixToMono);
+        std::shared_ptr<AudioBus> bus = detail::LoadInternal(audioData, mixToMono);
+
+        if (bus)
+        {
+            std::lock_guard<std::mutex> lock(g_busCacheMutex);
+            g_busCache[key] = bus;
+        }
+
+        return bus;
     }
 
     std::shared_ptr<AudioBus> MakeBusFromFile(const std::string& path, bool mixToMono)
@@ -89,19 +439,38 @@ namespace lab
         return MakeBusFromFile(path.c_str(), mixToMono);
     }
 
+    std::future<std::shared_ptr<AudioBus>> MakeBusFromFileAsync(const std::string & path, bool mixToMono)
+    {
+        auto promise = std::make_shared<std::promise<std::shared_ptr<AudioBus>>>();
+        std::future<std::shared_ptr<AudioBus>> future = promise->get_future();
+
+        DecodePool::shared().enqueue([promise, path, mixToMono]() {
+            promise->set_value(MakeBusFromFile(path, mixToMono));
+        });
+
+        return future;
+    }
+
+    void MakeBusFromFileAsync(const std::string & path, bool mixToMono, std::function<void(std::shared_ptr<AudioBus>)> callback)
+    {
+        DecodePool::shared().enqueue([path, mixToMono, callback]() {
+            callback(MakeBusFromFile(path, mixToMono));
+        });
+    }
+
     std::shared_ptr<AudioBus> MakeBusFromMemory(const std::vector<uint8_t> & buffer, bool mixToMono)
     {
-        std::lock_guard<std::mutex> lock(g_fileIOMutex);
         nqr::AudioData * audioData = new nqr::AudioData();
-        nyquist_io.Load(audioData, buffer);
+        nqr::NyquistIO io;
+        io.Load(audioData, buffer);
         return detail::LoadInternal(audioData, mixToMono);
     }
 
     std::shared_ptr<AudioBus> MakeBusFromMemory(const std::vector<uint8_t> & buffer, const std::string& extension, bool mixToMono)
     {
-        std::lock_guard<std::mutex> lock(g_fileIOMutex);
         nqr::AudioData * audioData = new nqr::AudioData();
-        nyquist_io.Load(audioData, extension, buffer);
+        nqr::NyquistIO io;
+        io.Load(audioData, extension, buffer);
         return detail::LoadInternal(audioData, mixToMono);
     }
 
@@ -0,0 +1,70 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/AudioFileStream.h"
+#include "LabSound/extended/AudioFileReader.h"
+
+#include "LabSound/core/AudioBus.h"
+
+#include <algorithm>
+
+namespace lab
+{
+
+AudioFileStream::AudioFileStream(const std::string & path, bool mixToMono)
+{
+    // Decode in full, then spill channel-major so that reading a span of frames
+    // for one channel is a single contiguous disk read.
+    std::shared_ptr<AudioBus> bus = MakeBusFromFile(path, mixToMono);
+    if (!bus || !bus->length() || !bus->numberOfChannels())
+        return;
+
+    FILE * file = tmpfile();
+    if (!file)
+        return;
+
+    size_t length = bus->length();
+    for (size_t i = 0; i < bus->numberOfChannels(); ++i)
+    {
+        if (fwrite(bus->channel(static_cast<unsigned>(i))->data(), sizeof(float), length, file) != length)
+        {
+            fclose(file);
+            return;
+        }
+    }
+
+    m_file = file;
+    m_sampleRate = bus->sampleRate();
+    m_length = length;
+    m_numberOfChannels = bus->numberOfChannels();
+
+    // The decoded bus is released here; only the spill file remains.
+}
+
+AudioFileStream::~AudioFileStream()
+{
+    if (m_file)
+        fclose(m_file); // tmpfile() unlinks on close
+}
+
+size_t AudioFileStream::read(size_t startFrame, float * const * destination, size_t frameCount)
+{
+    if (!m_file || startFrame >= m_length)
+        return 0;
+
+    size_t frames = std::min(frameCount, m_length - startFrame);
+
+    std::lock_guard<std::mutex> lock(m_ioMutex);
+    for (size_t i = 0; i < m_numberOfChannels; ++i)
+    {
+        long offset = static_cast<long>((i * m_length + startFrame) * sizeof(float));
+        if (fseek(m_file, offset, SEEK_SET) != 0)
+            return 0;
+        if (fread(destination[i], sizeof(float), frames, m_file) != frames)
+            return 0;
+    }
+
+    return frames;
+}
+
+} // namespace lab
@@ -58,6 +58,11 @@ namespace lab
             3.f
         };
 
+        // Tempo changes swap read heads inside the already allocated ring
+        // instead of gliding (and pitch-bending) the read position, so
+        // per-bar tempo automation is click-free and allocation-free.
+        setCrossfadeOnDelayChange(true);
+
         SetDelayIndex(TempoSync::TS_8);
     }
     
@@ -0,0 +1,135 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/BakeFarm.h"
+
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/OfflineAudioDestinationNode.h"
+
+#include "LabSound/extended/GraphSerialization.h"
+#include "LabSound/extended/Logging.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace lab
+{
+
+namespace
+{
+
+    BakeResult bakeOne(const BakeJob & job, bool singleThreadedRender)
+    {
+        BakeResult result;
+
+        if (job.durationSeconds <= 0.f)
+        {
+            result.error = "job has no duration";
+            return result;
+        }
+
+        if (!job.channels || job.sampleRate <= 0.f)
+        {
+            result.error = "job has no valid output format";
+            return result;
+        }
+
+        // A private context per job: graph state is mutable and cannot be
+        // shared, but everything immutable behind it - decoded samples, HRTF
+        // data, wavetables, window tables - comes out of the process-wide
+        // caches the whole farm shares.
+        std::unique_ptr<AudioContext> context(new AudioContext(true));
+        auto destination = std::make_shared<OfflineAudioDestinationNode>(context.get(), job.sampleRate, job.durationSeconds, job.channels);
+        context->setDestinationNode(destination);
+        context->lazyInitialize();
+
+        if (singleThreadedRender)
+            destination->setParallelRenderingEnabled(false);
+
+        std::vector<std::shared_ptr<AudioNode>> nodes;
+        if (!job.graph.empty())
+        {
+            nodes = deserializeGraph(*context, job.graph.data(), job.graph.size());
+            if (nodes.empty())
+            {
+                result.error = "graph did not deserialize";
+                return result;
+            }
+        }
+
+        if (job.prepare)
+            job.prepare(*context, nodes);
+
+        if (!destination->renderToWavFile(job.outputPath))
+        {
+            result.error = "could not create " + job.outputPath;
+            return result;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        // blocks until the render is complete and the file is finalized
+        destination->startRendering();
+
+        result.renderSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.ok = true;
+        return result;
+    }
+
+} // namespace
+
+std::vector<BakeResult> bakeAll(const std::vector<BakeJob> & jobs,
+                                size_t concurrency,
+                                std::function<void(size_t jobIndex, const BakeResult &)> onJobComplete)
+{
+    std::vector<BakeResult> results(jobs.size());
+    if (jobs.empty())
+        return results;
+
+    if (!concurrency)
+    {
+        concurrency = std::thread::hardware_concurrency();
+        if (!concurrency)
+            concurrency = 1;
+    }
+    concurrency = std::min(concurrency, jobs.size());
+
+    const bool singleThreadedRender = concurrency > 1;
+
+    // Workers claim jobs dynamically, so a batch of mixed durations stays
+    // balanced without any up-front estimate of per-job cost.
+    std::atomic<size_t> nextJob{0};
+
+    auto work = [&]() {
+        for (;;)
+        {
+            size_t i = nextJob.fetch_add(1, std::memory_order_relaxed);
+            if (i >= jobs.size())
+                return;
+
+            results[i] = bakeOne(jobs[i], singleThreadedRender);
+
+            if (!results[i].ok)
+                LOG("bake job %d failed: %s", static_cast<int>(i), results[i].error.c_str());
+
+            if (onJobComplete)
+                onJobComplete(i, results[i]);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < concurrency; ++t)
+        workers.emplace_back(work);
+
+    // the calling thread is the first worker
+    work();
+
+    for (auto & w : workers)
+        w.join();
+
+    return results;
+}
+
+} // namespace lab
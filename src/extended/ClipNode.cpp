@@ -75,10 +75,7 @@ namespace lab
                         source = sourceBus->channel(channelIndex)->data();
 
                     float * destination = destinationBus->channel(channelIndex)->mutableData();
-                    for (size_t i = 0; i < framesToProcess; ++i)
-                    {
-                        *destination++ = outputGain * tanhf(inputGain * source[i]);
-                    }
+                    VectorMath::vtanh(source, &inputGain, &outputGain, destination, framesToProcess);
                 }
             }
             else
@@ -92,18 +89,7 @@ namespace lab
                         source = sourceBus->channel(channelIndex)->data();
 
                     float * destination = destinationBus->channel(channelIndex)->mutableData();
-
-                    for (size_t i = 0; i < framesToProcess; ++i)
-                    {
-                        float d = source[i];
-
-                        if (d < minf)
-                            d = minf;
-                        else if (d > maxf)
-                            d = maxf;
-
-                        *destination++ = d;
-                    }
+                    VectorMath::vclip(source, 1, &minf, &maxf, destination, 1, framesToProcess);
                 }
             }
         }
@@ -0,0 +1,388 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/CompressedAudioStream.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <map>
+#include <mutex>
+
+namespace lab
+{
+
+// One decoded cache chunk: planar float frames for a run of consecutive
+// ADPCM blocks, immutable once built.
+struct CompressedAudioStream::DecodedChunk
+{
+    size_t frames = 0;
+    size_t channels = 0;
+    std::vector<float> samples;  // channel c occupies [c * frames, (c + 1) * frames)
+
+    const float * channel(size_t c) const { return samples.data() + c * frames; }
+    size_t bytes() const { return samples.size() * sizeof(float); }
+};
+
+namespace
+{
+    uint32_t readU32(const uint8_t * p) { uint32_t v; memcpy(&v, p, 4); return v; }
+    uint16_t readU16(const uint8_t * p) { uint16_t v; memcpy(&v, p, 2); return v; }
+
+    // IMA ADPCM step and index adaptation tables (IMA DVI spec).
+    const int kIndexTable[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+    const int kStepTable[89] = {
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37,
+        41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173,
+        190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+        724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+        2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894,
+        6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289,
+        16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+    struct AdpcmChannelState
+    {
+        int predictor = 0;
+        int stepIndex = 0;
+    };
+
+    float decodeNibble(AdpcmChannelState & state, int nibble)
+    {
+        int step = kStepTable[state.stepIndex];
+        int diff = step >> 3;
+        if (nibble & 1) diff += step >> 2;
+        if (nibble & 2) diff += step >> 1;
+        if (nibble & 4) diff += step;
+        if (nibble & 8)
+            state.predictor -= diff;
+        else
+            state.predictor += diff;
+        state.predictor = std::max(-32768, std::min(32767, state.predictor));
+        state.stepIndex = std::max(0, std::min(88, state.stepIndex + kIndexTable[nibble & 15]));
+        return state.predictor / 32768.f;
+    }
+
+    // Decodes one ADPCM block into planar output, writing at most
+    // maxFrames per channel. Each channel leads with a 4-byte header whose
+    // predictor is the block's first sample; the nibble data follows in
+    // 4-byte groups rotating through the channels.
+    void decodeAdpcmBlock(const uint8_t * block, size_t blockAlign, size_t channels,
+                          float * const * destination, size_t maxFrames)
+    {
+        if (!maxFrames)
+            return;
+
+        AdpcmChannelState state[8];
+        size_t written[8];
+        size_t usableChannels = std::min<size_t>(channels, 8);
+
+        for (size_t c = 0; c < usableChannels; ++c)
+        {
+            const uint8_t * header = block + 4 * c;
+            state[c].predictor = static_cast<int16_t>(readU16(header));
+            state[c].stepIndex = std::max(0, std::min(88, static_cast<int>(header[2])));
+            destination[c][0] = state[c].predictor / 32768.f;
+            written[c] = 1;
+        }
+
+        const uint8_t * data = block + 4 * channels;
+        size_t dataBytes = blockAlign - 4 * channels;
+        size_t groups = dataBytes / 4;
+
+        for (size_t group = 0; group < groups; ++group)
+        {
+            size_t c = channels > 1 ? group % channels : 0;
+            if (c >= usableChannels)
+                continue;
+            const uint8_t * groupData = data + group * 4;
+            for (size_t byte = 0; byte < 4; ++byte)
+            {
+                if (written[c] < maxFrames)
+                    destination[c][written[c]++] = decodeNibble(state[c], groupData[byte] & 0x0f);
+                if (written[c] < maxFrames)
+                    destination[c][written[c]++] = decodeNibble(state[c], groupData[byte] >> 4);
+            }
+        }
+    }
+
+    // The shared decoded-chunk cache: LRU over a byte budget, keyed by
+    // (stream, chunk). Lookups and inserts take a mutex - callers are
+    // prefetch i/o threads, never the render thread - and misses decode
+    // outside the lock so concurrent streams don't serialize on each
+    // other's decodes.
+    class DecodeCache
+    {
+    public:
+        static DecodeCache & shared()
+        {
+            static DecodeCache cache;
+            return cache;
+        }
+
+        using ChunkPtr = std::shared_ptr<const CompressedAudioStream::DecodedChunk>;
+
+        ChunkPtr find(uint64_t streamId, uint32_t chunkIndex)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_index.find(std::make_pair(streamId, chunkIndex));
+            if (it == m_index.end())
+                return {};
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            return it->second->chunk;
+        }
+
+        void insert(uint64_t streamId, uint32_t chunkIndex, ChunkPtr chunk)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto key = std::make_pair(streamId, chunkIndex);
+            if (m_index.count(key))
+                return;  // a concurrent decode won the race; keep its copy
+
+            Entry entry;
+            entry.key = key;
+            entry.chunk = chunk;
+            entry.bytes = chunk->bytes();
+            m_entries.push_front(entry);
+            m_index[key] = m_entries.begin();
+            m_bytes += entry.bytes;
+            evictLocked();
+        }
+
+        void purge(uint64_t streamId)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto it = m_entries.begin(); it != m_entries.end();)
+            {
+                if (it->key.first == streamId)
+                {
+                    m_bytes -= it->bytes;
+                    m_index.erase(it->key);
+                    it = m_entries.erase(it);
+                }
+                else
+                    ++it;
+            }
+        }
+
+        void setBudget(size_t bytes)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_budget = bytes;
+            evictLocked();
+        }
+
+        size_t budget() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_budget;
+        }
+
+        size_t bytes() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_bytes;
+        }
+
+    private:
+        struct Entry
+        {
+            std::pair<uint64_t, uint32_t> key;
+            ChunkPtr chunk;
+            size_t bytes = 0;
+        };
+
+        void evictLocked()
+        {
+            while (m_bytes > m_budget && !m_entries.empty())
+            {
+                Entry & last = m_entries.back();
+                m_bytes -= last.bytes;
+                m_index.erase(last.key);
+                m_entries.pop_back();
+            }
+        }
+
+        mutable std::mutex m_mutex;
+        std::list<Entry> m_entries;  // most recently used first
+        std::map<std::pair<uint64_t, uint32_t>, std::list<Entry>::iterator> m_index;
+        size_t m_bytes = 0;
+        size_t m_budget = 32 * 1024 * 1024;
+    };
+
+    std::atomic<uint64_t> s_nextCacheId{1};
+
+    // Decoded chunks target roughly 16k frames so a cold trigger decodes
+    // tens of blocks, not the whole line.
+    const size_t kTargetChunkFrames = 16384;
+}
+
+CompressedAudioStream::CompressedAudioStream(const std::string & path)
+{
+    FILE * f = fopen(path.c_str(), "rb");
+    if (!f)
+        return;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    std::vector<uint8_t> file;
+    if (size > 0)
+    {
+        file.resize(static_cast<size_t>(size));
+        if (fread(file.data(), 1, file.size(), f) != file.size())
+            file.clear();
+    }
+    fclose(f);
+
+    if (file.size() < 12 || memcmp(file.data(), "RIFF", 4) || memcmp(file.data() + 8, "WAVE", 4))
+        return;
+
+    int format = 0;
+    int channels = 0;
+    double sampleRate = 0;
+    size_t blockAlign = 0;
+    size_t samplesPerBlock = 0;
+    size_t factFrames = 0;
+    const uint8_t * payload = nullptr;
+    size_t payloadBytes = 0;
+
+    size_t pos = 12;
+    while (pos + 8 <= file.size())
+    {
+        const uint8_t * chunk = file.data() + pos;
+        uint32_t chunkSize = readU32(chunk + 4);
+        if (pos + 8 + chunkSize > file.size())
+            return;
+
+        if (!memcmp(chunk, "fmt ", 4) && chunkSize >= 16)
+        {
+            format = readU16(chunk + 8);
+            channels = readU16(chunk + 10);
+            sampleRate = readU32(chunk + 12);
+            blockAlign = readU16(chunk + 20);
+            if (chunkSize >= 20)
+                samplesPerBlock = readU16(chunk + 26);
+        }
+        else if (!memcmp(chunk, "fact", 4) && chunkSize >= 4)
+        {
+            factFrames = readU32(chunk + 8);
+        }
+        else if (!memcmp(chunk, "data", 4))
+        {
+            payload = chunk + 8;
+            payloadBytes = chunkSize;
+        }
+
+        pos += 8 + chunkSize + (chunkSize & 1);
+    }
+
+    // 0x11 is WAVE_FORMAT_IMA_ADPCM.
+    if (format != 0x11 || channels < 1 || channels > 8 || sampleRate <= 0 || !payload
+        || blockAlign <= 4 * static_cast<size_t>(channels))
+        return;
+
+    if (!samplesPerBlock)
+        samplesPerBlock = (blockAlign - 4 * channels) * 2 / channels + 1;
+
+    size_t blocks = payloadBytes / blockAlign;
+    if (!blocks)
+        return;
+
+    m_compressed.assign(payload, payload + blocks * blockAlign);
+    m_blockAlign = blockAlign;
+    m_samplesPerBlock = samplesPerBlock;
+    m_blocksPerChunk = std::max<size_t>(1, (kTargetChunkFrames + samplesPerBlock - 1) / samplesPerBlock);
+    m_cacheId = s_nextCacheId.fetch_add(1);
+
+    m_numberOfChannels = channels;
+    m_sampleRate = static_cast<float>(sampleRate);
+    m_length = factFrames ? std::min(factFrames, blocks * samplesPerBlock)
+                          : blocks * samplesPerBlock;
+    m_valid = true;
+}
+
+CompressedAudioStream::~CompressedAudioStream()
+{
+    if (m_valid)
+        DecodeCache::shared().purge(m_cacheId);
+}
+
+std::shared_ptr<const CompressedAudioStream::DecodedChunk>
+CompressedAudioStream::decodeChunk(uint32_t chunkIndex) const
+{
+    size_t totalBlocks = m_compressed.size() / m_blockAlign;
+    size_t firstBlock = static_cast<size_t>(chunkIndex) * m_blocksPerChunk;
+    if (firstBlock >= totalBlocks)
+        return {};
+    size_t blockCount = std::min(m_blocksPerChunk, totalBlocks - firstBlock);
+
+    auto chunk = std::make_shared<DecodedChunk>();
+    chunk->frames = blockCount * m_samplesPerBlock;
+    chunk->channels = m_numberOfChannels;
+    chunk->samples.resize(chunk->frames * chunk->channels);
+
+    float * channelPointers[8];
+    for (size_t b = 0; b < blockCount; ++b)
+    {
+        size_t frameOffset = b * m_samplesPerBlock;
+        for (size_t c = 0; c < chunk->channels; ++c)
+            channelPointers[c] = chunk->samples.data() + c * chunk->frames + frameOffset;
+        decodeAdpcmBlock(m_compressed.data() + (firstBlock + b) * m_blockAlign,
+                         m_blockAlign, chunk->channels, channelPointers, m_samplesPerBlock);
+    }
+    return chunk;
+}
+
+size_t CompressedAudioStream::read(size_t startFrame, float * const * destination, size_t frameCount)
+{
+    if (!m_valid || startFrame >= m_length)
+        return 0;
+
+    size_t frames = std::min(frameCount, m_length - startFrame);
+    size_t chunkFrames = m_samplesPerBlock * m_blocksPerChunk;
+    size_t written = 0;
+
+    while (written < frames)
+    {
+        size_t frame = startFrame + written;
+        uint32_t chunkIndex = static_cast<uint32_t>(frame / chunkFrames);
+
+        auto chunk = DecodeCache::shared().find(m_cacheId, chunkIndex);
+        if (!chunk)
+        {
+            chunk = decodeChunk(chunkIndex);
+            if (!chunk)
+                break;
+            DecodeCache::shared().insert(m_cacheId, chunkIndex, chunk);
+        }
+
+        size_t offsetInChunk = frame - static_cast<size_t>(chunkIndex) * chunkFrames;
+        if (offsetInChunk >= chunk->frames)
+            break;
+
+        size_t n = std::min(frames - written, chunk->frames - offsetInChunk);
+        for (size_t c = 0; c < m_numberOfChannels; ++c)
+            memcpy(destination[c] + written, chunk->channel(c) + offsetInChunk, n * sizeof(float));
+        written += n;
+    }
+
+    return written;
+}
+
+void CompressedAudioStream::setDecodeCacheBudget(size_t bytes)
+{
+    DecodeCache::shared().setBudget(bytes);
+}
+
+size_t CompressedAudioStream::decodeCacheBudget()
+{
+    return DecodeCache::shared().budget();
+}
+
+size_t CompressedAudioStream::decodeCacheBytes()
+{
+    return DecodeCache::shared().bytes();
+}
+
+} // namespace lab
@@ -0,0 +1,207 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/CrossfadeNode.h"
+
+#include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/AudioNodeInput.h"
+#include "LabSound/core/AudioNodeOutput.h"
+#include "LabSound/core/AudioSetting.h"
+#include "LabSound/extended/AudioContextLock.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace lab
+{
+    namespace
+    {
+        // One fused pass: destination = source0 * gain0(x) + source1 * gain1(x),
+        // with x ramping by dx per frame, clamped to [0, 1]. Linear gains are
+        // (1-x, x); equal-power takes the square root of each, which SIMD
+        // sqrt handles without a trig table.
+        void xfadeSpan(const float * source0, const float * source1, float * destination,
+                       float x0, float dx, bool equalPower, size_t framesToProcess)
+        {
+            size_t i = 0;
+
+#ifdef __SSE2__
+            __m128 x = _mm_setr_ps(x0, x0 + dx, x0 + 2 * dx, x0 + 3 * dx);
+            const __m128 step = _mm_set1_ps(4 * dx);
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.f);
+
+            for (; i + 4 <= framesToProcess; i += 4)
+            {
+                __m128 xc = _mm_min_ps(_mm_max_ps(x, zero), one);
+                __m128 g1 = xc;
+                __m128 g0 = _mm_sub_ps(one, xc);
+                if (equalPower)
+                {
+                    g0 = _mm_sqrt_ps(g0);
+                    g1 = _mm_sqrt_ps(g1);
+                }
+
+                __m128 blended = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(source0 + i), g0),
+                                            _mm_mul_ps(_mm_loadu_ps(source1 + i), g1));
+                _mm_storeu_ps(destination + i, blended);
+                x = _mm_add_ps(x, step);
+            }
+#endif
+
+            for (; i < framesToProcess; ++i)
+            {
+                float xc = x0 + dx * float(i);
+                xc = std::max(0.f, std::min(1.f, xc));
+                float g1 = xc;
+                float g0 = 1.f - xc;
+                if (equalPower)
+                {
+                    g0 = sqrtf(g0);
+                    g1 = sqrtf(g1);
+                }
+                destination[i] = source0[i] * g0 + source1[i] * g1;
+            }
+        }
+
+        // Substitute for an unconnected input.
+        const float s_silence[AudioNode::ProcessingSizeInFrames] = {};
+    }
+
+    CrossfadeNode::CrossfadeNode()
+    : m_law(std::make_shared<AudioSetting>("law"))
+    {
+        m_law->setUint32(EQUAL_POWER_LAW);
+        m_settings.push_back(m_law);
+
+        addInput(std::unique_ptr<AudioNodeInput>(new AudioNodeInput(this)));
+        addInput(std::unique_ptr<AudioNodeInput>(new AudioNodeInput(this)));
+        addOutput(std::unique_ptr<AudioNodeOutput>(new AudioNodeOutput(this, 2)));
+
+        initialize();
+    }
+
+    CrossfadeNode::~CrossfadeNode()
+    {
+        uninitialize();
+    }
+
+    CrossfadeNode::FadeLaw CrossfadeNode::law() const
+    {
+        return static_cast<FadeLaw>(m_law->valueUint32());
+    }
+
+    void CrossfadeNode::setLaw(FadeLaw law)
+    {
+        m_law->setUint32(law);
+    }
+
+    void CrossfadeNode::setPosition(float position)
+    {
+        transitionTo(position, 0, 0);
+    }
+
+    void CrossfadeNode::transitionTo(float target, double when, double duration)
+    {
+        m_pendingTrigger.when = when;
+        m_pendingTrigger.duration = duration > 0 ? duration : 0;
+        m_pendingTrigger.target = std::max(0.f, std::min(1.f, target));
+        m_hasPendingTrigger.store(true, std::memory_order_release);
+    }
+
+    void CrossfadeNode::process(ContextRenderLock & r, size_t framesToProcess)
+    {
+        AudioBus * outputBus = output(0)->bus(r);
+        if (!outputBus)
+            return;
+
+        if (!isInitialized())
+        {
+            outputBus->zero();
+            return;
+        }
+
+        const double sampleRate = r.context()->sampleRate();
+        const uint64_t quantumStartFrame = r.context()->currentSampleFrame();
+
+        // Latch a pending trigger, sample-accurately, against the context
+        // timeline. A trigger replaces whatever was running at its start.
+        if (m_hasPendingTrigger.exchange(false, std::memory_order_acquire))
+        {
+            uint64_t startFrame = quantumStartFrame;
+            if (m_pendingTrigger.when * sampleRate > double(quantumStartFrame))
+                startFrame = uint64_t(m_pendingTrigger.when * sampleRate);
+
+            m_transitionStartFrame = startFrame;
+            m_transitionEndFrame = startFrame + uint64_t(m_pendingTrigger.duration * sampleRate);
+            m_transitionTarget = m_pendingTrigger.target;
+            m_transitionActive = true;
+        }
+
+        AudioBus * bus0 = input(0)->bus(r);
+        AudioBus * bus1 = input(1)->bus(r);
+        const size_t channels0 = bus0 ? bus0->numberOfChannels() : 0;
+        const size_t channels1 = bus1 ? bus1->numberOfChannels() : 0;
+        const bool equalPower = law() == EQUAL_POWER_LAW;
+
+        // Render in up to three spans: holding before the trigger fires,
+        // ramping, and holding at the target.
+        size_t frame = 0;
+        while (frame < framesToProcess)
+        {
+            uint64_t now = quantumStartFrame + frame;
+            float x = m_position.load(std::memory_order_relaxed);
+            float dx = 0.f;
+            size_t spanFrames = framesToProcess - frame;
+
+            if (m_transitionActive && now >= m_transitionEndFrame)
+            {
+                m_position.store(m_transitionTarget, std::memory_order_relaxed);
+                m_transitionActive = false;
+                x = m_transitionTarget;
+            }
+            else if (m_transitionActive && now >= m_transitionStartFrame)
+            {
+                if (now == m_transitionStartFrame)
+                    m_transitionStartPosition = x;
+
+                double rampFrames = double(m_transitionEndFrame - m_transitionStartFrame);
+                dx = float((m_transitionTarget - m_transitionStartPosition) / rampFrames);
+                x = m_transitionStartPosition + dx * float(now - m_transitionStartFrame);
+                spanFrames = std::min<size_t>(spanFrames, size_t(m_transitionEndFrame - now));
+            }
+            else if (m_transitionActive)
+            {
+                // Holding until the trigger's start time.
+                spanFrames = std::min<size_t>(spanFrames, size_t(m_transitionStartFrame - now));
+            }
+
+            for (size_t c = 0; c < outputBus->numberOfChannels(); ++c)
+            {
+                const float * source0 = channels0 ? bus0->channel(c < channels0 ? c : channels0 - 1)->data() : s_silence;
+                const float * source1 = channels1 ? bus1->channel(c < channels1 ? c : channels1 - 1)->data() : s_silence;
+                float * destination = outputBus->channel(c)->mutableData();
+
+                xfadeSpan(source0 + frame, source1 + frame, destination + frame, x, dx, equalPower, spanFrames);
+            }
+
+            if (dx != 0.f)
+                m_position.store(x + dx * float(spanFrames), std::memory_order_relaxed);
+
+            frame += spanFrames;
+        }
+
+        outputBus->clearSilentFlag();
+    }
+
+    void CrossfadeNode::reset(ContextRenderLock & r)
+    {
+        m_transitionActive = false;
+    }
+}
@@ -29,7 +29,7 @@ namespace lab
     {
         AudioBus * outputBus = output(0)->bus(r);
 
-        if (!isInitialized() || !outputBus->numberOfChannels() || !_function)
+        if (!isInitialized() || !outputBus->numberOfChannels() || (!_function && !_blockFunction))
         {
             outputBus->zero();
             return;
@@ -46,16 +46,35 @@ namespace lab
             return;
         }
 
-        for (size_t i = 0; i < outputBus->numberOfChannels(); ++i)
+        if (_blockFunction)
         {
-            float * destP = outputBus->channel(i)->mutableData();
-            
-            // Start rendering at the correct offset.
-            destP += quantumFrameOffset;
-            _function(r, this, static_cast<int>(i), destP, nonSilentFramesToProcess);
+            // hand the callback every channel at once; one dispatch per quantum
+            size_t channelCount = outputBus->numberOfChannels();
+            if (_channelPointers.size() < channelCount)
+                _channelPointers.resize(channelCount);
+
+            for (size_t i = 0; i < channelCount; ++i)
+                _channelPointers[i] = outputBus->channel(i)->mutableData() + quantumFrameOffset;
+
+            double sampleTime = _now + double(quantumFrameOffset) / r.context()->sampleRate();
+            _blockFunction(r, this, _channelPointers.data(), channelCount, nonSilentFramesToProcess, sampleTime);
+        }
+        else
+        {
+            for (size_t i = 0; i < outputBus->numberOfChannels(); ++i)
+            {
+                float * destP = outputBus->channel(i)->mutableData();
+
+                // Start rendering at the correct offset.
+                destP += quantumFrameOffset;
+                _function(r, this, static_cast<int>(i), destP, nonSilentFramesToProcess);
+            }
         }
 
-        _now += double(framesToProcess) / r.context()->sampleRate();
+        // A control-rate node renders one frame per quantum, but wall time
+        // still advances a full quantum's worth.
+        size_t elapsedFrames = isControlRate() ? framesToProcess * ProcessingSizeInFrames : framesToProcess;
+        _now += double(elapsedFrames) / r.context()->sampleRate();
         outputBus->clearSilentFlag();
     }
     
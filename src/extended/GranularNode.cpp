@@ -0,0 +1,358 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/GranularNode.h"
+
+#include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/AudioNodeOutput.h"
+#include "LabSound/core/AudioSetting.h"
+#include "LabSound/extended/AudioContextLock.h"
+
+#include "internal/Assertions.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace lab
+{
+
+    namespace
+    {
+
+        // Window-table resolution. Grain envelopes are a smooth lookup; 1024
+        // entries plus a guard entry keeps the last frame of a grain in range
+        // without a clamp in the inner loop.
+        const int WindowTableSize = 1024;
+
+        // The per-grain inner loop: linear-interpolated source read, window
+        // gain from the table, accumulate into the destination. Source and
+        // window gathers are scalar (they go through computed indices) but
+        // the interpolation and accumulation run four frames at a time, the
+        // same shape as the SampledAudioNode resampling kernels.
+        void renderGrain(const float * source, const float * window,
+                         float position, float increment,
+                         float windowPhase, float windowStep,
+                         float gain, float * destination, int framesToProcess)
+        {
+            int k = 0;
+#ifdef __SSE2__
+            __m128 pos = _mm_setr_ps(position, position + increment, position + 2 * increment, position + 3 * increment);
+            __m128 phase = _mm_setr_ps(windowPhase, windowPhase + windowStep, windowPhase + 2 * windowStep, windowPhase + 3 * windowStep);
+            const __m128 posStep = _mm_set1_ps(4 * increment);
+            const __m128 phaseStep = _mm_set1_ps(4 * windowStep);
+            const __m128 g = _mm_set1_ps(gain);
+
+            for (; k + 4 <= framesToProcess; k += 4)
+            {
+                __m128i index = _mm_cvttps_epi32(pos);
+                __m128 frac = _mm_sub_ps(pos, _mm_cvtepi32_ps(index));
+
+                alignas(16) int i4[4];
+                _mm_store_si128(reinterpret_cast<__m128i *>(i4), index);
+                __m128 s0 = _mm_set_ps(source[i4[3]], source[i4[2]], source[i4[1]], source[i4[0]]);
+                __m128 s1 = _mm_set_ps(source[i4[3] + 1], source[i4[2] + 1], source[i4[1] + 1], source[i4[0] + 1]);
+
+                alignas(16) int w4[4];
+                _mm_store_si128(reinterpret_cast<__m128i *>(w4), _mm_cvttps_epi32(phase));
+                __m128 w = _mm_set_ps(window[w4[3]], window[w4[2]], window[w4[1]], window[w4[0]]);
+
+                __m128 sample = _mm_add_ps(s0, _mm_mul_ps(frac, _mm_sub_ps(s1, s0)));
+                __m128 out = _mm_add_ps(_mm_loadu_ps(destination + k), _mm_mul_ps(g, _mm_mul_ps(w, sample)));
+                _mm_storeu_ps(destination + k, out);
+
+                pos = _mm_add_ps(pos, posStep);
+                phase = _mm_add_ps(phase, phaseStep);
+            }
+            position += k * increment;
+            windowPhase += k * windowStep;
+#endif
+            for (; k < framesToProcess; ++k)
+            {
+                int index = static_cast<int>(position);
+                float frac = position - index;
+                float sample = source[index] + frac * (source[index + 1] - source[index]);
+                destination[k] += gain * window[static_cast<int>(windowPhase)] * sample;
+
+                position += increment;
+                windowPhase += windowStep;
+            }
+        }
+
+        inline uint32_t xorshift32(uint32_t x)
+        {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            return x;
+        }
+
+    }  // anonymous namespace
+
+    GranularNode::GranularNode()
+    : AudioScheduledSourceNode()
+    , m_window(std::make_shared<AudioSetting>("window"))
+    {
+        m_grainRate = make_shared<AudioParam>("grainRate", 20.0, 0.0, 10000.0);
+        m_grainDuration = make_shared<AudioParam>("grainDuration", 0.1, 0.0001, 10.0);
+        m_position = make_shared<AudioParam>("position", 0.0, 0.0, 1.0);
+        m_positionJitter = make_shared<AudioParam>("positionJitter", 0.0, 0.0, 1.0);
+        m_playbackRate = make_shared<AudioParam>("playbackRate", 1.0, 0.0, 32.0);
+        m_rateJitter = make_shared<AudioParam>("rateJitter", 0.0, 0.0, 32.0);
+        m_amplitude = make_shared<AudioParam>("amplitude", 1.0, 0.0, 10.0);
+
+        m_params.push_back(m_grainRate);
+        m_params.push_back(m_grainDuration);
+        m_params.push_back(m_position);
+        m_params.push_back(m_positionJitter);
+        m_params.push_back(m_playbackRate);
+        m_params.push_back(m_rateJitter);
+        m_params.push_back(m_amplitude);
+
+        m_window->setUint32(static_cast<uint32_t>(window_hanning));
+        m_settings.push_back(m_window);
+
+        m_grainPosition.reserve(MaxGrains);
+        m_grainIncrement.reserve(MaxGrains);
+        m_grainWindowPhase.reserve(MaxGrains);
+        m_grainWindowStep.reserve(MaxGrains);
+        m_grainGain.reserve(MaxGrains);
+        m_grainFramesLeft.reserve(MaxGrains);
+
+        // Seed the jitter generator from the node id so layered clouds decorrelate.
+        m_jitterState = 0x2545f491u + static_cast<uint32_t>(id()) * 0x9e3779b9u;
+
+        addOutput(std::unique_ptr<AudioNodeOutput>(new AudioNodeOutput(this, 1)));
+
+        initialize();
+    }
+
+    GranularNode::~GranularNode()
+    {
+        uninitialize();
+    }
+
+    bool GranularNode::setBus(ContextRenderLock & r, std::shared_ptr<AudioBus> sourceBus)
+    {
+        ASSERT(r.context());
+
+        if (sourceBus)
+        {
+            size_t numberOfChannels = sourceBus->numberOfChannels();
+            if (!numberOfChannels || numberOfChannels > AudioContext::maxNumberOfChannels)
+                return false;
+
+            output(0)->setNumberOfChannels(r, numberOfChannels);
+        }
+
+        m_sourceBus = sourceBus;
+        m_activeGrains = 0;
+        m_spawnAccumulator = 0;
+        return true;
+    }
+
+    WindowType GranularNode::window() const
+    {
+        return static_cast<WindowType>(m_window->valueUint32());
+    }
+
+    void GranularNode::setWindow(WindowType type)
+    {
+        m_window->setUint32(static_cast<uint32_t>(type));
+    }
+
+    void GranularNode::rebuildWindowTable()
+    {
+        std::vector<float> table(WindowTableSize, 1.f);
+        applyWindow(window(), table);
+
+        m_windowTable.assign(table.begin(), table.end());
+        m_windowTable.push_back(table.back());  // guard entry for the grain's final frame
+
+        m_windowTableType = window();
+        m_windowTableValid = true;
+    }
+
+    float GranularNode::jitter()
+    {
+        m_jitterState = xorshift32(m_jitterState);
+        return static_cast<int32_t>(m_jitterState) * (1.f / 2147483648.f);
+    }
+
+    void GranularNode::spawnGrain(float startFrame, float increment, float grainFrames, float gain, float sourceFrames)
+    {
+        if (m_activeGrains >= MaxGrains || increment <= 0 || grainFrames < 2)
+            return;
+
+        // Truncate so position + frames * increment never reaches the last
+        // interpolation tap; the render loop is then branch-free.
+        float framesAvailable = (sourceFrames - 2.f - startFrame) / increment;
+        int frames = static_cast<int>(std::min(grainFrames, framesAvailable));
+        if (frames < 2)
+            return;
+
+        if (m_activeGrains == m_grainPosition.size())
+        {
+            m_grainPosition.push_back(0);
+            m_grainIncrement.push_back(0);
+            m_grainWindowPhase.push_back(0);
+            m_grainWindowStep.push_back(0);
+            m_grainGain.push_back(0);
+            m_grainFramesLeft.push_back(0);
+        }
+
+        size_t g = m_activeGrains++;
+        m_grainPosition[g] = startFrame;
+        m_grainIncrement[g] = increment;
+        m_grainWindowPhase[g] = 0;
+        m_grainWindowStep[g] = static_cast<float>(WindowTableSize) / grainFrames;
+        m_grainGain[g] = gain;
+        m_grainFramesLeft[g] = frames;
+    }
+
+    void GranularNode::process(ContextRenderLock & r, size_t framesToProcess)
+    {
+        AudioBus * outputBus = output(0)->bus(r);
+
+        auto srcBus = getBus();
+        if (!isInitialized() || !outputBus->numberOfChannels() || !srcBus || !r.context())
+        {
+            outputBus->zero();
+            return;
+        }
+
+        size_t numChannels = outputBus->numberOfChannels();
+        if (numChannels != srcBus->numberOfChannels())
+        {
+            outputBus->zero();
+            return;
+        }
+
+        size_t quantumFrameOffset;
+        size_t nonSilentFramesToProcess;
+        updateSchedulingInfo(r, framesToProcess, outputBus, quantumFrameOffset, nonSilentFramesToProcess);
+
+        outputBus->zero();
+
+        if (!nonSilentFramesToProcess && !m_activeGrains)
+            return;
+
+        if (!m_windowTableValid || m_windowTableType != window())
+            rebuildWindowTable();
+
+        float sampleRate = r.context()->sampleRate();
+        float sourceFrames = static_cast<float>(srcBus->length());
+        if (sourceFrames < 4)
+            return;
+
+        int n = static_cast<int>(framesToProcess);
+
+        // 1) Render grains already sounding across the whole quantum,
+        //    swap-removing the ones that finish.
+        for (size_t g = 0; g < m_activeGrains;)
+        {
+            int frames = std::min(n, m_grainFramesLeft[g]);
+
+            for (size_t i = 0; i < numChannels; ++i)
+            {
+                renderGrain(srcBus->channel(static_cast<unsigned>(i))->data(), m_windowTable.data(),
+                            m_grainPosition[g], m_grainIncrement[g],
+                            m_grainWindowPhase[g], m_grainWindowStep[g],
+                            m_grainGain[g], outputBus->channel(static_cast<unsigned>(i))->mutableData(), frames);
+            }
+
+            m_grainPosition[g] += frames * m_grainIncrement[g];
+            m_grainWindowPhase[g] += frames * m_grainWindowStep[g];
+            m_grainFramesLeft[g] -= frames;
+
+            if (m_grainFramesLeft[g] <= 0)
+            {
+                size_t last = --m_activeGrains;
+                m_grainPosition[g] = m_grainPosition[last];
+                m_grainIncrement[g] = m_grainIncrement[last];
+                m_grainWindowPhase[g] = m_grainWindowPhase[last];
+                m_grainWindowStep[g] = m_grainWindowStep[last];
+                m_grainGain[g] = m_grainGain[last];
+                m_grainFramesLeft[g] = m_grainFramesLeft[last];
+            }
+            else
+            {
+                ++g;
+            }
+        }
+
+        // 2) Spawn new grains over the scheduled span and render their first
+        //    frames in place. Parameters are sampled once per quantum.
+        if (nonSilentFramesToProcess)
+        {
+            double grainsPerFrame = m_grainRate->value(r) / sampleRate;
+            float grainFrames = m_grainDuration->value(r) * sampleRate;
+            float center = m_position->value(r);
+            float centerJitter = m_positionJitter->value(r);
+            float rate = m_playbackRate->value(r);
+            float rateJitterAmount = m_rateJitter->value(r);
+            float gain = m_amplitude->value(r);
+            float sampleRateRatio = srcBus->sampleRate() / sampleRate;
+
+            int spanEnd = static_cast<int>(quantumFrameOffset + nonSilentFramesToProcess);
+            for (int k = static_cast<int>(quantumFrameOffset); k < spanEnd; ++k)
+            {
+                m_spawnAccumulator += grainsPerFrame;
+                while (m_spawnAccumulator >= 1.0)
+                {
+                    m_spawnAccumulator -= 1.0;
+
+                    float normalized = center + jitter() * centerJitter;
+                    normalized = std::max(0.f, std::min(1.f, normalized));
+                    float startFrame = normalized * (sourceFrames - 4.f);
+
+                    float increment = (rate + jitter() * rateJitterAmount) * sampleRateRatio;
+                    if (increment <= 0)
+                        continue;
+
+                    size_t g = m_activeGrains;
+                    spawnGrain(startFrame, increment, grainFrames, gain, sourceFrames);
+                    if (m_activeGrains == g)
+                        continue;  // pool exhausted or degenerate grain
+
+                    int frames = std::min(n - k, m_grainFramesLeft[g]);
+                    for (size_t i = 0; i < numChannels; ++i)
+                    {
+                        renderGrain(srcBus->channel(static_cast<unsigned>(i))->data(), m_windowTable.data(),
+                                    m_grainPosition[g], m_grainIncrement[g],
+                                    m_grainWindowPhase[g], m_grainWindowStep[g],
+                                    m_grainGain[g], outputBus->channel(static_cast<unsigned>(i))->mutableData() + k, frames);
+                    }
+                    m_grainPosition[g] += frames * m_grainIncrement[g];
+                    m_grainWindowPhase[g] += frames * m_grainWindowStep[g];
+                    m_grainFramesLeft[g] -= frames;
+
+                    if (m_grainFramesLeft[g] <= 0)
+                        --m_activeGrains;  // fit entirely inside this quantum
+                }
+            }
+        }
+
+        outputBus->clearSilentFlag();
+    }
+
+    void GranularNode::reset(ContextRenderLock & r)
+    {
+        m_activeGrains = 0;
+        m_spawnAccumulator = 0;
+        AudioScheduledSourceNode::reset(r);
+    }
+
+    bool GranularNode::propagatesSilence(ContextRenderLock & r) const
+    {
+        // Grains spawned before a stop keep sounding until they run out.
+        return (!isPlayingOrScheduled() || hasFinished() || !m_sourceBus) && !m_activeGrains;
+    }
+
+} // namespace lab
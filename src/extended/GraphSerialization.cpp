@@ -0,0 +1,452 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/GraphSerialization.h"
+
+#include "LabSound/core/AnalyserNode.h"
+#include "LabSound/core/AudioBusPool.h"
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/AudioDestinationNode.h"
+#include "LabSound/core/AudioNode.h"
+#include "LabSound/core/AudioNodeInput.h"
+#include "LabSound/core/AudioNodeOutput.h"
+#include "LabSound/core/AudioParam.h"
+#include "LabSound/core/AudioSetting.h"
+#include "LabSound/core/BiquadFilterNode.h"
+#include "LabSound/core/ChannelMergerNode.h"
+#include "LabSound/core/ChannelSplitterNode.h"
+#include "LabSound/core/ConvolverNode.h"
+#include "LabSound/core/DelayNode.h"
+#include "LabSound/core/DynamicsCompressorNode.h"
+#include "LabSound/core/GainNode.h"
+#include "LabSound/core/OscillatorNode.h"
+#include "LabSound/core/PannerNode.h"
+#include "LabSound/core/SampledAudioNode.h"
+#include "LabSound/core/StereoPannerNode.h"
+#include "LabSound/core/WaveShaperNode.h"
+#include "LabSound/extended/AudioContextLock.h"
+
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <typeindex>
+
+namespace lab
+{
+
+namespace
+{
+    // 'LSG1' - LabSound graph, format version 1.
+    const uint32_t kMagic = 0x3147534Cu;
+    const uint32_t kVersion = 1;
+
+    struct NodeType
+    {
+        std::string name;
+        std::function<std::shared_ptr<AudioNode>(float)> factory;
+    };
+
+    std::mutex s_registryMutex;
+
+    std::map<std::type_index, NodeType> & typeRegistry()
+    {
+        static std::map<std::type_index, NodeType> registry;
+        return registry;
+    }
+
+    std::map<std::string, std::function<std::shared_ptr<AudioNode>(float)>> & nameRegistry()
+    {
+        static std::map<std::string, std::function<std::shared_ptr<AudioNode>(float)>> registry;
+        return registry;
+    }
+
+    void registerLocked(const std::type_info & type, const char * name,
+                        std::function<std::shared_ptr<AudioNode>(float)> factory)
+    {
+        typeRegistry()[std::type_index(type)] = {name, factory};
+        nameRegistry()[name] = factory;
+    }
+
+    template <typename NodeT>
+    void registerDefault(const char * name)
+    {
+        registerLocked(typeid(NodeT), name, [](float) { return std::make_shared<NodeT>(); });
+    }
+
+    template <typename NodeT>
+    void registerWithRate(const char * name)
+    {
+        registerLocked(typeid(NodeT), name, [](float sampleRate) { return std::make_shared<NodeT>(sampleRate); });
+    }
+
+    // The standard processing node set. Types carrying bulk payloads
+    // (SampledAudioNode, ConvolverNode, WaveShaperNode) round-trip their
+    // topology and settings; the payload is restored by the caller.
+    void ensureBuiltinsLocked()
+    {
+        if (!typeRegistry().empty())
+            return;
+
+        registerDefault<AnalyserNode>("AnalyserNode");
+        registerDefault<BiquadFilterNode>("BiquadFilterNode");
+        registerDefault<ChannelMergerNode>("ChannelMergerNode");
+        registerDefault<ChannelSplitterNode>("ChannelSplitterNode");
+        registerDefault<ConvolverNode>("ConvolverNode");
+        registerDefault<DynamicsCompressorNode>("DynamicsCompressorNode");
+        registerDefault<GainNode>("GainNode");
+        registerDefault<SampledAudioNode>("SampledAudioNode");
+        registerDefault<WaveShaperNode>("WaveShaperNode");
+        registerWithRate<DelayNode>("DelayNode");
+        registerWithRate<OscillatorNode>("OscillatorNode");
+        registerWithRate<PannerNode>("PannerNode");
+        registerWithRate<StereoPannerNode>("StereoPannerNode");
+    }
+
+    // Little binary writer/reader. All integers are 32 bit little-endian
+    // except the one-byte flags; floats are IEEE bit patterns.
+    void writeU32(std::vector<uint8_t> & out, uint32_t v)
+    {
+        out.push_back(uint8_t(v));
+        out.push_back(uint8_t(v >> 8));
+        out.push_back(uint8_t(v >> 16));
+        out.push_back(uint8_t(v >> 24));
+    }
+
+    void writeF32(std::vector<uint8_t> & out, float f)
+    {
+        uint32_t v;
+        memcpy(&v, &f, sizeof(v));
+        writeU32(out, v);
+    }
+
+    void writeStr(std::vector<uint8_t> & out, const std::string & s)
+    {
+        writeU32(out, static_cast<uint32_t>(s.size()));
+        out.insert(out.end(), s.begin(), s.end());
+    }
+
+    struct Reader
+    {
+        const uint8_t * p = nullptr;
+        size_t remaining = 0;
+        bool ok = true;
+
+        uint32_t u32()
+        {
+            if (remaining < 4)
+            {
+                ok = false;
+                return 0;
+            }
+            uint32_t v = uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+            p += 4;
+            remaining -= 4;
+            return v;
+        }
+
+        uint8_t u8()
+        {
+            if (!remaining)
+            {
+                ok = false;
+                return 0;
+            }
+            --remaining;
+            return *p++;
+        }
+
+        float f32()
+        {
+            uint32_t v = u32();
+            float f;
+            memcpy(&f, &v, sizeof(f));
+            return f;
+        }
+
+        std::string str()
+        {
+            uint32_t length = u32();
+            if (remaining < length)
+            {
+                ok = false;
+                return {};
+            }
+            std::string s(reinterpret_cast<const char *>(p), length);
+            p += length;
+            remaining -= length;
+            return s;
+        }
+    };
+
+    struct Connection
+    {
+        uint32_t src, srcOutput, dst, dstInput;
+    };
+}  // namespace
+
+void registerGraphNodeType(const std::type_info & type, const char * name,
+                           std::function<std::shared_ptr<AudioNode>(float sampleRate)> factory)
+{
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    ensureBuiltinsLocked();
+    registerLocked(type, name, factory);
+}
+
+std::vector<uint8_t> serializeGraph(ContextRenderLock & r, AudioContext & context)
+{
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    ensureBuiltinsLocked();
+
+    auto destination = context.destination();
+    if (!destination)
+        return {};
+
+    // Walk the rendering snapshot from the destination, assigning each
+    // reachable registered node an index; the destination is index 0 and is
+    // not serialized (the loading context supplies its own).
+    std::vector<AudioNode *> nodes;
+    std::map<AudioNode *, uint32_t> indices;
+    std::vector<std::string> typeNames;  // per node, from index 1
+
+    nodes.push_back(destination.get());
+    indices[destination.get()] = 0;
+
+    std::vector<AudioNode *> pending{destination.get()};
+    std::vector<Connection> connections;
+
+    while (!pending.empty())
+    {
+        AudioNode * node = pending.back();
+        pending.pop_back();
+        uint32_t dstIndex = indices[node];
+
+        for (size_t i = 0; i < node->numberOfInputs(); ++i)
+        {
+            auto input = node->input(i);
+            if (!input)
+                continue;
+
+            size_t count = input->numberOfRenderingConnections(r);
+            for (size_t j = 0; j < count; ++j)
+            {
+                auto output = input->renderingOutput(r, j);
+                if (!output || !output->node())
+                    continue;
+
+                AudioNode * source = output->node();
+                auto found = indices.find(source);
+                if (found == indices.end())
+                {
+                    auto type = typeRegistry().find(std::type_index(typeid(*source)));
+                    if (type == typeRegistry().end())
+                        continue;  // unregistered type: omitted with its connections
+
+                    found = indices.insert({source, static_cast<uint32_t>(nodes.size())}).first;
+                    nodes.push_back(source);
+                    typeNames.push_back(type->second.name);
+                    pending.push_back(source);
+                }
+
+                uint32_t srcOutput = 0;
+                for (size_t k = 0; k < source->numberOfOutputs(); ++k)
+                {
+                    if (source->output(k).get() == output)
+                    {
+                        srcOutput = static_cast<uint32_t>(k);
+                        break;
+                    }
+                }
+
+                connections.push_back({found->second, srcOutput, dstIndex, static_cast<uint32_t>(i)});
+            }
+        }
+    }
+
+    // Gather params and settings by name, and the output-bus census that
+    // lets the loader prime the render bus pool before construction.
+    struct ParamRecord { uint32_t node; std::string name; float value; };
+    struct SettingRecord { uint32_t node; std::string name; bool asFloat; float f; uint32_t u; };
+    std::vector<ParamRecord> params;
+    std::vector<SettingRecord> settings;
+    std::map<uint32_t, uint32_t> busCensus;  // channel count -> bus count
+
+    for (size_t i = 1; i < nodes.size(); ++i)
+    {
+        AudioNode * node = nodes[i];
+        for (auto & name : node->params())
+        {
+            auto param = node->getParam(name.c_str());
+            if (param)
+                params.push_back({static_cast<uint32_t>(i), name, param->value(r)});
+        }
+        for (auto & name : node->settings())
+        {
+            auto setting = node->getSetting(name.c_str());
+            if (setting)
+                settings.push_back({static_cast<uint32_t>(i), name, setting->floatAssigned(),
+                                    setting->valueFloat(), setting->valueUint32()});
+        }
+        for (size_t k = 0; k < node->numberOfOutputs(); ++k)
+        {
+            auto output = node->output(k);
+            if (output && output->numberOfChannels())
+                ++busCensus[static_cast<uint32_t>(output->numberOfChannels())];
+        }
+    }
+
+    std::vector<uint8_t> out;
+    writeU32(out, kMagic);
+    writeU32(out, kVersion);
+    writeF32(out, context.sampleRate());
+    writeU32(out, static_cast<uint32_t>(nodes.size()));
+    writeU32(out, static_cast<uint32_t>(connections.size()));
+    writeU32(out, static_cast<uint32_t>(params.size()));
+    writeU32(out, static_cast<uint32_t>(settings.size()));
+    writeU32(out, static_cast<uint32_t>(busCensus.size()));
+
+    for (auto & entry : busCensus)
+    {
+        writeU32(out, entry.first);
+        writeU32(out, entry.second);
+    }
+
+    for (auto & name : typeNames)
+        writeStr(out, name);
+
+    for (auto & record : params)
+    {
+        writeU32(out, record.node);
+        writeStr(out, record.name);
+        writeF32(out, record.value);
+    }
+
+    for (auto & record : settings)
+    {
+        writeU32(out, record.node);
+        writeStr(out, record.name);
+        out.push_back(record.asFloat ? 1 : 0);
+        writeF32(out, record.f);
+        writeU32(out, record.u);
+    }
+
+    for (auto & connection : connections)
+    {
+        writeU32(out, connection.src);
+        writeU32(out, connection.srcOutput);
+        writeU32(out, connection.dst);
+        writeU32(out, connection.dstInput);
+    }
+
+    return out;
+}
+
+std::vector<std::shared_ptr<AudioNode>> deserializeGraph(AudioContext & context,
+                                                         const uint8_t * data, size_t size)
+{
+    return deserializeGraph(context, data, size, context.destination());
+}
+
+std::vector<std::shared_ptr<AudioNode>> deserializeGraph(AudioContext & context,
+                                                         const uint8_t * data, size_t size,
+                                                         std::shared_ptr<AudioNode> root)
+{
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    ensureBuiltinsLocked();
+
+    Reader in{data, size};
+    if (in.u32() != kMagic || in.u32() != kVersion)
+        return {};
+
+    in.f32();  // authoring sample rate; nodes are built at the context's own
+    uint32_t nodeCount = in.u32();
+    uint32_t connectionCount = in.u32();
+    uint32_t paramCount = in.u32();
+    uint32_t settingCount = in.u32();
+    uint32_t primeCount = in.u32();
+    if (!in.ok || !nodeCount)
+        return {};
+
+    // Pre-size the render bus pool from the header's census so the rebuilt
+    // graph's first quanta recycle busses instead of allocating them.
+    for (uint32_t i = 0; i < primeCount; ++i)
+    {
+        uint32_t channels = in.u32();
+        uint32_t count = in.u32();
+        if (!in.ok)
+            return {};
+        context.renderBusPool().prime(channels, count);
+    }
+
+    float sampleRate = context.sampleRate();
+    std::vector<std::shared_ptr<AudioNode>> nodes;
+    nodes.reserve(nodeCount);
+    nodes.push_back(root ? root : context.destination());
+
+    for (uint32_t i = 1; i < nodeCount; ++i)
+    {
+        std::string typeName = in.str();
+        if (!in.ok)
+            return {};
+        auto factory = nameRegistry().find(typeName);
+        if (factory == nameRegistry().end())
+            return {};
+        nodes.push_back(factory->second(sampleRate));
+    }
+
+    for (uint32_t i = 0; i < paramCount; ++i)
+    {
+        uint32_t node = in.u32();
+        std::string name = in.str();
+        float value = in.f32();
+        if (!in.ok || node >= nodes.size())
+            return {};
+        if (auto param = nodes[node]->getParam(name.c_str()))
+            param->setValue(value);
+    }
+
+    for (uint32_t i = 0; i < settingCount; ++i)
+    {
+        uint32_t node = in.u32();
+        std::string name = in.str();
+        bool asFloat = in.u8() != 0;
+        float f = in.f32();
+        uint32_t u = in.u32();
+        if (!in.ok || node >= nodes.size())
+            return {};
+        if (auto setting = nodes[node]->getSetting(name.c_str()))
+        {
+            if (asFloat)
+                setting->setFloat(f);
+            else
+                setting->setUint32(u);
+        }
+    }
+
+    // The whole topology goes down as one transaction: validated up front,
+    // queued under one lock acquisition, one graph-thread wakeup.
+    std::vector<AudioContext::ConnectionOperation> ops;
+    ops.reserve(connectionCount);
+    for (uint32_t i = 0; i < connectionCount; ++i)
+    {
+        uint32_t src = in.u32();
+        uint32_t srcOutput = in.u32();
+        uint32_t dst = in.u32();
+        uint32_t dstInput = in.u32();
+        if (!in.ok || src >= nodes.size() || dst >= nodes.size())
+            return {};
+
+        AudioContext::ConnectionOperation op;
+        op.destination = nodes[dst];
+        op.source = nodes[src];
+        op.destIndex = dstInput;
+        op.srcIndex = srcOutput;
+        ops.push_back(op);
+    }
+
+    context.applyConnectionBatch(ops);
+
+    return nodes;
+}
+
+}  // namespace lab
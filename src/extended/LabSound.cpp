@@ -8,6 +8,8 @@
 #include "LabSound/extended/AudioContextLock.h"
 #include "LabSound/extended/Logging.h"
 
+#include "internal/AudioDestination.h"
+
 #include <atomic>
 #include <chrono>
 #include <iostream>
@@ -28,6 +30,11 @@ std::shared_ptr<AudioHardwareSourceNode> MakeHardwareSourceNode(ContextRenderLoc
     return inputNode;
 }
 
+float HardwareSampleRate()
+{
+    return AudioDestination::hardwareSampleRate();
+}
+
 std::unique_ptr<lab::AudioContext> MakeRealtimeAudioContext(uint32_t numChannels, float sample_rate)
 {
     LOG("Initialize Realtime Context");
@@ -37,6 +44,16 @@ std::unique_ptr<lab::AudioContext> MakeRealtimeAudioContext(uint32_t numChannels
     return ctx;
 }
 
+std::unique_ptr<lab::AudioContext> MakeSharedRealtimeAudioContext(uint32_t numChannels, float sample_rate)
+{
+    LOG("Initialize Realtime Context (shared device)");
+    std::unique_ptr<AudioContext> ctx(new lab::AudioContext(false));
+    const bool useSharedDevice = true;
+    ctx->setDestinationNode(std::make_shared<lab::DefaultAudioDestinationNode>(ctx.get(), numChannels, sample_rate, useSharedDevice));
+    ctx->lazyInitialize();
+    return ctx;
+}
+
 std::unique_ptr<lab::AudioContext> MakeOfflineAudioContext(uint32_t numChannels, float recordTimeMilliseconds)
 {
     LOG("Initialize Offline Context");
@@ -115,22 +132,5 @@ char const * const * const AudioNodeNames()
 #define _CRT_SECURE_NO_WARNINGS
 #endif
 
-void LabSoundLog(const char * file, int line, const char * fmt, ...)
-{
-    va_list args;
-    va_start(args, fmt);
-
-    char tmp[256] = {0};
-    sprintf(tmp, "[%s @ %i]\n\t%s\n", file, line, fmt);
-    vprintf(tmp, args);
-
-    va_end(args);
-}
-
-void LabSoundAssertLog(const char * file_, int line, const char * function_, const char * assertion_)
-{
-    const char * file = file_ ? file_ : "Unknown source file";
-    const char * function = function_ ? function_ : "";
-    const char * assertion = assertion_ ? assertion_ : "Assertion failed";
-    printf("Assertion: %s:%s:%d - %s\n", function, file_, line, assertion);
-}
+// LabSoundLog and LabSoundAssertLog live in Logging.cpp, which queues
+// records to a background writer so call sites never block on io.
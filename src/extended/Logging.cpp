@@ -0,0 +1,409 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/Logging.h"
+
+#include "LabSound/core/MpscQueue.h"
+
+#include "internal/AudioThreads.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+using namespace lab;
+
+// A log record captures everything needed to format later: the file, line
+// and format string are string literals so their pointers are stable; the
+// arguments are decoded from the va_list by walking the format string and
+// stored as tagged 8-byte slots. Strings are the exception - the pointed-at
+// buffer may be a temporary, so %s copies into the slot, truncating.
+enum class ArgKind : uint8_t
+{
+    None = 0,
+    Int,       // d, i, c and friends, widened to long long
+    Uint,      // u, o, x, X
+    Double,    // f, F, e, E, g, G, a, A
+    Pointer,   // p
+    String,    // s, copied inline
+};
+
+struct LogArg
+{
+    ArgKind kind = ArgKind::None;
+    union
+    {
+        long long i;
+        unsigned long long u;
+        double d;
+        const void * p;
+        char s[64];
+    };
+};
+
+const int MaxLogArgs = 6;
+
+struct LogRecord
+{
+    const char * file = nullptr;
+    const char * fmt = nullptr;
+    int line = 0;
+    int argCount = 0;
+    LogArg args[MaxLogArgs];
+};
+
+// Records flow through the core bounded lock-free queue: depositing never
+// takes a lock and never blocks - a full queue drops the record and counts
+// it. Written records are counted so flush() can wait for exactly the
+// deposits that preceded it.
+const size_t RingSize = 1024;
+
+class LogBackend
+{
+public:
+
+    LogBackend()
+        : m_queue(RingSize)
+    {
+        m_writerThread = std::thread(&LogBackend::writerLoop, this);
+    }
+
+    ~LogBackend()
+    {
+        m_shouldExit = true;
+        if (m_writerThread.joinable())
+            m_writerThread.join();
+        drain();  // write anything still queued at process exit
+    }
+
+    bool deposit(const LogRecord & record)
+    {
+        if (m_queue.try_push(record))
+        {
+            m_deposited.fetch_add(1, std::memory_order_release);
+            return true;
+        }
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    void flush()
+    {
+        uint64_t target = m_deposited.load(std::memory_order_acquire);
+        while (m_written.load(std::memory_order_acquire) < target)
+            std::this_thread::yield();
+    }
+
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    static void write(const LogRecord & record);
+
+private:
+
+    void writerLoop()
+    {
+        ApplyThreadPolicy(AudioContext::ThreadRole::Background, "log writer");
+        while (!m_shouldExit)
+        {
+            if (!writeOne())
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+
+    void drain()
+    {
+        while (writeOne()) {}
+    }
+
+    bool writeOne()
+    {
+        LogRecord record;
+        if (!m_queue.try_pop(record))
+            return false;
+        write(record);
+        m_written.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    mpsc_queue<LogRecord> m_queue;
+    std::atomic<uint64_t> m_deposited{0};
+    std::atomic<uint64_t> m_written{0};
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<bool> m_shouldExit{false};
+    std::thread m_writerThread;
+};
+
+LogBackend & backend()
+{
+    static LogBackend instance;
+    return instance;
+}
+
+std::atomic<bool> s_synchronous{false};
+
+// Walks one conversion specification starting at the '%'; returns the
+// character past it and the kind of argument it consumes.
+const char * parseSpecifier(const char * p, ArgKind & kind)
+{
+    ++p;  // past '%'
+    if (*p == '%')
+    {
+        kind = ArgKind::None;
+        return p + 1;
+    }
+
+    // flags, width, precision
+    while (*p && strchr("-+ #0.123456789", *p))
+        ++p;
+
+    // length modifiers
+    int longCount = 0;
+    while (*p == 'l' || *p == 'h' || *p == 'z' || *p == 'j' || *p == 't')
+    {
+        if (*p == 'l')
+            ++longCount;
+        ++p;
+    }
+
+    switch (*p)
+    {
+        case 'd': case 'i': case 'c':
+            kind = ArgKind::Int;
+            break;
+        case 'u': case 'o': case 'x': case 'X':
+            kind = ArgKind::Uint;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            kind = ArgKind::Double;
+            break;
+        case 's':
+            kind = ArgKind::String;
+            break;
+        case 'p':
+            kind = ArgKind::Pointer;
+            break;
+        default:
+            kind = ArgKind::None;
+            break;
+    }
+
+    (void) longCount;
+    return *p ? p + 1 : p;
+}
+
+// Pulls arguments off the va_list in the order the format string consumes
+// them. Returns false if the format needs more slots than a record holds.
+bool captureArgs(const char * fmt, va_list args, LogRecord & record)
+{
+    record.argCount = 0;
+    for (const char * p = fmt; *p;)
+    {
+        if (*p != '%')
+        {
+            ++p;
+            continue;
+        }
+
+        ArgKind kind;
+        const char * next = parseSpecifier(p, kind);
+        bool isLong = false;
+        for (const char * q = p + 1; q < next; ++q)
+            if (*q == 'l' || *q == 'z' || *q == 'j' || *q == 't')
+                isLong = true;
+        p = next;
+
+        if (kind == ArgKind::None)
+            continue;
+        if (record.argCount == MaxLogArgs)
+            return false;
+
+        LogArg & slot = record.args[record.argCount++];
+        slot.kind = kind;
+        switch (kind)
+        {
+            case ArgKind::Int:
+                slot.i = isLong ? va_arg(args, long long) : va_arg(args, int);
+                break;
+            case ArgKind::Uint:
+                slot.u = isLong ? va_arg(args, unsigned long long) : va_arg(args, unsigned int);
+                break;
+            case ArgKind::Double:
+                slot.d = va_arg(args, double);
+                break;
+            case ArgKind::Pointer:
+                slot.p = va_arg(args, void *);
+                break;
+            case ArgKind::String:
+            {
+                const char * s = va_arg(args, const char *);
+                if (!s)
+                    s = "(null)";
+                strncpy(slot.s, s, sizeof(slot.s) - 1);
+                slot.s[sizeof(slot.s) - 1] = '\0';
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+// Formats on the consumer thread, substituting the stored arguments one
+// specifier at a time; output matches what the old synchronous path printed.
+void LogBackend::write(const LogRecord & record)
+{
+    char formatted[512];
+    size_t out = 0;
+    int argIndex = 0;
+
+    auto append = [&](const char * s, size_t len) {
+        if (out + len >= sizeof(formatted))
+            len = sizeof(formatted) - 1 - out;
+        memcpy(formatted + out, s, len);
+        out += len;
+    };
+
+    for (const char * p = record.fmt; *p;)
+    {
+        if (*p != '%')
+        {
+            append(p, 1);
+            ++p;
+            continue;
+        }
+
+        ArgKind kind;
+        const char * next = parseSpecifier(p, kind);
+        if (kind == ArgKind::None && next == p + 2 && p[1] == '%')
+        {
+            append("%", 1);
+            p = next;
+            continue;
+        }
+
+        if (kind == ArgKind::None || argIndex >= record.argCount)
+        {
+            append(p, next - p);
+            p = next;
+            continue;
+        }
+
+        // Rebuild the specifier with any length modifiers replaced by "ll"
+        // for the integer kinds, since the slots widen to long long.
+        const LogArg & arg = record.args[argIndex++];
+        char spec[32];
+        size_t s = 0;
+        char conversion = *(next - 1);
+        for (const char * q = p; q < next - 1 && s < sizeof(spec) - 4; ++q)
+        {
+            if (*q == 'l' || *q == 'h' || *q == 'z' || *q == 'j' || *q == 't')
+                continue;
+            spec[s++] = *q;
+        }
+        if (arg.kind == ArgKind::Int || arg.kind == ArgKind::Uint)
+        {
+            spec[s++] = 'l';
+            spec[s++] = 'l';
+        }
+        spec[s++] = conversion;
+        spec[s] = '\0';
+
+        char piece[128];
+        int n = 0;
+        if (conversion == 'c')
+        {
+            piece[0] = (char) arg.i;
+            n = 1;
+        }
+        else
+        {
+            switch (arg.kind)
+            {
+                case ArgKind::Int: n = snprintf(piece, sizeof(piece), spec, arg.i); break;
+                case ArgKind::Uint: n = snprintf(piece, sizeof(piece), spec, arg.u); break;
+                case ArgKind::Double: n = snprintf(piece, sizeof(piece), spec, arg.d); break;
+                case ArgKind::Pointer: n = snprintf(piece, sizeof(piece), spec, arg.p); break;
+                case ArgKind::String: n = snprintf(piece, sizeof(piece), spec, arg.s); break;
+                default: break;
+            }
+        }
+        if (n > 0)
+            append(piece, (size_t) n < sizeof(piece) ? (size_t) n : sizeof(piece) - 1);
+        p = next;
+    }
+
+    formatted[out] = '\0';
+    printf("[%s @ %i]\n\t%s\n", record.file ? record.file : "", record.line, formatted);
+}
+
+}  // namespace
+
+void LabSoundLog(const char * file, int line, const char * fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+
+    if (s_synchronous.load(std::memory_order_relaxed))
+    {
+        char tmp[256] = {0};
+        snprintf(tmp, sizeof(tmp), "[%s @ %i]\n\t%s\n", file, line, fmt);
+        vprintf(tmp, args);
+        va_end(args);
+        return;
+    }
+
+    LogRecord record;
+    record.file = file;
+    record.line = line;
+    record.fmt = fmt;
+
+    if (!captureArgs(fmt, args, record))
+    {
+        // more arguments than a record holds; format here rather than lose them
+        char tmp[256] = {0};
+        snprintf(tmp, sizeof(tmp), "[%s @ %i]\n\t%s\n", file, line, fmt);
+        vprintf(tmp, args);
+        va_end(args);
+        return;
+    }
+    va_end(args);
+
+    backend().deposit(record);
+}
+
+void LabSoundAssertLog(const char * file_, int line, const char * function_, const char * assertion_)
+{
+    const char * file = file_ ? file_ : "Unknown source file";
+    const char * function = function_ ? function_ : "";
+    const char * assertion = assertion_ ? assertion_ : "Assertion failed";
+
+    // keep ordering with anything already queued, then write immediately:
+    // an assert may be the last thing this process says
+    lab::FlushLog();
+    printf("Assertion: %s:%s:%d - %s\n", function, file, line, assertion);
+    fflush(stdout);
+}
+
+namespace lab
+{
+
+void FlushLog()
+{
+    backend().flush();
+}
+
+void SetSynchronousLogging(bool synchronous)
+{
+    s_synchronous.store(synchronous, std::memory_order_relaxed);
+}
+
+uint64_t DroppedLogRecords()
+{
+    return backend().dropped();
+}
+
+}  // namespace lab
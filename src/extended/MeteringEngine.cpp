@@ -0,0 +1,531 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/MeteringEngine.h"
+
+#include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/AudioNodeOutput.h"
+#include "LabSound/extended/AudioContextLock.h"
+
+#include "internal/Biquad.h"
+#include "internal/SpectralFFTService.h"
+#include "internal/VectorMath.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+
+namespace lab
+{
+    namespace
+    {
+        const size_t kLufsMaxChannels = 8;
+        const size_t kLufsMomentarySubBlocks = 4;   // 400 ms of 100 ms sub-blocks
+        const size_t kLufsShortTermSubBlocks = 30;  // 3 s
+        const double kLufsAbsoluteGate = -70.0;     // LUFS
+        const int kLufsGateBins = 751;              // [-70, +5] in 0.1 LU steps
+
+        float powerToLoudness(double meanSquare)
+        {
+            if (meanSquare <= 0.0)
+                return -120.f;
+            return std::max(-120.f, static_cast<float>(-0.691 + 10.0 * log10(meanSquare)));
+        }
+
+        // BS.1770 K-weighting, designed at the context rate: a ~+4 dB
+        // high-shelf at 1681.97 Hz modelling the head's acoustic effect,
+        // cascaded with the RLB high-pass at 38.14 Hz. RBJ designs with the
+        // spec's exact centers and Q values; at 48 kHz they reproduce the
+        // published coefficient tables.
+        void setKWeightingStages(Biquad & shelf, Biquad & highpass, double fs)
+        {
+            const double kPi = 3.14159265358979323846;
+            {
+                const double f0 = 1681.974450955533;
+                const double gainDb = 3.999843853973347;
+                const double Q = 0.7071752369554196;
+                double A = pow(10.0, gainDb / 40.0);
+                double w0 = 2.0 * kPi * f0 / fs;
+                double alpha = sin(w0) / (2.0 * Q);
+                double k2 = 2.0 * sqrt(A) * alpha;
+                double b0 = A * ((A + 1.0) + (A - 1.0) * cos(w0) + k2);
+                double b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cos(w0));
+                double b2 = A * ((A + 1.0) + (A - 1.0) * cos(w0) - k2);
+                double a0 = (A + 1.0) - (A - 1.0) * cos(w0) + k2;
+                double a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cos(w0));
+                double a2 = (A + 1.0) - (A - 1.0) * cos(w0) - k2;
+                shelf.setNormalizedCoefficients(b0, b1, b2, a0, a1, a2);
+            }
+            {
+                const double f0 = 38.13547087602444;
+                const double Q = 0.5003270373238773;
+                double w0 = 2.0 * kPi * f0 / fs;
+                double alpha = sin(w0) / (2.0 * Q);
+                double b0 = (1.0 + cos(w0)) / 2.0;
+                double b1 = -(1.0 + cos(w0));
+                double b2 = (1.0 + cos(w0)) / 2.0;
+                double a0 = 1.0 + alpha;
+                double a1 = -2.0 * cos(w0);
+                double a2 = 1.0 - alpha;
+                highpass.setNormalizedCoefficients(b0, b1, b2, a0, a1, a2);
+            }
+        }
+
+        // BS.1770 channel weights: unity for the front channels, +1.5 dB
+        // (x1.41 in power) for surrounds, LFE excluded. Channel 3 of a
+        // 5.1-layout bus is taken as the LFE.
+        float lufsChannelWeight(size_t channel, size_t channelCount)
+        {
+            if (channelCount >= 6 && channel == 3)
+                return 0.f;
+            return channel >= 3 ? 1.41f : 1.f;
+        }
+    }
+
+    struct MeteringEngine::Tap
+    {
+        int id = 0;
+        std::shared_ptr<AudioNode> node;
+        size_t output = 0;
+
+        std::atomic<float> db{-120.f};
+        std::atomic<float> peak{0.f};
+
+        // spectral taps only
+        bool spectral = false;
+        std::vector<float> window;  // render thread accumulates here
+        size_t cursor = 0;
+        int fftClient = 0;          // registration with the shared service
+
+        // loudness taps only (see addLoudnessTap). Everything here is
+        // preallocated at add time and touched only under the tap mutex the
+        // batch pass already holds; the published LUFS values are atomics.
+        bool lufs = false;
+        bool lufsConfigured = false;                    // stages designed at the context rate
+        std::vector<std::unique_ptr<Biquad>> kWeighting;  // 2 cascaded stages per channel
+        std::vector<float> kScratch;                    // one K-weighted segment, reused per channel
+        size_t subBlockFrames = 0;                      // 100 ms at the context rate
+        size_t subBlockCursor = 0;                      // frames in the open sub-block
+        double subBlockEnergy = 0;                      // channel-weighted sum of squares
+        std::vector<double> subBlocks;                  // ring of the last 3 s of sub-block mean squares
+        uint64_t subBlockCount = 0;                     // sub-blocks closed so far
+        std::atomic<float> momentaryLufs{-120.f};
+        std::atomic<float> shortTermLufs{-120.f};
+        std::vector<double> gateBinPower;               // integrated-gate histogram: summed block power
+        std::vector<uint32_t> gateBinCount;             // and block count, per 0.1 LU bin
+
+        ~Tap()
+        {
+            if (fftClient)
+                SpectralFFTService::shared().unregisterClient(fftClient);
+        }
+    };
+
+    // The single automatic pull node that meters every tap. It produces no
+    // audio of its own; its process() is the batch pass, run by the context
+    // once per quantum after the graph has rendered.
+    class MeteringEngine::BatchNode : public AudioNode
+    {
+    public:
+        BatchNode()
+        {
+            addOutput(std::unique_ptr<AudioNodeOutput>(new AudioNodeOutput(this, 1)));
+            initialize();
+        }
+
+        virtual ~BatchNode()
+        {
+            uninitialize();
+        }
+
+        virtual void process(ContextRenderLock & r, size_t framesToProcess) override
+        {
+            output(0)->bus(r)->zero();
+
+            std::lock_guard<std::mutex> lock(m_tapMutex);
+            for (auto & tap : m_taps)
+                meter(r, *tap, framesToProcess);
+        }
+
+        virtual void reset(ContextRenderLock &) override
+        {
+            std::lock_guard<std::mutex> lock(m_tapMutex);
+            for (auto & tap : m_taps)
+            {
+                tap->db = -120.f;
+                tap->peak = 0.f;
+                tap->cursor = 0;
+                if (tap->lufs)
+                    resetLoudnessState(*tap);
+            }
+        }
+
+        // The node renders nothing, so it must not be skipped as silent.
+        virtual bool propagatesSilence(ContextRenderLock &) const override { return false; }
+
+        int add(std::shared_ptr<AudioNode> node, size_t output, size_t windowSize, bool lufs)
+        {
+            auto tap = std::make_shared<Tap>();
+            tap->id = m_nextTapId++;
+            tap->node = node;
+            tap->output = output;
+            if (windowSize)
+            {
+                tap->spectral = true;
+                tap->window.resize(windowSize, 0.f);
+                tap->fftClient = SpectralFFTService::shared().registerClient(windowSize);
+            }
+            if (lufs)
+            {
+                tap->lufs = true;
+                tap->kWeighting.resize(2 * kLufsMaxChannels);
+                for (auto & stage : tap->kWeighting)
+                    stage.reset(new Biquad());
+                tap->kScratch.resize(AudioNode::ProcessingSizeInFrames);
+                tap->subBlocks.resize(kLufsShortTermSubBlocks, 0.0);
+                tap->gateBinPower.resize(kLufsGateBins, 0.0);
+                tap->gateBinCount.resize(kLufsGateBins, 0);
+            }
+
+            std::lock_guard<std::mutex> lock(m_tapMutex);
+            m_taps.push_back(tap);
+            return tap->id;
+        }
+
+        void remove(int id)
+        {
+            std::lock_guard<std::mutex> lock(m_tapMutex);
+            for (auto it = m_taps.begin(); it != m_taps.end(); ++it)
+            {
+                if ((*it)->id == id)
+                {
+                    m_taps.erase(it);
+                    return;
+                }
+            }
+        }
+
+        std::shared_ptr<Tap> find(int id) const
+        {
+            std::lock_guard<std::mutex> lock(m_tapMutex);
+            for (auto & tap : m_taps)
+            {
+                if (tap->id == id)
+                    return tap;
+            }
+            return {};
+        }
+
+        size_t count() const
+        {
+            std::lock_guard<std::mutex> lock(m_tapMutex);
+            return m_taps.size();
+        }
+
+    private:
+        virtual double tailTime(ContextRenderLock &) const override { return 0; }
+        virtual double latencyTime(ContextRenderLock &) const override { return 0; }
+
+        void meter(ContextRenderLock & r, Tap & tap, size_t framesToProcess)
+        {
+            AudioBus * bus = tap.node->output(tap.output) ? tap.node->output(tap.output)->bus(r) : nullptr;
+            if (!bus || !bus->numberOfChannels() || bus->channel(0)->length() < framesToProcess)
+            {
+                tap.db = -120.f;
+                tap.peak = 0.f;
+                return;
+            }
+
+            size_t numberOfChannels = bus->numberOfChannels();
+            float power = 0.f;
+            float peak = 0.f;
+            for (size_t c = 0; c < numberOfChannels; ++c)
+            {
+                const float * samples = bus->channel(c)->data();
+                float channelPower = 0.f;
+                float channelPeak = 0.f;
+                VectorMath::vsvesq(samples, 1, &channelPower, framesToProcess);
+                VectorMath::vmaxmgv(samples, 1, &channelPeak, framesToProcess);
+                power += channelPower;
+                peak = std::max(peak, channelPeak);
+            }
+
+            // Protect against accidental overload due to bad values in the
+            // input stream, exactly as PowerMonitorNode does.
+            const float kMinPower = 0.000125f;
+            if (std::isinf(power) || std::isnan(power) || power < kMinPower)
+                power = kMinPower;
+
+            float rms = sqrtf(power / (numberOfChannels * framesToProcess));
+            tap.db = 20.0f * logf(rms) / logf(10.0f);
+            tap.peak = peak;
+
+            if (tap.lufs)
+                meterLoudness(r, tap, bus, framesToProcess);
+
+            if (!tap.spectral)
+                return;
+
+            // accumulate the channel sum into the window
+            size_t windowSize = tap.window.size();
+            size_t frames = std::min(framesToProcess, windowSize - tap.cursor);
+            float * window = &tap.window[tap.cursor];
+            for (size_t i = 0; i < frames; ++i)
+                window[i] = 0.f;
+            for (size_t c = 0; c < numberOfChannels; ++c)
+            {
+                const float * samples = bus->channel(c)->data();
+                VectorMath::vadd(window, 1, samples, 1, window, 1, frames);
+            }
+            tap.cursor += frames;
+
+            if (tap.cursor < windowSize)
+                return;
+
+            tap.cursor = 0;
+
+            // Hand the filled window to the shared service; a busy worker
+            // means this window is dropped, never a blocked render thread.
+            SpectralFFTService::shared().submit(tap.fftClient, tap.window.data());
+        }
+
+    public:
+
+        // Reads all three loudness values under the tap mutex, so the gate
+        // histogram scan is ordered against the batch pass that fills it.
+        Loudness loudnessFor(int id) const
+        {
+            Loudness result;
+            std::lock_guard<std::mutex> lock(m_tapMutex);
+            for (auto & tap : m_taps)
+            {
+                if (tap->id != id || !tap->lufs)
+                    continue;
+                result.momentaryLufs = tap->momentaryLufs;
+                result.shortTermLufs = tap->shortTermLufs;
+                result.integratedLufs = integratedFromGate(*tap);
+                break;
+            }
+            return result;
+        }
+
+        void resetLoudness(int id)
+        {
+            std::lock_guard<std::mutex> lock(m_tapMutex);
+            for (auto & tap : m_taps)
+            {
+                if (tap->id == id && tap->lufs)
+                {
+                    resetLoudnessState(*tap);
+                    return;
+                }
+            }
+        }
+
+    private:
+
+        static void resetLoudnessState(Tap & tap)
+        {
+            for (auto & stage : tap.kWeighting)
+                stage->reset();
+            tap.subBlockCursor = 0;
+            tap.subBlockEnergy = 0;
+            tap.subBlockCount = 0;
+            std::fill(tap.subBlocks.begin(), tap.subBlocks.end(), 0.0);
+            std::fill(tap.gateBinPower.begin(), tap.gateBinPower.end(), 0.0);
+            std::fill(tap.gateBinCount.begin(), tap.gateBinCount.end(), 0u);
+            tap.momentaryLufs = -120.f;
+            tap.shortTermLufs = -120.f;
+        }
+
+        void meterLoudness(ContextRenderLock & r, Tap & tap, AudioBus * bus, size_t framesToProcess)
+        {
+            if (!tap.lufsConfigured)
+            {
+                double fs = r.context()->sampleRate();
+                tap.subBlockFrames = static_cast<size_t>(fs / 10.0 + 0.5);
+                for (size_t c = 0; c < kLufsMaxChannels; ++c)
+                    setKWeightingStages(*tap.kWeighting[2 * c], *tap.kWeighting[2 * c + 1], fs);
+                tap.lufsConfigured = true;
+            }
+
+            size_t channels = std::min(static_cast<size_t>(bus->numberOfChannels()), kLufsMaxChannels);
+
+            // Walk the quantum in segments that never cross a 100 ms
+            // sub-block boundary nor outgrow the scratch buffer; the biquad
+            // state carries across segments.
+            size_t offset = 0;
+            while (offset < framesToProcess)
+            {
+                size_t segment = std::min(framesToProcess - offset,
+                                          std::min(tap.subBlockFrames - tap.subBlockCursor, tap.kScratch.size()));
+                for (size_t c = 0; c < channels; ++c)
+                {
+                    float weight = lufsChannelWeight(c, channels);
+                    if (weight == 0.f)
+                        continue;
+
+                    const float * samples = bus->channel(c)->data() + offset;
+                    tap.kWeighting[2 * c]->process(samples, tap.kScratch.data(), segment);
+                    tap.kWeighting[2 * c + 1]->process(tap.kScratch.data(), tap.kScratch.data(), segment);
+
+                    float energy = 0.f;
+                    VectorMath::vsvesq(tap.kScratch.data(), 1, &energy, segment);
+                    tap.subBlockEnergy += weight * energy;
+                }
+                tap.subBlockCursor += segment;
+                offset += segment;
+                if (tap.subBlockCursor >= tap.subBlockFrames)
+                    closeLoudnessSubBlock(tap);
+            }
+        }
+
+        void closeLoudnessSubBlock(Tap & tap)
+        {
+            tap.subBlocks[tap.subBlockCount % kLufsShortTermSubBlocks] =
+                tap.subBlockEnergy / static_cast<double>(tap.subBlockFrames);
+            ++tap.subBlockCount;
+            tap.subBlockCursor = 0;
+            tap.subBlockEnergy = 0;
+
+            auto meanOfLast = [&tap](size_t n) {
+                double sum = 0;
+                for (size_t i = 0; i < n; ++i)
+                    sum += tap.subBlocks[(tap.subBlockCount - 1 - i) % kLufsShortTermSubBlocks];
+                return sum / n;
+            };
+
+            if (tap.subBlockCount >= kLufsMomentarySubBlocks)
+            {
+                double blockPower = meanOfLast(kLufsMomentarySubBlocks);
+                tap.momentaryLufs = powerToLoudness(blockPower);
+
+                // Every completed momentary window is a gating block (the
+                // spec's 75% overlap); blocks below the absolute gate are
+                // discarded, the rest land in a 0.1 LU histogram so the
+                // integrated measure needs no per-block storage.
+                double blockLoudness = -0.691 + 10.0 * log10(std::max(blockPower, 1.0e-30));
+                if (blockLoudness > kLufsAbsoluteGate)
+                {
+                    int bin = static_cast<int>((blockLoudness - kLufsAbsoluteGate) * 10.0);
+                    if (bin >= kLufsGateBins)
+                        bin = kLufsGateBins - 1;
+                    tap.gateBinPower[bin] += blockPower;
+                    tap.gateBinCount[bin] += 1;
+                }
+            }
+
+            size_t shortTermBlocks = static_cast<size_t>(
+                std::min<uint64_t>(tap.subBlockCount, kLufsShortTermSubBlocks));
+            tap.shortTermLufs = powerToLoudness(meanOfLast(shortTermBlocks));
+        }
+
+        // Two passes over the histogram: the mean of everything above the
+        // absolute gate sets the relative threshold 10 LU below it, then the
+        // blocks above that threshold average into the integrated value.
+        static float integratedFromGate(const Tap & tap)
+        {
+            double totalPower = 0;
+            uint64_t totalCount = 0;
+            for (int i = 0; i < kLufsGateBins; ++i)
+            {
+                totalPower += tap.gateBinPower[i];
+                totalCount += tap.gateBinCount[i];
+            }
+            if (!totalCount)
+                return -120.f;
+
+            double relativeGate = -0.691 + 10.0 * log10(totalPower / totalCount) - 10.0;
+
+            double gatedPower = 0;
+            uint64_t gatedCount = 0;
+            for (int i = 0; i < kLufsGateBins; ++i)
+            {
+                double binLoudness = kLufsAbsoluteGate + (i + 0.5) * 0.1;
+                if (binLoudness <= relativeGate)
+                    continue;
+                gatedPower += tap.gateBinPower[i];
+                gatedCount += tap.gateBinCount[i];
+            }
+            if (!gatedCount)
+                return -120.f;
+            return powerToLoudness(gatedPower / gatedCount);
+        }
+
+        std::vector<std::shared_ptr<Tap>> m_taps;
+        mutable std::mutex m_tapMutex;
+        int m_nextTapId = 1;
+    };
+
+    MeteringEngine::MeteringEngine(std::shared_ptr<AudioContext> context)
+        : m_context(context)
+    {
+        m_batchNode = std::make_shared<BatchNode>();
+        m_context->addAutomaticPullNode(m_batchNode);
+    }
+
+    MeteringEngine::~MeteringEngine()
+    {
+        m_context->removeAutomaticPullNode(m_batchNode);
+    }
+
+    int MeteringEngine::addTap(std::shared_ptr<AudioNode> node, size_t output)
+    {
+        return m_batchNode->add(node, output, 0, false);
+    }
+
+    int MeteringEngine::addSpectralTap(std::shared_ptr<AudioNode> node, size_t windowSize, size_t output)
+    {
+        return m_batchNode->add(node, output, windowSize, false);
+    }
+
+    int MeteringEngine::addLoudnessTap(std::shared_ptr<AudioNode> node, size_t output)
+    {
+        return m_batchNode->add(node, output, 0, true);
+    }
+
+    void MeteringEngine::removeTap(int id)
+    {
+        m_batchNode->remove(id);
+    }
+
+    MeteringEngine::Levels MeteringEngine::levels(int id) const
+    {
+        Levels result;
+        if (auto tap = m_batchNode->find(id))
+        {
+            result.db = tap->db;
+            result.peak = tap->peak;
+        }
+        return result;
+    }
+
+    void MeteringEngine::spectralMag(int id, std::vector<float> & result) const
+    {
+        result.clear();
+        if (auto tap = m_batchNode->find(id))
+        {
+            if (tap->spectral)
+                SpectralFFTService::shared().readMagnitudes(tap->fftClient, result);
+        }
+    }
+
+    MeteringEngine::Loudness MeteringEngine::loudness(int id) const
+    {
+        return m_batchNode->loudnessFor(id);
+    }
+
+    void MeteringEngine::resetLoudness(int id)
+    {
+        m_batchNode->resetLoudness(id);
+    }
+
+    size_t MeteringEngine::tapCount() const
+    {
+        return m_batchNode->count();
+    }
+
+}
@@ -0,0 +1,347 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/MixerHierarchy.h"
+
+#include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/AudioNode.h"
+#include "LabSound/core/AudioNodeOutput.h"
+#include "LabSound/core/AudioParam.h"
+#include "LabSound/core/GainNode.h"
+#include "LabSound/extended/AudioContextLock.h"
+
+namespace lab
+{
+    // The single automatic pull node that performs the control-rate flatten
+    // pass. Like MeteringEngine's batch node it produces no audio and owns
+    // the records it walks, so a quantum racing the facility's teardown never
+    // touches freed state. Once per quantum it multiplies each strip's fader
+    // by every control-bus gain above it and hands the product to the strip
+    // GainNode, which de-zippers it like any other gain change.
+    class MixerHierarchy::FlattenNode : public AudioNode
+    {
+    public:
+        FlattenNode()
+        {
+            addOutput(std::unique_ptr<AudioNodeOutput>(new AudioNodeOutput(this, 1)));
+            initialize();
+        }
+
+        virtual ~FlattenNode()
+        {
+            uninitialize();
+        }
+
+        virtual void process(ContextRenderLock & r, size_t framesToProcess) override
+        {
+            output(0)->bus(r)->zero();
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto & strip : m_strips)
+            {
+                float g = strip.level->value(r);
+                const Bus * bus = findLocked(strip.bus);
+                while (bus && bus->kind == BUS_CONTROL)
+                {
+                    g *= bus->gain->value(r);
+                    bus = findLocked(bus->parent);
+                }
+                // Rendered ancestors apply their gains natively from here up.
+                strip.gain->gain()->setValue(g);
+            }
+        }
+
+        virtual void reset(ContextRenderLock &) override {}
+
+        // The node renders nothing, so it must not be skipped as silent.
+        virtual bool propagatesSilence(ContextRenderLock &) const override { return false; }
+
+        std::mutex & mutex() { return m_mutex; }
+
+        // The records; callers hold mutex() across any access.
+        std::vector<Bus> & buses() { return m_buses; }
+        std::vector<Strip> & strips() { return m_strips; }
+
+        const Bus * findLocked(int busId) const
+        {
+            for (auto & bus : m_buses)
+                if (bus.id == busId)
+                    return &bus;
+            return nullptr;
+        }
+
+    private:
+        virtual double tailTime(ContextRenderLock &) const override { return 0; }
+        virtual double latencyTime(ContextRenderLock &) const override { return 0; }
+
+        mutable std::mutex m_mutex;
+        std::vector<Bus> m_buses;
+        std::vector<Strip> m_strips;
+    };
+
+    MixerHierarchy::MixerHierarchy(std::shared_ptr<AudioContext> context)
+        : m_context(context)
+    {
+        m_flattenNode = std::make_shared<FlattenNode>();
+
+        Bus master;
+        master.id = MasterBusId;
+        master.parent = -1;
+        master.kind = BUS_RENDERED;
+        master.name = "master";
+        master.node = std::make_shared<GainNode>();
+        m_flattenNode->buses().push_back(master);
+
+        m_context->addAutomaticPullNode(m_flattenNode);
+    }
+
+    MixerHierarchy::~MixerHierarchy()
+    {
+        m_context->removeAutomaticPullNode(m_flattenNode);
+
+        std::vector<Bus> buses;
+        std::vector<Strip> strips;
+        {
+            std::lock_guard<std::mutex> lock(m_flattenNode->mutex());
+            buses.swap(m_flattenNode->buses());
+            strips.swap(m_flattenNode->strips());
+        }
+
+        auto renderedParentOf = [&buses](int busId) -> std::shared_ptr<GainNode> {
+            for (bool found = true; found;)
+            {
+                found = false;
+                for (auto & bus : buses)
+                {
+                    if (bus.id != busId)
+                        continue;
+                    if (bus.node)
+                        return bus.node;
+                    busId = bus.parent;
+                    found = true;
+                    break;
+                }
+            }
+            return {};
+        };
+
+        for (auto & strip : strips)
+        {
+            auto into = renderedParentOf(strip.bus);
+            if (into)
+                m_context->disconnect(into, strip.gain);
+            m_context->disconnect(strip.gain, strip.source);
+            m_context->reclaim(std::move(strip.gain));
+        }
+
+        for (auto & bus : buses)
+        {
+            if (!bus.node)
+                continue;
+            if (bus.id != MasterBusId)
+            {
+                auto into = renderedParentOf(bus.parent);
+                if (into)
+                    m_context->disconnect(into, bus.node);
+            }
+            m_context->reclaim(std::move(bus.node));
+        }
+    }
+
+    const MixerHierarchy::Bus * MixerHierarchy::findBus(int busId) const
+    {
+        return m_flattenNode->findLocked(busId);
+    }
+
+    const MixerHierarchy::Bus * MixerHierarchy::nearestRendered(int busId) const
+    {
+        const Bus * bus = findBus(busId);
+        while (bus && !bus->node)
+            bus = findBus(bus->parent);
+        return bus;
+    }
+
+    int MixerHierarchy::createBus(const std::string & name, int parentBus, BusKind kind)
+    {
+        Bus bus;
+        bus.parent = parentBus;
+        bus.kind = kind;
+        bus.name = name;
+
+        std::shared_ptr<GainNode> into;
+        {
+            std::lock_guard<std::mutex> lock(m_flattenNode->mutex());
+            const Bus * parent = findBus(parentBus);
+            if (!parent)
+                return 0;
+
+            bus.id = m_nextBusId++;
+            if (kind == BUS_RENDERED)
+            {
+                bus.node = std::make_shared<GainNode>();
+                into = nearestRendered(parentBus)->node;
+            }
+            else
+            {
+                bus.gain = std::make_shared<AudioParam>("gain", 1.0, 0.0, 10000.0);
+            }
+            m_flattenNode->buses().push_back(bus);
+        }
+
+        if (into)
+            m_context->connect(into, bus.node);
+
+        return bus.id;
+    }
+
+    bool MixerHierarchy::removeBus(int busId)
+    {
+        if (busId == MasterBusId)
+            return false;
+
+        Bus bus;
+        std::shared_ptr<GainNode> into;
+        {
+            std::lock_guard<std::mutex> lock(m_flattenNode->mutex());
+            auto & buses = m_flattenNode->buses();
+
+            for (auto & other : buses)
+                if (other.parent == busId)
+                    return false;
+            for (auto & strip : m_flattenNode->strips())
+                if (strip.bus == busId)
+                    return false;
+
+            for (size_t i = 0; i < buses.size(); ++i)
+            {
+                if (buses[i].id == busId)
+                {
+                    bus = std::move(buses[i]);
+                    if (bus.node)
+                        into = nearestRendered(bus.parent)->node;
+                    buses.erase(buses.begin() + i);
+                    break;
+                }
+            }
+        }
+
+        if (!bus.id)
+            return false;
+
+        if (bus.node)
+        {
+            m_context->disconnect(into, bus.node);
+            m_context->reclaim(std::move(bus.node));
+        }
+        return true;
+    }
+
+    std::shared_ptr<AudioParam> MixerHierarchy::busGain(int busId) const
+    {
+        std::lock_guard<std::mutex> lock(m_flattenNode->mutex());
+        const Bus * bus = findBus(busId);
+        if (!bus)
+            return {};
+        return bus->node ? bus->node->gain() : bus->gain;
+    }
+
+    int MixerHierarchy::addSource(std::shared_ptr<AudioNode> source, int busId, float level)
+    {
+        if (!source)
+            return 0;
+
+        Strip strip;
+        strip.bus = busId;
+        strip.source = source;
+        strip.gain = std::make_shared<GainNode>();
+        strip.gain->gain()->setValue(level);
+        strip.level = std::make_shared<AudioParam>("level", 1.0, 0.0, 10000.0);
+        strip.level->setValue(level);
+
+        std::shared_ptr<GainNode> into;
+        {
+            std::lock_guard<std::mutex> lock(m_flattenNode->mutex());
+            const Bus * rendered = nearestRendered(busId);
+            if (!rendered)
+                return 0;
+            into = rendered->node;
+
+            strip.id = m_nextStripId++;
+            m_flattenNode->strips().push_back(strip);
+        }
+
+        // source -> strip gain -> the nearest rendered bus's summing input,
+        // which mixes every strip in one vectorized pass per quantum.
+        std::vector<AudioContext::ConnectionOperation> ops(2);
+        ops[0].destination = strip.gain;
+        ops[0].source = source;
+        ops[1].destination = into;
+        ops[1].source = strip.gain;
+        m_context->applyConnectionBatch(ops);
+
+        return strip.id;
+    }
+
+    void MixerHierarchy::removeSource(int stripId)
+    {
+        Strip strip;
+        std::shared_ptr<GainNode> into;
+        {
+            std::lock_guard<std::mutex> lock(m_flattenNode->mutex());
+            auto & strips = m_flattenNode->strips();
+            for (size_t i = 0; i < strips.size(); ++i)
+            {
+                if (strips[i].id == stripId)
+                {
+                    strip = std::move(strips[i]);
+                    into = nearestRendered(strip.bus)->node;
+                    strips.erase(strips.begin() + i);
+                    break;
+                }
+            }
+        }
+
+        if (!strip.gain)
+            return;
+
+        m_context->disconnect(into, strip.gain);
+        m_context->disconnect(strip.gain, strip.source);
+        m_context->reclaim(std::move(strip.gain));
+    }
+
+    std::shared_ptr<AudioParam> MixerHierarchy::sourceLevel(int stripId) const
+    {
+        std::lock_guard<std::mutex> lock(m_flattenNode->mutex());
+        for (auto & strip : m_flattenNode->strips())
+            if (strip.id == stripId)
+                return strip.level;
+        return {};
+    }
+
+    std::shared_ptr<GainNode> MixerHierarchy::tapNode(int busId) const
+    {
+        std::lock_guard<std::mutex> lock(m_flattenNode->mutex());
+        const Bus * bus = findBus(busId);
+        return bus ? bus->node : std::shared_ptr<GainNode>();
+    }
+
+    std::shared_ptr<GainNode> MixerHierarchy::output() const
+    {
+        std::lock_guard<std::mutex> lock(m_flattenNode->mutex());
+        return findBus(MasterBusId)->node;
+    }
+
+    size_t MixerHierarchy::busCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_flattenNode->mutex());
+        return m_flattenNode->buses().size();
+    }
+
+    size_t MixerHierarchy::sourceCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_flattenNode->mutex());
+        return m_flattenNode->strips().size();
+    }
+
+}  // namespace lab
@@ -4,19 +4,214 @@
 #include "LabSound/extended/NoiseNode.h"
 
 #include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioContext.h"
 #include "LabSound/core/AudioNodeOutput.h"
 #include "LabSound/core/AudioSetting.h"
+#include "LabSound/extended/AudioContextLock.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <cstring>
 
 using namespace std;
 using namespace lab;
 
 namespace lab {
 
+    namespace {
+
+        // xorshift32 step, applied to four independent lanes so one iteration
+        // yields four samples. The mantissa-stuffing trick maps 23 random bits
+        // to [2, 4), and subtracting 3 lands uniformly in [-1, 1).
+        inline uint32_t xorshift32(uint32_t x)
+        {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            return x;
+        }
+
+        inline float whiteFromBits(uint32_t x)
+        {
+            uint32_t bits = (x >> 9) | 0x40000000u;
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            return f - 3.f;
+        }
+
+        void generateWhite(uint32_t state[4], float * dest, size_t n)
+        {
+            size_t n4 = n & ~size_t(3);
+#ifdef __SSE2__
+            __m128i x = _mm_set_epi32(state[3], state[2], state[1], state[0]);
+            const __m128i exponent = _mm_set1_epi32(0x40000000);
+            const __m128 three = _mm_set1_ps(3.f);
+
+            for (size_t i = 0; i < n4; i += 4)
+            {
+                x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+                x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+                x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+
+                __m128i bits = _mm_or_si128(_mm_srli_epi32(x, 9), exponent);
+                _mm_storeu_ps(dest + i, _mm_sub_ps(_mm_castsi128_ps(bits), three));
+            }
+
+            alignas(16) uint32_t lanes[4];
+            _mm_store_si128(reinterpret_cast<__m128i *>(lanes), x);
+            for (int lane = 0; lane < 4; ++lane)
+                state[lane] = lanes[lane];
+#else
+            for (size_t i = 0; i < n4; i += 4)
+            {
+                // four independent recurrences; auto-vectorizable
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    state[lane] = xorshift32(state[lane]);
+                    dest[i + lane] = whiteFromBits(state[lane]);
+                }
+            }
+#endif
+            for (size_t i = n4; i < n; ++i)
+            {
+                state[i & 3] = xorshift32(state[i & 3]);
+                dest[i] = whiteFromBits(state[i & 3]);
+            }
+        }
+
+        // reference: http://noisehack.com/generate-noise-web-audio-api/
+        // Paul Kellet's economy pink filter; pink[0..6] are the pole states.
+        // The first four poles update as one vector; p4/p5 stay scalar, and
+        // the states live in registers for the whole block.
+        void applyPink(float pink[7], const float * white, float * dest, size_t n)
+        {
+#ifdef __SSE2__
+            __m128 p = _mm_loadu_ps(pink);
+            const __m128 poleGain = _mm_setr_ps(0.99886f, 0.99332f, 0.96900f, 0.86650f);
+            const __m128 whiteGain = _mm_setr_ps(0.0555179f, 0.0750759f, 0.1538520f, 0.3104856f);
+            float p4 = pink[4], p5 = pink[5], p6 = pink[6];
+
+            for (size_t i = 0; i < n; ++i)
+            {
+                float w = white[i];
+                p = _mm_add_ps(_mm_mul_ps(poleGain, p), _mm_mul_ps(whiteGain, _mm_set1_ps(w)));
+                p4 = 0.55000f * p4 + w * 0.5329522f;
+                p5 = -0.7616f * p5 - w * 0.0168980f;
+
+                __m128 s = _mm_add_ps(p, _mm_movehl_ps(p, p));
+                s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+                dest[i] = (_mm_cvtss_f32(s) + p4 + p5 + p6 + (w * 0.5362f)) * 0.11f; // .11 roughly compensates gain
+                p6 = w * 0.115926f;
+            }
+
+            _mm_storeu_ps(pink, p);
+            pink[4] = p4; pink[5] = p5; pink[6] = p6;
+#else
+            float p0 = pink[0], p1 = pink[1], p2 = pink[2], p3 = pink[3];
+            float p4 = pink[4], p5 = pink[5], p6 = pink[6];
+
+            for (size_t i = 0; i < n; ++i)
+            {
+                float w = white[i];
+                p0 = 0.99886f * p0 + w * 0.0555179f;
+                p1 = 0.99332f * p1 + w * 0.0750759f;
+                p2 = 0.96900f * p2 + w * 0.1538520f;
+                p3 = 0.86650f * p3 + w * 0.3104856f;
+                p4 = 0.55000f * p4 + w * 0.5329522f;
+                p5 = -0.7616f * p5 - w * 0.0168980f;
+                dest[i] = (p0 + p1 + p2 + p3 + p4 + p5 + p6 + (w * 0.5362f)) * 0.11f; // .11 roughly compensates gain
+                p6 = w * 0.115926f;
+            }
+
+            pink[0] = p0; pink[1] = p1; pink[2] = p2; pink[3] = p3;
+            pink[4] = p4; pink[5] = p5; pink[6] = p6;
+#endif
+        }
+
+        void applyBrown(float & lastBrown, const float * white, float * dest, size_t n)
+        {
+            const float leak = 1.0f / 1.02f; // multiply instead of a per-sample divide
+            float brown = lastBrown;
+            for (size_t i = 0; i < n; ++i)
+            {
+                brown = (brown + (0.02f * white[i])) * leak;
+                dest[i] = brown * 3.5f; // roughly compensate for gain
+            }
+            lastBrown = brown;
+        }
+
+        void generateNoise(NoiseNode::NoiseType type, uint32_t whiteState[4], float pink[7], float & lastBrown, float * dest, size_t n)
+        {
+            float white[AudioNode::ProcessingSizeInFrames];
+            size_t count = n < AudioNode::ProcessingSizeInFrames ? n : size_t(AudioNode::ProcessingSizeInFrames);
+            generateWhite(whiteState, white, count);
+
+            switch (type)
+            {
+            case NoiseNode::WHITE:
+                memcpy(dest, white, count * sizeof(float));
+                break;
+            case NoiseNode::PINK:
+                applyPink(pink, white, dest, count);
+                break;
+            case NoiseNode::BROWN:
+                applyBrown(lastBrown, white, dest, count);
+                break;
+            default:
+                throw std::invalid_argument("Invalid type specified");
+            }
+        }
+
+        // One shared block per noise type, regenerated once per render quantum
+        // and tapped by every node with the sharedBus setting enabled. Render
+        // threads don't share state: thread_local keeps a context's block on
+        // its own render thread, and the (context, time) key regenerates when
+        // several contexts render on one thread (the shared-device mixer).
+        struct SharedNoiseBlock
+        {
+            AudioContext * context = nullptr;
+            double time = -1.0;
+            uint32_t whiteState[4] = { 0x6a09e667u, 0xbb67ae85u, 0x3c6ef372u, 0xa54ff53au };
+            float pink[7] = { 0, 0, 0, 0, 0, 0, 0 };
+            float lastBrown = 0;
+            float data[AudioNode::ProcessingSizeInFrames];
+        };
+
+        const float * sharedNoiseBlock(ContextRenderLock & r, NoiseNode::NoiseType type)
+        {
+            static thread_local SharedNoiseBlock s_blocks[3];
+
+            SharedNoiseBlock & block = s_blocks[type];
+            double now = r.context()->currentTime();
+            if (block.context != r.context() || block.time != now)
+            {
+                generateNoise(type, block.whiteState, block.pink, block.lastBrown, block.data, AudioNode::ProcessingSizeInFrames);
+                block.context = r.context();
+                block.time = now;
+            }
+            return block.data;
+        }
+
+    } // anonymous namespace
+
     NoiseNode::NoiseNode() : AudioScheduledSourceNode()
     , _type(std::make_shared<AudioSetting>("type"))
+    , _sharedBus(std::make_shared<AudioSetting>("sharedBus"))
     {
         addOutput(std::unique_ptr<AudioNodeOutput>(new AudioNodeOutput(this, 1)));
         m_settings.push_back(_type);
+        m_settings.push_back(_sharedBus);
+
+        // Seed the lanes from the node id so layered nodes decorrelate.
+        uint32_t seed = 1489853723u + static_cast<uint32_t>(id()) * 0x9e3779b9u;
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            seed = xorshift32(seed | 1u);
+            m_whiteState[lane] = seed;
+        }
+
         initialize();
     }
 
@@ -38,7 +233,15 @@ namespace lab {
         return NoiseType(_type->valueUint32());
     }
 
+    void NoiseNode::setUseSharedBus(bool shared)
+    {
+        _sharedBus->setUint32(shared ? 1 : 0);
+    }
 
+    bool NoiseNode::useSharedBus() const
+    {
+        return _sharedBus->valueUint32() != 0;
+    }
 
     void NoiseNode::process(ContextRenderLock& r, size_t framesToProcess)
     {
@@ -65,57 +268,30 @@ namespace lab {
         destP += quantumFrameOffset;
         size_t n = nonSilentFramesToProcess;
 
-        switch (NoiseType(_type->valueUint32())) 
+        NoiseType noiseType = NoiseType(_type->valueUint32());
+
+        if (useSharedBus())
         {
-                // reference: http://noisehack.com/generate-noise-web-audio-api/
-            case WHITE:
-                while (n--) {
-                    float white = ((float)((whiteSeed & 0x7fffffff) - 0x40000000)) * (float)(1.0f / 0x40000000);
-                    white = (white * 0.5f) - 1.0f;
-                    *destP++ = white;
-                    whiteSeed = whiteSeed * 435898247 + 382842987;
-                }
-                break;
-            case PINK:
-                while (n--) {
-                    float white = ((float)((whiteSeed & 0x7fffffff) - 0x40000000)) * (float)(1.0f / 0x40000000);
-                    white = (white * 0.5f) - 1.0f;
-                    whiteSeed = whiteSeed * 435898247 + 382842987;
-
-                    pink0 = 0.99886f * pink0 + white * 0.0555179f;
-                    pink1 = 0.99332f * pink1 + white * 0.0750759f;
-                    pink2 = 0.96900f * pink2 + white * 0.1538520f;
-                    pink3 = 0.86650f * pink3 + white * 0.3104856f;
-                    pink4 = 0.55000f * pink4 + white * 0.5329522f;
-                    pink5 = -0.7616f * pink5 - white * 0.0168980f;
-                    *destP++ = (pink0 + pink1 + pink2 + pink3 + pink4 + pink5 + pink6 + (white * 0.5362f)) * 0.11f; // .11 roughly compensates gain
-                    pink6 = white * 0.115926f;
-                }
-                break;
-            case BROWN:
-                while (n--) {
-                    float white = ((float)((whiteSeed & 0x7fffffff) - 0x40000000)) * (float)(1.0f / 0x40000000);
-                    white = (white * 0.5f) - 1.0f;
-                    whiteSeed = whiteSeed * 435898247 + 382842987;
-                    float brown = (lastBrown + (0.02f * white)) / 1.02f;
-                    *destP++ = brown * 3.5f; // roughly compensate for gain
-                    lastBrown = brown;
-                }
-                break;
-            default:
-                throw std::invalid_argument("Invalid type specified");
+            // The shared block covers the whole quantum; this node's span of
+            // it starts at the node's own render offset.
+            const float * shared = sharedNoiseBlock(r, noiseType);
+            memcpy(destP, shared + quantumFrameOffset, n * sizeof(float));
+        }
+        else
+        {
+            generateNoise(noiseType, m_whiteState, m_pink, m_lastBrown, destP, n);
         }
+
         outputBus->clearSilentFlag();
     }
 
     void NoiseNode::reset(ContextRenderLock&)
     {
     }
-    
+
     bool NoiseNode::propagatesSilence(ContextRenderLock & r) const
     {
         return !isPlayingOrScheduled() || hasFinished();
     }
-    
-} // namespace lab
 
+} // namespace lab
@@ -8,6 +8,9 @@
 
 #include "LabSound/extended/PWMNode.h"
 
+#include "internal/VectorMath.h"
+
+#include <cstring>
 #include <iostream>
 
 using namespace lab;
@@ -38,24 +41,24 @@ namespace lab {
         {
             if (!numberOfChannels())
                 return;
-            
+
             const float* carrierP = source->channelByType(Channel::Left)->data();
             const float* modP = source->channelByType(Channel::Right)->data();
 
-            if (!modP && carrierP) 
+            if (!modP && carrierP)
             {
                 destination->copyFrom(*source);
             }
-            else 
+            else
             {
+                // The pulse train is computed once with the branch-free
+                // comparator kernel, then fanned out to the remaining output
+                // channels - the comparison result is mono by construction.
                 float* destP = destination->channel(0)->mutableData();
-                size_t n = framesToProcess;
-                while (n--)
-                {
-                    float carrier = *carrierP++;
-                    float mod = *modP++;
-                    *destP++ = (carrier > mod) ? 1.0f : -1.0f;
-                }
+                VectorMath::vcomp(carrierP, modP, destP, framesToProcess);
+
+                for (unsigned int c = 1; c < destination->numberOfChannels(); ++c)
+                    memcpy(destination->channel(c)->mutableData(), destP, sizeof(float) * framesToProcess);
             }
         }
 
@@ -16,61 +16,129 @@
 #include "z_libpd.h"
 
 #include <iostream>
+#include <mutex>
+#include <vector>
 
 namespace lab {
 
-class PdNode::PdNodeInternal : public lab::AudioProcessor {
+class PureDataNode::PureDataNodeInternal : public lab::AudioProcessor {
 public:
 
-    PdNodeInternal(float sampleRate)
+    PureDataNodeInternal(float sampleRate)
     : AudioProcessor(sampleRate)
     , numChannels(2)
     , pdBuffSize(128)
+    , framesProcessed(0)
     {
     }
-    
-    virtual ~PdNodeInternal() {
+
+    virtual ~PureDataNodeInternal() {
     }
 
     // AudioProcessor interface
     virtual void initialize() {
     }
-    
+
     virtual void uninitialize() { }
-    
+
+    // A control message queued for the next quantum boundary. time is the
+    // node's stream time when the message was queued, retained so receivers
+    // that care can reconstruct ordering against the audio clock.
+    struct ControlMessage {
+        enum Type { Bang, Float, Symbol };
+        Type type;
+        std::string destination;
+        float value;
+        std::string symbol;
+        double time;
+    };
+
+    void queueMessage(ControlMessage&& m) {
+        m.time = framesProcessed / sampleRate();
+        std::lock_guard<std::mutex> lock(messageMutex);
+        pendingMessages.push_back(std::move(m));
+    }
+
+    // Drains the queue and applies the whole batch in queue order, one lock
+    // acquisition and one pass for however many messages accumulated since
+    // the previous quantum.
+    void applyPendingMessages() {
+        {
+            std::lock_guard<std::mutex> lock(messageMutex);
+            if (pendingMessages.empty())
+                return;
+            dispatchMessages.swap(pendingMessages);
+        }
+
+        for (const ControlMessage& m : dispatchMessages) {
+            switch (m.type) {
+                case ControlMessage::Bang:   pd.sendBang(m.destination); break;
+                case ControlMessage::Float:  pd.sendFloat(m.destination, m.value); break;
+                case ControlMessage::Symbol: pd.sendSymbol(m.destination, m.symbol); break;
+            }
+        }
+        dispatchMessages.clear();
+    }
+
     // Processes the source to destination bus.  The number of channels must match in source and destination.
     virtual void process(const lab::AudioBus* source, lab::AudioBus* destination, size_t framesToProcess) {
         if (!numChannels)
             return;
-        
+
+        // Apply queued control at the quantum boundary, then hand pd the
+        // whole quantum in one processFloat call - libpd runs its 64-frame
+        // ticks internally without re-crossing the bridge per tick.
+        applyPendingMessages();
+
         int ticks = framesToProcess >> blockSizeAsLog; // this is a faster way of computing (inNumberFrames / blockSize)
-        const float* inData = source->channel(0)->data();
-        float* outData = destination->channel(0)->mutableData();
-        pd.processFloat(ticks, inData, outData);
+
+        // libpd expects interleaved frames; stage through buffers sized once
+        // and reused, so the handoff is two interleave passes per quantum.
+        size_t samples = framesToProcess * numChannels;
+        if (interleavedIn.size() < samples) {
+            interleavedIn.resize(samples);
+            interleavedOut.resize(samples);
+        }
+
+        source->interleave(interleavedIn.data(), framesToProcess);
+        pd.processFloat(ticks, interleavedIn.data(), interleavedOut.data());
+        destination->deinterleave(interleavedOut.data(), framesToProcess);
+
+        framesProcessed += framesToProcess;
     }
-    
+
     // Resets filter state
     virtual void reset() { }
-    
+
     virtual void setNumberOfChannels(unsigned i) {
         numChannels = i;
     }
-    
+
     virtual double tailTime() const { return 0; }
     virtual double latencyTime() const { return 0; }
-    
+
     // return true on successful initialization
     bool initPure(const int numInChannels, const int numOutChannels,
                   const int sampleRate, const int ticksPerBuffer);
-    
+
     /// print
     virtual void print(const std::string& message);
-    
+
     pd::PdBase pd;
-    
+
     int numChannels;
     int pdBuffSize;
     int blockSizeAsLog;
+    uint64_t framesProcessed;
+
+    std::vector<float> interleavedIn;
+    std::vector<float> interleavedOut;
+
+    // Guards pendingMessages; held only for a push or a swap, never while
+    // libpd runs.
+    std::mutex messageMutex;
+    std::vector<ControlMessage> pendingMessages;
+    std::vector<ControlMessage> dispatchMessages;
 };
 
 namespace {
@@ -89,64 +157,86 @@ namespace {
 
 
 // return true on successful initialization
-bool PdNode::PdNodeInternal::initPure(const int numInChannels, const int numOutChannels,
-                                      const int sampleRate, const int ticksPerBuffer) {
-    
+bool PureDataNode::PureDataNodeInternal::initPure(const int numInChannels, const int numOutChannels,
+                                                  const int sampleRate, const int ticksPerBuffer) {
+
     if (!pd.init(numInChannels, numOutChannels, sampleRate)) {
         return false;
     }
     blockSizeAsLog = log2int(libpd_blocksize());
-    
+
     // subscribe to receive source names
     pd.subscribe("toOF");
     pd.subscribe("env");
-    
+
     // add the data/pd folder to the search path
     pd.addToSearchPath("pd");
-    
+
     // audio processing on
     pd.computeAudio(true);
-    
+
     return true;
 }
 
 //--------------------------------------------------------------
-void PdNode::PdNodeInternal::print(const std::string& message) {
+void PureDataNode::PureDataNodeInternal::print(const std::string& message) {
     std::cout << message << std::endl;
 }
 
-pd::PdBase& PdNode::pd() const {
+pd::PdBase& PureDataNode::pd() const {
     return data->pd;
 }
 
-PdNode::PdNode(lab::AudioContext* context, float sampleRate)
+void PureDataNode::sendBang(const std::string& destination) {
+    PureDataNodeInternal::ControlMessage m;
+    m.type = PureDataNodeInternal::ControlMessage::Bang;
+    m.destination = destination;
+    data->queueMessage(std::move(m));
+}
+
+void PureDataNode::sendFloat(const std::string& destination, float value) {
+    PureDataNodeInternal::ControlMessage m;
+    m.type = PureDataNodeInternal::ControlMessage::Float;
+    m.destination = destination;
+    m.value = value;
+    data->queueMessage(std::move(m));
+}
+
+void PureDataNode::sendSymbol(const std::string& destination, const std::string& symbol) {
+    PureDataNodeInternal::ControlMessage m;
+    m.type = PureDataNodeInternal::ControlMessage::Symbol;
+    m.destination = destination;
+    m.symbol = symbol;
+    data->queueMessage(std::move(m));
+}
+
+PureDataNode::PureDataNode(lab::AudioContext* context, float sampleRate)
 : lab::AudioBasicProcessorNode(context, sampleRate)
-, data(new PdNodeInternal(sampleRate))
+, data(new PureDataNodeInternal(sampleRate))
 {
-    // Initially setup as lowpass filter.
     m_processor = std::move(std::unique_ptr<lab::AudioProcessor>(data));
-    
+
     setNodeType((AudioNode::NodeType) lab::NodeTypePd);
-    
+
     addInput(adoptPtr(new lab::AudioNodeInput(this)));
     addOutput(adoptPtr(new lab::AudioNodeOutput(this, 2))); // 2 stereo
 
     data->initPure(2, 2, sampleRate, 128);
-    
+
     initialize();
 }
 
-PdNode::~PdNode() {
+PureDataNode::~PureDataNode() {
     data->numChannels = 0;  // ensure there if there is a latent callback pending, pd is not invoked
     data = 0;
     uninitialize();
 }
 
-bool PdNode::propagatesSilence() const {
+bool PureDataNode::propagatesSilence() const {
     return !data->pd.isInited();
 }
-    
-    
+
+
 } // LabSound
 
 #endif
@@ -12,6 +12,7 @@
 #include "LabSound/extended/AudioContextLock.h"
 
 #include "internal/VectorMath.h"
+#include "internal/NonlinearityTable.h"
 
 #include "LabSound/core/Macros.h"
 
@@ -55,55 +56,45 @@ namespace lab
 
         virtual void uninitialize() override { }
 
-        // Processes the source to destination bus.  The number of channels must match in source and destination.
-        virtual void process(ContextRenderLock & r, const lab::AudioBus * sourceBus, lab::AudioBus* destinationBus, size_t framesToProcess) override
+        // Derives the linear thresholds and one-pole coefficients from the
+        // user-facing parameters. Only runs when a parameter (or the sample
+        // rate) actually changed, so the pow/exp calls drop out of the
+        // steady-state render path entirely.
+        void updateCoefficients(float thresholdDb, float ratioParam, float attackMs, float releaseMs, float makeupDb, float kneeParam)
         {
-            // Get sample rate
-            internalSampleRate = r.context()->sampleRate();
-            oneOverSampleRate = 1.0 / internalSampleRate;
-
-            if (!numberOfChannels())
-                return;
-
             // copy attributes to run time variables
-            float v = m_threshold->value(r);
-            if (v <= 0) {
+            if (thresholdDb <= 0) {
                 // dB to linear (could use the function from m_pd.h)
-                threshold = powf(10.f, (v*0.05f));
+                threshold = powf(10.f, (thresholdDb * 0.05f));
             }
             else
                 threshold = 0;
 
-            v = m_ratio->value(r);
-            if (v >= 1) {
-                ratio = 1.f/v;
+            if (ratioParam >= 1) {
+                ratio = 1.f / ratioParam;
             }
             else
                 ratio = 1;
 
-            v = m_attack->value(r);
-            if (v >= 0.001f) {
-                attack = v * 0.001f;
+            if (attackMs >= 0.001f) {
+                attack = attackMs * 0.001f;
             }
             else
                 attack = 0.000001f;
 
-            v = m_release->value(r);
-            if (v >= 0.001f) {
-                release = v * 0.001f;
+            if (releaseMs >= 0.001f) {
+                release = releaseMs * 0.001f;
             }
             else
                 release = 0.000001f;
 
-            v = m_makeup->value(r);
             // dB to linear (could use the function from m_pd.h)
-            makeupGain = powf(10.f, (v * 0.05f));
+            makeupGain = powf(10.f, (makeupDb * 0.05f));
 
-            v = m_knee->value(r);
-            if (v >= 0 && v <= 1)
+            if (kneeParam >= 0 && kneeParam <= 1)
             {
                 // knee value (0 to 1) is scaled from 0 (hard) to 0.02 (smooth). Could be scaled to a larger number.
-                knee = v * 0.02f;
+                knee = kneeParam * 0.02f;
             }
 
             // calc coefficients from run time vars
@@ -115,6 +106,41 @@ namespace lab
 
             releaseCoeff = expf(0.f - (oneOverSampleRate / release));
             releaseCoeffMinus = 1.f - releaseCoeff;
+        }
+
+        // Processes the source to destination bus.  The number of channels must match in source and destination.
+        virtual void process(ContextRenderLock & r, const lab::AudioBus * sourceBus, lab::AudioBus* destinationBus, size_t framesToProcess) override
+        {
+            // Get sample rate
+            internalSampleRate = r.context()->sampleRate();
+            oneOverSampleRate = 1.0 / internalSampleRate;
+
+            if (!numberOfChannels())
+                return;
+
+            // Regenerate the derived coefficients only when a parameter
+            // changed; the key folds in every input they depend on.
+            uint64_t key = 0;
+            float thresholdDb = m_threshold->value(r);
+            float ratioParam = m_ratio->value(r);
+            float attackMs = m_attack->value(r);
+            float releaseMs = m_release->value(r);
+            float makeupDb = m_makeup->value(r);
+            float kneeParam = m_knee->value(r);
+            key = NonlinearityTable::mixKey(key, thresholdDb);
+            key = NonlinearityTable::mixKey(key, ratioParam);
+            key = NonlinearityTable::mixKey(key, attackMs);
+            key = NonlinearityTable::mixKey(key, releaseMs);
+            key = NonlinearityTable::mixKey(key, makeupDb);
+            key = NonlinearityTable::mixKey(key, kneeParam);
+            key = NonlinearityTable::mixKey(key, internalSampleRate);
+
+            if (!coefficientsValid || key != coefficientKey)
+            {
+                updateCoefficients(thresholdDb, ratioParam, attackMs, releaseMs, makeupDb, kneeParam);
+                coefficientKey = key;
+                coefficientsValid = true;
+            }
 
             // Handle both the 1 -> N and N -> N case here.
             const float * source[16];
@@ -183,6 +209,10 @@ namespace lab
 
         double makeupGain;
 
+        // Parameter fingerprint of the last updateCoefficients() run.
+        uint64_t coefficientKey = 0;
+        bool coefficientsValid = false;
+
         // Resets filter state
         virtual void reset() override { /* @tofix */ }
 
@@ -5,93 +5,258 @@
 #include "LabSound/core/AudioNodeOutput.h"
 #include "LabSound/core/AudioProcessor.h"
 #include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioContext.h"
 #include "LabSound/core/Macros.h"
 
 #include "LabSound/extended/PingPongDelayNode.h"
 #include "LabSound/extended/AudioContextLock.h"
 
 #include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
 
 using namespace lab;
 
-namespace lab 
+namespace lab
 {
+    inline int TempoSyncToIndex(TempoSync in)
+    {
+        switch(in)
+        {
+            case TS_32: return 0;
+            case TS_16T: return 1;
+            case TS_32D: return 2;
+            case TS_16: return 3;
+            case TS_8T: return 4;
+            case TS_16D: return 5;
+            case TS_8: return 6;
+            case TS_4T: return 7;
+            case TS_8D: return 8;
+            case TS_4: return 9;
+            case TS_2T: return 10;
+            case TS_4D: return 11;
+            case TS_2: return 12;
+            case TS_2D: return 13;
+            default: return 0;
+        }
+    }
+
+    //////////////////////////////////////////////
+    // Private PingPongDelayNode Implementation //
+    //////////////////////////////////////////////
+
+    class PingPongDelayNode::PingPongDelayInternal : public lab::AudioProcessor
+    {
+    public:
+
+        PingPongDelayInternal() : AudioProcessor(2)
+        {
+            m_feedback = std::make_shared<AudioParam>("feedback", 0.5f, 0, 1);
+            m_level = std::make_shared<AudioParam>("level", 1.f, 0, 1);
+            m_delayTime = std::make_shared<AudioParam>("delayTime", 0.25f, 0, float(MaxDelaySeconds));
+        }
+
+        virtual ~PingPongDelayInternal() { }
+
+        virtual void initialize() override { }
+
+        virtual void uninitialize() override { }
+
+        // One pass over a single interleaved stereo ring. Per frame: the left
+        // tap crossfeeds to the right delay line, the right tap feeds back to
+        // the left, and both taps are summed onto the dry signal. The
+        // feedback recursion makes each frame depend on the ring writes of
+        // the previous ones, so the loop is scalar by nature - but it is one
+        // loop over one buffer in place of the eight-node subgraph this used
+        // to be.
+        virtual void process(ContextRenderLock & r,
+                             const lab::AudioBus * sourceBus, lab::AudioBus * destinationBus,
+                             size_t framesToProcess) override
+        {
+            if (!numberOfChannels())
+                return;
+
+            float sampleRate = r.context()->sampleRate();
+
+            // this will only ever happen once; the ring covers the maximum
+            // tempo-synced delay
+            if (m_ring.empty())
+            {
+                size_t length = 1 + static_cast<size_t>(MaxDelaySeconds * sampleRate);
+                size_t powerOfTwo = 1;
+                while (powerOfTwo < length)
+                    powerOfTwo <<= 1;
+                m_ringFrames = powerOfTwo;
+                m_ring.assign(2 * m_ringFrames, 0.f);
+
+                // same 20ms settling as DelayDSPKernel's glide
+                m_smoothingRate = 1.0 - exp(-1.0 / (0.020 * sampleRate));
+            }
+
+            float feedback = clampTo<float>(m_feedback->value(r), 0.f, 1.f);
+            float level = clampTo<float>(m_level->value(r), 0.f, 1.f);
+            double targetDelayFrames = std::min(double(m_delayTime->value(r)) * sampleRate, double(m_ringFrames - 2));
+
+            if (m_firstTime)
+            {
+                m_currentDelayFrames = targetDelayFrames;
+                m_firstTime = false;
+            }
+
+            // Handle both the 1 -> 2 and 2 -> 2 case here.
+            const float * sourceL = sourceBus->channel(0)->data();
+            const float * sourceR = sourceBus->numberOfChannels() > 1 ? sourceBus->channel(1)->data() : sourceL;
+            float * destL = destinationBus->channel(0)->mutableData();
+            float * destR = destinationBus->numberOfChannels() > 1 ? destinationBus->channel(1)->mutableData() : destL;
+
+            float * ring = m_ring.data();
+            const size_t mask = m_ringFrames - 1;
+            size_t writeIndex = m_writeIndex;
+
+            for (size_t i = 0; i < framesToProcess; ++i)
+            {
+                // glide toward the tempo-synced delay; click-free per-bar
+                // tempo automation without touching the ring
+                m_currentDelayFrames += (targetDelayFrames - m_currentDelayFrames) * m_smoothingRate;
+
+                double readPosition = double(writeIndex + m_ringFrames) - m_currentDelayFrames;
+                size_t read1 = static_cast<size_t>(readPosition) & mask;
+                size_t read2 = (read1 + 1) & mask;
+                float frac = static_cast<float>(readPosition - floor(readPosition));
+
+                float tapL = ring[2 * read1] + frac * (ring[2 * read2] - ring[2 * read1]);
+                float tapR = ring[2 * read1 + 1] + frac * (ring[2 * read2 + 1] - ring[2 * read1 + 1]);
+
+                // mono sum drives the left line; the left tap crosses to the
+                // right line; the right tap closes the feedback loop
+                float mono = 0.5f * (sourceL[i] + sourceR[i]) * level;
+                ring[2 * writeIndex] = mono + feedback * tapR;
+                ring[2 * writeIndex + 1] = tapL;
+
+                destL[i] = sourceL[i] + tapL;
+                destR[i] = sourceR[i] + tapR;
+
+                writeIndex = (writeIndex + 1) & mask;
+            }
+
+            m_writeIndex = writeIndex;
+        }
+
+        virtual void reset() override
+        {
+            std::fill(m_ring.begin(), m_ring.end(), 0.f);
+            m_firstTime = true;
+        }
+
+        virtual double tailTime(ContextRenderLock & r) const override { return MaxDelaySeconds; }
+        virtual double latencyTime(ContextRenderLock & r) const override { return 0; }
+
+        virtual size_t memoryBytes() const override { return m_ring.size() * sizeof(float); }
+
+        // Generous enough for a dotted half note at very slow tempi; matches
+        // the 8 second bound the BPMDelay-based version allocated per line.
+        static constexpr double MaxDelaySeconds = 8.0;
+
+        std::shared_ptr<AudioParam> m_feedback;
+        std::shared_ptr<AudioParam> m_level;
+        std::shared_ptr<AudioParam> m_delayTime;
+
+    private:
+
+        // Interleaved [L R] frames; one ring serves both delay lines.
+        std::vector<float> m_ring;
+        size_t m_ringFrames = 0;
+        size_t m_writeIndex = 0;
+        double m_currentDelayFrames = 0;
+        double m_smoothingRate = 0;
+        bool m_firstTime = true;
+    };
+
+    constexpr double PingPongDelayNode::PingPongDelayInternal::MaxDelaySeconds;
+
+    //////////////////////////////
+    // Public PingPongDelayNode //
+    //////////////////////////////
+
     PingPongDelayNode::PingPongDelayNode(float sampleRate, float tempo)
+        : lab::AudioBasicProcessorNode()
+        , tempo(tempo)
     {
-        input = std::make_shared<lab::GainNode>();
-        output = std::make_shared<lab::GainNode>();
+        internalNode = new PingPongDelayInternal();
+        m_processor.reset(internalNode);
 
-        leftDelay = std::make_shared<lab::BPMDelay>(sampleRate, tempo);
-        rightDelay = std::make_shared<lab::BPMDelay>(sampleRate, tempo);
+        m_params.push_back(internalNode->m_feedback);
+        m_params.push_back(internalNode->m_level);
+        m_params.push_back(internalNode->m_delayTime);
 
-        splitterGain = std::make_shared<lab::GainNode>();
-        wetGain = std::make_shared<lab::GainNode>();
-        feedbackGain = std::make_shared<lab::GainNode>();
+        times =
+        {
+            1.f / 8.f,
+            (1.f / 4.f) * 2.f / 3.f,
+            (1.f / 8.f) * 3.f / 2.f,
+            1.f / 4.f,
+            (1.f / 2.f) * 2.f / 3.f,
+            (1.f / 4.f) * 3.f / 2.f,
+            1.f / 2.f,
+            1.f * 2.f / 3.f,
+            (1.f / 2.f) * 3.f / 2.f,
+            1.0f,
+            2.f * 2.f / 3.f,
+            1.f * 3.f / 2.f,
+            2.f,
+            3.f
+        };
 
-        merger = std::make_shared<lab::ChannelMergerNode>(2);
-        splitter = std::make_shared<lab::ChannelSplitterNode>(2);
+        addInput(std::unique_ptr<AudioNodeInput>(new lab::AudioNodeInput(this)));
+        addOutput(std::unique_ptr<AudioNodeOutput>(new lab::AudioNodeOutput(this, 2)));
 
         SetDelayIndex(TempoSync::TS_8);
         SetFeedback(0.5f);
         SetLevel(1.0f);
+
+        initialize();
     }
-    
+
     PingPongDelayNode::~PingPongDelayNode()
     {
-
+        uninitialize();
     }
 
-    void PingPongDelayNode::SetTempo(float t)
-    { 
-        tempo = t; 
-        leftDelay->SetTempo(tempo);
-        rightDelay->SetTempo(tempo);
+    void PingPongDelayNode::recomputeDelay()
+    {
+        // times[] is in quarter notes; one quarter lasts 60 / tempo seconds
+        float dT = times[noteDivision] * 60.f / tempo;
+        internalNode->m_delayTime->setValue(dT);
     }
 
-    void PingPongDelayNode::SetFeedback(float f) 
+    void PingPongDelayNode::SetTempo(float t)
     {
-        auto clamped = clampTo<float>(f,0.0f, 1.0f);
-        feedbackGain->gain()->setValue(clamped);
+        tempo = t;
+        recomputeDelay();
     }
 
-    void PingPongDelayNode::SetLevel(float f) 
+    void PingPongDelayNode::SetFeedback(float f)
     {
-        auto clamped = clampTo<float>(f,0.0f, 1.0f);
-        wetGain->gain()->setValue(clamped);
+        auto clamped = clampTo<float>(f, 0.0f, 1.0f);
+        internalNode->m_feedback->setValue(clamped);
     }
 
-    void PingPongDelayNode::SetDelayIndex(TempoSync value)
+    void PingPongDelayNode::SetLevel(float f)
     {
-        leftDelay->SetDelayIndex(value);
-        rightDelay->SetDelayIndex(value);
+        auto clamped = clampTo<float>(f, 0.0f, 1.0f);
+        internalNode->m_level->setValue(clamped);
     }
 
-    void PingPongDelayNode::BuildSubgraph(std::unique_ptr<AudioContext> & ac) 
+    void PingPongDelayNode::SetDelayIndex(TempoSync value)
     {
-
-        // Input into splitter
-        ac->connect(splitter, input, 0, 0);
-
-        ac->connect(splitterGain, splitter, 0, 0);
-        ac->connect(splitterGain, splitter, 1, 0);
-
-        ac->connect(wetGain, splitterGain, 0, 0);
-        splitterGain->gain()->setValue(0.5f);
-
-        ac->connect(leftDelay, wetGain, 0, 0);
-        ac->connect(leftDelay, feedbackGain, 0, 0);
-
-        ac->connect(rightDelay, leftDelay, 0, 0);
-        ac->connect(feedbackGain, rightDelay, 0, 0);
-
-        ac->connect(merger, leftDelay, 0, 0);
-        ac->connect(merger, rightDelay, 0, 1);
-
-        ac->connect(output, merger, 0, 0);
-
-        // Activate with input->output
-        ac->connect(output, input, 0, 0);
+        if (value >= TempoSync::TS_32 && value <= TempoSync::TS_2D)
+        {
+            noteDivision = TempoSyncToIndex(value);
+            recomputeDelay();
+        }
+        else
+            throw std::invalid_argument("Delay index out of bounds");
     }
 
-
-}
+} // end namespace lab
@@ -0,0 +1,261 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/QualityGovernor.h"
+
+#include "LabSound/core/AnalyserNode.h"
+#include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/AudioDestinationNode.h"
+#include "LabSound/core/ConvolverNode.h"
+#include "LabSound/core/PannerNode.h"
+
+#include "LabSound/extended/AudioContextLock.h"
+#include "LabSound/extended/RealtimeAnalyser.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace lab
+{
+
+static_assert(AudioDestinationNode::CallbackStats::LoadHistogramSize == 16,
+              "QualityGovernor's histogram baseline must match the watchdog's bucket count");
+
+namespace
+{
+    // Truncates an impulse response to at most tailSeconds, fading the final
+    // stretch linearly to zero so the cut does not click.
+    std::shared_ptr<AudioBus> truncateImpulse(const AudioBus * impulse, float tailSeconds, float sampleRate)
+    {
+        size_t capFrames = static_cast<size_t>(tailSeconds * sampleRate);
+        if (!capFrames || impulse->length() <= capFrames)
+            return nullptr;
+
+        size_t channels = impulse->numberOfChannels();
+        auto truncated = std::make_shared<AudioBus>(channels, capFrames);
+        truncated->setSampleRate(impulse->sampleRate());
+
+        size_t fadeFrames = std::min(capFrames / 4, static_cast<size_t>(1024));
+        for (size_t c = 0; c < channels; ++c)
+        {
+            const float * src = impulse->channel(c)->data();
+            float * dst = truncated->channel(c)->mutableData();
+            memcpy(dst, src, capFrames * sizeof(float));
+            for (size_t i = 0; i < fadeFrames; ++i)
+                dst[capFrames - fadeFrames + i] *= 1.f - static_cast<float>(i + 1) / fadeFrames;
+        }
+        return truncated;
+    }
+}
+
+QualityGovernor::QualityGovernor(std::shared_ptr<AudioContext> context)
+    : QualityGovernor(context, Policy())
+{
+}
+
+QualityGovernor::QualityGovernor(std::shared_ptr<AudioContext> context, Policy policy)
+    : m_context(context)
+    , m_policy(policy)
+{
+}
+
+QualityGovernor::~QualityGovernor()
+{
+}
+
+void QualityGovernor::governPanner(std::shared_ptr<PannerNode> panner)
+{
+    if (!panner)
+        return;
+    GovernedPanner entry;
+    entry.node = panner;
+    entry.originalModel = panner->panningModel();
+    m_panners.push_back(entry);
+}
+
+void QualityGovernor::governConvolver(std::shared_ptr<ConvolverNode> convolver)
+{
+    if (!convolver)
+        return;
+    GovernedConvolver entry;
+    entry.node = convolver;
+    entry.originalImpulse = convolver->getImpulse();
+    m_convolvers.push_back(entry);
+}
+
+void QualityGovernor::governAnalyser(std::shared_ptr<AnalyserNode> analyser)
+{
+    if (!analyser)
+        return;
+    GovernedAnalyser entry;
+    entry.node = analyser;
+    entry.originalFftSize = analyser->fftSize();
+    m_analysers.push_back(entry);
+}
+
+void QualityGovernor::update()
+{
+    auto destination = m_context->destination();
+    if (!destination)
+        return;
+
+    auto stats = destination->callbackStats();
+
+    if (!m_haveBaseline)
+    {
+        // First call establishes the baseline; load is judged from here on.
+        memcpy(m_previousHistogram, stats.loadHistogram, sizeof(m_previousHistogram));
+        m_haveBaseline = true;
+        return;
+    }
+
+    // The load histogram has one bucket per eighth of the deadline, so the
+    // delta since the previous update gives a deadline-relative load
+    // distribution for exactly the callbacks seen in between, regardless of
+    // the device's buffer size.
+    uint64_t total = 0;
+    double weighted = 0;
+    for (int i = 0; i < AudioDestinationNode::CallbackStats::LoadHistogramSize; ++i)
+    {
+        uint64_t count = stats.loadHistogram[i] - m_previousHistogram[i];
+        total += count;
+        weighted += count * ((i + 0.5) / 8.0);  // bucket midpoint as a fraction of the deadline
+    }
+    memcpy(m_previousHistogram, stats.loadHistogram, sizeof(m_previousHistogram));
+
+    if (!total)
+        return;  // no callbacks ran since the last update
+
+    m_recentLoad = static_cast<float>(weighted / total);
+
+    if (m_recentLoad > m_policy.degradeLoad)
+    {
+        m_underBudgetUpdates = 0;
+        if (++m_overBudgetUpdates >= m_policy.degradeUpdates && m_tier != Tier::Minimum)
+        {
+            m_overBudgetUpdates = 0;
+            setTier(static_cast<Tier>(static_cast<int>(m_tier) + 1));
+        }
+    }
+    else if (m_recentLoad < m_policy.restoreLoad)
+    {
+        m_overBudgetUpdates = 0;
+        if (++m_underBudgetUpdates >= m_policy.restoreUpdates && m_tier != Tier::Full)
+        {
+            m_underBudgetUpdates = 0;
+            setTier(static_cast<Tier>(static_cast<int>(m_tier) - 1));
+        }
+    }
+    else
+    {
+        // Between the thresholds: the hysteresis band. Hold the tier and
+        // require fresh consecutive evidence before moving again.
+        m_overBudgetUpdates = 0;
+        m_underBudgetUpdates = 0;
+    }
+}
+
+void QualityGovernor::setTier(Tier tier)
+{
+    if (tier == m_tier)
+        return;
+
+    m_tier = tier;
+    applyTier(tier);
+
+    if (m_tierChangedCallback)
+        m_tierChangedCallback(tier, m_recentLoad);
+}
+
+void QualityGovernor::setTierChangedCallback(std::function<void(Tier, float)> callback)
+{
+    m_tierChangedCallback = std::move(callback);
+}
+
+void QualityGovernor::applyTier(Tier tier)
+{
+    float sampleRate = m_context->sampleRate();
+
+    if (m_policy.stepPanners)
+    {
+        for (auto it = m_panners.begin(); it != m_panners.end();)
+        {
+            auto panner = it->node.lock();
+            if (!panner)
+            {
+                it = m_panners.erase(it);
+                continue;
+            }
+            if (it->originalModel == PanningMode::HRTF)
+                panner->setPanningModel(tier == Tier::Full ? PanningMode::HRTF : PanningMode::EQUALPOWER);
+            ++it;
+        }
+    }
+
+    if (m_policy.truncateConvolvers)
+    {
+        float tailCap = tier == Tier::Reduced ? m_policy.reducedTailSeconds
+                      : tier == Tier::Minimum ? m_policy.minimumTailSeconds
+                      : 0.f;  // Full: no cap
+
+        for (auto it = m_convolvers.begin(); it != m_convolvers.end();)
+        {
+            auto convolver = it->node.lock();
+            if (!convolver)
+            {
+                it = m_convolvers.erase(it);
+                continue;
+            }
+
+            // The impulse may have been set after registration.
+            if (!it->originalImpulse)
+                it->originalImpulse = convolver->getImpulse();
+
+            if (it->originalImpulse)
+            {
+                if (tailCap == 0.f)
+                {
+                    if (it->appliedTailSeconds != 0.f)
+                    {
+                        convolver->setImpulse(it->originalImpulse);
+                        it->appliedTailSeconds = 0.f;
+                    }
+                }
+                else if (it->appliedTailSeconds != tailCap)
+                {
+                    if (auto truncated = truncateImpulse(it->originalImpulse.get(), tailCap, sampleRate))
+                    {
+                        convolver->setImpulse(truncated);
+                        it->appliedTailSeconds = tailCap;
+                    }
+                }
+            }
+            ++it;
+        }
+    }
+
+    if (m_policy.reduceAnalysers)
+    {
+        // setFftSize reconfigures analysis state shared with the render
+        // thread, so the changes are applied under the render lock.
+        ContextRenderLock r(m_context.get(), "QualityGovernor");
+        for (auto it = m_analysers.begin(); it != m_analysers.end();)
+        {
+            auto analyser = it->node.lock();
+            if (!analyser)
+            {
+                it = m_analysers.erase(it);
+                continue;
+            }
+            size_t divisor = tier == Tier::Reduced ? 2 : tier == Tier::Minimum ? 4 : 1;
+            size_t target = std::max(it->originalFftSize / divisor,
+                                     static_cast<size_t>(RealtimeAnalyser::MinFFTSize));
+            if (analyser->fftSize() != target)
+                analyser->setFftSize(r, target);
+            ++it;
+        }
+    }
+}
+
+}  // namespace lab
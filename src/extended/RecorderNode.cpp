@@ -1,158 +1,341 @@
-// License: BSD 2 Clause
-// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
-
-#include "LabSound/core/AudioNodeInput.h"
-#include "LabSound/core/AudioNodeOutput.h"
-#include "LabSound/core/AudioBus.h"
-
-#include "LabSound/extended/RecorderNode.h"
-
-#include "libnyquist/Encoders.h"
-
-namespace lab 
-{
-    
-    using namespace lab;
-    
-    RecorderNode::RecorderNode() : AudioBasicInspectorNode(2)
-    {
-        addInput(std::unique_ptr<AudioNodeInput>(new AudioNodeInput(this)));
-        addOutput(std::unique_ptr<AudioNodeOutput>(new AudioNodeOutput(this, 2)));
-
-        initialize();
-    }
-    
-    RecorderNode::~RecorderNode()
-    {
-        uninitialize();
-    }
-    
-    void RecorderNode::getData(std::vector<float> & result)
-    {
-        // swap is quick enough that process should not be adversely affected
-        result.clear();
-        std::lock_guard<std::recursive_mutex> lock(m_mutex);
-        result.swap(m_data);
-    }
-
-    void RecorderNode::process(ContextRenderLock& r, size_t framesToProcess)
-    {
-        AudioBus* outputBus = output(0)->bus(r);
-        
-        if (!isInitialized() || !input(0)->isConnected())
-        {
-            if (outputBus)
-                outputBus->zero();
-            return;
-        }
-
-        // =====> should this follow the WebAudio pattern have a writer object to call here?
-        AudioBus* bus = input(0)->bus(r);        
-        bool isBusGood = bus && (bus->numberOfChannels() > 0) && (bus->channel(0)->length() >= framesToProcess);
-        
-        if (!isBusGood)
-        {
-            outputBus->zero();
-            return;
-        }
-        
-        if (m_recording)
-        {
-            std::vector<const float*> channels;
-            size_t numberOfChannels = bus->numberOfChannels();
-            
-            for (size_t i = 0; i < numberOfChannels; ++i)
-            {
-                channels.push_back(bus->channel(i)->data());
-            }
-
-            // mix down the output, or interleave the output
-            // use the tightest loop possible since this is part of the processing step
-            std::lock_guard<std::recursive_mutex> lock(m_mutex);
-            
-            m_data.reserve(framesToProcess * (m_mixToMono ? 1 : 2));
-            
-            if (m_mixToMono)
-            {
-                if (numberOfChannels == Channels::Mono)
-                {
-                    for (size_t i = 0; i < framesToProcess; ++i)
-                    {
-                        m_data.push_back(channels[0][i]);
-                    }
-                }
-                
-                else
-                {
-                    for (size_t i = 0; i < framesToProcess; ++i)
-                    {
-                        float val = 0;
-                        for (unsigned int c = 0; c < numberOfChannels; ++ c)
-                        {
-                            val += channels[c][i];
-                        }
-                        val *= 1.0f / float(numberOfChannels);
-                        m_data.push_back(val);
-                    }
-                }
-
-            }
-            else
-            {
-                for (size_t i = 0; i < framesToProcess; ++i)
-                {
-                    for (unsigned int c = 0; c < numberOfChannels; ++ c)
-                    {
-                        m_data.push_back(channels[c][i]);
-                    }
-                }
-            }
-
-        }
-        // <====== to here
-        
-        // For in-place processing, our override of pullInputs() will just pass the audio data
-        // through unchanged if the channel count matches from input to output
-        // (resulting in inputBus == outputBus). Otherwise, do an up-mix to stereo.
-        if (bus != outputBus)
-        {
-           outputBus->copyFrom(*bus);
-        }
-    }
-    
-    void RecorderNode::writeRecordingToWav(int channels, const std::string & filenameWithWavExtension)
-    {
-        // Represents structure of underlying data
-        std::unique_ptr<nqr::AudioData> fileData(new nqr::AudioData());
-        
-        {
-            std::lock_guard<std::recursive_mutex> lock(m_mutex);
-            fileData->samples.swap(m_data);
-        }
-        
-        fileData->channelCount = channels;
-        fileData->sourceFormat = nqr::PCM_FLT;
-        fileData->sampleRate = 44100; // @tofix - hardcoded sample rate
-        
-        // fileData->... other file data not needed
-        
-        // Represents target encoding (wav only)
-        // Libnyquist bug with things other than PCM_FLT?
-        nqr::EncoderParams params = {channels, nqr::PCM_FLT, nqr::DITHER_NONE};
-
-        /*int encoderStatus =*/
-        nqr::encode_wav_to_disk(params, fileData.get(), filenameWithWavExtension);
-    }
-    
-    void RecorderNode::reset(ContextRenderLock& r)
-    {
-        std::vector<float> clear;
-        {
-            std::lock_guard<std::recursive_mutex> lock(m_mutex);
-            m_data.swap(clear);
-        }
-        
-        // release the data in clear's destructor after the mutex has been released
-    }
-                                           
-} // end namespace lab
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/core/AudioNodeInput.h"
+#include "LabSound/core/AudioNodeOutput.h"
+#include "LabSound/core/AudioBus.h"
+
+#include "LabSound/extended/RecorderNode.h"
+
+#include "internal/AudioThreads.h"
+#include "internal/VectorMath.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace lab
+{
+
+    using namespace lab;
+
+    namespace
+    {
+        // power of two samples; ~6 seconds of stereo at 44.1kHz, so the
+        // writer thread can stall for seconds before any frame is dropped
+        const size_t kRingCapacity = 1 << 19;
+
+        // Minimal WAV framing, 32 bit float or 16 bit PCM. The sizes written
+        // at offsets 4 (RIFF) and 40 (data) start as zero and are patched on
+        // finalize, so the file grows incrementally while recording.
+        void writeWavHeader(FILE * f, int channels, int sampleRate, bool sixteenBit)
+        {
+            auto u16 = [f](uint16_t v) { fwrite(&v, 2, 1, f); };
+            auto u32 = [f](uint32_t v) { fwrite(&v, 4, 1, f); };
+
+            const size_t sampleBytes = sixteenBit ? sizeof(int16_t) : sizeof(float);
+
+            fwrite("RIFF", 1, 4, f);
+            u32(0);  // patched on finalize
+            fwrite("WAVE", 1, 4, f);
+            fwrite("fmt ", 1, 4, f);
+            u32(16);
+            u16(sixteenBit ? 1 : 3);  // PCM / IEEE float
+            u16(static_cast<uint16_t>(channels));
+            u32(static_cast<uint32_t>(sampleRate));
+            u32(static_cast<uint32_t>(sampleRate * channels * sampleBytes));  // byte rate
+            u16(static_cast<uint16_t>(channels * sampleBytes));  // block align
+            u16(static_cast<uint16_t>(sampleBytes * 8));  // bits per sample
+            fwrite("data", 1, 4, f);
+            u32(0);  // patched on finalize
+        }
+
+        void patchWavSizes(FILE * f, uint64_t dataBytes)
+        {
+            uint32_t riffSize = static_cast<uint32_t>(36 + dataBytes);
+            uint32_t dataSize = static_cast<uint32_t>(dataBytes);
+            fseek(f, 4, SEEK_SET);
+            fwrite(&riffSize, 4, 1, f);
+            fseek(f, 40, SEEK_SET);
+            fwrite(&dataSize, 4, 1, f);
+        }
+    }
+
+    RecorderNode::RecorderNode() : AudioBasicInspectorNode(2)
+    {
+        addInput(std::unique_ptr<AudioNodeInput>(new AudioNodeInput(this)));
+        addOutput(std::unique_ptr<AudioNodeOutput>(new AudioNodeOutput(this, 2)));
+
+        m_ring.resize(kRingCapacity);
+        m_writerThread = std::thread(&RecorderNode::writerThread, this);
+
+        initialize();
+    }
+
+    RecorderNode::~RecorderNode()
+    {
+        m_recording = false;
+        m_writerShouldRun = false;
+        if (m_writerThread.joinable())
+            m_writerThread.join();
+
+        uninitialize();
+    }
+
+    void RecorderNode::startRecording()
+    {
+        m_recording = true;
+    }
+
+    void RecorderNode::startRecording(const std::string & filenameWithWavExtension, int channels, float sampleRate, bool sixteenBit)
+    {
+        std::lock_guard<std::mutex> lock(m_controlMutex);
+        if (m_file)
+            return;  // already streaming
+
+        m_file = fopen(filenameWithWavExtension.c_str(), "wb");
+        if (!m_file)
+            return;
+
+        m_streamInt16 = sixteenBit;
+        writeWavHeader(m_file, channels, static_cast<int>(sampleRate), sixteenBit);
+        m_bytesStreamed = 0;
+        m_finalizeRequested = false;
+        m_recording = true;
+    }
+
+    void RecorderNode::stopRecording()
+    {
+        m_recording = false;
+
+        // the writer thread drains what's left in the ring and patches the
+        // header; the caller doesn't wait on the disk
+        std::lock_guard<std::mutex> lock(m_controlMutex);
+        if (m_file)
+            m_finalizeRequested = true;
+    }
+
+    void RecorderNode::getData(std::vector<float> & result)
+    {
+        result.clear();
+        std::lock_guard<std::mutex> lock(m_controlMutex);
+        result.swap(m_data);
+    }
+
+    void RecorderNode::process(ContextRenderLock& r, size_t framesToProcess)
+    {
+        AudioBus* outputBus = output(0)->bus(r);
+
+        if (!isInitialized() || !input(0)->isConnected())
+        {
+            if (outputBus)
+                outputBus->zero();
+            return;
+        }
+
+        AudioBus* bus = input(0)->bus(r);
+        bool isBusGood = bus && (bus->numberOfChannels() > 0) && (bus->channel(0)->length() >= framesToProcess);
+
+        if (!isBusGood)
+        {
+            outputBus->zero();
+            return;
+        }
+
+        if (m_recording.load(std::memory_order_relaxed))
+        {
+            size_t numberOfChannels = bus->numberOfChannels();
+
+            // interleave (or mix down) into a stack staging buffer, then copy
+            // into the ring in at most two segments. Constant time, no locks,
+            // no allocation.
+            float staging[AudioNode::ProcessingSizeInFrames * 2];
+            size_t sampleCount;
+
+            if (m_mixToMono)
+            {
+                sampleCount = framesToProcess;
+                memcpy(staging, bus->channel(0)->data(), framesToProcess * sizeof(float));
+                if (numberOfChannels > Channels::Mono)
+                {
+                    // Sum the remaining channels in one accumulating pass,
+                    // then scale - all through the SIMD kernels rather than
+                    // a per-sample channel loop.
+                    const float * sources[16];
+                    size_t summed = 1;
+                    while (summed < numberOfChannels)
+                    {
+                        size_t batch = std::min<size_t>(numberOfChannels - summed, 16);
+                        for (size_t c = 0; c < batch; ++c)
+                            sources[c] = bus->channel(summed + c)->data();
+                        VectorMath::vaddm(sources, batch, staging, framesToProcess);
+                        summed += batch;
+                    }
+                    const float scale = 1.0f / float(numberOfChannels);
+                    VectorMath::vsmul(staging, 1, &scale, staging, 1, framesToProcess);
+                }
+            }
+            else if (numberOfChannels <= 2)
+            {
+                sampleCount = framesToProcess * numberOfChannels;
+                bus->interleave(staging, framesToProcess);
+            }
+            else
+            {
+                // more channels than we record; pack the first two
+                sampleCount = framesToProcess * 2;
+                VectorMath::vintlve(bus->channel(0)->data(), bus->channel(1)->data(), staging, framesToProcess);
+            }
+
+            uint64_t w = m_ringWrite.load(std::memory_order_relaxed);
+            uint64_t rd = m_ringRead.load(std::memory_order_acquire);
+            if (kRingCapacity - (w - rd) >= sampleCount)
+            {
+                size_t offset = static_cast<size_t>(w & (kRingCapacity - 1));
+                size_t first = std::min(sampleCount, kRingCapacity - offset);
+                memcpy(&m_ring[offset], staging, first * sizeof(float));
+                if (first < sampleCount)
+                    memcpy(&m_ring[0], staging + first, (sampleCount - first) * sizeof(float));
+                m_ringWrite.store(w + sampleCount, std::memory_order_release);
+            }
+            else
+            {
+                m_overrunFrames.fetch_add(framesToProcess, std::memory_order_relaxed);
+            }
+        }
+
+        // For in-place processing, our override of pullInputs() will just pass the audio data
+        // through unchanged if the channel count matches from input to output
+        // (resulting in inputBus == outputBus). Otherwise, do an up-mix to stereo.
+        if (bus != outputBus)
+        {
+           outputBus->copyFrom(*bus);
+        }
+    }
+
+    void RecorderNode::writerThread()
+    {
+        ApplyThreadPolicy(AudioContext::ThreadRole::Background, "recorder io");
+
+        std::vector<float> staging;
+        staging.reserve(kRingCapacity);
+        std::vector<int16_t> converted;
+
+        bool draining = true;
+        while (m_writerShouldRun.load(std::memory_order_relaxed) || draining)
+        {
+            uint64_t rd = m_ringRead.load(std::memory_order_relaxed);
+            uint64_t w = m_ringWrite.load(std::memory_order_acquire);
+            size_t avail = static_cast<size_t>(w - rd);
+
+            if (avail)
+            {
+                staging.resize(avail);
+                size_t offset = static_cast<size_t>(rd & (kRingCapacity - 1));
+                size_t first = std::min(avail, kRingCapacity - offset);
+                memcpy(staging.data(), &m_ring[offset], first * sizeof(float));
+                if (first < avail)
+                    memcpy(staging.data() + first, &m_ring[0], (avail - first) * sizeof(float));
+                m_ringRead.store(rd + avail, std::memory_order_release);
+            }
+            else
+            {
+                staging.clear();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_controlMutex);
+                if (m_file)
+                {
+                    if (!staging.empty())
+                    {
+                        if (m_streamInt16)
+                        {
+                            // Convert incrementally as data streams through,
+                            // so the 16 bit file needs no save-time pass. The
+                            // samples are already interleaved, so the kernel
+                            // runs in single-channel form with TPDF dither.
+                            converted.resize(staging.size());
+                            const float * source = staging.data();
+                            VectorMath::vfloat_to_int16_interleave(&source, 1, converted.data(), staging.size(), true);
+                            fwrite(converted.data(), sizeof(int16_t), converted.size(), m_file);
+                            m_bytesStreamed += converted.size() * sizeof(int16_t);
+                        }
+                        else
+                        {
+                            fwrite(staging.data(), sizeof(float), staging.size(), m_file);
+                            m_bytesStreamed += staging.size() * sizeof(float);
+                        }
+                    }
+                    bool done = m_finalizeRequested || !m_writerShouldRun.load(std::memory_order_relaxed);
+                    if (done && staging.empty())
+                    {
+                        patchWavSizes(m_file, m_bytesStreamed);
+                        fclose(m_file);
+                        m_file = nullptr;
+                        m_finalizeRequested = false;
+                    }
+                }
+                else if (!staging.empty())
+                {
+                    m_data.insert(m_data.end(), staging.begin(), staging.end());
+                }
+            }
+
+            if (staging.empty())
+            {
+                // exit only once the ring is empty and any stream is closed,
+                // so nothing recorded is lost at teardown
+                if (!m_writerShouldRun.load(std::memory_order_relaxed))
+                {
+                    std::lock_guard<std::mutex> lock(m_controlMutex);
+                    draining = m_file != nullptr;
+                    if (!draining)
+                        break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }
+    }
+
+    void RecorderNode::writeRecordingToWav(int channels, const std::string & filenameWithWavExtension)
+    {
+        std::vector<float> data;
+        {
+            std::lock_guard<std::mutex> lock(m_controlMutex);
+            data.swap(m_data);
+        }
+
+        FILE * f = fopen(filenameWithWavExtension.c_str(), "wb");
+        if (!f)
+            return;
+
+        writeWavHeader(f, channels, 44100, false);  // @tofix - hardcoded sample rate
+        fwrite(data.data(), sizeof(float), data.size(), f);
+        patchWavSizes(f, data.size() * sizeof(float));
+        fclose(f);
+    }
+
+    void RecorderNode::queryMemory(ContextRenderLock & r, MemoryUsage & usage) const
+    {
+        AudioNode::queryMemory(r, usage);
+
+        // the ring is fixed; the in-memory accumulation grows while recording
+        usage.otherBytes += m_ring.capacity() * sizeof(float);
+
+        std::lock_guard<std::mutex> lock(m_controlMutex);
+        usage.otherBytes += m_data.capacity() * sizeof(float);
+    }
+
+    void RecorderNode::reset(ContextRenderLock& r)
+    {
+        std::vector<float> clear;
+        {
+            std::lock_guard<std::mutex> lock(m_controlMutex);
+            m_data.swap(clear);
+        }
+
+        // release the data in clear's destructor after the mutex has been released
+    }
+
+} // end namespace lab
@@ -0,0 +1,108 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/ReverbSendBus.h"
+
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/AudioParam.h"
+#include "LabSound/core/ConvolverNode.h"
+#include "LabSound/core/GainNode.h"
+
+namespace lab
+{
+
+    ReverbSendBus::ReverbSendBus(std::shared_ptr<AudioContext> context)
+        : m_context(context)
+    {
+        m_convolver = std::make_shared<ConvolverNode>();
+        m_returnGain = std::make_shared<GainNode>();
+        m_returnGain->gain()->setValue(1.f);
+        m_context->connect(m_returnGain, m_convolver);
+    }
+
+    ReverbSendBus::~ReverbSendBus()
+    {
+        std::lock_guard<std::mutex> lock(m_sendMutex);
+        for (auto & send : m_sends)
+        {
+            m_context->disconnect(m_convolver, send.gain);
+            m_context->disconnect(send.gain, send.source);
+            m_context->reclaim(std::move(send.gain));
+        }
+        m_sends.clear();
+
+        m_context->disconnect(m_returnGain, m_convolver);
+        m_context->reclaim(std::move(m_convolver));
+        m_context->reclaim(std::move(m_returnGain));
+    }
+
+    void ReverbSendBus::setImpulse(std::shared_ptr<AudioBus> impulse)
+    {
+        m_convolver->setImpulse(impulse);
+    }
+
+    void ReverbSendBus::setNormalize(bool normalize)
+    {
+        m_convolver->setNormalize(normalize);
+    }
+
+    int ReverbSendBus::addSend(std::shared_ptr<AudioNode> source, float level)
+    {
+        if (!source)
+            return 0;
+
+        Send send;
+        send.source = source;
+        send.gain = std::make_shared<GainNode>();
+        send.gain->gain()->setValue(level);
+
+        // source -> send gain -> the convolver's summing input. The input
+        // junction mixes every send in one vectorized pass per quantum.
+        m_context->connect(send.gain, source);
+        m_context->connect(m_convolver, send.gain);
+
+        std::lock_guard<std::mutex> lock(m_sendMutex);
+        send.id = m_nextSendId++;
+        m_sends.push_back(send);
+        return send.id;
+    }
+
+    void ReverbSendBus::removeSend(int id)
+    {
+        Send send;
+        {
+            std::lock_guard<std::mutex> lock(m_sendMutex);
+            for (size_t i = 0; i < m_sends.size(); ++i)
+            {
+                if (m_sends[i].id == id)
+                {
+                    send = std::move(m_sends[i]);
+                    m_sends.erase(m_sends.begin() + i);
+                    break;
+                }
+            }
+        }
+
+        if (!send.gain)
+            return;
+
+        m_context->disconnect(m_convolver, send.gain);
+        m_context->disconnect(send.gain, send.source);
+        m_context->reclaim(std::move(send.gain));
+    }
+
+    std::shared_ptr<AudioParam> ReverbSendBus::sendLevel(int id) const
+    {
+        std::lock_guard<std::mutex> lock(m_sendMutex);
+        for (const auto & send : m_sends)
+            if (send.id == id)
+                return send.gain->gain();
+        return {};
+    }
+
+    std::shared_ptr<AudioParam> ReverbSendBus::returnLevel() const
+    {
+        return m_returnGain->gain();
+    }
+
+}  // namespace lab
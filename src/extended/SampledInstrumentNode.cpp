@@ -1,134 +1,185 @@
 // License: BSD 2 Clause
 // Copyright (C) 2015+, The LabSound Authors. All rights reserved.
 
-
 #include "LabSound/extended/SampledInstrumentNode.h"
+#include "LabSound/extended/AudioFileReader.h"
+#include "LabSound/extended/Logging.h"
 
-/*
-#include "internal/ConfigMacros.h"
-
-#include <string>
-#include <fstream>
-#include <streambuf>
-#include <stdlib.h>
+#include <cmath>
+#include <map>
 
-namespace lab 
+namespace lab
 {
+    namespace
+    {
+        // Decoded sample sets are shared by name via weak pointers, the same
+        // scheme the file reader uses for busses: the cache de-duplicates
+        // concurrent users without ever pinning memory.
+        std::mutex g_sampleSetCacheMutex;
+        std::map<std::string, std::weak_ptr<const InstrumentSampleSet>> g_sampleSetCache;
+    }
 
-    using namespace lab;
+    ////////////////////////////
+    // InstrumentSampleSet    //
+    ////////////////////////////
 
-    struct SamplerSound 
+    std::shared_ptr<const InstrumentSampleSet> InstrumentSampleSet::load(const std::string & name,
+                                                                         const std::vector<SampledInstrumentDefinition> & defs)
     {
-
-        SamplerSound(SampledInstrumentDefinition & def, float sampleRate)
         {
-            soundBuf = new SoundBuffer(def.audio, def.extension, sampleRate);
-            this->baseMidiNote = def.root;
-            this->midiNoteLow = def.min;
-            this->midiNoteHigh = def.max;
+            std::lock_guard<std::mutex> lock(g_sampleSetCacheMutex);
+            auto it = g_sampleSetCache.find(name);
+            if (it != g_sampleSetCache.end())
+            {
+                if (auto existing = it->second.lock())
+                    return existing;
+            }
         }
 
-        bool AppliesToNote(uint8_t note) 
+        std::shared_ptr<InstrumentSampleSet> set(new InstrumentSampleSet());
+        set->m_zones.reserve(defs.size());
+        for (auto & def : defs)
         {
-            // Debugging: 
-            //std::cout << "Note: " << int(note) << std::endl;
-            //std::cout << "Base: " << int(baseMidiNote) << std::endl;
-            //std::cout << "Low: " << int(midiNoteLow) << std::endl;
-            //std::cout << "High: " << int(midiNoteHigh) << std::endl;
-            //std::cout << std::endl << std::endl;
-            if (baseMidiNote == note || (note >= midiNoteLow && note <= midiNoteHigh)) 
-                return true; 
-            else 
-                return false; 
-        }
+            auto bus = MakeBusFromMemory(def.audio, def.extension, false);
+            if (!bus)
+            {
+                LOG_ERROR("Could not decode zone (root %d) of instrument %s", int(def.root), name.c_str());
+                continue;
+            }
 
-        SoundBuffer * soundBuf;
+            Zone zone;
+            zone.bus = bus;
+            zone.root = def.root;
+            zone.keyLow = def.min;
+            zone.keyHigh = def.max;
+            zone.velocityLow = def.velocityMin;
+            zone.velocityHigh = def.velocityMax;
+            set->m_zones.push_back(zone);
+        }
 
-        uint8_t baseMidiNote;
-        uint8_t midiNoteLow;
-        uint8_t midiNoteHigh; 
-    };
+        std::sort(set->m_zones.begin(), set->m_zones.end(), [](const Zone & a, const Zone & b) {
+            if (a.keyHigh != b.keyHigh) return a.keyHigh < b.keyHigh;
+            return a.velocityHigh < b.velocityHigh;
+        });
 
-    SampledInstrumentNode::SampledInstrumentNode(AudioContext * ctx, float sampleRate) : sampleRate(sampleRate)
-    { 
-        gainNode = std::make_shared<GainNode>(sampleRate);
-        gainNode->gain()->setValue(1.0);
+        std::lock_guard<std::mutex> lock(g_sampleSetCacheMutex);
+        g_sampleSetCache[name] = set;
+        return set;
+    }
 
-        voices.resize(maxVoiceCount);
+    const InstrumentSampleSet::Zone * InstrumentSampleSet::find(int midiNoteNumber, int velocity) const
+    {
+        // Zones are sorted by keyHigh, so the first candidate is the first
+        // zone whose range can still contain the note; from there the match is
+        // normally found within that key's few velocity layers.
+        auto it = std::lower_bound(m_zones.begin(), m_zones.end(), midiNoteNumber,
+                                   [](const Zone & z, int note) { return int(z.keyHigh) < note; });
 
-        for (size_t i = 0; i < voices.size(); i++)
+        for (; it != m_zones.end(); ++it)
         {
-            voices[i] = std::make_shared<SampledAudioNode>(sampleRate);
-            ctx->connect(gainNode, voices[i], 0, 0);
+            if (midiNoteNumber >= it->keyLow && midiNoteNumber <= it->keyHigh &&
+                velocity >= it->velocityLow && velocity <= it->velocityHigh)
+                return &(*it);
         }
+        return nullptr;
+    }
+
+    ////////////////////////////
+    // SampledInstrumentNode  //
+    ////////////////////////////
 
+    SampledInstrumentNode::SampledInstrumentNode(std::shared_ptr<AudioContext> context,
+                                                 std::shared_ptr<const InstrumentSampleSet> samples,
+                                                 size_t voiceCount)
+        : m_context(context)
+        , m_samples(samples)
+    {
+        m_output = std::make_shared<GainNode>();
+        m_output->gain()->setValue(1.f);
+        m_voices.reset(new VoicePool(context, voiceCount, m_output));
     }
 
     SampledInstrumentNode::~SampledInstrumentNode()
     {
-
+        killAllNotes();
     }
 
     // @tofix - add adsr
-    void SampledInstrumentNode::NoteOn(ContextRenderLock & r, const int midiNoteNumber, const float amplitude)
+    void SampledInstrumentNode::noteOn(ContextRenderLock & r, int midiNoteNumber, int velocity)
     {
-        if (!r.context()) return;
+        if (!r.context() || !m_samples)
+            return;
 
-        for (const auto & sample : samples)
-        {
-            // Find note in sample map
-            if (sample->AppliesToNote(midiNoteNumber))
-            {
-                for (auto & v : voices)
-                {    
+        const InstrumentSampleSet::Zone * zone = m_samples->find(midiNoteNumber, velocity);
+        if (!zone)
+            return;
 
-                    if (v->hasFinished())
-                    {
-                        v->reset(r);
-                    }
-
-                    if (v->playbackState() == 0) 
-                    {
-                        double pitchRatio = pow(2.0, (midiNoteNumber - sample->baseMidiNote) / 12.0);
+        VoicePool::Voice * voice = m_voices->acquire();
+        if (!voice)
+        {
+            // all voices sounding; steal nothing, drop the note
+            return;
+        }
 
-                        v->playbackRate()->setValue(pitchRatio); 
-                        v->gain()->setValue(amplitude); 
+        double pitchRatio = std::pow(2.0, (midiNoteNumber - zone->root) / 12.0);
+        voice->source->playbackRate()->setValue(static_cast<float>(pitchRatio));
+        voice->source->gain()->setValue(velocity / 127.f);
+        voice->source->setBus(r, zone->bus);
+        voice->source->start(r.context()->currentTime());
 
-                        // Connect the source node to the parsed audio data for playback
-                        v->setBus(r, sample->soundBuf->audioBuffer);
+        std::lock_guard<std::mutex> lock(m_activeMutex);
+        m_active.push_back({voice, midiNoteNumber});
+    }
 
-                        v->start(r.context()->currentTime());
-                        v->stop(r.context()->currentTime() + sample->soundBuf->audioBuffer->length());
+    void SampledInstrumentNode::noteOff(ContextRenderLock & r, int midiNoteNumber)
+    {
+        if (!r.context())
+            return;
 
-                        return;
-                    }
-                }
+        std::lock_guard<std::mutex> lock(m_activeMutex);
+        for (auto it = m_active.begin(); it != m_active.end(); ++it)
+        {
+            if (it->midiNoteNumber == midiNoteNumber)
+            {
+                // The voice returns to the pool via recycleFinishedVoices
+                // once the stop has rendered out.
+                it->voice->source->stop(r.context()->currentTime());
+                m_active.erase(it);
+                return;
             }
         }
     }
 
-    void SampledInstrumentNode::NoteOff(ContextRenderLock & r, const int midiNoteNumber, const float amplitude)
+    void SampledInstrumentNode::killAllNotes()
     {
-        if (!r.context()) return;
-         
-        // This logic is wrong. Find in voices... 
-        for (const auto & sample : samples)
+        std::vector<ActiveNote> active;
         {
-            if (sample->AppliesToNote(midiNoteNumber))
-            {
-                //sample->Stop(r, midiNoteNumber, amplitude);
-            }
+            std::lock_guard<std::mutex> lock(m_activeMutex);
+            active.swap(m_active);
         }
+
+        for (auto & note : active)
+            m_voices->release(note.voice);
+
+        m_voices->recycleFinishedVoices();
     }
-    
-    void SampledInstrumentNode::LoadInstrument(std::vector<SampledInstrumentDefinition> & sounds) 
+
+    void SampledInstrumentNode::recycleFinishedVoices()
     {
-        for (auto & samp : sounds) 
+        // Drop bookkeeping for notes that played out on their own (one-shots
+        // that never get a noteOff) before the pool reclaims their voices.
         {
-            samples.push_back(std::make_shared<SamplerSound>(samp, sampleRate));
+            std::lock_guard<std::mutex> lock(m_activeMutex);
+            for (auto it = m_active.begin(); it != m_active.end();)
+            {
+                if (it->voice->source->hasFinished())
+                    it = m_active.erase(it);
+                else
+                    ++it;
+            }
         }
 
+        m_voices->recycleFinishedVoices();
     }
 
 }
-*/
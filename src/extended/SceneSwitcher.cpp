@@ -0,0 +1,171 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/SceneSwitcher.h"
+
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/GainNode.h"
+
+#include "LabSound/extended/CrossfadeNode.h"
+#include "LabSound/extended/GraphSerialization.h"
+#include "LabSound/extended/Logging.h"
+
+#include <chrono>
+
+namespace lab
+{
+
+SceneSwitcher::SceneSwitcher(std::shared_ptr<AudioContext> context, float crossfadeSeconds)
+: m_context(context)
+, m_crossfadeSeconds(crossfadeSeconds)
+{
+    m_crossfade = std::make_shared<CrossfadeNode>();
+    m_crossfade->setLaw(CrossfadeNode::EQUAL_POWER_LAW);
+}
+
+SceneSwitcher::~SceneSwitcher()
+{
+    m_shuttingDown = true;
+
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        threads.swap(m_threads);
+    }
+
+    for (auto & t : threads)
+    {
+        if (t.joinable())
+            t.join();
+    }
+}
+
+std::shared_ptr<AudioNode> SceneSwitcher::output() const
+{
+    return m_crossfade;
+}
+
+void SceneSwitcher::reclaimScene(Scene & scene)
+{
+    // The references park on the context's reclamation list, so the
+    // destructors run on the graph update thread, never here.
+    for (auto & node : scene.nodes)
+        m_context->reclaim(node);
+    scene.nodes.clear();
+    scene.root.reset();
+}
+
+int SceneSwitcher::prepareScene(std::vector<uint8_t> graph, PrepareScene prepare)
+{
+    auto scene = std::make_shared<Scene>();
+    scene->root = std::make_shared<GainNode>();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int id = m_nextSceneId++;
+    m_scenes[id] = scene;
+
+    auto context = m_context;
+    m_threads.emplace_back([this, context, scene, graph = std::move(graph), prepare]() {
+        std::vector<std::shared_ptr<AudioNode>> nodes;
+        if (graph.empty())
+        {
+            nodes.push_back(scene->root);
+        }
+        else
+        {
+            nodes = deserializeGraph(*context, graph.data(), graph.size(), scene->root);
+            if (nodes.empty())
+            {
+                LOG("scene graph did not deserialize");
+                std::lock_guard<std::mutex> lock(m_mutex);
+                scene->failed = true;
+                if (scene->discarded)
+                    reclaimScene(*scene);
+                return;
+            }
+        }
+
+        scene->nodes = std::move(nodes);
+
+        if (prepare)
+            prepare(*context, scene->nodes);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        scene->ready = true;
+        if (scene->discarded)
+            reclaimScene(*scene);
+    });
+
+    return id;
+}
+
+bool SceneSwitcher::sceneReady(int sceneId) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_scenes.find(sceneId);
+    return it != m_scenes.end() && it->second->ready;
+}
+
+bool SceneSwitcher::switchTo(int sceneId, double when)
+{
+    std::shared_ptr<Scene> incoming;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_scenes.find(sceneId);
+        if (it == m_scenes.end() || !it->second->ready || it->second->failed)
+            return false;
+        incoming = it->second;
+        m_scenes.erase(it);
+    }
+
+    // The switch itself: one queued connection onto the idle input and a
+    // sample-accurate fade trigger. No graph construction happens here.
+    int incomingInput = m_activeInput == 0 ? 1 : 0;
+    m_context->connect(m_crossfade, incoming->root, incomingInput, 0);
+    m_crossfade->transitionTo(incomingInput == 1 ? 1.f : 0.f, when, m_crossfadeSeconds);
+
+    std::shared_ptr<Scene> outgoing = m_activeScene;
+    int outgoingInput = m_activeInput;
+    m_activeScene = incoming;
+    m_activeInput = incomingInput;
+
+    if (outgoing)
+    {
+        // Retire the outgoing scene once the fade has landed, so its kernels
+        // stop being pulled at zero gain; the crossfade keeps both inputs
+        // live only for the duration of the transition.
+        double now = m_context->currentTime();
+        double fadeEnd = (when > now ? when : now) + m_crossfadeSeconds;
+
+        auto context = m_context;
+        auto crossfade = m_crossfade;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_threads.emplace_back([this, context, crossfade, outgoing, outgoingInput, fadeEnd]() {
+            while (!m_shuttingDown && context->currentTime() < fadeEnd)
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+            context->disconnect(crossfade, outgoing->root, outgoingInput, 0);
+            reclaimScene(*outgoing);
+        });
+    }
+
+    return true;
+}
+
+void SceneSwitcher::discardScene(int sceneId)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_scenes.find(sceneId);
+    if (it == m_scenes.end())
+        return;
+
+    std::shared_ptr<Scene> scene = it->second;
+    m_scenes.erase(it);
+
+    scene->discarded = true;
+    if (scene->ready || scene->failed)
+        reclaimScene(*scene);
+    // otherwise the builder reclaims when it finishes
+}
+
+} // namespace lab
@@ -177,8 +177,12 @@
 
 #include "LabSound/core/AudioBus.h"
 
+#include "internal/NonlinearityTable.h"
+
+#include <map>
 #include <math.h>
 #include <memory.h>
+#include <mutex>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -742,6 +746,122 @@ namespace lab {
         return !isPlayingOrScheduled() || hasFinished();
     }
 
+    namespace
+    {
+        // Process-wide cache of rendered effects keyed by parameter hash, so
+        // every SfxrNode (and every playback) shares one rendered copy of a
+        // given sound.
+        std::mutex s_effectCacheMutex;
+        std::map<uint64_t, std::shared_ptr<AudioBus>> s_effectCache;
+    }
+
+    std::shared_ptr<AudioBus> SfxrNode::renderToBus(ContextRenderLock& r)
+    {
+        // Snapshot the parameters into a scratch synth so the state machine
+        // of a live playback isn't disturbed by the offline render.
+        Sfxr synth = *sfxr;
+        synth.wave_type = static_cast<int>(_waveType->value(r));
+        synth.p_base_freq = _startFrequency->value(r);
+        synth.p_freq_limit = _minFrequency->value(r);
+        synth.p_freq_ramp = _slide->value(r);
+        synth.p_freq_dramp = _deltaSlide->value(r);
+        synth.p_duty = _squareDuty->value(r);
+        synth.p_duty_ramp = _dutySweep->value(r);
+        synth.p_vib_strength = _vibratoDepth->value(r);
+        synth.p_vib_speed = _vibratoSpeed->value(r);
+        synth.p_env_attack = _attack->value(r);
+        synth.p_env_sustain = _sustainTime->value(r);
+        synth.p_env_decay = _decayTime->value(r);
+        synth.p_env_punch = _sustainPunch->value(r);
+        synth.p_lpf_resonance = _lpFiterResonance->value(r);
+        synth.filter_on = synth.p_lpf_resonance > 0;
+        synth.p_lpf_freq = _lpFilterCutoff->value(r);
+        synth.p_lpf_ramp = _lpFilterCutoffSweep->value(r);
+        synth.p_hpf_freq = _hpFilterCutoff->value(r);
+        synth.p_hpf_ramp = _hpFilterCutoffSweep->value(r);
+        synth.p_pha_offset = _phaserOffset->value(r);
+        synth.p_pha_ramp = _phaserSweep->value(r);
+        synth.p_repeat_speed = _repeatSpeed->value(r);
+        synth.p_arp_speed = _changeSpeed->value(r);
+        synth.p_arp_mod = _changeAmount->value(r);
+
+        float sampleRate = r.context()->sampleRate();
+
+        // Fingerprint every input the render depends on.
+        uint64_t key = NonlinearityTable::mixKey(0, float(synth.wave_type));
+        key = NonlinearityTable::mixKey(key, synth.p_base_freq);
+        key = NonlinearityTable::mixKey(key, synth.p_freq_limit);
+        key = NonlinearityTable::mixKey(key, synth.p_freq_ramp);
+        key = NonlinearityTable::mixKey(key, synth.p_freq_dramp);
+        key = NonlinearityTable::mixKey(key, synth.p_duty);
+        key = NonlinearityTable::mixKey(key, synth.p_duty_ramp);
+        key = NonlinearityTable::mixKey(key, synth.p_vib_strength);
+        key = NonlinearityTable::mixKey(key, synth.p_vib_speed);
+        key = NonlinearityTable::mixKey(key, synth.p_env_attack);
+        key = NonlinearityTable::mixKey(key, synth.p_env_sustain);
+        key = NonlinearityTable::mixKey(key, synth.p_env_decay);
+        key = NonlinearityTable::mixKey(key, synth.p_env_punch);
+        key = NonlinearityTable::mixKey(key, synth.p_lpf_resonance);
+        key = NonlinearityTable::mixKey(key, synth.p_lpf_freq);
+        key = NonlinearityTable::mixKey(key, synth.p_lpf_ramp);
+        key = NonlinearityTable::mixKey(key, synth.p_hpf_freq);
+        key = NonlinearityTable::mixKey(key, synth.p_hpf_ramp);
+        key = NonlinearityTable::mixKey(key, synth.p_pha_offset);
+        key = NonlinearityTable::mixKey(key, synth.p_pha_ramp);
+        key = NonlinearityTable::mixKey(key, synth.p_repeat_speed);
+        key = NonlinearityTable::mixKey(key, synth.p_arp_speed);
+        key = NonlinearityTable::mixKey(key, synth.p_arp_mod);
+        key = NonlinearityTable::mixKey(key, synth.sound_vol);
+        key = NonlinearityTable::mixKey(key, synth.master_vol);
+        key = NonlinearityTable::mixKey(key, sampleRate);
+
+        {
+            std::lock_guard<std::mutex> lock(s_effectCacheMutex);
+            auto it = s_effectCache.find(key);
+            if (it != s_effectCache.end())
+                return it->second;
+        }
+
+        // Render to completion. The envelope stages are bounded (at most
+        // 100000 samples each) and repeats don't restart the envelope, so the
+        // synth always terminates; the cap is pure paranoia. A chunk that ends
+        // mid-render leaves trailing zeros, which is just a short silent tail.
+        synth.ResetSample(false);
+        synth.playing_sample = true;
+
+        std::vector<float> samples;
+        const size_t maxFrames = 1 << 20;
+        float chunk[512];
+        while (synth.playing_sample && samples.size() < maxFrames)
+        {
+            memset(chunk, 0, sizeof(chunk));
+            synth.SynthSample(512, chunk, NULL);
+            for (size_t i = 0; i < 512; ++i)
+            {
+                float f = chunk[i];
+                if (f < -1.0f) f = -1.0f;
+                else if (f > 1.0f) f = 1.0f;
+                samples.push_back(f);
+            }
+        }
+        if (samples.empty())
+            samples.push_back(0.f);
+
+        auto bus = std::make_shared<AudioBus>(1, samples.size(), true);
+        bus->setSampleRate(sampleRate);
+        memcpy(bus->channel(0)->mutableData(), samples.data(), samples.size() * sizeof(float));
+
+        std::lock_guard<std::mutex> lock(s_effectCacheMutex);
+        s_effectCache[key] = bus;
+        return bus;
+    }
+
+    void SfxrNode::clearEffectCache()
+    {
+        std::lock_guard<std::mutex> lock(s_effectCacheMutex);
+        s_effectCache.clear();
+    }
+
 
 // ____________________________________
 // Some default sounds
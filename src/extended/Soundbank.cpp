@@ -0,0 +1,298 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/Soundbank.h"
+#include "LabSound/extended/Logging.h"
+
+#include "LabSound/core/Macros.h"
+
+#include <cstring>
+#include <fstream>
+
+#if defined(LABSOUND_PLATFORM_WINDOWS)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace lab
+{
+    namespace
+    {
+        // Bank layout, all fields little-endian:
+        //   BankHeader
+        //   channel data - planar float PCM, every channel starting on a
+        //                  DataAlignment boundary
+        //   index       - entryCount records of (nameLength, name bytes,
+        //                  dataOffset, frameCount, channelCount, sampleRate)
+        const char BankMagic[4] = {'L', 'S', 'B', 'K'};
+        const uint32_t BankVersion = 1;
+        const uint64_t DataAlignment = 64;  // file offsets; mappings are page aligned so this carries to addresses
+
+        struct BankHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint64_t entryCount;
+            uint64_t indexOffset;
+            uint64_t reserved;
+        };
+
+        uint64_t alignUp(uint64_t offset, uint64_t alignment)
+        {
+            return (offset + alignment - 1) & ~(alignment - 1);
+        }
+    }
+
+    // Owns the platform mapping handle; the Soundbank's entries are offsets
+    // into data().
+    class Soundbank::Mapping
+    {
+    public:
+        ~Mapping()
+        {
+#if defined(LABSOUND_PLATFORM_WINDOWS)
+            if (m_data) UnmapViewOfFile(m_data);
+            if (m_mappingHandle) CloseHandle(m_mappingHandle);
+            if (m_fileHandle != INVALID_HANDLE_VALUE) CloseHandle(m_fileHandle);
+#else
+            if (m_data) munmap(m_data, m_size);
+            if (m_fd >= 0) close(m_fd);
+#endif
+        }
+
+        bool map(const std::string & path)
+        {
+#if defined(LABSOUND_PLATFORM_WINDOWS)
+            m_fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                       OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (m_fileHandle == INVALID_HANDLE_VALUE)
+                return false;
+
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(m_fileHandle, &size) || size.QuadPart <= 0)
+                return false;
+            m_size = static_cast<size_t>(size.QuadPart);
+
+            m_mappingHandle = CreateFileMappingA(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!m_mappingHandle)
+                return false;
+
+            m_data = MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0);
+            return m_data != nullptr;
+#else
+            m_fd = ::open(path.c_str(), O_RDONLY);
+            if (m_fd < 0)
+                return false;
+
+            struct stat st;
+            if (fstat(m_fd, &st) != 0 || st.st_size <= 0)
+                return false;
+            m_size = static_cast<size_t>(st.st_size);
+
+            void * p = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+            if (p == MAP_FAILED)
+                return false;
+            m_data = p;
+            return true;
+#endif
+        }
+
+        const uint8_t * data() const { return static_cast<const uint8_t *>(m_data); }
+        size_t size() const { return m_size; }
+
+    private:
+        void * m_data = nullptr;
+        size_t m_size = 0;
+#if defined(LABSOUND_PLATFORM_WINDOWS)
+        HANDLE m_fileHandle = INVALID_HANDLE_VALUE;
+        HANDLE m_mappingHandle = nullptr;
+#else
+        int m_fd = -1;
+#endif
+    };
+
+    Soundbank::~Soundbank() = default;
+
+    std::shared_ptr<Soundbank> Soundbank::open(const std::string & path)
+    {
+        std::unique_ptr<Mapping> mapping(new Mapping());
+        if (!mapping->map(path) || mapping->size() < sizeof(BankHeader))
+        {
+            LOG_ERROR("Could not map soundbank %s", path.c_str());
+            return {};
+        }
+
+        BankHeader header;
+        std::memcpy(&header, mapping->data(), sizeof(header));
+        if (std::memcmp(header.magic, BankMagic, sizeof(BankMagic)) != 0 || header.version != BankVersion ||
+            header.indexOffset >= mapping->size())
+        {
+            LOG_ERROR("%s is not a valid soundbank", path.c_str());
+            return {};
+        }
+
+        // Walk the index, rejecting anything that runs past the mapping so a
+        // truncated or corrupt bank cannot produce out-of-bounds views.
+        std::shared_ptr<Soundbank> bank(new Soundbank());
+        const uint8_t * base = mapping->data();
+        size_t cursor = static_cast<size_t>(header.indexOffset);
+        for (uint64_t e = 0; e < header.entryCount; ++e)
+        {
+            uint32_t nameLength;
+            if (cursor + sizeof(nameLength) > mapping->size())
+                return {};
+            std::memcpy(&nameLength, base + cursor, sizeof(nameLength));
+            cursor += sizeof(nameLength);
+
+            if (cursor + nameLength + sizeof(Entry::dataOffset) + sizeof(Entry::frameCount) +
+                    sizeof(Entry::channelCount) + sizeof(Entry::sampleRate) > mapping->size())
+                return {};
+
+            std::string name(reinterpret_cast<const char *>(base + cursor), nameLength);
+            cursor += nameLength;
+
+            Entry entry;
+            std::memcpy(&entry.dataOffset, base + cursor, sizeof(entry.dataOffset));
+            cursor += sizeof(entry.dataOffset);
+            std::memcpy(&entry.frameCount, base + cursor, sizeof(entry.frameCount));
+            cursor += sizeof(entry.frameCount);
+            std::memcpy(&entry.channelCount, base + cursor, sizeof(entry.channelCount));
+            cursor += sizeof(entry.channelCount);
+            std::memcpy(&entry.sampleRate, base + cursor, sizeof(entry.sampleRate));
+            cursor += sizeof(entry.sampleRate);
+
+            uint64_t channelStride = alignUp(entry.frameCount * sizeof(float), DataAlignment);
+            if (!entry.channelCount || entry.dataOffset + channelStride * entry.channelCount > mapping->size())
+                return {};
+
+            bank->m_index[name] = entry;
+        }
+
+        bank->m_mapping = std::move(mapping);
+        return bank;
+    }
+
+    bool Soundbank::write(const std::string & path,
+                          const std::vector<std::pair<std::string, std::shared_ptr<AudioBus>>> & assets)
+    {
+        if (assets.empty())
+            return false;
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+
+        // Lay out channel data first so every entry's offset is known before
+        // the index is emitted.
+        struct Placed
+        {
+            Entry entry;
+            const std::string * name;
+            const AudioBus * bus;
+        };
+        std::vector<Placed> placed;
+        uint64_t offset = alignUp(sizeof(BankHeader), DataAlignment);
+        for (auto & asset : assets)
+        {
+            const AudioBus * bus = asset.second.get();
+            if (!bus || !bus->numberOfChannels() || !bus->length())
+                return false;
+
+            Placed p;
+            p.entry.dataOffset = offset;
+            p.entry.frameCount = bus->length();
+            p.entry.channelCount = static_cast<uint32_t>(bus->numberOfChannels());
+            p.entry.sampleRate = bus->sampleRate();
+            p.name = &asset.first;
+            p.bus = bus;
+            placed.push_back(p);
+
+            offset += alignUp(p.entry.frameCount * sizeof(float), DataAlignment) * p.entry.channelCount;
+        }
+
+        BankHeader header;
+        std::memcpy(header.magic, BankMagic, sizeof(BankMagic));
+        header.version = BankVersion;
+        header.entryCount = placed.size();
+        header.indexOffset = offset;
+        header.reserved = 0;
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+        const char zeros[DataAlignment] = {};
+        auto padTo = [&](uint64_t target) {
+            uint64_t at = static_cast<uint64_t>(file.tellp());
+            if (at < target)
+                file.write(zeros, target - at);
+        };
+
+        for (auto & p : placed)
+        {
+            padTo(p.entry.dataOffset);
+            uint64_t channelStride = alignUp(p.entry.frameCount * sizeof(float), DataAlignment);
+            for (uint32_t c = 0; c < p.entry.channelCount; ++c)
+            {
+                padTo(p.entry.dataOffset + channelStride * c);
+                file.write(reinterpret_cast<const char *>(p.bus->channel(c)->data()),
+                           p.entry.frameCount * sizeof(float));
+            }
+        }
+
+        padTo(header.indexOffset);
+        for (auto & p : placed)
+        {
+            uint32_t nameLength = static_cast<uint32_t>(p.name->size());
+            file.write(reinterpret_cast<const char *>(&nameLength), sizeof(nameLength));
+            file.write(p.name->data(), nameLength);
+            file.write(reinterpret_cast<const char *>(&p.entry.dataOffset), sizeof(p.entry.dataOffset));
+            file.write(reinterpret_cast<const char *>(&p.entry.frameCount), sizeof(p.entry.frameCount));
+            file.write(reinterpret_cast<const char *>(&p.entry.channelCount), sizeof(p.entry.channelCount));
+            file.write(reinterpret_cast<const char *>(&p.entry.sampleRate), sizeof(p.entry.sampleRate));
+        }
+
+        return file.good();
+    }
+
+    std::shared_ptr<AudioBus> Soundbank::bus(const std::string & name) const
+    {
+        auto it = m_index.find(name);
+        if (it == m_index.end())
+            return {};
+
+        const Entry & entry = it->second;
+        uint64_t channelStride = alignUp(entry.frameCount * sizeof(float), DataAlignment);
+
+        AudioBus * view = new AudioBus(entry.channelCount, static_cast<size_t>(entry.frameCount), false);
+        view->setSampleRate(entry.sampleRate);
+        for (uint32_t c = 0; c < entry.channelCount; ++c)
+        {
+            // The mapping is PROT_READ; the view is read-only by convention
+            // (see header) so the non-const channel interface is never used
+            // to write through it.
+            const float * samples =
+                reinterpret_cast<const float *>(m_mapping->data() + entry.dataOffset + channelStride * c);
+            view->setChannelMemory(c, const_cast<float *>(samples), static_cast<size_t>(entry.frameCount));
+        }
+
+        // The view holds no samples of its own; tie the mapping's lifetime to it.
+        std::shared_ptr<const Soundbank> keepAlive = shared_from_this();
+        return std::shared_ptr<AudioBus>(view, [keepAlive](AudioBus * b) { delete b; });
+    }
+
+    bool Soundbank::contains(const std::string & name) const
+    {
+        return m_index.find(name) != m_index.end();
+    }
+
+    std::vector<std::string> Soundbank::names() const
+    {
+        std::vector<std::string> result;
+        result.reserve(m_index.size());
+        for (auto & kv : m_index)
+            result.push_back(kv.first);
+        return result;
+    }
+}
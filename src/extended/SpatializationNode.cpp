@@ -4,9 +4,16 @@
 #include "LabSound/core/PannerNode.h"
 #include "LabSound/core/FloatPoint3D.h"
 
+#include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioNodeOutput.h"
+
 #include "LabSound/extended/SpatializationNode.h"
 #include "LabSound/extended/AudioContextLock.h"
 
+#include "internal/Biquad.h"
+
+#include <atomic>
+
 namespace lab
 {
     
@@ -70,22 +77,112 @@ namespace lab
         return occlusionAttenuation;
     }
     
+    void OcclusionBatch::stage(int emitterId, float attenuation, float lowpassCutoffHz)
+    {
+        OcclusionResult result;
+        result.attenuation = attenuation;
+        result.lowpassCutoffHz = lowpassCutoffHz;
+        m_staging[emitterId] = result;
+    }
+
+    void OcclusionBatch::publish()
+    {
+        // The staged set becomes the visible set in one atomic pointer swap;
+        // readers holding the previous snapshot keep it alive through their
+        // own reference until the end of their quantum.
+        auto snapshot = std::make_shared<std::map<int, OcclusionResult>>(std::move(m_staging));
+        m_staging.clear();
+        std::atomic_store(&m_current, std::shared_ptr<const std::map<int, OcclusionResult>>(std::move(snapshot)));
+    }
+
+    std::shared_ptr<const std::map<int, OcclusionResult>> OcclusionBatch::snapshot() const
+    {
+        return std::atomic_load(&m_current);
+    }
+
     // @tofix - pass in HRTF loader path
     SpatializationNode::SpatializationNode(const float sampleRate) : lab::PannerNode(sampleRate)
     {
         initialize();
     }
-    
+
+    SpatializationNode::~SpatializationNode()
+    {
+    }
+
     void SpatializationNode::setOccluders(std::shared_ptr<Occluders> o)
     {
         occluders = o;
     }
-    
+
+    void SpatializationNode::setOcclusionBatch(std::shared_ptr<OcclusionBatch> batch, int id)
+    {
+        occlusionBatch = batch;
+        emitterId = id;
+    }
+
+    void SpatializationNode::process(ContextRenderLock & r, size_t framesToProcess)
+    {
+        // Pick up the most recently published batch once, at the quantum
+        // boundary; the rest of the quantum works from the local copy.
+        if (occlusionBatch)
+        {
+            auto snapshot = occlusionBatch->snapshot();
+            if (snapshot)
+            {
+                auto it = snapshot->find(emitterId);
+                currentOcclusion = (it != snapshot->end()) ? it->second : OcclusionResult();
+            }
+        }
+
+        PannerNode::process(r, framesToProcess);
+
+        // Muffle: run the occlusion lowpass over the panned output through
+        // the shared biquad engine, both channels in parallel lanes.
+        float cutoff = currentOcclusion.lowpassCutoffHz;
+        float nyquist = r.context() ? 0.5f * r.context()->sampleRate() : 0.f;
+        if (!occlusionBatch || cutoff <= 0.f || cutoff >= nyquist)
+            return;
+
+        AudioBus * outputBus = output(0)->bus(r);
+        if (!outputBus || !outputBus->numberOfChannels())
+            return;
+
+        size_t channels = outputBus->numberOfChannels() < 2 ? outputBus->numberOfChannels() : 2;
+        if (cutoff != configuredCutoff)
+        {
+            double normalized = cutoff / nyquist;
+            for (size_t c = 0; c < 2; ++c)
+            {
+                if (!occlusionFilter[c])
+                    occlusionFilter[c].reset(new Biquad());
+                occlusionFilter[c]->setLowpassParams(normalized, 0);
+            }
+            configuredCutoff = cutoff;
+        }
+
+        Biquad * filters[2];
+        const float * sources[2];
+        float * dests[2];
+        for (size_t c = 0; c < channels; ++c)
+        {
+            filters[c] = occlusionFilter[c].get();
+            dests[c] = outputBus->channel(c)->mutableData();
+            sources[c] = dests[c];
+        }
+        Biquad::processChannels(filters, sources, dests, channels, framesToProcess);
+    }
+
     float SpatializationNode::distanceConeGain(ContextRenderLock & r)
     {
         if (!r.context())
             return 1.f;
-        
+
+        // A batch supersedes the geometric occluder set: the engine already
+        // did the occlusion math for every emitter this frame.
+        if (occlusionBatch)
+            return currentOcclusion.attenuation * PannerNode::distanceConeGain(r);
+
         AudioListener & listener = r.context()->listener();
 
         FloatPoint3D fwd = {
@@ -6,92 +6,79 @@
 #include "LabSound/core/AudioNodeOutput.h"
 #include "LabSound/core/AudioSetting.h"
 #include "LabSound/core/Macros.h"
-#include "LabSound/core/WindowFunctions.h"
 
 #include "LabSound/extended/SpectralMonitorNode.h"
 
-#include <ooura/fftsg.h>
+#include "internal/SpectralFFTService.h"
+
 #include <cmath>
+#include <cstring>
 
-namespace lab 
+namespace lab
 {
 
     using namespace lab;
 
-    //////////////////////////////////////////////////////
-    // Prviate FFT + SpectralMonitorNode Implementation //
-    //////////////////////////////////////////////////////
-
-    // FFT class directly inspired by that in Cinder Audio 2.
-    struct FFT 
-    {
-    public:
-        FFT(size_t size) : size(size)
-        {
-            oouraIp = (int *)calloc( 2 + (int)sqrt( size/2 ), sizeof( int ) );
-            oouraW = (float *)calloc( size/2, sizeof( float ) );
-        }
-
-        ~FFT()
-        {
-            free(oouraIp);
-            free(oouraW);
-        }
-
-        // does an in place transform of waveform to real and imag.
-        // real values are on even, imag on odd
-        void forward( std::vector<float>& waveform)
-        {
-            ooura::rdft( static_cast<int>(size), 1, &waveform[0], oouraIp, oouraW );
-        }
+    /////////////////////////////////////////////////
+    // Prviate SpectralMonitorNode Implementation  //
+    /////////////////////////////////////////////////
 
-        size_t size;
-        int * oouraIp;
-        float * oouraW;
-    };
-
-    class SpectralMonitorNode::SpectralMonitorNodeInternal 
+    class SpectralMonitorNode::SpectralMonitorNodeInternal
     {
     public:
 
-        SpectralMonitorNodeInternal() 
+        SpectralMonitorNodeInternal()
         : windowSize(std::make_shared<AudioSetting>("windowSize"))
-        , fft(nullptr)
         {
             setWindowSize(512);
         }
 
-        ~SpectralMonitorNodeInternal() 
+        ~SpectralMonitorNodeInternal()
         {
-            delete fft;
+            if (fftClient)
+                SpectralFFTService::shared().unregisterClient(fftClient);
         }
 
-        void setWindowSize(int s) 
+        void setWindowSize(int s)
         {
             cursor = 0;
+            accumulated = 0;
             windowSize->setUint32(static_cast<size_t>(s));
 
-            buffer.resize(s);
+            buffer.assign(s, 0.f);
+            submitScratch.resize(s);
 
-            for (size_t i = 0; i < s; ++i) 
-            {
-                buffer[i] = 0;
-            }
+            if (fftClient)
+                SpectralFFTService::shared().unregisterClient(fftClient);
+            fftClient = SpectralFFTService::shared().registerClient(s);
+        }
 
-            delete fft;
-            fft = new FFT(s);
+        // Unrolls the most recent windowSize samples (ending at cursor) from
+        // the ring and hands them to the shared service. Non-blocking.
+        void submitWindow()
+        {
+            size_t sz = buffer.size();
+            size_t start = cursor;  // oldest sample in the ring
+            memcpy(submitScratch.data(), &buffer[start], sizeof(float) * (sz - start));
+            if (start)
+                memcpy(submitScratch.data() + sz - start, &buffer[0], sizeof(float) * start);
+            SpectralFFTService::shared().submit(fftClient, submitScratch.data());
         }
-        
-        float _db;
 
-        size_t cursor;
+        float _db;
 
+        // The input ring. Analysis windows are submitted every half window
+        // (50% overlap) once a full window has accumulated, so the spectrum
+        // refreshes at twice the rate a fill-and-dump window would.
+        size_t cursor = 0;
+        size_t accumulated = 0;
         std::vector<float> buffer;
+        std::vector<float> submitScratch;
         std::recursive_mutex magMutex;
 
         std::shared_ptr<AudioSetting> windowSize;
 
-        FFT * fft;
+        int fftClient = 0;
     };
 
     ////////////////////////////////
@@ -139,44 +126,27 @@ namespace lab
             for (size_t c = 0; c < numberOfChannels; ++ c)
                 channels.push_back(bus->channel(c)->data());
 
-            size_t sz = internalNode->windowSize->valueUint32();
-
-            // if the fft is smaller than the quantum, just grab a chunk
-            if (sz < framesToProcess) 
-            {
-                internalNode->cursor = 0;
-                framesToProcess = internalNode->windowSize->valueUint32();
-            }
+            std::lock_guard<std::recursive_mutex> lock(internalNode->magMutex);
 
-            // if the quantum overlaps the end of the window, just fill up the buffer
-            if (internalNode->cursor + framesToProcess > sz)
-                framesToProcess = sz - internalNode->cursor;
+            size_t sz = internalNode->buffer.size();
+            size_t hop = sz / 2;
 
+            // accumulate the channel sum into the ring, submitting a full
+            // window to the shared FFT service at every hop boundary.
+            for (size_t i = 0; i < framesToProcess; ++i)
             {
-                std::lock_guard<std::recursive_mutex> lock(internalNode->magMutex);
-
-                internalNode->buffer.resize(sz);
-
-                for (size_t i = 0; i < framesToProcess; ++i) 
-                {
-                    internalNode->buffer[i + internalNode->cursor] = 0;
-                }
-
+                float p = 0.f;
                 for (unsigned c = 0; c < numberOfChannels; ++c)
-                {
-                    for (size_t i = 0; i < framesToProcess; ++i) 
-                    {
-                        float p = channels[c][i];
-                        internalNode->buffer[i + internalNode->cursor] += p;
-                    }
-                }
+                    p += channels[c][i];
+                internalNode->buffer[internalNode->cursor] = p;
 
-            }
+                if (++internalNode->cursor >= sz)
+                    internalNode->cursor = 0;
+                ++internalNode->accumulated;
 
-            // advance the cursor
-            internalNode->cursor += framesToProcess;
-            if (internalNode->cursor >= internalNode->windowSize->valueUint32())
-                internalNode->cursor = 0;
+                if (internalNode->accumulated >= sz && (internalNode->cursor % hop) == 0)
+                    internalNode->submitWindow();
+            }
         }
         // to here
 
@@ -193,43 +163,21 @@ namespace lab
         internalNode->setWindowSize(internalNode->windowSize->valueUint32());
     }
 
-    void SpectralMonitorNode::spectralMag(std::vector<float>& result) 
+    void SpectralMonitorNode::spectralMag(std::vector<float>& result)
     {
-        std::vector<float> window;
-
-        {
-            std::lock_guard<std::recursive_mutex> lock(internalNode->magMutex);
-            window.swap(internalNode->buffer);
-            internalNode->setWindowSize(internalNode->windowSize->valueUint32());
-        }
-
-        // http://www.ni.com/white-paper/4844/en/
-        applyWindow(lab::window_blackman, window);
-        internalNode->fft->forward(window);
-
-        // similar to cinder audio2 Scope object, although Scope smooths spectral samples frame by frame
-        // remove nyquist component - the first imaginary component
-        window[1] = 0.0f;
-
-        // compute normalized magnitude spectrum
-        // @tofix - break this into vector cartisian -> polar and then vector lowpass. skip lowpass if smoothing factor is very small
-        const float kMagScale = 1.0f ;/// detail->windowSize;
-        for(size_t i = 0; i < window.size(); i += 2)
-        {
-            float re = window[i];
-            float im = window[i+1];
-            window[i/2] = sqrt(re * re + im * im) * kMagScale;
-        }
-
-        result.swap(window);
+        // The worker publishes windowSize/2 Blackman-windowed magnitude bins
+        // (nyquist removed); this just snapshots the most recent set. Empty
+        // until the first full window has been transformed.
+        SpectralFFTService::shared().readMagnitudes(internalNode->fftClient, result);
     }
 
-    void SpectralMonitorNode::windowSize(size_t ws) 
+    void SpectralMonitorNode::windowSize(size_t ws)
     {
-        internalNode->setWindowSize(ws);
+        std::lock_guard<std::recursive_mutex> lock(internalNode->magMutex);
+        internalNode->setWindowSize(static_cast<int>(ws));
     }
 
-    size_t SpectralMonitorNode::windowSize() const 
+    size_t SpectralMonitorNode::windowSize() const
     {
         return internalNode->windowSize->valueUint32();
     }
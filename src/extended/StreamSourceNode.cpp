@@ -0,0 +1,352 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/StreamSourceNode.h"
+
+#include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioNodeOutput.h"
+#include "LabSound/extended/AudioContextLock.h"
+
+#include "internal/VectorMath.h"
+
+#include "readerwriterqueue/readerwriterqueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace lab
+{
+    namespace
+    {
+        // Encoded packets larger than this are malformed for voice-chat use
+        // and are rejected at the push site.
+        const size_t MaxEncodedPacketBytes = 8192;
+
+        const size_t MaxStreamChannels = 8;
+
+        // Ceiling on the frames one packet may decode to (opus caps at 120 ms;
+        // this allows a little more at high rates).
+        const size_t MaxPacketFrames = 8192;
+
+        // A worker shared by all stream sources, mirroring AudioFileReader's
+        // decode pool: drains are short and bursty, so one thread suffices and
+        // keeps decoder cache state warm.
+        class StreamDecodeWorker
+        {
+        public:
+            static StreamDecodeWorker & shared()
+            {
+                static StreamDecodeWorker worker;
+                return worker;
+            }
+
+            void enqueue(std::function<void()> task)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_tasks.push_back(std::move(task));
+                }
+                m_wake.notify_one();
+            }
+
+        private:
+            StreamDecodeWorker()
+            {
+                m_thread = std::thread(&StreamDecodeWorker::run, this);
+            }
+
+            ~StreamDecodeWorker()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_shouldExit = true;
+                }
+                m_wake.notify_all();
+                if (m_thread.joinable())
+                    m_thread.join();
+            }
+
+            void run()
+            {
+                for (;;)
+                {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(m_mutex);
+                        m_wake.wait(lock, [this]() { return m_shouldExit || !m_tasks.empty(); });
+                        if (m_shouldExit && m_tasks.empty())
+                            return;
+                        task = std::move(m_tasks.front());
+                        m_tasks.pop_front();
+                    }
+                    task();
+                }
+            }
+
+            std::mutex m_mutex;
+            std::condition_variable m_wake;
+            std::deque<std::function<void()>> m_tasks;
+            std::thread m_thread;
+            bool m_shouldExit = false;
+        };
+    }
+
+    struct StreamSourceNode::Internals
+    {
+        // One queued network packet: either encoded bytes for the decoder or
+        // raw interleaved PCM.
+        struct Packet
+        {
+            std::vector<uint8_t> encoded;
+            std::vector<float> pcm;
+        };
+
+        Internals(float sampleRate, size_t numberOfChannels,
+                  std::function<std::unique_ptr<StreamPacketDecoder>()> factory)
+        : packetQueue(256)
+        , decoderFactory(std::move(factory))
+        , channelCount(numberOfChannels)
+        {
+            // One second of ready audio, rounded up to a power of two so the
+            // ring indices wrap with a mask.
+            ringFrames = 1;
+            while (ringFrames < size_t(sampleRate))
+                ringFrames *= 2;
+
+            ring.resize(channelCount);
+            for (auto & channel : ring)
+                channel.reset(new float[ringFrames]);
+
+            planarScratch.reset(new float[MaxPacketFrames * channelCount]);
+            decodeScratch.reset(new float[MaxPacketFrames * channelCount]);
+
+            // 60 ms default jitter depth.
+            jitterDepthFrames = size_t(sampleRate * 0.06f);
+        }
+
+        size_t framesBuffered() const
+        {
+            return size_t(writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire));
+        }
+
+        // Worker side: drain every queued packet through the decoder into the
+        // ready ring. Only the shared worker runs this, one drain at a time.
+        void drain()
+        {
+            drainScheduled.store(false, std::memory_order_release);
+
+            Packet packet;
+            while (packetQueue.try_dequeue(packet))
+            {
+                const float * interleaved = nullptr;
+                size_t frames = 0;
+
+                if (!packet.pcm.empty())
+                {
+                    interleaved = packet.pcm.data();
+                    frames = packet.pcm.size() / channelCount;
+                }
+                else if (!packet.encoded.empty())
+                {
+                    if (!decoder && decoderFactory)
+                        decoder = decoderFactory();
+                    if (!decoder)
+                        continue; // encoded packets without a decoder are dropped
+
+                    frames = decoder->decode(packet.encoded.data(), packet.encoded.size(),
+                                             decodeScratch.get(), MaxPacketFrames);
+                    interleaved = decodeScratch.get();
+                }
+
+                if (!frames)
+                    continue;
+                if (frames > MaxPacketFrames)
+                    frames = MaxPacketFrames;
+
+                writeFrames(interleaved, frames);
+            }
+        }
+
+        void writeFrames(const float * interleaved, size_t frames)
+        {
+            // Drop what the ring can't take; the jitter window has long since
+            // overflowed if this happens.
+            size_t free = ringFrames - framesBuffered();
+            if (frames > free)
+                frames = free;
+            if (!frames)
+                return;
+
+            // Deinterleave into scratch planes, then at most two memcpys per
+            // channel into the ring.
+            float * planes[MaxStreamChannels];
+            for (size_t c = 0; c < channelCount; ++c)
+                planes[c] = planarScratch.get() + c * MaxPacketFrames;
+            VectorMath::vdeintlvem(interleaved, planes, channelCount, frames);
+
+            uint64_t w = writeIndex.load(std::memory_order_relaxed);
+            size_t mask = ringFrames - 1;
+            size_t start = size_t(w) & mask;
+            size_t firstRun = std::min(frames, ringFrames - start);
+
+            for (size_t c = 0; c < channelCount; ++c)
+            {
+                memcpy(ring[c].get() + start, planes[c], firstRun * sizeof(float));
+                if (frames > firstRun)
+                    memcpy(ring[c].get(), planes[c] + firstRun, (frames - firstRun) * sizeof(float));
+            }
+
+            writeIndex.store(w + frames, std::memory_order_release);
+        }
+
+        // Render side: copy frames out of the ring, honouring the jitter gate.
+        void readFrames(AudioBus * outputBus, size_t frames)
+        {
+            size_t buffered = framesBuffered();
+
+            if (!playing.load(std::memory_order_relaxed))
+            {
+                if (buffered < jitterDepthFrames.load(std::memory_order_relaxed))
+                {
+                    outputBus->zero();
+                    return;
+                }
+                playing.store(true, std::memory_order_relaxed);
+            }
+
+            if (buffered < frames)
+            {
+                // Underrun: go silent and re-arm the jitter gate so playback
+                // resumes with a full window rather than stuttering.
+                playing.store(false, std::memory_order_relaxed);
+                outputBus->zero();
+                return;
+            }
+
+            uint64_t r = readIndex.load(std::memory_order_relaxed);
+            size_t mask = ringFrames - 1;
+            size_t start = size_t(r) & mask;
+            size_t firstRun = std::min(frames, ringFrames - start);
+
+            size_t busChannels = outputBus->numberOfChannels();
+            for (size_t c = 0; c < busChannels; ++c)
+            {
+                // A mono stream feeding a wider bus duplicates its channel.
+                const float * source = ring[c < channelCount ? c : channelCount - 1].get();
+                float * dest = outputBus->channel(c)->mutableData();
+                memcpy(dest, source + start, firstRun * sizeof(float));
+                if (frames > firstRun)
+                    memcpy(dest + firstRun, source, (frames - firstRun) * sizeof(float));
+            }
+
+            readIndex.store(r + frames, std::memory_order_release);
+        }
+
+        moodycamel::ReaderWriterQueue<Packet> packetQueue;
+        std::function<std::unique_ptr<StreamPacketDecoder>()> decoderFactory;
+        std::unique_ptr<StreamPacketDecoder> decoder;  // created lazily on the worker
+
+        size_t channelCount;
+        size_t ringFrames = 0;
+        std::vector<std::unique_ptr<float[]>> ring;
+        std::unique_ptr<float[]> planarScratch;  // worker-only
+        std::unique_ptr<float[]> decodeScratch;  // worker-only
+
+        std::atomic<uint64_t> readIndex{0};
+        std::atomic<uint64_t> writeIndex{0};
+        std::atomic<size_t> jitterDepthFrames{0};
+        std::atomic<bool> playing{false};
+        std::atomic<bool> drainScheduled{false};
+    };
+
+    StreamSourceNode::StreamSourceNode(const float sampleRate, size_t numberOfChannels,
+                                       std::function<std::unique_ptr<StreamPacketDecoder>()> decoderFactory)
+    {
+        if (!numberOfChannels || numberOfChannels > MaxStreamChannels)
+            throw std::invalid_argument("StreamSourceNode: unsupported channel count");
+
+        m_internals = std::make_shared<Internals>(sampleRate, numberOfChannels, std::move(decoderFactory));
+
+        addOutput(std::unique_ptr<AudioNodeOutput>(new AudioNodeOutput(this, int(numberOfChannels))));
+
+        initialize();
+    }
+
+    StreamSourceNode::~StreamSourceNode()
+    {
+        uninitialize();
+        // Internals is shared with any in-flight worker drain, which keeps it
+        // alive until the drain completes.
+    }
+
+    bool StreamSourceNode::pushEncodedPacket(const uint8_t * data, size_t byteCount)
+    {
+        if (!data || !byteCount || byteCount > MaxEncodedPacketBytes)
+            return false;
+
+        Internals::Packet packet;
+        packet.encoded.assign(data, data + byteCount);
+        if (!m_internals->packetQueue.try_enqueue(std::move(packet)))
+            return false;
+
+        if (!m_internals->drainScheduled.exchange(true, std::memory_order_acq_rel))
+        {
+            std::shared_ptr<Internals> internals = m_internals;
+            StreamDecodeWorker::shared().enqueue([internals]() { internals->drain(); });
+        }
+        return true;
+    }
+
+    bool StreamSourceNode::pushPcmPacket(const float * interleaved, size_t frames)
+    {
+        if (!interleaved || !frames || frames > MaxPacketFrames)
+            return false;
+
+        Internals::Packet packet;
+        packet.pcm.assign(interleaved, interleaved + frames * m_internals->channelCount);
+        if (!m_internals->packetQueue.try_enqueue(std::move(packet)))
+            return false;
+
+        if (!m_internals->drainScheduled.exchange(true, std::memory_order_acq_rel))
+        {
+            std::shared_ptr<Internals> internals = m_internals;
+            StreamDecodeWorker::shared().enqueue([internals]() { internals->drain(); });
+        }
+        return true;
+    }
+
+    void StreamSourceNode::setJitterFrames(size_t frames)
+    {
+        if (frames > m_internals->ringFrames / 2)
+            frames = m_internals->ringFrames / 2;
+        m_internals->jitterDepthFrames.store(frames, std::memory_order_relaxed);
+    }
+
+    size_t StreamSourceNode::jitterFrames() const
+    {
+        return m_internals->jitterDepthFrames.load(std::memory_order_relaxed);
+    }
+
+    void StreamSourceNode::process(ContextRenderLock & r, size_t framesToProcess)
+    {
+        AudioBus * outputBus = output(0)->bus(r);
+        if (!outputBus)
+            return;
+
+        m_internals->readFrames(outputBus, framesToProcess);
+    }
+
+    void StreamSourceNode::reset(ContextRenderLock & r)
+    {
+        // Discard buffered audio and re-arm the jitter gate. Queued packets
+        // still drain, they just land in an empty ring.
+        m_internals->readIndex.store(m_internals->writeIndex.load(std::memory_order_acquire), std::memory_order_release);
+        m_internals->playing.store(false, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,201 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/SubgraphFreeze.h"
+
+#include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/OfflineAudioDestinationNode.h"
+
+#include "LabSound/extended/AudioContextLock.h"
+#include "LabSound/extended/Logging.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace lab
+{
+
+SubgraphFreeze::SubgraphFreeze(std::shared_ptr<AudioContext> context)
+    : m_context(context)
+{
+}
+
+SubgraphFreeze::~SubgraphFreeze()
+{
+    // Restore any frozen chains; a SubgraphFreeze going away should leave
+    // the graph as it found it. Entries still rendering never touched the
+    // live graph - their offline contexts join their render threads as the
+    // entries are destroyed.
+    for (auto & f : m_freezes)
+    {
+        if (f->state != State::Frozen)
+            continue;
+        std::vector<AudioContext::ConnectionOperation> swap(2);
+        swap[0].connect = false;
+        swap[0].destination = f->output;
+        swap[0].source = f->bounce;
+        swap[1].destination = f->output;
+        swap[1].source = f->chainHead;
+        m_context->applyConnectionBatch(swap);
+    }
+}
+
+int SubgraphFreeze::freeze(std::shared_ptr<AudioNode> chainHead,
+                           std::shared_ptr<AudioNode> output,
+                           SubgraphBuilder builder,
+                           float seconds,
+                           uint32_t numChannels,
+                           bool loop)
+{
+    if (!chainHead || !output || !builder || seconds <= 0.f || !numChannels)
+        return -1;
+
+    std::unique_ptr<FreezeEntry> entry(new FreezeEntry());
+    entry->id = m_nextId++;
+    entry->chainHead = chainHead;
+    entry->output = output;
+    entry->loop = loop;
+    entry->captured.resize(numChannels);
+
+    // The same construction MakeOfflineAudioContext performs, at the live
+    // context's sample rate so the bounce needs no rate conversion.
+    entry->offlineContext.reset(new AudioContext(true));
+    entry->offlineContext->setDestinationNode(std::make_shared<OfflineAudioDestinationNode>(
+        entry->offlineContext.get(), m_context->sampleRate(), seconds, numChannels));
+    entry->offlineContext->lazyInitialize();
+
+    std::shared_ptr<AudioNode> head = builder(*entry->offlineContext);
+    if (!head)
+        return -1;
+    entry->offlineContext->connect(entry->offlineContext->destination(), head);
+
+    // Stream each rendered quantum straight into the capture buffers; the
+    // bounce never exists twice in memory. The completion flag is the only
+    // value read cross-thread - update() won't look at the captures until
+    // it observes the store the render thread makes after its last quantum.
+    FreezeEntry * raw = entry.get();
+    auto offlineDestination =
+        static_cast<OfflineAudioDestinationNode *>(entry->offlineContext->destination().get());
+    offlineDestination->setRenderQuantumConsumer([raw](const AudioBus & bus) {
+        size_t channels = std::min(raw->captured.size(), bus.numberOfChannels());
+        for (size_t c = 0; c < channels; ++c)
+        {
+            const float * data = bus.channel(c)->data();
+            raw->captured[c].insert(raw->captured[c].end(), data, data + bus.length());
+        }
+    });
+    entry->offlineContext->offlineRenderCompleteCallback = [raw]() {
+        raw->renderComplete.store(true, std::memory_order_release);
+    };
+    entry->offlineContext->startRendering();
+
+    int id = entry->id;
+    m_freezes.push_back(std::move(entry));
+    return id;
+}
+
+void SubgraphFreeze::unfreeze(int id)
+{
+    for (auto it = m_freezes.begin(); it != m_freezes.end(); ++it)
+    {
+        FreezeEntry & f = **it;
+        if (f.id != id)
+            continue;
+
+        if (f.state == State::Frozen)
+        {
+            std::vector<AudioContext::ConnectionOperation> swap(2);
+            swap[0].connect = false;
+            swap[0].destination = f.output;
+            swap[0].source = f.bounce;
+            swap[1].destination = f.output;
+            swap[1].source = f.chainHead;
+            m_context->applyConnectionBatch(swap);
+            m_freezes.erase(it);
+        }
+        else if (f.renderComplete.load(std::memory_order_acquire))
+        {
+            // Bounce finished but was never swapped in; just drop it.
+            m_freezes.erase(it);
+        }
+        else
+        {
+            // Can't interrupt the offline render thread mid-bounce; let it
+            // finish into the capture buffers and discard on a later update().
+            f.abandoned = true;
+        }
+        return;
+    }
+}
+
+size_t SubgraphFreeze::update()
+{
+    size_t swapped = 0;
+
+    for (auto it = m_freezes.begin(); it != m_freezes.end();)
+    {
+        FreezeEntry & f = **it;
+        if (f.state != State::Rendering || !f.renderComplete.load(std::memory_order_acquire))
+        {
+            ++it;
+            continue;
+        }
+
+        if (f.abandoned)
+        {
+            it = m_freezes.erase(it);
+            continue;
+        }
+
+        size_t length = f.captured.empty() ? 0 : f.captured[0].size();
+        if (!length)
+        {
+            LOG_ERROR("SubgraphFreeze: bounce %d rendered no frames", f.id);
+            it = m_freezes.erase(it);
+            continue;
+        }
+
+        auto bounceBus = std::make_shared<AudioBus>(f.captured.size(), length);
+        bounceBus->setSampleRate(m_context->sampleRate());
+        for (size_t c = 0; c < f.captured.size(); ++c)
+            memcpy(bounceBus->channel(c)->mutableData(), f.captured[c].data(), length * sizeof(float));
+        f.captured.clear();
+        f.captured.shrink_to_fit();
+
+        f.bounce = std::make_shared<SampledAudioNode>();
+        {
+            ContextRenderLock r(m_context.get(), "SubgraphFreeze::update");
+            f.bounce->setBus(r, bounceBus);
+        }
+        f.bounce->setLoop(f.loop);
+        f.bounce->start(0);
+
+        // One transaction: the chain detaches and the bounce attaches in the
+        // same graph edit, so there is no quantum with both or neither.
+        std::vector<AudioContext::ConnectionOperation> swap(2);
+        swap[0].connect = false;
+        swap[0].destination = f.output;
+        swap[0].source = f.chainHead;
+        swap[1].destination = f.output;
+        swap[1].source = f.bounce;
+        m_context->applyConnectionBatch(swap);
+
+        f.offlineContext.reset();
+        f.state = State::Frozen;
+        ++swapped;
+        ++it;
+    }
+
+    return swapped;
+}
+
+bool SubgraphFreeze::frozen(int id) const
+{
+    for (auto & f : m_freezes)
+        if (f->id == id)
+            return f->state == State::Frozen;
+    return false;
+}
+
+}  // namespace lab
@@ -1,16 +1,23 @@
 // License: BSD 2 Clause
 // Copyright (C) 2015+, The LabSound Authors. All rights reserved.
 
-#include "LabSound/core/OscillatorNode.h"
 #include "LabSound/core/AudioNodeInput.h"
 #include "LabSound/core/AudioNodeOutput.h"
 #include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioProcessor.h"
+#include "LabSound/core/Constants.h"
 
 #include "LabSound/extended/SupersawNode.h"
 #include "LabSound/extended/ADSRNode.h"
 #include "LabSound/extended/AudioContextLock.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include <cfloat>
+#include <cmath>
+#include <cstdint>
 
 using namespace lab;
 
@@ -21,80 +28,169 @@ namespace lab
     // Private Supersaw Node Implementation //
     //////////////////////////////////////////
 
+    // The saw bank is a flat array of phase accumulators advanced in SIMD,
+    // summed internally and shaped by the embedded ADSR, so one process()
+    // call replaces the former per-oscillator graph of OscillatorNodes and
+    // their buses.
+
+    namespace {
+
+        // Two-sample polyBLEP residual applied at each wrap to band-limit the
+        // otherwise naive sawtooth. t is the wrapped phase in [0, 1), dt the
+        // per-sample phase increment.
+        inline float polyBlepAfterWrap(float t, float dt)
+        {
+            t /= dt;
+            return t + t - t * t - 1.f;
+        }
+
+        inline float polyBlepBeforeWrap(float t, float dt)
+        {
+            t = (t - 1.f) / dt;
+            return t * t + t + t + 1.f;
+        }
+
+        // Accumulates one saw into dest and returns the wrapped end phase.
+        float accumulateSaw(float phase, float increment, float * dest, size_t n)
+        {
+            size_t n4 = n & ~size_t(3);
+#ifdef __SSE2__
+            // vectorized over time: four consecutive samples of one saw per step
+            __m128 p = _mm_setr_ps(phase,
+                                   phase + increment,
+                                   phase + 2 * increment,
+                                   phase + 3 * increment);
+            const __m128 step = _mm_set1_ps(4 * increment);
+            const __m128 one = _mm_set1_ps(1.f);
+            const __m128 two = _mm_set1_ps(2.f);
+
+            for (size_t i = 0; i < n4; i += 4)
+            {
+                // frac(p); p never goes negative so truncation is floor
+                __m128 frac = _mm_sub_ps(p, _mm_cvtepi32_ps(_mm_cvttps_epi32(p)));
+                frac = _mm_add_ps(frac, _mm_and_ps(_mm_cmplt_ps(frac, _mm_setzero_ps()), one)); // cvttps rounds toward zero
+
+                __m128 saw = _mm_sub_ps(_mm_mul_ps(two, frac), one);
+                _mm_storeu_ps(dest + i, _mm_add_ps(_mm_loadu_ps(dest + i), saw));
+
+                p = _mm_add_ps(frac, step);
+            }
+#else
+            float p = phase;
+            for (size_t i = 0; i < n4; ++i)
+            {
+                p -= floorf(p);
+                dest[i] += 2.f * p - 1.f;
+                p += increment;
+            }
+#endif
+            for (size_t i = n4; i < n; ++i)
+            {
+                float p = phase + i * increment;
+                p -= floorf(p);
+                dest[i] += 2.f * p - 1.f;
+            }
+
+            // polyBLEP correction at each wrap inside the block; a saw wraps
+            // only freq/sampleRate times per sample, so this scalar pass
+            // touches a handful of samples per quantum.
+            float dt = increment;
+            for (int k = 0;; ++k)
+            {
+                int i = static_cast<int>(ceilf((k + 1 - phase) / increment));
+                if (i >= static_cast<int>(n))
+                    break;
+
+                float tAfter = phase + i * increment - (k + 1);
+                if (i >= 0 && tAfter >= 0.f && tAfter < dt)
+                    dest[i] -= polyBlepAfterWrap(tAfter, dt);
+
+                float tBefore = tAfter - increment + 1.f;
+                if (i >= 1 && tBefore > 1.f - dt && tBefore <= 1.f)
+                    dest[i - 1] -= polyBlepBeforeWrap(tBefore, dt);
+            }
+
+            float end = phase + n * increment;
+            return end - floorf(end);
+        }
+
+    } // anonymous namespace
+
     class SupersawNode::SupersawNodeInternal
     {
     public:
 
+        // sawCount can grow to its param maximum without reallocating, so the
+        // render thread may track count changes directly.
+        enum { MaxSaws = 100 };
+
         SupersawNodeInternal() : cachedDetune(FLT_MAX), cachedFrequency(FLT_MAX)
         {
             gainNode = std::make_shared<ADSRNode>();
-            sawCount = std::make_shared<AudioParam>("sawCount", 1.0, 100.0f, 3.0f);
+            gainNode->m_processor->setNumberOfChannels(1);
+
+            sawCount = std::make_shared<AudioParam>("sawCount", 1.0, 100.0f, MaxSaws);
             detune = std::make_shared<AudioParam>("detune", 1.0, 0, 120);
-            frequency= std::make_shared<AudioParam>("frequency", 440.0, 1.0f, sampleRate * 0.5f);
+            frequency = std::make_shared<AudioParam>("frequency", 440.0, 1.0f, LABSOUND_DEFAULT_SAMPLERATE * 0.5f);
+
+            phases.reserve(MaxSaws);
+            increments.reserve(MaxSaws);
         }
 
         ~SupersawNodeInternal()
         {
-
         }
 
         void update(ContextRenderLock & r)
         {
-            if (cachedFrequency != frequency->value(r))
+            float sampleRate = r.context()->sampleRate();
+
+            size_t n = static_cast<size_t>(sawCount->value(r) + 0.5f);
+            if (n < 1) n = 1;
+            if (n > MaxSaws) n = MaxSaws;
+
+            bool countChanged = n != phases.size();
+            if (countChanged)
             {
-                cachedFrequency = frequency->value(r);
-                for (auto i : saws)
+                size_t oldCount = phases.size();
+                phases.resize(n);
+                increments.resize(n);
+
+                // spread the new lanes' phases deterministically so the stack
+                // doesn't comb-filter against itself
+                for (size_t i = oldCount; i < n; ++i)
                 {
-                    i->frequency()->setValue(cachedFrequency);
-                    i->frequency()->resetSmoothedValue();
+                    uint32_t h = static_cast<uint32_t>(i) * 2654435761u + 1013904223u;
+                    phases[i] = (h >> 8) * (1.f / 16777216.f);
                 }
             }
 
-            if (cachedDetune != detune->value(r))
+            if (countChanged || cachedFrequency != frequency->value(r) || cachedDetune != detune->value(r))
             {
+                cachedFrequency = frequency->value(r);
                 cachedDetune = detune->value(r);
-                float n = cachedDetune / ((float) saws.size() - 1.0f);
-                for (size_t i = 0; i < saws.size(); ++i)
+
+                // the saws spread +-detune cents around the center frequency
+                float spread = increments.size() > 1 ? cachedDetune / (static_cast<float>(increments.size()) - 1.0f) : 0.f;
+                for (size_t i = 0; i < increments.size(); ++i)
                 {
-                    saws[i]->detune()->setValue(-cachedDetune + float(i) * 2 * n);
+                    float cents = increments.size() > 1 ? -cachedDetune + static_cast<float>(i) * 2 * spread : 0.f;
+                    float rate = cachedFrequency * powf(2.f, cents / 1200.f);
+                    increments[i] = rate / sampleRate;
                 }
             }
         }
 
-        void update(ContextRenderLock & r, bool okayToReallocate)
+        void render(ContextRenderLock & r, AudioBus * outputBus, size_t framesToProcess)
         {
-            size_t currentN = saws.size();
-            int n = int(sawCount->value(r) + 0.5f);
-
-            auto context = r.context();
-
-            if (okayToReallocate && (n != currentN))
-            {
-                for (auto i : sawStorage)
-                {
-                    // r.context()->disconnect(i); // dimitri
-                    context->disconnect(i, nullptr);
-                }
-
-                sawStorage.clear();
-                saws.clear();
-
-                for (int i = 0; i < n; ++i) sawStorage.emplace_back(std::make_shared<OscillatorNode>(sampleRate));
-
-                for (int i = 0; i < n; ++i) saws.push_back(sawStorage[i].get());
-
-                for (auto i : sawStorage)
-                {
-                    i->setType(OscillatorType::SAWTOOTH);
-                    context->connect(gainNode, i, 0, 0);
-                    i->start(0);
-                }
+            outputBus->zero();
+            float * dest = outputBus->channel(0)->mutableData();
 
-                cachedFrequency = FLT_MAX;
-                cachedDetune = FLT_MAX;
-            }
+            for (size_t i = 0; i < phases.size(); ++i)
+                phases[i] = accumulateSaw(phases[i], increments[i], dest, framesToProcess);
 
-            update(r);
+            // shape in place with the embedded envelope
+            gainNode->m_processor->process(r, outputBus, outputBus, framesToProcess);
         }
 
         std::shared_ptr<ADSRNode> gainNode;
@@ -104,12 +200,11 @@ namespace lab
 
     private:
 
-        float sampleRate;
         float cachedDetune;
         float cachedFrequency;
 
-        std::vector<std::shared_ptr<OscillatorNode>> sawStorage;
-        std::vector<OscillatorNode * > saws;
+        std::vector<float> phases;
+        std::vector<float> increments;
     };
 
     //////////////////////////
@@ -147,15 +242,19 @@ namespace lab
             return;
         }
 
+        internalNode->render(r, outputBus, framesToProcess);
+
+        // anything driven into the node mixes with the saw bank
         AudioBus * inputBus = input(0)->bus(r);
+        if (input(0)->isConnected())
+            outputBus->sumFrom(*inputBus);
 
-        outputBus->copyFrom(*inputBus);
         outputBus->clearSilentFlag();
     }
 
     void SupersawNode::update(ContextRenderLock & r)
     {
-        internalNode->update(r, true);
+        internalNode->update(r);
     }
 
     std::shared_ptr<AudioParam> SupersawNode::attack() const { return internalNode->gainNode->attackTime(); }
@@ -178,7 +277,9 @@ namespace lab
 
     bool SupersawNode::propagatesSilence(ContextRenderLock & r) const
     {
-        return true; // return internalNode->gainNode->propagatesSilence(now); // dimitri 
+        // the saw bank renders regardless of input, so the node must not be
+        // skipped as silent; the envelope decides what is audible
+        return false;
     }
 
 } // End namespace lab
@@ -0,0 +1,313 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/TimeStretchNode.h"
+
+#include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/AudioNodeOutput.h"
+#include "LabSound/core/AudioSetting.h"
+#include "LabSound/extended/AudioContextLock.h"
+
+#include "internal/Assertions.h"
+#include "internal/VectorMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace lab
+{
+    namespace
+    {
+        // ~23 ms analysis window at 44.1 kHz; each block synthesizes half a
+        // window of new output.
+        const size_t WindowFrames = 1024;
+        const size_t HopFrames = WindowFrames / 2;
+
+        // The WSOLA search range to either side of the natural segment
+        // position (~6 ms). Wider finds better matches but costs linearly.
+        const size_t SearchFrames = 256;
+
+        const size_t ScratchFrames = WindowFrames + 2 * SearchFrames;
+
+        // Output ring; power of two, must hold at least a hop plus a quantum.
+        const size_t RingFrames = 2048;
+
+        // The coarse correlation pass strides candidates and a second pass
+        // refines around the winner, quartering the search cost for no
+        // audible difference.
+        const size_t CoarseStep = 4;
+    }
+
+    TimeStretchNode::TimeStretchNode()
+    : AudioScheduledSourceNode()
+    , m_isLooping(std::make_shared<AudioSetting>("loop"))
+    {
+        m_tempo = std::make_shared<AudioParam>("tempo", 1.0, 0.25, 4.0);
+        m_pitchRatio = std::make_shared<AudioParam>("pitchRatio", 1.0, 0.25, 4.0);
+
+        m_params.push_back(m_tempo);
+        m_params.push_back(m_pitchRatio);
+
+        m_settings.push_back(m_isLooping);
+
+        m_fadeIn.resize(HopFrames);
+        m_fadeOut.resize(HopFrames);
+        for (size_t i = 0; i < HopFrames; ++i)
+        {
+            float x = float(i) / float(HopFrames);
+            m_fadeIn[i] = x;
+            m_fadeOut[i] = 1.f - x;
+        }
+        m_blockScratch.resize(HopFrames);
+
+        // Default to mono. A call to setBus() will set the number of output channels to that of the bus.
+        addOutput(std::unique_ptr<AudioNodeOutput>(new AudioNodeOutput(this, 1)));
+
+        initialize();
+    }
+
+    TimeStretchNode::~TimeStretchNode()
+    {
+        uninitialize();
+    }
+
+    bool TimeStretchNode::setBus(ContextRenderLock & r, std::shared_ptr<AudioBus> sourceBus)
+    {
+        ASSERT(r.context());
+
+        if (sourceBus)
+        {
+            size_t numberOfChannels = sourceBus->numberOfChannels();
+            if (!numberOfChannels || numberOfChannels > AudioContext::maxNumberOfChannels)
+                return false;
+
+            output(0)->setNumberOfChannels(r, numberOfChannels);
+
+            m_channelCount = numberOfChannels;
+            m_scratch.resize(numberOfChannels);
+            m_prevTail.resize(numberOfChannels);
+            m_ring.resize(numberOfChannels);
+            for (size_t c = 0; c < numberOfChannels; ++c)
+            {
+                m_scratch[c].assign(ScratchFrames, 0.f);
+                m_prevTail[c].assign(HopFrames, 0.f);
+                m_ring[c].assign(RingFrames, 0.f);
+            }
+        }
+
+        m_sourceBus = sourceBus;
+        m_sourcePos = 0;
+        m_primed = false;
+        m_sourceExhausted = false;
+        m_ringRead = 0;
+        m_ringWrite = 0;
+        return true;
+    }
+
+    bool TimeStretchNode::loop() const
+    {
+        return m_isLooping->valueUint32() != 0;
+    }
+
+    void TimeStretchNode::setLoop(bool loop)
+    {
+        m_isLooping->setUint32(loop ? 1 : 0);
+    }
+
+    size_t TimeStretchNode::ringFramesAvailable() const
+    {
+        return m_ringWrite - m_ringRead;
+    }
+
+    bool TimeStretchNode::fillScratch(float pitch)
+    {
+        const size_t sourceLength = m_sourceBus->length();
+        const bool looping = loop();
+
+        // Source index of the first scratch sample; past the end with no loop
+        // means every sample from here on is silence.
+        double scratchStart = m_sourcePos - double(SearchFrames) * pitch;
+        if (!looping && scratchStart >= double(sourceLength))
+            return false;
+
+        for (size_t c = 0; c < m_channelCount; ++c)
+        {
+            const float * source = m_sourceBus->channel(c)->data();
+            float * scratch = m_scratch[c].data();
+
+            double pos = scratchStart;
+            for (size_t i = 0; i < ScratchFrames; ++i, pos += pitch)
+            {
+                double p = pos;
+                if (looping)
+                {
+                    p = fmod(p, double(sourceLength));
+                    if (p < 0)
+                        p += double(sourceLength);
+                }
+
+                if (p < 0 || p >= double(sourceLength - 1))
+                {
+                    scratch[i] = 0.f;
+                    continue;
+                }
+
+                size_t i0 = size_t(p);
+                float frac = float(p - double(i0));
+                scratch[i] = source[i0] + frac * (source[i0 + 1] - source[i0]);
+            }
+        }
+
+        return true;
+    }
+
+    void TimeStretchNode::synthesizeBlock(float tempo, float pitch)
+    {
+        using namespace VectorMath;
+
+        if (!fillScratch(pitch))
+        {
+            m_sourceExhausted = true;
+            return;
+        }
+
+        // Choose the candidate offset whose overlap best continues what was
+        // just rendered. Channel 0 is the search reference; every channel
+        // uses the same offset so the image stays phase-coherent.
+        size_t bestOffset = SearchFrames;
+        if (m_primed)
+        {
+            const float * reference = m_prevTail[0].data();
+            const float * scratch = m_scratch[0].data();
+
+            float bestScore = 0.f;
+            bool haveScore = false;
+            for (size_t d = 0; d <= 2 * SearchFrames; d += CoarseStep)
+            {
+                float score;
+                vdotpr(reference, scratch + d, &score, HopFrames);
+                if (!haveScore || score > bestScore)
+                {
+                    bestScore = score;
+                    bestOffset = d;
+                    haveScore = true;
+                }
+            }
+
+            size_t lo = bestOffset > CoarseStep ? bestOffset - CoarseStep + 1 : 0;
+            size_t hi = std::min(bestOffset + CoarseStep - 1, 2 * SearchFrames);
+            for (size_t d = lo; d <= hi; ++d)
+            {
+                float score;
+                vdotpr(reference, scratch + d, &score, HopFrames);
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    bestOffset = d;
+                }
+            }
+        }
+
+        // Overlap-add a hop of new output per channel and bank the new tail.
+        const size_t mask = RingFrames - 1;
+        for (size_t c = 0; c < m_channelCount; ++c)
+        {
+            const float * segment = m_scratch[c].data() + bestOffset;
+            float * tail = m_prevTail[c].data();
+            float * block = m_blockScratch.data();
+
+            vmul(segment, 1, m_fadeIn.data(), 1, block, 1, HopFrames);
+            vmul(tail, 1, m_fadeOut.data(), 1, tail, 1, HopFrames);
+            vadd(block, 1, tail, 1, block, 1, HopFrames);
+
+            size_t start = m_ringWrite & mask;
+            size_t firstRun = std::min(HopFrames, RingFrames - start);
+            memcpy(m_ring[c].data() + start, block, firstRun * sizeof(float));
+            if (HopFrames > firstRun)
+                memcpy(m_ring[c].data(), block + firstRun, (HopFrames - firstRun) * sizeof(float));
+
+            memcpy(tail, segment + HopFrames, HopFrames * sizeof(float));
+        }
+
+        m_ringWrite += HopFrames;
+        m_primed = true;
+
+        // The hop consumes tempo * HopFrames source frames regardless of the
+        // offset chosen - per-block drift is bounded by the search window.
+        m_sourcePos += double(HopFrames) * tempo;
+
+        const size_t sourceLength = m_sourceBus->length();
+        if (loop() && m_sourcePos >= double(sourceLength))
+            m_sourcePos -= double(sourceLength);
+    }
+
+    void TimeStretchNode::process(ContextRenderLock & r, size_t framesToProcess)
+    {
+        AudioBus * outputBus = output(0)->bus(r);
+        if (!outputBus)
+            return;
+
+        if (!isInitialized() || !m_sourceBus || outputBus->numberOfChannels() != m_channelCount)
+        {
+            outputBus->zero();
+            return;
+        }
+
+        size_t quantumFrameOffset = 0;
+        size_t nonSilentFramesToProcess = 0;
+        updateSchedulingInfo(r, framesToProcess, outputBus, quantumFrameOffset, nonSilentFramesToProcess);
+
+        if (!nonSilentFramesToProcess)
+        {
+            outputBus->zero();
+            return;
+        }
+
+        float tempo = std::max(0.25f, std::min(4.f, m_tempo->value(r)));
+        float pitch = std::max(0.25f, std::min(4.f, m_pitchRatio->value(r)));
+
+        while (ringFramesAvailable() < nonSilentFramesToProcess && !m_sourceExhausted)
+            synthesizeBlock(tempo, pitch);
+
+        size_t available = std::min(ringFramesAvailable(), nonSilentFramesToProcess);
+        const size_t mask = RingFrames - 1;
+        size_t start = m_ringRead & mask;
+        size_t firstRun = std::min(available, RingFrames - start);
+
+        for (size_t c = 0; c < m_channelCount; ++c)
+        {
+            float * destination = outputBus->channel(c)->mutableData() + quantumFrameOffset;
+            memcpy(destination, m_ring[c].data() + start, firstRun * sizeof(float));
+            if (available > firstRun)
+                memcpy(destination + firstRun, m_ring[c].data(), (available - firstRun) * sizeof(float));
+            if (available < nonSilentFramesToProcess)
+                memset(destination + available, 0, (nonSilentFramesToProcess - available) * sizeof(float));
+        }
+
+        m_ringRead += available;
+        outputBus->clearSilentFlag();
+
+        if (m_sourceExhausted && !ringFramesAvailable())
+            finish(r);
+    }
+
+    void TimeStretchNode::reset(ContextRenderLock & r)
+    {
+        AudioScheduledSourceNode::reset(r);
+
+        m_sourcePos = 0;
+        m_primed = false;
+        m_sourceExhausted = false;
+        m_ringRead = 0;
+        m_ringWrite = 0;
+        for (size_t c = 0; c < m_channelCount; ++c)
+            std::fill(m_prevTail[c].begin(), m_prevTail[c].end(), 0.f);
+    }
+
+    bool TimeStretchNode::propagatesSilence(ContextRenderLock & r) const
+    {
+        return !isPlayingOrScheduled() || hasFinished() || !m_sourceBus;
+    }
+}
@@ -0,0 +1,203 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/VoiceManager.h"
+
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/AudioParam.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace lab
+{
+
+namespace
+{
+    const float kSilenceDb = -120.f;
+
+    float gainToDb(float gain)
+    {
+        return 20.f * log10f(std::max(gain, 1.e-6f));
+    }
+
+    // The panner's dynamically computed distance and cone attenuation, in
+    // dB. The params are written by the render thread each quantum; the
+    // smoothed value is a coherent single-float read from here.
+    float pannerAttenuationDb(PannerNode & panner)
+    {
+        return gainToDb(panner.distanceGain()->smoothedValue() * panner.coneGain()->smoothedValue());
+    }
+}
+
+VoiceManager::VoiceManager(std::shared_ptr<AudioContext> context)
+    : VoiceManager(context, Policy())
+{
+}
+
+VoiceManager::VoiceManager(std::shared_ptr<AudioContext> context, Policy policy)
+    : m_context(context)
+    , m_policy(policy)
+    , m_metering(new MeteringEngine(context))
+{
+}
+
+VoiceManager::~VoiceManager()
+{
+    // Never leave a source muted behind a manager that no longer exists.
+    for (auto & v : m_voices)
+    {
+        if (v.state == State::Audible)
+            continue;
+
+        if (auto source = v.source.lock())
+            source->setParked(false);
+        if (auto gain = v.gain.lock())
+            gain->gain()->setValue(v.restoreGain);
+    }
+}
+
+int VoiceManager::manage(std::shared_ptr<SampledAudioNode> source,
+                         std::shared_ptr<GainNode> gain,
+                         std::shared_ptr<PannerNode> panner)
+{
+    if (!source || !gain)
+        return -1;
+
+    ManagedVoice voice;
+    voice.id = m_nextId++;
+    voice.source = source;
+    voice.gain = gain;
+    voice.panner = panner;
+    voice.tapId = m_metering->addTap(gain);
+    voice.restoreGain = gain->gain()->smoothedValue();
+    m_voices.push_back(voice);
+    return voice.id;
+}
+
+void VoiceManager::unmanage(int id)
+{
+    for (auto it = m_voices.begin(); it != m_voices.end(); ++it)
+    {
+        if (it->id != id)
+            continue;
+
+        if (it->state != State::Audible)
+        {
+            if (auto source = it->source.lock())
+                source->setParked(false);
+            if (auto gain = it->gain.lock())
+                gain->gain()->setValue(it->restoreGain);
+        }
+        m_metering->removeTap(it->tapId);
+        m_voices.erase(it);
+        return;
+    }
+}
+
+void VoiceManager::update()
+{
+    const double now = m_context->currentTime();
+
+    // Drop released chains and score the rest.
+    for (auto it = m_voices.begin(); it != m_voices.end();)
+    {
+        auto source = it->source.lock();
+        auto gain = it->gain.lock();
+        if (!source || !gain)
+        {
+            m_metering->removeTap(it->tapId);
+            it = m_voices.erase(it);
+            continue;
+        }
+
+        float attenuationDb = 0.f;
+        if (auto panner = it->panner.lock())
+            attenuationDb = pannerAttenuationDb(*panner);
+
+        if (it->state == State::Parked)
+        {
+            // The tap reads silence while parked; rank by what the voice
+            // could contribute, minus the hysteresis margin.
+            it->audibilityDb = gainToDb(it->restoreGain) + attenuationDb - m_policy.reviveMarginDb;
+        }
+        else
+        {
+            float powerDb = std::max(m_metering->levels(it->tapId).db, kSilenceDb);
+            it->audibilityDb = powerDb + attenuationDb;
+        }
+        ++it;
+    }
+
+    // Complete fades whose ramp has finished: the source goes quiet for
+    // real, so parking it now is inaudible.
+    for (auto & v : m_voices)
+    {
+        if (v.state != State::FadingOut || now < v.parkAtTime)
+            continue;
+        if (auto source = v.source.lock())
+        {
+            source->setParked(true);
+            v.state = State::Parked;
+        }
+    }
+
+    // Loudest first; everything past the budget should be parked.
+    std::vector<ManagedVoice *> ranked;
+    ranked.reserve(m_voices.size());
+    for (auto & v : m_voices)
+        ranked.push_back(&v);
+    std::sort(ranked.begin(), ranked.end(),
+              [](const ManagedVoice * a, const ManagedVoice * b) { return a->audibilityDb > b->audibilityDb; });
+
+    for (size_t i = 0; i < ranked.size(); ++i)
+    {
+        ManagedVoice & v = *ranked[i];
+        auto source = v.source.lock();
+        auto gainNode = v.gain.lock();
+        if (!source || !gainNode)
+            continue;
+
+        const bool withinBudget = i < m_policy.maxAudibleVoices;
+
+        if (withinBudget && v.state != State::Audible)
+        {
+            // Revive: resume rendering and ramp the gate back up from
+            // wherever the fade left it.
+            float from = v.state == State::Parked ? 0.f : gainNode->gain()->smoothedValue();
+            source->setParked(false);
+            gainNode->gain()->setValueAtTime(from, static_cast<float>(now));
+            gainNode->gain()->linearRampToValueAtTime(v.restoreGain, static_cast<float>(now + m_policy.fadeSeconds));
+            v.state = State::Audible;
+        }
+        else if (!withinBudget && v.state == State::Audible)
+        {
+            // Fade to silence first; the park lands once the ramp is done.
+            v.restoreGain = gainNode->gain()->smoothedValue();
+            gainNode->gain()->setValueAtTime(v.restoreGain, static_cast<float>(now));
+            gainNode->gain()->linearRampToValueAtTime(0.f, static_cast<float>(now + m_policy.fadeSeconds));
+            v.parkAtTime = now + m_policy.fadeSeconds;
+            v.state = State::FadingOut;
+        }
+    }
+}
+
+size_t VoiceManager::audibleVoices() const
+{
+    size_t count = 0;
+    for (auto & v : m_voices)
+        if (v.state == State::Audible)
+            ++count;
+    return count;
+}
+
+size_t VoiceManager::parkedVoices() const
+{
+    size_t count = 0;
+    for (auto & v : m_voices)
+        if (v.state == State::Parked)
+            ++count;
+    return count;
+}
+
+}  // namespace lab
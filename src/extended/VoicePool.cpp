@@ -0,0 +1,124 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/extended/VoicePool.h"
+#include "LabSound/extended/AudioContextLock.h"
+
+#include "LabSound/core/AudioContext.h"
+
+#include "internal/Assertions.h"
+
+namespace lab
+{
+
+VoicePool::VoicePool(std::shared_ptr<AudioContext> context, size_t count, std::shared_ptr<AudioNode> output,
+                     const std::string & hrtfSearchPath)
+    : m_context(context)
+    , m_output(output)
+{
+    ASSERT(context && output && count > 0);
+
+    m_voices.resize(count);
+    m_busy.resize(count, false);
+    m_freeList.reserve(count);
+
+    float sampleRate = context->sampleRate();
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        Voice & voice = m_voices[i];
+        voice.source = std::make_shared<SampledAudioNode>();
+        voice.gain = std::make_shared<GainNode>();
+        voice.panner = std::make_shared<PannerNode>(sampleRate, hrtfSearchPath);
+
+        // Gate closed until the voice is acquired.
+        voice.gain->gain()->setValue(0.f);
+
+        context->connect(voice.gain, voice.source);
+        context->connect(voice.panner, voice.gain);
+        context->connect(output, voice.panner);
+
+        m_freeList.push_back(count - 1 - i);  // so voice 0 is acquired first
+    }
+}
+
+VoicePool::~VoicePool()
+{
+    for (Voice & voice : m_voices)
+    {
+        m_context->disconnect(m_output, voice.panner);
+        m_context->disconnect(voice.panner, voice.gain);
+        m_context->disconnect(voice.gain, voice.source);
+    }
+}
+
+VoicePool::Voice * VoicePool::acquire()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_freeList.empty())
+        return nullptr;
+
+    size_t index = m_freeList.back();
+    m_freeList.pop_back();
+    m_busy[index] = true;
+
+    Voice & voice = m_voices[index];
+
+    // Open the gate at unity; callers scale from there.
+    voice.gain->gain()->setValue(1.f);
+
+    return &voice;
+}
+
+void VoicePool::release(Voice * voice)
+{
+    if (!voice)
+        return;
+
+    size_t index = static_cast<size_t>(voice - m_voices.data());
+    ASSERT(index < m_voices.size());
+    if (index >= m_voices.size())
+        return;
+
+    // Close the gate before resetting so a not-quite-finished source can't
+    // leak a click into the mix.
+    voice->gain->gain()->setValue(0.f);
+
+    {
+        ContextRenderLock r(m_context.get(), "VoicePool::release");
+        voice->source->reset(r);
+        voice->gain->reset(r);
+        voice->panner->reset(r);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_busy[index])
+    {
+        m_busy[index] = false;
+        m_freeList.push_back(index);
+    }
+}
+
+void VoicePool::recycleFinishedVoices()
+{
+    for (size_t i = 0; i < m_voices.size(); ++i)
+    {
+        bool busy;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            busy = m_busy[i];
+        }
+
+        if (busy && m_voices[i].source->hasFinished())
+            release(&m_voices[i]);
+    }
+}
+
+size_t VoicePool::availableVoices() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_freeList.size();
+}
+
+}  // namespace lab
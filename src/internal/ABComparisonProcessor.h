@@ -0,0 +1,80 @@
+// License: BSD 3 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef ABComparisonProcessor_h
+#define ABComparisonProcessor_h
+
+#include "LabSound/core/AudioProcessor.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace lab {
+
+// ABComparisonProcessor wraps a reference and a candidate implementation of
+// the same AudioProcessor and runs both on every quantum's input, so an
+// optimized kernel (a vectorized biquad, a fast-math approximation) can be
+// validated against the implementation it replaces inside a real graph
+// instead of a hand-built one. The candidate's output is what flows
+// downstream; the reference renders into a scratch bus and the two results
+// are compared sample by sample in ulps. Per-quantum timing of each side is
+// accumulated alongside, so the same run answers both "is it right" and
+// "is it faster". Works offline as well as live; offline is the usual home
+// since a render there can sweep far more material than realtime allows.
+//
+// Both processors see identical input every quantum, so stateful kernels
+// stay in step as long as they are deterministic; reset() resets both.
+class ABComparisonProcessor : public AudioProcessor
+{
+public:
+    ABComparisonProcessor(std::unique_ptr<AudioProcessor> reference,
+                          std::unique_ptr<AudioProcessor> candidate,
+                          unsigned numberOfChannels);
+    virtual ~ABComparisonProcessor();
+
+    virtual void initialize() override;
+    virtual void uninitialize() override;
+
+    virtual void process(ContextRenderLock &, const AudioBus * source, AudioBus * destination, size_t framesToProcess) override;
+
+    virtual void reset() override;
+
+    virtual double tailTime(ContextRenderLock & r) const override;
+    virtual double latencyTime(ContextRenderLock & r) const override;
+
+    virtual size_t memoryBytes() const override;
+
+    // Accumulated comparison results. Written only by the rendering thread;
+    // a snapshot taken mid-quantum can straddle one update, which for
+    // validation telemetry is harmless.
+    struct ComparisonStats
+    {
+        uint64_t quanta = 0;                 // quanta compared
+        uint32_t maxUlp = 0;                 // worst sample difference observed, in ulps
+        uint32_t lastMaxUlp = 0;             // worst difference in the most recent quantum
+        uint64_t referenceMicroseconds = 0;  // total time in the reference processor
+        uint64_t candidateMicroseconds = 0;  // total time in the candidate processor
+    };
+
+    ComparisonStats stats() const;
+    void resetStats();
+
+private:
+    std::unique_ptr<AudioProcessor> m_reference;
+    std::unique_ptr<AudioProcessor> m_candidate;
+
+    // Landing bus for the reference output, sized lazily to the widest
+    // destination seen so the render path allocates at most once per width.
+    std::unique_ptr<AudioBus> m_referenceBus;
+
+    std::atomic<uint64_t> m_statQuanta{0};
+    std::atomic<uint32_t> m_statMaxUlp{0};
+    std::atomic<uint32_t> m_statLastMaxUlp{0};
+    std::atomic<uint64_t> m_statReferenceMicroseconds{0};
+    std::atomic<uint64_t> m_statCandidateMicroseconds{0};
+};
+
+} // namespace lab
+
+#endif // ABComparisonProcessor_h
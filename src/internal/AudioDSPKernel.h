@@ -7,6 +7,8 @@
 
 #include "LabSound/extended/AudioContextLock.h"
 
+#include <cstddef>
+
 namespace lab {
 
     class AudioDSPKernelProcessor;
@@ -22,6 +24,14 @@ public:
 
     virtual ~AudioDSPKernel() {}
 
+    // Kernel state comes from per-size slabs (KernelStatePool) rather than
+    // individual heap blocks: kernels of one type created together land
+    // back to back and cache-line aligned, so a render pass over many
+    // voices streams through their state instead of pointer-chasing cold
+    // lines. Inherited by every kernel subclass.
+    static void * operator new(size_t bytes);
+    static void operator delete(void * p, size_t bytes);
+
     // Subclasses must override process() to do the processing and reset() to reset DSP state.
     virtual void process(ContextRenderLock&, const float* source, float* destination, size_t framesToProcess) = 0;
     virtual void reset() = 0;
@@ -32,6 +42,10 @@ public:
     virtual double tailTime(ContextRenderLock & r) const = 0;
     virtual double latencyTime(ContextRenderLock & r) const = 0;
 
+    // Bytes of DSP state this kernel owns (a delay line, for example); most
+    // kernels hold only scalar state.
+    virtual size_t memoryBytes() const { return 0; }
+
 protected:
 
     AudioDSPKernelProcessor* m_kernelProcessor;
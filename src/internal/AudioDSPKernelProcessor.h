@@ -41,9 +41,37 @@ public:
     virtual double tailTime(ContextRenderLock & r) const override;
     virtual double latencyTime(ContextRenderLock & r) const override;
 
+    virtual size_t memoryBytes() const override
+    {
+        size_t bytes = 0;
+        for (auto & kernel : m_kernels)
+            bytes += kernel->memoryBytes();
+        return bytes;
+    }
+
+    // Process-wide debug counters for verifying the silent-quantum shortcut:
+    // quanta where the source bus was silent and the kernels were skipped
+    // outright, and quanta where silence still had to be run through the
+    // kernels to flush a live tail. Relaxed atomics; read from any thread.
+    static uint64_t silentQuantaSkipped();
+    static uint64_t silentQuantaProcessed();
+    static void resetSilenceStatistics();
+
 protected:
+    // Call at the top of process() (and any subclass override). Returns true
+    // if the quantum was fully handled as silence - the destination has been
+    // zeroed and the kernels must not run. While the kernel tail is still
+    // ringing, silence is fed through normally so filters and delay lines
+    // drain; once the tail is flushed, silent input costs a zero() and
+    // nothing else.
+    bool handleSilentQuantum(ContextRenderLock & r, const AudioBus * source, AudioBus * destination, size_t framesToProcess);
+
     std::vector<std::unique_ptr<AudioDSPKernel> > m_kernels;
     bool m_hasJustReset;
+
+    // Frames of silence still to feed through the kernels before their tail
+    // is fully flushed; re-armed from tailTime() whenever input is audible.
+    size_t m_silentFlushFramesRemaining = 0;
 };
 
 } // namespace lab
@@ -5,6 +5,8 @@
 #ifndef AudioDestination_h
 #define AudioDestination_h
 
+#include <cstddef>
+
 namespace lab {
 
 struct AudioIOCallback;
@@ -25,6 +27,43 @@ struct AudioDestination
     // Sample-rate conversion may happen in AudioDestination to the hardware sample-rate
     virtual float sampleRate() const = 0;
 
+    // The rate the open hardware stream actually runs at, which can differ
+    // from sampleRate() (the graph's rate): backends that support it bridge
+    // the difference with a resampling stage at the device boundary rather
+    // than forcing the context to rebuild its rate-dependent state.
+    virtual float deviceSampleRate() const { return sampleRate(); }
+
+    // The default output device changed, or the OS changed its rate: reopen
+    // the stream against whatever the default device now is, rebuilding the
+    // resampling bridge around the new rate if needed. The graph keeps its
+    // original sample rate throughout. Call from an application thread, not
+    // the device callback; the base is a no-op.
+    virtual void handleDeviceChange() { }
+
+    // The device's stream clock: seconds of audio the stream has consumed
+    // since start(), as reported by the driver at the last callback. Advances
+    // with the hardware rather than the render graph, so it does not quantize
+    // to render-quantum steps. Returns 0 when the backend cannot report it.
+    virtual double streamTime() const { return 0; }
+
+    // Seconds between a sample rendered in the current callback and its
+    // audible presentation: the driver's buffering plus whatever hardware
+    // latency the platform API exposes. Returns 0 when unknown.
+    virtual double outputLatency() const { return 0; }
+
+    // Low-latency buffer negotiation. requestLowLatency() records a
+    // process-wide preference read when the platform destination is created
+    // (so call it before constructing the AudioContext): backends that
+    // support it open the device exclusively with the smallest period the
+    // driver will grant, stepping back toward shared mode with conservative
+    // buffering if the driver refuses. A preferredBufferFrames of zero means
+    // ask for the render quantum. callbackBufferSize() reports the period
+    // actually granted, in frames; zero when the backend cannot report one.
+    static void requestLowLatency(bool enable, unsigned int preferredBufferFrames = 0);
+    static bool lowLatencyRequested();
+    static unsigned int preferredBufferFrames();
+    virtual unsigned int callbackBufferSize() const { return 0; }
+
     // maxChannelCount() returns the total number of output channels of the audio hardware.
     // A value of 0 indicates that the number of channels cannot be configured and
     // that only stereo (2-channel) destinations can be created.
@@ -32,6 +71,12 @@ struct AudioDestination
     // be a value: 1 <= numberOfOutputChannels <= maxChannelCount(),
     // or if maxChannelCount() equals 0, then numberOfOutputChannels must be 2.
     static unsigned long maxChannelCount();
+
+    // The current nominal sample rate of the default output device, in Hz,
+    // or zero when the platform cannot report one. Passing it as the
+    // context's rate runs the device natively, with no hidden conversion on
+    // either side of the boundary.
+    static float hardwareSampleRate();
 };
 
 } // namespace lab
@@ -0,0 +1,91 @@
+// License: BSD 3 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef AudioDestinationMirror_h
+#define AudioDestinationMirror_h
+
+#include "LabSound/core/AudioArray.h"
+#include "LabSound/core/AudioIOCallback.h"
+#include "LabSound/core/AudioSourceProvider.h"
+
+#include "internal/AudioDestination.h"
+#include "internal/SincResampler.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lab {
+
+class AudioBus;
+
+// AudioDestinationMirror drives an additional hardware output from audio an
+// AudioDestinationNode has already rendered, so a second device (speakers
+// beside headphones, say) costs a resample and a copy rather than a second
+// context. The render thread deposits each quantum into a lock-free ring;
+// the mirror device's own callback drains it through a SincResampler whose
+// ratio is servoed from the ring's fill level, absorbing the drift between
+// the two devices' clocks. An underrun plays silence and re-arms the
+// prebuffer; an overrun drops the newest quantum. Neither side ever blocks.
+class AudioDestinationMirror : public AudioIOCallback
+{
+public:
+    // sourceSampleRate is the rate of the audio pushed in;
+    // deviceSampleRate is requested from the platform (the rate actually
+    // granted is what the servo trims around). Channels are capped at
+    // SincResampler::MaxInterleavedChannels.
+    AudioDestinationMirror(size_t numberOfChannels, float deviceSampleRate, float sourceSampleRate);
+    virtual ~AudioDestinationMirror();
+
+    void start();
+    void stop();
+
+    // Called on the source's render thread with the quantum just rendered.
+    // Device channels beyond the source's receive silence.
+    void pushRenderedQuantum(const AudioBus * bus, size_t framesToProcess);
+
+    // AudioIOCallback; runs on the mirror device's callback thread.
+    virtual void render(AudioBus * sourceBus, AudioBus * destinationBus, size_t framesToProcess) override;
+
+    uint64_t underruns() const { return m_underruns.load(std::memory_order_relaxed); }
+    uint64_t overruns() const { return m_overruns.load(std::memory_order_relaxed); }
+
+private:
+    // Feeds ring frames to the resampler; a shortfall is zero-filled,
+    // counted, and re-arms the prebuffer gate.
+    struct RingReader : public AudioSourceProvider
+    {
+        AudioDestinationMirror * mirror = nullptr;
+        virtual void provideInput(AudioBus * bus, size_t framesToProcess) override;
+    };
+
+    void readFromRing(AudioBus * bus, size_t framesToProcess);
+
+    size_t m_channels;
+    double m_nominalScale = 1.0; // source rate / device rate
+    size_t m_ringFrames = 0;     // power of two
+    size_t m_targetFill = 0;     // prebuffer and servo midpoint, in source frames
+
+    // Planar ring; the write index belongs to the render thread, the read
+    // index to the device thread.
+    std::vector<AudioFloatArray> m_ring;
+    std::atomic<uint64_t> m_readIndex{0};
+    std::atomic<uint64_t> m_writeIndex{0};
+    bool m_primed = false; // device thread only
+
+    RingReader m_reader;
+    std::unique_ptr<SincResampler> m_resampler;
+    std::unique_ptr<AudioDestination> m_device;
+
+    // Interleaved landing buffer for the resampler's output, deinterleaved
+    // into the device bus per pass.
+    std::vector<float> m_interleaved;
+
+    std::atomic<uint64_t> m_underruns{0};
+    std::atomic<uint64_t> m_overruns{0};
+};
+
+} // namespace lab
+
+#endif // AudioDestinationMirror_h
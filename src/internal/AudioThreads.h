@@ -0,0 +1,25 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef AudioThreads_h
+#define AudioThreads_h
+
+#include "LabSound/core/AudioContext.h"
+
+namespace lab {
+
+// Applies the process-wide policy for the given role to the calling thread
+// and names it for debuggers and profilers. Each engine thread calls this as
+// it starts; the device callback applies it on its first buffer, since that
+// thread is owned by the platform audio layer. Failures (insufficient
+// privileges for the realtime class, an affinity mask with no usable
+// processors) are ignored; the thread runs with whatever was granted.
+void ApplyThreadPolicy(AudioContext::ThreadRole role, const char * name);
+
+// Backing store for AudioContext::setThreadPolicy / threadPolicy.
+void SetThreadPolicy(AudioContext::ThreadRole role, const AudioContext::ThreadPolicy & policy);
+AudioContext::ThreadPolicy GetThreadPolicy(AudioContext::ThreadRole role);
+
+}  // namespace lab
+
+#endif  // AudioThreads_h
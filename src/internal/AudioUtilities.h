@@ -22,6 +22,12 @@ double discreteTimeConstantForSampleRate(double timeConstant, double sampleRate)
 
 // Convert the time to a sample frame at the given sample rate.
 size_t timeToSampleFrame(double time, double sampleRate);
+
+// Polynomial approximation of acos (Abramowitz & Stegun 4.4.45), maximum
+// error 6.8e-5 radians (about 0.004 degrees) over [-1, 1]. Spatialization
+// uses it in place of libm when fast spatial math is requested; the error
+// is orders of magnitude below the smallest audible panning change.
+float fastAcos(float x);
 } // AudioUtilites
 
 } // lab
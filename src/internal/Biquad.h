@@ -27,6 +27,13 @@ public:
 
     void process(const float* sourceP, float* destP, size_t framesToProcess);
 
+    // Processes several independent channels in parallel SIMD lanes (the recurrence is
+    // serial in time but embarrassingly parallel across channels). Each filter keeps its
+    // own coefficients and state; filters, sources and dests must all have
+    // numberOfChannels entries. Falls back to per-channel processing where no suitable
+    // SIMD is available. Output is bit-identical to calling process() per channel.
+    static void processChannels(Biquad* const* filters, const float* const* sources, float* const* dests, size_t numberOfChannels, size_t framesToProcess);
+
     // frequency is 0 - 1 normalized, resonance and dbGain are in decibels.
     // Q is a unitless quality factor.
     void setLowpassParams(double frequency, double resonance);
@@ -42,6 +49,11 @@ public:
     // and a single pole (other pole will be conjugate)
     void setZeroPolePairs(const std::complex<double>& zero, const std::complex<double>& pole);
 
+    // First-order section with one real zero and one real pole, gain
+    // compensated to 0dB at DC. b2 and a2 are zero, so it runs through the
+    // engine as a trivial section; ZeroPole cascades are built from these.
+    void setZeroPoleParams(double zero, double pole);
+
     // Set the biquad coefficients given a single pole (other pole will be conjugate)
     // (The zeroes will be the inverse of the poles)
     void setAllpassPole(const std::complex<double>& pole);
@@ -56,9 +68,28 @@ public:
                               const float* frequency,
                               float* magResponse,
                               float* phaseResponse);
-private:
+
+    // Set the coefficients directly (normalized so a0 becomes 1) for filters
+    // whose response is not one of the canned designs above, e.g. stages
+    // taken from a published specification.
     void setNormalizedCoefficients(double b0, double b1, double b2, double a0, double a1, double a2);
-    
+
+    // When enabled, subsequent coefficient changes - from the canned designs above
+    // or from setNormalizedCoefficients() - are applied as a linear per-sample ramp
+    // spanning the next process() or processChannels() call instead of stepping at
+    // the quantum boundary. The design (with its trig) runs once at control rate;
+    // the per-sample cost of the ramp is five additions, and the coefficients land
+    // exactly on the designed values at the end of the quantum. (The vDSP path on
+    // OSX runs fixed coefficients per quantum, so changes step there as before.)
+    void setCoefficientRampEnabled(bool enabled) { m_rampEnabled = enabled; }
+
+    // Adopt another filter's coefficients - including any pending ramp target -
+    // without touching this filter's state memory. Used when several channels
+    // share one design so that only the first channel pays for the trig.
+    void copyCoefficientsFrom(const Biquad& other);
+
+private:
+
     // Filter coefficients. The filter is defined as
     //
     // y[n] + m_a1*y[n-1] + m_a2*y[n-2] = m_b0*x[n] + m_b1*x[n-1] + m_b2*x[n-2].
@@ -68,6 +99,17 @@ private:
     double m_a1;
     double m_a2;
 
+    // Target coefficients for an armed ramp; see setCoefficientRampEnabled().
+    // While m_rampPending is set, m_b0..m_a2 still hold the coefficients the
+    // last processed sample was filtered with.
+    double m_tb0;
+    double m_tb1;
+    double m_tb2;
+    double m_ta1;
+    double m_ta2;
+    bool m_rampEnabled;
+    bool m_rampPending;
+
 #if defined(LABSOUND_PLATFORM_OSX)
     void processFast(const float* sourceP, float* destP, size_t framesToProcess);
     void processSliceFast(double* sourceP, double* destP, double* coefficientsP, size_t framesToProcess);
@@ -38,6 +38,11 @@ public:
     virtual double tailTime(ContextRenderLock & r) const override;
     virtual double latencyTime(ContextRenderLock & r) const override;
 
+    // Used by BiquadProcessor to refresh coefficients before running all
+    // channels together through Biquad::processChannels.
+    void updateCoefficients(ContextRenderLock& r) { updateCoefficientsIfNecessary(r, true, false); }
+    Biquad& biquad() { return m_biquad; }
+
 protected:
     Biquad m_biquad;
     BiquadProcessor* biquadProcessor() { return static_cast<BiquadProcessor*>(processor()); }
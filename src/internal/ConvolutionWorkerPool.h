@@ -0,0 +1,107 @@
+// License: BSD 3 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef ConvolutionWorkerPool_h
+#define ConvolutionWorkerPool_h
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lab {
+
+class AudioChannel;
+class ContextRenderLock;
+class ReverbConvolver;
+
+// One per-channel convolution of a single render quantum, for runParallel().
+// A plain aggregate so forking never allocates on the render thread.
+struct ConvolutionJob
+{
+    ReverbConvolver * convolver;
+    const AudioChannel * source;
+    AudioChannel * destination;
+    ContextRenderLock * r;
+    size_t framesToProcess;
+};
+
+// ConvolutionWorkerPool services the background (long-tail) stages of every
+// ReverbConvolver from one bounded set of worker threads, instead of each
+// convolver spawning its own thread. Thirty ConvolverNodes therefore share a
+// handful of workers sized to the machine rather than oversubscribing the
+// scheduler with thirty threads.
+//
+// Only one worker services a given convolver at a time (the stages of one
+// convolver accumulate into a shared buffer and are not thread safe against
+// each other), but distinct convolvers are drained concurrently, so total
+// convolution throughput scales with cores.
+class ConvolutionWorkerPool
+{
+public:
+    static ConvolutionWorkerPool& shared();
+
+    void addClient(ReverbConvolver* convolver);
+
+    // Blocks until no worker is servicing the convolver, then forgets it.
+    void removeClient(ReverbConvolver* convolver);
+
+    // Called from the real-time thread after writing input; must never block.
+    void signalMoreInput();
+
+    // Runs count independent convolutions concurrently on the pool's workers
+    // and returns once all of them have finished. The calling thread takes a
+    // share of the work itself, so a busy or small pool degrades to inline
+    // execution rather than deadlock. The jobs must target distinct
+    // convolvers. Used by Reverb to fork one quantum's per-channel
+    // convolutions and join before matrixing the output.
+    void runParallel(const ConvolutionJob * jobs, size_t count);
+
+    // Runs a one-shot task on a pool worker; used for off-thread preparation
+    // work such as impulse-response resampling and partitioning. Tasks run
+    // after any forked quantum work, so a long prepare cannot stall a render
+    // thread joining in runParallel().
+    void enqueueTask(std::function<void()> task);
+
+private:
+    ConvolutionWorkerPool();
+    ~ConvolutionWorkerPool();
+
+    void workerLoop();
+    void runPendingJobs();
+
+    struct Client
+    {
+        explicit Client(ReverbConvolver* c) : convolver(c) {}
+        ReverbConvolver* convolver;
+        std::atomic<bool> busy{false};
+    };
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+
+    std::vector<std::unique_ptr<Client>> m_clients;
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_tasks;
+
+    std::atomic<uint64_t> m_inputEpoch{0};
+    bool m_shouldExit = false;
+
+    // Fork/join state for runParallel. One batch at a time; m_forkMutex
+    // serializes callers, m_mutex guards publication to the workers.
+    std::mutex m_forkMutex;
+    std::condition_variable m_jobsDone;
+    const ConvolutionJob * m_jobs = nullptr;
+    std::atomic<size_t> m_jobCount{0};
+    std::atomic<size_t> m_jobCursor{0};
+    std::atomic<size_t> m_jobsRemaining{0};
+};
+
+} // namespace lab
+
+#endif // ConvolutionWorkerPool_h
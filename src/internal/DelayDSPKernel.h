@@ -30,6 +30,11 @@ public:
     virtual double tailTime(ContextRenderLock & r) const override;
     virtual double latencyTime(ContextRenderLock & r) const override;
 
+    virtual size_t memoryBytes() const override
+    {
+        return (m_buffer.size() + m_delayTimes.size()) * sizeof(float);
+    }
+
 private:
     AudioFloatArray m_buffer;
     double m_maxDelayTime;
@@ -39,6 +44,15 @@ private:
     bool m_firstTime;
     double m_desiredDelayFrames;
 
+    // Crossfade-on-change state (see DelayProcessor::setCrossfadeOnDelayChange):
+    // while a fade runs, the outgoing head stays at m_crossfadeFromDelay and
+    // the incoming head at m_currentDelayTime, blended equal-power over the
+    // fade window. Both heads read the one existing ring.
+    bool m_crossfading{ false };
+    double m_crossfadeFromDelay{ 0 };
+    double m_crossfadePosition{ 0 };
+    double m_crossfadeStep{ 0 };
+
     AudioFloatArray m_delayTimes;
 
     DelayProcessor * delayProcessor() { return static_cast<DelayProcessor*>(processor()); }
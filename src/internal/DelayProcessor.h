@@ -29,6 +29,16 @@ public:
     std::shared_ptr<AudioParam> delayTime() const { return m_delayTime; }
 
     double maxDelayTime() { return m_maxDelayTime; }
+
+    // When set, delay-time changes crossfade between two read heads inside
+    // the existing ring instead of gliding the read position (which pitch
+    // shifts while it settles). Tempo-synced delays opt in; the default
+    // keeps WebAudio's smoothing semantics.
+    void setCrossfadeOnDelayChange(bool v) { m_crossfadeOnDelayChange = v; }
+    bool crossfadeOnDelayChange() const { return m_crossfadeOnDelayChange; }
+
+private:
+    bool m_crossfadeOnDelayChange{ false };
 };
 
 } // namespace lab
@@ -16,6 +16,12 @@
 #endif
 #include <float.h>
 
+#ifndef NDEBUG
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#endif
+
 #if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
 #define HAVE_DENORMAL
 #endif
@@ -99,6 +105,30 @@ public:
 
 #endif
 
+#ifndef NDEBUG
+// Debug-build audit of denormal production. Flushing at the thread level hides
+// which kernel generated subnormals in the first place; these hooks let the
+// graph count denormal-range samples in node outputs so the offender can be
+// found and fixed at source. Compiled out entirely in release builds.
+inline std::atomic<uint64_t> & denormalAuditCount()
+{
+    static std::atomic<uint64_t> s_count{0};
+    return s_count;
+}
+
+inline size_t countDenormalsInBlock(const float * source, size_t framesToProcess)
+{
+    size_t found = 0;
+    for (size_t i = 0; i < framesToProcess; ++i)
+    {
+        float f = source[i];
+        if (f != 0.f && fabsf(f) < FLT_MIN)
+            ++found;
+    }
+    return found;
+}
+#endif
+
 } // lab
 
 #undef HAVE_DENORMAL
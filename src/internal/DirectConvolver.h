@@ -19,6 +19,8 @@ public:
 
     void process(AudioFloatArray* convolutionKernel, const float* sourceP, float* destP, size_t framesToProcess);
 
+    size_t memoryBytes() const { return m_buffer.size() * sizeof(float); }
+
     void reset();
 
 private:
@@ -68,7 +68,11 @@ protected:
     unsigned m_lastPreDelayFrames;
     void setPreDelayTime(float time, float sampleRate);
 
-    std::vector< std::unique_ptr<AudioFloatArray> > m_preDelayBuffers;
+    // All channels share one contiguous allocation, MaxPreDelayFrames apart,
+    // rather than one heap block per channel.
+    unsigned m_numberOfChannels;
+    AudioFloatArray m_preDelayBuffer;
+    float * preDelayChannel(unsigned i) { return m_preDelayBuffer.data() + i * MaxPreDelayFrames; }
 
     int m_preDelayReadIndex;
     int m_preDelayWriteIndex;
@@ -103,6 +107,22 @@ protected:
 
     // Internal parameter for the knee portion of the curve.
     float m_K;
+
+    // Interpolated lookup tables for the detector's per-sample math: the
+    // static gain curve as attenuation over input level, and the saturation
+    // release rate over attenuation. Regenerated by process() only when
+    // threshold/knee/ratio or the sample rate change.
+    enum { StaticCurveTableSize = 2048 };
+    enum { SatReleaseTableSize = 1024 };
+    void updateStaticCurveTables(float k, float satReleaseFrames);
+    float lookupAttenuation(float absInput, float k);
+    float lookupSatReleaseRate(float attenuation) const;
+
+    AudioFloatArray m_attenuationTable;
+    AudioFloatArray m_satReleaseRateTable;
+    float m_tableMaxInput;
+    float m_tableSatReleaseFrames;
+    bool m_staticCurveTablesDirty;
 };
 
 } // namespace lab
@@ -0,0 +1,48 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef EqualPowerTable_h
+#define EqualPowerTable_h
+
+namespace lab {
+
+// Shared equal-power panning gain table. Stores sin(x * pi/2) for x in
+// [0, 1] over kEqualPowerTableSize intervals; the cosine gain comes from the
+// mirrored index, so one table serves both channels. Linear interpolation
+// keeps the worst-case error below 3e-7, far under audibility, while a
+// lookup replaces a sin/cos pair per sample in pan automation and per
+// quantum per source in EqualPowerPanner. The table is generated at compile
+// time (constexpr) into the read-only data segment, so there is no
+// initialization at startup or first use and the pages are shared across
+// processes.
+const int kEqualPowerTableSize = 1024;
+
+// Returns the table, kEqualPowerTableSize + 1 entries.
+const float * equalPowerSinTable();
+
+// position 0 is hard left (gainL 1, gainR 0), 1 is hard right.
+inline void equalPowerGains(float position, float & gainL, float & gainR)
+{
+    if (position < 0.f)
+        position = 0.f;
+    else if (position > 1.f)
+        position = 1.f;
+
+    const float * table = equalPowerSinTable();
+
+    float x = position * kEqualPowerTableSize;
+    int i = static_cast<int>(x);
+    if (i >= kEqualPowerTableSize)
+        i = kEqualPowerTableSize - 1;
+    gainR = table[i] + (x - i) * (table[i + 1] - table[i]);
+
+    float y = (1.f - position) * kEqualPowerTableSize;
+    int k = static_cast<int>(y);
+    if (k >= kEqualPowerTableSize)
+        k = kEqualPowerTableSize - 1;
+    gainL = table[k] + (y - k) * (table[k + 1] - table[k]);
+}
+
+} // namespace lab
+
+#endif // EqualPowerTable_h
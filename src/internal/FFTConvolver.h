@@ -27,10 +27,21 @@ public:
 
     void reset();
 
-    size_t fftSize() const { return m_frame.fftSize(); }
+    size_t fftSize() const { return m_fftSize; }
+
+    // persistent buffers only; the transform scratch is borrowed from the
+    // per-thread arena and counted there
+    size_t memoryBytes() const { return (m_inputBuffer.size() + m_outputBuffer.size() + m_lastOverlapBuffer.size()) * sizeof(float); }
 
 private:
-    FFTFrame m_frame;
+    size_t m_fftSize;
+
+    // An instance holds only what must persist between process() calls:
+    // half an FFT of buffered input, half an FFT of pending output, and the
+    // overlap tail. The FFTFrame and the full-size transform buffer are pure
+    // scratch during process() and are borrowed from a per-thread arena
+    // shared by every convolver of the same FFT size, so hundreds of
+    // instances (HRTF panners, reverb stages) don't each carry their own.
 
     // Buffer input until we get fftSize / 2 samples then do an FFT
     size_t m_readWriteIndex;
@@ -27,9 +27,15 @@
 #include <kissfft/kiss_fftr.hpp>
 #endif // USE(WEBAUDIO_KISSFFT)
 
-namespace lab 
+namespace lab
 {
 
+#if defined(WEBAUDIO_OOURA)
+// Bit-reversal and trig tables for one FFT size, shared between all frames of
+// that size. Defined in FFTFrameOoura.cpp.
+struct OouraFFTTables;
+#endif
+
 // Defines the interface for an "FFT frame", an object which is able to perform a forward
 // and reverse FFT, internally storing the resultant frequency-domain data.
 class FFTFrame 
@@ -90,16 +96,23 @@ private:
     AudioFloatArray m_realData;
     AudioFloatArray m_imagData;
 #else // !USE_ACCELERATE_FFT
-    
-#if defined(WEBAUDIO_KISSFFT)
-    kiss_fftr_cfg mFFT;
-    kiss_fftr_cfg mIFFT;
-
-    kiss_fft_cpx* m_cpxInputData;
-    kiss_fft_cpx* m_cpxOutputData;
 
-    std::vector<kiss_fft_cpx> mOutputBuffer; 
+#if defined(WEBAUDIO_OOURA)
+    // Work buffer in ooura's interleaved layout; the tables are per size and
+    // shared between every frame of that size, so creating a frame never
+    // rebuilds twiddle tables. The nyquist component is packed into imag[0],
+    // matching the Accelerate backend's convention.
+    std::shared_ptr<OouraFFTTables> m_tables;
+    AudioFloatArray m_buffer;
+    AudioFloatArray m_realData;
+    AudioFloatArray m_imagData;
+#endif
 
+#if defined(WEBAUDIO_KISSFFT)
+    // Forward/inverse kiss_fftr configs and the interleaved staging buffers
+    // are not stored per frame; both come from a per-thread cache keyed by
+    // size, so every frame of the same partition size shares one set of
+    // twiddle tables and one scratch pair. See FFTFrameKissFFT.cpp.
     AudioFloatArray m_realData;
     AudioFloatArray m_imagData;
 #endif
@@ -0,0 +1,189 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef FastMath_h
+#define FastMath_h
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#if defined(ARM_NEON_INTRINSICS)
+#include <arm_neon.h>
+#endif
+
+// Polynomial approximations of the transcendentals that show up inside
+// per-sample DSP loops, where a libm call per sample dominates the kernel.
+// Accuracy is stated per function; all of them are branch-light and inline.
+// They are not substitutes for libm where accumulated error matters - an
+// exponential-ramp multiplier applied thousands of times compounds any
+// relative error, so AudioParamTimeline deliberately stays on powf.
+
+namespace lab {
+
+namespace FastMath {
+
+// 2^x for x in roughly [-126, 127]. The fractional part goes through a
+// degree-7 polynomial (relative error below 2e-6); the integer part is
+// applied directly to the exponent field.
+inline float fast_exp2f(float x)
+{
+    if (x < -126.f)
+        x = -126.f;
+    if (x > 127.f)
+        x = 127.f;
+
+    int i = int(x);
+    if (x < float(i))
+        --i;
+    float f = x - float(i);
+
+    float p = 1.f + f * (0.69314718f + f * (0.24022651f + f * (0.05550411f + f * (0.00961813f + f * (0.00133336f + f * (0.00015404f + f * 0.00001525f))))));
+
+    uint32_t scaleBits = uint32_t(i + 127) << 23;
+    float scale;
+    memcpy(&scale, &scaleBits, sizeof(scale));
+    return p * scale;
+}
+
+inline float fast_expf(float x)
+{
+    return fast_exp2f(x * 1.44269504f); // 1 / ln(2)
+}
+
+// log2(x) for finite x > 0. Exponent extraction plus a degree-4 polynomial
+// on the mantissa; absolute error below 2e-4, which maps to under 0.002 dB
+// when used for level conversion.
+inline float fast_log2f(float x)
+{
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+
+    float exponent = float(int((bits >> 23) & 0xFF) - 127);
+    bits = (bits & 0x007FFFFFu) | 0x3F800000u;
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+
+    // The polynomial approximates ln(m) on [1, 2); scale to base 2.
+    float p = -1.7417939f + (2.8212026f + (-1.4699568f + (0.44717955f - 0.056570851f * m) * m) * m) * m;
+    return exponent + p * 1.44269504f;
+}
+
+inline float fast_logf(float x)
+{
+    return fast_log2f(x) * 0.69314718f; // ln(2)
+}
+
+inline float fast_log10f(float x)
+{
+    return fast_log2f(x) * 0.30103001f; // log10(2)
+}
+
+// x^y for x > 0, via exp2(y * log2(x)). Inherits the log2 error scaled by
+// y, so keep y moderate.
+inline float fast_powf(float x, float y)
+{
+    return fast_exp2f(y * fast_log2f(x));
+}
+
+// sin(x) for x in [-pi, pi]. Folds into [-pi/2, pi/2] and evaluates a
+// degree-7 odd polynomial; absolute error below 1e-6.
+inline float fast_sinf(float x)
+{
+    const float halfPi = 1.57079633f;
+    const float pi = 3.14159265f;
+
+    if (x > halfPi)
+        x = pi - x;
+    else if (x < -halfPi)
+        x = -pi - x;
+
+    float x2 = x * x;
+    return x * (0.99999661f + x2 * (-0.16664824f + x2 * (0.00830629f - x2 * 0.00018363f)));
+}
+
+// Array form of fast_exp2f: destP[i] = 2^sourceP[i], four lanes at a time
+// where SIMD is available. Sample-accurate detune (cents to frequency
+// scale) is the main client.
+inline void fast_exp2(const float * sourceP, float * destP, size_t framesToProcess)
+{
+    size_t n = framesToProcess;
+
+#ifdef __SSE2__
+    while (n >= 4)
+    {
+        __m128 x = _mm_loadu_ps(sourceP);
+        x = _mm_max_ps(x, _mm_set1_ps(-126.f));
+        x = _mm_min_ps(x, _mm_set1_ps(127.f));
+
+        // floor(x): truncate, then subtract one where truncation rounded up
+        __m128i i = _mm_cvttps_epi32(x);
+        __m128 fi = _mm_cvtepi32_ps(i);
+        __m128 needsAdjust = _mm_cmplt_ps(x, fi);
+        i = _mm_add_epi32(i, _mm_castps_si128(needsAdjust)); // mask is -1 where set
+        fi = _mm_cvtepi32_ps(i);
+        __m128 f = _mm_sub_ps(x, fi);
+
+        __m128 p = _mm_set1_ps(0.00001525f);
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.00015404f));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.00133336f));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.00961813f));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.05550411f));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.24022651f));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.69314718f));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.f));
+
+        __m128i scaleBits = _mm_slli_epi32(_mm_add_epi32(i, _mm_set1_epi32(127)), 23);
+        __m128 scale = _mm_castsi128_ps(scaleBits);
+
+        _mm_storeu_ps(destP, _mm_mul_ps(p, scale));
+        sourceP += 4;
+        destP += 4;
+        n -= 4;
+    }
+#elif defined(ARM_NEON_INTRINSICS)
+    while (n >= 4)
+    {
+        float32x4_t x = vld1q_f32(sourceP);
+        x = vmaxq_f32(x, vdupq_n_f32(-126.f));
+        x = vminq_f32(x, vdupq_n_f32(127.f));
+
+        int32x4_t i = vcvtq_s32_f32(x);
+        float32x4_t fi = vcvtq_f32_s32(i);
+        uint32x4_t needsAdjust = vcltq_f32(x, fi);
+        i = vaddq_s32(i, vreinterpretq_s32_u32(needsAdjust));
+        fi = vcvtq_f32_s32(i);
+        float32x4_t f = vsubq_f32(x, fi);
+
+        float32x4_t p = vdupq_n_f32(0.00001525f);
+        p = vmlaq_f32(vdupq_n_f32(0.00015404f), p, f);
+        p = vmlaq_f32(vdupq_n_f32(0.00133336f), p, f);
+        p = vmlaq_f32(vdupq_n_f32(0.00961813f), p, f);
+        p = vmlaq_f32(vdupq_n_f32(0.05550411f), p, f);
+        p = vmlaq_f32(vdupq_n_f32(0.24022651f), p, f);
+        p = vmlaq_f32(vdupq_n_f32(0.69314718f), p, f);
+        p = vmlaq_f32(vdupq_n_f32(1.f), p, f);
+
+        int32x4_t scaleBits = vshlq_n_s32(vaddq_s32(i, vdupq_n_s32(127)), 23);
+        float32x4_t scale = vreinterpretq_f32_s32(scaleBits);
+
+        vst1q_f32(destP, vmulq_f32(p, scale));
+        sourceP += 4;
+        destP += 4;
+        n -= 4;
+    }
+#endif
+
+    while (n--)
+        *destP++ = fast_exp2f(*sourceP++);
+}
+
+} // namespace FastMath
+
+} // namespace lab
+
+#endif // FastMath_h
@@ -0,0 +1,98 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef GraphRenderScheduler_h
+#define GraphRenderScheduler_h
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lab
+{
+
+class AudioNode;
+class AudioNodeInput;
+class ContextRenderLock;
+
+// GraphRenderScheduler processes independent subgraphs feeding a summing junction
+// (typically the destination node's input) in parallel on a small worker pool.
+//
+// The graph is partitioned by walking upstream from each output connected to the
+// junction; branches that share any node are merged into a single partition so that
+// no node is ever processed on two threads in the same quantum. Each partition is
+// "pre-pulled" by calling processIfNecessary() on its root node, which caches the
+// results in the node output busses. The ordinary single threaded pull that follows
+// then finds every node already processed for the current quantum and simply sums.
+//
+// Partitions are recomputed only when the set of outputs connected to the junction
+// changes; steady-state rendering does no allocation here.
+//
+// Partitions are dispatched heaviest-first, costed from the nodes' profile
+// counters when the context has profiling enabled (node count otherwise), so a
+// convolver-laden branch is claimed at the start of the quantum rather than
+// becoming the straggler everything waits on. Costs are re-evaluated
+// periodically since they drift with parameter changes.
+class GraphRenderScheduler
+{
+public:
+    GraphRenderScheduler();
+    ~GraphRenderScheduler();
+
+    // Called from the render thread before the normal pull of the junction.
+    // No-op unless at least two independent partitions exist.
+    void preRender(ContextRenderLock & r, AudioNodeInput * junction, size_t framesToProcess);
+
+private:
+    struct Partition
+    {
+        // the nodes sourcing the junction that belong to this partition
+        std::vector<AudioNode *> roots;
+
+        // every node reachable within the partition, kept for costing
+        std::vector<AudioNode *> nodes;
+
+        // summed mean per-quantum cost of the partition's nodes, in
+        // microseconds; 1 per node when no profile data exists
+        uint64_t costMicroseconds = 0;
+    };
+
+    void rebuildPartitionsIfNecessary(ContextRenderLock & r, AudioNodeInput * junction);
+    void packScheduleByCost();
+    void startWorkers(size_t count);
+    void stopWorkers();
+    void workerLoop();
+    void runOneTask(int task, ContextRenderLock & r, size_t framesToProcess);
+
+    std::vector<Partition> m_partitions;
+
+    // raw output pointers seen at the junction when partitions were last built;
+    // compared each quantum to detect topology changes cheaply
+    std::vector<void *> m_lastConnections;
+
+    // the context's graph generation when partitions were last built; catches
+    // param connection changes, which never show up at the junction
+    uint64_t m_lastGraphGeneration = 0;
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_workMutex;
+    std::condition_variable m_workAvailable;
+    std::condition_variable m_workDone;
+
+    // per-quantum dispatch state
+    ContextRenderLock * m_renderLock = nullptr;
+    size_t m_framesToProcess = 0;
+    std::atomic<int> m_nextTask{0};
+    std::atomic<int> m_tasksRemaining{0};
+    bool m_shouldExit = false;
+
+    // quanta since costs were last re-evaluated
+    int m_quantaSinceCostSort = 0;
+};
+
+} // namespace lab
+
+#endif // GraphRenderScheduler_h
@@ -8,20 +8,30 @@
 #include "LabSound/extended/Util.h"
 #include "internal/HRTFElevation.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace lab {
- 
+
 class HRTFKernel;
-class HRTFDatabase 
+class HRTFDatabase
 {
-    
+
     NO_MOVE(HRTFDatabase);
-    
+
 public:
 
+    // Construction loads only a band of elevations around the horizon; the
+    // rest load on demand with a prefetch margin as sources move (see
+    // getKernelsFromAzimuthElevation), so a ground-based scene never decodes
+    // or holds the kernels for steep elevations it does not use.
     HRTFDatabase(float sampleRate, const std::string & searchPath);
 
+    ~HRTFDatabase();
+
     // getKernelsFromAzimuthElevation() returns a left and right ear kernel, and an interpolated left and right frame delay for the given azimuth and elevation.
     // azimuthBlend must be in the range 0 -> 1.
     // Valid values for azimuthIndex are 0 -> HRTFElevation::NumberOfTotalAzimuths - 1 (corresponding to angles of 0 -> 360).
@@ -31,12 +41,50 @@ public:
     // Returns the number of different azimuth angles.
     static unsigned numberOfAzimuths() { return HRTFElevation::NumberOfTotalAzimuths; }
 
+    // Bytes held by the processed kernel set.
+    size_t memoryBytes() const;
+
 private:
 
-    std::vector<std::unique_ptr<HRTFElevation> > m_elevations;
-    
+    // The fully processed kernel set (FFT-transformed, delays extracted) can be
+    // baked into a single binary file so later launches skip the per-file WAV
+    // decode and FFT entirely. Records are fixed size, so elevations load from
+    // a baked file individually; validateBaked() checks the header once and
+    // loadBakedElevation() reads one record. saveBaked() writes the file once
+    // every elevation has become resident.
+    bool validateBaked(const std::string & path);
+    bool loadBakedElevation(int elevationIndex);
+    bool saveBaked(const std::string & path) const;
+
+    // Loads elevations [firstIndex, lastIndex] that are not yet resident,
+    // publishing each finished slice to its slot. Caller holds m_loadMutex.
+    void ensureElevationRangeLocked(int firstIndex, int lastIndex);
+    void loadElevationLocked(int elevationIndex);
+
+    // Kicks a background load of the band around elevationIndex. Called from
+    // the render thread on a miss or when the band edge comes within the
+    // prefetch margin; never blocks (a flag limits it to one in-flight load).
+    void requestElevationAsync(int elevationIndex);
+
+    // Slots fill in over time; a loaded slice is published with an atomic
+    // store and never replaced or removed, so a kernel pointer handed to the
+    // panner stays valid for the database's lifetime.
+    std::vector<std::shared_ptr<HRTFElevation>> m_elevations;
+
     std::unique_ptr<HRTFDatabaseInfo> info;
-    
+
+    // Serializes loading; the render thread never takes this lock, it only
+    // atomic-loads slots and flips m_loadPending.
+    std::mutex m_loadMutex;
+    std::condition_variable m_loadCondition;
+    std::atomic<bool> m_loadPending{false};
+    std::atomic<int> m_loadsInFlight{0};
+    bool m_shutdown = false;
+
+    std::string m_bakedPath;
+    bool m_bakedValid = false;
+    uint32_t m_bakedFFTSize = 0;
+    bool m_bakedSaved = false;
 };
 
 } // namespace lab
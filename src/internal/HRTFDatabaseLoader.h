@@ -43,6 +43,9 @@ public:
     HRTFDatabase * database() { return m_hrtfDatabase.get(); }
 
     float databaseSampleRate() const { return m_databaseSampleRate; }
+
+    // Bytes held by the loaded database; zero while loading.
+    size_t memoryBytes() const;
     
     // Called in asynchronous loading thread.
     void load();
@@ -29,10 +29,15 @@ public:
     // Given two HRTFElevations, and an interpolation factor x: 0 -> 1, returns an interpolated HRTFElevation.
     static std::unique_ptr<HRTFElevation> createByInterpolatingSlices(HRTFDatabaseInfo * info, HRTFElevation * hrtfElevation1, HRTFElevation * hrtfElevation2, float x);
 
+    // Reconstructs an elevation from kernel lists deserialized from a baked database file.
+    static std::unique_ptr<HRTFElevation> createFromBakedKernels(HRTFDatabaseInfo * info, std::unique_ptr<HRTFKernelList> kernelListL, std::unique_ptr<HRTFKernelList> kernelListR, int elevation);
+
     // Returns the list of left or right ear HRTFKernels for all the azimuths going from 0 to 360 degrees.
     HRTFKernelList * kernelListL() { return m_kernelListL.get(); }
     HRTFKernelList * kernelListR() { return m_kernelListR.get(); }
 
+    size_t memoryBytes() const;
+
     double elevationAngle() const { return m_elevationAngle; }
     unsigned numberOfAzimuths() const { return NumberOfTotalAzimuths; }
     
@@ -6,32 +6,46 @@
 #define HRTFKernel_h
 
 #include "internal/FFTFrame.h"
+
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace lab {
 
 class AudioChannel;
-   
+
 // HRTF stands for Head-Related Transfer Function.
 // HRTFKernel is a frequency-domain representation of an impulse-response used as part of the spatialized panning system.
 // For a given azimuth / elevation angle there will be one HRTFKernel for the left ear transfer function, and one for the right ear.
 // The leading delay (average group delay) for each impulse response is extracted:
-//      m_fftFrame is the frequency-domain representation of the impulse response with the delay removed
 //      m_frameDelay is the leading delay of the original impulse response.
-class HRTFKernel 
+//
+// The frequency-domain data itself is stored quantized to int16 with one
+// scale per kernel, halving the resident size of a database that is mostly
+// cold. fftFrame() expands to float on first use; expanded frames are pinned
+// by a small process-wide hot cache (see HRTFKernel.cpp), and convolution
+// always runs against the float expansion, so working precision is unchanged.
+class HRTFKernel
 {
 public:
     // Note: this is destructive on the passed in AudioChannel.
     // The length of channel must be a power of two.
     HRTFKernel(AudioChannel *, size_t fftSize, float sampleRate);
-    
-    HRTFKernel(std::unique_ptr<FFTFrame> fftFrame, float frameDelay, float sampleRate) : m_fftFrame(std::move(fftFrame)) , m_frameDelay(frameDelay), m_sampleRate(sampleRate)
-    {
-    }
-
-    FFTFrame* fftFrame() { return m_fftFrame.get(); }
-    
-    size_t fftSize() const { return m_fftFrame->fftSize(); }
+
+    HRTFKernel(std::unique_ptr<FFTFrame> fftFrame, float frameDelay, float sampleRate);
+
+    ~HRTFKernel();
+
+    // Returns the float frequency-domain frame, expanding it from the
+    // quantized storage if it is not resident. The returned reference keeps
+    // the frame alive for the caller even if the hot cache evicts it.
+    std::shared_ptr<FFTFrame> fftFrame();
+
+    size_t fftSize() const { return m_fftSize; }
+
+    // Quantized halves, plus the float expansion while it is resident.
+    size_t memoryBytes() const;
     float frameDelay() const { return m_frameDelay; }
 
     // Converts back into impulse-response form.
@@ -41,8 +55,19 @@ public:
 
 private:
 
-    // Note: this is destructive on the passed in AudioChannel.
-    std::unique_ptr<FFTFrame> m_fftFrame;
+    void quantize(const FFTFrame & frame);
+    void cacheExpandedFrame(const std::shared_ptr<FFTFrame> & frame);
+
+    // fftSize/2 entries each, the packed DC/nyquist layout FFTFrame uses.
+    std::vector<int16_t> m_quantReal;
+    std::vector<int16_t> m_quantImag;
+    float m_quantScale = 0;
+    size_t m_fftSize = 0;
+
+    // Accessed with std::atomic_load/store; the hot cache may clear it from
+    // another thread while a caller still holds its own reference.
+    std::shared_ptr<FFTFrame> m_expandedFrame;
+
     float m_frameDelay;
     float m_sampleRate;
 };
@@ -36,6 +36,15 @@ private:
     // and azimuthBlend which is an interpolation value from 0 -> 1.
     int calculateDesiredAzimuthIndexAndBlend(double azimuth, double& azimuthBlend);
 
+    // Returns true when a desired index/elevation change should not open the
+    // second convolver pair: the source is essentially stationary and the
+    // index flip comes from hovering at an azimuth boundary, which the kernel
+    // interpolation blend can cover. When holding, azimuthBlend is
+    // re-expressed relative to the held index so the rendered direction stays
+    // continuous - that is what keeps the hold click-free.
+    bool shouldHoldKernel(int desiredAzimuthIndex, int activeAzimuthIndex, double elevation, double activeElevation,
+                          bool stationary, int numberOfAzimuths, double & azimuthBlend) const;
+
     // We maintain two sets of convolvers for smooth cross-faded interpolations when
     // then azimuth and elevation are dynamically changing.
     // When the azimuth and elevation are not changing, we simply process with one of the two sets.
@@ -69,6 +78,12 @@ private:
     // Per-sample-frame crossfade value increment.
     float m_crossfadeIncr;
 
+    // Direction rendered at the previous pan() call, for the angular-velocity
+    // estimate behind the stationary-source crossfade gate.
+    double m_lastAzimuth;
+    double m_lastElevation;
+    bool m_haveLastDirection;
+
     FFTConvolver m_convolverL1;
     FFTConvolver m_convolverR1;
     FFTConvolver m_convolverL2;
@@ -0,0 +1,77 @@
+// License: BSD 3 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef KernelStatePool_h
+#define KernelStatePool_h
+
+#include "LabSound/core/AudioArray.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lab {
+
+// KernelStatePool backs the per-channel DSP kernels (see
+// AudioDSPKernel::operator new) with size-class slabs instead of individual
+// heap blocks. Kernels of one type share a size class, so instances created
+// together - a bank of voices built in graph order - land back to back in
+// one cache-line-aligned slab rather than scattered across the heap, and a
+// render pass that walks them walks memory nearly linearly. Blocks are
+// recycled through a per-class free list; slabs themselves are never
+// returned, which is the same steady-state policy the bus pool uses.
+class KernelStatePool
+{
+public:
+    static KernelStatePool & instance();
+
+    // Cache-line aligned. Sizes above MaxPooledBytes fall through to the
+    // global allocator (no kernel today is near that, but a future one with
+    // inline table state shouldn't silently bloat the slabs).
+    void * allocate(size_t bytes);
+    void deallocate(void * p, size_t bytes);
+
+    static const size_t Alignment = 64;        // one cache line
+    static const size_t MaxPooledBytes = 4096;
+    static const size_t SlabBlocks = 64;       // blocks per slab
+
+    // Occupancy counters for leak hunting and sizing; relaxed snapshot.
+    struct Stats
+    {
+        size_t sizeClasses = 0;
+        size_t slabs = 0;
+        size_t liveBlocks = 0;
+        size_t reservedBytes = 0;
+    };
+    Stats stats() const;
+
+private:
+    KernelStatePool() = default;
+    KernelStatePool(const KernelStatePool &) = delete;
+    KernelStatePool & operator=(const KernelStatePool &) = delete;
+
+    struct AlignedSlabFree
+    {
+        void operator()(uint8_t * p) const { audioBufferFree(p); }
+    };
+
+    struct SizeClass
+    {
+        size_t blockBytes = 0;
+        void * freeList = nullptr; // intrusive; next pointer lives in the free block
+        size_t liveBlocks = 0;
+        std::vector<std::unique_ptr<uint8_t[], AlignedSlabFree>> slabs;
+    };
+
+    void addSlab(SizeClass & sizeClass);
+
+    mutable std::mutex m_mutex;
+    std::map<size_t, SizeClass> m_classes; // keyed by rounded block size
+};
+
+} // namespace lab
+
+#endif // KernelStatePool_h
@@ -17,7 +17,10 @@ class ContextRenderLock;
     
 class MultiChannelResampler {
 public:   
-    MultiChannelResampler(double scaleFactor, unsigned numberOfChannels);
+    // quality selects the kernel size of every channel's sinc resampler; the
+    // default is the full 32-tap kernel this class has always used.
+    MultiChannelResampler(double scaleFactor, unsigned numberOfChannels,
+                          ResamplerQuality quality = ResamplerQuality::FullSinc);
     
     // Process given AudioSourceProvider for streaming applications.
     void process(ContextRenderLock&, AudioSourceProvider*, AudioBus* destination, size_t framesToProcess);
@@ -26,10 +29,16 @@ private:
     // FIXME: the mac port can have a more highly optimized implementation based on CoreAudio
     // instead of SincResampler. For now the default implementation will be used on all ports.
     // https://bugs.webkit.org/show_bug.cgi?id=75118
-    
+
+    // 2..MaxInterleavedChannels channels resample through one interleaved
+    // SincResampler so all channels advance through the kernel together;
+    // otherwise each channel gets its own resampler.
+    std::unique_ptr<SincResampler> m_interleavedKernel;
+    AudioFloatArray m_interleavedOutput;
+
     // Each channel will be resampled using a high-quality SincResampler.
     std::vector<std::unique_ptr<SincResampler> > m_kernels;
-    
+
     unsigned m_numberOfChannels;
 };
 
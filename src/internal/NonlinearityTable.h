@@ -0,0 +1,67 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef NonlinearityTable_h
+#define NonlinearityTable_h
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace lab {
+
+// Shared table-driven nonlinearity: a shaping function is sampled once into
+// an interpolated lookup table, and blocks are then mapped through the table
+// by a common SIMD kernel instead of evaluating transcendentals per sample.
+// The table only regenerates when the parameters it was built from change,
+// so steady-state processing never touches libm. WaveShaperDSPKernel routes
+// its curve lookup through the same kernel; extended nodes with exponential
+// or power-law curves (diode clippers, gain computers) build their curve
+// here rather than hand-rolling per-sample math.
+//
+// Not thread safe: ensure() is expected under the render lock or from the
+// thread that owns the table.
+class NonlinearityTable
+{
+public:
+
+    // Rebuilds the table by evaluating shape at tableLength evenly spaced
+    // points across [inputMin, inputMax] - but only if the geometry or
+    // shapeKey differ from the previous build. shapeKey must encode every
+    // parameter the shape depends on (e.g. bit-cast floats mixed together);
+    // callers pass the same key while parameters are unchanged and pay
+    // nothing. Returns true when the table was regenerated.
+    bool ensure(float inputMin, float inputMax, size_t tableLength, uint64_t shapeKey,
+                const std::function<float(float)> & shape);
+
+    bool valid() const { return m_table.size() >= 2; }
+
+    // Interpolated lookup of a block; inputs outside [inputMin, inputMax]
+    // clamp to the table ends. source and destination may alias.
+    void apply(const float * source, float * destination, size_t framesToProcess) const;
+
+    // The underlying kernel: maps source values in [inputMin, inputMax] onto
+    // tableData with linear interpolation between adjacent entries, clamping
+    // out-of-range input. SIMD on SSE2; exposed so curve owners with their
+    // own storage (WaveShaperProcessor) share one implementation.
+    static void applyTable(const float * tableData, size_t tableLength,
+                           float inputMin, float inputMax,
+                           const float * source, float * destination, size_t framesToProcess);
+
+    // Convenience for building keys: mixes a float's bits into a running key.
+    static uint64_t mixKey(uint64_t key, float value);
+
+    size_t memoryBytes() const { return m_table.size() * sizeof(float); }
+
+private:
+
+    std::vector<float> m_table;
+    float m_inputMin{ 0 };
+    float m_inputMax{ 0 };
+    uint64_t m_shapeKey{ 0 };
+};
+
+} // namespace lab
+
+#endif // NonlinearityTable_h
@@ -0,0 +1,116 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef RenderAllocationDetector_h
+#define RenderAllocationDetector_h
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lab
+{
+
+class AudioNode;
+
+// Catches hidden heap allocations on the render thread (std::function
+// captures, lazy buffer growth) the day they land instead of in production
+// dropout telemetry. When the library is built with the CMake option
+// LABSOUND_RENDER_ALLOC_DETECTOR, global operator new/delete are interposed;
+// while a thread is inside a RenderSpan every allocation is counted, its call
+// site (the allocating return address) recorded, and the cost attributed to
+// the node whose process() is running. Without the option every entry point
+// below is an empty inline and the interposition is not compiled at all.
+//
+// Detection is off by default even in an instrumented build; enable it with
+// setDetectionEnabled() or the environment variable
+// LABSOUND_RENDER_ALLOC_DETECT=1. Hard-fail mode (setHardFailEnabled() or
+// LABSOUND_RENDER_ALLOC_HARDFAIL=1) aborts on the first render-span
+// allocation with the call site logged, which is what CI should run.
+namespace RenderAllocationDetector
+{
+
+#ifdef LABSOUND_RENDER_ALLOC_DETECTOR
+
+    void setDetectionEnabled(bool enabled);
+    bool detectionEnabled();
+
+    void setHardFailEnabled(bool enabled);
+    bool hardFailEnabled();
+
+    // A distinct allocating return address and what flowed through it.
+    // Addresses are raw; symbolize them offline (addr2line, atos) against
+    // the unstripped binary.
+    struct CallSite
+    {
+        const void * returnAddress = nullptr;
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
+    // Snapshot of the distinct call sites observed, most allocations first.
+    std::vector<CallSite> callSites();
+
+    uint64_t totalAllocations();
+    uint64_t totalBytes();
+
+    // Clears the call-site table and the totals (not the per-node counters;
+    // those reset with AudioNode::resetProfile()).
+    void reset();
+
+    // Marks the calling thread as rendering for the scope's lifetime.
+    // AudioDestinationNode::render() holds one across the device callback.
+    struct RenderSpan
+    {
+        RenderSpan();
+        ~RenderSpan();
+    };
+
+    // Attributes allocations inside the scope to a node, surfaced per node
+    // through AudioContext::nodeProfile(). processIfNecessary() holds one
+    // around process().
+    struct NodeScope
+    {
+        NodeScope(AudioNode * node);
+        ~NodeScope();
+
+    private:
+        AudioNode * m_previous;
+    };
+
+#else
+
+    inline void setDetectionEnabled(bool) {}
+    inline bool detectionEnabled() { return false; }
+    inline void setHardFailEnabled(bool) {}
+    inline bool hardFailEnabled() { return false; }
+
+    struct CallSite
+    {
+        const void * returnAddress = nullptr;
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
+    inline std::vector<CallSite> callSites() { return {}; }
+    inline uint64_t totalAllocations() { return 0; }
+    inline uint64_t totalBytes() { return 0; }
+    inline void reset() {}
+
+    struct RenderSpan
+    {
+        RenderSpan() {}
+    };
+
+    struct NodeScope
+    {
+        NodeScope(AudioNode *) {}
+    };
+
+#endif
+
+}  // namespace RenderAllocationDetector
+
+}  // namespace lab
+
+#endif  // RenderAllocationDetector_h
@@ -28,12 +28,22 @@ public:
     size_t impulseResponseLength() const { return m_impulseResponseLength; }
     size_t latencyFrames() const;
 
+    // Total bytes held by the convolution engines and workspaces.
+    size_t memoryBytes() const;
+
+    // Forwarded to each convolver; see ReverbConvolver::setTailTruncationThreshold.
+    void setTailTruncationThreshold(float threshold);
+
 private:
 
     void initialize(AudioBus* impulseResponseBuffer, size_t renderSliceSize, size_t maxFFTSize, size_t numberOfChannels, bool useBackgroundThreads);
 
     size_t m_impulseResponseLength;
 
+    // Content hash of the un-normalized impulse response, used to key the
+    // process-wide stage-kernel cache; see ReverbConvolver.
+    uint64_t m_responseHash = 0;
+
     std::vector<std::unique_ptr<ReverbConvolver> > m_convolvers;
 
     // For "True" stereo processing
@@ -16,6 +16,12 @@ class ReverbAccumulationBuffer {
 public:
     ReverbAccumulationBuffer(size_t length);
 
+    // One stage's rendered output and the buffer position it lands at; see accumulateBatch().
+    struct Contribution {
+        const float* source;
+        size_t writeIndex;
+    };
+
     // This will read from, then clear-out numberOfFrames
     void readAndClear(float* destination, size_t numberOfFrames);
 
@@ -25,11 +31,27 @@ public:
     // Returns the writeIndex where the accumulation took place
     int accumulate(float* source, size_t numberOfFrames, int* readIndex, size_t delayFrames);
 
+    // The position accumulate() would write at for this readIndex and delay.
+    size_t writeIndexFor(int readIndex, size_t delayFrames) const;
+
+    // Accumulates at an already-computed position without touching any read index.
+    void accumulateAt(const float* source, size_t numberOfFrames, size_t writeIndex);
+
+    // Accumulates many stages' outputs in one pass. Contributions landing at
+    // the same position are first summed into scratch, so each buffer region
+    // is read and written once however many stages feed it, instead of one
+    // read-modify-write pass per stage. Reorders contributions in place.
+    // scratch belongs to the caller because realtime and background stages
+    // batch concurrently from different threads.
+    void accumulateBatch(Contribution* contributions, size_t count, size_t numberOfFrames, AudioFloatArray& scratch);
+
     size_t readIndex() const { return m_readIndex; }
     void updateReadIndex(int* readIndex, size_t numberOfFrames) const;
 
     size_t readTimeFrame() const { return m_readTimeFrame; }
 
+    size_t memoryBytes() const { return m_buffer.size() * sizeof(float); }
+
     void reset();
 
 private:
@@ -13,6 +13,7 @@
 #include "internal/ReverbConvolverStage.h"
 #include "internal/ReverbInputBuffer.h"
 
+#include <cstdint>
 #include <mutex>
 #include <vector>
 #include <condition_variable>
@@ -32,7 +33,11 @@ public:
     // For certain tweaky de-convolving applications the phase errors add up quickly and lead to non-sensical results with
     // larger FFT sizes and single-precision floats.  In these cases 2048 is a good size.
     // If not doing multi-threaded convolution, then should not go > 8192.
-    ReverbConvolver(AudioChannel* impulseResponse, size_t renderSliceSize, size_t maxFFTSize, size_t convolverRenderPhase, bool useBackgroundThreads);
+    // cacheKey, when non-zero, identifies the impulse response content and
+    // partitioning parameters; convolvers constructed with the same key share
+    // one immutable set of FFT'd stage kernels via a process-wide cache, so
+    // only the first construction pays for transforming the response.
+    ReverbConvolver(AudioChannel* impulseResponse, size_t renderSliceSize, size_t maxFFTSize, size_t convolverRenderPhase, bool useBackgroundThreads, uint64_t cacheKey = 0);
     ~ReverbConvolver();
 
     void process(ContextRenderLock& r, const AudioChannel* sourceChannel, AudioChannel* destinationChannel, size_t framesToProcess);
@@ -43,16 +48,38 @@ public:
     ReverbInputBuffer* inputBuffer() { return &m_inputBuffer; }
 
     bool useBackgroundThreads() const { return m_useBackgroundThreads; }
-    void backgroundThreadEntry();
+
+    // Runs on a ConvolutionWorkerPool worker: processes the background stages
+    // until they have caught up with the input buffer's write index. Only one
+    // worker drains a given convolver at a time.
+    void drainBackgroundWork();
 
     size_t latencyFrames() const;
 
+    size_t memoryBytes() const;
+
+    // Tail truncation: a stage is gated off while its bounded output
+    // amplitude (input peak envelope times the L1 norm of its response
+    // slice) stays below this linear threshold. 0 disables the bound;
+    // stages are always gated once the input has been silent longer than
+    // their portion of the tail, which is output-exact.
+    void setTailTruncationThreshold(float threshold) { m_tailThreshold.store(threshold, std::memory_order_relaxed); }
+    float tailTruncationThreshold() const { return m_tailThreshold.load(std::memory_order_relaxed); }
+
 private:
 
     std::vector<std::unique_ptr<ReverbConvolverStage> > m_stages;
     std::vector<std::unique_ptr<ReverbConvolverStage> > m_backgroundStages;
     size_t m_impulseResponseLength;
 
+    // Per-slice staging for batched accumulation (see accumulateBatch).
+    // Reserved at construction so render-time use never allocates; realtime
+    // and background draining run on different threads, hence one set each.
+    std::vector<ReverbAccumulationBuffer::Contribution> m_realtimeContributions;
+    std::vector<ReverbAccumulationBuffer::Contribution> m_backgroundContributions;
+    AudioFloatArray m_realtimeScratch;
+    AudioFloatArray m_backgroundScratch;
+
     ReverbAccumulationBuffer m_accumulationBuffer;
 
     // One or more background threads read from this input buffer which is fed from the realtime thread.
@@ -65,13 +92,34 @@ private:
     // But don't exceed this size in the real-time thread (if we're doing background processing).
     size_t m_maxRealtimeFFTSize;
 
-    // Background thread and synchronization
+    // Background stages are serviced by the shared ConvolutionWorkerPool
+    // rather than a per-instance thread.
     bool m_useBackgroundThreads;
-    std::thread m_backgroundThread;
-    std::atomic<bool> m_wantsToExit;
-    bool m_moreInputBuffered;
-    mutable std::mutex m_backgroundThreadLock;
-    mutable std::condition_variable m_backgroundThreadCondition;
+    bool m_registeredWithWorkerPool{false};
+
+    // Workers are only woken once this many new input frames have
+    // accumulated - half the smallest background-stage FFT, the partition
+    // the background drain actually operates on. Waking per quantum just
+    // context-switched a worker to find no complete partition.
+    size_t m_backgroundBatchFrames{0};
+    size_t m_framesSinceWake{0};
+
+    // Per-stage gating state, parallel to m_stages / m_backgroundStages.
+    // tailFrames: input silent longer than this means the stage's output is
+    // exactly zero. responseL1: sum of |response| over the stage's slice, a
+    // bound on its output amplitude per unit input peak. engaged flags let a
+    // stage be reset exactly once when it gates off.
+    std::vector<size_t> m_stageTailFrames;
+    std::vector<float> m_stageResponseL1;
+    std::vector<char> m_stageEngaged;
+    std::vector<size_t> m_backgroundStageTailFrames;
+    std::vector<float> m_backgroundStageResponseL1;
+    std::vector<char> m_backgroundStageEngaged;
+
+    // Written on the render thread, read by background drains.
+    std::atomic<float> m_tailThreshold{0.f};
+    std::atomic<uint64_t> m_framesSinceAudibleInput{uint64_t(1) << 62};
+    std::atomic<float> m_inputEnvelope{0.f};
 };
 
 } // namespace lab
@@ -8,10 +8,12 @@
 #include "LabSound/core/AudioArray.h"
 
 #include "internal/FFTFrame.h"
+#include "internal/ReverbAccumulationBuffer.h"
+
+#include <memory>
 
 namespace lab {
 
-class ReverbAccumulationBuffer;
 class ReverbConvolver;
 class FFTConvolver;
 class DirectConvolver;
@@ -22,20 +24,48 @@ class ReverbConvolverStage {
 public:
     // renderPhase is useful to know so that we can manipulate the pre versus post delay so that stages will perform
     // their heavy work (FFT processing) on different slices to balance the load in a real-time thread.
-    ReverbConvolverStage(const float* impulseResponse, size_t responseLength, size_t reverbTotalLatency, size_t stageOffset, size_t stageLength, size_t fftSize, size_t renderPhase, size_t renderSliceSize, ReverbAccumulationBuffer*, bool directMode = false);
+    // If sharedKernel is non-null the stage uses it instead of FFT-transforming
+    // its slice of the impulse response; the kernel is read-only during
+    // processing so instances can share one (see the kernel cache in
+    // ReverbConvolver.cpp).
+    ReverbConvolverStage(const float* impulseResponse, size_t responseLength, size_t reverbTotalLatency, size_t stageOffset, size_t stageLength, size_t fftSize, size_t renderPhase, size_t renderSliceSize, ReverbAccumulationBuffer*, bool directMode = false, std::shared_ptr<FFTFrame> sharedKernel = nullptr);
 
     // WARNING: framesToProcess must be such that it evenly divides the delay buffer size (stage_offset).
     void process(const float* source, size_t framesToProcess);
 
-    void processInBackground(ReverbConvolver* convolver, size_t framesToProcess);
+    // As process(), but instead of accumulating immediately, returns the
+    // stage's rendered slice and target position through contribution so the
+    // convolver can batch all stages into one accumulation pass. Returns
+    // false (and produces no contribution) while the stage is still
+    // buffering its pre-delay. The contribution's source points at the
+    // stage's temporary buffer and is valid until the next call.
+    bool processToContribution(const float* source, size_t framesToProcess, ReverbAccumulationBuffer::Contribution& contribution);
+
+    bool processInBackground(ReverbConvolver* convolver, size_t framesToProcess, ReverbAccumulationBuffer::Contribution& contribution);
+
+    // Advances past background input this stage will not render; used while
+    // the stage is gated off by tail truncation (see ReverbConvolver) so its
+    // ring read position stays in step with the active stages.
+    void skipInBackground(ReverbConvolver* convolver, size_t framesToProcess);
 
     void reset();
 
+    // As reset(), but keeps the background input-ring read position so a
+    // gated-off stage can continue consuming ring input in step.
+    void resetConvolutionState();
+
     // Useful for background processing
     int inputReadIndex() const { return m_inputReadIndex; }
 
+    // The frequency-domain kernel for this stage; null in direct mode.
+    std::shared_ptr<FFTFrame> fftKernel() const { return m_fftKernel; }
+
+    // Bytes held by this stage's partition: kernel, pre-delay, convolver
+    // state. A kernel shared through the cache is counted by each sharer.
+    size_t memoryBytes() const;
+
 private:
-    std::unique_ptr<FFTFrame> m_fftKernel;
+    std::shared_ptr<FFTFrame> m_fftKernel;
     std::unique_ptr<FFTConvolver> m_fftConvolver;
 
     AudioFloatArray m_preDelayBuffer;
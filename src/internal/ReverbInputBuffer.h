@@ -22,6 +22,8 @@ public:
     // Background threads can call this to check if there's anything to read...
     size_t writeIndex() const { return m_writeIndex; }
 
+    size_t memoryBytes() const { return m_buffer.size() * sizeof(float); }
+
     // The individual background threads read here (and hope that they can keep up with the buffer writing).
     // readIndex is updated with the next readIndex to read from...
     // The assumption is that the buffer's length is evenly divisible by numberOfFrames.
@@ -0,0 +1,31 @@
+// License: BSD 3 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef SharedAudioDestination_h
+#define SharedAudioDestination_h
+
+#include <cstddef>
+
+#include "internal/AudioDestination.h"
+
+namespace lab {
+
+struct AudioIOCallback;
+
+// SharedAudioDestination lets several AudioContexts share one hardware
+// stream. Each destination made through MakeSharedAudioDestination is a
+// lightweight client of a process-wide device; all clients with the same
+// channel count and sample rate are rendered in sequence inside a single
+// platform callback and summed into the hardware buffer. Compared to
+// opening a stream per context this avoids duplicated callback overhead
+// and OS-level mixing latency, and keeps the contexts sample-aligned with
+// one another.
+//
+// start() and stop() control only this client's participation; the
+// underlying hardware stream starts with the first active client and
+// stops with the last.
+AudioDestination * MakeSharedAudioDestination(AudioIOCallback &, size_t numberOfOutputChannels, float sampleRate);
+
+} // namespace lab
+
+#endif // SharedAudioDestination_h
@@ -7,24 +7,57 @@
 
 #include "LabSound/core/AudioSourceProvider.h"
 #include "LabSound/core/AudioArray.h"
+#include "LabSound/core/Constants.h"
+
+#include <vector>
 
 namespace lab {
 
 // SincResampler is a high-quality sample-rate converter.
 
 class SincResampler {
-public:   
+public:
+    // With numberOfChannels > 1 the resampler runs in interleaved mode: the
+    // source provider is asked for multichannel busses, the sample history is
+    // kept as interleaved frames, and every channel advances through the
+    // kernel together so each coefficient is loaded once and applied across
+    // the channel lanes.
+    enum { MaxInterleavedChannels = 8 };
+
     // scaleFactor == sourceSampleRate / destinationSampleRate
     // kernelSize can be adjusted for quality (higher is better)
     // numberOfKernelOffsets is used for interpolation and is the number of sub-sample kernel shifts.
-    SincResampler(double scaleFactor, size_t kernelSize = 32, size_t numberOfKernelOffsets = 32);
-    
+    SincResampler(double scaleFactor, size_t kernelSize = 32, size_t numberOfKernelOffsets = 32, unsigned numberOfChannels = 1);
+
+    // Kernel size for a quality tier: 4, 8 or 32 taps. The 4-tap kernel is
+    // the cheapest conversion this class can express; true linear paths
+    // (SampledAudioNode pitch) interpret the Linear tier themselves.
+    static size_t kernelSizeForQuality(ResamplerQuality quality)
+    {
+        switch (quality)
+        {
+            case ResamplerQuality::Linear: return 4;
+            case ResamplerQuality::SmallSinc: return 8;
+            default: return 32;
+        }
+    }
+
     // Processes numberOfSourceFrames from source to produce numberOfSourceFrames / scaleFactor frames in destination.
+    // Single-channel mode only.
     void process(const float* source, float* destination, size_t numberOfSourceFrames);
 
     // Process with input source callback function for streaming applications.
+    // In interleaved mode, destination receives framesToProcess interleaved
+    // frames (framesToProcess * numberOfChannels floats).
     void process(AudioSourceProvider*, float* destination, size_t framesToProcess);
 
+    // Adjusts the conversion ratio between processing passes; used by
+    // consumers that servo the rate against a fill level to absorb clock
+    // drift between domains. Keep trims to a fraction of a percent, or the
+    // fixed kernel's cutoff no longer matches the ratio.
+    void setScaleFactor(double scaleFactor) { m_scaleFactor = scaleFactor; }
+    double scaleFactor() const { return m_scaleFactor; }
+
 protected:
     void initializeKernel();
     void consumeSource(float* buffer, size_t numberOfSourceFrames);
@@ -44,9 +77,16 @@ protected:
     // This is the number of destination frames we generate per processing pass on the buffer.
     size_t m_blockSize;
 
-    // Source is copied into this buffer for each processing pass.
+    // Source is copied into this buffer for each processing pass. In
+    // interleaved mode it holds frames of m_numberOfChannels samples.
     AudioFloatArray m_inputBuffer;
 
+    unsigned m_numberOfChannels;
+
+    // Interleaved mode: planar per-channel landing buffers the provider
+    // writes into before the frames are interleaved into m_inputBuffer.
+    std::vector<AudioFloatArray> m_consumeScratch;
+
     const float* m_source;
     size_t m_sourceFramesAvailable;
     
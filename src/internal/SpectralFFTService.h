@@ -0,0 +1,57 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef SpectralFFTService_h
+#define SpectralFFTService_h
+
+#include <cstddef>
+#include <vector>
+
+namespace lab {
+
+// Shared spectral analysis worker. Every spectrum consumer - spectral meter
+// taps, SpectralMonitorNode instances, any number of spectrum views - used to
+// own a private FFT setup and either transform on the render thread's dime or
+// spin up its own worker. The service instead owns one background thread for
+// the whole process: clients register a window size, hand over filled
+// Blackman-windowed-to-be blocks from any thread without blocking, and the
+// worker batches all pending transforms grouped by size so frames of the same
+// size share one FFT setup (the platform SIMD backend underneath FFTFrame).
+// Results are published per client through a seqlock, so readers on UI
+// threads never take a lock the worker holds and the tenth spectrum view
+// costs one more transform, not one more thread.
+class SpectralFFTService
+{
+public:
+    // The process-wide instance; created on first use, torn down at exit.
+    static SpectralFFTService & shared();
+
+    // Registers a consumer of windowSize-point transforms (power of two).
+    // Returns a client id for submit/read/unregister.
+    int registerClient(size_t windowSize);
+    void unregisterClient(int id);
+
+    // Queues windowSize samples for analysis and wakes the worker. Never
+    // blocks: if the worker is mid-copy on this client the block is dropped,
+    // and an unserviced previous submission is simply replaced by the newer
+    // one. Safe to call from the render thread.
+    void submit(int id, const float * samples);
+
+    // Copies the most recent magnitude spectrum (windowSize / 2 bins,
+    // Blackman windowed, nyquist removed) into result. Returns false and
+    // leaves result empty before the first transform completes. Any thread.
+    bool readMagnitudes(int id, std::vector<float> & result) const;
+
+private:
+    SpectralFFTService();
+    ~SpectralFFTService();
+    SpectralFFTService(const SpectralFFTService &) = delete;
+
+    struct Client;
+    struct Internals;
+    Internals * m_internals;
+};
+
+} // namespace lab
+
+#endif // SpectralFFTService_h
@@ -0,0 +1,77 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifndef StreamingWavWriter_h
+#define StreamingWavWriter_h
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lab
+{
+
+// Streams interleaved float samples to a 32 bit float WAV on a background
+// writer thread, so producing audio and writing it to disk overlap and the
+// producer stays lock-free. This is the writer-thread machinery RecorderNode
+// uses, factored out so offline rendering can bake straight to disk: an SPSC
+// ring whose write index the producer owns and whose read index the writer
+// thread owns, a header written with zero sizes and patched on finalize so
+// the file grows incrementally, and a drain-before-close guarantee so nothing
+// produced is lost at teardown.
+class StreamingWavWriter
+{
+public:
+    StreamingWavWriter();
+    ~StreamingWavWriter();  // finishes any open stream and joins the writer
+
+    // Opens the file and writes the header; returns false when the file
+    // cannot be created. One stream at a time per writer.
+    bool open(const std::string & path, int channels, int sampleRate);
+
+    // Producer side: constant time, no locks, no allocation. Samples are
+    // dropped (and counted) only if the ring fills because the writer thread
+    // stalled for several seconds.
+    void writeInterleaved(const float * samples, size_t count);
+
+    // Producer side for non-realtime producers (offline rendering): blocks
+    // until the ring has room instead of dropping, so a bake that outruns
+    // the disk is throttled to disk speed rather than corrupted.
+    void writeInterleavedBlocking(const float * samples, size_t count);
+
+    // Asks the writer thread to drain the ring, patch the header and close;
+    // returns immediately. busy() turns false once the file is complete.
+    void finish();
+
+    bool busy() const;
+
+    // Frames dropped because the ring filled.
+    uint64_t overrunFrames() const { return m_overrunFrames.load(std::memory_order_relaxed); }
+
+private:
+    void writerThread();
+
+    // SPSC ring of interleaved samples; both indices only advance.
+    std::vector<float> m_ring;
+    std::atomic<uint64_t> m_ringWrite{0};
+    std::atomic<uint64_t> m_ringRead{0};
+    std::atomic<uint64_t> m_overrunFrames{0};
+
+    std::atomic<bool> m_writerShouldRun{true};
+    std::thread m_writerThread;
+
+    // Guards the stream state below; taken by the writer thread and the
+    // open/finish calls, never by the producer.
+    mutable std::mutex m_controlMutex;
+    FILE * m_file = nullptr;
+    uint64_t m_bytesStreamed = 0;
+    bool m_finalizeRequested = false;
+};
+
+} // namespace lab
+
+#endif // StreamingWavWriter_h
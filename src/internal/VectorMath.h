@@ -7,6 +7,7 @@
 
 
 #include <cstddef>
+#include <stdint.h>
 
 // Defines the interface for several vector math functions whose implementation will ideally be optimized.
 
@@ -19,15 +20,41 @@ void vsma(const float* sourceP, int sourceStride, const float* scale, float* des
 
 void vsmul(const float* sourceP, int sourceStride, const float* scale, float* destP, int destStride, size_t framesToProcess);
 void vadd(const float* source1P, int sourceStride1, const float* source2P, int sourceStride2, float* destP, int destStride, size_t framesToProcess);
+
+// Accumulates several source vectors into destP in one pass: destP += source[0] + source[1] + ...
+// High fan-in summing junctions use this so that mixing cost is bounded by memory
+// bandwidth over the destination rather than by one full pass per connection.
+void vaddm(const float* const* sourceP, size_t numberOfSources, float* destP, size_t framesToProcess);
 void vintlve(const float* realSrcP, const float* imagSrcP, float* destP, size_t framesToProcess); // for KissFFT
 void vdeintlve(const float* sourceP, float* realDestP, float* imagDestP, size_t framesToProcess); // for KissFFT
 
+// N-channel form of vdeintlve: scatters interleaved sample frames into planar
+// channel arrays. framesToProcess counts frames, not interleaved samples.
+// Stereo and quad take SIMD shuffle/transpose paths; asset decode uses this
+// to land decoders' interleaved output directly in AudioBus channels.
+void vdeintlvem(const float* sourceP, float* const* destP, size_t numberOfChannels, size_t framesToProcess);
+
 // Finds the maximum magnitude of a float vector.
 void vmaxmgv(const float* sourceP, int sourceStride, float* maxP, size_t framesToProcess);
 
+// Multichannel form of vmaxmgv over planar channel data: one call scans every
+// channel and reports the global peak magnitude.
+void vmaxmgvm(const float* const* sourceP, size_t numberOfChannels, float* maxP, size_t framesToProcess);
+
+// Fused scan-and-scale over planar channel data: finds the global peak
+// magnitude across all channels, then rescales every channel in place so the
+// peak lands on targetPeak. The scale pass is skipped entirely when the data
+// is silent or already at the target. Asset normalization at load time is the
+// main client.
+void vnormalizem(float* const* channelP, size_t numberOfChannels, float targetPeak, size_t framesToProcess);
+
 // Sums the squares of a float vector's elements.
 void vsvesq(const float* sourceP, int sourceStride, float* sumP, size_t framesToProcess);
 
+// Dot product of two float vectors. Correlation searches (WSOLA offset
+// selection) evaluate many of these per block, so the inner loop matters.
+void vdotpr(const float* source1P, const float* source2P, float* resultP, size_t framesToProcess);
+
 // For an element-by-element multiply of two float vectors.
 void vmul(const float* source1P, int sourceStride1, const float* source2P, int sourceStride2, float* destP, int destStride, size_t framesToProcess);
 
@@ -37,6 +64,38 @@ void zvmul(const float* real1P, const float* imag1P, const float* real2P, const
 // Copies elements while clipping values to the threshold inputs.
 void vclip(const float* sourceP, int sourceStride, const float* lowThresholdP, const float* highThresholdP, float* destP, int destStride, size_t framesToProcess);
 
+// Branch-free comparator: destP = source1P > source2P ? 1 : -1, e.g. a
+// carrier compared against a modulator for pulse-width modulation.
+void vcomp(const float* source1P, const float* source2P, float* destP, size_t framesToProcess);
+
+// Saturates elements: destP = *outputGainP * tanh(*inputGainP * sourceP).
+// Uses a branch-free rational approximation of tanh (error below 1e-6 against
+// tanhf, output bounded by +/-1) so whole quanta process without per-sample
+// libm calls.
+void vtanh(const float* sourceP, const float* inputGainP, const float* outputGainP, float* destP, size_t framesToProcess);
+
+// Fused exponential gain ramp: destP = sourceP * g, where g relaxes toward
+// targetGain by g += (targetGain - g) * rate each frame. The ramp is computed
+// analytically (g_i = target + (g_0 - target) * (1 - rate)^i) inline with the
+// multiply, so dezippering needs no intermediate gain array and no second
+// memory pass. *gainP carries the ramp state: it is read as the starting gain
+// and updated to the value after the last frame.
+void vexpramp(const float* sourceP, float* destP, float targetGain, float* gainP, float rate, size_t framesToProcess);
+
+// Converts planar float channels to interleaved integer PCM in one pass:
+// clamp to [-1, 1], scale to the target bit depth, optionally add 1 LSB TPDF
+// dither, round. int24 samples are packed little-endian, three bytes each.
+// Device callbacks on integer-format outputs use these to write the hardware
+// buffer directly from AudioBus channel data, with no separate interleave or
+// format-conversion passes.
+void vfloat_to_int16_interleave(const float* const* sourceP, size_t numberOfChannels, int16_t* destP, size_t framesToProcess, bool dither);
+void vfloat_to_int24_interleave(const float* const* sourceP, size_t numberOfChannels, uint8_t* destP, size_t framesToProcess, bool dither);
+
+// True when the CPU and OS support the AVX2+FMA kernels used by the x86
+// runtime dispatch; always false on other architectures and on Apple builds
+// (which use Accelerate instead).
+bool cpuHasAVX2();
+
 } // namespace VectorMath
 
 } // namespace lab
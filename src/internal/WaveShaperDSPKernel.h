@@ -5,33 +5,52 @@
 #ifndef WaveShaperDSPKernel_h
 #define WaveShaperDSPKernel_h
 
+#include "LabSound/core/AudioArray.h"
+
 #include "internal/AudioDSPKernel.h"
+#include "internal/SincResampler.h"
 #include "internal/WaveShaperProcessor.h"
 
+#include <memory>
+
 namespace lab {
 
 class WaveShaperProcessor;
 
 // WaveShaperDSPKernel is an AudioDSPKernel and is responsible for non-linear distortion on one channel.
 
-class WaveShaperDSPKernel : public AudioDSPKernel 
+class WaveShaperDSPKernel : public AudioDSPKernel
 {
-public:  
+public:
 
     explicit WaveShaperDSPKernel(WaveShaperProcessor * processor) : AudioDSPKernel(processor) { }
-    
+
     // AudioDSPKernel
     virtual void process(ContextRenderLock&,
                          const float* source, float* dest, size_t framesToProcess) override;
-    virtual void reset() override { }
+    virtual void reset() override;
 
     virtual double tailTime(ContextRenderLock & r) const override { return 0; }
-    virtual double latencyTime(ContextRenderLock & r) const override { return 0; }
-    
+    virtual double latencyTime(ContextRenderLock & r) const override;
+
 protected:
 
     WaveShaperProcessor* waveShaperProcessor() { return static_cast<WaveShaperProcessor*>(processor()); }
 
+    // Interpolated curve lookup over one block; source and destination may alias.
+    void shapeBlock(const float * curveData, size_t curveLength, const float * source, float * destination, size_t framesToProcess);
+
+    // Builds (or tears down) the resampler pair when the processor's
+    // oversampling factor changes. A one-time allocation per mode change;
+    // steady-state processing reuses the scratch buffer.
+    void configureOversampling(int oversample);
+
+    int m_oversample = 1;
+    std::unique_ptr<SincResampler> m_upSampler;
+    std::unique_ptr<SincResampler> m_downSampler;
+
+    // Holds one upsampled quantum; the curve is applied to it in place.
+    AudioFloatArray m_oversampleBuffer;
 };
 
 } // namespace lab
@@ -27,6 +27,11 @@ public:
     // curve is moved into setCurve, and contents will be mutated safely
     void setCurve(std::vector<float> && curve);
 
+    // 1 (off), 2 or 4. Takes effect at the start of the next rendering
+    // quantum, like a curve change.
+    void setOversample(int oversample);
+    int oversample() const { return m_oversample; }
+
     struct Curve
     {
         explicit Curve(std::mutex& m, const std::vector<float> & c)
@@ -49,6 +54,8 @@ private:
     std::mutex m_curveWrite;
     std::vector<float> m_curve;
     std::vector<float> m_newCurve;
+    int m_oversample = 1;
+    int m_newOversample = 0;  // 0 means no change pending
 };
 
 }  // namespace lab
@@ -5,30 +5,41 @@
 #ifndef ZeroPole_h
 #define ZeroPole_h
 
+#include "internal/Biquad.h"
+
 #include <cstddef>
 
 namespace lab {
 
-// ZeroPole is a simple filter with one zero and one pole.
+// ZeroPole is a simple filter with one zero and one pole, carried by the
+// biquad engine as a trivial (first-order) section so cascades process whole
+// quanta through the vectorized recurrence instead of a scalar per-sample
+// loop.
 class ZeroPole
 {
     float m_zero = 0.f;
     float m_pole = 0.f;
-    float m_lastX = 0.f;
-    float m_lastY = 0.f;
-    
+    Biquad m_biquad;
+
+    void updateCoefficients() { m_biquad.setZeroPoleParams(m_zero, m_pole); }
+
 public:
 
-    ZeroPole() { }
+    ZeroPole() { updateCoefficients(); }
 
     void process(const float *source, float *destination, size_t framesToProcess);
 
+    // Processes one cascade stage across several independent channels in
+    // parallel SIMD lanes (see Biquad::processChannels). filters, sources and
+    // dests must all have numberOfChannels entries.
+    static void processChannels(ZeroPole* const* filters, const float* const* sources, float* const* dests, size_t numberOfChannels, size_t framesToProcess);
+
     // Reset filter state.
-    void reset() { m_lastX = 0; m_lastY = 0; }
-    
-    void setZero(float zero) { m_zero = zero; }
-    void setPole(float pole) { m_pole = pole; }
-    
+    void reset() { m_biquad.reset(); }
+
+    void setZero(float zero) { m_zero = zero; updateCoefficients(); }
+    void setPole(float pole) { m_pole = pole; updateCoefficients(); }
+
     float zero() const { return m_zero; }
     float pole() const { return m_pole; }
 };
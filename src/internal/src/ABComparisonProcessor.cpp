@@ -0,0 +1,151 @@
+// License: BSD 3 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "internal/ABComparisonProcessor.h"
+
+#include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioNode.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace lab {
+
+namespace {
+
+    // Distance between two floats in units of last place, over a monotonic
+    // mapping of the bit patterns so the measure is continuous through zero.
+    // Any NaN on either side saturates, so a kernel that manufactures NaNs
+    // can't score as a near-match.
+    uint32_t ulpDistance(float a, float b)
+    {
+        if (a != a || b != b)
+            return a == a || b == b ? 0xffffffffu : 0;
+
+        int32_t ia, ib;
+        memcpy(&ia, &a, sizeof(ia));
+        memcpy(&ib, &b, sizeof(ib));
+
+        if (ia < 0) ia = static_cast<int32_t>(0x80000000u) - ia;
+        if (ib < 0) ib = static_cast<int32_t>(0x80000000u) - ib;
+
+        int64_t d = int64_t(ia) - int64_t(ib);
+        if (d < 0) d = -d;
+        return d > 0xffffffff ? 0xffffffffu : static_cast<uint32_t>(d);
+    }
+}
+
+ABComparisonProcessor::ABComparisonProcessor(std::unique_ptr<AudioProcessor> reference,
+                                             std::unique_ptr<AudioProcessor> candidate,
+                                             unsigned numberOfChannels)
+    : AudioProcessor(numberOfChannels)
+    , m_reference(std::move(reference))
+    , m_candidate(std::move(candidate))
+{
+}
+
+ABComparisonProcessor::~ABComparisonProcessor()
+{
+    if (isInitialized())
+        uninitialize();
+}
+
+void ABComparisonProcessor::initialize()
+{
+    m_reference->initialize();
+    m_candidate->initialize();
+    m_referenceBus.reset(new AudioBus(numberOfChannels(), AudioNode::ProcessingSizeInFrames));
+    m_initialized = true;
+}
+
+void ABComparisonProcessor::uninitialize()
+{
+    m_reference->uninitialize();
+    m_candidate->uninitialize();
+    m_initialized = false;
+}
+
+void ABComparisonProcessor::process(ContextRenderLock & r, const AudioBus * source, AudioBus * destination, size_t framesToProcess)
+{
+    size_t channels = destination->numberOfChannels();
+
+    // Resized only when the graph changes width - never per quantum.
+    if (!m_referenceBus || m_referenceBus->numberOfChannels() != channels || m_referenceBus->length() < framesToProcess)
+        m_referenceBus.reset(new AudioBus(channels, std::max<size_t>(framesToProcess, AudioNode::ProcessingSizeInFrames)));
+
+    m_reference->setNumberOfChannels(channels);
+    m_candidate->setNumberOfChannels(channels);
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    m_reference->process(r, source, m_referenceBus.get(), framesToProcess);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    m_candidate->process(r, source, destination, framesToProcess);
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    uint32_t quantumMaxUlp = 0;
+    for (size_t c = 0; c < channels; ++c)
+    {
+        const float * ref = m_referenceBus->channel(c)->data();
+        const float * cand = destination->channel(c)->data();
+        for (size_t i = 0; i < framesToProcess; ++i)
+        {
+            uint32_t d = ulpDistance(ref[i], cand[i]);
+            if (d > quantumMaxUlp)
+                quantumMaxUlp = d;
+        }
+    }
+
+    m_statQuanta.fetch_add(1, std::memory_order_relaxed);
+    m_statLastMaxUlp.store(quantumMaxUlp, std::memory_order_relaxed);
+    if (quantumMaxUlp > m_statMaxUlp.load(std::memory_order_relaxed))
+        m_statMaxUlp.store(quantumMaxUlp, std::memory_order_relaxed);
+
+    uint64_t refMicros = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    uint64_t candMicros = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+    m_statReferenceMicroseconds.fetch_add(refMicros, std::memory_order_relaxed);
+    m_statCandidateMicroseconds.fetch_add(candMicros, std::memory_order_relaxed);
+}
+
+void ABComparisonProcessor::reset()
+{
+    m_reference->reset();
+    m_candidate->reset();
+}
+
+double ABComparisonProcessor::tailTime(ContextRenderLock & r) const
+{
+    return m_candidate->tailTime(r);
+}
+
+double ABComparisonProcessor::latencyTime(ContextRenderLock & r) const
+{
+    return m_candidate->latencyTime(r);
+}
+
+size_t ABComparisonProcessor::memoryBytes() const
+{
+    return m_reference->memoryBytes() + m_candidate->memoryBytes();
+}
+
+ABComparisonProcessor::ComparisonStats ABComparisonProcessor::stats() const
+{
+    ComparisonStats stats;
+    stats.quanta = m_statQuanta.load(std::memory_order_relaxed);
+    stats.maxUlp = m_statMaxUlp.load(std::memory_order_relaxed);
+    stats.lastMaxUlp = m_statLastMaxUlp.load(std::memory_order_relaxed);
+    stats.referenceMicroseconds = m_statReferenceMicroseconds.load(std::memory_order_relaxed);
+    stats.candidateMicroseconds = m_statCandidateMicroseconds.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void ABComparisonProcessor::resetStats()
+{
+    m_statQuanta.store(0, std::memory_order_relaxed);
+    m_statMaxUlp.store(0, std::memory_order_relaxed);
+    m_statLastMaxUlp.store(0, std::memory_order_relaxed);
+    m_statReferenceMicroseconds.store(0, std::memory_order_relaxed);
+    m_statCandidateMicroseconds.store(0, std::memory_order_relaxed);
+}
+
+} // namespace lab
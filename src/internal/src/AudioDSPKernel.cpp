@@ -4,9 +4,20 @@
 
 #include "internal/AudioDSPKernel.h"
 #include "internal/AudioDSPKernelProcessor.h"
+#include "internal/KernelStatePool.h"
 
 namespace lab
 {
     AudioDSPKernel::AudioDSPKernel(AudioDSPKernelProcessor * kernelProcessor) : m_kernelProcessor(kernelProcessor) { }
     AudioDSPKernel::AudioDSPKernel() : m_kernelProcessor(nullptr) { }
+
+    void * AudioDSPKernel::operator new(size_t bytes)
+    {
+        return KernelStatePool::instance().allocate(bytes);
+    }
+
+    void AudioDSPKernel::operator delete(void * p, size_t bytes)
+    {
+        KernelStatePool::instance().deallocate(p, bytes);
+    }
 }
@@ -6,8 +6,62 @@
 #include "internal/AudioDSPKernel.h"
 #include "internal/Assertions.h"
 
+#include "LabSound/extended/AudioContextLock.h"
+
+#include <atomic>
+#include <cmath>
+
 namespace lab {
 
+namespace
+{
+    std::atomic<uint64_t> s_silentQuantaSkipped{0};
+    std::atomic<uint64_t> s_silentQuantaProcessed{0};
+}
+
+uint64_t AudioDSPKernelProcessor::silentQuantaSkipped()
+{
+    return s_silentQuantaSkipped.load(std::memory_order_relaxed);
+}
+
+uint64_t AudioDSPKernelProcessor::silentQuantaProcessed()
+{
+    return s_silentQuantaProcessed.load(std::memory_order_relaxed);
+}
+
+void AudioDSPKernelProcessor::resetSilenceStatistics()
+{
+    s_silentQuantaSkipped.store(0, std::memory_order_relaxed);
+    s_silentQuantaProcessed.store(0, std::memory_order_relaxed);
+}
+
+bool AudioDSPKernelProcessor::handleSilentQuantum(ContextRenderLock & r, const AudioBus * source, AudioBus * destination, size_t framesToProcess)
+{
+    if (!source->isSilent())
+    {
+        // Audible input re-arms the tail; an infinite tail never skips.
+        double tailSeconds = tailTime(r);
+        if (std::isinf(tailSeconds))
+            m_silentFlushFramesRemaining = static_cast<size_t>(-1);
+        else
+            m_silentFlushFramesRemaining = static_cast<size_t>(tailSeconds * r.context()->sampleRate());
+        return false;
+    }
+
+    if (!m_silentFlushFramesRemaining)
+    {
+        // The tail has fully drained; nothing the kernels could compute from
+        // zeros is audible.
+        destination->zero();
+        s_silentQuantaSkipped.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    m_silentFlushFramesRemaining -= std::min(m_silentFlushFramesRemaining, framesToProcess);
+    s_silentQuantaProcessed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
 // setNumberOfChannels() may later be called if the object is not yet in an "initialized" state.
 AudioDSPKernelProcessor::AudioDSPKernelProcessor(size_t numberOfChannels) : AudioProcessor(numberOfChannels), m_hasJustReset(true)
 {
@@ -53,10 +107,22 @@ void AudioDSPKernelProcessor::process(ContextRenderLock& r, const AudioBus* sour
     ASSERT(channelCountMatches);
     if (!channelCountMatches)
         return;
-        
+
+    if (handleSilentQuantum(r, source, destination, framesToProcess))
+        return;
+
     for (unsigned i = 0; i < m_kernels.size(); ++i)
+    {
+        // Pooled kernels sit adjacent in memory (see KernelStatePool), so
+        // warming the next kernel's state while this one runs hides the
+        // line fill on wide busses.
+#if defined(__GNUC__) || defined(__clang__)
+        if (i + 1 < m_kernels.size())
+            __builtin_prefetch(m_kernels[i + 1].get());
+#endif
         m_kernels[i]->process(r, source->channel(i)->data(),
                                  destination->channel(i)->mutableData(), framesToProcess);
+    }
 }
 
 // Resets filter state
@@ -0,0 +1,36 @@
+// License: BSD 3 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "internal/AudioDestination.h"
+
+#include <atomic>
+
+namespace lab
+{
+
+// The low-latency preference is process-wide state rather than a constructor
+// argument because platform destinations are created inside AudioContext
+// initialization, several layers away from application code.
+namespace
+{
+    std::atomic<bool> s_lowLatencyRequested{false};
+    std::atomic<unsigned int> s_preferredBufferFrames{0};
+}
+
+void AudioDestination::requestLowLatency(bool enable, unsigned int preferredBufferFrames)
+{
+    s_lowLatencyRequested.store(enable, std::memory_order_relaxed);
+    s_preferredBufferFrames.store(preferredBufferFrames, std::memory_order_relaxed);
+}
+
+bool AudioDestination::lowLatencyRequested()
+{
+    return s_lowLatencyRequested.load(std::memory_order_relaxed);
+}
+
+unsigned int AudioDestination::preferredBufferFrames()
+{
+    return s_preferredBufferFrames.load(std::memory_order_relaxed);
+}
+
+} // namespace lab
@@ -0,0 +1,202 @@
+// License: BSD 3 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "internal/AudioDestinationMirror.h"
+#include "internal/VectorMath.h"
+
+#include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioNode.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace lab {
+
+namespace {
+
+    // Largest single resample pass; longer device buffers are chunked.
+    const size_t InterleavedCapacityFrames = 4096;
+
+    // Largest rate trim the servo may apply (half a percent); enough to
+    // absorb real-world oscillator drift without audible pitch movement or
+    // pushing the sinc kernel's cutoff off the ratio it was built for.
+    const double MaxRateTrim = 0.005;
+}
+
+AudioDestinationMirror::AudioDestinationMirror(size_t numberOfChannels, float deviceSampleRate, float sourceSampleRate)
+    : m_channels(std::min<size_t>(numberOfChannels ? numberOfChannels : 1, SincResampler::MaxInterleavedChannels))
+{
+    // Half a second of source audio, rounded up to a power of two; deep
+    // enough that a scheduling hiccup on either side doesn't wrap the ring.
+    size_t minFrames = static_cast<size_t>(sourceSampleRate * 0.5f);
+    m_ringFrames = 1;
+    while (m_ringFrames < minFrames)
+        m_ringFrames <<= 1;
+
+    m_ring.resize(m_channels);
+    for (auto & channel : m_ring)
+        channel.allocate(m_ringFrames);
+
+    // Eight quanta of prebuffer (~21 ms at 48 kHz): the servo's midpoint,
+    // and the jitter margin between the two callback cadences.
+    m_targetFill = 8 * AudioNode::ProcessingSizeInFrames;
+
+    m_reader.mirror = this;
+
+    m_device.reset(AudioDestination::MakePlatformAudioDestination(*this, m_channels, deviceSampleRate));
+
+    float actualRate = m_device ? m_device->sampleRate() : deviceSampleRate;
+    m_nominalScale = actualRate > 0 ? double(sourceSampleRate) / double(actualRate) : 1.0;
+
+    m_resampler.reset(new SincResampler(m_nominalScale, 32, 32, static_cast<unsigned>(m_channels)));
+
+    m_interleaved.resize(InterleavedCapacityFrames * m_channels);
+}
+
+AudioDestinationMirror::~AudioDestinationMirror()
+{
+    stop();
+}
+
+void AudioDestinationMirror::start()
+{
+    if (m_device)
+        m_device->start();
+}
+
+void AudioDestinationMirror::stop()
+{
+    if (m_device)
+        m_device->stop();
+}
+
+void AudioDestinationMirror::pushRenderedQuantum(const AudioBus * bus, size_t framesToProcess)
+{
+    if (!bus || !framesToProcess || framesToProcess > m_ringFrames)
+        return;
+
+    uint64_t w = m_writeIndex.load(std::memory_order_relaxed);
+    uint64_t r = m_readIndex.load(std::memory_order_acquire);
+
+    if (w - r + framesToProcess > m_ringFrames)
+    {
+        // Ring full - the device clock has fallen behind (or the device is
+        // stopped). Drop the newest quantum; the servo catches mild drift
+        // long before this point.
+        m_overruns.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    size_t mask = m_ringFrames - 1;
+    size_t offset = static_cast<size_t>(w) & mask;
+    size_t first = std::min(framesToProcess, m_ringFrames - offset);
+    size_t sourceChannels = bus->numberOfChannels();
+
+    for (size_t c = 0; c < m_channels; ++c)
+    {
+        float * dest = m_ring[c].data();
+        if (c < sourceChannels)
+        {
+            const float * source = bus->channel(static_cast<unsigned>(c))->data();
+            memcpy(dest + offset, source, first * sizeof(float));
+            if (first < framesToProcess)
+                memcpy(dest, source + first, (framesToProcess - first) * sizeof(float));
+        }
+        else
+        {
+            memset(dest + offset, 0, first * sizeof(float));
+            if (first < framesToProcess)
+                memset(dest, 0, (framesToProcess - first) * sizeof(float));
+        }
+    }
+
+    m_writeIndex.store(w + framesToProcess, std::memory_order_release);
+}
+
+void AudioDestinationMirror::RingReader::provideInput(AudioBus * bus, size_t framesToProcess)
+{
+    mirror->readFromRing(bus, framesToProcess);
+}
+
+void AudioDestinationMirror::readFromRing(AudioBus * bus, size_t framesToProcess)
+{
+    uint64_t r = m_readIndex.load(std::memory_order_relaxed);
+    uint64_t w = m_writeIndex.load(std::memory_order_acquire);
+
+    size_t avail = static_cast<size_t>(std::min<uint64_t>(w - r, framesToProcess));
+    size_t mask = m_ringFrames - 1;
+    size_t offset = static_cast<size_t>(r) & mask;
+    size_t first = std::min(avail, m_ringFrames - offset);
+    size_t channels = std::min<size_t>(bus->numberOfChannels(), m_channels);
+
+    for (size_t c = 0; c < channels; ++c)
+    {
+        float * dest = bus->channel(static_cast<unsigned>(c))->mutableData();
+        const float * source = m_ring[c].data();
+        memcpy(dest, source + offset, first * sizeof(float));
+        if (first < avail)
+            memcpy(dest + first, source, (avail - first) * sizeof(float));
+        if (avail < framesToProcess)
+            memset(dest + avail, 0, (framesToProcess - avail) * sizeof(float));
+    }
+
+    m_readIndex.store(r + avail, std::memory_order_release);
+
+    if (avail < framesToProcess)
+    {
+        m_underruns.fetch_add(1, std::memory_order_relaxed);
+        m_primed = false;
+    }
+}
+
+void AudioDestinationMirror::render(AudioBus *, AudioBus * destinationBus, size_t framesToProcess)
+{
+    if (!destinationBus)
+        return;
+
+    if (destinationBus->numberOfChannels() < m_channels)
+    {
+        destinationBus->zero();
+        return;
+    }
+
+    uint64_t w = m_writeIndex.load(std::memory_order_acquire);
+    uint64_t r = m_readIndex.load(std::memory_order_relaxed);
+    uint64_t fill = w - r;
+
+    // Prebuffer gate: play silence until the ring holds the target fill, so
+    // a fresh (or just-underrun) stream starts with jitter margin in hand.
+    if (!m_primed)
+    {
+        if (fill < m_targetFill)
+        {
+            destinationBus->zero();
+            return;
+        }
+        m_primed = true;
+    }
+
+    // Servo the conversion ratio from the fill level: consuming slightly
+    // faster when the ring runs ahead and slower when it runs low absorbs
+    // the drift between the source's clock and this device's.
+    double deviation = (double(fill) - double(m_targetFill)) / double(m_targetFill);
+    if (deviation > 1.0) deviation = 1.0;
+    if (deviation < -1.0) deviation = -1.0;
+    m_resampler->setScaleFactor(m_nominalScale * (1.0 + MaxRateTrim * deviation));
+
+    size_t framesDone = 0;
+    while (framesDone < framesToProcess)
+    {
+        size_t n = std::min(framesToProcess - framesDone, InterleavedCapacityFrames);
+        m_resampler->process(&m_reader, m_interleaved.data(), n);
+
+        float * dests[SincResampler::MaxInterleavedChannels];
+        for (size_t c = 0; c < m_channels; ++c)
+            dests[c] = destinationBus->channel(static_cast<unsigned>(c))->mutableData() + framesDone;
+        VectorMath::vdeintlvem(m_interleaved.data(), dests, m_channels, n);
+
+        framesDone += n;
+    }
+}
+
+} // namespace lab
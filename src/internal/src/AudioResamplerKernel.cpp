@@ -8,6 +8,7 @@
 #include "internal/Assertions.h"
 
 #include <algorithm>
+#include <cstdint>
 
 using namespace std;
 
@@ -74,30 +75,41 @@ void AudioResamplerKernel::process(ContextRenderLock&, float* destination, size_
     ASSERT(framesToProcess > 0);
     ASSERT(virtualReadIndex >= 0 && 1 + static_cast<unsigned>(virtualReadIndex + (framesToProcess - 1) * rate) < m_sourceBuffer.size());
 
-    // Do the linear interpolation.
-    int n = framesToProcess;
-    while (n--) {
-        unsigned readIndex = static_cast<unsigned>(virtualReadIndex);
-        double interpolationFactor = virtualReadIndex - readIndex;
+    // Do the linear interpolation on a 32.32 fixed-point read position: the
+    // high word is the integer index and the low word the interpolation
+    // fraction, so each frame's position is one integer multiply-add off the
+    // loop counter and the body is branch-free - integer SIMD the compiler
+    // auto-vectorizes (the same scheme SampledAudioNode renders through).
+    // The step is truncated, never rounded up, so the accumulated position
+    // cannot pass the endpoint the source buffer was filled for.
+    const double kFixedScale = 4294967296.0;  // 2^32
+    const float kFracScale = static_cast<float>(1.0 / kFixedScale);
+
+    int64_t fixedReadIndex = static_cast<int64_t>(virtualReadIndex * kFixedScale);
+    int64_t fixedStep = static_cast<int64_t>(rate * kFixedScale);
 
-        double sample1 = source[readIndex];
-        double sample2 = source[readIndex + 1];
+    int n = framesToProcess;
+    for (int k = 0; k < n; ++k) {
+        int64_t p = fixedReadIndex + k * fixedStep;
+        unsigned readIndex = static_cast<unsigned>(p >> 32);
+        float interpolationFactor = static_cast<float>(static_cast<uint32_t>(p)) * kFracScale;
 
-        double sample = (1.0 - interpolationFactor) * sample1 + interpolationFactor * sample2;
+        float sample1 = source[readIndex];
+        float sample2 = source[readIndex + 1];
 
-        *destination++ = static_cast<float>(sample);
+        destination[k] = sample1 + interpolationFactor * (sample2 - sample1);
+    }
 
-        virtualReadIndex += rate;
-    }                        
+    fixedReadIndex += n * fixedStep;
 
     // Save the last two sample-frames which will later be used at the beginning of the source buffer the next time around.
-    int readIndex = static_cast<int>(virtualReadIndex);
+    unsigned readIndex = static_cast<unsigned>(fixedReadIndex >> 32);
     m_lastValues[0] = source[readIndex];
     m_lastValues[1] = source[readIndex + 1];
     m_fillIndex = 2;
 
     // Wrap the virtual read index back to the start of the buffer.
-    virtualReadIndex -= readIndex;
+    virtualReadIndex = static_cast<double>(fixedReadIndex) / kFixedScale - readIndex;
 
     // Put local copy back into member variable.
     m_virtualReadIndex = virtualReadIndex;
@@ -0,0 +1,200 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "internal/AudioThreads.h"
+
+#include <mutex>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <mach/thread_act.h>
+#include <mach/thread_policy.h>
+#include <pthread.h>
+#include <pthread/qos.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace lab {
+
+namespace {
+
+const int ThreadRoleCount = 4;
+
+std::mutex & policyMutex()
+{
+    static std::mutex m;
+    return m;
+}
+
+AudioContext::ThreadPolicy * policyTable()
+{
+    // The device callback defaults to the realtime class; everything else
+    // runs with whatever the platform scheduler assigns.
+    static AudioContext::ThreadPolicy policies[ThreadRoleCount];
+    static bool initialized = false;
+    if (!initialized)
+    {
+        policies[static_cast<int>(AudioContext::ThreadRole::DeviceCallback)].priority =
+            AudioContext::ThreadPolicy::PRIORITY_REALTIME;
+        initialized = true;
+    }
+    return policies;
+}
+
+void applyName(const char * name)
+{
+    if (!name || !name[0])
+        return;
+
+#if defined(_WIN32)
+    // SetThreadDescription is Windows 10+; resolve it dynamically so older
+    // systems simply skip naming.
+    typedef HRESULT(WINAPI * SetThreadDescriptionFn)(HANDLE, PCWSTR);
+    HMODULE kernel = GetModuleHandleA("kernel32.dll");
+    SetThreadDescriptionFn setDescription =
+        kernel ? reinterpret_cast<SetThreadDescriptionFn>(GetProcAddress(kernel, "SetThreadDescription")) : nullptr;
+    if (setDescription)
+    {
+        wchar_t wname[32];
+        size_t n = 0;
+        for (; name[n] && n < 31; ++n)
+            wname[n] = static_cast<wchar_t>(name[n]);
+        wname[n] = 0;
+        setDescription(GetCurrentThread(), wname);
+    }
+#elif defined(__APPLE__)
+    pthread_setname_np(name);
+#else
+    // Linux limits thread names to 15 characters plus the terminator.
+    char truncated[16];
+    size_t n = 0;
+    for (; name[n] && n < 15; ++n)
+        truncated[n] = name[n];
+    truncated[n] = 0;
+    pthread_setname_np(pthread_self(), truncated);
+#endif
+}
+
+void applyPriority(AudioContext::ThreadPolicy::Priority priority)
+{
+    if (priority == AudioContext::ThreadPolicy::PRIORITY_DEFAULT)
+        return;
+
+#if defined(_WIN32)
+    int winPriority = THREAD_PRIORITY_NORMAL;
+    switch (priority)
+    {
+        case AudioContext::ThreadPolicy::PRIORITY_BACKGROUND: winPriority = THREAD_PRIORITY_BELOW_NORMAL; break;
+        case AudioContext::ThreadPolicy::PRIORITY_ELEVATED: winPriority = THREAD_PRIORITY_ABOVE_NORMAL; break;
+        case AudioContext::ThreadPolicy::PRIORITY_REALTIME: winPriority = THREAD_PRIORITY_TIME_CRITICAL; break;
+        default: return;
+    }
+    SetThreadPriority(GetCurrentThread(), winPriority);
+#elif defined(__APPLE__)
+    if (priority == AudioContext::ThreadPolicy::PRIORITY_REALTIME)
+    {
+        // CoreAudio IO threads are already time-constrained; this covers
+        // engine-owned threads asked to run in the realtime class.
+        sched_param param = {};
+        int lo = sched_get_priority_min(SCHED_RR);
+        int hi = sched_get_priority_max(SCHED_RR);
+        param.sched_priority = lo + (hi - lo) / 2;
+        pthread_setschedparam(pthread_self(), SCHED_RR, &param);
+    }
+    else
+    {
+        pthread_set_qos_class_self_np(
+            priority == AudioContext::ThreadPolicy::PRIORITY_BACKGROUND ? QOS_CLASS_UTILITY
+                                                                        : QOS_CLASS_USER_INTERACTIVE,
+            0);
+    }
+#else
+    if (priority == AudioContext::ThreadPolicy::PRIORITY_REALTIME)
+    {
+        sched_param param = {};
+        int lo = sched_get_priority_min(SCHED_RR);
+        int hi = sched_get_priority_max(SCHED_RR);
+        param.sched_priority = lo + (hi - lo) / 2;
+        pthread_setschedparam(pthread_self(), SCHED_RR, &param);
+    }
+    else
+    {
+        // Nice values apply per thread on Linux.
+        int niceValue = priority == AudioContext::ThreadPolicy::PRIORITY_BACKGROUND ? 10 : -10;
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), niceValue);
+    }
+#endif
+}
+
+void applyAffinity(uint64_t affinityMask, int pinnedCore)
+{
+    if (pinnedCore < 0 && !affinityMask)
+        return;
+
+#if defined(_WIN32)
+    DWORD_PTR mask = pinnedCore >= 0 ? (DWORD_PTR(1) << pinnedCore) : static_cast<DWORD_PTR>(affinityMask);
+    if (mask)
+        SetThreadAffinityMask(GetCurrentThread(), mask);
+#elif defined(__APPLE__)
+    // macOS offers no strict pinning; the affinity tag is a hint that threads
+    // sharing a tag should share an L2. Derive a tag from the requested core.
+    int core = pinnedCore;
+    if (core < 0)
+        for (int i = 0; i < 64; ++i)
+            if (affinityMask & (uint64_t(1) << i)) { core = i; break; }
+    if (core >= 0)
+    {
+        thread_affinity_policy_data_t data = { core + 1 };
+        thread_policy_set(pthread_mach_thread_np(pthread_self()), THREAD_AFFINITY_POLICY,
+                          reinterpret_cast<thread_policy_t>(&data), THREAD_AFFINITY_POLICY_COUNT);
+    }
+#else
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    if (pinnedCore >= 0 && pinnedCore < CPU_SETSIZE)
+        CPU_SET(pinnedCore, &cpus);
+    else
+        for (int i = 0; i < 64 && i < CPU_SETSIZE; ++i)
+            if (affinityMask & (uint64_t(1) << i))
+                CPU_SET(i, &cpus);
+    if (CPU_COUNT(&cpus))
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+}
+
+}  // namespace
+
+void SetThreadPolicy(AudioContext::ThreadRole role, const AudioContext::ThreadPolicy & policy)
+{
+    int index = static_cast<int>(role);
+    if (index < 0 || index >= ThreadRoleCount)
+        return;
+    std::lock_guard<std::mutex> lock(policyMutex());
+    policyTable()[index] = policy;
+}
+
+AudioContext::ThreadPolicy GetThreadPolicy(AudioContext::ThreadRole role)
+{
+    int index = static_cast<int>(role);
+    if (index < 0 || index >= ThreadRoleCount)
+        return {};
+    std::lock_guard<std::mutex> lock(policyMutex());
+    return policyTable()[index];
+}
+
+void ApplyThreadPolicy(AudioContext::ThreadRole role, const char * name)
+{
+    AudioContext::ThreadPolicy policy = GetThreadPolicy(role);
+    applyName(name);
+    applyPriority(policy.priority);
+    applyAffinity(policy.affinityMask, policy.pinnedCore);
+}
+
+}  // namespace lab
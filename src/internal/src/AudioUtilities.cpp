@@ -34,6 +34,25 @@ size_t timeToSampleFrame(double time, double sampleRate)
     ASSERT(time >= 0);
     return static_cast<size_t>(round(time * sampleRate));
 }
+
+float fastAcos(float x)
+{
+    // The polynomial is only valid on [0, 1]; mirror for negative inputs
+    // with acos(-x) = pi - acos(x). Clamp to guard against dot products
+    // drifting just outside [-1, 1] from rounding.
+    bool negate = x < 0.f;
+    x = fabsf(x);
+    if (x > 1.f)
+        x = 1.f;
+
+    float result = -0.0187293f;
+    result = result * x + 0.0742610f;
+    result = result * x - 0.2121144f;
+    result = result * x + 1.5707288f;
+    result *= sqrtf(1.f - x);
+
+    return negate ? 3.14159265358979f - result : result;
+}
     
 } } // end AudioUtilites & lab
 
@@ -14,6 +14,10 @@
 #include <Accelerate/Accelerate.h>
 #endif
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 using namespace std;
 
 namespace lab {
@@ -28,6 +32,10 @@ Biquad::Biquad()
     m_outputBuffer.allocate(kBufferSize + 2);
 #endif
 
+    m_rampEnabled = false;
+    m_rampPending = false;
+    m_tb0 = m_tb1 = m_tb2 = m_ta1 = m_ta2 = 0;
+
     // Initialize as pass-thru (straight-wire, no filter effect)
     setNormalizedCoefficients(1, 0, 0, 1, 0, 0);
 
@@ -59,7 +67,44 @@ void Biquad::process(const float* sourceP, float* destP, size_t framesToProcess)
     double a1 = m_a1;
     double a2 = m_a2;
 
-    while (n--) {
+    if (m_rampPending && n) {
+        // Move the coefficients linearly from their current values to the armed
+        // targets across this quantum; the design ran once at control rate and
+        // the per-sample cost here is five additions.
+        double step = 1.0 / n;
+        double db0 = (m_tb0 - b0) * step;
+        double db1 = (m_tb1 - b1) * step;
+        double db2 = (m_tb2 - b2) * step;
+        double da1 = (m_ta1 - a1) * step;
+        double da2 = (m_ta2 - a2) * step;
+
+        while (n--) {
+            b0 += db0;
+            b1 += db1;
+            b2 += db2;
+            a1 += da1;
+            a2 += da2;
+
+            float x = *sourceP++;
+            float y = static_cast<float>(b0*x + b1*x1 + b2*x2 - a1*y1 - a2*y2);
+
+            *destP++ = y;
+
+            // Update state variables
+            x2 = x1;
+            x1 = x;
+            y2 = y1;
+            y1 = y;
+        }
+
+        // Land exactly on the designed coefficients.
+        b0 = m_tb0;
+        b1 = m_tb1;
+        b2 = m_tb2;
+        a1 = m_ta1;
+        a2 = m_ta2;
+        m_rampPending = false;
+    } else while (n--) {
         // FIXME: this can be optimized by pipelining the multiply adds...
         float x = *sourceP++;
         float y = static_cast<float>(b0*x + b1*x1 + b2*x2 - a1*y1 - a2*y2);
@@ -88,6 +133,146 @@ void Biquad::process(const float* sourceP, float* destP, size_t framesToProcess)
 #endif
 }
 
+void Biquad::processChannels(Biquad* const* filters, const float* const* sources, float* const* dests, size_t numberOfChannels, size_t framesToProcess)
+{
+    size_t ch = 0;
+
+#if defined(__SSE2__) && !defined(LABSOUND_PLATFORM_OSX)
+    // Two channels ride the two lanes of each double vector. Coefficients and
+    // state are per-lane, so the channels are fully independent.
+    for (; ch + 2 <= numberOfChannels; ch += 2)
+    {
+        Biquad* f0 = filters[ch];
+        Biquad* f1 = filters[ch + 1];
+
+        __m128d b0 = _mm_set_pd(f1->m_b0, f0->m_b0);
+        __m128d b1 = _mm_set_pd(f1->m_b1, f0->m_b1);
+        __m128d b2 = _mm_set_pd(f1->m_b2, f0->m_b2);
+        __m128d a1 = _mm_set_pd(f1->m_a1, f0->m_a1);
+        __m128d a2 = _mm_set_pd(f1->m_a2, f0->m_a2);
+
+        __m128d x1 = _mm_set_pd(f1->m_x1, f0->m_x1);
+        __m128d x2 = _mm_set_pd(f1->m_x2, f0->m_x2);
+        __m128d y1 = _mm_set_pd(f1->m_y1, f0->m_y1);
+        __m128d y2 = _mm_set_pd(f1->m_y2, f0->m_y2);
+
+        const float* s0 = sources[ch];
+        const float* s1 = sources[ch + 1];
+        float* d0 = dests[ch];
+        float* d1 = dests[ch + 1];
+
+        bool ramping = (f0->m_rampPending || f1->m_rampPending) && framesToProcess;
+        if (ramping)
+        {
+            // Per-lane coefficient ramps matching the scalar ramp; a lane with
+            // no pending ramp targets its own current values, so its deltas are
+            // exactly zero.
+            __m128d step = _mm_set1_pd(1.0 / framesToProcess);
+            __m128d db0 = _mm_mul_pd(_mm_sub_pd(_mm_set_pd(f1->m_rampPending ? f1->m_tb0 : f1->m_b0, f0->m_rampPending ? f0->m_tb0 : f0->m_b0), b0), step);
+            __m128d db1 = _mm_mul_pd(_mm_sub_pd(_mm_set_pd(f1->m_rampPending ? f1->m_tb1 : f1->m_b1, f0->m_rampPending ? f0->m_tb1 : f0->m_b1), b1), step);
+            __m128d db2 = _mm_mul_pd(_mm_sub_pd(_mm_set_pd(f1->m_rampPending ? f1->m_tb2 : f1->m_b2, f0->m_rampPending ? f0->m_tb2 : f0->m_b2), b2), step);
+            __m128d da1 = _mm_mul_pd(_mm_sub_pd(_mm_set_pd(f1->m_rampPending ? f1->m_ta1 : f1->m_a1, f0->m_rampPending ? f0->m_ta1 : f0->m_a1), a1), step);
+            __m128d da2 = _mm_mul_pd(_mm_sub_pd(_mm_set_pd(f1->m_rampPending ? f1->m_ta2 : f1->m_a2, f0->m_rampPending ? f0->m_ta2 : f0->m_a2), a2), step);
+
+            for (size_t i = 0; i < framesToProcess; ++i)
+            {
+                b0 = _mm_add_pd(b0, db0);
+                b1 = _mm_add_pd(b1, db1);
+                b2 = _mm_add_pd(b2, db2);
+                a1 = _mm_add_pd(a1, da1);
+                a2 = _mm_add_pd(a2, da2);
+
+                __m128d x = _mm_set_pd(static_cast<double>(s1[i]), static_cast<double>(s0[i]));
+
+                __m128d y = _mm_mul_pd(b0, x);
+                y = _mm_add_pd(y, _mm_mul_pd(b1, x1));
+                y = _mm_add_pd(y, _mm_mul_pd(b2, x2));
+                y = _mm_sub_pd(y, _mm_mul_pd(a1, y1));
+                y = _mm_sub_pd(y, _mm_mul_pd(a2, y2));
+
+                // round through float so the fed-back state matches the scalar path exactly
+                __m128 yf = _mm_cvtpd_ps(y);
+                y = _mm_cvtps_pd(yf);
+
+                float out[4];
+                _mm_storeu_ps(out, yf);
+                d0[i] = out[0];
+                d1[i] = out[1];
+
+                x2 = x1;
+                x1 = x;
+                y2 = y1;
+                y1 = y;
+            }
+
+            // Land the ramped filters exactly on their designed coefficients.
+            // The coefficient vectors are otherwise never written back, so only
+            // ramped lanes change their filters here.
+            if (f0->m_rampPending)
+            {
+                f0->m_b0 = f0->m_tb0;
+                f0->m_b1 = f0->m_tb1;
+                f0->m_b2 = f0->m_tb2;
+                f0->m_a1 = f0->m_ta1;
+                f0->m_a2 = f0->m_ta2;
+                f0->m_rampPending = false;
+            }
+            if (f1->m_rampPending)
+            {
+                f1->m_b0 = f1->m_tb0;
+                f1->m_b1 = f1->m_tb1;
+                f1->m_b2 = f1->m_tb2;
+                f1->m_a1 = f1->m_ta1;
+                f1->m_a2 = f1->m_ta2;
+                f1->m_rampPending = false;
+            }
+        }
+        else for (size_t i = 0; i < framesToProcess; ++i)
+        {
+            __m128d x = _mm_set_pd(static_cast<double>(s1[i]), static_cast<double>(s0[i]));
+
+            __m128d y = _mm_mul_pd(b0, x);
+            y = _mm_add_pd(y, _mm_mul_pd(b1, x1));
+            y = _mm_add_pd(y, _mm_mul_pd(b2, x2));
+            y = _mm_sub_pd(y, _mm_mul_pd(a1, y1));
+            y = _mm_sub_pd(y, _mm_mul_pd(a2, y2));
+
+            // round through float so the fed-back state matches the scalar path exactly
+            __m128 yf = _mm_cvtpd_ps(y);
+            y = _mm_cvtps_pd(yf);
+
+            float out[4];
+            _mm_storeu_ps(out, yf);
+            d0[i] = out[0];
+            d1[i] = out[1];
+
+            x2 = x1;
+            x1 = x;
+            y2 = y1;
+            y1 = y;
+        }
+
+        double state[2];
+        _mm_storeu_pd(state, x1);
+        f0->m_x1 = DenormalDisabler::flushDenormalFloatToZero(static_cast<float>(state[0]));
+        f1->m_x1 = DenormalDisabler::flushDenormalFloatToZero(static_cast<float>(state[1]));
+        _mm_storeu_pd(state, x2);
+        f0->m_x2 = DenormalDisabler::flushDenormalFloatToZero(static_cast<float>(state[0]));
+        f1->m_x2 = DenormalDisabler::flushDenormalFloatToZero(static_cast<float>(state[1]));
+        _mm_storeu_pd(state, y1);
+        f0->m_y1 = DenormalDisabler::flushDenormalFloatToZero(static_cast<float>(state[0]));
+        f1->m_y1 = DenormalDisabler::flushDenormalFloatToZero(static_cast<float>(state[1]));
+        _mm_storeu_pd(state, y2);
+        f0->m_y2 = DenormalDisabler::flushDenormalFloatToZero(static_cast<float>(state[0]));
+        f1->m_y2 = DenormalDisabler::flushDenormalFloatToZero(static_cast<float>(state[1]));
+    }
+#endif
+
+    // odd channel, or no SIMD available
+    for (; ch < numberOfChannels; ++ch)
+        filters[ch]->process(sources[ch], dests[ch], framesToProcess);
+}
+
 #if defined(LABSOUND_PLATFORM_OSX)
 
 // Here we have optimized version using Accelerate.framework
@@ -239,13 +424,43 @@ void Biquad::setHighpassParams(double cutoff, double resonance)
 void Biquad::setNormalizedCoefficients(double b0, double b1, double b2, double a0, double a1, double a2)
 {
     double a0Inverse = 1 / a0;
-    
+
+#if !defined(LABSOUND_PLATFORM_OSX)
+    if (m_rampEnabled) {
+        // Defer: the next process() call ramps to these values per-sample.
+        m_tb0 = b0 * a0Inverse;
+        m_tb1 = b1 * a0Inverse;
+        m_tb2 = b2 * a0Inverse;
+        m_ta1 = a1 * a0Inverse;
+        m_ta2 = a2 * a0Inverse;
+        m_rampPending = true;
+        return;
+    }
+#endif
+
     m_b0 = b0 * a0Inverse;
     m_b1 = b1 * a0Inverse;
     m_b2 = b2 * a0Inverse;
     m_a1 = a1 * a0Inverse;
     m_a2 = a2 * a0Inverse;
+    m_rampPending = false;
+}
 
+void Biquad::copyCoefficientsFrom(const Biquad& other)
+{
+    m_b0 = other.m_b0;
+    m_b1 = other.m_b1;
+    m_b2 = other.m_b2;
+    m_a1 = other.m_a1;
+    m_a2 = other.m_a2;
+
+    m_tb0 = other.m_tb0;
+    m_tb1 = other.m_tb1;
+    m_tb2 = other.m_tb2;
+    m_ta1 = other.m_ta1;
+    m_ta2 = other.m_ta2;
+    m_rampEnabled = other.m_rampEnabled;
+    m_rampPending = other.m_rampPending;
 }
 
 void Biquad::setLowShelfParams(double frequency, double dbGain)
@@ -483,6 +698,14 @@ void Biquad::setZeroPolePairs(const complex<double> &zero, const complex<double>
     setNormalizedCoefficients(b0, b1, b2, 1, a1, a2);
 }
 
+void Biquad::setZeroPoleParams(double zero, double pole)
+{
+    // Gain compensation to make 0dB @ 0Hz
+    const double k1 = 1 / (1 - zero);
+    const double k2 = 1 - pole;
+    setNormalizedCoefficients(k1 * k2, -k1 * k2 * zero, 0, 1, -pole, 0);
+}
+
 void Biquad::setAllpassPole(const complex<double> &pole)
 {
     complex<double> zero = complex<double>(1, 0) / pole;
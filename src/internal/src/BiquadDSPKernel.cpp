@@ -20,6 +20,12 @@ static const double MaxBiquadDelayTime = 0.2;
 void BiquadDSPKernel::updateCoefficientsIfNecessary(ContextRenderLock& r, bool useSmoothing, bool forceUpdate)
 {
     if (forceUpdate || biquadProcessor()->filterCoefficientsDirty()) {
+        // Smoothed updates glide: the freshly designed coefficients become a
+        // per-sample ramp inside Biquad rather than a step at the quantum
+        // boundary. Forced updates (frequency response) snap to the exact
+        // target values.
+        m_biquad.setCoefficientRampEnabled(useSmoothing);
+
         double value1;
         double value2;
         double gain;
@@ -95,8 +101,8 @@ void BiquadDSPKernel::process(ContextRenderLock& r, const float* source, float*
     ASSERT(source && destination && biquadProcessor());
     
     // Recompute filter coefficients if any of the parameters have changed.
-    // FIXME: as an optimization, implement a way that a Biquad object can simply copy its internal filter coefficients from another Biquad object.
-    // Then re-factor this code to only run for the first BiquadDSPKernel of each BiquadProcessor.
+    // BiquadProcessor's batched path designs once and copies the coefficients
+    // between kernels; this runs when channels are processed individually.
 
     updateCoefficientsIfNecessary(r, true, false);
 
@@ -5,6 +5,8 @@
 #include "internal/BiquadProcessor.h"
 #include "internal/BiquadDSPKernel.h"
 
+#include "LabSound/core/AudioBus.h"
+
 namespace lab {
     
 BiquadProcessor::BiquadProcessor(size_t numberOfChannels, bool autoInitialize) : AudioDSPKernelProcessor(numberOfChannels),
@@ -72,9 +74,42 @@ void BiquadProcessor::process(ContextRenderLock& r, const AudioBus* source, Audi
         destination->zero();
         return;
     }
-        
+
+    if (handleSilentQuantum(r, source, destination, framesToProcess))
+        return;
+
     checkForDirtyCoefficients(r);
-            
+
+    // Multichannel filters run all channels in parallel SIMD lanes; the common
+    // stereo case halves the per-sample recurrence cost.
+    const size_t kMaxBatchedChannels = 8;
+    size_t channels = m_kernels.size();
+    if (channels >= 2 && channels <= kMaxBatchedChannels
+        && source->numberOfChannels() >= channels && destination->numberOfChannels() >= channels)
+    {
+        Biquad* filters[kMaxBatchedChannels];
+        const float* sources[kMaxBatchedChannels];
+        float* dests[kMaxBatchedChannels];
+
+        // Every kernel of a processor filters with the same parameters, so the
+        // coefficient design (trig and all) runs once on the first kernel and
+        // the siblings copy the result.
+        BiquadDSPKernel* firstKernel = static_cast<BiquadDSPKernel*>(m_kernels[0].get());
+        firstKernel->updateCoefficients(r);
+
+        for (unsigned i = 0; i < channels; ++i) {
+            BiquadDSPKernel* kernel = static_cast<BiquadDSPKernel*>(m_kernels[i].get());
+            if (i)
+                kernel->biquad().copyCoefficientsFrom(firstKernel->biquad());
+            filters[i] = &kernel->biquad();
+            sources[i] = source->channel(i)->data();
+            dests[i] = destination->channel(i)->mutableData();
+        }
+
+        Biquad::processChannels(filters, sources, dests, channels, framesToProcess);
+        return;
+    }
+
     // For each channel of our input, process using the corresponding BiquadDSPKernel into the output channel.
     for (unsigned i = 0; i < m_kernels.size(); ++i) {
         m_kernels[i]->process(r, source->channel(i)->data(), destination->channel(i)->mutableData(), framesToProcess);
@@ -0,0 +1,224 @@
+// License: BSD 3 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "internal/ConvolutionWorkerPool.h"
+#include "internal/AudioThreads.h"
+#include "internal/DenormalDisabler.h"
+#include "internal/ReverbConvolver.h"
+
+#include "LabSound/core/TraceRecorder.h"
+
+#include <algorithm>
+
+namespace lab {
+
+ConvolutionWorkerPool& ConvolutionWorkerPool::shared()
+{
+    static ConvolutionWorkerPool pool;
+    return pool;
+}
+
+ConvolutionWorkerPool::ConvolutionWorkerPool()
+{
+    unsigned int hw = std::thread::hardware_concurrency();
+    size_t count = std::min<size_t>(hw > 2 ? hw / 2 : 1, 8);
+
+    for (size_t i = 0; i < count; ++i)
+        m_workers.emplace_back(&ConvolutionWorkerPool::workerLoop, this);
+}
+
+ConvolutionWorkerPool::~ConvolutionWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_shouldExit = true;
+    }
+    m_wake.notify_all();
+
+    for (auto & w : m_workers)
+    {
+        if (w.joinable())
+            w.join();
+    }
+}
+
+void ConvolutionWorkerPool::addClient(ReverbConvolver* convolver)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_clients.emplace_back(new Client(convolver));
+}
+
+void ConvolutionWorkerPool::removeClient(ReverbConvolver* convolver)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (auto it = m_clients.begin(); it != m_clients.end(); ++it)
+    {
+        if ((*it)->convolver == convolver)
+        {
+            // wait for any in-flight servicing of this convolver to finish
+            Client* client = it->get();
+            m_idle.wait(lock, [client]() { return !client->busy.load(); });
+            m_clients.erase(it);
+            return;
+        }
+    }
+}
+
+void ConvolutionWorkerPool::signalMoreInput()
+{
+    m_inputEpoch.fetch_add(1, std::memory_order_release);
+
+    // A tryLock() keeps the real-time thread from ever blocking here. Missing a
+    // signal occasionally is fine; we're called every render quantum and the
+    // background stages process well into the future.
+    if (m_mutex.try_lock())
+    {
+        m_mutex.unlock();
+        m_wake.notify_all();
+    }
+}
+
+void ConvolutionWorkerPool::enqueueTask(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_wake.notify_one();
+}
+
+void ConvolutionWorkerPool::runParallel(const ConvolutionJob * jobs, size_t count)
+{
+    if (!count)
+        return;
+
+    auto runJob = [](const ConvolutionJob & job) {
+        job.convolver->process(*job.r, job.source, job.destination, job.framesToProcess);
+    };
+
+    if (count == 1 || m_workers.empty())
+    {
+        for (size_t i = 0; i < count; ++i)
+            runJob(jobs[i]);
+        return;
+    }
+
+    // One batch in flight at a time; concurrent renderers queue here.
+    std::lock_guard<std::mutex> fork(m_forkMutex);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs = jobs;
+        m_jobCount.store(count, std::memory_order_relaxed);
+        m_jobCursor.store(0, std::memory_order_relaxed);
+        m_jobsRemaining.store(count, std::memory_order_release);
+    }
+    m_wake.notify_all();
+
+    // Take a share on this thread, then wait for any straggling workers.
+    runPendingJobs();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_jobsDone.wait(lock, [this]() { return m_jobsRemaining.load(std::memory_order_acquire) == 0; });
+    m_jobCount.store(0, std::memory_order_relaxed);
+    m_jobs = nullptr;
+}
+
+void ConvolutionWorkerPool::runPendingJobs()
+{
+    for (;;)
+    {
+        size_t index = m_jobCursor.fetch_add(1, std::memory_order_acq_rel);
+        if (index >= m_jobCount.load(std::memory_order_acquire))
+            return;
+
+        m_jobs[index].convolver->process(*m_jobs[index].r, m_jobs[index].source,
+                                         m_jobs[index].destination, m_jobs[index].framesToProcess);
+
+        if (m_jobsRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            // Last job in the batch; wake the joining thread. Taking the lock
+            // orders the notify against the waiter's predicate check.
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobsDone.notify_all();
+        }
+    }
+}
+
+void ConvolutionWorkerPool::workerLoop()
+{
+    ApplyThreadPolicy(AudioContext::ThreadRole::Background, "convolution");
+
+    // Reverb tails decay straight into the denormal range; keep FTZ/DAZ set
+    // for this worker's lifetime just as the render threads do.
+    DenormalDisabler denormalDisabler;
+
+    uint64_t seenEpoch = 0;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this, seenEpoch]() {
+                return m_shouldExit || m_inputEpoch.load(std::memory_order_acquire) != seenEpoch
+                    || m_jobCursor.load(std::memory_order_relaxed) < m_jobCount.load(std::memory_order_relaxed)
+                    || !m_tasks.empty();
+            });
+
+            if (m_shouldExit)
+                return;
+
+            seenEpoch = m_inputEpoch.load(std::memory_order_acquire);
+        }
+
+        // Forked quantum work first; the joining render thread is waiting on it.
+        runPendingJobs();
+
+        // One-shot tasks next. Each is popped under the lock and run outside
+        // it, so other workers keep servicing convolvers while a long prepare
+        // (e.g. impulse partitioning) runs here.
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_tasks.empty())
+                    break;
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            TraceSpan span(TraceRecorder::Category::Worker, "convolution task");
+            task();
+        }
+
+        // Service every convolver that isn't already being drained by another worker.
+        size_t i = 0;
+        for (;;)
+        {
+            ReverbConvolver* convolver = nullptr;
+            Client* client = nullptr;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (i >= m_clients.size())
+                    break;
+
+                client = m_clients[i].get();
+                if (!client->busy.exchange(true))
+                    convolver = client->convolver;
+                ++i;
+            }
+
+            if (convolver)
+            {
+                TraceSpan span(TraceRecorder::Category::Worker, "convolver drain");
+                convolver->drainBackgroundWork();
+
+                client->busy.store(false);
+                m_idle.notify_all();
+            }
+        }
+    }
+}
+
+} // namespace lab
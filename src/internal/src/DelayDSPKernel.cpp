@@ -9,6 +9,8 @@
 #include "internal/Assertions.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 
 using namespace std;
 
@@ -16,6 +18,11 @@ namespace lab {
 
 const float SmoothingTimeConstant = 0.020f; // 20ms
 
+// Length of the dual-head crossfade used in crossfade-on-change mode; short
+// enough to fit well inside one bar at any sane tempo, long enough to be
+// click-free.
+const double CrossfadeSeconds = 0.050;
+
 DelayDSPKernel::DelayDSPKernel( DelayProcessor * processor, float sampleRate) : AudioDSPKernel(processor)
     , m_writeIndex(0)
     , m_firstTime(true)
@@ -56,8 +63,15 @@ DelayDSPKernel::DelayDSPKernel(double maxDelayTime, float sampleRate) : AudioDSP
 size_t DelayDSPKernel::bufferLengthForDelay(double maxDelayTime, double sampleRate) const
 {
     // Compute the length of the buffer needed to handle a max delay of |maxDelayTime|. One is
-    // added to handle the case where the actual delay equals the maximum delay.
-    return 1 + AudioUtilities::timeToSampleFrame(maxDelayTime, sampleRate);
+    // added to handle the case where the actual delay equals the maximum delay. The length is
+    // then rounded up to a power of two so the ring can wrap with a mask instead of a modulo.
+    size_t length = 1 + AudioUtilities::timeToSampleFrame(maxDelayTime, sampleRate);
+
+    size_t powerOfTwo = 1;
+    while (powerOfTwo < length)
+        powerOfTwo <<= 1;
+
+    return powerOfTwo;
 }
 
 void DelayDSPKernel::process(ContextRenderLock& r, const float* source, float* destination, size_t framesToProcess)
@@ -95,6 +109,162 @@ void DelayDSPKernel::process(ContextRenderLock& r, const float* source, float* d
         }
     }
 
+    // bufferLengthForDelay() rounds the ring up to a power of two.
+    const size_t indexMask = bufferLength - 1;
+    size_t writeIndex = static_cast<size_t>(m_writeIndex);
+
+    bool crossfadeMode = !sampleAccurate && delayProcessor() && delayProcessor()->crossfadeOnDelayChange();
+
+    if (crossfadeMode)
+    {
+        if (delayTime != m_currentDelayTime)
+        {
+            // New target: hold the outgoing head at the current delay and
+            // fade in a second head at the new one. If a fade is already
+            // running, its incoming head becomes the outgoing head - the
+            // fade window is far shorter than any per-bar tempo automation,
+            // so back-to-back retargets are rare.
+            m_crossfadeFromDelay = m_currentDelayTime;
+            m_currentDelayTime = delayTime;
+            m_crossfadePosition = 0;
+            m_crossfadeStep = 1.0 / (CrossfadeSeconds * sampleRate);
+            m_crossfading = true;
+        }
+    }
+    else
+    {
+        // A sample-accurate automation or a mode switch supersedes any fade
+        // in flight.
+        m_crossfading = false;
+
+        // Once the smoothing filter has settled to within a thousandth of a
+        // frame of the target, snap to it so the fast path below can engage.
+        if (!sampleAccurate && fabs(delayTime - m_currentDelayTime) * sampleRate < 0.001)
+            m_currentDelayTime = delayTime;
+    }
+
+    // Write the entire input block up front, wrapping at most once. For delays
+    // of a frame or more this is identical to interleaving writes with reads,
+    // and it frees the read side to process the whole block at once.
+    if (framesToProcess <= bufferLength)
+    {
+        size_t framesToEnd = bufferLength - writeIndex;
+        if (framesToProcess <= framesToEnd)
+        {
+            memcpy(buffer + writeIndex, source, sizeof(float) * framesToProcess);
+        }
+        else
+        {
+            memcpy(buffer + writeIndex, source, sizeof(float) * framesToEnd);
+            memcpy(buffer, source + framesToEnd, sizeof(float) * (framesToProcess - framesToEnd));
+        }
+
+        if (!sampleAccurate && !m_crossfading && m_currentDelayTime == delayTime)
+        {
+            double desiredDelayFrames = m_currentDelayTime * sampleRate;
+            double integerDelayFrames = floor(desiredDelayFrames + 0.5);
+
+            if (fabs(desiredDelayFrames - integerDelayFrames) < 1e-6)
+            {
+                // Fixed whole-frame delay: the block reduces to two memcpys.
+                size_t delayFrames = static_cast<size_t>(integerDelayFrames);
+                size_t readIndex = (writeIndex + bufferLength - delayFrames) & indexMask;
+
+                framesToEnd = bufferLength - readIndex;
+                if (framesToProcess <= framesToEnd)
+                {
+                    memcpy(destination, buffer + readIndex, sizeof(float) * framesToProcess);
+                }
+                else
+                {
+                    memcpy(destination, buffer + readIndex, sizeof(float) * framesToEnd);
+                    memcpy(destination + framesToEnd, buffer, sizeof(float) * (framesToProcess - framesToEnd));
+                }
+
+                m_writeIndex = static_cast<int>((writeIndex + framesToProcess) & indexMask);
+                return;
+            }
+        }
+
+        // Interpolated read of one head at a fixed offset from the write
+        // position; readPosition already includes + bufferLength so the mask
+        // handles the wrap.
+        auto readHead = [buffer, indexMask](double readPosition) -> float
+        {
+            size_t readIndex1 = static_cast<size_t>(readPosition) & indexMask;
+            size_t readIndex2 = (readIndex1 + 1) & indexMask;
+            float interpolationFactor = static_cast<float>(readPosition - floor(readPosition));
+
+            float sample1 = buffer[readIndex1];
+            float sample2 = buffer[readIndex2];
+            return sample1 + interpolationFactor * (sample2 - sample1);
+        };
+
+        if (m_crossfading)
+        {
+            // Tempo transition: both heads sit at fixed delays inside the
+            // ring and an equal-power blend hands the signal from the old
+            // delay to the new one. No pitch glide, no allocation; the
+            // sin/cos only runs for the fade window's duration.
+            double fromDelayFrames = m_crossfadeFromDelay * sampleRate;
+            double toDelayFrames = m_currentDelayTime * sampleRate;
+
+            for (unsigned i = 0; i < framesToProcess; ++i)
+            {
+                double basePosition = double(writeIndex + i + bufferLength);
+                float fromSample = readHead(basePosition - fromDelayFrames);
+                float toSample = readHead(basePosition - toDelayFrames);
+
+                float t = static_cast<float>(std::min(1.0, m_crossfadePosition));
+                const float halfPi = 1.57079632679f;
+                destination[i] = cosf(halfPi * t) * fromSample + sinf(halfPi * t) * toSample;
+
+                m_crossfadePosition += m_crossfadeStep;
+                if (m_crossfadePosition >= 1.0)
+                {
+                    m_crossfading = false;
+
+                    // Fade complete mid-block: the incoming head carries on
+                    // alone.
+                    for (unsigned j = i + 1; j < framesToProcess; ++j)
+                        destination[j] = readHead(double(writeIndex + j + bufferLength) - toDelayFrames);
+                    break;
+                }
+            }
+
+            m_writeIndex = static_cast<int>((writeIndex + framesToProcess) & indexMask);
+            return;
+        }
+
+        // Fractional or modulated delay: branch-free lerp with masked
+        // wraparound; no modulo and no per-sample write bookkeeping.
+        for (unsigned i = 0; i < framesToProcess; ++i)
+        {
+            if (sampleAccurate)
+            {
+                delayTime = delayTimes[i];
+                delayTime = std::min(maxTime, delayTime);
+                delayTime = std::max(0.0, delayTime);
+                m_currentDelayTime = delayTime;
+            }
+            else
+            {
+                // Approach desired delay time.
+                m_currentDelayTime += (delayTime - m_currentDelayTime) * m_smoothingRate;
+            }
+
+            double desiredDelayFrames = m_currentDelayTime * sampleRate;
+            double readPosition = writeIndex + i + bufferLength - desiredDelayFrames;
+
+            destination[i] = readHead(readPosition);
+        }
+
+        m_writeIndex = static_cast<int>((writeIndex + framesToProcess) & indexMask);
+        return;
+    }
+
+    // Degenerate case: the ring is shorter than one render quantum (a very
+    // small maxDelayTime). Keep the original interleaved per-sample loop.
     for (unsigned i = 0; i < framesToProcess; ++i) {
         if (sampleAccurate) {
             delayTime = delayTimes[i];
@@ -113,13 +283,12 @@ void DelayDSPKernel::process(ContextRenderLock& r, const float* source, float* d
             readPosition -= bufferLength;
 
         // Linearly interpolate in-between delay times.
-        int readIndex1 = static_cast<int>(readPosition);
-        int readIndex2 = (readIndex1 + 1) % bufferLength;
-        double interpolationFactor = readPosition - readIndex1;
+        size_t readIndex1 = static_cast<size_t>(readPosition) & indexMask;
+        size_t readIndex2 = (readIndex1 + 1) & indexMask;
+        double interpolationFactor = readPosition - floor(readPosition);
 
-        double input = static_cast<float>(*source++);
-        buffer[m_writeIndex] = static_cast<float>(input);
-        m_writeIndex = (m_writeIndex + 1) % bufferLength;
+        buffer[m_writeIndex] = *source++;
+        m_writeIndex = static_cast<int>((m_writeIndex + 1) & indexMask);
 
         double sample1 = buffer[readIndex1];
         double sample2 = buffer[readIndex2];
@@ -133,6 +302,7 @@ void DelayDSPKernel::process(ContextRenderLock& r, const float* source, float* d
 void DelayDSPKernel::reset()
 {
     m_firstTime = true;
+    m_crossfading = false;
     m_buffer.zero();
 }
 
@@ -154,17 +154,21 @@ void DynamicsCompressor::process(ContextRenderLock& r, const AudioBus* sourceBus
     }
 
     // Apply pre-emphasis filter.
-    // Note that the final three stages are computed in-place in the destination buffer.
-    for (unsigned i = 0; i < numberOfChannels; ++i)
+    // Each cascade stage runs across all channels at once so the biquad engine
+    // can pack channels into SIMD lanes; the final three stages are computed
+    // in-place in the destination buffer.
+    const unsigned MaxChannels = 8;
+    ASSERT(numberOfChannels <= MaxChannels);
+
+    ZeroPole* stageFilters[MaxChannels];
+
+    for (unsigned stageIndex = 0; stageIndex < 4; ++stageIndex)
     {
-        const float* sourceData = m_sourceChannels[i];
-        float* destinationData = m_destinationChannels[i];
-        ZeroPole* preFilters = m_preFilterPacks[i]->filters;
-
-        preFilters[0].process(sourceData, destinationData, framesToProcess);
-        preFilters[1].process(destinationData, destinationData, framesToProcess);
-        preFilters[2].process(destinationData, destinationData, framesToProcess);
-        preFilters[3].process(destinationData, destinationData, framesToProcess);
+        for (unsigned i = 0; i < numberOfChannels; ++i)
+            stageFilters[i] = &m_preFilterPacks[i]->filters[stageIndex];
+
+        const float* const* sources = stageIndex ? const_cast<const float* const*>(m_destinationChannels.get()) : m_sourceChannels.get();
+        ZeroPole::processChannels(stageFilters, sources, m_destinationChannels.get(), numberOfChannels, framesToProcess);
     }
 
     float dbThreshold = parameterValue(ParamThreshold);
@@ -212,16 +216,13 @@ void DynamicsCompressor::process(ContextRenderLock& r, const AudioBus* sourceBus
     // Update the compression amount.                     
     setParameterValue(ParamReduction, m_compressor.meteringGain());
 
-    // Apply de-emphasis filter.
-    for (unsigned i = 0; i < numberOfChannels; ++i)
+    // Apply de-emphasis filter, again one stage across all channels, in-place.
+    for (unsigned stageIndex = 0; stageIndex < 4; ++stageIndex)
     {
-        float* destinationData = m_destinationChannels[i];
-        ZeroPole* postFilters = m_postFilterPacks[i]->filters;
+        for (unsigned i = 0; i < numberOfChannels; ++i)
+            stageFilters[i] = &m_postFilterPacks[i]->filters[stageIndex];
 
-        postFilters[0].process(destinationData, destinationData, framesToProcess);
-        postFilters[1].process(destinationData, destinationData, framesToProcess);
-        postFilters[2].process(destinationData, destinationData, framesToProcess);
-        postFilters[3].process(destinationData, destinationData, framesToProcess);
+        ZeroPole::processChannels(stageFilters, const_cast<const float* const*>(m_destinationChannels.get()), m_destinationChannels.get(), numberOfChannels, framesToProcess);
     }
 }
 
@@ -6,6 +6,7 @@
 
 #include "internal/DynamicsCompressorKernel.h"
 #include "internal/AudioUtilities.h"
+#include "internal/FastMath.h"
 #include "internal/DenormalDisabler.h"
 #include "internal/Assertions.h"
 
@@ -38,6 +39,10 @@ DynamicsCompressorKernel::DynamicsCompressorKernel(unsigned numberOfChannels) :
     , m_kneeThresholdDb(uninitializedValue)
     , m_ykneeThresholdDb(uninitializedValue)
     , m_K(uninitializedValue)
+    , m_numberOfChannels(0)
+    , m_tableMaxInput(uninitializedValue)
+    , m_tableSatReleaseFrames(uninitializedValue)
+    , m_staticCurveTablesDirty(true)
 {
     setNumberOfChannels(numberOfChannels);
 
@@ -47,14 +52,12 @@ DynamicsCompressorKernel::DynamicsCompressorKernel(unsigned numberOfChannels) :
 
 void DynamicsCompressorKernel::setNumberOfChannels(unsigned numberOfChannels)
 {
-    
-    if (m_preDelayBuffers.size() == numberOfChannels)
+    if (m_numberOfChannels == numberOfChannels)
         return;
 
-    m_preDelayBuffers.clear();
-    for (unsigned i = 0; i < numberOfChannels; ++i)
-        m_preDelayBuffers.push_back(std::unique_ptr<AudioFloatArray>(new AudioFloatArray(MaxPreDelayFrames)));
-
+    // One allocation for all channels; preDelayChannel() strides into it.
+    m_numberOfChannels = numberOfChannels;
+    m_preDelayBuffer.allocate(numberOfChannels * MaxPreDelayFrames);
 }
 
 void DynamicsCompressorKernel::setPreDelayTime(float preDelayTime, float sampleRate)
@@ -66,8 +69,7 @@ void DynamicsCompressorKernel::setPreDelayTime(float preDelayTime, float sampleR
 
     if (m_lastPreDelayFrames != preDelayFrames) {
         m_lastPreDelayFrames = preDelayFrames;
-        for (unsigned i = 0; i < m_preDelayBuffers.size(); ++i)
-            m_preDelayBuffers[i]->zero();
+        m_preDelayBuffer.zero();
 
         m_preDelayReadIndex = 0;
         m_preDelayWriteIndex = preDelayFrames;
@@ -82,7 +84,7 @@ float DynamicsCompressorKernel::kneeCurve(float x, float k)
     if (x < m_linearThreshold)
         return x;
 
-    return m_linearThreshold + (1 - expf(-k * (x - m_linearThreshold))) / k;
+    return m_linearThreshold + (1 - FastMath::fast_expf(-k * (x - m_linearThreshold))) / k;
 }
 
 // Full compression curve with constant ratio after knee.
@@ -173,10 +175,70 @@ float DynamicsCompressorKernel::updateStaticCurveParameters(float dbThreshold, f
         m_ykneeThresholdDb = linearToDecibels(kneeCurve(m_kneeThreshold, k));
 
         m_K = k;
+        m_staticCurveTablesDirty = true;
     }
     return m_K;
 }
 
+void DynamicsCompressorKernel::updateStaticCurveTables(float k, float satReleaseFrames)
+{
+    m_attenuationTable.allocate(StaticCurveTableSize);
+    m_satReleaseRateTable.allocate(SatReleaseTableSize);
+
+    // Cover the static curve well past full scale; hotter inputs fall back to
+    // the analytic curve in lookupAttenuation().
+    m_tableMaxInput = 8;
+    m_tableSatReleaseFrames = satReleaseFrames;
+
+    float * attenuationTable = m_attenuationTable.data();
+    for (int i = 0; i < StaticCurveTableSize; ++i) {
+        float x = m_tableMaxInput * i / (StaticCurveTableSize - 1);
+        attenuationTable[i] = x <= 0.0001f ? 1 : saturate(x, k) / x;
+    }
+
+    // satReleaseRate as a function of attenuation (which is always <= 1).
+    float * rateTable = m_satReleaseRateTable.data();
+    for (int i = 1; i < SatReleaseTableSize; ++i) {
+        float attenuation = static_cast<float>(i) / (SatReleaseTableSize - 1);
+
+        float attenuationDb = -linearToDecibels(attenuation);
+        attenuationDb = max(2.0f, attenuationDb);
+
+        float dbPerFrame = attenuationDb / satReleaseFrames;
+        rateTable[i] = decibelsToLinear(dbPerFrame) - 1;
+    }
+    rateTable[0] = rateTable[1]; // attenuation == 0 would be -inf dB
+
+    m_staticCurveTablesDirty = false;
+}
+
+float DynamicsCompressorKernel::lookupAttenuation(float absInput, float k)
+{
+    if (absInput >= m_tableMaxInput)
+        return saturate(absInput, k) / absInput;
+
+    float position = absInput * (StaticCurveTableSize - 1) / m_tableMaxInput;
+    int index = static_cast<int>(position);
+    if (index > StaticCurveTableSize - 2)
+        index = StaticCurveTableSize - 2;
+    float fraction = position - index;
+
+    const float * table = m_attenuationTable.data();
+    return table[index] + fraction * (table[index + 1] - table[index]);
+}
+
+float DynamicsCompressorKernel::lookupSatReleaseRate(float attenuation) const
+{
+    float position = attenuation * (SatReleaseTableSize - 1);
+    int index = static_cast<int>(position);
+    if (index > SatReleaseTableSize - 2)
+        index = SatReleaseTableSize - 2;
+    float fraction = position - index;
+
+    const float * table = m_satReleaseRateTable.data();
+    return table[index] + fraction * (table[index + 1] - table[index]);
+}
+
 void DynamicsCompressorKernel::process(ContextRenderLock & r,
                                        const float * sourceChannels[],
                                        float * destinationChannels[],
@@ -196,7 +258,7 @@ void DynamicsCompressorKernel::process(ContextRenderLock & r,
                                        float releaseZone4
                                        )
 {
-    ASSERT(m_preDelayBuffers.size() == numberOfChannels);
+    ASSERT(m_numberOfChannels == numberOfChannels);
 
     float sampleRate = r.context()->sampleRate();
 
@@ -227,6 +289,12 @@ void DynamicsCompressorKernel::process(ContextRenderLock & r,
     float satReleaseTime = 0.0025f;
     float satReleaseFrames = satReleaseTime * sampleRate;
 
+    // Regenerate the static curve tables only when threshold/knee/ratio or
+    // the sample rate changed; the detector below then runs without a single
+    // powf/expf/log10f per sample.
+    if (m_staticCurveTablesDirty || satReleaseFrames != m_tableSatReleaseFrames)
+        updateStaticCurveTables(k, satReleaseFrames);
+
     // Create a smooth function which passes through four points.
 
     // Polynomial of the form
@@ -346,40 +414,51 @@ void DynamicsCompressorKernel::process(ContextRenderLock & r,
             float detectorAverage = m_detectorAverage;
             float compressorGain = m_compressorGain;
 
-            int loopFrames = nDivisionFrames;
-            while (loopFrames--) {
-                float compressorInput = 0;
-
-                // Predelay signal, computing compression amount from un-delayed version.
-                for (unsigned i = 0; i < numberOfChannels; ++i) {
-                    float* delayBuffer = m_preDelayBuffers[i]->data();
-                    float undelayedSource = sourceChannels[i][frameIndex];
-                    delayBuffer[preDelayWriteIndex] = undelayedSource;
-
-                    float absUndelayedSource = undelayedSource > 0 ? undelayedSource : -undelayedSource;
-                    if (compressorInput < absUndelayedSource)
-                        compressorInput = absUndelayedSource;
+            // Write the division into the pre-delay ring and reduce the
+            // channels to a single max-magnitude envelope input, in
+            // vectorizable per-channel passes instead of a per-sample
+            // channel loop.
+            float compressorInputs[nDivisionFrames];
+            {
+                const float* source = sourceChannels[0] + frameIndex;
+                for (int j = 0; j < nDivisionFrames; ++j)
+                    compressorInputs[j] = fabsf(source[j]);
+
+                for (unsigned c = 1; c < numberOfChannels; ++c) {
+                    source = sourceChannels[c] + frameIndex;
+                    for (int j = 0; j < nDivisionFrames; ++j) {
+                        float absSource = fabsf(source[j]);
+                        if (compressorInputs[j] < absSource)
+                            compressorInputs[j] = absSource;
+                    }
                 }
 
-                // Calculate shaped power on undelayed input.
+                int framesToEnd = MaxPreDelayFrames - preDelayWriteIndex;
+                for (unsigned c = 0; c < numberOfChannels; ++c) {
+                    float* delayBuffer = preDelayChannel(c);
+                    source = sourceChannels[c] + frameIndex;
+                    if (nDivisionFrames <= framesToEnd) {
+                        memcpy(delayBuffer + preDelayWriteIndex, source, sizeof(float) * nDivisionFrames);
+                    } else {
+                        memcpy(delayBuffer + preDelayWriteIndex, source, sizeof(float) * framesToEnd);
+                        memcpy(delayBuffer, source + framesToEnd, sizeof(float) * (nDivisionFrames - framesToEnd));
+                    }
+                }
+            }
 
-                float scaledInput = compressorInput;
-                float absInput = scaledInput > 0 ? scaledInput : -scaledInput;
+            // Serial envelope recursion over the division, using the
+            // interpolated curve tables instead of per-sample transcendentals.
+            float totalGains[nDivisionFrames];
+            for (int j = 0; j < nDivisionFrames; ++j) {
+                float absInput = compressorInputs[j];
 
                 // Put through shaping curve.
                 // This is linear up to the threshold, then enters a "knee" portion followed by the "ratio" portion.
                 // The transition from the threshold to the knee is smooth (1st derivative matched).
                 // The transition from the knee to the ratio portion is smooth (1st derivative matched).
-                float shapedInput = saturate(absInput, k);
-
-                float attenuation = absInput <= 0.0001f ? 1 : shapedInput / absInput;
-
-                float attenuationDb = -linearToDecibels(attenuation);
-                attenuationDb = max(2.0f, attenuationDb);
-
-                float dbPerFrame = attenuationDb / satReleaseFrames;
+                float attenuation = absInput <= 0.0001f ? 1 : lookupAttenuation(absInput, k);
 
-                float satReleaseRate = decibelsToLinear(dbPerFrame) - 1;
+                float satReleaseRate = lookupSatReleaseRate(attenuation);
 
                 bool isRelease = (attenuation > detectorAverage);
                 float rate = isRelease ? satReleaseRate : 1;
@@ -404,30 +483,38 @@ void DynamicsCompressorKernel::process(ContextRenderLock & r,
                 }
 
                 // Warp pre-compression gain to smooth out sharp exponential transition points.
-                float postWarpCompressorGain = sinf(0.5f * piFloat * compressorGain);
+                float postWarpCompressorGain = FastMath::fast_sinf(0.5f * piFloat * compressorGain);
 
                 // Calculate total gain using master gain and effect blend.
-                float totalGain = dryMix + wetMix * masterLinearGain * postWarpCompressorGain;
+                totalGains[j] = dryMix + wetMix * masterLinearGain * postWarpCompressorGain;
 
                 // Calculate metering.
-                float dbRealGain = 20 * log10(postWarpCompressorGain);
+                float dbRealGain = 20 * FastMath::fast_log10f(postWarpCompressorGain);
                 if (dbRealGain < m_meteringGain)
                     m_meteringGain = dbRealGain;
                 else
                     m_meteringGain += (dbRealGain - m_meteringGain) * m_meteringReleaseK;
+            }
 
-                // Apply final gain.
-                for (unsigned i = 0; i < numberOfChannels; ++i) 
-                {
-                    float* delayBuffer = m_preDelayBuffers[i]->data();
-                    destinationChannels[i][frameIndex] = delayBuffer[preDelayReadIndex] * totalGain;
+            // Apply the gains to the delayed signal in vectorizable
+            // per-channel passes.
+            {
+                int framesToEnd = MaxPreDelayFrames - preDelayReadIndex;
+                int headFrames = nDivisionFrames <= framesToEnd ? nDivisionFrames : framesToEnd;
+                for (unsigned c = 0; c < numberOfChannels; ++c) {
+                    const float* delayBuffer = preDelayChannel(c);
+                    float* destination = destinationChannels[c] + frameIndex;
+                    for (int j = 0; j < headFrames; ++j)
+                        destination[j] = delayBuffer[preDelayReadIndex + j] * totalGains[j];
+                    for (int j = headFrames; j < nDivisionFrames; ++j)
+                        destination[j] = delayBuffer[j - headFrames] * totalGains[j];
                 }
-
-                frameIndex++;
-                preDelayReadIndex = (preDelayReadIndex + 1) & MaxPreDelayFramesMask;
-                preDelayWriteIndex = (preDelayWriteIndex + 1) & MaxPreDelayFramesMask;
             }
 
+            frameIndex += nDivisionFrames;
+            preDelayReadIndex = (preDelayReadIndex + nDivisionFrames) & MaxPreDelayFramesMask;
+            preDelayWriteIndex = (preDelayWriteIndex + nDivisionFrames) & MaxPreDelayFramesMask;
+
             // Locals back to member variables.
             m_preDelayReadIndex = preDelayReadIndex;
             m_preDelayWriteIndex = preDelayWriteIndex;
@@ -444,8 +531,7 @@ void DynamicsCompressorKernel::reset()
     m_meteringGain = 1;
 
     // Predelay section.
-    for (unsigned i = 0; i < m_preDelayBuffers.size(); ++i)
-        m_preDelayBuffers[i]->zero();
+    m_preDelayBuffer.zero();
 
     m_preDelayReadIndex = 0;
     m_preDelayWriteIndex = DefaultPreDelayFrames;
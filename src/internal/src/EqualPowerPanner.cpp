@@ -9,6 +9,7 @@
 #include "internal/EqualPowerPanner.h"
 #include "internal/AudioUtilities.h"
 #include "internal/Assertions.h"
+#include "internal/EqualPowerTable.h"
 
 #include "LabSound/extended/AudioContextLock.h"
 
@@ -24,7 +25,8 @@ namespace lab {
 
 EqualPowerPanner::EqualPowerPanner(const float sampleRate) : Panner(sampleRate, PanningMode::EQUALPOWER)
 {
-
+    // Build the shared gain table now rather than on the render thread.
+    equalPowerSinTable();
 }
 
 void EqualPowerPanner::pan(ContextRenderLock & r, double azimuth, double /*elevation*/, const AudioBus* inputBus, AudioBus* outputBus, size_t framesToProcess)
@@ -81,9 +83,11 @@ void EqualPowerPanner::pan(ContextRenderLock & r, double azimuth, double /*eleva
         }
     }
 
-    desiredGainL = cos(0.5 * piDouble * desiredPanPosition);
-    desiredGainR = sin(0.5 * piDouble * desiredPanPosition);
-   
+    float tableGainL, tableGainR;
+    equalPowerGains(static_cast<float>(desiredPanPosition), tableGainL, tableGainR);
+    desiredGainL = tableGainL;
+    desiredGainR = tableGainR;
+
     // Don't de-zipper on first render call.
     if (m_isFirstRender) {
         m_isFirstRender = false;
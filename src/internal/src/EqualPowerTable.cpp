@@ -0,0 +1,50 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "internal/EqualPowerTable.h"
+
+namespace lab {
+
+namespace {
+
+// sin(x) on [0, pi/2] by Taylor series in double precision; on this
+// interval a dozen terms converge past double precision, so the float
+// cast is identical to a libm-built table. constexpr so the whole table
+// can be evaluated at compile time.
+constexpr double constexprSin(double x)
+{
+    double term = x;
+    double sum = x;
+    for (int k = 1; k < 12; ++k)
+    {
+        term *= -x * x / ((2 * k) * (2 * k + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+struct SinQuarterTable
+{
+    float values[kEqualPowerTableSize + 1];
+
+    constexpr SinQuarterTable() : values{}
+    {
+        const double piOverTwo = 1.57079632679489661923;
+        for (int i = 0; i <= kEqualPowerTableSize; ++i)
+            values[i] = static_cast<float>(constexprSin(piOverTwo * i / kEqualPowerTableSize));
+    }
+};
+
+// Evaluated by the compiler; the table lives in the read-only data
+// segment, shared process-wide (and across processes as clean pages),
+// with no initialization at startup or first use.
+constexpr SinQuarterTable s_table;
+
+}  // namespace
+
+const float * equalPowerSinTable()
+{
+    return s_table.values;
+}
+
+} // namespace lab
@@ -6,22 +6,53 @@
 #include "internal/VectorMath.h"
 #include "internal/Assertions.h"
 
+#include <map>
+
 namespace lab {
 
 using namespace VectorMath;
-    
+
+namespace {
+
+// Per-thread scratch shared by every FFTConvolver of the same FFT size on
+// that thread. The FFTFrame (with its twiddle tables) and the full-size
+// transform buffer are only live inside one process() call, so instances
+// never need their own; sharing them keeps the per-instance working set at
+// 1.5x half-FFT-size floats instead of several full FFTs, small enough for
+// convolution data to stay cache-resident between stages. Keyed per thread,
+// so the render thread and the convolution workers never contend.
+struct ConvolverScratch
+{
+    std::unique_ptr<FFTFrame> frame;
+    AudioFloatArray buffer;
+};
+
+ConvolverScratch & scratchForSize(size_t fftSize)
+{
+    static thread_local std::map<size_t, ConvolverScratch> arena;
+    ConvolverScratch & scratch = arena[fftSize];
+    if (!scratch.frame)
+    {
+        scratch.frame.reset(new FFTFrame((uint32_t) fftSize));
+        scratch.buffer.allocate(fftSize);
+    }
+    return scratch;
+}
+
+}  // namespace
+
 FFTConvolver::FFTConvolver(size_t fftSize)
-    : m_frame(fftSize)
+    : m_fftSize(fftSize)
     , m_readWriteIndex(0)
-    , m_inputBuffer(fftSize) // 2nd half of buffer is always zeroed
-    , m_outputBuffer(fftSize)
+    , m_inputBuffer(fftSize / 2)
+    , m_outputBuffer(fftSize / 2)
     , m_lastOverlapBuffer(fftSize / 2)
 {
 }
 
 void FFTConvolver::process(FFTFrame * fftKernel, const float * sourceP, float * destP, size_t framesToProcess)
 {
-    uint32_t halfSize = fftSize() / 2;
+    uint32_t halfSize = (uint32_t) (fftSize() / 2);
 
     // framesToProcess must be an exact multiple of halfSize,
     // or halfSize is a multiple of framesToProcess when halfSize > framesToProcess.
@@ -34,7 +65,7 @@ void FFTConvolver::process(FFTFrame * fftKernel, const float * sourceP, float *
     uint32_t numberOfDivisions = halfSize <= framesToProcess ? (framesToProcess / halfSize) : 1;
     uint32_t divisionSize = numberOfDivisions == 1 ? framesToProcess : halfSize;
 
-    for (uint32_t i = 0; i < numberOfDivisions; ++i, sourceP += divisionSize, destP += divisionSize) 
+    for (uint32_t i = 0; i < numberOfDivisions; ++i, sourceP += divisionSize, destP += divisionSize)
     {
         // Copy samples to input buffer (note contraint above!)
         float* inputP = m_inputBuffer.data();
@@ -60,24 +91,30 @@ void FFTConvolver::process(FFTFrame * fftKernel, const float * sourceP, float *
         m_readWriteIndex += divisionSize;
 
         // Check if it's time to perform the next FFT
-        if (m_readWriteIndex == halfSize) 
+        if (m_readWriteIndex == halfSize)
         {
+            ConvolverScratch & scratch = scratchForSize(m_fftSize);
+            float * transformP = scratch.buffer.data();
+
+            // Stage the buffered input zero-padded to a full FFT
+            memcpy(transformP, inputP, sizeof(float) * halfSize);
+            memset(transformP + halfSize, 0, sizeof(float) * halfSize);
 
             // The input buffer is now filled (get frequency-domain version)
-            m_frame.doFFT(m_inputBuffer.data());
-            m_frame.multiply(*fftKernel);
-            m_frame.doInverseFFT(m_outputBuffer.data());
+            scratch.frame->doFFT(transformP);
+            scratch.frame->multiply(*fftKernel);
+            scratch.frame->doInverseFFT(transformP);
 
-            // Overlap-add 1st half from previous time
-            vadd(m_outputBuffer.data(), 1, m_lastOverlapBuffer.data(), 1, m_outputBuffer.data(), 1, halfSize);
+            // Overlap-add 1st half from previous time, and keep it for reading out
+            vadd(transformP, 1, m_lastOverlapBuffer.data(), 1, outputP, 1, halfSize);
 
             // Finally, save 2nd half of result
-            bool isCopyGood3 = m_outputBuffer.size() == 2 * halfSize && m_lastOverlapBuffer.size() == halfSize;
+            bool isCopyGood3 = m_lastOverlapBuffer.size() == halfSize;
             ASSERT(isCopyGood3);
             if (!isCopyGood3)
                 return;
 
-            memcpy(m_lastOverlapBuffer.data(), m_outputBuffer.data() + halfSize, sizeof(float) * halfSize);
+            memcpy(m_lastOverlapBuffer.data(), transformP + halfSize, sizeof(float) * halfSize);
 
             // Reset index back to start for next time
             m_readWriteIndex = 0;
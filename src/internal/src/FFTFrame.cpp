@@ -47,8 +47,6 @@ std::unique_ptr<FFTFrame> FFTFrame::createInterpolatedFrame(const FFTFrame& fram
 
 void FFTFrame::interpolateFrequencyComponents(const FFTFrame& frame1, const FFTFrame& frame2, double interp)
 {
-    // FIXME : with some work, this method could be optimized
-
     float* realP = realData();
     float* imagP = imagData();
 
@@ -72,42 +70,52 @@ void FFTFrame::interpolateFrequencyComponents(const FFTFrame& frame1, const FFTF
 
     int n = m_FFTSize / 2;
 
+    // Compute both magnitude spectra up front. Pulling the sqrt out of the
+    // serial phase-unwrapping loop below lets this pass vectorize.
+    AudioFloatArray magnitudes1(n);
+    AudioFloatArray magnitudes2(n);
+    float* mag1P = magnitudes1.data();
+    float* mag2P = magnitudes2.data();
     for (int i = 1; i < n; ++i) {
-        Complex c1(realP1[i], imagP1[i]);
-        Complex c2(realP2[i], imagP2[i]);
+        mag1P[i] = sqrtf(realP1[i] * realP1[i] + imagP1[i] * imagP1[i]);
+        mag2P[i] = sqrtf(realP2[i] * realP2[i] + imagP2[i] * imagP2[i]);
+    }
 
-        double mag1 = abs(c1);
-        double mag2 = abs(c2);
+    // The magnitude blending below works in decibels, but expressed as ratio
+    // tests and a geometric blend so that no per-bin log10()/pow() is needed.
+    // These are the original 2 dB and 5 dB thresholds as linear ratios.
+    const float thresholdRatioLow = 1.2589254f;   // 10^(2/20), bins <= 16
+    const float thresholdRatioHigh = 1.7782794f;  // 10^(5/20), bins > 16
 
-        // Interpolate magnitudes in decibels
-        double mag1db = 20.0 * log10(mag1);
-        double mag2db = 20.0 * log10(mag2);
+    for (int i = 1; i < n; ++i) {
+        double mag1 = mag1P[i];
+        double mag2 = mag2P[i];
 
         double s1 = s1base;
         double s2 = s2base;
 
-        double magdbdiff = mag1db - mag2db;
-
         // Empirical tweak to retain higher-frequency zeroes
-        double threshold =  (i > 16) ? 5.0 : 2.0;
+        float thresholdRatio = (i > 16) ? thresholdRatioHigh : thresholdRatioLow;
 
-        if (magdbdiff < -threshold && mag1db < 0.0) 
+        // mag1/mag2 more than threshold dB below mag2 and itself below 0 dB,
+        // or vice versa - same conditions as the old decibel comparison.
+        if (mag1 * thresholdRatio < mag2 && mag1 < 1.0)
         {
             s1 = pow(s1, 0.75);
             s2 = 1.0 - s1;
-        } else if (magdbdiff > threshold && mag2db < 0.0)
+        } else if (mag2 * thresholdRatio < mag1 && mag2 < 1.0)
         {
             s2 = pow(s2, 0.75);
             s1 = 1.0 - s2;
         }
 
-        // Average magnitude by decibels instead of linearly
-        double magdb = s1 * mag1db + s2 * mag2db;
-        double mag = pow(10.0, 0.05 * magdb);
+        // Average magnitude by decibels instead of linearly; the geometric blend
+        // exp(s1*ln(mag1) + s2*ln(mag2)) is identical to 10^(0.05 * (s1*mag1db + s2*mag2db)).
+        double mag = exp(s1 * log(mag1) + s2 * log(mag2));
 
         // Now, deal with phase
-        double phase1 = arg(c1);
-        double phase2 = arg(c2);
+        double phase1 = atan2(static_cast<double>(imagP1[i]), static_cast<double>(realP1[i]));
+        double phase2 = atan2(static_cast<double>(imagP2[i]), static_cast<double>(realP2[i]));
 
         double deltaPhase1 = phase1 - lastPhase1;
         double deltaPhase2 = phase2 - lastPhase2;
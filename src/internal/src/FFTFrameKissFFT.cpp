@@ -11,63 +11,118 @@
 
 #include <kissfft/kiss_fftr.hpp>
 #include <iostream>
+#include <map>
+#include <utility>
 
 // To use this implementation, add WTF_USE_WEBAUDIO_KISSFFT=1 to the list of preprocessor defines
-namespace lab 
+namespace lab
 {
-    
+
+    namespace
+    {
+        // Per-thread cache of kiss_fftr configs, keyed by (fftSize, inverse).
+        // A config embeds both the twiddle tables and a work buffer; the work
+        // buffer makes it unsafe to share between threads (a truly
+        // process-wide cache, as the Accelerate backend keeps for its
+        // FFTSetups, is not possible with kissfft's opaque state), but within
+        // a thread every FFTFrame of the same size can use one config.
+        // Previously each frame allocated its own forward and inverse config,
+        // so the HRTF panner's four convolvers per voice each carried private
+        // twiddle tables; with many voices the shared tables stay hot in
+        // cache across consecutive stage FFTs.
+        //
+        // The cache also owns the interleaved staging pair a transform needs.
+        // The buffers are live only for the duration of a doFFT/doInverseFFT
+        // call, so one pair per thread, grown to the largest size requested,
+        // replaces a private pair in every frame - a 256-partition convolver
+        // used to carry ~512 of them.
+        struct FFTConfigCache
+        {
+            ~FFTConfigCache()
+            {
+                for (auto & entry : configs)
+                    KISS_FFT_FREE(entry.second);
+            }
+
+            kiss_fftr_cfg get(size_t fftSize, int inverse)
+            {
+                auto key = std::make_pair(fftSize, inverse);
+                auto it = configs.find(key);
+                if (it != configs.end())
+                    return it->second;
+
+                kiss_fftr_cfg cfg = kiss_fftr_alloc(static_cast<int>(fftSize), inverse, nullptr, nullptr);
+                configs[key] = cfg;
+                return cfg;
+            }
+
+            kiss_fft_cpx * inputScratch(size_t binSize)
+            {
+                if (input.size() < binSize)
+                    input.resize(binSize);
+                return input.data();
+            }
+
+            kiss_fft_cpx * outputScratch(size_t binSize)
+            {
+                if (output.size() < binSize)
+                    output.resize(binSize);
+                return output.data();
+            }
+
+            std::map<std::pair<size_t, int>, kiss_fftr_cfg> configs;
+            std::vector<kiss_fft_cpx> input;
+            std::vector<kiss_fft_cpx> output;
+        };
+
+        FFTConfigCache & fftCache()
+        {
+            static thread_local FFTConfigCache cache;
+            return cache;
+        }
+
+        kiss_fftr_cfg cachedFFTConfig(size_t fftSize, int inverse)
+        {
+            return fftCache().get(fftSize, inverse);
+        }
+    }
+
     const int kMaxFFTPow2Size = 24;
-    
+
     // Normal constructor: allocates for a given fftSize.
-    FFTFrame::FFTFrame(size_t fftSize) : m_FFTSize(fftSize), m_log2FFTSize(static_cast<unsigned>(log2((double)fftSize))), mFFT(0), mIFFT(0), m_realData(fftSize / 2 + 1), m_imagData(fftSize / 2 + 1)
+    FFTFrame::FFTFrame(size_t fftSize) : m_FFTSize(fftSize), m_log2FFTSize(static_cast<unsigned>(log2((double)fftSize))), m_realData(fftSize / 2 + 1), m_imagData(fftSize / 2 + 1)
     {
         // We only allow power of two.
         ASSERT(1UL << m_log2FFTSize == m_FFTSize);
-        
-        const int mBinSize = m_FFTSize / 2 + 1; 
 
-        mFFT = kiss_fftr_alloc(m_FFTSize, 0, nullptr, nullptr);
-        mIFFT = kiss_fftr_alloc(m_FFTSize, 1, nullptr, nullptr);
-        
-        m_cpxInputData = new kiss_fft_cpx[mBinSize];
-        m_cpxOutputData = new kiss_fft_cpx[mBinSize];
+        const int mBinSize = m_FFTSize / 2 + 1;
 
         size_t nbytes = sizeof(float) * mBinSize;
 
         memset(realData(), 0, nbytes);
         memset(imagData(), 0, nbytes);
     }
-    
+
     // Creates a blank/empty frame (interpolate() must later be called).
-    FFTFrame::FFTFrame() : m_FFTSize(0), m_log2FFTSize(0), mFFT(0), mIFFT(0)
+    FFTFrame::FFTFrame() : m_FFTSize(0), m_log2FFTSize(0)
     {
 
     }
-    
-    // Copy constructor.
-    FFTFrame::FFTFrame(const FFTFrame& frame) : m_FFTSize(frame.m_FFTSize), m_log2FFTSize(frame.m_log2FFTSize), mFFT(0), mIFFT(0), m_realData(frame.m_FFTSize / 2), m_imagData(frame.m_FFTSize / 2)
-    { 
-        mFFT = kiss_fftr_alloc(m_FFTSize, 0, nullptr, nullptr);
-        mIFFT = kiss_fftr_alloc(m_FFTSize, 1, nullptr, nullptr);
 
-        const int mBinSize = m_FFTSize / 2 + 1; 
+    // Copy constructor.
+    FFTFrame::FFTFrame(const FFTFrame& frame) : m_FFTSize(frame.m_FFTSize), m_log2FFTSize(frame.m_log2FFTSize), m_realData(frame.m_FFTSize / 2), m_imagData(frame.m_FFTSize / 2)
+    {
+        const int mBinSize = m_FFTSize / 2 + 1;
 
         // Copy/setup frame data.
         unsigned nbytes = sizeof(float) * mBinSize;
 
         memcpy(realData(), frame.realData(), nbytes);
         memcpy(imagData(), frame.imagData(), nbytes);
-
-        m_cpxInputData = new kiss_fft_cpx[mBinSize];
-        m_cpxOutputData = new kiss_fft_cpx[mBinSize];
     }
-    
+
     FFTFrame::~FFTFrame()
     {
-        KISS_FFT_FREE(mFFT);
-        KISS_FFT_FREE(mIFFT);
-        delete m_cpxInputData;
-        delete m_cpxOutputData;
     }
     
     void FFTFrame::multiply(const FFTFrame& frame)
@@ -92,9 +147,10 @@ namespace lab
     
     void FFTFrame::doFFT(const float* data)
     {
-        kiss_fftr(mFFT, data, m_cpxOutputData);
-        
-        float * outputData = reinterpret_cast<float*>(m_cpxOutputData); // interleaved .r / .i
+        kiss_fft_cpx * cpxOutput = fftCache().outputScratch(m_FFTSize / 2 + 1);
+        kiss_fftr(cachedFFTConfig(m_FFTSize, 0), data, cpxOutput);
+
+        float * outputData = reinterpret_cast<float*>(cpxOutput); // interleaved .r / .i
 
         // De-interleave to separate real and complex arrays.
         VectorMath::vdeintlve(outputData, m_realData.data(), m_imagData.data(), m_FFTSize);
@@ -104,16 +160,17 @@ namespace lab
     {
         const uint32_t inputSize = m_FFTSize / 2 + 1;
 
-        for (uint32_t i = 0; i < inputSize; ++i) 
+        kiss_fft_cpx * cpxInput = fftCache().inputScratch(inputSize);
+        for (uint32_t i = 0; i < inputSize; ++i)
         {
-            m_cpxInputData[i].r = m_realData.data()[i];
-            m_cpxInputData[i].i = m_imagData.data()[i];
+            cpxInput[i].r = m_realData.data()[i];
+            cpxInput[i].i = m_imagData.data()[i];
         }
 
         // Inverse-transform the (inputSize) points of data in each
-        // of (m_cpxInputData.r) and (m_cpxInputData.i) 
-        float * outData = reinterpret_cast<float*>(m_cpxOutputData); // .r + .i
-        kiss_fftri(mIFFT, m_cpxInputData, outData);
+        // of (cpxInput.r) and (cpxInput.i)
+        float * outData = reinterpret_cast<float*>(fftCache().outputScratch(inputSize));  // .r + .i
+        kiss_fftri(cachedFFTConfig(m_FFTSize, 1), cpxInput, outData);
 
         // Scale so that a forward then inverse FFT yields exactly the original data and
         // store the resulting (m_FFTSize) points in (data).
@@ -0,0 +1,183 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "LabSound/core/Macros.h"
+#include "internal/Assertions.h"
+
+#if defined(WEBAUDIO_OOURA)
+
+#include "internal/FFTFrame.h"
+#include "internal/VectorMath.h"
+
+#include <ooura/fftsg.h>
+
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// Real-to-complex FFT backend built on ooura's split-radix fftsg, which is
+// considerably faster than the KissFFT fallback. Enabled by default on
+// non-Apple platforms; add LABSOUND_USE_KISSFFT to the CMake configuration to
+// select the old backend instead.
+namespace lab
+{
+
+struct OouraFFTTables
+{
+    std::vector<int> ip;
+    std::vector<float> w;
+
+    OouraFFTTables(size_t fftSize)
+        : ip(2 + static_cast<size_t>(sqrt(fftSize / 2.0)) + 1, 0)
+        , w(fftSize / 2)
+    {
+        // ooura writes the tables on the first transform (ip[0] == 0). Run one
+        // throwaway transform now, so that afterwards concurrent transforms on
+        // different frames only ever read them.
+        std::vector<float> scratch(fftSize, 0.f);
+        ooura::rdft(static_cast<int>(fftSize), 1, scratch.data(), ip.data(), w.data());
+    }
+};
+
+namespace
+{
+    std::shared_ptr<OouraFFTTables> tablesForSize(size_t fftSize)
+    {
+        // Process-wide plan cache: one set of tables per FFT size, shared by
+        // every convolver and kernel instead of a per-frame setup.
+        static std::mutex tableMutex;
+        static std::map<size_t, std::shared_ptr<OouraFFTTables>> tables;
+
+        std::lock_guard<std::mutex> lock(tableMutex);
+
+        auto it = tables.find(fftSize);
+        if (it != tables.end())
+            return it->second;
+
+        auto entry = std::make_shared<OouraFFTTables>(fftSize);
+        tables[fftSize] = entry;
+        return entry;
+    }
+}
+
+// Normal constructor: allocates for a given fftSize.
+FFTFrame::FFTFrame(size_t fftSize)
+    : m_FFTSize(fftSize)
+    , m_log2FFTSize(static_cast<unsigned>(log2((double) fftSize)))
+    , m_tables(tablesForSize(fftSize))
+    , m_buffer(fftSize)
+    , m_realData(fftSize / 2)
+    , m_imagData(fftSize / 2)
+{
+    // We only allow power of two.
+    ASSERT(1UL << m_log2FFTSize == m_FFTSize);
+}
+
+// Creates a blank/empty frame (interpolate() must later be called).
+FFTFrame::FFTFrame() : m_FFTSize(0), m_log2FFTSize(0)
+{
+}
+
+// Copy constructor.
+FFTFrame::FFTFrame(const FFTFrame & frame)
+    : m_FFTSize(frame.m_FFTSize)
+    , m_log2FFTSize(frame.m_log2FFTSize)
+    , m_tables(frame.m_tables)
+    , m_buffer(frame.m_FFTSize)
+    , m_realData(frame.m_FFTSize / 2)
+    , m_imagData(frame.m_FFTSize / 2)
+{
+    size_t nbytes = sizeof(float) * (m_FFTSize / 2);
+    memcpy(realData(), frame.realData(), nbytes);
+    memcpy(imagData(), frame.imagData(), nbytes);
+}
+
+FFTFrame::~FFTFrame()
+{
+}
+
+void FFTFrame::multiply(const FFTFrame & frame)
+{
+    FFTFrame & frame1 = *this;
+    const FFTFrame & frame2 = frame;
+
+    float * realP1 = frame1.realData();
+    float * imagP1 = frame1.imagData();
+    const float * realP2 = frame2.realData();
+    const float * imagP2 = frame2.imagData();
+
+    unsigned halfSize = fftSize() / 2;
+    float real0 = realP1[0];
+    float imag0 = imagP1[0];
+    VectorMath::zvmul(realP1, imagP1, realP2, imagP2, realP1, imagP1, halfSize);
+
+    // Multiply the packed DC/nyquist component
+    realP1[0] = real0 * realP2[0];
+    imagP1[0] = imag0 * imagP2[0];
+}
+
+void FFTFrame::doFFT(const float * data)
+{
+    size_t n = m_FFTSize;
+    size_t halfSize = n / 2;
+
+    float * buffer = m_buffer.data();
+    memcpy(buffer, data, n * sizeof(float));
+
+    ooura::rdft(static_cast<int>(n), 1, buffer, m_tables->ip.data(), m_tables->w.data());
+
+    // De-interleave, negating the imaginary parts: ooura uses a positive-sine
+    // convention where the engine (and the other backends) expect the standard
+    // negative-exponent DFT. ooura packs the (purely real) nyquist component
+    // into buffer[1]; it is carried in imag[0].
+    float * realP = m_realData.data();
+    float * imagP = m_imagData.data();
+    realP[0] = buffer[0];
+    imagP[0] = buffer[1];
+    for (size_t k = 1; k < halfSize; ++k)
+    {
+        realP[k] = buffer[2 * k];
+        imagP[k] = -buffer[2 * k + 1];
+    }
+}
+
+void FFTFrame::doInverseFFT(float * data)
+{
+    size_t n = m_FFTSize;
+    size_t halfSize = n / 2;
+
+    // Re-interleave into ooura's layout, undoing the sign flip from doFFT().
+    float * buffer = m_buffer.data();
+    const float * realP = m_realData.data();
+    const float * imagP = m_imagData.data();
+    buffer[0] = realP[0];
+    buffer[1] = imagP[0];
+    for (size_t k = 1; k < halfSize; ++k)
+    {
+        buffer[2 * k] = realP[k];
+        buffer[2 * k + 1] = -imagP[k];
+    }
+
+    ooura::rdft(static_cast<int>(n), -1, buffer, m_tables->ip.data(), m_tables->w.data());
+
+    // Scale so that a forward then inverse FFT yields exactly the original data:
+    //  x == IFFT(FFT(x))
+    const float scale = 2.0f / n;
+    VectorMath::vsmul(buffer, 1, &scale, data, 1, n);
+}
+
+float * FFTFrame::realData() const
+{
+    return const_cast<float *>(m_realData.data());
+}
+
+float * FFTFrame::imagData() const
+{
+    return const_cast<float *>(m_imagData.data());
+}
+
+}  // namespace lab
+
+#endif  // WEBAUDIO_OOURA
@@ -0,0 +1,376 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "internal/GraphRenderScheduler.h"
+
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/AudioNode.h"
+#include "LabSound/core/AudioNodeInput.h"
+#include "LabSound/core/AudioNodeOutput.h"
+#include "LabSound/core/AudioParam.h"
+
+#include "LabSound/extended/AudioContextLock.h"
+
+#include "internal/Assertions.h"
+#include "internal/AudioThreads.h"
+#include "internal/DenormalDisabler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <typeinfo>
+
+namespace lab
+{
+
+namespace
+{
+    // Gather every node reachable upstream of root, inclusive. Param drivers
+    // count as upstream too: process() pulls them through
+    // AudioParam::calculateSampleAccurateValues exactly like an input, so an
+    // LFO modulating params in two branches must land both branches in one
+    // partition or the two threads would race processIfNecessary on it.
+    void collectUpstreamNodes(ContextRenderLock & r, AudioNode * root, std::set<AudioNode *> & nodes)
+    {
+        if (!root || nodes.count(root))
+            return;
+
+        nodes.insert(root);
+
+        for (size_t i = 0; i < root->numberOfInputs(); ++i)
+        {
+            auto input = root->input(i);
+            if (!input)
+                continue;
+
+            size_t c = input->numberOfRenderingConnections(r);
+            for (size_t j = 0; j < c; ++j)
+            {
+                auto output = input->renderingOutput(r, j);
+                if (output)
+                    collectUpstreamNodes(r, output->node(), nodes);
+            }
+        }
+
+        for (size_t i = 0; i < root->numberOfParams(); ++i)
+        {
+            auto param = root->param(i);
+            if (!param)
+                continue;
+
+            size_t c = param->numberOfRenderingConnections(r);
+            for (size_t j = 0; j < c; ++j)
+            {
+                auto output = param->renderingOutput(r, j);
+                if (output)
+                    collectUpstreamNodes(r, output->node(), nodes);
+            }
+        }
+    }
+
+    // How often measured costs are folded back into the dispatch order;
+    // roughly three quarters of a second of 128-frame quanta at 44.1kHz.
+    const int kCostResortIntervalQuanta = 256;
+
+    size_t desiredWorkerCount()
+    {
+        unsigned int hw = std::thread::hardware_concurrency();
+        if (hw < 2)
+            return 0;
+
+        // leave a core for the device callback thread itself, and don't
+        // oversubscribe small graphs on very wide machines
+        return std::min<size_t>(hw - 1, 7);
+    }
+}
+
+GraphRenderScheduler::GraphRenderScheduler()
+{
+}
+
+GraphRenderScheduler::~GraphRenderScheduler()
+{
+    stopWorkers();
+}
+
+void GraphRenderScheduler::startWorkers(size_t count)
+{
+    for (size_t i = m_workers.size(); i < count; ++i)
+    {
+        m_workers.emplace_back(&GraphRenderScheduler::workerLoop, this);
+    }
+}
+
+void GraphRenderScheduler::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_workMutex);
+        m_shouldExit = true;
+    }
+    m_workAvailable.notify_all();
+
+    for (auto & w : m_workers)
+    {
+        if (w.joinable())
+            w.join();
+    }
+    m_workers.clear();
+}
+
+void GraphRenderScheduler::rebuildPartitionsIfNecessary(ContextRenderLock & r, AudioNodeInput * junction)
+{
+    size_t c = junction->numberOfRenderingConnections(r);
+
+    // Param connections don't alter the junction's output set, so the pointer
+    // comparison below cannot see them; the context bumps its graph
+    // generation for node and param edits alike, so track that as well.
+    uint64_t generation = r.context()->graphGeneration();
+
+    // cheap steady-state check: same topology and connection set as last quantum?
+    bool changed = generation != m_lastGraphGeneration || c != m_lastConnections.size();
+    if (!changed)
+    {
+        for (size_t i = 0; i < c; ++i)
+        {
+            auto output = junction->renderingOutput(r, i);
+            if (m_lastConnections[i] != static_cast<void *>(output))
+            {
+                changed = true;
+                break;
+            }
+        }
+    }
+
+    if (!changed)
+        return;
+
+    m_lastGraphGeneration = generation;
+    m_lastConnections.resize(c);
+    m_partitions.clear();
+
+    // Union branches that reach any common node: two sources mixing through a
+    // shared subgraph must be processed on the same thread.
+    std::vector<std::set<AudioNode *>> reachable;
+    std::vector<AudioNode *> roots;
+
+    for (size_t i = 0; i < c; ++i)
+    {
+        auto output = junction->renderingOutput(r, i);
+        m_lastConnections[i] = static_cast<void *>(output);
+
+        if (!output || !output->node())
+            continue;
+
+        std::set<AudioNode *> nodes;
+        collectUpstreamNodes(r, output->node(), nodes);
+        reachable.push_back(std::move(nodes));
+        roots.push_back(output->node());
+    }
+
+    std::vector<int> partitionOf(roots.size(), -1);
+
+    for (size_t i = 0; i < roots.size(); ++i)
+    {
+        // find an earlier branch sharing at least one node
+        for (size_t j = 0; j < i && partitionOf[i] < 0; ++j)
+        {
+            for (AudioNode * n : reachable[i])
+            {
+                if (reachable[j].count(n))
+                {
+                    partitionOf[i] = partitionOf[j];
+                    break;
+                }
+            }
+        }
+
+        if (partitionOf[i] < 0)
+        {
+            partitionOf[i] = static_cast<int>(m_partitions.size());
+            m_partitions.push_back(Partition());
+        }
+
+        Partition & p = m_partitions[partitionOf[i]];
+        p.roots.push_back(roots[i]);
+
+        // merge the reachable sets so later branches compare against the union
+        if (partitionOf[i] < static_cast<int>(i))
+        {
+            for (size_t j = 0; j < i; ++j)
+            {
+                if (partitionOf[j] == partitionOf[i])
+                {
+                    reachable[j].insert(reachable[i].begin(), reachable[i].end());
+                }
+            }
+        }
+    }
+
+    // Flatten each partition's node set for costing, and group same-type
+    // roots contiguously so a partition of many light sources of one kind
+    // runs the same process() code back to back - warm instruction cache and
+    // adjacent pooled kernel state - instead of in connection order.
+    for (size_t p = 0; p < m_partitions.size(); ++p)
+    {
+        std::set<AudioNode *> nodes;
+        for (size_t i = 0; i < roots.size(); ++i)
+        {
+            if (partitionOf[i] == static_cast<int>(p))
+                nodes.insert(reachable[i].begin(), reachable[i].end());
+        }
+        m_partitions[p].nodes.assign(nodes.begin(), nodes.end());
+
+        std::stable_sort(m_partitions[p].roots.begin(), m_partitions[p].roots.end(),
+                         [](AudioNode * a, AudioNode * b) {
+                             return strcmp(typeid(*a).name(), typeid(*b).name()) < 0;
+                         });
+    }
+
+    packScheduleByCost();
+    m_quantaSinceCostSort = 0;
+}
+
+void GraphRenderScheduler::packScheduleByCost()
+{
+    for (Partition & p : m_partitions)
+    {
+        uint64_t cost = 0;
+        for (AudioNode * n : p.nodes)
+        {
+            // mean measured quantum cost; one microsecond stands in for an
+            // unmeasured node so unprofiled graphs still order by node count
+            uint64_t quanta = n->profiledQuanta();
+            cost += quanta ? n->profiledTotalMicroseconds() / quanta : 1;
+        }
+        p.costMicroseconds = cost;
+    }
+
+    // Longest first: with dynamic claiming, starting the heavy partitions at
+    // the top of the quantum bounds the finish time by the heaviest single
+    // partition rather than by an unlucky claim order.
+    std::stable_sort(m_partitions.begin(), m_partitions.end(),
+                     [](const Partition & a, const Partition & b) {
+                         return a.costMicroseconds > b.costMicroseconds;
+                     });
+}
+
+void GraphRenderScheduler::runOneTask(int task, ContextRenderLock & r, size_t framesToProcess)
+{
+    for (AudioNode * root : m_partitions[task].roots)
+    {
+        // roots are processed directly rather than pulled, so no downstream
+        // consumer is supplying an in-place bus this quantum
+        for (size_t i = 0; i < root->numberOfOutputs(); ++i)
+            root->output(i)->clearInPlaceBus();
+
+        root->processIfNecessary(r, framesToProcess);
+    }
+
+    if (m_tasksRemaining.fetch_sub(1, std::memory_order_release) == 1)
+    {
+        // Notify under the mutex: preRender's check of m_tasksRemaining and
+        // its sleep on m_workDone are atomic with respect to m_workMutex, so
+        // a notify issued while holding it cannot land in between and be
+        // lost, leaving the device callback blocked forever.
+        std::lock_guard<std::mutex> lock(m_workMutex);
+        m_workDone.notify_all();
+    }
+}
+
+void GraphRenderScheduler::workerLoop()
+{
+    ApplyThreadPolicy(AudioContext::ThreadRole::Render, "graph render");
+
+    // protect this worker against denormals just as the device thread is
+    DenormalDisabler denormalDisabler;
+
+    for (;;)
+    {
+        ContextRenderLock * r = nullptr;
+        size_t frames = 0;
+        int task = -1;
+
+        {
+            std::unique_lock<std::mutex> lock(m_workMutex);
+            m_workAvailable.wait(lock, [this]() {
+                return m_shouldExit || (m_renderLock && m_nextTask.load(std::memory_order_relaxed) < static_cast<int>(m_partitions.size()));
+            });
+
+            if (m_shouldExit)
+                return;
+
+            // Claim while still holding the mutex: the claim is then atomic
+            // with the render-lock read, so a worker preempted after waking
+            // can never pair a task of the next quantum with the previous
+            // quantum's (dangling) render lock and frame count - preRender
+            // resets m_nextTask under this mutex.
+            task = m_nextTask.fetch_add(1, std::memory_order_relaxed);
+            if (task >= static_cast<int>(m_partitions.size()))
+                continue;  // the render thread's own claims got there first
+
+            r = m_renderLock;
+            frames = m_framesToProcess;
+        }
+
+        runOneTask(task, *r, frames);
+    }
+}
+
+void GraphRenderScheduler::preRender(ContextRenderLock & r, AudioNodeInput * junction, size_t framesToProcess)
+{
+    ASSERT(r.context());
+    if (!junction)
+        return;
+
+    rebuildPartitionsIfNecessary(r, junction);
+
+    size_t partitionCount = m_partitions.size();
+    if (partitionCount < 2)
+        return; // nothing to parallelize; the normal pull handles it
+
+    // fold drifting measured costs back into the dispatch order; cheap, and
+    // no worker holds a partition reference between quanta
+    if (++m_quantaSinceCostSort >= kCostResortIntervalQuanta)
+    {
+        packScheduleByCost();
+        m_quantaSinceCostSort = 0;
+    }
+
+    size_t workers = std::min(desiredWorkerCount(), partitionCount - 1);
+    if (!workers)
+        return;
+
+    startWorkers(workers);
+
+    {
+        std::lock_guard<std::mutex> lock(m_workMutex);
+        m_renderLock = &r;
+        m_framesToProcess = framesToProcess;
+        m_nextTask.store(0, std::memory_order_relaxed);
+        m_tasksRemaining.store(static_cast<int>(partitionCount), std::memory_order_relaxed);
+    }
+    m_workAvailable.notify_all();
+
+    // The render thread participates rather than idling. Claiming without
+    // the mutex is fine here: only this thread resets m_nextTask and its
+    // own render lock is valid by construction.
+    for (;;)
+    {
+        int task = m_nextTask.fetch_add(1, std::memory_order_relaxed);
+        if (task >= static_cast<int>(partitionCount))
+            break;
+        runOneTask(task, r, framesToProcess);
+    }
+
+    // wait for stragglers still inside their partitions
+    if (m_tasksRemaining.load(std::memory_order_acquire))
+    {
+        std::unique_lock<std::mutex> lock(m_workMutex);
+        m_workDone.wait(lock, [this]() { return !m_tasksRemaining.load(std::memory_order_acquire); });
+    }
+
+    std::lock_guard<std::mutex> lock(m_workMutex);
+    m_renderLock = nullptr;
+}
+
+} // namespace lab
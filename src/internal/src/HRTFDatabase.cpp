@@ -4,51 +4,384 @@
 
 #include "internal/HRTFDatabase.h"
 #include "internal/HRTFElevation.h"
+#include "internal/FFTFrame.h"
 #include "internal/Assertions.h"
+#include "internal/ConvolutionWorkerPool.h"
+
+#include "LabSound/core/Macros.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
 
 using namespace std;
 
 namespace lab {
 
+namespace {
+
+    // A baked database is the fully processed kernel set written out as one flat
+    // file: frequency-domain data and frame delays, exactly as HRTFKernel holds
+    // them in memory. Loading it skips the per-file WAV decode and forward FFT
+    // that dominate spatializer startup.
+    //
+    // Layout: BakedHeader, then per elevation
+    //   float elevationAngle
+    //   per azimuth: float delayL, float delayR,
+    //                float realL[fftSize/2], float imagL[fftSize/2],
+    //                float realR[fftSize/2], float imagR[fftSize/2]
+    struct BakedHeader
+    {
+        char magic[4]; // "LSHB"
+        uint32_t version;
+        float sampleRate;
+        uint32_t numElevations;
+        uint32_t numAzimuths;
+        uint32_t fftSize;
+    };
+
+    const uint32_t BakedVersion = 1;
+
+    // How far past the requested elevation a load reaches, in raw slices.
+    // One slice each side keeps a source sweeping through elevations inside
+    // resident data while the next band loads behind it.
+    const int PrefetchRawSlices = 1;
+
+    size_t bakedRecordBytes(uint32_t numAzimuths, uint32_t fftSize)
+    {
+        return sizeof(float) + numAzimuths * (2 + 4 * (fftSize / 2)) * sizeof(float);
+    }
+
+    struct BakedReader
+    {
+        const uint8_t * p = nullptr;
+        size_t remaining = 0;
+
+        bool read(void * dst, size_t bytes)
+        {
+            if (bytes > remaining)
+                return false;
+            memcpy(dst, p, bytes);
+            p += bytes;
+            remaining -= bytes;
+            return true;
+        }
+    };
+
+} // namespace
+
 HRTFDatabase::HRTFDatabase(float sampleRate, const std::string & searchPath)
 {
     info.reset(new HRTFDatabaseInfo("Composite", searchPath, sampleRate));
-    
+
     m_elevations.resize(info->numTotalElevations);
-    
-    int elevationIndex = 0;
-    for (int elevation = info->minElevation; elevation <= info->maxElevation; elevation += info->rawElevationAngleSpacing)
-    {
-        std::unique_ptr<HRTFElevation> hrtfElevation = HRTFElevation::createForSubject(info.get(), elevation);
-        
-        // @tofix - removed ASSERT(hrtfElevation.get());
-        if (!hrtfElevation.get()) return;
-        
-        m_elevations[elevationIndex] = std::move(hrtfElevation);
-        elevationIndex += info->interpolationFactor;
-    }
 
-    // Go back and interpolate elevations
-    if (info->interpolationFactor > 1)
+    // A previous run may have baked the processed kernels into a single file;
+    // its records are fixed size and load individually, so baked and per-file
+    // loading both go through the same on-demand path below.
+    m_bakedPath = searchPath + "/hrtf_composite.baked";
+    m_bakedValid = validateBaked(m_bakedPath);
+    m_bakedSaved = m_bakedValid;
+
+    // Load the band around the horizon now, still on the loader thread;
+    // everything else waits until a panner asks for it.
+    int horizon = info->indexFromElevationAngle(0);
+    int margin = PrefetchRawSlices * info->interpolationFactor;
+    std::lock_guard<std::mutex> lock(m_loadMutex);
+    ensureElevationRangeLocked(horizon - margin, horizon + margin);
+}
+
+HRTFDatabase::~HRTFDatabase()
+{
+    // A demand load may still be running on a pool worker; members must stay
+    // alive until it finishes. The task checks m_shutdown under the lock and
+    // notifies under the lock, so once this wait returns it touches nothing.
+    std::unique_lock<std::mutex> lock(m_loadMutex);
+    m_shutdown = true;
+    m_loadCondition.wait(lock, [this] { return m_loadsInFlight.load() == 0; });
+}
+
+void HRTFDatabase::ensureElevationRangeLocked(int firstIndex, int lastIndex)
+{
+    int maxIndex = info->numTotalElevations - 1;
+    firstIndex = std::max(0, firstIndex);
+    lastIndex = std::min(maxIndex, lastIndex);
+
+    for (int i = firstIndex; i <= lastIndex; ++i)
+        if (!std::atomic_load(&m_elevations[i]))
+            loadElevationLocked(i);
+
+    // Once use has swept every elevation, bake the complete processed set so
+    // the next launch skips the WAV decode and FFT entirely. Best effort; the
+    // assets directory may be read-only.
+    if (!m_bakedSaved)
     {
-        for (int i = 0; i < info->numTotalElevations; i += info->interpolationFactor)
+        bool complete = true;
+        for (auto & elevation : m_elevations)
         {
-            int j = (i + info->interpolationFactor);
-            
-            if (j >= info->numTotalElevations)
+            if (!std::atomic_load(&elevation))
             {
-                j = i; // for last elevation interpolate with itself
+                complete = false;
+                break;
             }
+        }
+        if (complete)
+            m_bakedSaved = saveBaked(m_bakedPath);
+    }
+}
+
+void HRTFDatabase::loadElevationLocked(int elevationIndex)
+{
+    int factor = info->interpolationFactor;
+    int maxIndex = info->numTotalElevations - 1;
+    int rawStart = (elevationIndex / factor) * factor;
+
+    // Returns the raw slice at rawIndex, loading and publishing it if needed.
+    auto rawSlice = [this, factor](int rawIndex) -> std::shared_ptr<HRTFElevation>
+    {
+        auto existing = std::atomic_load(&m_elevations[rawIndex]);
+        if (existing)
+            return existing;
+
+        if (m_bakedValid && loadBakedElevation(rawIndex))
+            return std::atomic_load(&m_elevations[rawIndex]);
+
+        int angle = info->minElevation + (rawIndex / factor) * info->rawElevationAngleSpacing;
+        std::shared_ptr<HRTFElevation> built = HRTFElevation::createForSubject(info.get(), angle);
+        if (built)
+            std::atomic_store(&m_elevations[rawIndex], built);
+        return built;
+    };
+
+    if (elevationIndex == rawStart)
+    {
+        rawSlice(elevationIndex);
+        return;
+    }
+
+    // An interpolated slice: the baked file stores it directly; otherwise
+    // create it from the raw slices bracketing it.
+    if (m_bakedValid && loadBakedElevation(elevationIndex))
+        return;
+
+    int next = rawStart + factor;
+    if (next > maxIndex)
+        next = rawStart; // for last elevation interpolate with itself
+
+    auto slice1 = rawSlice(rawStart);
+    auto slice2 = rawSlice(next);
+    if (!slice1 || !slice2)
+        return;
+
+    float x = static_cast<float>(elevationIndex - rawStart) / static_cast<float>(factor);
+    std::shared_ptr<HRTFElevation> interpolated = HRTFElevation::createByInterpolatingSlices(info.get(), slice1.get(), slice2.get(), x);
+    if (interpolated)
+        std::atomic_store(&m_elevations[elevationIndex], interpolated);
+}
+
+// Called from the render thread; must not block or touch the load mutex. A
+// miss costs one small task allocation, and the prefetch margin makes misses
+// rare once the scene's elevation band is resident.
+void HRTFDatabase::requestElevationAsync(int elevationIndex)
+{
+    bool expected = false;
+    if (!m_loadPending.compare_exchange_strong(expected, true))
+        return;
+
+    m_loadsInFlight.fetch_add(1);
+
+    int margin = PrefetchRawSlices * info->interpolationFactor;
+    ConvolutionWorkerPool::shared().enqueueTask([this, elevationIndex, margin]()
+    {
+        std::lock_guard<std::mutex> lock(m_loadMutex);
+        if (!m_shutdown)
+            ensureElevationRangeLocked(elevationIndex - margin, elevationIndex + margin);
+        m_loadPending.store(false);
+        m_loadsInFlight.fetch_sub(1);
+        // Notified under the lock so the destructor cannot finish between
+        // the decrement and the notify.
+        m_loadCondition.notify_all();
+    });
+}
+
+bool HRTFDatabase::validateBaked(const std::string & path)
+{
+    FILE * file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    BakedHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1
+        && !memcmp(header.magic, "LSHB", 4)
+        && header.version == BakedVersion
+        && header.sampleRate == info->sampleRate
+        && header.numElevations == static_cast<uint32_t>(info->numTotalElevations)
+        && header.numAzimuths == HRTFDatabase::numberOfAzimuths()
+        && header.fftSize && !(header.fftSize & (header.fftSize - 1));
+
+    if (ok)
+    {
+        // Records are fixed size; a short file would truncate the last one.
+        fseek(file, 0, SEEK_END);
+        long expected = static_cast<long>(sizeof(BakedHeader)
+            + header.numElevations * bakedRecordBytes(header.numAzimuths, header.fftSize));
+        ok = ftell(file) == expected;
+    }
+
+    fclose(file);
+
+    if (ok)
+        m_bakedFFTSize = header.fftSize;
+    return ok;
+}
 
-            // Create the interpolated convolution kernels and delays.
-            for (int jj = 1; jj < info->interpolationFactor; ++jj)
+bool HRTFDatabase::loadBakedElevation(int elevationIndex)
+{
+    uint32_t numAzimuths = HRTFDatabase::numberOfAzimuths();
+    size_t recordBytes = bakedRecordBytes(numAzimuths, m_bakedFFTSize);
+
+    FILE * file = fopen(m_bakedPath.c_str(), "rb");
+    if (!file)
+    {
+        m_bakedValid = false;
+        return false;
+    }
+
+    std::vector<uint8_t> record(recordBytes);
+    long offset = static_cast<long>(sizeof(BakedHeader) + elevationIndex * recordBytes);
+    bool ok = fseek(file, offset, SEEK_SET) == 0
+        && fread(record.data(), 1, recordBytes, file) == recordBytes;
+    fclose(file);
+
+    if (!ok)
+    {
+        // The file changed since validation; fall back to the per-file path.
+        m_bakedValid = false;
+        return false;
+    }
+
+    BakedReader reader;
+    reader.p = record.data();
+    reader.remaining = record.size();
+
+    size_t halfSize = m_bakedFFTSize / 2;
+
+    float elevationAngle = 0;
+    ok = reader.read(&elevationAngle, sizeof(elevationAngle));
+
+    std::unique_ptr<HRTFKernelList> kernelListL(new HRTFKernelList(numAzimuths));
+    std::unique_ptr<HRTFKernelList> kernelListR(new HRTFKernelList(numAzimuths));
+
+    for (uint32_t a = 0; ok && a < numAzimuths; ++a)
+    {
+        float delayL = 0;
+        float delayR = 0;
+        ok = reader.read(&delayL, sizeof(delayL)) && reader.read(&delayR, sizeof(delayR));
+        if (!ok)
+            break;
+
+        std::unique_ptr<FFTFrame> frameL(new FFTFrame(m_bakedFFTSize));
+        std::unique_ptr<FFTFrame> frameR(new FFTFrame(m_bakedFFTSize));
+
+        ok = reader.read(frameL->realData(), halfSize * sizeof(float))
+            && reader.read(frameL->imagData(), halfSize * sizeof(float))
+            && reader.read(frameR->realData(), halfSize * sizeof(float))
+            && reader.read(frameR->imagData(), halfSize * sizeof(float));
+        if (!ok)
+            break;
+
+        (*kernelListL)[a] = std::make_shared<HRTFKernel>(std::move(frameL), delayL, info->sampleRate);
+        (*kernelListR)[a] = std::make_shared<HRTFKernel>(std::move(frameR), delayR, info->sampleRate);
+    }
+
+    if (!ok)
+        return false;
+
+    std::shared_ptr<HRTFElevation> elevation = HRTFElevation::createFromBakedKernels(
+        info.get(), std::move(kernelListL), std::move(kernelListR), static_cast<int>(elevationAngle));
+    if (!elevation)
+        return false;
+
+    std::atomic_store(&m_elevations[elevationIndex], elevation);
+    return true;
+}
+
+bool HRTFDatabase::saveBaked(const std::string & path) const
+{
+    if (m_elevations.empty() || !m_elevations[0].get())
+        return false;
+
+    HRTFKernelList * firstList = m_elevations[0]->kernelListL();
+    if (!firstList || firstList->empty() || !(*firstList)[0])
+        return false;
+
+    uint32_t fftSize = static_cast<uint32_t>((*firstList)[0]->fftSize());
+    size_t halfSize = fftSize / 2;
+
+    // Write to a temporary and rename so a crash can't leave a truncated file
+    // that a later launch would have to reject.
+    std::string tempPath = path + ".tmp";
+    FILE * file = fopen(tempPath.c_str(), "wb");
+    if (!file)
+        return false;
+
+    BakedHeader header;
+    memcpy(header.magic, "LSHB", 4);
+    header.version = BakedVersion;
+    header.sampleRate = info->sampleRate;
+    header.numElevations = static_cast<uint32_t>(m_elevations.size());
+    header.numAzimuths = HRTFDatabase::numberOfAzimuths();
+    header.fftSize = fftSize;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    for (auto & elevation : m_elevations)
+    {
+        if (!ok || !elevation.get())
+        {
+            ok = false;
+            break;
+        }
+
+        float elevationAngle = static_cast<float>(elevation->elevationAngle());
+        ok = fwrite(&elevationAngle, sizeof(elevationAngle), 1, file) == 1;
+
+        HRTFKernelList * kernelListL = elevation->kernelListL();
+        HRTFKernelList * kernelListR = elevation->kernelListR();
+
+        for (uint32_t a = 0; ok && a < header.numAzimuths; ++a)
+        {
+            HRTFKernel * kernelL = (*kernelListL)[a].get();
+            HRTFKernel * kernelR = (*kernelListR)[a].get();
+            if (!kernelL || !kernelR || kernelL->fftSize() != fftSize || kernelR->fftSize() != fftSize)
             {
-                float x = static_cast<float>(jj) / static_cast<float>(info->interpolationFactor);
-                m_elevations[i + jj] = HRTFElevation::createByInterpolatingSlices(info.get(), m_elevations[i].get(), m_elevations[j].get(), x);
-                ASSERT(m_elevations[i + jj].get());
+                ok = false;
+                break;
             }
+
+            float delayL = kernelL->frameDelay();
+            float delayR = kernelR->frameDelay();
+            std::shared_ptr<FFTFrame> frameL = kernelL->fftFrame();
+            std::shared_ptr<FFTFrame> frameR = kernelR->fftFrame();
+            ok = fwrite(&delayL, sizeof(delayL), 1, file) == 1
+                && fwrite(&delayR, sizeof(delayR), 1, file) == 1
+                && fwrite(frameL->realData(), sizeof(float), halfSize, file) == halfSize
+                && fwrite(frameL->imagData(), sizeof(float), halfSize, file) == halfSize
+                && fwrite(frameR->realData(), sizeof(float), halfSize, file) == halfSize
+                && fwrite(frameR->imagData(), sizeof(float), halfSize, file) == halfSize;
         }
     }
+
+    ok = (fclose(file) == 0) && ok;
+
+    if (ok)
+        ok = (rename(tempPath.c_str(), path.c_str()) == 0);
+
+    if (!ok)
+        remove(tempPath.c_str());
+
+    return ok;
 }
 
 void HRTFDatabase::getKernelsFromAzimuthElevation(double azimuthBlend,
@@ -59,33 +392,68 @@ void HRTFDatabase::getKernelsFromAzimuthElevation(double azimuthBlend,
                                                   double & frameDelayL,
                                                   double & frameDelayR)
 {
-    
-    size_t elevationIndex = info->indexFromElevationAngle(elevationAngle);
-    
-    ASSERT(elevationIndex < m_elevations.size() && m_elevations.size() > 0);
-    
-    if (!m_elevations.size())
+
+    int elevationIndex = info->indexFromElevationAngle(elevationAngle);
+    int maxIndex = static_cast<int>(m_elevations.size()) - 1;
+
+    ASSERT(maxIndex >= 0);
+
+    if (maxIndex < 0)
     {
         kernelL = 0;
         kernelR = 0;
         return;
     }
-    
-    if (elevationIndex > m_elevations.size() - 1)
+
+    if (elevationIndex > maxIndex)
+        elevationIndex = maxIndex;
+
+    std::shared_ptr<HRTFElevation> hrtfElevation = std::atomic_load(&m_elevations[elevationIndex]);
+
+    if (!hrtfElevation)
+    {
+        // Not resident yet: kick a background load and pan with the nearest
+        // resident slice meanwhile; the approximation lasts until the loader
+        // publishes the requested band, typically a few quanta.
+        requestElevationAsync(elevationIndex);
+
+        for (int d = 1; !hrtfElevation && d <= maxIndex; ++d)
+        {
+            if (elevationIndex - d >= 0)
+                hrtfElevation = std::atomic_load(&m_elevations[elevationIndex - d]);
+            if (!hrtfElevation && elevationIndex + d <= maxIndex)
+                hrtfElevation = std::atomic_load(&m_elevations[elevationIndex + d]);
+        }
+    }
+    else
     {
-        elevationIndex = m_elevations.size() - 1;
+        // Resident, but prefetch before a moving source reaches the band edge.
+        bool nearEdge = (elevationIndex > 0 && !std::atomic_load(&m_elevations[elevationIndex - 1]))
+            || (elevationIndex < maxIndex && !std::atomic_load(&m_elevations[elevationIndex + 1]));
+        if (nearEdge)
+            requestElevationAsync(elevationIndex);
     }
-    
-    HRTFElevation * hrtfElevation = m_elevations[elevationIndex].get();
-    
+
     ASSERT(hrtfElevation);
-    
+
     if (!hrtfElevation)
     {
         throw std::runtime_error("Error getting hrtfElevation");
     }
-    
+
     hrtfElevation->getKernelsFromAzimuth(azimuthBlend, azimuthIndex, kernelL, kernelR, frameDelayL, frameDelayR);
-}                                                     
+}
+
+size_t HRTFDatabase::memoryBytes() const
+{
+    size_t bytes = 0;
+    for (auto & elevation : m_elevations)
+    {
+        auto resident = std::atomic_load(&elevation);
+        if (resident)
+            bytes += resident->memoryBytes();
+    }
+    return bytes;
+}
 
 } // namespace lab
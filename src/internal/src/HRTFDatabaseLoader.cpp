@@ -5,6 +5,7 @@
 #include "internal/HRTFDatabaseLoader.h"
 #include "internal/HRTFDatabase.h"
 #include "internal/Assertions.h"
+#include "internal/AudioThreads.h"
 
 #include <iostream>
 
@@ -48,6 +49,8 @@ HRTFDatabaseLoader::~HRTFDatabaseLoader()
 // Asynchronously load the database in this thread.
 void HRTFDatabaseLoader::databaseLoaderEntry(HRTFDatabaseLoader * threadData)
 {
+    ApplyThreadPolicy(AudioContext::ThreadRole::Background, "hrtf loader");
+
     std::lock_guard<std::mutex> locker(threadData->m_threadLock);
     HRTFDatabaseLoader * loader = reinterpret_cast<HRTFDatabaseLoader*>(threadData);
     ASSERT(loader);
@@ -97,4 +100,11 @@ HRTFDatabase * HRTFDatabaseLoader::defaultHRTFDatabase()
     return s_loader->database();
 }
 
+size_t HRTFDatabaseLoader::memoryBytes() const
+{
+    // The loader thread publishes m_hrtfDatabase once fully built; a poll
+    // that races the load simply reports zero for a frame.
+    return m_hrtfDatabase ? m_hrtfDatabase->memoryBytes() : 0;
+}
+
 } // namespace lab
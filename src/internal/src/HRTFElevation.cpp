@@ -215,6 +215,15 @@ std::unique_ptr<HRTFElevation> HRTFElevation::createByInterpolatingSlices(HRTFDa
     return std::unique_ptr<HRTFElevation>(new HRTFElevation(info, std::move(kernelListL), std::move(kernelListR), (int) angle));
 }
 
+std::unique_ptr<HRTFElevation> HRTFElevation::createFromBakedKernels(HRTFDatabaseInfo * info, std::unique_ptr<HRTFKernelList> kernelListL, std::unique_ptr<HRTFKernelList> kernelListR, int elevation)
+{
+    ASSERT(kernelListL && kernelListR && kernelListL->size() == NumberOfTotalAzimuths && kernelListR->size() == NumberOfTotalAzimuths);
+    if (!kernelListL || !kernelListR)
+        return nullptr;
+
+    return std::unique_ptr<HRTFElevation>(new HRTFElevation(info, std::move(kernelListL), std::move(kernelListR), elevation));
+}
+
 void HRTFElevation::getKernelsFromAzimuth(double azimuthBlend, unsigned azimuthIndex, HRTFKernel* &kernelL, HRTFKernel* &kernelR, double& frameDelayL, double& frameDelayR)
 {
     bool checkAzimuthBlend = azimuthBlend >= 0.0 && azimuthBlend < 1.0;
@@ -251,4 +260,18 @@ void HRTFElevation::getKernelsFromAzimuth(double azimuthBlend, unsigned azimuthI
     frameDelayR = (1.0 - azimuthBlend) * frameDelayR + azimuthBlend * frameDelay2R;
 }
 
+size_t HRTFElevation::memoryBytes() const
+{
+    size_t bytes = 0;
+    if (m_kernelListL)
+        for (auto & kernel : *m_kernelListL)
+            if (kernel)
+                bytes += kernel->memoryBytes();
+    if (m_kernelListR)
+        for (auto & kernel : *m_kernelListR)
+            if (kernel)
+                bytes += kernel->memoryBytes();
+    return bytes;
+}
+
 } // namespace lab
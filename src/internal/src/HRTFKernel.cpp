@@ -12,12 +12,45 @@
 #include "LabSound/core/Macros.h"
 
 #include <algorithm>
+#include <cmath>
+#include <deque>
+#include <mutex>
 
 using namespace std;
 
-namespace lab 
+namespace lab
 {
 
+namespace
+{
+    // Pins the float expansions of recently used kernels so steady-state
+    // panning never re-expands. Entries are kept in expansion order and the
+    // oldest is dropped first, which approximates LRU without touching the
+    // cache on every render-thread hit (a hit is one atomic shared_ptr load
+    // on the kernel itself). At the 44.1/48 kHz fft size of 512 the full
+    // cache is 512 KiB, against the tens of MB a fully expanded database
+    // used to hold.
+    struct HotKernelCache
+    {
+        static const size_t MaxEntries = 256;
+
+        struct Entry
+        {
+            HRTFKernel * owner;
+            std::shared_ptr<FFTFrame> frame;
+        };
+
+        std::mutex mutex;
+        std::deque<Entry> entries;
+    };
+
+    HotKernelCache & hotKernelCache()
+    {
+        static HotKernelCache cache;
+        return cache;
+    }
+}
+
 // Takes the input AudioChannel as an input impulse response and calculates the average group delay.
 // This represents the initial delay before the most energetic part of the impulse response.
 // The sample-frame delay is removed from the impulseP impulse response, and this value  is returned.
@@ -72,14 +105,130 @@ HRTFKernel::HRTFKernel(AudioChannel * channel, size_t fftSize, float sampleRate)
         }
     }
 
-    m_fftFrame = std::unique_ptr<FFTFrame>(new FFTFrame(fftSize));
-    m_fftFrame->doPaddedFFT(impulseResponse, truncatedResponseLength);
+    FFTFrame frame(fftSize);
+    frame.doPaddedFFT(impulseResponse, truncatedResponseLength);
+    quantize(frame);
+}
+
+HRTFKernel::HRTFKernel(std::unique_ptr<FFTFrame> fftFrame, float frameDelay, float sampleRate)
+: m_frameDelay(frameDelay)
+, m_sampleRate(sampleRate)
+{
+    ASSERT(fftFrame.get());
+    if (fftFrame)
+        quantize(*fftFrame);
+}
+
+HRTFKernel::~HRTFKernel()
+{
+    auto & cache = hotKernelCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    for (auto it = cache.entries.begin(); it != cache.entries.end();)
+    {
+        if (it->owner == this)
+            it = cache.entries.erase(it);
+        else
+            ++it;
+    }
+}
+
+void HRTFKernel::quantize(const FFTFrame & frame)
+{
+    m_fftSize = frame.fftSize();
+    size_t halfSize = m_fftSize / 2;
+
+    const float * realP = frame.realData();
+    const float * imagP = frame.imagData();
+
+    float maxAbs = 0;
+    for (size_t i = 0; i < halfSize; ++i)
+    {
+        maxAbs = std::max(maxAbs, fabsf(realP[i]));
+        maxAbs = std::max(maxAbs, fabsf(imagP[i]));
+    }
+
+    // One scale per kernel keeps expansion a single multiply; int16 against
+    // the kernel's own peak leaves ~90 dB of headroom below it.
+    m_quantScale = maxAbs > 0 ? maxAbs / 32767.f : 0;
+    float invScale = m_quantScale > 0 ? 1.f / m_quantScale : 0;
+
+    m_quantReal.resize(halfSize);
+    m_quantImag.resize(halfSize);
+    for (size_t i = 0; i < halfSize; ++i)
+    {
+        m_quantReal[i] = static_cast<int16_t>(lroundf(realP[i] * invScale));
+        m_quantImag[i] = static_cast<int16_t>(lroundf(imagP[i] * invScale));
+    }
+}
+
+std::shared_ptr<FFTFrame> HRTFKernel::fftFrame()
+{
+    auto frame = std::atomic_load(&m_expandedFrame);
+    if (frame)
+        return frame;
+
+    // Expand the quantized halves. A plain scaled-convert loop vectorizes;
+    // at fft size 512 this is cheaper than the convolution that follows, so
+    // a cache miss on the render thread costs a fraction of a quantum.
+    frame = std::make_shared<FFTFrame>(m_fftSize);
+    size_t halfSize = m_fftSize / 2;
+    float * realP = frame->realData();
+    float * imagP = frame->imagData();
+    const float scale = m_quantScale;
+    for (size_t i = 0; i < halfSize; ++i)
+    {
+        realP[i] = m_quantReal[i] * scale;
+        imagP[i] = m_quantImag[i] * scale;
+    }
+
+    std::atomic_store(&m_expandedFrame, frame);
+    cacheExpandedFrame(frame);
+    return frame;
+}
+
+void HRTFKernel::cacheExpandedFrame(const std::shared_ptr<FFTFrame> & frame)
+{
+    auto & cache = hotKernelCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+
+    for (auto & entry : cache.entries)
+    {
+        if (entry.owner == this)
+        {
+            entry.frame = frame;
+            return;
+        }
+    }
+
+    cache.entries.push_back({this, frame});
+
+    while (cache.entries.size() > HotKernelCache::MaxEntries)
+    {
+        HotKernelCache::Entry victim = cache.entries.front();
+        cache.entries.pop_front();
+
+        // Only drop the owner's reference if it still refers to the frame
+        // this entry pinned; the owner may have re-expanded since. A caller
+        // mid-quantum holds its own reference, so the frame cannot vanish
+        // under it.
+        std::shared_ptr<FFTFrame> none;
+        std::atomic_compare_exchange_strong(&victim.owner->m_expandedFrame, &victim.frame, none);
+    }
+}
+
+size_t HRTFKernel::memoryBytes() const
+{
+    size_t bytes = (m_quantReal.capacity() + m_quantImag.capacity()) * sizeof(int16_t);
+    auto frame = std::atomic_load(&m_expandedFrame);
+    if (frame)
+        bytes += frame->fftSize() * sizeof(float);
+    return bytes;
 }
 
 std::unique_ptr<AudioChannel> HRTFKernel::createImpulseResponse()
 {
     std::unique_ptr<AudioChannel> channel(new AudioChannel(fftSize()));
-    FFTFrame fftFrame(*m_fftFrame);
+    FFTFrame fftFrame(*this->fftFrame());
 
     // Add leading delay back in.
     fftFrame.addConstantGroupDelay(m_frameDelay);
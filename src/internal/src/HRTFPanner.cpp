@@ -24,6 +24,12 @@ const double MaxDelayTimeSeconds = 0.002;
 const int UninitializedAzimuth = -1;
 const uint32_t RenderingQuantum = 128;
 
+// A source moving less than this many degrees per render quantum (about
+// 3.5 degrees per second at 44.1kHz) is treated as stationary for crossfade
+// gating; its boundary jitter never opens the second convolver pair.
+const double StationaryAzimuthEpsilon = 0.01;
+const double StationaryElevationEpsilon = 1.0;
+
 HRTFPanner::HRTFPanner(const float sampleRate) : Panner(sampleRate, PanningMode::HRTF)
     , m_crossfadeSelection(CrossfadeSelection1)
     , m_azimuthIndex1(UninitializedAzimuth)
@@ -32,6 +38,9 @@ HRTFPanner::HRTFPanner(const float sampleRate) : Panner(sampleRate, PanningMode:
     , m_elevation2(0)
     , m_crossfadeX(0)
     , m_crossfadeIncr(0)
+    , m_lastAzimuth(0)
+    , m_lastElevation(0)
+    , m_haveLastDirection(false)
     , m_convolverL1(fftSizeForSampleRate(sampleRate))
     , m_convolverR1(fftSizeForSampleRate(sampleRate))
     , m_convolverL2(fftSizeForSampleRate(sampleRate))
@@ -60,6 +69,7 @@ uint32_t HRTFPanner::fftSizeForSampleRate(float sampleRate)
 
 void HRTFPanner::reset()
 {
+    m_haveLastDirection = false;
     m_convolverL1.reset();
     m_convolverR1.reset();
     m_convolverL2.reset();
@@ -93,6 +103,30 @@ int HRTFPanner::calculateDesiredAzimuthIndexAndBlend(double azimuth, double& azi
     return desiredAzimuthIndex;
 }
 
+bool HRTFPanner::shouldHoldKernel(int desiredAzimuthIndex, int activeAzimuthIndex, double elevation, double activeElevation,
+                                  bool stationary, int numberOfAzimuths, double & azimuthBlend) const
+{
+    if (!stationary)
+        return false;
+
+    if (fabs(elevation - activeElevation) > StationaryElevationEpsilon)
+        return false;
+
+    // The hold is only valid while the desired position stays within one
+    // azimuth step of the held index; anything further is real motion.
+    int signedDistance = desiredAzimuthIndex - activeAzimuthIndex;
+    if (signedDistance > numberOfAzimuths / 2)
+        signedDistance -= numberOfAzimuths;
+    if (signedDistance < -numberOfAzimuths / 2)
+        signedDistance += numberOfAzimuths;
+
+    if (signedDistance < -1 || signedDistance > 1)
+        return false;
+
+    azimuthBlend = min(1.0, max(0.0, azimuthBlend + signedDistance));
+    return true;
+}
+
 void HRTFPanner::pan(ContextRenderLock & r, double desiredAzimuth, double elevation, const AudioBus * inputBus, AudioBus * outputBus, size_t framesToProcess)
 {
     size_t numInputChannels = inputBus ? inputBus->numberOfChannels() : 0;
@@ -146,6 +180,27 @@ void HRTFPanner::pan(ContextRenderLock & r, double desiredAzimuth, double elevat
     double azimuthBlend;
     int desiredAzimuthIndex = calculateDesiredAzimuthIndexAndBlend(azimuth, azimuthBlend);
 
+    // Estimate angular motion since the previous quantum. A stationary source
+    // hovering at an azimuth-index boundary would otherwise flip indices every
+    // few quanta and keep both convolver pairs hot through back-to-back
+    // crossfades.
+    bool stationary = false;
+    if (m_haveLastDirection)
+    {
+        double deltaAzimuth = azimuth - m_lastAzimuth;
+        if (deltaAzimuth > 180.0)
+            deltaAzimuth -= 360.0;
+        if (deltaAzimuth < -180.0)
+            deltaAzimuth += 360.0;
+
+        const double quanta = double(framesToProcess) / RenderingQuantum;
+        stationary = fabs(deltaAzimuth) < StationaryAzimuthEpsilon * quanta
+            && fabs(elevation - m_lastElevation) < StationaryElevationEpsilon;
+    }
+    m_lastAzimuth = azimuth;
+    m_lastElevation = elevation;
+    m_haveLastDirection = true;
+
     // Initially snap azimuth and elevation values to first values encountered.
     if (m_azimuthIndex1 == UninitializedAzimuth)
     {
@@ -167,7 +222,8 @@ void HRTFPanner::pan(ContextRenderLock & r, double desiredAzimuth, double elevat
     // Check for azimuth and elevation changes, initiating a cross-fade if needed.
     if (!m_crossfadeX && m_crossfadeSelection == CrossfadeSelection1)
     {
-        if (desiredAzimuthIndex != m_azimuthIndex1 || elevation != m_elevation1) 
+        if ((desiredAzimuthIndex != m_azimuthIndex1 || elevation != m_elevation1)
+            && !shouldHoldKernel(desiredAzimuthIndex, m_azimuthIndex1, elevation, m_elevation1, stationary, database->numberOfAzimuths(), azimuthBlend))
         {
             // Cross-fade from 1 -> 2
             m_crossfadeIncr = 1 / fadeFrames;
@@ -178,7 +234,8 @@ void HRTFPanner::pan(ContextRenderLock & r, double desiredAzimuth, double elevat
 
     if (m_crossfadeX == 1 && m_crossfadeSelection == CrossfadeSelection2)
     {
-        if (desiredAzimuthIndex != m_azimuthIndex2 || elevation != m_elevation2) 
+        if ((desiredAzimuthIndex != m_azimuthIndex2 || elevation != m_elevation2)
+            && !shouldHoldKernel(desiredAzimuthIndex, m_azimuthIndex2, elevation, m_elevation2, stationary, database->numberOfAzimuths(), azimuthBlend))
         {
             // Cross-fade from 2 -> 1
             m_crossfadeIncr = -1 / fadeFrames;
@@ -249,16 +306,22 @@ void HRTFPanner::pan(ContextRenderLock & r, double desiredAzimuth, double elevat
 
         // Now do the convolutions.
         // Note that we avoid doing convolutions on both sets of convolvers if we're not currently cross-fading.
-        if (m_crossfadeSelection == CrossfadeSelection1 || needsCrossfading) 
+        // The shared_ptrs keep the expanded frames alive through the segment
+        // even if the kernel hot cache evicts them mid-render.
+        if (m_crossfadeSelection == CrossfadeSelection1 || needsCrossfading)
         {
-            m_convolverL1.process(kernelL1->fftFrame(), segmentDestinationL, convolutionDestinationL1, framesPerSegment);
-            m_convolverR1.process(kernelR1->fftFrame(), segmentDestinationR, convolutionDestinationR1, framesPerSegment);
+            std::shared_ptr<FFTFrame> frameL1 = kernelL1->fftFrame();
+            std::shared_ptr<FFTFrame> frameR1 = kernelR1->fftFrame();
+            m_convolverL1.process(frameL1.get(), segmentDestinationL, convolutionDestinationL1, framesPerSegment);
+            m_convolverR1.process(frameR1.get(), segmentDestinationR, convolutionDestinationR1, framesPerSegment);
         }
 
-        if (m_crossfadeSelection == CrossfadeSelection2 || needsCrossfading) 
+        if (m_crossfadeSelection == CrossfadeSelection2 || needsCrossfading)
         {
-            m_convolverL2.process(kernelL2->fftFrame(), segmentDestinationL, convolutionDestinationL2, framesPerSegment);
-            m_convolverR2.process(kernelR2->fftFrame(), segmentDestinationR, convolutionDestinationR2, framesPerSegment);
+            std::shared_ptr<FFTFrame> frameL2 = kernelL2->fftFrame();
+            std::shared_ptr<FFTFrame> frameR2 = kernelR2->fftFrame();
+            m_convolverL2.process(frameL2.get(), segmentDestinationL, convolutionDestinationL2, framesPerSegment);
+            m_convolverR2.process(frameR2.get(), segmentDestinationR, convolutionDestinationR2, framesPerSegment);
         }
         
         if (needsCrossfading) 
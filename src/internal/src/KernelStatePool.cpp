@@ -0,0 +1,106 @@
+// License: BSD 3 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "internal/KernelStatePool.h"
+
+#include <cstring>
+
+namespace lab {
+
+namespace {
+
+    size_t roundUpToAlignment(size_t bytes)
+    {
+        return (bytes + KernelStatePool::Alignment - 1) & ~(KernelStatePool::Alignment - 1);
+    }
+
+}
+
+static_assert(KernelStatePool::Alignment == kAudioBufferAlignment,
+              "slabs come from the shared aligned-allocation facility");
+
+KernelStatePool & KernelStatePool::instance()
+{
+    static KernelStatePool pool;
+    return pool;
+}
+
+void KernelStatePool::addSlab(SizeClass & sizeClass)
+{
+    // Slabs come from the shared aligned-allocation facility, so the base is
+    // cache-line aligned by construction and blocks stay aligned since
+    // blockBytes is a multiple of the alignment.
+    size_t slabBytes = sizeClass.blockBytes * SlabBlocks;
+    std::unique_ptr<uint8_t[], AlignedSlabFree> slab(static_cast<uint8_t *>(audioBufferAllocate(slabBytes)));
+    uint8_t * base = slab.get();
+
+    // Thread the fresh blocks onto the free list back to front, so they are
+    // handed out in address order and consecutive allocations sit adjacent.
+    for (size_t i = SlabBlocks; i > 0; --i)
+    {
+        uint8_t * block = base + (i - 1) * sizeClass.blockBytes;
+        *reinterpret_cast<void **>(block) = sizeClass.freeList;
+        sizeClass.freeList = block;
+    }
+
+    sizeClass.slabs.push_back(std::move(slab));
+}
+
+void * KernelStatePool::allocate(size_t bytes)
+{
+    if (!bytes || bytes > MaxPooledBytes)
+        return ::operator new(bytes);
+
+    size_t blockBytes = roundUpToAlignment(bytes);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    SizeClass & sizeClass = m_classes[blockBytes];
+    sizeClass.blockBytes = blockBytes;
+
+    if (!sizeClass.freeList)
+        addSlab(sizeClass);
+
+    void * block = sizeClass.freeList;
+    sizeClass.freeList = *reinterpret_cast<void **>(block);
+    ++sizeClass.liveBlocks;
+    return block;
+}
+
+void KernelStatePool::deallocate(void * p, size_t bytes)
+{
+    if (!p)
+        return;
+
+    if (!bytes || bytes > MaxPooledBytes)
+    {
+        ::operator delete(p);
+        return;
+    }
+
+    size_t blockBytes = roundUpToAlignment(bytes);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    SizeClass & sizeClass = m_classes[blockBytes];
+    *reinterpret_cast<void **>(p) = sizeClass.freeList;
+    sizeClass.freeList = p;
+    --sizeClass.liveBlocks;
+}
+
+KernelStatePool::Stats KernelStatePool::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Stats stats;
+    stats.sizeClasses = m_classes.size();
+    for (auto & entry : m_classes)
+    {
+        stats.slabs += entry.second.slabs.size();
+        stats.liveBlocks += entry.second.liveBlocks;
+        stats.reservedBytes += entry.second.slabs.size() * (entry.second.blockBytes * SlabBlocks);
+    }
+    return stats;
+}
+
+} // namespace lab
@@ -6,6 +6,7 @@
 
 #include "internal/MultiChannelResampler.h"
 #include "internal/Assertions.h"
+#include "internal/VectorMath.h"
 
 namespace lab {
 
@@ -35,7 +36,7 @@ public:
 
         // Get the data from the multi-channel provider when the first channel asks for it.
         // For subsequent channels, we can just dish out the channel data from that (stored in m_multiChannelBus).
-        if (m_currentChannel != 0) {
+        if (m_currentChannel == 0) {
             m_framesToProcess = framesToProcess;
             m_multiChannelBus = std::unique_ptr<AudioBus>(new AudioBus(m_numberOfChannels, framesToProcess));
             m_multiChannelProvider->provideInput(m_multiChannelBus.get(), framesToProcess);
@@ -68,16 +69,57 @@ private:
 
 } // namespace
 
-MultiChannelResampler::MultiChannelResampler(double scaleFactor, unsigned numberOfChannels)
+MultiChannelResampler::MultiChannelResampler(double scaleFactor, unsigned numberOfChannels, ResamplerQuality quality)
     : m_numberOfChannels(numberOfChannels)
 {
+    const size_t kernelSize = SincResampler::kernelSizeForQuality(quality);
+
+    if (numberOfChannels > 1 && numberOfChannels <= SincResampler::MaxInterleavedChannels)
+    {
+        // All channels advance through one interleaved resampler, touching
+        // the kernel table once per output frame instead of once per channel.
+        m_interleavedKernel.reset(new SincResampler(scaleFactor, kernelSize, 32, numberOfChannels));
+        return;
+    }
+
     // Create each channel's resampler.
     for (unsigned channelIndex = 0; channelIndex < numberOfChannels; ++channelIndex)
-        m_kernels.push_back(std::unique_ptr<SincResampler>(new SincResampler(scaleFactor)));
+        m_kernels.push_back(std::unique_ptr<SincResampler>(new SincResampler(scaleFactor, kernelSize)));
 }
 
 void MultiChannelResampler::process(ContextRenderLock&, AudioSourceProvider* provider, AudioBus* destination, size_t framesToProcess)
 {
+    if (m_interleavedKernel)
+    {
+        // The interleaved kernel consumes the multi-channel provider
+        // directly; deinterleave its output frames into the planar
+        // destination channels.
+        if (m_interleavedOutput.size() < framesToProcess * m_numberOfChannels)
+            m_interleavedOutput.allocate(framesToProcess * m_numberOfChannels);
+
+        float* interleaved = m_interleavedOutput.data();
+        m_interleavedKernel->process(provider, interleaved, framesToProcess);
+
+        if (m_numberOfChannels == 2)
+        {
+            VectorMath::vdeintlve(interleaved,
+                                  destination->channel(0)->mutableData(),
+                                  destination->channel(1)->mutableData(),
+                                  framesToProcess);
+        }
+        else
+        {
+            for (unsigned c = 0; c < m_numberOfChannels; ++c)
+            {
+                float* dest = destination->channel(c)->mutableData();
+                const float* source = interleaved + c;
+                for (size_t i = 0; i < framesToProcess; ++i, source += m_numberOfChannels)
+                    dest[i] = *source;
+            }
+        }
+        return;
+    }
+
     // The provider can provide us with multi-channel audio data. But each of our single-channel resamplers (kernels)
     // below requires a provider which provides a single unique channel of data.
     // channelProvider wraps the original multi-channel provider and dishes out one channel at a time.
@@ -0,0 +1,115 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "internal/NonlinearityTable.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace lab {
+
+uint64_t NonlinearityTable::mixKey(uint64_t key, float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    // splitmix64-style mixing so nearby parameter values land far apart
+    key ^= bits + 0x9E3779B97F4A7C15ull + (key << 6) + (key >> 2);
+    return key;
+}
+
+bool NonlinearityTable::ensure(float inputMin, float inputMax, size_t tableLength, uint64_t shapeKey,
+                               const std::function<float(float)> & shape)
+{
+    if (m_table.size() == tableLength && m_inputMin == inputMin && m_inputMax == inputMax && m_shapeKey == shapeKey)
+        return false;
+
+    if (tableLength < 2 || !(inputMax > inputMin))
+    {
+        m_table.clear();
+        return false;
+    }
+
+    m_table.resize(tableLength);
+    float step = (inputMax - inputMin) / float(tableLength - 1);
+    for (size_t i = 0; i < tableLength; ++i)
+        m_table[i] = shape(inputMin + step * float(i));
+
+    m_inputMin = inputMin;
+    m_inputMax = inputMax;
+    m_shapeKey = shapeKey;
+    return true;
+}
+
+void NonlinearityTable::apply(const float * source, float * destination, size_t framesToProcess) const
+{
+    applyTable(m_table.data(), m_table.size(), m_inputMin, m_inputMax, source, destination, framesToProcess);
+}
+
+void NonlinearityTable::applyTable(const float * tableData, size_t tableLength,
+                                   float inputMin, float inputMax,
+                                   const float * source, float * destination, size_t framesToProcess)
+{
+    // Map [inputMin, inputMax] onto the table with linear interpolation
+    // between adjacent entries; input outside the range clamps to the ends.
+    const float scale = float(tableLength - 1) / (inputMax - inputMin);
+    const float maxIndex = float(tableLength - 1);
+
+    size_t n4 = framesToProcess & ~size_t(3);
+#ifdef __SSE2__
+    // index computation and clamping are branch-free in vector registers;
+    // SSE2 has no gather, so the paired table loads stay scalar
+    const __m128 vScale = _mm_set1_ps(scale);
+    const __m128 vMin = _mm_set1_ps(inputMin);
+    const __m128 vMax = _mm_set1_ps(maxIndex);
+    const __m128 vMaxBase = _mm_set1_ps(float(tableLength - 2));
+
+    for (size_t f = 0; f < n4; f += 4)
+    {
+        __m128 v = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(source + f), vMin), vScale);
+        v = _mm_max_ps(v, _mm_setzero_ps());
+        v = _mm_min_ps(v, vMax);
+
+        // v >= 0, so truncation is floor; the base index is capped at
+        // tableLength - 2 so the i+1 load is always in range (frac then
+        // reaches 1.0 for an input at the very top of the table)
+        __m128 vBase = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+        vBase = _mm_min_ps(vBase, vMaxBase);
+        __m128 frac = _mm_sub_ps(v, vBase);
+
+        alignas(16) int idx[4];
+        alignas(16) float fr[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(idx), _mm_cvttps_epi32(vBase));
+        _mm_store_ps(fr, frac);
+
+        for (int k = 0; k < 4; ++k)
+        {
+            float c0 = tableData[idx[k]];
+            float c1 = tableData[idx[k] + 1];
+            destination[f + k] = c0 + fr[k] * (c1 - c0);
+        }
+    }
+#else
+    for (size_t f = 0; f < n4; ++f)
+    {
+        float v = (source[f] - inputMin) * scale;
+        v = std::max(0.f, std::min(v, maxIndex));
+        size_t base = std::min(static_cast<size_t>(v), tableLength - 2);
+        float frac = v - base;
+        destination[f] = tableData[base] + frac * (tableData[base + 1] - tableData[base]);
+    }
+#endif
+    for (size_t f = n4; f < framesToProcess; ++f)
+    {
+        float v = (source[f] - inputMin) * scale;
+        v = std::max(0.f, std::min(v, maxIndex));
+        size_t base = std::min(static_cast<size_t>(v), tableLength - 2);
+        float frac = v - base;
+        destination[f] = tableData[base] + frac * (tableData[base + 1] - tableData[base]);
+    }
+}
+
+} // namespace lab
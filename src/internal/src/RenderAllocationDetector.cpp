@@ -0,0 +1,283 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#ifdef LABSOUND_RENDER_ALLOC_DETECTOR
+
+#include "internal/RenderAllocationDetector.h"
+
+#include "LabSound/core/AudioNode.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define LABSOUND_ALLOC_CALL_SITE() _ReturnAddress()
+#else
+#define LABSOUND_ALLOC_CALL_SITE() __builtin_return_address(0)
+#endif
+
+namespace lab
+{
+namespace RenderAllocationDetector
+{
+
+namespace
+{
+    // Per-thread state: the render-span depth (render() could in principle
+    // nest through a sub-destination) and the node being processed. The hook
+    // guard keeps the recorder's own bookkeeping from re-entering itself.
+    thread_local int t_renderSpanDepth = 0;
+    thread_local AudioNode * t_currentNode = nullptr;
+    thread_local bool t_inHook = false;
+
+    std::atomic<bool> g_detect{false};
+    std::atomic<bool> g_hardFail{false};
+
+    std::atomic<uint64_t> g_totalAllocations{0};
+    std::atomic<uint64_t> g_totalBytes{0};
+
+    // Open-addressed table of distinct allocating return addresses. Fixed
+    // size and lock-free so recording is safe inside operator new on the
+    // render thread; a full table folds the remainder into the last slot.
+    const size_t kSiteTableSize = 256;
+
+    struct Site
+    {
+        std::atomic<const void *> address{nullptr};
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> bytes{0};
+    };
+
+    Site g_sites[kSiteTableSize];
+
+    void recordSite(const void * address, size_t bytes)
+    {
+        size_t h = (reinterpret_cast<uintptr_t>(address) >> 4) % (kSiteTableSize - 1);
+        for (size_t probe = 0; probe < kSiteTableSize - 1; ++probe)
+        {
+            Site & site = g_sites[(h + probe) % (kSiteTableSize - 1)];
+            const void * expected = nullptr;
+            if (site.address.load(std::memory_order_relaxed) == address ||
+                site.address.compare_exchange_strong(expected, address, std::memory_order_relaxed))
+            {
+                site.count.fetch_add(1, std::memory_order_relaxed);
+                site.bytes.fetch_add(bytes, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        // table full; the overflow slot aggregates whatever did not fit
+        g_sites[kSiteTableSize - 1].count.fetch_add(1, std::memory_order_relaxed);
+        g_sites[kSiteTableSize - 1].bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    // One-time opt-in from the environment so CI can instrument a test run
+    // without touching its source.
+    bool readEnvironment()
+    {
+        const char * detect = getenv("LABSOUND_RENDER_ALLOC_DETECT");
+        if (detect && *detect && *detect != '0')
+            g_detect.store(true, std::memory_order_relaxed);
+
+        const char * hardFail = getenv("LABSOUND_RENDER_ALLOC_HARDFAIL");
+        if (hardFail && *hardFail && *hardFail != '0')
+        {
+            g_detect.store(true, std::memory_order_relaxed);
+            g_hardFail.store(true, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    void noteAllocation(const void * callSite, size_t bytes)
+    {
+        static bool envRead = readEnvironment();
+        (void) envRead;
+
+        if (t_inHook || !t_renderSpanDepth || !g_detect.load(std::memory_order_relaxed))
+            return;
+
+        t_inHook = true;
+
+        g_totalAllocations.fetch_add(1, std::memory_order_relaxed);
+        g_totalBytes.fetch_add(bytes, std::memory_order_relaxed);
+        recordSite(callSite, bytes);
+
+        if (t_currentNode)
+            t_currentNode->countRenderAllocation(bytes);
+
+        if (g_hardFail.load(std::memory_order_relaxed))
+        {
+            // fprintf rather than the logging machinery: we are inside
+            // operator new on the render thread and about to abort anyway.
+            fprintf(stderr,
+                    "LabSound: heap allocation of %zu bytes on the render thread, call site %p "
+                    "(symbolize against the unstripped binary)\n",
+                    bytes, callSite);
+            abort();
+        }
+
+        t_inHook = false;
+    }
+}
+
+void setDetectionEnabled(bool enabled)
+{
+    g_detect.store(enabled, std::memory_order_relaxed);
+}
+
+bool detectionEnabled()
+{
+    return g_detect.load(std::memory_order_relaxed);
+}
+
+void setHardFailEnabled(bool enabled)
+{
+    g_hardFail.store(enabled, std::memory_order_relaxed);
+}
+
+bool hardFailEnabled()
+{
+    return g_hardFail.load(std::memory_order_relaxed);
+}
+
+std::vector<CallSite> callSites()
+{
+    std::vector<CallSite> sites;
+    for (size_t i = 0; i < kSiteTableSize; ++i)
+    {
+        uint64_t count = g_sites[i].count.load(std::memory_order_relaxed);
+        if (!count)
+            continue;
+
+        CallSite site;
+        site.returnAddress = g_sites[i].address.load(std::memory_order_relaxed);
+        site.count = count;
+        site.bytes = g_sites[i].bytes.load(std::memory_order_relaxed);
+        sites.push_back(site);
+    }
+
+    std::sort(sites.begin(), sites.end(), [](const CallSite & a, const CallSite & b) {
+        return a.count > b.count;
+    });
+
+    return sites;
+}
+
+uint64_t totalAllocations()
+{
+    return g_totalAllocations.load(std::memory_order_relaxed);
+}
+
+uint64_t totalBytes()
+{
+    return g_totalBytes.load(std::memory_order_relaxed);
+}
+
+void reset()
+{
+    for (size_t i = 0; i < kSiteTableSize; ++i)
+    {
+        g_sites[i].address.store(nullptr, std::memory_order_relaxed);
+        g_sites[i].count.store(0, std::memory_order_relaxed);
+        g_sites[i].bytes.store(0, std::memory_order_relaxed);
+    }
+    g_totalAllocations.store(0, std::memory_order_relaxed);
+    g_totalBytes.store(0, std::memory_order_relaxed);
+}
+
+RenderSpan::RenderSpan()
+{
+    ++t_renderSpanDepth;
+}
+
+RenderSpan::~RenderSpan()
+{
+    --t_renderSpanDepth;
+}
+
+NodeScope::NodeScope(AudioNode * node)
+    : m_previous(t_currentNode)
+{
+    t_currentNode = node;
+}
+
+NodeScope::~NodeScope()
+{
+    t_currentNode = m_previous;
+}
+
+}  // namespace RenderAllocationDetector
+}  // namespace lab
+
+// Global interposition. Only compiled into instrumented builds; the hooks
+// cost a thread-local load and a branch per allocation when detection is off.
+void * operator new(size_t size)
+{
+    void * p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    lab::RenderAllocationDetector::noteAllocation(LABSOUND_ALLOC_CALL_SITE(), size);
+    return p;
+}
+
+void * operator new[](size_t size)
+{
+    void * p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    lab::RenderAllocationDetector::noteAllocation(LABSOUND_ALLOC_CALL_SITE(), size);
+    return p;
+}
+
+void * operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    void * p = malloc(size ? size : 1);
+    if (p)
+        lab::RenderAllocationDetector::noteAllocation(LABSOUND_ALLOC_CALL_SITE(), size);
+    return p;
+}
+
+void * operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    void * p = malloc(size ? size : 1);
+    if (p)
+        lab::RenderAllocationDetector::noteAllocation(LABSOUND_ALLOC_CALL_SITE(), size);
+    return p;
+}
+
+void operator delete(void * p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void * p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void * p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void * p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete(void * p, const std::nothrow_t &) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void * p, const std::nothrow_t &) noexcept
+{
+    free(p);
+}
+
+#endif  // LABSOUND_RENDER_ALLOC_DETECTOR
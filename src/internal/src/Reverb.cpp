@@ -3,6 +3,7 @@
 // Copyright (C) 2015+, The LabSound Authors. All rights reserved.
 
 #include "internal/Reverb.h"
+#include "internal/ConvolutionWorkerPool.h"
 #include "internal/ReverbConvolver.h"
 #include "internal/VectorMath.h"
 #include "internal/Assertions.h"
@@ -12,6 +13,7 @@
 #include "LabSound/extended/AudioFileReader.h"
 
 #include <math.h>
+#include <string.h>
 
 #if defined(LABSOUND_PLATFORM_OSX)
 using namespace std;
@@ -28,6 +30,34 @@ const float GainCalibrationSampleRate = 44100;
 // A minimum power value to when normalizing a silent (or very quiet) impulse response
 const float MinPower = 0.000125f;
     
+// FNV-1a over the raw response samples and the partitioning parameters. The
+// hash is taken before normalization scaling so that scale/unscale roundoff
+// can't produce a different key for the same source material.
+static uint64_t hashImpulseResponse(AudioBus * response, size_t renderSliceSize, size_t maxFFTSize, bool useBackgroundThreads, bool normalize)
+{
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](const void * data, size_t bytes)
+    {
+        const uint8_t * p = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < bytes; ++i)
+        {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+    };
+
+    for (size_t c = 0; c < response->numberOfChannels(); ++c)
+        mix(response->channel(c)->data(), response->length() * sizeof(float));
+
+    uint64_t params[4] = { renderSliceSize, maxFFTSize, useBackgroundThreads ? 1u : 0u, normalize ? 1u : 0u };
+    mix(params, sizeof(params));
+
+    float sampleRate = response->sampleRate();
+    mix(&sampleRate, sizeof(sampleRate));
+
+    return h ? h : 1;  // 0 means "don't cache"
+}
+
 static float calculateNormalizationScale(AudioBus* response)
 {
     // Normalize by RMS power
@@ -66,22 +96,24 @@ static float calculateNormalizationScale(AudioBus* response)
 
 Reverb::Reverb(AudioBus* impulseResponse, size_t renderSliceSize, size_t maxFFTSize, size_t numberOfChannels, bool useBackgroundThreads, bool normalize)
 {
-    float scale = 1;
-
-    if (normalize) {
-        scale = calculateNormalizationScale(impulseResponse);
-
-        if (scale)
-            impulseResponse->scale(scale);
+    m_responseHash = hashImpulseResponse(impulseResponse, renderSliceSize, maxFFTSize, useBackgroundThreads, normalize);
+
+    float scale = normalize ? calculateNormalizationScale(impulseResponse) : 1;
+
+    if (normalize && scale != 1) {
+        // Scale a temporary copy rather than scaling and unscaling the caller's
+        // buffer in place; the old approach left roundoff behind, which both
+        // perturbed the source material and made the content hash (and thus the
+        // kernel cache key) unstable across repeated construction.
+        AudioBus scaled(impulseResponse->numberOfChannels(), impulseResponse->length());
+        scaled.setSampleRate(impulseResponse->sampleRate());
+        scaled.copyFrom(*impulseResponse, ChannelInterpretation::Discrete);
+        scaled.scale(scale);
+        initialize(&scaled, renderSliceSize, maxFFTSize, numberOfChannels, useBackgroundThreads);
+    }
+    else {
+        initialize(impulseResponse, renderSliceSize, maxFFTSize, numberOfChannels, useBackgroundThreads);
     }
-
-    initialize(impulseResponse, renderSliceSize, maxFFTSize, numberOfChannels, useBackgroundThreads);
-
-    // Undo scaling since this shouldn't be a destructive operation on impulseResponse.
-    // FIXME: What about roundoff? Perhaps consider making a temporary scaled copy
-    // instead of scaling and unscaling in place.
-    if (normalize && scale)
-        impulseResponse->scale(1 / scale);
 }
 
 void Reverb::initialize(AudioBus* impulseResponseBuffer, size_t renderSliceSize, size_t maxFFTSize, size_t numberOfChannels, bool useBackgroundThreads)
@@ -96,10 +128,14 @@ void Reverb::initialize(AudioBus* impulseResponseBuffer, size_t renderSliceSize,
     for (size_t i = 0; i < numResponseChannels; ++i) {
         AudioChannel* channel = impulseResponseBuffer->channel(i);
 
+        // decorrelate the per-channel cache keys so each channel's kernels
+        // are cached separately
+        uint64_t channelKey = m_responseHash ? m_responseHash ^ (0x9e3779b97f4a7c15ull * (i + 1)) : 0;
+
         m_convolvers.push_back(
            std::unique_ptr<ReverbConvolver>(
                new ReverbConvolver(channel, renderSliceSize, maxFFTSize,
-                                  convolverRenderPhase, useBackgroundThreads)));
+                                  convolverRenderPhase, useBackgroundThreads, channelKey)));
 
         convolverRenderPhase += renderSliceSize;
     }
@@ -136,26 +172,33 @@ void Reverb::process(ContextRenderLock& r, const AudioBus* sourceBus, AudioBus*
     size_t numOutputChannels = destinationBus->numberOfChannels();
     size_t numReverbChannels = m_convolvers.size();
 
+    // The per-channel convolvers are independent, so the multi-convolver
+    // matrixing cases below fork their convolutions across the shared worker
+    // pool and join before assembling the output; a true-stereo response then
+    // costs close to one channel's wall time instead of four.
     if (numInputChannels == Channels::Stereo && numReverbChannels == Channels::Stereo && numOutputChannels == Channels::Stereo) {
         // 2 -> 2 -> 2
         const AudioChannel* sourceChannelR = sourceBus->channelByType(Channel::Right);
         AudioChannel* destinationChannelR = destinationBus->channelByType(Channel::Right);
-        m_convolvers[0]->process(r, sourceChannelL, destinationChannelL, framesToProcess);
-        m_convolvers[1]->process(r, sourceChannelR, destinationChannelR, framesToProcess);
+        ConvolutionJob jobs[2] = {
+            { m_convolvers[0].get(), sourceChannelL, destinationChannelL, &r, framesToProcess },
+            { m_convolvers[1].get(), sourceChannelR, destinationChannelR, &r, framesToProcess }};
+        ConvolutionWorkerPool::shared().runParallel(jobs, 2);
     } else if (numInputChannels == Channels::Stereo && numReverbChannels == Channels::Mono && numOutputChannels == Channels::Stereo) {
         // LabSound added this case, should submit it back to WebKit after it's known to work correctly
         // because the initialize method says that a mono-IR is expected to work with a stero in/out setup
         // 2 -> 1 -> 2
+        // Both passes go through the same convolver, so they stay serial.
         const AudioChannel* sourceChannelR = sourceBus->channelByType(Channel::Right);
         AudioChannel* destinationChannelR = destinationBus->channelByType(Channel::Right);
         m_convolvers[0]->process(r, sourceChannelL, destinationChannelL, framesToProcess);
         m_convolvers[0]->process(r, sourceChannelR, destinationChannelR, framesToProcess);
     } else  if (numInputChannels == Channels::Mono && numOutputChannels == Channels::Stereo && numReverbChannels == Channels::Stereo) {
         // 1 -> 2 -> 2
-        for (int i = 0; i < 2; ++i) {
-            AudioChannel* destinationChannel = destinationBus->channel(i);
-            m_convolvers[i]->process(r, sourceChannelL, destinationChannel, framesToProcess);
-        }
+        ConvolutionJob jobs[2] = {
+            { m_convolvers[0].get(), sourceChannelL, destinationBus->channel(0), &r, framesToProcess },
+            { m_convolvers[1].get(), sourceChannelL, destinationBus->channel(1), &r, framesToProcess }};
+        ConvolutionWorkerPool::shared().runParallel(jobs, 2);
     } else if (numInputChannels == Channels::Mono && numReverbChannels == Channels::Mono && numOutputChannels == Channels::Stereo) {
         // 1 -> 1 -> 2
         m_convolvers[0]->process(r, sourceChannelL, destinationChannelL, framesToProcess);
@@ -178,13 +221,14 @@ void Reverb::process(ContextRenderLock& r, const AudioBus* sourceBus, AudioBus*
         AudioChannel* tempChannelL = m_tempBuffer->channelByType(Channel::Left);
         AudioChannel* tempChannelR = m_tempBuffer->channelByType(Channel::Right);
 
-        // Process left virtual source
-        m_convolvers[0]->process(r, sourceChannelL, destinationChannelL, framesToProcess);
-        m_convolvers[1]->process(r, sourceChannelL, destinationChannelR, framesToProcess);
-
-        // Process right virtual source
-        m_convolvers[2]->process(r, sourceChannelR, tempChannelL, framesToProcess);
-        m_convolvers[3]->process(r, sourceChannelR, tempChannelR, framesToProcess);
+        // Left virtual source into the destination, right into the temp
+        // buffer, all four convolutions in flight at once.
+        ConvolutionJob jobs[4] = {
+            { m_convolvers[0].get(), sourceChannelL, destinationChannelL, &r, framesToProcess },
+            { m_convolvers[1].get(), sourceChannelL, destinationChannelR, &r, framesToProcess },
+            { m_convolvers[2].get(), sourceChannelR, tempChannelL, &r, framesToProcess },
+            { m_convolvers[3].get(), sourceChannelR, tempChannelR, &r, framesToProcess }};
+        ConvolutionWorkerPool::shared().runParallel(jobs, 4);
 
         destinationBus->sumFrom(*m_tempBuffer);
     } else if (numInputChannels == Channels::Mono && numReverbChannels == Channels::Quad && numOutputChannels == Channels::Stereo) {
@@ -195,13 +239,12 @@ void Reverb::process(ContextRenderLock& r, const AudioBus* sourceBus, AudioBus*
         AudioChannel* tempChannelL = m_tempBuffer->channelByType(Channel::Left);
         AudioChannel* tempChannelR = m_tempBuffer->channelByType(Channel::Right);
 
-        // Process left virtual source
-        m_convolvers[0]->process(r, sourceChannelL, destinationChannelL, framesToProcess);
-        m_convolvers[1]->process(r, sourceChannelL, destinationChannelR, framesToProcess);
-
-        // Process right virtual source
-        m_convolvers[2]->process(r, sourceChannelL, tempChannelL, framesToProcess);
-        m_convolvers[3]->process(r, sourceChannelL, tempChannelR, framesToProcess);
+        ConvolutionJob jobs[4] = {
+            { m_convolvers[0].get(), sourceChannelL, destinationChannelL, &r, framesToProcess },
+            { m_convolvers[1].get(), sourceChannelL, destinationChannelR, &r, framesToProcess },
+            { m_convolvers[2].get(), sourceChannelL, tempChannelL, &r, framesToProcess },
+            { m_convolvers[3].get(), sourceChannelL, tempChannelR, &r, framesToProcess }};
+        ConvolutionWorkerPool::shared().runParallel(jobs, 4);
 
         destinationBus->sumFrom(*m_tempBuffer);
     } else {
@@ -223,4 +266,18 @@ size_t Reverb::latencyFrames() const
     return !m_convolvers.empty() ? (*m_convolvers.begin())->latencyFrames() : 0;
 }
 
+void Reverb::setTailTruncationThreshold(float threshold)
+{
+    for (auto & convolver : m_convolvers)
+        convolver->setTailTruncationThreshold(threshold);
+}
+
+size_t Reverb::memoryBytes() const
+{
+    size_t bytes = m_tempBuffer ? m_tempBuffer->memoryBytes() : 0;
+    for (auto & convolver : m_convolvers)
+        bytes += convolver->memoryBytes();
+    return bytes;
+}
+
 } // namespace lab
@@ -54,12 +54,24 @@ void ReverbAccumulationBuffer::updateReadIndex(int* readIndex, size_t numberOfFr
 
 int ReverbAccumulationBuffer::accumulate(float* source, size_t numberOfFrames, int* readIndex, size_t delayFrames)
 {
-    size_t bufferLength = m_buffer.size();
-    
-    size_t writeIndex = (*readIndex + delayFrames) % bufferLength;
+    size_t writeIndex = writeIndexFor(*readIndex, delayFrames);
 
     // Update caller's readIndex
-    *readIndex = (*readIndex + numberOfFrames) % bufferLength;
+    *readIndex = (*readIndex + numberOfFrames) % m_buffer.size();
+
+    accumulateAt(source, numberOfFrames, writeIndex);
+
+    return static_cast<int>(writeIndex);
+}
+
+size_t ReverbAccumulationBuffer::writeIndexFor(int readIndex, size_t delayFrames) const
+{
+    return (readIndex + delayFrames) % m_buffer.size();
+}
+
+void ReverbAccumulationBuffer::accumulateAt(const float* source, size_t numberOfFrames, size_t writeIndex)
+{
+    size_t bufferLength = m_buffer.size();
 
     size_t framesAvailable = bufferLength - writeIndex;
     size_t numberOfFrames1 = std::min(numberOfFrames, framesAvailable);
@@ -70,15 +82,48 @@ int ReverbAccumulationBuffer::accumulate(float* source, size_t numberOfFrames, i
     bool isSafe = writeIndex <= bufferLength && numberOfFrames1 + writeIndex <= bufferLength && numberOfFrames2 <= bufferLength;
     ASSERT(isSafe);
     if (!isSafe)
-        return 0;
+        return;
 
     vadd(source, 1, destination + writeIndex, 1, destination + writeIndex, 1, numberOfFrames1);
 
     // Handle wrap-around if necessary
-    if (numberOfFrames2 > 0)       
+    if (numberOfFrames2 > 0)
         vadd(source + numberOfFrames1, 1, destination, 1, destination, 1, numberOfFrames2);
+}
 
-    return writeIndex;
+void ReverbAccumulationBuffer::accumulateBatch(Contribution* contributions, size_t count, size_t numberOfFrames, AudioFloatArray& scratch)
+{
+    if (!count)
+        return;
+
+    // Group contributions landing at the same position; stage delays are all
+    // multiples of the render slice, so coinciding stages coincide exactly.
+    std::sort(contributions, contributions + count,
+              [](const Contribution& a, const Contribution& b) { return a.writeIndex < b.writeIndex; });
+
+    if (scratch.size() < numberOfFrames)
+        scratch.allocate(numberOfFrames);
+
+    size_t i = 0;
+    while (i < count) {
+        size_t j = i + 1;
+        while (j < count && contributions[j].writeIndex == contributions[i].writeIndex)
+            ++j;
+
+        if (j - i == 1) {
+            accumulateAt(contributions[i].source, numberOfFrames, contributions[i].writeIndex);
+        } else {
+            // Sum the group before touching the accumulation buffer, so the
+            // shared region sees one read-modify-write instead of j - i.
+            float* summed = scratch.data();
+            vadd(contributions[i].source, 1, contributions[i + 1].source, 1, summed, 1, numberOfFrames);
+            for (size_t k = i + 2; k < j; ++k)
+                vadd(contributions[k].source, 1, summed, 1, summed, 1, numberOfFrames);
+            accumulateAt(summed, numberOfFrames, contributions[i].writeIndex);
+        }
+
+        i = j;
+    }
 }
 
 void ReverbAccumulationBuffer::reset()
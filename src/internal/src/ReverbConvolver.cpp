@@ -5,15 +5,51 @@
 #include "LabSound/extended/AudioContextLock.h"
 
 #include "internal/ReverbConvolver.h"
+#include "internal/ConvolutionWorkerPool.h"
 #include "internal/VectorMath.h"
 #include "internal/Assertions.h"
 
 #include "LabSound/core/AudioBus.h"
 
+#include <map>
+
 namespace lab {
 
 using namespace VectorMath;
 
+namespace {
+
+    // Process-wide cache of FFT'd stage kernels, keyed by the caller's content
+    // hash (see Reverb). Kernels are immutable once built, so every convolver
+    // constructed from the same response shares one set, and entries persist
+    // so re-creating convolvers across level loads stays free. The memory held
+    // is roughly twice the response length per cached response - a handful of
+    // impulse responses at most in practice.
+    struct ReverbKernelSet
+    {
+        std::vector<std::shared_ptr<FFTFrame>> kernels;  // non-direct stages, in creation order
+    };
+
+    std::mutex s_kernelCacheMutex;
+    std::map<uint64_t, std::shared_ptr<ReverbKernelSet>> s_kernelCache;
+
+    std::shared_ptr<ReverbKernelSet> lookupKernelSet(uint64_t key)
+    {
+        if (!key) return nullptr;
+        std::lock_guard<std::mutex> lock(s_kernelCacheMutex);
+        auto it = s_kernelCache.find(key);
+        return it != s_kernelCache.end() ? it->second : nullptr;
+    }
+
+    void publishKernelSet(uint64_t key, std::shared_ptr<ReverbKernelSet> set)
+    {
+        if (!key) return;
+        std::lock_guard<std::mutex> lock(s_kernelCacheMutex);
+        s_kernelCache.emplace(key, set);  // keep the first publisher's set on a race
+    }
+
+}  // anonymous namespace
+
 const int InputBufferSize = 8 * 16384;
 
 // We only process the leading portion of the impulse response in the real-time thread.  We don't exceed this length.
@@ -28,15 +64,30 @@ const size_t RealtimeFrameLimit = 8192  + 4096; // ~278msec @ 44.1KHz
 const size_t MinFFTSize = 128;
 const size_t MaxRealtimeFFTSize = 2048;
 
-ReverbConvolver::ReverbConvolver(AudioChannel* impulseResponse, size_t renderSliceSize, size_t maxFFTSize, size_t convolverRenderPhase, bool useBackgroundThreads)
+// Upper bound on how long worker wakes may be deferred (~93msec @ 44.1KHz),
+// so batching never consumes the background stages' scheduling slop even
+// when the smallest background partition is very large.
+const size_t MaxBackgroundBatchFrames = 4096;
+
+// True when a stage can still contribute audibly: the input hasn't been
+// silent past its portion of the tail (the exact criterion), and - when a
+// truncation threshold is set - its bounded output amplitude is above it.
+static bool stageAudible(uint64_t framesSinceAudibleInput, float inputEnvelope, float threshold, size_t tailFrames, float responseL1)
+{
+    if (framesSinceAudibleInput > tailFrames)
+        return false;
+    if (threshold > 0 && inputEnvelope * responseL1 < threshold)
+        return false;
+    return true;
+}
+
+ReverbConvolver::ReverbConvolver(AudioChannel* impulseResponse, size_t renderSliceSize, size_t maxFFTSize, size_t convolverRenderPhase, bool useBackgroundThreads, uint64_t cacheKey)
     : m_impulseResponseLength(impulseResponse->length())
     , m_accumulationBuffer(impulseResponse->length() + renderSliceSize)
     , m_inputBuffer(InputBufferSize)
     , m_minFFTSize(MinFFTSize) // First stage will have this size - successive stages will double in size each time
     , m_maxFFTSize(maxFFTSize) // until we hit m_maxFFTSize
     , m_useBackgroundThreads(useBackgroundThreads)
-    , m_wantsToExit(false)
-    , m_moreInputBuffered(false)
 {
     // If we are using background threads then don't exceed this FFT size for the
     // stages which run in the real-time thread.  This avoids having only one or two
@@ -54,6 +105,12 @@ ReverbConvolver::ReverbConvolver(AudioChannel* impulseResponse, size_t renderSli
     // The total latency is zero because the direct-convolution is used in the leading portion.
     size_t reverbTotalLatency = 0;
 
+    std::shared_ptr<ReverbKernelSet> cachedKernels = lookupKernelSet(cacheKey);
+    std::shared_ptr<ReverbKernelSet> builtKernels;
+    if (cacheKey && !cachedKernels)
+        builtKernels = std::make_shared<ReverbKernelSet>();
+    size_t kernelIndex = 0;
+
     size_t stageOffset = 0;
     int i = 0;
     size_t fftSize = m_minFFTSize;
@@ -70,19 +127,46 @@ ReverbConvolver::ReverbConvolver(AudioChannel* impulseResponse, size_t renderSli
 
         bool useDirectConvolver = !stageOffset;
 
+        std::shared_ptr<FFTFrame> sharedKernel;
+        if (!useDirectConvolver && cachedKernels && kernelIndex < cachedKernels->kernels.size())
+            sharedKernel = cachedKernels->kernels[kernelIndex];
+
         std::unique_ptr<ReverbConvolverStage> stage(
                 new ReverbConvolverStage(response, totalResponseLength, reverbTotalLatency,
                                          stageOffset, stageSize, fftSize, renderPhase, renderSliceSize,
-                                         &m_accumulationBuffer, useDirectConvolver));
+                                         &m_accumulationBuffer, useDirectConvolver, sharedKernel));
+
+        if (!useDirectConvolver) {
+            if (builtKernels)
+                builtKernels->kernels.push_back(stage->fftKernel());
+            ++kernelIndex;
+        }
+
+        // Gating metadata: the L1 norm bounds the stage's output amplitude
+        // per unit input peak, and tailFrames (slice end plus FFT/render
+        // slack) is how long input silence makes its output exactly zero.
+        float responseL1 = 0;
+        for (size_t j = 0; j < stageSize; ++j)
+            responseL1 += fabsf(response[stageOffset + j]);
+        size_t tailFrames = stageOffset + stageSize + fftSize + renderSliceSize;
 
         bool isBackgroundStage = false;
 
         if (this->useBackgroundThreads() && stageOffset > RealtimeFrameLimit) {
             m_backgroundStages.push_back(std::move(stage));
+            m_backgroundStageTailFrames.push_back(tailFrames);
+            m_backgroundStageResponseL1.push_back(responseL1);
+            m_backgroundStageEngaged.push_back(1);
             isBackgroundStage = true;
+            if (!m_backgroundBatchFrames || fftSize / 2 < m_backgroundBatchFrames)
+                m_backgroundBatchFrames = fftSize / 2;
         }
-        else
+        else {
             m_stages.push_back(std::move(stage));
+            m_stageTailFrames.push_back(tailFrames);
+            m_stageResponseL1.push_back(responseL1);
+            m_stageEngaged.push_back(1);
+        }
 
         stageOffset += stageSize;
         ++i;
@@ -98,59 +182,74 @@ ReverbConvolver::ReverbConvolver(AudioChannel* impulseResponse, size_t renderSli
             fftSize = m_maxFFTSize;
     }
 
+    if (builtKernels)
+        publishKernelSet(cacheKey, builtKernels);
+
+    if (m_backgroundBatchFrames > MaxBackgroundBatchFrames)
+        m_backgroundBatchFrames = MaxBackgroundBatchFrames;
+
+    m_realtimeContributions.reserve(m_stages.size());
+    m_backgroundContributions.reserve(m_backgroundStages.size());
+    m_realtimeScratch.allocate(renderSliceSize);
+    m_backgroundScratch.allocate(MinFFTSize / 2);
+
     if (this->useBackgroundThreads() && m_backgroundStages.size() > 0)
     {
-        // @tofix - proper notification when thread is completed with condition variable
-        m_backgroundThread = std::thread(&ReverbConvolver::backgroundThreadEntry, this);
+        // All convolvers share one pool of workers sized to the machine
+        ConvolutionWorkerPool::shared().addClient(this);
+        m_registeredWithWorkerPool = true;
     }
 
 }
 
 ReverbConvolver::~ReverbConvolver()
 {
-    // Wait for background thread to stop
-    if (useBackgroundThreads()) 
-    {
-        m_wantsToExit = true;
-
-        // Wake up thread so it can return
-        {
-            std::lock_guard<std::mutex> locker(m_backgroundThreadLock);
-            m_moreInputBuffered = true;
-            m_backgroundThreadCondition.notify_one();
-        }
-
-        if (m_backgroundThread.joinable()) m_backgroundThread.join();
-    }
+    // Blocks until no worker is servicing this convolver
+    if (m_registeredWithWorkerPool)
+        ConvolutionWorkerPool::shared().removeClient(this);
 }
 
-void ReverbConvolver::backgroundThreadEntry()
+void ReverbConvolver::drainBackgroundWork()
 {
-    while (!m_wantsToExit) 
-    {
-        // Wait for realtime thread to give us more input
-        m_moreInputBuffered = false;        
-        {
-            std::unique_lock<std::mutex> locker(m_backgroundThreadLock);
-            while (!m_moreInputBuffered && !m_wantsToExit)
-                m_backgroundThreadCondition.wait(locker);
+    // Process all of the stages until their read indices reach the input buffer's write index
+    int writeIndex = m_inputBuffer.writeIndex();
+
+    // Even though it doesn't seem like every stage needs to maintain its own version of readIndex
+    // we do this in case we want to run in more than one background thread.
+    int readIndex;
+
+    while ((readIndex = m_backgroundStages[0]->inputReadIndex()) != writeIndex) { // FIXME: do better to detect buffer overrun...
+        // The ReverbConvolverStages need to process in amounts which evenly divide half the FFT size
+        const int SliceSize = MinFFTSize / 2;
+
+        uint64_t silentRun = m_framesSinceAudibleInput.load(std::memory_order_relaxed);
+        float envelope = m_inputEnvelope.load(std::memory_order_relaxed);
+        float threshold = m_tailThreshold.load(std::memory_order_relaxed);
+
+        // Render every stage's slice, then accumulate them in one batched pass
+        m_backgroundContributions.clear();
+        for (size_t i = 0; i < m_backgroundStages.size(); ++i) {
+            if (!stageAudible(silentRun, envelope, threshold, m_backgroundStageTailFrames[i], m_backgroundStageResponseL1[i])) {
+                // A gated stage still consumes its ring input so its read
+                // position stays in step with the active stages.
+                if (m_backgroundStageEngaged[i]) {
+                    m_backgroundStages[i]->resetConvolutionState();
+                    m_backgroundStageEngaged[i] = 0;
+                }
+                m_backgroundStages[i]->skipInBackground(this, SliceSize);
+                continue;
+            }
+            m_backgroundStageEngaged[i] = 1;
+
+            ReverbAccumulationBuffer::Contribution contribution;
+            if (m_backgroundStages[i]->processInBackground(this, SliceSize, contribution))
+                m_backgroundContributions.push_back(contribution);
         }
+        m_accumulationBuffer.accumulateBatch(m_backgroundContributions.data(), m_backgroundContributions.size(),
+                                             SliceSize, m_backgroundScratch);
 
-        // Process all of the stages until their read indices reach the input buffer's write index
-        int writeIndex = m_inputBuffer.writeIndex();
-
-        // Even though it doesn't seem like every stage needs to maintain its own version of readIndex 
-        // we do this in case we want to run in more than one background thread.
-        int readIndex;
-
-        while ((readIndex = m_backgroundStages[0]->inputReadIndex()) != writeIndex) { // FIXME: do better to detect buffer overrun...
-            // The ReverbConvolverStages need to process in amounts which evenly divide half the FFT size
-            const int SliceSize = MinFFTSize / 2;
-
-            // Accumulate contributions from each stage
-            for (size_t i = 0; i < m_backgroundStages.size(); ++i)
-                m_backgroundStages[i]->processInBackground(this, SliceSize);
-        }
+        // pick up any input that arrived while we were working
+        writeIndex = m_inputBuffer.writeIndex();
     }
 }
 
@@ -171,25 +270,65 @@ void ReverbConvolver::process(ContextRenderLock&, const AudioChannel* sourceChan
     // Feed input buffer (read by all threads)
     m_inputBuffer.write(source, framesToProcess);
 
-    // Accumulate contributions from each stage
-    for (size_t i = 0; i < m_stages.size(); ++i)
-        m_stages[i]->process(source, framesToProcess);
+    // Update the audibility trackers behind stage gating: an exact run of
+    // silent input frames, and a peak envelope decaying with a half-life of
+    // the response length (slow enough to bound any stage's input window).
+    float slicePeak = 0;
+    vmaxmgv(source, 1, &slicePeak, framesToProcess);
+
+    uint64_t silentRun = m_framesSinceAudibleInput.load(std::memory_order_relaxed);
+    if (slicePeak > 0)
+        silentRun = 0;
+    else if (silentRun < (uint64_t(1) << 62))
+        silentRun += framesToProcess;
+    m_framesSinceAudibleInput.store(silentRun, std::memory_order_relaxed);
+
+    float envelope = m_inputEnvelope.load(std::memory_order_relaxed);
+    envelope *= exp2f(-float(framesToProcess) / float(m_impulseResponseLength));
+    if (slicePeak > envelope)
+        envelope = slicePeak;
+    m_inputEnvelope.store(envelope, std::memory_order_relaxed);
+
+    const float threshold = m_tailThreshold.load(std::memory_order_relaxed);
+
+    // Render every stage's slice, then accumulate them in one batched pass
+    m_realtimeContributions.clear();
+    for (size_t i = 0; i < m_stages.size(); ++i) {
+        if (!stageAudible(silentRun, envelope, threshold, m_stageTailFrames[i], m_stageResponseL1[i])) {
+            // Reset once on the way out so reactivation starts from the
+            // clean state the (silent or inaudible) missed input implies.
+            if (m_stageEngaged[i]) {
+                m_stages[i]->reset();
+                m_stageEngaged[i] = 0;
+            }
+            continue;
+        }
+        m_stageEngaged[i] = 1;
+
+        ReverbAccumulationBuffer::Contribution contribution;
+        if (m_stages[i]->processToContribution(source, framesToProcess, contribution))
+            m_realtimeContributions.push_back(contribution);
+    }
+    m_accumulationBuffer.accumulateBatch(m_realtimeContributions.data(), m_realtimeContributions.size(),
+                                         framesToProcess, m_realtimeScratch);
 
     // Finally read from accumulation buffer
     m_accumulationBuffer.readAndClear(destination, framesToProcess);
         
-    // Now that we've buffered more input, wake up our background thread.
-    
-    // Not using a MutexLocker looks strange, but we use a tryLock() instead because this is run on the real-time
-    // thread where it is a disaster for the lock to be contended (causes audio glitching).  It's OK if we fail to
-    // signal from time to time, since we'll get to it the next time we're called.  We're called repeatedly
-    // and frequently (around every 3ms).  The background thread is processing well into the future and has a considerable amount of 
-    // leeway here...
-    if (m_backgroundThreadLock.try_lock()) 
+    // Wake the shared worker pool only once a full background partition has
+    // accumulated; earlier wakes would context-switch a worker that finds no
+    // FFT ready. One signal wakes the pool, which services every registered
+    // convolver with pending input. signalMoreInput() uses a tryLock()
+    // internally so the real-time thread never blocks here; a missed signal
+    // just waits for the next batch boundary.
+    if (m_registeredWithWorkerPool)
     {
-        m_moreInputBuffered = true;
-        m_backgroundThreadCondition.notify_one();
-        m_backgroundThreadLock.unlock();
+        m_framesSinceWake += framesToProcess;
+        if (m_framesSinceWake >= m_backgroundBatchFrames)
+        {
+            m_framesSinceWake = 0;
+            ConvolutionWorkerPool::shared().signalMoreInput();
+        }
     }
 }
 
@@ -203,6 +342,9 @@ void ReverbConvolver::reset()
 
     m_accumulationBuffer.reset();
     m_inputBuffer.reset();
+    m_framesSinceWake = 0;
+    m_framesSinceAudibleInput.store(uint64_t(1) << 62, std::memory_order_relaxed);
+    m_inputEnvelope.store(0.f, std::memory_order_relaxed);
 }
 
 size_t ReverbConvolver::latencyFrames() const
@@ -210,4 +352,16 @@ size_t ReverbConvolver::latencyFrames() const
     return 0;
 }
 
+size_t ReverbConvolver::memoryBytes() const
+{
+    size_t bytes = (m_realtimeScratch.size() + m_backgroundScratch.size()) * sizeof(float);
+    bytes += m_accumulationBuffer.memoryBytes();
+    bytes += m_inputBuffer.memoryBytes();
+    for (auto & stage : m_stages)
+        bytes += stage->memoryBytes();
+    for (auto & stage : m_backgroundStages)
+        bytes += stage->memoryBytes();
+    return bytes;
+}
+
 } // namespace lab
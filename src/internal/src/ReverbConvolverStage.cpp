@@ -16,7 +16,8 @@ namespace lab {
 using namespace VectorMath;
 
 ReverbConvolverStage::ReverbConvolverStage(const float* impulseResponse, size_t, size_t reverbTotalLatency, size_t stageOffset, size_t stageLength,
-                                           size_t fftSize, size_t renderPhase, size_t renderSliceSize, ReverbAccumulationBuffer* accumulationBuffer, bool directMode)
+                                           size_t fftSize, size_t renderPhase, size_t renderSliceSize, ReverbAccumulationBuffer* accumulationBuffer, bool directMode,
+                                           std::shared_ptr<FFTFrame> sharedKernel)
     : m_accumulationBuffer(accumulationBuffer)
     , m_accumulationReadIndex(0)
     , m_inputReadIndex(0)
@@ -26,8 +27,12 @@ ReverbConvolverStage::ReverbConvolverStage(const float* impulseResponse, size_t,
     ASSERT(accumulationBuffer);
 
     if (!m_directMode) {
-        m_fftKernel = std::unique_ptr<FFTFrame>(new FFTFrame(fftSize));
-        m_fftKernel->doPaddedFFT(impulseResponse + stageOffset, stageLength);
+        if (sharedKernel) {
+            m_fftKernel = sharedKernel;
+        } else {
+            m_fftKernel = std::make_shared<FFTFrame>(fftSize);
+            m_fftKernel->doPaddedFFT(impulseResponse + stageOffset, stageLength);
+        }
         m_fftConvolver = std::unique_ptr<FFTConvolver>(new FFTConvolver(fftSize));
     } else {
         m_directKernel = std::unique_ptr<AudioFloatArray>(new AudioFloatArray(fftSize / 2));
@@ -63,19 +68,26 @@ ReverbConvolverStage::ReverbConvolverStage(const float* impulseResponse, size_t,
     m_preDelayBuffer.allocate(delayBufferSize);
 }
 
-void ReverbConvolverStage::processInBackground(ReverbConvolver* convolver, size_t framesToProcess)
+bool ReverbConvolverStage::processInBackground(ReverbConvolver* convolver, size_t framesToProcess, ReverbAccumulationBuffer::Contribution& contribution)
 {
     ReverbInputBuffer* inputBuffer = convolver->inputBuffer();
     float* source = inputBuffer->directReadFrom(&m_inputReadIndex, framesToProcess);
-    process(source, framesToProcess);
+    return processToContribution(source, framesToProcess, contribution);
 }
 
 void ReverbConvolverStage::process(const float* source, size_t framesToProcess)
+{
+    ReverbAccumulationBuffer::Contribution contribution;
+    if (processToContribution(source, framesToProcess, contribution))
+        m_accumulationBuffer->accumulateAt(contribution.source, framesToProcess, contribution.writeIndex);
+}
+
+bool ReverbConvolverStage::processToContribution(const float* source, size_t framesToProcess, ReverbAccumulationBuffer::Contribution& contribution)
 {
     ASSERT(source);
     if (!source)
-        return;
-    
+        return false;
+
     // Deal with pre-delay stream : note special handling of zero delay.
 
     const float* preDelayedSource;
@@ -87,7 +99,7 @@ void ReverbConvolverStage::process(const float* source, size_t framesToProcess)
         bool isPreDelaySafe = m_preReadWriteIndex + framesToProcess <= m_preDelayBuffer.size();
         ASSERT(isPreDelaySafe);
         if (!isPreDelaySafe)
-            return;
+            return false;
 
         isTemporaryBufferSafe = framesToProcess <= m_temporaryBuffer.size();
 
@@ -105,8 +117,9 @@ void ReverbConvolverStage::process(const float* source, size_t framesToProcess)
     
     ASSERT(isTemporaryBufferSafe);
     if (!isTemporaryBufferSafe)
-        return;
+        return false;
 
+    bool producedContribution = false;
     if (m_framesProcessed < m_preDelayLength) {
         // For the first m_preDelayLength frames don't process the convolver, instead simply buffer in the pre-delay.
         // But while buffering the pre-delay, we still need to update our index.
@@ -120,8 +133,12 @@ void ReverbConvolverStage::process(const float* source, size_t framesToProcess)
         else
             m_directConvolver->process(m_directKernel.get(), preDelayedSource, temporaryBuffer, framesToProcess);
 
-        // Now accumulate into reverb's accumulation buffer.
-        m_accumulationBuffer->accumulate(temporaryBuffer, framesToProcess, &m_accumulationReadIndex, m_postDelayLength);
+        // The accumulation itself is the caller's, so stages landing at the
+        // same position can be combined before the buffer is touched.
+        contribution.source = temporaryBuffer;
+        contribution.writeIndex = m_accumulationBuffer->writeIndexFor(m_accumulationReadIndex, m_postDelayLength);
+        m_accumulationBuffer->updateReadIndex(&m_accumulationReadIndex, framesToProcess);
+        producedContribution = true;
     }
 
     // Finally copy input to pre-delay.
@@ -135,6 +152,20 @@ void ReverbConvolverStage::process(const float* source, size_t framesToProcess)
     }
 
     m_framesProcessed += framesToProcess;
+
+    return producedContribution;
+}
+
+void ReverbConvolverStage::skipInBackground(ReverbConvolver* convolver, size_t framesToProcess)
+{
+    convolver->inputBuffer()->directReadFrom(&m_inputReadIndex, framesToProcess);
+}
+
+void ReverbConvolverStage::resetConvolutionState()
+{
+    int inputReadIndex = m_inputReadIndex;
+    reset();
+    m_inputReadIndex = inputReadIndex;
 }
 
 void ReverbConvolverStage::reset()
@@ -150,4 +181,17 @@ void ReverbConvolverStage::reset()
     m_framesProcessed = 0;
 }
 
+size_t ReverbConvolverStage::memoryBytes() const
+{
+    // An FFTFrame of size N stores N floats of frequency-domain data.
+    size_t bytes = m_fftKernel ? m_fftKernel->fftSize() * sizeof(float) : 0;
+    if (m_fftConvolver)
+        bytes += m_fftConvolver->memoryBytes();
+    if (m_directKernel)
+        bytes += m_directKernel->size() * sizeof(float);
+    if (m_directConvolver)
+        bytes += m_directConvolver->memoryBytes();
+    return bytes + (m_preDelayBuffer.size() + m_temporaryBuffer.size()) * sizeof(float);
+}
+
 } // namespace lab
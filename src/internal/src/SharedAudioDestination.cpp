@@ -0,0 +1,181 @@
+// License: BSD 3 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "internal/SharedAudioDestination.h"
+
+#include "LabSound/core/AudioBus.h"
+#include "LabSound/core/AudioIOCallback.h"
+#include "LabSound/core/AudioNode.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lab {
+
+namespace {
+
+// One SharedAudioDevice exists per distinct (channel count, sample rate)
+// configuration in use. It owns the single platform stream and fans the
+// hardware callback out to every active client, summing their output.
+class SharedAudioDevice : public AudioIOCallback
+{
+public:
+
+    SharedAudioDevice(size_t numberOfOutputChannels, float sampleRate)
+    : m_numberOfOutputChannels(numberOfOutputChannels)
+    , m_sampleRate(sampleRate)
+    , m_mixBus(numberOfOutputChannels, AudioNode::ProcessingSizeInFrames)
+    {
+        m_mixBus.setSampleRate(sampleRate);
+        m_destination.reset(AudioDestination::MakePlatformAudioDestination(*this, numberOfOutputChannels, sampleRate));
+    }
+
+    ~SharedAudioDevice()
+    {
+        if (m_started && m_destination)
+            m_destination->stop();
+    }
+
+    bool matches(size_t numberOfOutputChannels, float sampleRate) const
+    {
+        return m_numberOfOutputChannels == numberOfOutputChannels && m_sampleRate == sampleRate;
+    }
+
+    float sampleRate() const { return m_destination ? m_destination->sampleRate() : m_sampleRate; }
+
+    // All clients render inside the one hardware callback, so the device's
+    // clock and latency apply to each of them identically.
+    double streamTime() const { return m_destination ? m_destination->streamTime() : 0; }
+    double outputLatency() const { return m_destination ? m_destination->outputLatency() : 0; }
+
+    void activate(AudioIOCallback * client)
+    {
+        std::lock_guard<std::mutex> lock(m_clientMutex);
+        if (std::find(m_clients.begin(), m_clients.end(), client) == m_clients.end())
+            m_clients.push_back(client);
+
+        if (!m_started && m_destination)
+        {
+            m_destination->start();
+            m_started = true;
+        }
+    }
+
+    void deactivate(AudioIOCallback * client)
+    {
+        bool stop = false;
+        {
+            std::lock_guard<std::mutex> lock(m_clientMutex);
+            m_clients.erase(std::remove(m_clients.begin(), m_clients.end(), client), m_clients.end());
+            if (m_clients.empty() && m_started)
+            {
+                stop = true;
+                m_started = false;
+            }
+        }
+        // Stop outside the lock; the hardware callback may be blocked on it.
+        if (stop && m_destination)
+            m_destination->stop();
+    }
+
+    // The single hardware callback. Clients render in registration order, so
+    // their contexts advance in lock step and mix deterministically.
+    virtual void render(AudioBus * sourceBus, AudioBus * destinationBus, size_t framesToProcess) override
+    {
+        std::lock_guard<std::mutex> lock(m_clientMutex);
+
+        if (m_clients.empty())
+        {
+            destinationBus->zero();
+            return;
+        }
+
+        // The first client renders straight into the hardware bus; the rest
+        // render into the scratch bus and are summed on top.
+        m_clients[0]->render(sourceBus, destinationBus, framesToProcess);
+
+        for (size_t i = 1; i < m_clients.size(); ++i)
+        {
+            m_mixBus.zero();
+            m_clients[i]->render(sourceBus, &m_mixBus, framesToProcess);
+            destinationBus->sumFrom(m_mixBus);
+        }
+    }
+
+private:
+
+    size_t m_numberOfOutputChannels;
+    float m_sampleRate;
+
+    std::unique_ptr<AudioDestination> m_destination;
+    bool m_started = false;
+
+    std::mutex m_clientMutex;
+    std::vector<AudioIOCallback *> m_clients;
+
+    AudioBus m_mixBus;
+};
+
+std::mutex s_deviceRegistryMutex;
+std::vector<std::weak_ptr<SharedAudioDevice>> s_deviceRegistry;
+
+std::shared_ptr<SharedAudioDevice> acquireSharedDevice(size_t numberOfOutputChannels, float sampleRate)
+{
+    std::lock_guard<std::mutex> lock(s_deviceRegistryMutex);
+
+    for (auto i = s_deviceRegistry.begin(); i != s_deviceRegistry.end();)
+    {
+        if (auto device = i->lock())
+        {
+            if (device->matches(numberOfOutputChannels, sampleRate))
+                return device;
+            ++i;
+        }
+        else
+        {
+            i = s_deviceRegistry.erase(i);
+        }
+    }
+
+    auto device = std::make_shared<SharedAudioDevice>(numberOfOutputChannels, sampleRate);
+    s_deviceRegistry.emplace_back(device);
+    return device;
+}
+
+// The per-context handle; routes start()/stop() to the shared device and
+// keeps the device alive while any handle exists.
+struct SharedAudioDestinationImpl : public AudioDestination
+{
+    SharedAudioDestinationImpl(AudioIOCallback & callback, size_t numberOfOutputChannels, float sampleRate)
+    : m_callback(callback)
+    , m_device(acquireSharedDevice(numberOfOutputChannels, sampleRate))
+    {
+    }
+
+    virtual ~SharedAudioDestinationImpl()
+    {
+        m_device->deactivate(&m_callback);
+    }
+
+    virtual void start() override { m_device->activate(&m_callback); }
+    virtual void stop() override { m_device->deactivate(&m_callback); }
+
+    virtual float sampleRate() const override { return m_device->sampleRate(); }
+
+    virtual double streamTime() const override { return m_device->streamTime(); }
+    virtual double outputLatency() const override { return m_device->outputLatency(); }
+
+    AudioIOCallback & m_callback;
+    std::shared_ptr<SharedAudioDevice> m_device;
+};
+
+} // anonymous namespace
+
+AudioDestination * MakeSharedAudioDestination(AudioIOCallback & callback, size_t numberOfOutputChannels, float sampleRate)
+{
+    return new SharedAudioDestinationImpl(callback, numberOfOutputChannels, sampleRate);
+}
+
+} // namespace lab
@@ -5,12 +5,28 @@
 #include "LabSound/core/Macros.h"
 #include "internal/SincResampler.h"
 #include "internal/Assertions.h"
+#include "internal/VectorMath.h"
 #include "LabSound/core/AudioBus.h"
 
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
 
+#if defined(__SSE2__) && !defined(LABSOUND_PLATFORM_OSX)
+// 256-bit convolution with runtime dispatch, mirroring VectorMath.cpp
+#define LAB_SINC_AVX2_DISPATCH 1
+#include <immintrin.h>
+#if defined(LABSOUND_COMPILER_VISUAL_STUDIO)
+#define LAB_TARGET_AVX2
+#else
+#define LAB_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+#if defined(ARM_NEON_INTRINSICS)
+#include <arm_neon.h>
+#endif
+
 using namespace std;
 
 // Input buffer layout, dividing the total buffer into regions (r0 - r5):
@@ -42,19 +58,29 @@ using namespace std;
 
 namespace lab {
 
-SincResampler::SincResampler(double scaleFactor, size_t kernelSize, size_t numberOfKernelOffsets)
+SincResampler::SincResampler(double scaleFactor, size_t kernelSize, size_t numberOfKernelOffsets, unsigned numberOfChannels)
     : m_scaleFactor(scaleFactor)
     , m_kernelSize(kernelSize)
     , m_numberOfKernelOffsets(numberOfKernelOffsets)
     , m_kernelStorage(m_kernelSize * (m_numberOfKernelOffsets + 1))
     , m_virtualSourceIndex(0)
     , m_blockSize(512)
-    , m_inputBuffer(m_blockSize + m_kernelSize) // See input buffer layout above.
+    , m_inputBuffer((m_blockSize + m_kernelSize) * numberOfChannels) // See input buffer layout above.
+    , m_numberOfChannels(numberOfChannels)
     , m_source(0)
     , m_sourceFramesAvailable(0)
     , m_sourceProvider(0)
     , m_isBufferPrimed(false)
 {
+    ASSERT(numberOfChannels >= 1 && numberOfChannels <= MaxInterleavedChannels);
+
+    if (m_numberOfChannels > 1)
+    {
+        m_consumeScratch.resize(m_numberOfChannels);
+        for (auto & scratch : m_consumeScratch)
+            scratch.allocate(m_blockSize + m_kernelSize);
+    }
+
     initializeKernel();
 }
 
@@ -105,18 +131,86 @@ void SincResampler::consumeSource(float* buffer, size_t numberOfSourceFrames)
     ASSERT(m_sourceProvider);
     if (!m_sourceProvider)
         return;
-    
+
+    if (m_numberOfChannels > 1)
+    {
+        // Land the provider's planar channels in the scratch buffers, then
+        // interleave them into the frame-oriented input buffer.
+        AudioBus bus(m_numberOfChannels, numberOfSourceFrames, false);
+        for (unsigned c = 0; c < m_numberOfChannels; ++c)
+            bus.setChannelMemory(c, m_consumeScratch[c].data(), numberOfSourceFrames);
+
+        m_sourceProvider->provideInput(&bus, numberOfSourceFrames);
+
+        if (m_numberOfChannels == 2)
+        {
+            VectorMath::vintlve(m_consumeScratch[0].data(), m_consumeScratch[1].data(), buffer, numberOfSourceFrames);
+        }
+        else
+        {
+            for (unsigned c = 0; c < m_numberOfChannels; ++c)
+            {
+                const float* source = m_consumeScratch[c].data();
+                float* dest = buffer + c;
+                for (size_t i = 0; i < numberOfSourceFrames; ++i, dest += m_numberOfChannels)
+                    *dest = source[i];
+            }
+        }
+        return;
+    }
+
     // Wrap the provided buffer by an AudioBus for use by the source provider.
     AudioBus bus(1, numberOfSourceFrames, false);
 
     // FIXME: Find a way to make the following const-correct:
     bus.setChannelMemory(0, buffer, numberOfSourceFrames);
-    
+
     m_sourceProvider->provideInput(&bus, numberOfSourceFrames);
 }
 
 namespace {
 
+#if defined(LAB_SINC_AVX2_DISPATCH)
+
+// Convolves both kernels straddling the virtual source index in one fused
+// multiply-add pass and folds the two-kernel interpolation into the final
+// reduction, so one call produces the finished output sample.
+LAB_TARGET_AVX2 float convolveInterpolatedAVX2(const float * inputP, const float * k1, const float * k2, int n, float interpolationFactor)
+{
+    __m256 sums1 = _mm256_setzero_ps();
+    __m256 sums2 = _mm256_setzero_ps();
+
+    while (n >= 8)
+    {
+        __m256 input = _mm256_loadu_ps(inputP);
+        sums1 = _mm256_fmadd_ps(input, _mm256_loadu_ps(k1), sums1);
+        sums2 = _mm256_fmadd_ps(input, _mm256_loadu_ps(k2), sums2);
+        inputP += 8;
+        k1 += 8;
+        k2 += 8;
+        n -= 8;
+    }
+
+    // Blend the two accumulators before reducing: one horizontal sum instead of two.
+    __m256 blended = _mm256_add_ps(_mm256_mul_ps(sums1, _mm256_set1_ps(1.f - interpolationFactor)),
+                                   _mm256_mul_ps(sums2, _mm256_set1_ps(interpolationFactor)));
+
+    __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(blended), _mm256_extractf128_ps(blended, 1));
+    sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+    sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+    float sum = _mm_cvtss_f32(sum4);
+
+    while (n--)
+    {
+        float input = *inputP++;
+        sum += input * ((1.f - interpolationFactor) * *k1++ + interpolationFactor * *k2++);
+    }
+
+    return sum;
+}
+
+#endif // LAB_SINC_AVX2_DISPATCH
+
 // BufferSourceProvider is an AudioSourceProvider wrapping an in-memory buffer.
 
 class BufferSourceProvider : public AudioSourceProvider {
@@ -158,6 +252,7 @@ private:
 void SincResampler::process(const float* source, float* destination, size_t numberOfSourceFrames)
 {
     // Resample an in-memory buffer using an AudioSourceProvider.
+    ASSERT(m_numberOfChannels == 1);
     BufferSourceProvider sourceProvider(source, numberOfSourceFrames);
 
     size_t numberOfDestinationFrames = static_cast<size_t>(numberOfSourceFrames / m_scaleFactor);
@@ -175,7 +270,7 @@ void SincResampler::process(const float* source, float* destination, size_t numb
 
 void SincResampler::process(AudioSourceProvider* sourceProvider, float* destination, size_t framesToProcess)
 {
-    bool isGood = sourceProvider && m_blockSize > m_kernelSize && m_inputBuffer.size() >= m_blockSize + m_kernelSize && !(m_kernelSize % 2);
+    bool isGood = sourceProvider && m_blockSize > m_kernelSize && m_inputBuffer.size() >= (m_blockSize + m_kernelSize) * m_numberOfChannels && !(m_kernelSize % 2);
     ASSERT(isGood);
     if (!isGood)
         return;
@@ -183,14 +278,16 @@ void SincResampler::process(AudioSourceProvider* sourceProvider, float* destinat
     m_sourceProvider = sourceProvider;
 
     size_t numberOfDestinationFrames = framesToProcess;
-    
-    // Setup various region pointers in the buffer (see diagram above).
-    float* r0 = m_inputBuffer.data() + m_kernelSize / 2;
+
+    // Setup various region pointers in the buffer (see diagram above). In
+    // interleaved mode the regions are measured in frames of ch samples.
+    const unsigned ch = m_numberOfChannels;
+    float* r0 = m_inputBuffer.data() + (m_kernelSize / 2) * ch;
     float* r1 = m_inputBuffer.data();
     float* r2 = r0;
-    float* r3 = r0 + m_blockSize - m_kernelSize / 2;
-    float* r4 = r0 + m_blockSize;
-    float* r5 = r0 + m_kernelSize / 2;
+    float* r3 = r0 + (m_blockSize - m_kernelSize / 2) * ch;
+    float* r4 = r0 + m_blockSize * ch;
+    float* r5 = r0 + (m_kernelSize / 2) * ch;
 
     // Step (1)
     // Prime the input buffer at the start of the input stream.
@@ -214,7 +311,7 @@ void SincResampler::process(AudioSourceProvider* sourceProvider, float* destinat
             float* k2 = k1 + m_kernelSize;
 
             // Initialize input pointer based on quantized m_virtualSourceIndex.
-            float* inputP = r1 + sourceIndexI;
+            float* inputP = r1 + sourceIndexI * ch;
 
             // We'll compute "convolutions" for the two kernels which straddle m_virtualSourceIndex
             float sum1 = 0;
@@ -223,9 +320,115 @@ void SincResampler::process(AudioSourceProvider* sourceProvider, float* destinat
             // Figure out how much to weight each kernel's "convolution".
             double kernelInterpolationFactor = virtualOffsetIndex - offsetIndex;
 
-            // Generate a single output sample. 
+            // Generate a single output sample.
             int n = static_cast<int>(m_kernelSize);
 
+            if (ch > 1)
+            {
+                // Every channel advances through the kernel together: each
+                // coefficient is loaded once and applied across the lanes of
+                // the interleaved frame, so the kernel table is walked once
+                // per output frame instead of once per channel.
+                float sums1[MaxInterleavedChannels] = {0};
+                float sums2[MaxInterleavedChannels] = {0};
+
+#ifdef __SSE2__
+                if (ch == 2)
+                {
+                    __m128 s1 = _mm_setzero_ps();
+                    __m128 s2 = _mm_setzero_ps();
+                    const float* in = inputP;
+
+                    // The kernel size is even, so pairs of taps cover it.
+                    for (int i = 0; i + 2 <= n; i += 2)
+                    {
+                        __m128 input = _mm_loadu_ps(in);  // L0 R0 L1 R1
+                        __m128 kp1 = _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(k1 + i)));
+                        __m128 kp2 = _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(k2 + i)));
+                        kp1 = _mm_unpacklo_ps(kp1, kp1);  // k0 k0 k1 k1
+                        kp2 = _mm_unpacklo_ps(kp2, kp2);
+                        s1 = _mm_add_ps(s1, _mm_mul_ps(input, kp1));
+                        s2 = _mm_add_ps(s2, _mm_mul_ps(input, kp2));
+                        in += 4;
+                    }
+
+                    // Fold the two frames of partial sums; L, R land in lanes 0, 1.
+                    __m128 lo1 = _mm_add_ps(s1, _mm_movehl_ps(s1, s1));
+                    __m128 lo2 = _mm_add_ps(s2, _mm_movehl_ps(s2, s2));
+                    sums1[0] = _mm_cvtss_f32(lo1);
+                    sums1[1] = _mm_cvtss_f32(_mm_shuffle_ps(lo1, lo1, 1));
+                    sums2[0] = _mm_cvtss_f32(lo2);
+                    sums2[1] = _mm_cvtss_f32(_mm_shuffle_ps(lo2, lo2, 1));
+                }
+                else
+#elif defined(ARM_NEON_INTRINSICS)
+                if (ch == 2)
+                {
+                    float32x4_t s1 = vdupq_n_f32(0);
+                    float32x4_t s2 = vdupq_n_f32(0);
+                    const float* in = inputP;
+
+                    for (int i = 0; i + 2 <= n; i += 2)
+                    {
+                        float32x4_t input = vld1q_f32(in);  // L0 R0 L1 R1
+                        float32x2_t kp1 = vld1_f32(k1 + i);
+                        float32x2_t kp2 = vld1_f32(k2 + i);
+                        float32x2x2_t kz1 = vzip_f32(kp1, kp1);  // k0 k0 | k1 k1
+                        float32x2x2_t kz2 = vzip_f32(kp2, kp2);
+                        s1 = vmlaq_f32(s1, input, vcombine_f32(kz1.val[0], kz1.val[1]));
+                        s2 = vmlaq_f32(s2, input, vcombine_f32(kz2.val[0], kz2.val[1]));
+                        in += 4;
+                    }
+
+                    float32x2_t lo1 = vadd_f32(vget_low_f32(s1), vget_high_f32(s1));
+                    float32x2_t lo2 = vadd_f32(vget_low_f32(s2), vget_high_f32(s2));
+                    sums1[0] = vget_lane_f32(lo1, 0);
+                    sums1[1] = vget_lane_f32(lo1, 1);
+                    sums2[0] = vget_lane_f32(lo2, 0);
+                    sums2[1] = vget_lane_f32(lo2, 1);
+                }
+                else
+#endif
+                {
+                    const float* in = inputP;
+                    for (int i = 0; i < n; ++i)
+                    {
+                        float c1 = k1[i];
+                        float c2 = k2[i];
+                        for (unsigned c = 0; c < ch; ++c)
+                        {
+                            float input = in[c];
+                            sums1[c] += input * c1;
+                            sums2[c] += input * c2;
+                        }
+                        in += ch;
+                    }
+                }
+
+                // Linearly interpolate the two "convolutions" per channel.
+                for (unsigned c = 0; c < ch; ++c)
+                    *destination++ = static_cast<float>((1.0 - kernelInterpolationFactor) * sums1[c] + kernelInterpolationFactor * sums2[c]);
+
+                m_virtualSourceIndex += m_scaleFactor;
+                --numberOfDestinationFrames;
+                if (!numberOfDestinationFrames)
+                    return;
+                continue;
+            }
+
+#if defined(LAB_SINC_AVX2_DISPATCH)
+            if (VectorMath::cpuHasAVX2())
+            {
+                *destination++ = convolveInterpolatedAVX2(inputP, k1, k2, n, static_cast<float>(kernelInterpolationFactor));
+
+                m_virtualSourceIndex += m_scaleFactor;
+                --numberOfDestinationFrames;
+                if (!numberOfDestinationFrames)
+                    return;
+                continue;
+            }
+#endif
+
 #define CONVOLVE_ONE_SAMPLE      \
             input = *inputP++;   \
             sum1 += input * *k1; \
@@ -299,13 +502,36 @@ void SincResampler::process(AudioSourceProvider* sourceProvider, float* destinat
                 sum2 += groupSumP[0] + groupSumP[1] + groupSumP[2] + groupSumP[3];
 
                 n %= 4;
+                while (n) {
+                    CONVOLVE_ONE_SAMPLE
+                    n--;
+                }
+#elif defined(ARM_NEON_INTRINSICS)
+                float32x4_t sums1 = vdupq_n_f32(0);
+                float32x4_t sums2 = vdupq_n_f32(0);
+
+                while (n >= 4) {
+                    float32x4_t input4 = vld1q_f32(inputP);
+                    sums1 = vmlaq_f32(sums1, input4, vld1q_f32(k1));
+                    sums2 = vmlaq_f32(sums2, input4, vld1q_f32(k2));
+                    inputP += 4;
+                    k1 += 4;
+                    k2 += 4;
+                    n -= 4;
+                }
+
+                float32x2_t pair1 = vadd_f32(vget_low_f32(sums1), vget_high_f32(sums1));
+                sum1 += vget_lane_f32(vpadd_f32(pair1, pair1), 0);
+                float32x2_t pair2 = vadd_f32(vget_low_f32(sums2), vget_high_f32(sums2));
+                sum2 += vget_lane_f32(vpadd_f32(pair2, pair2), 0);
+
                 while (n) {
                     CONVOLVE_ONE_SAMPLE
                     n--;
                 }
 #else
-                // FIXME: add ARM NEON optimizations for the following. The scalar code-path can probably also be optimized better.
-                
+                // The scalar code-path can probably also be optimized better.
+
                 // Optimize size 32 and size 64 kernels by unrolling the while loop.
                 // A 20 - 30% speed improvement was measured in some cases by using this approach.
                 
@@ -432,8 +658,8 @@ void SincResampler::process(AudioSourceProvider* sourceProvider, float* destinat
 
         // Step (3) Copy r3 to r1 and r4 to r2.
         // This wraps the last input frames back to the start of the buffer.
-        memcpy(r1, r3, sizeof(float) * (m_kernelSize / 2));
-        memcpy(r2, r4, sizeof(float) * (m_kernelSize / 2));
+        memcpy(r1, r3, sizeof(float) * (m_kernelSize / 2) * ch);
+        memcpy(r2, r4, sizeof(float) * (m_kernelSize / 2) * ch);
 
         // Step (4)
         // Refresh the buffer with more input.
@@ -0,0 +1,244 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "internal/SpectralFFTService.h"
+
+#include "LabSound/core/AudioContext.h"
+#include "LabSound/core/WindowFunctions.h"
+
+#include "internal/AudioThreads.h"
+#include "internal/FFTFrame.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace lab {
+
+struct SpectralFFTService::Client
+{
+    int id = 0;
+    size_t windowSize = 0;
+
+    // Submission slot. submit() fills it under a try_lock so the producer
+    // (often the render thread) never blocks on the worker's copy-out.
+    std::mutex inputMutex;
+    std::vector<float> input;
+    bool pending = false;
+
+    // Published magnitudes behind a seqlock: the worker bumps sequence to an
+    // odd value, writes, bumps it even; readers retry while it is odd or
+    // changed underneath them. magnitudes never shrinks, so a racing reader
+    // only ever sees stale floats, not a reallocation.
+    std::atomic<uint32_t> sequence{0};
+    std::vector<float> magnitudes;
+    bool haveResult = false;
+};
+
+struct SpectralFFTService::Internals
+{
+    mutable std::mutex clientMutex;
+    std::map<int, std::shared_ptr<Client>> clients;
+    int nextClientId = 1;
+
+    std::thread worker;
+    std::mutex workerMutex;
+    std::condition_variable workerWake;
+    std::atomic<uint64_t> epoch{0};
+    bool shouldExit = false;
+
+    // Worker-only: one frame per distinct window size, so same-size
+    // transforms from any number of clients share a single FFT setup.
+    std::map<size_t, std::unique_ptr<FFTFrame>> frames;
+    std::vector<float> scratch;
+};
+
+SpectralFFTService & SpectralFFTService::shared()
+{
+    static SpectralFFTService s_service;
+    return s_service;
+}
+
+SpectralFFTService::SpectralFFTService()
+    : m_internals(new Internals())
+{
+    m_internals->worker = std::thread([this]() {
+        ApplyThreadPolicy(AudioContext::ThreadRole::Background, "spectral fft");
+
+        Internals * in = m_internals;
+        uint64_t seenEpoch = 0;
+
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(in->workerMutex);
+                in->workerWake.wait(lock, [in, seenEpoch]() {
+                    return in->shouldExit || in->epoch.load(std::memory_order_acquire) != seenEpoch;
+                });
+
+                if (in->shouldExit)
+                    return;
+
+                seenEpoch = in->epoch.load(std::memory_order_acquire);
+            }
+
+            // Snapshot the client list, then transform outside the registry
+            // lock. The map is ordered by id but processing batches by window
+            // size, so each size's FFT setup is fetched once per pass.
+            std::vector<std::shared_ptr<Client>> clients;
+            {
+                std::lock_guard<std::mutex> lock(in->clientMutex);
+                clients.reserve(in->clients.size());
+                for (auto & entry : in->clients)
+                    clients.push_back(entry.second);
+            }
+
+            std::sort(clients.begin(), clients.end(),
+                      [](const std::shared_ptr<Client> & a, const std::shared_ptr<Client> & b) {
+                          return a->windowSize < b->windowSize;
+                      });
+
+            FFTFrame * frame = nullptr;
+            size_t frameSize = 0;
+
+            for (auto & client : clients)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(client->inputMutex);
+                    if (!client->pending)
+                        continue;
+                    client->pending = false;
+                    in->scratch.assign(client->input.begin(), client->input.end());
+                }
+
+                size_t windowSize = client->windowSize;
+                if (windowSize != frameSize)
+                {
+                    auto it = in->frames.find(windowSize);
+                    if (it == in->frames.end())
+                        it = in->frames.emplace(windowSize, std::unique_ptr<FFTFrame>(new FFTFrame(windowSize))).first;
+                    frame = it->second.get();
+                    frameSize = windowSize;
+                }
+
+                applyWindowTable(window_blackman, in->scratch.data(), windowSize);
+                frame->doFFT(in->scratch.data());
+
+                const float * realP = frame->realData();
+                const float * imagP = frame->imagData();
+                size_t bins = windowSize / 2;
+
+                // Publish. Readers spin on the odd sequence for the length of
+                // one memcpy-sized loop, never on a held lock.
+                client->sequence.fetch_add(1, std::memory_order_acq_rel);
+                client->magnitudes.resize(bins);
+                // bin 0 carries the packed nyquist in imagP[0]; drop it.
+                client->magnitudes[0] = std::abs(realP[0]);
+                for (size_t i = 1; i < bins; ++i)
+                    client->magnitudes[i] = sqrtf(realP[i] * realP[i] + imagP[i] * imagP[i]);
+                client->haveResult = true;
+                client->sequence.fetch_add(1, std::memory_order_release);
+            }
+        }
+    });
+}
+
+SpectralFFTService::~SpectralFFTService()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_internals->workerMutex);
+        m_internals->shouldExit = true;
+    }
+    m_internals->workerWake.notify_all();
+    if (m_internals->worker.joinable())
+        m_internals->worker.join();
+    delete m_internals;
+}
+
+int SpectralFFTService::registerClient(size_t windowSize)
+{
+    auto client = std::make_shared<Client>();
+    client->windowSize = windowSize;
+    client->input.resize(windowSize, 0.f);
+    client->magnitudes.reserve(windowSize / 2);
+
+    std::lock_guard<std::mutex> lock(m_internals->clientMutex);
+    client->id = m_internals->nextClientId++;
+    m_internals->clients[client->id] = client;
+    return client->id;
+}
+
+void SpectralFFTService::unregisterClient(int id)
+{
+    std::lock_guard<std::mutex> lock(m_internals->clientMutex);
+    m_internals->clients.erase(id);
+}
+
+void SpectralFFTService::submit(int id, const float * samples)
+{
+    std::shared_ptr<Client> client;
+    {
+        std::lock_guard<std::mutex> lock(m_internals->clientMutex);
+        auto it = m_internals->clients.find(id);
+        if (it == m_internals->clients.end())
+            return;
+        client = it->second;
+    }
+
+    if (client->inputMutex.try_lock())
+    {
+        memcpy(client->input.data(), samples, sizeof(float) * client->windowSize);
+        client->pending = true;
+        client->inputMutex.unlock();
+    }
+    else
+    {
+        // The worker is copying this client out right now; drop the block
+        // rather than stall the producer.
+        return;
+    }
+
+    m_internals->epoch.fetch_add(1, std::memory_order_release);
+    if (m_internals->workerMutex.try_lock())
+    {
+        m_internals->workerMutex.unlock();
+        m_internals->workerWake.notify_one();
+    }
+}
+
+bool SpectralFFTService::readMagnitudes(int id, std::vector<float> & result) const
+{
+    result.clear();
+
+    std::shared_ptr<Client> client;
+    {
+        std::lock_guard<std::mutex> lock(m_internals->clientMutex);
+        auto it = m_internals->clients.find(id);
+        if (it == m_internals->clients.end())
+            return false;
+        client = it->second;
+    }
+
+    for (;;)
+    {
+        uint32_t before = client->sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            continue;
+        if (!client->haveResult)
+            return false;
+
+        result.assign(client->magnitudes.begin(), client->magnitudes.end());
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (client->sequence.load(std::memory_order_relaxed) == before)
+            return true;
+    }
+}
+
+} // namespace lab
@@ -0,0 +1,203 @@
+// License: BSD 2 Clause
+// Copyright (C) 2015+, The LabSound Authors. All rights reserved.
+
+#include "internal/StreamingWavWriter.h"
+#include "internal/AudioThreads.h"
+
+#include "LabSound/core/AudioContext.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace lab
+{
+
+namespace
+{
+    // power of two samples; ~6 seconds of stereo at 44.1kHz, so the writer
+    // thread can stall for seconds before any frame is dropped
+    const size_t kRingCapacity = 1 << 19;
+
+    // Minimal 32 bit float WAV framing. The sizes written at offsets 4
+    // (RIFF) and 40 (data) start as zero and are patched on finalize, so
+    // the file grows incrementally while streaming.
+    void writeWavHeader(FILE * f, int channels, int sampleRate)
+    {
+        auto u16 = [f](uint16_t v) { fwrite(&v, 2, 1, f); };
+        auto u32 = [f](uint32_t v) { fwrite(&v, 4, 1, f); };
+
+        fwrite("RIFF", 1, 4, f);
+        u32(0);  // patched on finalize
+        fwrite("WAVE", 1, 4, f);
+        fwrite("fmt ", 1, 4, f);
+        u32(16);
+        u16(3);  // IEEE float
+        u16(static_cast<uint16_t>(channels));
+        u32(static_cast<uint32_t>(sampleRate));
+        u32(static_cast<uint32_t>(sampleRate * channels * sizeof(float)));  // byte rate
+        u16(static_cast<uint16_t>(channels * sizeof(float)));  // block align
+        u16(32);  // bits per sample
+        fwrite("data", 1, 4, f);
+        u32(0);  // patched on finalize
+    }
+
+    void patchWavSizes(FILE * f, uint64_t dataBytes)
+    {
+        uint32_t riffSize = static_cast<uint32_t>(36 + dataBytes);
+        uint32_t dataSize = static_cast<uint32_t>(dataBytes);
+        fseek(f, 4, SEEK_SET);
+        fwrite(&riffSize, 4, 1, f);
+        fseek(f, 40, SEEK_SET);
+        fwrite(&dataSize, 4, 1, f);
+    }
+}
+
+StreamingWavWriter::StreamingWavWriter()
+{
+    m_ring.resize(kRingCapacity);
+    m_writerThread = std::thread(&StreamingWavWriter::writerThread, this);
+}
+
+StreamingWavWriter::~StreamingWavWriter()
+{
+    m_writerShouldRun = false;
+    if (m_writerThread.joinable())
+        m_writerThread.join();
+}
+
+bool StreamingWavWriter::open(const std::string & path, int channels, int sampleRate)
+{
+    std::lock_guard<std::mutex> lock(m_controlMutex);
+    if (m_file)
+        return false;  // already streaming
+
+    m_file = fopen(path.c_str(), "wb");
+    if (!m_file)
+        return false;
+
+    writeWavHeader(m_file, channels, sampleRate);
+    m_bytesStreamed = 0;
+    m_finalizeRequested = false;
+    return true;
+}
+
+void StreamingWavWriter::writeInterleaved(const float * samples, size_t count)
+{
+    uint64_t w = m_ringWrite.load(std::memory_order_relaxed);
+    uint64_t rd = m_ringRead.load(std::memory_order_acquire);
+    if (kRingCapacity - (w - rd) >= count)
+    {
+        size_t offset = static_cast<size_t>(w & (kRingCapacity - 1));
+        size_t first = std::min(count, kRingCapacity - offset);
+        memcpy(&m_ring[offset], samples, first * sizeof(float));
+        if (first < count)
+            memcpy(&m_ring[0], samples + first, (count - first) * sizeof(float));
+        m_ringWrite.store(w + count, std::memory_order_release);
+    }
+    else
+    {
+        m_overrunFrames.fetch_add(count, std::memory_order_relaxed);
+    }
+}
+
+void StreamingWavWriter::writeInterleavedBlocking(const float * samples, size_t count)
+{
+    while (count)
+    {
+        uint64_t w = m_ringWrite.load(std::memory_order_relaxed);
+        uint64_t rd = m_ringRead.load(std::memory_order_acquire);
+        size_t space = static_cast<size_t>(kRingCapacity - (w - rd));
+
+        if (!space)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            continue;
+        }
+
+        size_t chunk = std::min(count, space);
+        writeInterleaved(samples, chunk);
+        samples += chunk;
+        count -= chunk;
+    }
+}
+
+void StreamingWavWriter::finish()
+{
+    std::lock_guard<std::mutex> lock(m_controlMutex);
+    if (m_file)
+        m_finalizeRequested = true;
+}
+
+bool StreamingWavWriter::busy() const
+{
+    std::lock_guard<std::mutex> lock(m_controlMutex);
+    return m_file != nullptr;
+}
+
+void StreamingWavWriter::writerThread()
+{
+    ApplyThreadPolicy(AudioContext::ThreadRole::Background, "wav writer io");
+
+    std::vector<float> staging;
+    staging.reserve(kRingCapacity);
+
+    bool draining = true;
+    while (m_writerShouldRun.load(std::memory_order_relaxed) || draining)
+    {
+        uint64_t rd = m_ringRead.load(std::memory_order_relaxed);
+        uint64_t w = m_ringWrite.load(std::memory_order_acquire);
+        size_t avail = static_cast<size_t>(w - rd);
+
+        if (avail)
+        {
+            staging.resize(avail);
+            size_t offset = static_cast<size_t>(rd & (kRingCapacity - 1));
+            size_t first = std::min(avail, kRingCapacity - offset);
+            memcpy(staging.data(), &m_ring[offset], first * sizeof(float));
+            if (first < avail)
+                memcpy(staging.data() + first, &m_ring[0], (avail - first) * sizeof(float));
+            m_ringRead.store(rd + avail, std::memory_order_release);
+        }
+        else
+        {
+            staging.clear();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_controlMutex);
+            if (m_file)
+            {
+                if (!staging.empty())
+                {
+                    fwrite(staging.data(), sizeof(float), staging.size(), m_file);
+                    m_bytesStreamed += staging.size() * sizeof(float);
+                }
+                bool done = m_finalizeRequested || !m_writerShouldRun.load(std::memory_order_relaxed);
+                if (done && staging.empty())
+                {
+                    patchWavSizes(m_file, m_bytesStreamed);
+                    fclose(m_file);
+                    m_file = nullptr;
+                    m_finalizeRequested = false;
+                }
+            }
+        }
+
+        if (staging.empty())
+        {
+            // exit only once the ring is empty and any stream is closed,
+            // so nothing produced is lost at teardown
+            if (!m_writerShouldRun.load(std::memory_order_relaxed))
+            {
+                std::lock_guard<std::mutex> lock(m_controlMutex);
+                draining = m_file != nullptr;
+                if (!draining)
+                    break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+}
+
+} // namespace lab
@@ -15,17 +15,158 @@
 #include <emmintrin.h>
 #endif
 
+#if defined(__SSE2__) && !defined(LABSOUND_PLATFORM_OSX)
+// 256-bit kernels with runtime dispatch; one binary serves both old and new x86.
+#define LAB_X86_AVX2_DISPATCH 1
+#include <immintrin.h>
+#if defined(LABSOUND_COMPILER_VISUAL_STUDIO)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
 #if defined(ARM_NEON_INTRINSICS)
 #include <arm_neon.h>
 #endif
 
 #include <algorithm>
+#include <cstring>
 #include <math.h>
 
 namespace lab {
 
 namespace VectorMath {
 
+#if defined(LAB_X86_AVX2_DISPATCH)
+
+// MSVC emits AVX2 intrinsics without per-function flags; gcc/clang need the target attribute
+#if defined(LABSOUND_COMPILER_VISUAL_STUDIO)
+#define LAB_TARGET_AVX2
+#else
+#define LAB_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+namespace {
+
+    bool detectAVX2()
+    {
+        // AVX2+FMA in the CPU, and the OS must have enabled YMM state (XCR0)
+#if defined(LABSOUND_COMPILER_VISUAL_STUDIO)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        __cpuid(info, 1);
+        bool fma = (info[2] & (1 << 12)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        __cpuidex(info, 7, 0);
+        bool avx2 = (info[1] & (1 << 5)) != 0;
+        if (!fma || !osxsave || !avx2)
+            return false;
+        return (_xgetbv(0) & 0x6) == 0x6;
+#else
+        unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+            return false;
+        bool fma = (ecx & (1 << 12)) != 0;
+        bool osxsave = (ecx & (1 << 27)) != 0;
+        if (!fma || !osxsave)
+            return false;
+        if (__get_cpuid_max(0, nullptr) < 7)
+            return false;
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        if (!(ebx & (1 << 5)))
+            return false;
+        unsigned int xcr0Lo, xcr0Hi;
+        __asm__("xgetbv" : "=a"(xcr0Lo), "=d"(xcr0Hi) : "c"(0));
+        return (xcr0Lo & 0x6) == 0x6;
+#endif
+    }
+
+    // Each kernel consumes as many groups of 8 as possible and advances the
+    // pointers; the caller's 128-bit or scalar code handles what remains.
+    // Unaligned loads are used throughout; they carry no penalty on AVX2 parts.
+
+    LAB_TARGET_AVX2 void avx2_vsma(const float *& sourceP, float k, float *& destP, int & n)
+    {
+        __m256 mScale = _mm256_set1_ps(k);
+        while (n >= 8)
+        {
+            __m256 source = _mm256_loadu_ps(sourceP);
+            __m256 dest = _mm256_loadu_ps(destP);
+            _mm256_storeu_ps(destP, _mm256_fmadd_ps(source, mScale, dest));
+            sourceP += 8;
+            destP += 8;
+            n -= 8;
+        }
+    }
+
+    LAB_TARGET_AVX2 void avx2_vsmul(const float *& sourceP, float k, float *& destP, int & n)
+    {
+        __m256 mScale = _mm256_set1_ps(k);
+        while (n >= 8)
+        {
+            _mm256_storeu_ps(destP, _mm256_mul_ps(_mm256_loadu_ps(sourceP), mScale));
+            sourceP += 8;
+            destP += 8;
+            n -= 8;
+        }
+    }
+
+    LAB_TARGET_AVX2 void avx2_vadd(const float *& source1P, const float *& source2P, float *& destP, int & n)
+    {
+        while (n >= 8)
+        {
+            _mm256_storeu_ps(destP, _mm256_add_ps(_mm256_loadu_ps(source1P), _mm256_loadu_ps(source2P)));
+            source1P += 8;
+            source2P += 8;
+            destP += 8;
+            n -= 8;
+        }
+    }
+
+    LAB_TARGET_AVX2 void avx2_vaddm4(const float * s0, const float * s1, const float * s2, const float * s3, float * destP, size_t & i, size_t framesToProcess)
+    {
+        while (i + 8 <= framesToProcess)
+        {
+            __m256 d = _mm256_loadu_ps(destP + i);
+            d = _mm256_add_ps(d, _mm256_add_ps(_mm256_loadu_ps(s0 + i), _mm256_loadu_ps(s1 + i)));
+            d = _mm256_add_ps(d, _mm256_add_ps(_mm256_loadu_ps(s2 + i), _mm256_loadu_ps(s3 + i)));
+            _mm256_storeu_ps(destP + i, d);
+            i += 8;
+        }
+    }
+
+    LAB_TARGET_AVX2 void avx2_vmul(const float *& source1P, const float *& source2P, float *& destP, int & n)
+    {
+        while (n >= 8)
+        {
+            _mm256_storeu_ps(destP, _mm256_mul_ps(_mm256_loadu_ps(source1P), _mm256_loadu_ps(source2P)));
+            source1P += 8;
+            source2P += 8;
+            destP += 8;
+            n -= 8;
+        }
+    }
+
+} // anonymous namespace
+
+bool cpuHasAVX2()
+{
+    static bool has = detectAVX2();
+    return has;
+}
+
+#else
+
+bool cpuHasAVX2()
+{
+    return false;
+}
+
+#endif // LAB_X86_AVX2_DISPATCH
+
 #if defined(LABSOUND_PLATFORM_OSX)
 // On the Mac we use the highly optimized versions in Accelerate.framework
 // In 32-bit mode (__ppc__ or __i386__) <Accelerate/Accelerate.h> includes <vecLib/vDSP_translate.h> which defines macros of the same name as
@@ -101,6 +242,10 @@ void vsma(const float* sourceP, int sourceStride, const float* scale, float* des
 {
     int n = framesToProcess;
 
+#if defined(LAB_X86_AVX2_DISPATCH)
+    if ((sourceStride == 1) && (destStride == 1) && cpuHasAVX2())
+        avx2_vsma(sourceP, *scale, destP, n);
+#endif
 #ifdef __SSE2__
     if ((sourceStride == 1) && (destStride == 1)) {
         float k = *scale;
@@ -174,6 +319,10 @@ void vsmul(const float* sourceP, int sourceStride, const float* scale, float* de
 {
     int n = framesToProcess;
 
+#if defined(LAB_X86_AVX2_DISPATCH)
+    if ((sourceStride == 1) && (destStride == 1) && cpuHasAVX2())
+        avx2_vsmul(sourceP, *scale, destP, n);
+#endif
 #ifdef __SSE2__
     if ((sourceStride == 1) && (destStride == 1)) {
         float k = *scale;
@@ -254,6 +403,10 @@ void vadd(const float* source1P, int sourceStride1, const float* source2P, int s
 {
     int n = framesToProcess;
 
+#if defined(LAB_X86_AVX2_DISPATCH)
+    if ((sourceStride1 == 1) && (sourceStride2 == 1) && (destStride == 1) && cpuHasAVX2())
+        avx2_vadd(source1P, source2P, destP, n);
+#endif
 #ifdef __SSE2__
     if ((sourceStride1 ==1) && (sourceStride2 == 1) && (destStride == 1)) {
         // If the sourceP address is not 16-byte aligned, the first several frames (at most three) should be processed separately.
@@ -367,6 +520,10 @@ void vmul(const float* source1P, int sourceStride1, const float* source2P, int s
 
     int n = framesToProcess;
 
+#if defined(LAB_X86_AVX2_DISPATCH)
+    if ((sourceStride1 == 1) && (sourceStride2 == 1) && (destStride == 1) && cpuHasAVX2())
+        avx2_vmul(source1P, source2P, destP, n);
+#endif
 #ifdef __SSE2__
     if ((sourceStride1 == 1) && (sourceStride2 == 1) && (destStride == 1)) {
         // If the source1P address is not 16-byte aligned, the first several frames (at most three) should be processed separately.
@@ -633,8 +790,22 @@ void vclip(const float* sourceP, int sourceStride, const float* lowThresholdP, c
     float lowThreshold = *lowThresholdP;
     float highThreshold = *highThresholdP;
 
-    // FIXME: Optimize for SSE2.
-#if defined(ARM_NEON_INTRINSICS)
+#ifdef __SSE2__
+    if ((sourceStride == 1) && (destStride == 1)) {
+        int tailFrames = n % 4;
+        const float* endP = destP + n - tailFrames;
+
+        __m128 low = _mm_set1_ps(lowThreshold);
+        __m128 high = _mm_set1_ps(highThreshold);
+        while (destP < endP) {
+            __m128 source = _mm_loadu_ps(sourceP);
+            _mm_storeu_ps(destP, _mm_max_ps(_mm_min_ps(source, high), low));
+            sourceP += 4;
+            destP += 4;
+        }
+        n = tailFrames;
+    }
+#elif defined(ARM_NEON_INTRINSICS)
     if ((sourceStride == 1) && (destStride == 1)) {
         int tailFrames = n % 4;
         const float* endP = destP + n - tailFrames;
@@ -659,9 +830,124 @@ void vclip(const float* sourceP, int sourceStride, const float* lowThresholdP, c
 
 #endif // OS(DARWIN)
 
+void vaddm(const float* const* sourceP, size_t numberOfSources, float* destP, size_t framesToProcess)
+{
+    size_t s = 0;
+
+    // four sources per pass over the destination
+    for (; s + 4 <= numberOfSources; s += 4)
+    {
+        const float* s0 = sourceP[s];
+        const float* s1 = sourceP[s + 1];
+        const float* s2 = sourceP[s + 2];
+        const float* s3 = sourceP[s + 3];
+
+        size_t i = 0;
+#if defined(LAB_X86_AVX2_DISPATCH)
+        if (cpuHasAVX2())
+            avx2_vaddm4(s0, s1, s2, s3, destP, i, framesToProcess);
+#endif
+#ifdef __SSE2__
+        while (i + 4 <= framesToProcess)
+        {
+            __m128 d = _mm_loadu_ps(destP + i);
+            d = _mm_add_ps(d, _mm_add_ps(_mm_loadu_ps(s0 + i), _mm_loadu_ps(s1 + i)));
+            d = _mm_add_ps(d, _mm_add_ps(_mm_loadu_ps(s2 + i), _mm_loadu_ps(s3 + i)));
+            _mm_storeu_ps(destP + i, d);
+            i += 4;
+        }
+#elif defined(ARM_NEON_INTRINSICS)
+        while (i + 4 <= framesToProcess)
+        {
+            float32x4_t d = vld1q_f32(destP + i);
+            d = vaddq_f32(d, vaddq_f32(vld1q_f32(s0 + i), vld1q_f32(s1 + i)));
+            d = vaddq_f32(d, vaddq_f32(vld1q_f32(s2 + i), vld1q_f32(s3 + i)));
+            vst1q_f32(destP + i, d);
+            i += 4;
+        }
+#endif
+        for (; i < framesToProcess; ++i)
+            destP[i] += s0[i] + s1[i] + s2[i] + s3[i];
+    }
+
+    // remaining one to three sources
+    for (; s < numberOfSources; ++s)
+        vadd(sourceP[s], 1, destP, 1, destP, 1, framesToProcess);
+}
+
+void vdotpr(const float* source1P, const float* source2P, float* resultP, size_t framesToProcess)
+{
+    size_t i = 0;
+    float sum = 0;
+
+#ifdef __SSE2__
+    __m128 fourSum = _mm_setzero_ps();
+    for (; i + 4 <= framesToProcess; i += 4)
+        fourSum = _mm_add_ps(fourSum, _mm_mul_ps(_mm_loadu_ps(source1P + i), _mm_loadu_ps(source2P + i)));
+
+    const float* groupSumP = reinterpret_cast<float*>(&fourSum);
+    sum = groupSumP[0] + groupSumP[1] + groupSumP[2] + groupSumP[3];
+#elif defined(ARM_NEON_INTRINSICS)
+    float32x4_t fourSum = vdupq_n_f32(0);
+    for (; i + 4 <= framesToProcess; i += 4)
+        fourSum = vmlaq_f32(fourSum, vld1q_f32(source1P + i), vld1q_f32(source2P + i));
+
+    float32x2_t twoSum = vadd_f32(vget_low_f32(fourSum), vget_high_f32(fourSum));
+    float groupSum[2];
+    vst1_f32(groupSum, twoSum);
+    sum = groupSum[0] + groupSum[1];
+#endif
+
+    for (; i < framesToProcess; ++i)
+        sum += source1P[i] * source2P[i];
+
+    ASSERT(resultP);
+    *resultP = sum;
+}
+
+void vmaxmgvm(const float* const* sourceP, size_t numberOfChannels, float* maxP, size_t framesToProcess)
+{
+    float max = 0;
+
+    for (size_t c = 0; c < numberOfChannels; ++c) {
+        float channelMax = 0;
+        vmaxmgv(sourceP[c], 1, &channelMax, framesToProcess);
+        max = std::max(max, channelMax);
+    }
+
+    ASSERT(maxP);
+    *maxP = max;
+}
+
+void vnormalizem(float* const* channelP, size_t numberOfChannels, float targetPeak, size_t framesToProcess)
+{
+    // The gain depends on the completed scan, so this is two passes by
+    // construction - but one entry point means the second pass can be elided
+    // outright for silent or already-normalized data.
+    float max = 0;
+    vmaxmgvm(channelP, numberOfChannels, &max, framesToProcess);
+
+    if (!max || max == targetPeak)
+        return;
+
+    float scale = targetPeak / max;
+    for (size_t c = 0; c < numberOfChannels; ++c)
+        vsmul(channelP[c], 1, &scale, channelP[c], 1, framesToProcess);
+}
+
 void vintlve(const float* realSrcP, const float* imagSrcP, float* destP, size_t framesToProcess) {
     int i = 0;
-#if defined(ARM_NEON_INTRINSICS)
+#ifdef __SSE2__
+    int len = (int)(framesToProcess / 2) - (int)(framesToProcess / 2) % 4;
+
+    while (i < len) {
+        __m128 real = _mm_loadu_ps(realSrcP + i);
+        __m128 imag = _mm_loadu_ps(imagSrcP + i);
+        _mm_storeu_ps(destP + 2 * i, _mm_unpacklo_ps(real, imag));
+        _mm_storeu_ps(destP + 2 * i + 4, _mm_unpackhi_ps(real, imag));
+        i += 4;
+    }
+#elif defined(ARM_NEON_INTRINSICS)
     int j = 0;
     int endSize = framesToProcess - framesToProcess % 4;
     int len = endSize / 2;
@@ -690,7 +976,17 @@ void vintlve(const float* realSrcP, const float* imagSrcP, float* destP, size_t
 
 void vdeintlve(const float* sourceP, float* realDestP, float* imagDestP, size_t framesToProcess) {
     int i = 0;
-#if defined(ARM_NEON_INTRINSICS)
+#ifdef __SSE2__
+    int len = (int)(framesToProcess / 2) - (int)(framesToProcess / 2) % 4;
+
+    while (i < len) {
+        __m128 lo = _mm_loadu_ps(sourceP + 2 * i);      // r0 i0 r1 i1
+        __m128 hi = _mm_loadu_ps(sourceP + 2 * i + 4);  // r2 i2 r3 i3
+        _mm_storeu_ps(realDestP + i, _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(imagDestP + i, _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+        i += 4;
+    }
+#elif defined(ARM_NEON_INTRINSICS)
     int j = 0;
     int endSize = framesToProcess - framesToProcess % 4;
 
@@ -717,6 +1013,364 @@ void vdeintlve(const float* sourceP, float* realDestP, float* imagDestP, size_t
     }
 }
 
+void vdeintlvem(const float* sourceP, float* const* destP, size_t numberOfChannels, size_t framesToProcess)
+{
+    if (!numberOfChannels)
+        return;
+
+    if (numberOfChannels == 1) {
+        memcpy(destP[0], sourceP, framesToProcess * sizeof(float));
+        return;
+    }
+
+    if (numberOfChannels == 2) {
+        float* leftP = destP[0];
+        float* rightP = destP[1];
+        size_t i = 0;
+#ifdef __SSE2__
+        while (i + 4 <= framesToProcess) {
+            __m128 lo = _mm_loadu_ps(sourceP + 2 * i);      // L0 R0 L1 R1
+            __m128 hi = _mm_loadu_ps(sourceP + 2 * i + 4);  // L2 R2 L3 R3
+            _mm_storeu_ps(leftP + i, _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(rightP + i, _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+            i += 4;
+        }
+#elif defined(ARM_NEON_INTRINSICS)
+        while (i + 4 <= framesToProcess) {
+            float32x4x2_t frames = vld2q_f32(sourceP + 2 * i);
+            vst1q_f32(leftP + i, frames.val[0]);
+            vst1q_f32(rightP + i, frames.val[1]);
+            i += 4;
+        }
+#endif
+        for (; i < framesToProcess; ++i) {
+            leftP[i] = sourceP[2 * i];
+            rightP[i] = sourceP[2 * i + 1];
+        }
+        return;
+    }
+
+    if (numberOfChannels == 4) {
+        size_t i = 0;
+#ifdef __SSE2__
+        // A 4x4 register transpose turns four interleaved frames into four
+        // planar quads.
+        while (i + 4 <= framesToProcess) {
+            __m128 f0 = _mm_loadu_ps(sourceP + 4 * i);
+            __m128 f1 = _mm_loadu_ps(sourceP + 4 * i + 4);
+            __m128 f2 = _mm_loadu_ps(sourceP + 4 * i + 8);
+            __m128 f3 = _mm_loadu_ps(sourceP + 4 * i + 12);
+            _MM_TRANSPOSE4_PS(f0, f1, f2, f3);
+            _mm_storeu_ps(destP[0] + i, f0);
+            _mm_storeu_ps(destP[1] + i, f1);
+            _mm_storeu_ps(destP[2] + i, f2);
+            _mm_storeu_ps(destP[3] + i, f3);
+            i += 4;
+        }
+#elif defined(ARM_NEON_INTRINSICS)
+        while (i + 4 <= framesToProcess) {
+            float32x4x4_t frames = vld4q_f32(sourceP + 4 * i);
+            vst1q_f32(destP[0] + i, frames.val[0]);
+            vst1q_f32(destP[1] + i, frames.val[1]);
+            vst1q_f32(destP[2] + i, frames.val[2]);
+            vst1q_f32(destP[3] + i, frames.val[3]);
+            i += 4;
+        }
+#endif
+        for (; i < framesToProcess; ++i) {
+            destP[0][i] = sourceP[4 * i];
+            destP[1][i] = sourceP[4 * i + 1];
+            destP[2][i] = sourceP[4 * i + 2];
+            destP[3][i] = sourceP[4 * i + 3];
+        }
+        return;
+    }
+
+    // Other channel counts: one strided gather pass per channel.
+    for (size_t c = 0; c < numberOfChannels; ++c) {
+        float* dst = destP[c];
+        const float* src = sourceP + c;
+        for (size_t i = 0; i < framesToProcess; ++i)
+            dst[i] = src[i * numberOfChannels];
+    }
+}
+
+namespace {
+
+    // Pade (7,6) approximant of tanh. With the argument clamped to the range
+    // where the approximant is monotonic, the error against tanhf stays below
+    // 1e-6 and the output magnitude never exceeds one.
+    const float kTanhArgClamp = 4.97f;
+
+    inline float tanhApprox(float x)
+    {
+        x = std::max(-kTanhArgClamp, std::min(kTanhArgClamp, x));
+        float x2 = x * x;
+        float p = x * (135135.f + x2 * (17325.f + x2 * (378.f + x2)));
+        float q = 135135.f + x2 * (62370.f + x2 * (3150.f + 28.f * x2));
+        return p / q;
+    }
+
+} // anonymous namespace
+
+void vcomp(const float* source1P, const float* source2P, float* destP, size_t framesToProcess)
+{
+    int n = framesToProcess;
+
+#ifdef __SSE2__
+    {
+        const __m128 plusOne = _mm_set1_ps(1.f);
+        const __m128 minusOne = _mm_set1_ps(-1.f);
+        while (n >= 4)
+        {
+            // the compare mask selects between the +1 and -1 lanes
+            __m128 mask = _mm_cmpgt_ps(_mm_loadu_ps(source1P), _mm_loadu_ps(source2P));
+            _mm_storeu_ps(destP, _mm_or_ps(_mm_and_ps(mask, plusOne), _mm_andnot_ps(mask, minusOne)));
+            source1P += 4;
+            source2P += 4;
+            destP += 4;
+            n -= 4;
+        }
+    }
+#elif defined(ARM_NEON_INTRINSICS)
+    {
+        const float32x4_t plusOne = vdupq_n_f32(1.f);
+        const float32x4_t minusOne = vdupq_n_f32(-1.f);
+        while (n >= 4)
+        {
+            uint32x4_t mask = vcgtq_f32(vld1q_f32(source1P), vld1q_f32(source2P));
+            vst1q_f32(destP, vbslq_f32(mask, plusOne, minusOne));
+            source1P += 4;
+            source2P += 4;
+            destP += 4;
+            n -= 4;
+        }
+    }
+#endif
+    while (n--)
+    {
+        *destP++ = (*source1P++ > *source2P++) ? 1.f : -1.f;
+    }
+}
+
+void vexpramp(const float* sourceP, float* destP, float targetGain, float* gainP, float rate, size_t framesToProcess)
+{
+    int n = framesToProcess;
+    const float c = 1.f - rate;
+    float delta = *gainP - targetGain;
+
+#ifdef __SSE2__
+    if (n >= 4)
+    {
+        const float c2 = c * c;
+        const float c4 = c2 * c2;
+        // Gain lanes for frames i+1..i+4 relative to the running delta.
+        __m128 vdelta = _mm_mul_ps(_mm_set1_ps(delta), _mm_set_ps(c4, c2 * c, c2, c));
+        const __m128 vc4 = _mm_set1_ps(c4);
+        const __m128 vtarget = _mm_set1_ps(targetGain);
+        while (n >= 4)
+        {
+            __m128 gains = _mm_add_ps(vtarget, vdelta);
+            _mm_storeu_ps(destP, _mm_mul_ps(_mm_loadu_ps(sourceP), gains));
+            vdelta = _mm_mul_ps(vdelta, vc4);
+            sourceP += 4;
+            destP += 4;
+            n -= 4;
+            delta *= c4;
+        }
+    }
+#elif defined(ARM_NEON_INTRINSICS)
+    if (n >= 4)
+    {
+        const float c2 = c * c;
+        const float c4 = c2 * c2;
+        const float lanes[4] = { c, c2, c2 * c, c4 };
+        float32x4_t vdelta = vmulq_n_f32(vld1q_f32(lanes), delta);
+        const float32x4_t vtarget = vdupq_n_f32(targetGain);
+        while (n >= 4)
+        {
+            float32x4_t gains = vaddq_f32(vtarget, vdelta);
+            vst1q_f32(destP, vmulq_f32(vld1q_f32(sourceP), gains));
+            vdelta = vmulq_n_f32(vdelta, c4);
+            sourceP += 4;
+            destP += 4;
+            n -= 4;
+            delta *= c4;
+        }
+    }
+#endif
+    while (n--)
+    {
+        delta *= c;
+        *destP++ = *sourceP++ * (targetGain + delta);
+    }
+
+    *gainP = targetGain + delta;
+}
+
+void vtanh(const float* sourceP, const float* inputGainP, const float* outputGainP, float* destP, size_t framesToProcess)
+{
+    int n = framesToProcess;
+    float inputGain = *inputGainP;
+    float outputGain = *outputGainP;
+
+#ifdef __SSE2__
+    {
+        __m128 vInputGain = _mm_set1_ps(inputGain);
+        __m128 vOutputGain = _mm_set1_ps(outputGain);
+        __m128 low = _mm_set1_ps(-kTanhArgClamp);
+        __m128 high = _mm_set1_ps(kTanhArgClamp);
+        __m128 c0 = _mm_set1_ps(135135.f);
+        __m128 c1 = _mm_set1_ps(17325.f);
+        __m128 c2 = _mm_set1_ps(378.f);
+        __m128 d1 = _mm_set1_ps(62370.f);
+        __m128 d2 = _mm_set1_ps(3150.f);
+        __m128 d3 = _mm_set1_ps(28.f);
+        while (n >= 4)
+        {
+            __m128 x = _mm_mul_ps(_mm_loadu_ps(sourceP), vInputGain);
+            x = _mm_max_ps(_mm_min_ps(x, high), low);
+            __m128 x2 = _mm_mul_ps(x, x);
+            __m128 p = _mm_mul_ps(x, _mm_add_ps(c0, _mm_mul_ps(x2, _mm_add_ps(c1, _mm_mul_ps(x2, _mm_add_ps(c2, x2))))));
+            __m128 q = _mm_add_ps(c0, _mm_mul_ps(x2, _mm_add_ps(d1, _mm_mul_ps(x2, _mm_add_ps(d2, _mm_mul_ps(d3, x2))))));
+            _mm_storeu_ps(destP, _mm_mul_ps(vOutputGain, _mm_div_ps(p, q)));
+            sourceP += 4;
+            destP += 4;
+            n -= 4;
+        }
+    }
+#endif
+    while (n--)
+    {
+        *destP++ = outputGain * tanhApprox(inputGain * *sourceP++);
+    }
+}
+
+namespace {
+
+    // Dither noise source: xorshift32, persistent across callbacks so the
+    // noise doesn't repeat with the quantum period. The converters run on a
+    // single device callback thread, so plain state is fine.
+    uint32_t s_ditherState = 0x9E3779B9u;
+
+    inline uint32_t ditherNext()
+    {
+        uint32_t x = s_ditherState;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        s_ditherState = x;
+        return x;
+    }
+
+    // Triangular (TPDF) dither in (-1, 1) LSB: the difference of two
+    // uniform samples.
+    inline float ditherTPDF()
+    {
+        const float kUniformScale = 1.f / 4294967296.f;
+        float a = ditherNext() * kUniformScale;
+        float b = ditherNext() * kUniformScale;
+        return a - b;
+    }
+
+    inline int32_t clampedRound(float scaled, int32_t low, int32_t high)
+    {
+        int32_t v = static_cast<int32_t>(lrintf(scaled));
+        return std::max(low, std::min(high, v));
+    }
+
+#ifdef __SSE2__
+    // Four-lane xorshift32 for the vector path; each lane runs its own
+    // stream so no two samples in a block share noise.
+    __m128i s_ditherLanesA = _mm_set_epi32(0x9E3779B9, 0x243F6A88, 0xB7E15162, 0x6C62272E);
+    __m128i s_ditherLanesB = _mm_set_epi32(0x3C6EF372, 0x487ED511, 0x2545F491, 0x14057B7E);
+
+    inline __m128i ditherNext4(__m128i & state)
+    {
+        __m128i x = state;
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+        x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+        state = x;
+        return x;
+    }
+
+    // TPDF in (-1, 1) LSB for four samples: the halved difference of two
+    // uniform lanes in [-1, 1).
+    inline __m128 ditherTPDF4()
+    {
+        const __m128 kScale = _mm_set1_ps(0.5f / 2147483648.f);
+        __m128 a = _mm_cvtepi32_ps(ditherNext4(s_ditherLanesA));
+        __m128 b = _mm_cvtepi32_ps(ditherNext4(s_ditherLanesB));
+        return _mm_mul_ps(_mm_sub_ps(a, b), kScale);
+    }
+#endif
+}
+
+void vfloat_to_int16_interleave(const float* const* sourceP, size_t numberOfChannels, int16_t* destP, size_t framesToProcess, bool dither)
+{
+    const float scale = 32767.f;
+    size_t i = 0;
+
+#ifdef __SSE2__
+    if (numberOfChannels == 2)
+    {
+        const float* left = sourceP[0];
+        const float* right = sourceP[1];
+        __m128 vscale = _mm_set1_ps(scale);
+        __m128 low = _mm_set1_ps(-1.f);
+        __m128 high = _mm_set1_ps(1.f);
+        size_t n4 = framesToProcess & ~size_t(3);
+
+        for (; i < n4; i += 4)
+        {
+            __m128 l = _mm_mul_ps(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(left + i), high), low), vscale);
+            __m128 r = _mm_mul_ps(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(right + i), high), low), vscale);
+            if (dither)
+            {
+                l = _mm_add_ps(l, ditherTPDF4());
+                r = _mm_add_ps(r, ditherTPDF4());
+            }
+            // cvtps rounds to nearest; packs saturates to the int16 range
+            __m128i li = _mm_cvtps_epi32(l);
+            __m128i ri = _mm_cvtps_epi32(r);
+            __m128i lo = _mm_unpacklo_epi32(li, ri);  // L0 R0 L1 R1
+            __m128i hi = _mm_unpackhi_epi32(li, ri);  // L2 R2 L3 R3
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destP + 2 * i), _mm_packs_epi32(lo, hi));
+        }
+    }
+#endif
+
+    int16_t* out = destP + i * numberOfChannels;
+    for (; i < framesToProcess; ++i)
+    {
+        for (size_t c = 0; c < numberOfChannels; ++c)
+        {
+            float x = std::max(-1.f, std::min(1.f, sourceP[c][i]));
+            float scaled = x * scale + (dither ? ditherTPDF() : 0.f);
+            *out++ = static_cast<int16_t>(clampedRound(scaled, -32768, 32767));
+        }
+    }
+}
+
+void vfloat_to_int24_interleave(const float* const* sourceP, size_t numberOfChannels, uint8_t* destP, size_t framesToProcess, bool dither)
+{
+    const float scale = 8388607.f;
+    uint8_t* out = destP;
+
+    for (size_t i = 0; i < framesToProcess; ++i)
+    {
+        for (size_t c = 0; c < numberOfChannels; ++c)
+        {
+            float x = std::max(-1.f, std::min(1.f, sourceP[c][i]));
+            float scaled = x * scale + (dither ? ditherTPDF() : 0.f);
+            int32_t v = clampedRound(scaled, -8388608, 8388607);
+            *out++ = static_cast<uint8_t>(v & 0xff);
+            *out++ = static_cast<uint8_t>((v >> 8) & 0xff);
+            *out++ = static_cast<uint8_t>((v >> 16) & 0xff);
+        }
+    }
+}
 
 } // namespace VectorMath
 
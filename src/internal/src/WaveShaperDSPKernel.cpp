@@ -5,6 +5,7 @@
 #include "LabSound/core/Macros.h"
 #include "internal/WaveShaperDSPKernel.h"
 #include "internal/WaveShaperProcessor.h"
+#include "internal/NonlinearityTable.h"
 #include "internal/Assertions.h"
 
 #include <algorithm>
@@ -13,6 +14,55 @@ using namespace std;
 
 namespace lab {
 
+void WaveShaperDSPKernel::shapeBlock(const float * curveData, size_t curveLength, const float * source, float * destination, size_t framesToProcess)
+{
+    // Map input -1 -> +1 onto the curve through the shared interpolated
+    // lookup kernel; input outside the nominal range clamps to the curve ends.
+    NonlinearityTable::applyTable(curveData, curveLength, -1.f, 1.f, source, destination, framesToProcess);
+}
+
+void WaveShaperDSPKernel::configureOversampling(int oversample)
+{
+    if (oversample == m_oversample)
+        return;
+
+    m_oversample = oversample;
+
+    if (oversample == 1)
+    {
+        m_upSampler.reset();
+        m_downSampler.reset();
+        return;
+    }
+
+    // scaleFactor == sourceSampleRate / destinationSampleRate
+    m_upSampler.reset(new SincResampler(1.0 / oversample));
+    m_downSampler.reset(new SincResampler(double(oversample)));
+    m_oversampleBuffer.allocate(oversample * AudioNode::ProcessingSizeInFrames);
+}
+
+void WaveShaperDSPKernel::reset()
+{
+    // drop resampler history so a restarted stream doesn't convolve stale samples
+    if (m_oversample != 1)
+    {
+        int oversample = m_oversample;
+        m_oversample = 1;
+        configureOversampling(oversample);
+    }
+}
+
+double WaveShaperDSPKernel::latencyTime(ContextRenderLock & r) const
+{
+    if (m_oversample == 1)
+        return 0;
+
+    // each SincResampler delays by half its kernel (32 taps); the upsampler's
+    // half-kernel is in source frames, the downsampler's in oversampled frames
+    const double halfKernel = 16.0;
+    return (halfKernel + halfKernel / m_oversample) / static_cast<double>(r.context()->sampleRate());
+}
+
 void WaveShaperDSPKernel::process(ContextRenderLock &, const float* source, float* destination, size_t framesToProcess)
 {
     ASSERT(source && destination && waveShaperProcessor());
@@ -20,38 +70,38 @@ void WaveShaperDSPKernel::process(ContextRenderLock &, const float* source, floa
     // Curve object locks the curve during processing
     std::unique_ptr<WaveShaperProcessor::Curve> c = waveShaperProcessor()->curve();
 
-    if (c->curve.size() == 0) 
+    float const * curveData = c->curve.data();
+    size_t curveLength = c->curve.size();
+
+    if (!curveData || curveLength < 2)
     {
         // Act as "straight wire" pass-through if no curve is set.
         memcpy(destination, source, sizeof(float) * framesToProcess);
         return;
     }
 
-    float const * curveData = c->curve.data();
-    size_t curveLength = c->curve.size();
+    configureOversampling(waveShaperProcessor()->oversample());
 
-    ASSERT(curveData);
-
-    if (!curveData || !curveLength) 
+    if (m_oversample == 1)
     {
-        memcpy(destination, source, sizeof(float) * framesToProcess);
+        shapeBlock(curveData, curveLength, source, destination, framesToProcess);
         return;
     }
 
-    // Apply waveshaping curve.
-    for (unsigned i = 0; i < framesToProcess; ++i) 
+    // upsample - shape in place - downsample, all within the preallocated
+    // scratch buffer; no intermediate busses
+    size_t oversampledFrames = framesToProcess * m_oversample;
+    ASSERT(oversampledFrames <= m_oversampleBuffer.size());
+    if (oversampledFrames > m_oversampleBuffer.size())
     {
-        const float input = source[i];
-
-        // Calculate an index based on input -1 -> +1 with 0 being at the center of the curve data.
-        size_t index = static_cast<size_t>((curveLength * (input + 1)) / 2);
-
-        // Clip index to the input range of the curve.
-        // This takes care of input outside of nominal range -1 -> +1
-        index = max(index, size_t(0));
-        index = min(index, curveLength - 1);
-        destination[i] = curveData[index];
+        shapeBlock(curveData, curveLength, source, destination, framesToProcess);
+        return;
     }
+
+    float * buffer = m_oversampleBuffer.data();
+    m_upSampler->process(source, buffer, framesToProcess);
+    shapeBlock(curveData, curveLength, buffer, buffer, oversampledFrames);
+    m_downSampler->process(buffer, destination, oversampledFrames);
 }
 
 } // namespace lab
@@ -31,6 +31,12 @@ void WaveShaperProcessor::setCurve(std::vector<float> && curve)
     std::swap(m_newCurve, curve);
 }
 
+void WaveShaperProcessor::setOversample(int oversample)
+{
+    std::lock_guard<std::mutex> lock(m_curveWrite);
+    m_newOversample = oversample;
+}
+
 void WaveShaperProcessor::process(ContextRenderLock& r, const AudioBus* source, AudioBus* destination, size_t framesToProcess)
 {
     if (!isInitialized() || !r.context()) 
@@ -46,12 +52,23 @@ void WaveShaperProcessor::process(ContextRenderLock& r, const AudioBus* source,
         std::swap(m_curve, m_newCurve);
         m_newCurve.clear();
     }
-    
+
+    if (m_newOversample)
+    {
+        std::lock_guard<std::mutex> lock(m_curveWrite);
+        m_oversample = m_newOversample;
+        m_newOversample = 0;
+    }
+
+
     const bool channelCountMatches = source->numberOfChannels() == destination->numberOfChannels() && source->numberOfChannels() == m_kernels.size();
-    
+
     if (!channelCountMatches)
         return;
 
+    if (handleSilentQuantum(r, source, destination, framesToProcess))
+        return;
+
     // For each channel of our input, process using the corresponding WaveShaperDSPKernel into the output channel.
     for (unsigned i = 0; i < m_kernels.size(); ++i)
     {
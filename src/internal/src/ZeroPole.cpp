@@ -3,43 +3,34 @@
 // Copyright (C) 2015+, The LabSound Authors. All rights reserved.
 
 #include "internal/ZeroPole.h"
-#include "internal/DenormalDisabler.h"
 
-namespace lab 
+namespace lab
 {
 
 void ZeroPole::process(const float *source, float *destination, size_t framesToProcess)
 {
-    float zero = m_zero;
-    float pole = m_pole;
-
-    // Gain compensation to make 0dB @ 0Hz
-    const float k1 = 1 / (1 - zero);
-    const float k2 = 1 - pole;
-    
-    // Member variables to locals.
-    float lastX = m_lastX;
-    float lastY = m_lastY;
-
-    while (framesToProcess--) 
+    m_biquad.process(source, destination, framesToProcess);
+}
+
+void ZeroPole::processChannels(ZeroPole* const* filters, const float* const* sources, float* const* dests, size_t numberOfChannels, size_t framesToProcess)
+{
+    const size_t MaxLanes = 8;
+
+    while (numberOfChannels)
     {
-        float input = *source++;
+        size_t n = numberOfChannels < MaxLanes ? numberOfChannels : MaxLanes;
 
-        // Zero
-        float output1 = k1 * (input - zero * lastX);
-        lastX = input;
+        Biquad * biquads[MaxLanes];
+        for (size_t i = 0; i < n; ++i)
+            biquads[i] = &filters[i]->m_biquad;
 
-        // Pole
-        float output2 = k2 * output1 + pole * lastY;
-        lastY = output2;
+        Biquad::processChannels(biquads, sources, dests, n, framesToProcess);
 
-        *destination++ = output2;
+        filters += n;
+        sources += n;
+        dests += n;
+        numberOfChannels -= n;
     }
-    
-    // Locals to member variables. Flush denormals here so we don't
-    // slow down the inner loop above.
-    m_lastX = DenormalDisabler::flushDenormalFloatToZero(lastX);
-    m_lastY = DenormalDisabler::flushDenormalFloatToZero(lastY);
 }
 
 } // lab